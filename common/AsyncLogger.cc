@@ -0,0 +1,469 @@
+//------------------------------------------------------------------------------
+// File: AsyncLogger.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/AsyncLogger.hh"
+#include "common/Logging.hh"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <climits>
+#include <cerrno>
+#include <unistd.h>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Single producer/single consumer ring of log records. The producer is the
+//! owning logging thread, the consumer is the writer thread.
+//------------------------------------------------------------------------------
+class AsyncLogger::Ring
+{
+public:
+  explicit Ring(size_t slots):
+    mSlots(slots), mMask(slots - 1), mHead(0), mTail(0), mOrphaned(false)
+  {}
+
+  std::vector<AsyncLogRecord> mSlots; ///< Record slots
+  const size_t mMask; ///< Mask to map a position to a slot
+  std::atomic<uint64_t> mHead; ///< Next position to be written by producer
+  std::atomic<uint64_t> mTail; ///< Next position to be read by consumer
+  std::atomic<bool> mOrphaned; ///< Mark that the producer thread exited
+};
+
+namespace
+{
+//! Unique identifier of every AsyncLogger object
+std::atomic<uint64_t> sLoggerId {0};
+
+//------------------------------------------------------------------------------
+//! Ring of the current thread, marked as orphaned when the thread exits so
+//! that the writer can drop it once drained
+//------------------------------------------------------------------------------
+struct ThreadRing {
+  ~ThreadRing()
+  {
+    if (mRing) {
+      mRing->mOrphaned = true;
+    }
+  }
+
+  uint64_t mOwnerId = 0;
+  std::shared_ptr<AsyncLogger::Ring> mRing;
+};
+
+thread_local ThreadRing tThreadRing;
+
+//! Maximum time the writer sleeps when there is nothing to do
+const std::chrono::milliseconds sIdleWait {100};
+//! Time a producer sleeps while waiting for space in a full ring
+const std::chrono::microseconds sFullWait {50};
+//! New line appended to the records
+char sNewLine[] = "\n";
+
+//------------------------------------------------------------------------------
+// Write all the given buffers to the file descriptor, handling short writes
+//------------------------------------------------------------------------------
+void
+WriteFully(int fd, std::vector<struct iovec>& iov)
+{
+  size_t pos = 0;
+
+  while (pos < iov.size()) {
+    int cnt = (int) std::min(iov.size() - pos, (size_t) IOV_MAX);
+    ssize_t nwrite = writev(fd, &iov[pos], cnt);
+
+    if (nwrite < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return;
+    }
+
+    // Skip the buffers fully written and adjust the partially written one
+    while ((pos < iov.size()) && (nwrite >= (ssize_t) iov[pos].iov_len)) {
+      nwrite -= iov[pos].iov_len;
+      ++pos;
+    }
+
+    if (nwrite > 0) {
+      iov[pos].iov_base = (char*) iov[pos].iov_base + nwrite;
+      iov[pos].iov_len -= nwrite;
+    }
+  }
+}
+}
+
+constexpr size_t AsyncLogger::sDefaultRingSlots;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+AsyncLogger::AsyncLogger(Logging& logging, size_t ring_slots):
+  mLogging(logging), mRingSlots(1), mStarted(false), mWriterIdle(false),
+  mDropped(0), mBlocked(0), mWritten(0), mRetiredQueued(0),
+  mReportedDropped(0), mId(++sLoggerId)
+{
+  while (mRingSlots < ring_slots) {
+    mRingSlots <<= 1;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+AsyncLogger::~AsyncLogger()
+{
+  if (mStarted) {
+    mWriterThread.stop();
+    {
+      std::lock_guard<std::mutex> lock(mWakeMutex);
+      mWakeCv.notify_all();
+    }
+    mWriterThread.join();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Start the writer thread if not already running
+//------------------------------------------------------------------------------
+void
+AsyncLogger::EnsureStarted()
+{
+  if (mStarted.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mStartMutex);
+
+  if (!mStarted) {
+    mWriterThread.reset(&AsyncLogger::WriterJob, this);
+    mWriterThread.setName("AsyncLogger");
+    mStarted = true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the ring of the calling thread, registering it if needed
+//------------------------------------------------------------------------------
+AsyncLogger::Ring*
+AsyncLogger::GetThreadRing()
+{
+  if (tThreadRing.mRing && (tThreadRing.mOwnerId == mId)) {
+    return tThreadRing.mRing.get();
+  }
+
+  if (tThreadRing.mRing) {
+    // Ring registered with a different logger object
+    tThreadRing.mRing->mOrphaned = true;
+  }
+
+  tThreadRing.mRing = std::make_shared<Ring>(mRingSlots);
+  tThreadRing.mOwnerId = mId;
+  std::lock_guard<std::mutex> lock(mRingsMutex);
+  mRings.push_back(tThreadRing.mRing);
+  return tThreadRing.mRing.get();
+}
+
+//------------------------------------------------------------------------------
+// Reserve a record in the ring of the calling thread
+//------------------------------------------------------------------------------
+AsyncLogRecord*
+AsyncLogger::Reserve(int priority)
+{
+  EnsureStarted();
+  Ring* ring = GetThreadRing();
+  uint64_t head = ring->mHead.load(std::memory_order_relaxed);
+
+  if (head - ring->mTail.load(std::memory_order_acquire) >= mRingSlots) {
+    if (priority > LOG_WARNING) {
+      mDropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    // Never lose warnings and errors, wait for the writer to catch up
+    mBlocked.fetch_add(1, std::memory_order_relaxed);
+
+    while (head - ring->mTail.load(std::memory_order_acquire) >= mRingSlots) {
+      {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mWakeCv.notify_one();
+      }
+      std::this_thread::sleep_for(sFullWait);
+    }
+  }
+
+  return &ring->mSlots[head & ring->mMask];
+}
+
+//------------------------------------------------------------------------------
+// Publish the record obtained through the last Reserve call
+//------------------------------------------------------------------------------
+void
+AsyncLogger::Commit()
+{
+  Ring* ring = tThreadRing.mRing.get();
+  // Sequentially consistent store paired with the idle flag of the writer
+  ring->mHead.fetch_add(1);
+
+  if (mWriterIdle.load()) {
+    std::lock_guard<std::mutex> lock(mWakeMutex);
+    mWakeCv.notify_one();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Wait until all the records queued so far are processed by the writer
+//------------------------------------------------------------------------------
+void
+AsyncLogger::Flush()
+{
+  if (!mStarted) {
+    return;
+  }
+
+  std::vector<std::pair<std::shared_ptr<Ring>, uint64_t>> targets;
+  {
+    std::lock_guard<std::mutex> lock(mRingsMutex);
+
+    for (const auto& ring : mRings) {
+      targets.emplace_back(ring, ring->mHead.load());
+    }
+  }
+  std::unique_lock<std::mutex> lock(mWakeMutex);
+  mWakeCv.notify_one();
+  mFlushCv.wait(lock, [&]() {
+    for (const auto& target : targets) {
+      if (target.first->mTail.load() < target.second) {
+        return false;
+      }
+    }
+
+    return true;
+  });
+}
+
+//------------------------------------------------------------------------------
+// Get pipeline counters
+//------------------------------------------------------------------------------
+AsyncLogger::Stats
+AsyncLogger::GetStats() const
+{
+  Stats stats;
+  stats.mWritten = mWritten;
+  stats.mDropped = mDropped;
+  stats.mBlocked = mBlocked;
+  std::lock_guard<std::mutex> lock(mRingsMutex);
+  stats.mQueued = mRetiredQueued;
+
+  for (const auto& ring : mRings) {
+    stats.mQueued += ring->mHead.load(std::memory_order_relaxed);
+  }
+
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+// Writer thread loop
+//------------------------------------------------------------------------------
+void
+AsyncLogger::WriterJob(ThreadAssistant& assistant)
+{
+  while (!assistant.terminationRequested()) {
+    if (Drain()) {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mWakeMutex);
+    mWriterIdle = true;
+
+    // Catch records published before the idle flag became visible
+    if (!HasPending() && !assistant.terminationRequested()) {
+      mWakeCv.wait_for(lock, sIdleWait);
+    }
+
+    mWriterIdle = false;
+  }
+
+  // Write out everything still pending
+  while (Drain()) {}
+}
+
+//------------------------------------------------------------------------------
+// Check if any of the rings has records pending
+//------------------------------------------------------------------------------
+bool
+AsyncLogger::HasPending()
+{
+  std::lock_guard<std::mutex> lock(mRingsMutex);
+
+  for (const auto& ring : mRings) {
+    if (ring->mHead.load() != ring->mTail.load(std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Drain all the rings once
+//------------------------------------------------------------------------------
+size_t
+AsyncLogger::Drain()
+{
+  size_t total = 0;
+  {
+    std::lock_guard<std::mutex> lock(mRingsMutex);
+    mDrainRings.assign(mRings.begin(), mRings.end());
+  }
+
+  for (auto& ring : mDrainRings) {
+    total += DrainRing(*ring);
+  }
+
+  mDrainRings.clear();
+  {
+    // Drop the drained rings of the threads which are gone
+    std::lock_guard<std::mutex> lock(mRingsMutex);
+    auto it = std::remove_if(mRings.begin(), mRings.end(),
+    [&](const std::shared_ptr<Ring>& ring) {
+      if (ring->mOrphaned && (ring->mHead == ring->mTail)) {
+        mRetiredQueued += ring->mHead;
+        return true;
+      }
+
+      return false;
+    });
+    mRings.erase(it, mRings.end());
+  }
+  uint64_t dropped = mDropped.load(std::memory_order_relaxed);
+
+  if (dropped != mReportedDropped) {
+    fprintf(stderr, "                 ---- %lu log messages dropped, "
+            "async log buffer full ----\n",
+            (unsigned long)(dropped - mReportedDropped));
+    mReportedDropped = dropped;
+  }
+
+  if (total) {
+    std::lock_guard<std::mutex> lock(mWakeMutex);
+    mFlushCv.notify_all();
+  }
+
+  return total;
+}
+
+//------------------------------------------------------------------------------
+// Write out and store in memory all the records available in a ring
+//------------------------------------------------------------------------------
+size_t
+AsyncLogger::DrainRing(Ring& ring)
+{
+  uint64_t tail = ring.mTail.load(std::memory_order_relaxed);
+  uint64_t head = ring.mHead.load(std::memory_order_acquire);
+
+  if (tail == head) {
+    return 0;
+  }
+
+  for (auto& file_iov : mIov) {
+    file_iov.second.clear();
+  }
+
+  auto add_iov = [&](FILE * file, const char* buf, size_t len) {
+    auto it = std::find_if(mIov.begin(), mIov.end(),
+    [&](const std::pair<FILE*, std::vector<struct iovec>>& elem) {
+      return (elem.first == file);
+    });
+
+    if (it == mIov.end()) {
+      mIov.emplace_back(file, std::vector<struct iovec>());
+      it = mIov.end() - 1;
+    }
+
+    it->second.push_back({(void*) buf, len});
+  };
+  {
+    // Rate limiting and the memory log are protected by the global mutex,
+    // take it once for the whole batch
+    XrdSysMutexHelper scope_lock(mLogging.gMutex);
+    FILE* star = nullptr;
+
+    if (mLogging.gLogFanOut.size()) {
+      auto it = mLogging.gLogFanOut.find("*");
+
+      if (it != mLogging.gLogFanOut.end()) {
+        star = it->second;
+      }
+    }
+
+    for (uint64_t pos = tail; pos != head; ++pos) {
+      AsyncLogRecord& rec = ring.mSlots[pos & ring.mMask];
+      int priority = rec.mPriority;
+      bool silent = (priority == LOG_SILENT);
+
+      if (!silent && mLogging.rate_limit(rec.mTv, priority, rec.mFile,
+                                         rec.mLine)) {
+        continue;
+      }
+
+      if (!silent) {
+        if (mLogging.gToSysLog) {
+          syslog(priority, "%s", rec.mText.c_str() + rec.mMsgOffset);
+        }
+
+        if (star) {
+          add_iov(star, rec.mText.c_str(), rec.mText.length());
+          add_iov(star, sNewLine, 1);
+        }
+
+        if (rec.mFanOut) {
+          add_iov(rec.mFanOut, rec.mFanOutText.c_str(), rec.mFanOutText.length());
+        }
+
+        add_iov(stderr, rec.mText.c_str(), rec.mText.length());
+        add_iov(stderr, sNewLine, 1);
+      } else {
+        priority = LOG_DEBUG;
+      }
+
+      // Store into global log memory
+      mLogging.gLogMemory[priority][mLogging.gLogCircularIndex[priority] %
+                                    mLogging.gCircularIndexSize] = rec.mText.c_str();
+      mLogging.gLogCircularIndex[priority]++;
+    }
+  }
+
+  for (auto& file_iov : mIov) {
+    if (file_iov.second.size()) {
+      fflush(file_iov.first);
+      WriteFully(fileno(file_iov.first), file_iov.second);
+    }
+  }
+
+  ring.mTail.store(head, std::memory_order_release);
+  mWritten.fetch_add(head - tail, std::memory_order_relaxed);
+  return head - tail;
+}
+
+EOSCOMMONNAMESPACE_END
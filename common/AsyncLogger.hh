@@ -0,0 +1,194 @@
+//------------------------------------------------------------------------------
+//! @file AsyncLogger.hh
+//! @brief Asynchronous writer for the log messages produced by Logging
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSCOMMON_ASYNCLOGGER_HH__
+#define __EOSCOMMON_ASYNCLOGGER_HH__
+
+#include "common/Namespace.hh"
+#include "common/AssistedThread.hh"
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+class Logging;
+
+//------------------------------------------------------------------------------
+//! Log record handed over from a logging thread to the writer thread
+//------------------------------------------------------------------------------
+struct AsyncLogRecord {
+  int mPriority; ///< Message priority, LOG_SILENT records are not printed
+  const char* mFile; ///< Source file, used for rate limiting
+  int mLine; ///< Source line, used for rate limiting
+  struct timeval mTv; ///< Time when the message was generated
+  std::string mText; ///< Fully formatted log line without new line
+  size_t mMsgOffset; ///< Offset of the user message inside mText
+  FILE* mFanOut; ///< Tag specific or '#' fan-out file, nullptr if none
+  std::string mFanOutText; ///< Line to be written to mFanOut
+};
+
+//------------------------------------------------------------------------------
+//! Class AsyncLogger
+//!
+//! Every logging thread owns a single producer/single consumer ring of log
+//! records so that producers never contend with each other. One writer
+//! thread drains the rings, writes the records in batches with writev to the
+//! fan-out files and stores them in the in-memory circular log of Logging
+//! taking the global logging mutex once per batch.
+//!
+//! Backpressure policy: when the ring of a thread is full, messages with
+//! priority WARNING or more severe block until the writer makes space, all
+//! the other messages are dropped. Dropped messages are counted and reported
+//! in the log by the writer.
+//------------------------------------------------------------------------------
+class AsyncLogger
+{
+public:
+  //! Counters of the asynchronous logging pipeline
+  struct Stats {
+    uint64_t mQueued = 0; ///< Records handed over to the writer
+    uint64_t mWritten = 0; ///< Records processed by the writer
+    uint64_t mDropped = 0; ///< Records dropped because the ring was full
+    uint64_t mBlocked = 0; ///< Records which had to wait for space
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param logging logging object whose fan-out and memory log are used
+  //! @param ring_slots number of records buffered per thread, rounded up to a
+  //!        power of two
+  //----------------------------------------------------------------------------
+  AsyncLogger(Logging& logging, size_t ring_slots = sDefaultRingSlots);
+
+  //----------------------------------------------------------------------------
+  //! Destructor - drains all the pending records
+  //----------------------------------------------------------------------------
+  ~AsyncLogger();
+
+  //----------------------------------------------------------------------------
+  //! Reserve a record in the ring of the calling thread. The writer thread is
+  //! started on first use.
+  //!
+  //! @param priority priority of the message, decides if the call blocks
+  //!        or drops the message when the ring is full
+  //!
+  //! @return record to be filled in and published with Commit or nullptr if
+  //!         the message was dropped
+  //----------------------------------------------------------------------------
+  AsyncLogRecord* Reserve(int priority);
+
+  //----------------------------------------------------------------------------
+  //! Publish the record obtained through the last Reserve call
+  //----------------------------------------------------------------------------
+  void Commit();
+
+  //----------------------------------------------------------------------------
+  //! Wait until all the records queued so far are processed by the writer
+  //----------------------------------------------------------------------------
+  void Flush();
+
+  //----------------------------------------------------------------------------
+  //! Get pipeline counters
+  //----------------------------------------------------------------------------
+  Stats GetStats() const;
+
+  //----------------------------------------------------------------------------
+  //! Forbid copying or moving AsyncLogger objects
+  //----------------------------------------------------------------------------
+  AsyncLogger(const AsyncLogger&) = delete;
+  AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+  class Ring;
+
+private:
+  //----------------------------------------------------------------------------
+  //! Get the ring of the calling thread, registering it if needed
+  //----------------------------------------------------------------------------
+  Ring* GetThreadRing();
+
+  //----------------------------------------------------------------------------
+  //! Start the writer thread if not already running
+  //----------------------------------------------------------------------------
+  void EnsureStarted();
+
+  //----------------------------------------------------------------------------
+  //! Writer thread loop
+  //----------------------------------------------------------------------------
+  void WriterJob(ThreadAssistant& assistant);
+
+  //----------------------------------------------------------------------------
+  //! Drain all the rings once
+  //!
+  //! @return number of records processed
+  //----------------------------------------------------------------------------
+  size_t Drain();
+
+  //----------------------------------------------------------------------------
+  //! Write out and store in memory all the records available in a ring
+  //!
+  //! @return number of records processed
+  //----------------------------------------------------------------------------
+  size_t DrainRing(Ring& ring);
+
+  //----------------------------------------------------------------------------
+  //! Check if any of the rings has records pending
+  //----------------------------------------------------------------------------
+  bool HasPending();
+
+  //! Default number of records buffered per thread
+  static constexpr size_t sDefaultRingSlots = 1024;
+  Logging& mLogging; ///< Logging object
+  size_t mRingSlots; ///< Number of records per ring
+  mutable std::mutex mRingsMutex; ///< Mutex protecting the list of rings
+  std::vector<std::shared_ptr<Ring>> mRings; ///< Rings of all the threads
+  std::vector<std::shared_ptr<Ring>> mDrainRings; ///< Writer copy of mRings
+  std::atomic<bool> mStarted; ///< Mark if the writer thread is running
+  std::mutex mStartMutex; ///< Mutex serializing the writer start
+  std::mutex mWakeMutex; ///< Mutex for the writer notification
+  std::condition_variable mWakeCv; ///< CV to wake up the writer thread
+  std::atomic<bool> mWriterIdle; ///< Mark if the writer is waiting on mWakeCv
+  std::condition_variable mFlushCv; ///< CV notified after every drain
+  std::atomic<uint64_t> mDropped; ///< Records dropped
+  std::atomic<uint64_t> mBlocked; ///< Records which waited for space
+  std::atomic<uint64_t> mWritten; ///< Records processed by the writer
+  uint64_t mRetiredQueued; ///< Records queued by rings already removed
+  uint64_t mReportedDropped; ///< Dropped records already reported in the log
+  const uint64_t mId; ///< Unique id used to match the thread local rings
+  //! Writer scratch space, the iovecs to be written for each file
+  std::vector<std::pair<FILE*, std::vector<struct iovec>>> mIov;
+  AssistedThread mWriterThread; ///< Thread draining the rings
+};
+
+EOSCOMMONNAMESPACE_END
+
+#endif // __EOSCOMMON_ASYNCLOGGER_HH__
@@ -0,0 +1,459 @@
+//------------------------------------------------------------------------------
+// File: Executor.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/Executor.hh"
+#include "common/Logging.hh"
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <pthread.h>
+#include <sched.h>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+constexpr size_t Executor::sNumPriorities;
+
+namespace
+{
+//! Index of the current thread in its pool, if it is a worker
+thread_local const Executor* tlsPool = nullptr;
+thread_local size_t tlsIndex = 0;
+
+//------------------------------------------------------------------------------
+// Registry of the named pools
+//------------------------------------------------------------------------------
+std::mutex&
+GetRegistryMutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<std::string, std::unique_ptr<Executor>>&
+GetRegistry()
+{
+  static std::map<std::string, std::unique_ptr<Executor>> registry;
+  return registry;
+}
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+Executor::Executor(const std::string& name, unsigned int threads, bool pin):
+  mName(name), mNumaNodes(1), mPending(0), mNextWorker(0), mStop(false),
+  mSleepers(0), mSubmitted(0), mExecuted(0), mSteals(0)
+{
+  if (threads == 0) {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  std::vector<std::vector<int>> topology = GetNumaTopology();
+  mNumaNodes = std::min<size_t>(topology.size(), threads);
+
+  for (unsigned int i = 0; i < threads; ++i) {
+    mWorkers.emplace_back(new Worker());
+    mWorkers.back()->mNode = i % mNumaNodes;
+  }
+
+  // Steal order: workers of the same node first, then the others, each
+  // starting after the worker itself to spread the victims
+  for (size_t i = 0; i < mWorkers.size(); ++i) {
+    for (int same = 1; same >= 0; --same) {
+      for (size_t k = 1; k < mWorkers.size(); ++k) {
+        size_t victim = (i + k) % mWorkers.size();
+
+        if ((mWorkers[victim]->mNode == mWorkers[i]->mNode) == (same == 1)) {
+          mWorkers[i]->mVictims.push_back(victim);
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < mWorkers.size(); ++i) {
+    Worker* worker = mWorkers[i].get();
+    worker->mThread = std::thread(&Executor::Run, this, i);
+    std::string thread_name = mName.substr(0, 10) + "-" + std::to_string(i);
+    pthread_setname_np(worker->mThread.native_handle(), thread_name.c_str());
+
+    if (pin && (topology.size() > 1)) {
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+
+      for (int cpu : topology[worker->mNode]) {
+        CPU_SET(cpu, &cpuset);
+      }
+
+      if (pthread_setaffinity_np(worker->mThread.native_handle(),
+                                 sizeof(cpu_set_t), &cpuset)) {
+        eos_static_warning("msg=\"failed to pin worker to numa node\" "
+                           "worker=%s node=%d", thread_name.c_str(),
+                           worker->mNode);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+Executor::~Executor()
+{
+  Stop();
+}
+
+//------------------------------------------------------------------------------
+// Get a named pool
+//------------------------------------------------------------------------------
+Executor&
+Executor::GetPool(const std::string& name, unsigned int threads)
+{
+  std::lock_guard<std::mutex> lock(GetRegistryMutex());
+  auto& registry = GetRegistry();
+  auto it = registry.find(name);
+
+  if (it == registry.end()) {
+    it = registry.emplace(name, std::unique_ptr<Executor>
+                          (new Executor(name, threads))).first;
+  }
+
+  return *it->second;
+}
+
+//------------------------------------------------------------------------------
+// Get the statistics of all the named pools
+//------------------------------------------------------------------------------
+std::vector<Executor::Stats>
+Executor::GetAllStats()
+{
+  std::vector<Stats> all;
+  std::lock_guard<std::mutex> lock(GetRegistryMutex());
+
+  for (const auto& elem : GetRegistry()) {
+    all.push_back(elem.second->GetStats());
+  }
+
+  return all;
+}
+
+//------------------------------------------------------------------------------
+// Submit a task
+//------------------------------------------------------------------------------
+void
+Executor::Add(std::function<void(void)> func, Priority prio)
+{
+  if (mStop || mWorkers.empty()) {
+    // Nobody left to run it
+    func();
+    return;
+  }
+
+  size_t index;
+
+  if (tlsPool == this) {
+    // Keep tasks spawned by a worker local, they are likely to share data
+    index = tlsIndex;
+  } else {
+    index = mNextWorker++ % mWorkers.size();
+  }
+
+  Worker& worker = *mWorkers[index];
+  // Count the task before it becomes visible so that mPending never drops
+  // below the number of tasks in the deques
+  mSubmitted++;
+  mPending++;
+  {
+    std::lock_guard<std::mutex> lock(worker.mMutex);
+    worker.mQueues[static_cast<size_t>(prio)].push_back(Task{std::move(func),
+        Clock::now()});
+  }
+
+  // Sleepers register themselves before checking mPending under the sleep
+  // mutex, so either they see the new task or we see them here
+  if (mSleepers.load()) {
+    std::lock_guard<std::mutex> lock(mSleepMutex);
+    mSleepCond.notify_one();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Take the next task for a worker
+//------------------------------------------------------------------------------
+bool
+Executor::Take(size_t index, Task& task)
+{
+  if (mPending.load() == 0) {
+    return false;
+  }
+
+  for (size_t prio = 0; prio < sNumPriorities; ++prio) {
+    // Own tasks are taken LIFO, while they are still warm in the cache
+    Worker& own = *mWorkers[index];
+    {
+      std::lock_guard<std::mutex> lock(own.mMutex);
+
+      if (!own.mQueues[prio].empty()) {
+        task = std::move(own.mQueues[prio].back());
+        own.mQueues[prio].pop_back();
+        mPending--;
+        return true;
+      }
+    }
+
+    // Stolen tasks are taken FIFO, the oldest first
+    for (size_t victim : own.mVictims) {
+      Worker& other = *mWorkers[victim];
+      std::lock_guard<std::mutex> lock(other.mMutex);
+
+      if (!other.mQueues[prio].empty()) {
+        task = std::move(other.mQueues[prio].front());
+        other.mQueues[prio].pop_front();
+        mPending--;
+        mSteals++;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Take the next task without being a worker
+//------------------------------------------------------------------------------
+bool
+Executor::TakeAny(Task& task)
+{
+  if (mPending.load() == 0) {
+    return false;
+  }
+
+  for (size_t prio = 0; prio < sNumPriorities; ++prio) {
+    for (auto& worker : mWorkers) {
+      std::lock_guard<std::mutex> lock(worker->mMutex);
+
+      if (!worker->mQueues[prio].empty()) {
+        task = std::move(worker->mQueues[prio].front());
+        worker->mQueues[prio].pop_front();
+        mPending--;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Execute a task and account for it
+//------------------------------------------------------------------------------
+void
+Executor::Execute(Task& task)
+{
+  Clock::time_point start = Clock::now();
+  mWaitLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>
+                      (start - task.mSubmitted).count());
+
+  try {
+    task.mFunc();
+  } catch (const std::exception& e) {
+    eos_static_err("msg=\"task threw an exception\" executor=%s what=\"%s\"",
+                   mName.c_str(), e.what());
+  } catch (...) {
+    eos_static_err("msg=\"task threw an unknown exception\" executor=%s",
+                   mName.c_str());
+  }
+
+  task.mFunc = nullptr;
+  mRunLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>
+                     (Clock::now() - start).count());
+  mExecuted++;
+}
+
+//------------------------------------------------------------------------------
+// Worker loop
+//------------------------------------------------------------------------------
+void
+Executor::Run(size_t index)
+{
+  tlsPool = this;
+  tlsIndex = index;
+  Task task;
+
+  while (true) {
+    if (Take(index, task)) {
+      Execute(task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mSleepMutex);
+    mSleepers++;
+    mSleepCond.wait(lock, [this]() {
+      return (mPending.load() != 0) || mStop.load();
+    });
+    mSleepers--;
+
+    if (mStop.load() && (mPending.load() == 0)) {
+      break;
+    }
+  }
+
+  tlsPool = nullptr;
+}
+
+//------------------------------------------------------------------------------
+// Stop the pool
+//------------------------------------------------------------------------------
+void
+Executor::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mSleepMutex);
+
+    if (mStop.exchange(true)) {
+      return;
+    }
+
+    mSleepCond.notify_all();
+  }
+
+  for (auto& worker : mWorkers) {
+    if (worker->mThread.joinable()) {
+      worker->mThread.join();
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the statistics
+//------------------------------------------------------------------------------
+Executor::Stats
+Executor::GetStats() const
+{
+  Stats stats;
+  stats.mName = mName;
+  stats.mThreads = mWorkers.size();
+  stats.mNumaNodes = mNumaNodes;
+  stats.mQueued = mPending.load();
+  stats.mSubmitted = mSubmitted.load();
+  stats.mExecuted = mExecuted.load();
+  stats.mSteals = mSteals.load();
+  stats.mWaitP50 = mWaitLatency.GetPercentile(0.5);
+  stats.mWaitP99 = mWaitLatency.GetPercentile(0.99);
+  stats.mRunP50 = mRunLatency.GetPercentile(0.5);
+  stats.mRunP99 = mRunLatency.GetPercentile(0.99);
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+// Get the statistics as a "key=value" string
+//------------------------------------------------------------------------------
+std::string
+Executor::GetInfo() const
+{
+  Stats stats = GetStats();
+  std::ostringstream oss;
+  oss << "executor=" << stats.mName
+      << " threads=" << stats.mThreads
+      << " numa_nodes=" << stats.mNumaNodes
+      << " queue_size=" << stats.mQueued
+      << " submitted=" << stats.mSubmitted
+      << " executed=" << stats.mExecuted
+      << " steals=" << stats.mSteals
+      << " wait_p50_us=" << stats.mWaitP50 / 1000
+      << " wait_p99_us=" << stats.mWaitP99 / 1000
+      << " run_p50_us=" << stats.mRunP50 / 1000
+      << " run_p99_us=" << stats.mRunP99 / 1000;
+  return oss.str();
+}
+
+//------------------------------------------------------------------------------
+// Get the CPUs of every NUMA node
+//------------------------------------------------------------------------------
+std::vector<std::vector<int>>
+Executor::GetNumaTopology()
+{
+  std::vector<std::vector<int>> topology;
+
+  for (int node = 0; ; ++node) {
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) +
+                       "/cpulist");
+    std::string list;
+
+    if (!file.is_open() || !std::getline(file, list)) {
+      break;
+    }
+
+    std::vector<int> cpus = ParseCpuList(list);
+
+    if (!cpus.empty()) {
+      topology.push_back(cpus);
+    }
+  }
+
+  if (topology.empty()) {
+    std::vector<int> cpus;
+    unsigned int ncpu = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (unsigned int cpu = 0; cpu < ncpu; ++cpu) {
+      cpus.push_back(cpu);
+    }
+
+    topology.push_back(cpus);
+  }
+
+  return topology;
+}
+
+//------------------------------------------------------------------------------
+// Parse a cpulist string
+//------------------------------------------------------------------------------
+std::vector<int>
+Executor::ParseCpuList(const std::string& list)
+{
+  std::vector<int> cpus;
+  std::istringstream iss(list);
+  std::string range;
+
+  while (std::getline(iss, range, ',')) {
+    size_t pos = range.find('-');
+
+    try {
+      if (pos == std::string::npos) {
+        cpus.push_back(std::stoi(range));
+      } else {
+        int first = std::stoi(range.substr(0, pos));
+        int last = std::stoi(range.substr(pos + 1));
+
+        for (int cpu = first; cpu <= last; ++cpu) {
+          cpus.push_back(cpu);
+        }
+      }
+    } catch (const std::logic_error& e) {
+      // Ignore malformed entries e.g. the trailing newline
+    }
+  }
+
+  return cpus;
+}
+
+EOSCOMMONNAMESPACE_END
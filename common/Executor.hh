@@ -0,0 +1,347 @@
+//------------------------------------------------------------------------------
+//! @file Executor.hh
+//! @brief Work-stealing executor with named pools, priorities and statistics
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSCOMMON_EXECUTOR_HH__
+#define __EOSCOMMON_EXECUTOR_HH__
+
+#include "common/Namespace.hh"
+#include "common/RWMutexProfiler.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class Executor
+//!
+//! @description Fixed size pool of worker threads for short, CPU bound tasks.
+//! Every worker owns one deque per priority level: it pushes and pops its own
+//! tasks at the back, and idle workers steal from the front of the deques of
+//! the others, first from workers sitting on the same NUMA node. Tasks
+//! submitted from outside the pool are spread round-robin over the workers,
+//! so there is no single queue all producers and consumers contend on.
+//!
+//! Tasks must not block for long: anything waiting on the network or on
+//! other tasks of the same pool belongs in a ThreadPool.
+//------------------------------------------------------------------------------
+class Executor
+{
+public:
+  //! Task priorities, higher priority tasks are always taken first
+  enum class Priority {
+    High = 0,
+    Normal = 1,
+    Low = 2
+  };
+
+  static constexpr size_t sNumPriorities = 3;
+
+  //! Statistics of a pool
+  struct Stats {
+    std::string mName; ///< Pool name
+    unsigned int mThreads = 0; ///< Number of workers
+    unsigned int mNumaNodes = 0; ///< Number of NUMA nodes used for pinning
+    uint64_t mQueued = 0; ///< Tasks waiting for execution
+    uint64_t mSubmitted = 0; ///< Tasks submitted since start
+    uint64_t mExecuted = 0; ///< Tasks executed since start
+    uint64_t mSteals = 0; ///< Tasks taken from another worker
+    uint64_t mWaitP50 = 0; ///< Median time spent queued in ns
+    uint64_t mWaitP99 = 0; ///< 99th percentile of the time spent queued in ns
+    uint64_t mRunP50 = 0; ///< Median execution time in ns
+    uint64_t mRunP99 = 0; ///< 99th percentile of the execution time in ns
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param name pool name, also used for the thread names
+  //! @param threads number of workers, 0 means hardware concurrency
+  //! @param pin if true pin the workers to the CPUs of the NUMA nodes, spread
+  //!        round-robin over the nodes
+  //----------------------------------------------------------------------------
+  explicit Executor(const std::string& name, unsigned int threads = 0,
+                    bool pin = false);
+
+  //----------------------------------------------------------------------------
+  //! Destructor - runs the queued tasks and joins the workers
+  //----------------------------------------------------------------------------
+  ~Executor();
+
+  //----------------------------------------------------------------------------
+  //! Get a named pool shared by the whole process, created on first use
+  //!
+  //! @param name pool name
+  //! @param threads number of workers if the pool gets created, 0 means
+  //!        hardware concurrency
+  //!
+  //! @return pool reference, valid until the end of the process
+  //----------------------------------------------------------------------------
+  static Executor& GetPool(const std::string& name, unsigned int threads = 0);
+
+  //----------------------------------------------------------------------------
+  //! Get the statistics of all the named pools
+  //----------------------------------------------------------------------------
+  static std::vector<Stats> GetAllStats();
+
+  //----------------------------------------------------------------------------
+  //! Submit a task
+  //!
+  //! @param task function to execute
+  //! @param prio task priority
+  //----------------------------------------------------------------------------
+  void Add(std::function<void(void)> task, Priority prio = Priority::Normal);
+
+  //----------------------------------------------------------------------------
+  //! Submit a task and get a future for its result, same interface as
+  //! ThreadPool::PushTask
+  //----------------------------------------------------------------------------
+  template<typename Ret>
+  std::future<Ret> PushTask(std::function<Ret(void)> func,
+                            Priority prio = Priority::Normal)
+  {
+    auto task = std::make_shared<std::packaged_task<Ret(void)>>(func);
+    Add([task] {
+      (*task)();
+    }, prio);
+    return task->get_future();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Run func(i) for every i in [start, end) and wait for completion. The
+  //! range is cut in at most as many slices as workers, and the calling
+  //! thread processes slices as well so the call makes progress even when
+  //! issued from a task of the same pool. The first exception thrown by func
+  //! is rethrown once all the slices are done.
+  //----------------------------------------------------------------------------
+  template<typename Index, typename Callable>
+  void ParallelFor(Index start, Index end, Callable func,
+                   Priority prio = Priority::Normal);
+
+  //----------------------------------------------------------------------------
+  //! Stop the pool, the queued tasks are still executed. The pool cannot be
+  //! used afterwards.
+  //----------------------------------------------------------------------------
+  void Stop();
+
+  //----------------------------------------------------------------------------
+  //! Get number of workers
+  //----------------------------------------------------------------------------
+  inline unsigned int GetSize() const
+  {
+    return mWorkers.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the pool name
+  //----------------------------------------------------------------------------
+  inline const std::string& GetName() const
+  {
+    return mName;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the statistics
+  //----------------------------------------------------------------------------
+  Stats GetStats() const;
+
+  //----------------------------------------------------------------------------
+  //! Get the statistics as a "key=value" string
+  //----------------------------------------------------------------------------
+  std::string GetInfo() const;
+
+  //----------------------------------------------------------------------------
+  //! Get the CPUs of every NUMA node of the machine
+  //!
+  //! @return one CPU list per node, a single list of all the CPUs if the
+  //!         topology is not available
+  //----------------------------------------------------------------------------
+  static std::vector<std::vector<int>> GetNumaTopology();
+
+  //----------------------------------------------------------------------------
+  //! Parse a cpulist string as found in sysfs e.g. "0-3,8,10-11"
+  //----------------------------------------------------------------------------
+  static std::vector<int> ParseCpuList(const std::string& list);
+
+  // Disable copy/move constructors and assignment operators
+  Executor(const Executor&) = delete;
+  Executor(Executor&&) = delete;
+  Executor& operator=(const Executor&) = delete;
+  Executor& operator=(Executor&&) = delete;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  //! Queued task
+  struct Task {
+    std::function<void(void)> mFunc; ///< Function to execute
+    Clock::time_point mSubmitted; ///< Submission time
+  };
+
+  //! Per worker state
+  struct Worker {
+    std::mutex mMutex; ///< Protects the deques
+    std::deque<Task> mQueues[sNumPriorities]; ///< Tasks by priority
+    std::thread mThread; ///< Worker thread
+    int mNode = 0; ///< NUMA node the worker is pinned to
+    std::vector<size_t> mVictims; ///< Steal order, same node first
+  };
+
+  //----------------------------------------------------------------------------
+  //! Worker loop
+  //!
+  //! @param index index of the worker
+  //----------------------------------------------------------------------------
+  void Run(size_t index);
+
+  //----------------------------------------------------------------------------
+  //! Take the next task for a worker, from its own deques or by stealing
+  //!
+  //! @param index index of the worker
+  //! @param task filled with the task
+  //!
+  //! @return true if a task was found
+  //----------------------------------------------------------------------------
+  bool Take(size_t index, Task& task);
+
+  //----------------------------------------------------------------------------
+  //! Take the next task without being a worker, used by ParallelFor callers
+  //----------------------------------------------------------------------------
+  bool TakeAny(Task& task);
+
+  //----------------------------------------------------------------------------
+  //! Execute a task and account for it
+  //----------------------------------------------------------------------------
+  void Execute(Task& task);
+
+  std::string mName; ///< Pool name
+  std::vector<std::unique_ptr<Worker>> mWorkers; ///< Workers
+  unsigned int mNumaNodes; ///< Number of NUMA nodes the workers span
+  std::atomic<uint64_t> mPending; ///< Number of queued tasks
+  std::atomic<uint64_t> mNextWorker; ///< Round-robin submission cursor
+  std::atomic<bool> mStop; ///< Set when stopping
+  std::mutex mSleepMutex; ///< Mutex for sleeping workers
+  std::condition_variable mSleepCond; ///< Wakes up sleeping workers
+  std::atomic<uint32_t> mSleepers; ///< Number of sleeping workers
+  std::atomic<uint64_t> mSubmitted; ///< Tasks submitted since start
+  std::atomic<uint64_t> mExecuted; ///< Tasks executed since start
+  std::atomic<uint64_t> mSteals; ///< Tasks stolen from another worker
+  LatencyHistogram mWaitLatency; ///< Time between submission and start
+  LatencyHistogram mRunLatency; ///< Execution time
+};
+
+//------------------------------------------------------------------------------
+// Blocking parallel loop
+//------------------------------------------------------------------------------
+template<typename Index, typename Callable>
+void
+Executor::ParallelFor(Index start, Index end, Callable func, Priority prio)
+{
+  if (!(start < end)) {
+    return;
+  }
+
+  //! State shared between the caller and the helper tasks, which may only
+  //! start after the loop is over
+  struct LoopState {
+    std::atomic<uint64_t> mNextSlice {0};
+    std::atomic<uint64_t> mDoneSlices {0};
+    uint64_t mNumSlices = 0;
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    std::exception_ptr mError;
+  };
+
+  uint64_t n = end - start;
+  uint64_t nslices = std::min<uint64_t>(n, std::max(GetSize(), 1u));
+  uint64_t slice = n / nslices;
+  uint64_t rest = n % nslices;
+  auto state = std::make_shared<LoopState>();
+  state->mNumSlices = nslices;
+  // Slice boundaries: the first "rest" slices get one more element
+  auto run_slices = [state, start, slice, rest, &func]() {
+    uint64_t s;
+
+    while ((s = state->mNextSlice++) < state->mNumSlices) {
+      uint64_t first = s * slice + std::min(s, rest);
+      uint64_t last = first + slice + ((s < rest) ? 1 : 0);
+
+      try {
+        for (uint64_t k = first; k < last; ++k) {
+          func(static_cast<Index>(start + k));
+        }
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(state->mMutex);
+
+        if (!state->mError) {
+          state->mError = std::current_exception();
+        }
+      }
+
+      if (++state->mDoneSlices == state->mNumSlices) {
+        std::lock_guard<std::mutex> lock(state->mMutex);
+        state->mCond.notify_all();
+      }
+    }
+  };
+
+  // The helpers only touch func after claiming a slice, and every claimed
+  // slice completes before this function returns
+  for (uint64_t i = 1; i < nslices; ++i) {
+    Add(run_slices, prio);
+  }
+
+  run_slices();
+  Task task;
+
+  // Help with other queued work instead of sleeping while slices are running
+  while (state->mDoneSlices.load() < nslices && TakeAny(task)) {
+    Execute(task);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(state->mMutex);
+    state->mCond.wait(lock, [&state, nslices]() {
+      return state->mDoneSlices.load() == nslices;
+    });
+  }
+
+  if (state->mError) {
+    std::rethrow_exception(state->mError);
+  }
+}
+
+EOSCOMMONNAMESPACE_END
+
+#endif
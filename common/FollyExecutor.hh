@@ -0,0 +1,97 @@
+//------------------------------------------------------------------------------
+//! @file FollyExecutor.hh
+//! @brief Adapter running folly continuations on an eos::common::Executor
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSCOMMON_FOLLYEXECUTOR_HH__
+#define __EOSCOMMON_FOLLYEXECUTOR_HH__
+
+#include "common/Namespace.hh"
+#include "common/Executor.hh"
+#include <folly/Executor.h>
+#include <memory>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class FollyExecutor
+//!
+//! @description Header only so that only the components already depending on
+//! folly pull it in. Does not own the pool, which usually is a named one
+//! obtained through Executor::GetPool.
+//------------------------------------------------------------------------------
+class FollyExecutor : public folly::Executor
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param pool executor running the continuations
+  //----------------------------------------------------------------------------
+  explicit FollyExecutor(eos::common::Executor& pool):
+    mPool(pool)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Run a function with normal priority
+  //----------------------------------------------------------------------------
+  void add(folly::Func func) override
+  {
+    addWithPriority(std::move(func), folly::Executor::MID_PRI);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Run a function, folly priorities above zero map to high and below zero
+  //! to low priority
+  //----------------------------------------------------------------------------
+  void addWithPriority(folly::Func func, int8_t priority) override
+  {
+    // folly::Func is move-only, std::function needs a copyable target
+    auto shared = std::make_shared<folly::Func>(std::move(func));
+    eos::common::Executor::Priority prio =
+      eos::common::Executor::Priority::Normal;
+
+    if (priority > folly::Executor::MID_PRI) {
+      prio = eos::common::Executor::Priority::High;
+    } else if (priority < folly::Executor::MID_PRI) {
+      prio = eos::common::Executor::Priority::Low;
+    }
+
+    mPool.Add([shared]() {
+      (*shared)();
+    }, prio);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of priority levels
+  //----------------------------------------------------------------------------
+  uint8_t getNumPriorities() const override
+  {
+    return eos::common::Executor::sNumPriorities;
+  }
+
+private:
+  eos::common::Executor& mPool; ///< Pool running the functions
+};
+
+EOSCOMMONNAMESPACE_END
+
+#endif
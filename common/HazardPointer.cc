@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------------
+//! @file HazardPointer.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/HazardPointer.hh"
+#include <thread>
+#include <vector>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+//! Slots owned by one thread at a time, records are never freed so that the
+//! writers can walk the list without synchronization
+//------------------------------------------------------------------------------
+struct HazardRecord {
+  static constexpr size_t sNumSlots = 8;
+
+  HazardRecord(): mActive(true), mNext(nullptr)
+  {
+    for (auto& slot : mSlots) {
+      slot.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<const void*> mSlots[sNumSlots]; ///< Protected objects
+  std::atomic<bool> mActive; ///< Record is owned by a thread
+  HazardRecord* mNext; ///< Next record, immutable once published
+};
+
+std::atomic<HazardRecord*> gHazardRecords {nullptr};
+
+//------------------------------------------------------------------------------
+//! Records and free slots of the calling thread
+//------------------------------------------------------------------------------
+struct HazardThreadState {
+  ~HazardThreadState()
+  {
+    for (auto record : mRecords) {
+      record->mActive.store(false, std::memory_order_release);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Take an unused record or append a new one to the list
+  //----------------------------------------------------------------------------
+  void AddRecord()
+  {
+    HazardRecord* record = gHazardRecords.load(std::memory_order_acquire);
+
+    for (; record; record = record->mNext) {
+      bool active = false;
+
+      if (!record->mActive.load(std::memory_order_relaxed) &&
+          record->mActive.compare_exchange_strong(active, true)) {
+        break;
+      }
+    }
+
+    if (!record) {
+      record = new HazardRecord();
+      HazardRecord* head = gHazardRecords.load(std::memory_order_relaxed);
+
+      do {
+        record->mNext = head;
+      } while (!gHazardRecords.compare_exchange_weak(head, record,
+               std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    mRecords.push_back(record);
+
+    for (auto& slot : record->mSlots) {
+      mFree.push_back(&slot);
+    }
+  }
+
+  std::vector<HazardRecord*> mRecords; ///< Records owned by the thread
+  std::vector<std::atomic<const void*>*> mFree; ///< Unused slots
+};
+
+thread_local HazardThreadState tlHazardState;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+HazardPointer::HazardPointer()
+{
+  if (tlHazardState.mFree.empty()) {
+    tlHazardState.AddRecord();
+  }
+
+  mSlot = tlHazardState.mFree.back();
+  tlHazardState.mFree.pop_back();
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+HazardPointer::~HazardPointer()
+{
+  if (mSlot) {
+    mSlot->store(nullptr, std::memory_order_release);
+    tlHazardState.mFree.push_back(mSlot);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Wait until no reader protects the given object anymore
+//------------------------------------------------------------------------------
+void
+HazardPointer::WaitUntilUnprotected(const void* ptr)
+{
+  for (HazardRecord* record = gHazardRecords.load(std::memory_order_acquire);
+       record; record = record->mNext) {
+    for (auto& slot : record->mSlots) {
+      while (slot.load(std::memory_order_seq_cst) == ptr) {
+        std::this_thread::yield();
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Check if an object is protected by any reader
+//------------------------------------------------------------------------------
+bool
+HazardPointer::IsProtected(const void* ptr)
+{
+  for (HazardRecord* record = gHazardRecords.load(std::memory_order_acquire);
+       record; record = record->mNext) {
+    for (auto& slot : record->mSlots) {
+      if (slot.load(std::memory_order_seq_cst) == ptr) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+EOSCOMMONNAMESPACE_END
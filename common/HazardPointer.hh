@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------------
+//! @file HazardPointer.hh
+//! @brief Lock-free protection of objects published through a pointer
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSCOMMON_HAZARDPOINTER_HH__
+#define __EOSCOMMON_HAZARDPOINTER_HH__
+
+#include "common/Namespace.hh"
+#include <atomic>
+#include <cstddef>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class HazardPointer
+//!
+//! Lets readers use an object published through a plain pointer without
+//! taking any lock. A reader announces the object it works on in a slot
+//! owned by its thread, the writer replacing the published pointer waits
+//! until no slot announces the previous object before modifying or freeing
+//! it. Readers never wait, the writer only waits for the readers which are
+//! still using the object it replaced.
+//!
+//! Every thread owns a few records of slots which are reused by the next
+//! thread once it exits. Acquiring and releasing a slot only touches thread
+//! local state.
+//------------------------------------------------------------------------------
+class HazardPointer
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor, takes a free slot of the calling thread
+  //----------------------------------------------------------------------------
+  HazardPointer();
+
+  //----------------------------------------------------------------------------
+  //! Destructor, clears and gives back the slot
+  //----------------------------------------------------------------------------
+  ~HazardPointer();
+
+  //----------------------------------------------------------------------------
+  //! Move constructor
+  //----------------------------------------------------------------------------
+  HazardPointer(HazardPointer&& other) noexcept:
+    mSlot(other.mSlot)
+  {
+    other.mSlot = nullptr;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Forbid copying and assignment
+  //----------------------------------------------------------------------------
+  HazardPointer(const HazardPointer&) = delete;
+  HazardPointer& operator=(const HazardPointer&) = delete;
+  HazardPointer& operator=(HazardPointer&&) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Protect the object currently published in a pointer. The returned object
+  //! stays valid until the guard is reset, destroyed or protects another
+  //! object, even if the pointer is republished in the meantime.
+  //!
+  //! @param src published pointer, only modified through Publish
+  //!
+  //! @return protected object
+  //----------------------------------------------------------------------------
+  template<typename T>
+  T* Protect(T* const& src)
+  {
+    T* ptr = __atomic_load_n(&src, __ATOMIC_ACQUIRE);
+
+    while (true) {
+      mSlot->store(ptr, std::memory_order_seq_cst);
+      T* current = __atomic_load_n(&src, __ATOMIC_SEQ_CST);
+
+      if (current == ptr) {
+        return ptr;
+      }
+
+      ptr = current;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop the protection of the current object
+  //----------------------------------------------------------------------------
+  void Reset()
+  {
+    mSlot->store(nullptr, std::memory_order_release);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Publish a new object for the readers
+  //!
+  //! @param dst published pointer
+  //! @param ptr new object
+  //----------------------------------------------------------------------------
+  template<typename T>
+  static void Publish(T*& dst, T* ptr)
+  {
+    __atomic_store_n(&dst, ptr, __ATOMIC_SEQ_CST);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Wait until no reader protects the given object anymore. Must be called
+  //! after the object was replaced with Publish, the caller must not protect
+  //! the object itself.
+  //!
+  //! @param ptr replaced object
+  //----------------------------------------------------------------------------
+  static void WaitUntilUnprotected(const void* ptr);
+
+  //----------------------------------------------------------------------------
+  //! Check if an object is protected by any reader
+  //!
+  //! @param ptr object
+  //!
+  //! @return true if protected, otherwise false
+  //----------------------------------------------------------------------------
+  static bool IsProtected(const void* ptr);
+
+private:
+  std::atomic<const void*>* mSlot; ///< Slot announcing the protected object
+};
+
+EOSCOMMONNAMESPACE_END
+
+#endif // __EOSCOMMON_HAZARDPOINTER_HH__
@@ -24,11 +24,78 @@
 #include "common/Namespace.hh"
 #include "common/Logging.hh"
 #include "XrdSys/XrdSysPthread.hh"
+#include <algorithm>
 #include <new>
 #include <type_traits>
 
 EOSCOMMONNAMESPACE_BEGIN
 
+namespace
+{
+//! Maximum size of a log message
+const size_t sMaxLogMsgSize = 1024 * 1024;
+//! Slot buffers larger than this are released after holding a big message
+const size_t sMaxIdleSlotCapacity = 64 * 1024;
+
+//------------------------------------------------------------------------------
+//! Per thread cache of the formatted local date and time, localtime_r is only
+//! called when the second changes
+//------------------------------------------------------------------------------
+struct TimePrefix {
+  time_t mSec = -1;
+  char mText[32];
+};
+
+thread_local TimePrefix tTimePrefix;
+
+//------------------------------------------------------------------------------
+// Get "YYMMDD HH:MM:SS" string for the given time
+//------------------------------------------------------------------------------
+const char*
+GetTimePrefix(time_t sec)
+{
+  if (tTimePrefix.mSec != sec) {
+    struct tm tm;
+    localtime_r(&sec, &tm);
+    snprintf(tTimePrefix.mText, sizeof(tTimePrefix.mText),
+             "%02d%02d%02d %02d:%02d:%02d", tm.tm_year - 100, tm.tm_mon + 1,
+             tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+    tTimePrefix.mSec = sec;
+  }
+
+  return tTimePrefix.mText;
+}
+
+//------------------------------------------------------------------------------
+// Printf into a string reusing its capacity
+//------------------------------------------------------------------------------
+void
+AssignFormat(std::string& out, const char* fmt, ...)
+{
+  va_list args, args_copy;
+  va_start(args, fmt);
+  va_copy(args_copy, args);
+
+  if (out.capacity() < 256) {
+    out.reserve(256);
+  }
+
+  out.resize(out.capacity());
+  int len = vsnprintf(&out[0], out.size(), fmt, args);
+
+  if (len < 0) {
+    len = 0;
+  } else if ((size_t) len >= out.size()) {
+    out.resize(len + 1);
+    vsnprintf(&out[0], out.size(), fmt, args_copy);
+  }
+
+  out.resize(len);
+  va_end(args_copy);
+  va_end(args);
+}
+}
+
 static std::atomic<int> sCounter {0};
 static typename std::aligned_storage<sizeof(Logging), alignof(Logging)>::type
 logging_buf; ///< Memory for the global logging object
@@ -68,7 +135,7 @@ Logging::GetInstance()
 //------------------------------------------------------------------------------
 Logging::Logging():
   gLogMask(0), gPriorityLevel(0), gToSysLog(false),  gUnit("none"),
-  gShortFormat(0)
+  gShortFormat(0), mAsync(false), mAsyncLogger(new AsyncLogger(*this))
 {
   // Initialize the log array and sets the log circular size
   gLogCircularIndex.resize(LOG_DEBUG + 1);
@@ -91,6 +158,31 @@ Logging::Logging():
       gToSysLog = true;
     }
   }
+
+  // The writer thread is only started by the first asynchronous message
+  if (getenv("EOS_LOG_ASYNC")) {
+    XrdOucString async = getenv("EOS_LOG_ASYNC");
+
+    if ((async == "1") || (async == "true")) {
+      mAsync = true;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Enable or disable asynchronous logging
+//------------------------------------------------------------------------------
+void
+Logging::SetAsync(bool onoff)
+{
+  if (!onoff && mAsync) {
+    mAsync = false;
+    // Messages logged from now on are written directly, make sure the ones
+    // still queued come first
+    mAsyncLogger->Flush();
+  } else {
+    mAsync = onoff;
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -129,7 +221,7 @@ Logging::log(const char* func, const char* file, int line, const char* logid,
              const Mapping::VirtualIdentity& vid, const char* cident, int priority,
              const char* msg, ...)
 {
-  static int logmsgbuffersize = 1024 * 1024;
+  static int logmsgbuffersize = sMaxLogMsgSize;
   bool silent = (priority == LOG_SILENT);
 
   // short cut if log messages are masked
@@ -152,6 +244,15 @@ Logging::log(const char* func, const char* file, int line, const char* logid,
     }
   }
 
+  if (mAsync) {
+    va_list args;
+    va_start(args, msg);
+    const char* rptr = LogAsync(func, file, line, logid, vid, cident, priority,
+                                msg, args);
+    va_end(args);
+    return rptr;
+  }
+
   static char* buffer = 0;
 
   if (!buffer) {
@@ -164,18 +265,12 @@ Logging::log(const char* func, const char* file, int line, const char* logid,
   // file names like *.cc and *.hh
   File.erase(0, File.rfind("/") + 1);
   File.erase(File.length() - 3);
-  static time_t current_time;
   static struct timeval tv;
   static struct timezone tz;
-  struct tm tm;
   XrdSysMutexHelper scope_lock(gMutex);
   va_list args;
   va_start(args, msg);
   gettimeofday(&tv, &tz);
-  current_time = tv.tv_sec;
-  static char linen[16];
-  sprintf(linen, "%d", line);
-  static char fcident[1024];
   XrdOucString truncname = vid.name;
 
   // we show only the last 16 bytes of the name
@@ -185,41 +280,10 @@ Logging::log(const char* func, const char* file, int line, const char* logid,
   }
 
   char sourceline[64];
-
-  if (gShortFormat) {
-    localtime_r(&current_time, &tm);
-    snprintf(sourceline, sizeof(sourceline) - 1, "%s:%s", File.c_str(), linen);
-    XrdOucString slog = logid;
-
-    if (slog.beginswith("logid:")) {
-      slog.erase(0, 6);
-      sprintf(buffer,
-              "%02d%02d%02d %02d:%02d:%02d t=%lu.%06lu f=%-16s l=%s %s s=%-24s ",
-              tm.tm_year - 100, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour,
-              tm.tm_min, tm.tm_sec, current_time, (unsigned long) tv.tv_usec,
-              func, GetPriorityString(priority), slog.c_str(), sourceline);
-    } else {
-      sprintf(buffer,
-              "%02d%02d%02d %02d:%02d:%02d t=%lu.%06lu f=%-16s l=%s tid=%016lx s=%-24s ",
-              tm.tm_year - 100, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour,
-              tm.tm_min, tm.tm_sec, current_time, (unsigned long) tv.tv_usec,
-              func, GetPriorityString(priority), (unsigned long) XrdSysThread::ID(),
-              sourceline);
-    }
-  } else {
-    sprintf(fcident, "tident=%s sec=%-5s uid=%d gid=%d name=%s geo=\"%s\"", cident,
-            vid.prot.c_str(), vid.uid, vid.gid, truncname.c_str(), vid.geolocation.c_str());
-    localtime_r(&current_time, &tm);
-    snprintf(sourceline, sizeof(sourceline) - 1, "%s:%s", File.c_str(), linen);
-    sprintf(buffer,
-            "%02d%02d%02d %02d:%02d:%02d time=%lu.%06lu func=%-24s level=%s logid=%s unit=%s tid=%016lx source=%-30s %s ",
-            tm.tm_year - 100, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min,
-            tm.tm_sec, current_time, (unsigned long) tv.tv_usec, func,
-            GetPriorityString(priority), logid, gUnit.c_str(),
-            (unsigned long) XrdSysThread::ID(), sourceline, fcident);
-  }
-
-  char* ptr = buffer + strlen(buffer);
+  char* ptr = buffer + FormatHeader(buffer, logmsgbuffersize, tv, func,
+                                    File.c_str(), File.length(), line, logid,
+                                    vid, cident, priority, truncname.c_str(),
+                                    sourceline, sizeof(sourceline));
   // limit the length of the output to buffer-1 length
   vsnprintf(ptr, logmsgbuffersize - (ptr - buffer + 1), msg, args);
 
@@ -293,6 +357,156 @@ Logging::log(const char* func, const char* file, int line, const char* logid,
   return rptr;
 }
 
+//------------------------------------------------------------------------------
+// Format the header of a log line
+//------------------------------------------------------------------------------
+size_t
+Logging::FormatHeader(char* buffer, size_t size, const struct timeval& tv,
+                      const char* func, const char* tag, size_t tag_len,
+                      int line, const char* logid,
+                      const Mapping::VirtualIdentity& vid, const char* cident,
+                      int priority, const char* truncname, char* sourceline,
+                      size_t sourceline_size)
+{
+  int len = 0;
+  const char* time_prefix = GetTimePrefix(tv.tv_sec);
+  snprintf(sourceline, sourceline_size - 1, "%.*s:%d", (int) tag_len, tag,
+           line);
+
+  if (gShortFormat) {
+    if (strncmp(logid, "logid:", 6) == 0) {
+      len = snprintf(buffer, size,
+                     "%s t=%lu.%06lu f=%-16s l=%s %s s=%-24s ",
+                     time_prefix, (unsigned long) tv.tv_sec,
+                     (unsigned long) tv.tv_usec, func,
+                     GetPriorityString(priority), logid + 6, sourceline);
+    } else {
+      len = snprintf(buffer, size,
+                     "%s t=%lu.%06lu f=%-16s l=%s tid=%016lx s=%-24s ",
+                     time_prefix, (unsigned long) tv.tv_sec,
+                     (unsigned long) tv.tv_usec, func,
+                     GetPriorityString(priority),
+                     (unsigned long) XrdSysThread::ID(), sourceline);
+    }
+  } else {
+    char fcident[1024];
+    snprintf(fcident, sizeof(fcident),
+             "tident=%s sec=%-5s uid=%d gid=%d name=%s geo=\"%s\"", cident,
+             vid.prot.c_str(), vid.uid, vid.gid, truncname,
+             vid.geolocation.c_str());
+    len = snprintf(buffer, size,
+                   "%s time=%lu.%06lu func=%-24s level=%s logid=%s unit=%s tid=%016lx source=%-30s %s ",
+                   time_prefix, (unsigned long) tv.tv_sec,
+                   (unsigned long) tv.tv_usec, func, GetPriorityString(priority),
+                   logid, gUnit.c_str(), (unsigned long) XrdSysThread::ID(),
+                   sourceline, fcident);
+  }
+
+  if (len < 0) {
+    buffer[0] = 0;
+    return 0;
+  }
+
+  return std::min((size_t) len, size - 1);
+}
+
+//------------------------------------------------------------------------------
+// Format a message and hand it over to the asynchronous writer
+//------------------------------------------------------------------------------
+const char*
+Logging::LogAsync(const char* func, const char* file, int line,
+                  const char* logid, const Mapping::VirtualIdentity& vid,
+                  const char* cident, int priority, const char* msg,
+                  va_list args)
+{
+  // Returned to the caller, valid until the next message of this thread
+  thread_local std::string tBuffer;
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  // Source file name without directory and extension
+  const char* tag = strrchr(file, '/');
+  tag = (tag ? tag + 1 : file);
+  size_t tag_len = strlen(tag);
+  tag_len = (tag_len > 3 ? tag_len - 3 : 0);
+  // We show only the last 16 bytes of the name
+  const char* truncname = vid.name.c_str();
+  size_t name_len = vid.name.length();
+
+  if (name_len > 16) {
+    truncname += name_len - 16;
+  }
+
+  char header[4096];
+  char sourceline[64];
+  size_t hlen = FormatHeader(header, sizeof(header), tv, func, tag, tag_len,
+                             line, logid, vid, cident, priority, truncname,
+                             sourceline, sizeof(sourceline));
+
+  if (tBuffer.capacity() < hlen + 1024) {
+    tBuffer.reserve(hlen + 1024);
+  }
+
+  tBuffer.resize(tBuffer.capacity());
+  memcpy(&tBuffer[0], header, hlen);
+  va_list args_copy;
+  va_copy(args_copy, args);
+  int len = vsnprintf(&tBuffer[hlen], tBuffer.size() - hlen, msg, args);
+
+  if (len < 0) {
+    len = 0;
+  } else if ((size_t) len >= tBuffer.size() - hlen) {
+    // Limit the length of the output like in synchronous mode
+    size_t new_size = std::min(hlen + len + 1, sMaxLogMsgSize);
+    tBuffer.resize(new_size);
+    vsnprintf(&tBuffer[hlen], new_size - hlen, msg, args_copy);
+    len = std::min((size_t) len, new_size - hlen - 1);
+  }
+
+  va_end(args_copy);
+  tBuffer.resize(hlen + len);
+  AsyncLogRecord* rec = mAsyncLogger->Reserve(priority);
+
+  if (rec == nullptr) {
+    return tBuffer.c_str();
+  }
+
+  if ((rec->mText.capacity() > sMaxIdleSlotCapacity) &&
+      (tBuffer.length() < sMaxIdleSlotCapacity)) {
+    std::string().swap(rec->mText);
+    std::string().swap(rec->mFanOutText);
+  }
+
+  rec->mPriority = priority;
+  rec->mFile = file;
+  rec->mLine = line;
+  rec->mTv = tv;
+  rec->mText.assign(tBuffer);
+  rec->mMsgOffset = hlen;
+  rec->mFanOut = nullptr;
+
+  if (gLogFanOut.size() && (priority != LOG_SILENT)) {
+    const char* ptr = tBuffer.c_str() + hlen;
+    const char* level = GetPriorityString(priority);
+    auto it = gLogFanOut.find(std::string(tag, tag_len));
+
+    if (it != gLogFanOut.end()) {
+      rec->mFanOut = it->second;
+      AssignFormat(rec->mFanOutText, "%.15s %s%s%s %-30s %s \n",
+                   tBuffer.c_str(), GetLogColour(level), level, EOS_TEXTNORMAL,
+                   sourceline, ptr);
+    } else if ((it = gLogFanOut.find("#")) != gLogFanOut.end()) {
+      rec->mFanOut = it->second;
+      AssignFormat(rec->mFanOutText,
+                   "%.15s %s%s%s [%05d/%05d] %16s ::%-16s %s \n",
+                   tBuffer.c_str(), GetLogColour(level), level, EOS_TEXTNORMAL,
+                   vid.uid, vid.gid, truncname, func, ptr);
+    }
+  }
+
+  mAsyncLogger->Commit();
+  return tBuffer.c_str();
+}
+
 bool
 Logging::rate_limit(struct timeval& tv, int priority, const char* file,
                     int line)
@@ -48,6 +48,7 @@
 
 #include "common/Namespace.hh"
 #include "common/Mapping.hh"
+#include "common/AsyncLogger.hh"
 #include "XrdOuc/XrdOucString.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include "XrdSys/XrdSysLogger.hh"
@@ -56,6 +57,9 @@
 #include <sys/syslog.h>
 #include <sys/time.h>
 #include <uuid/uuid.h>
+#include <atomic>
+#include <cstdarg>
+#include <memory>
 #include <string>
 #include <vector>
 #include <sstream>
@@ -369,6 +373,47 @@ public:
   //----------------------------------------------------------------------------
   ~Logging() = default;
 
+  //----------------------------------------------------------------------------
+  //! Enable or disable asynchronous logging. In asynchronous mode messages
+  //! are formatted by the calling thread without taking the global mutex and
+  //! handed over to a writer thread which does all the output, see
+  //! AsyncLogger for the drop policy. Can also be enabled by setting
+  //! EOS_LOG_ASYNC=1 in the environment or at runtime with "eos debug async".
+  //! Disabling it flushes all the pending messages.
+  //!
+  //! @note the value returned by log in asynchronous mode points to a thread
+  //!       local buffer which is valid until the next log call of the thread
+  //----------------------------------------------------------------------------
+  void SetAsync(bool onoff);
+
+  //----------------------------------------------------------------------------
+  //! Check if asynchronous logging is enabled
+  //----------------------------------------------------------------------------
+  bool
+  IsAsync() const
+  {
+    return mAsync;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Wait until all the asynchronously logged messages are written out and
+  //! stored in the in-memory log
+  //----------------------------------------------------------------------------
+  void
+  FlushAsync()
+  {
+    mAsyncLogger->Flush();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the counters of the asynchronous logging pipeline
+  //----------------------------------------------------------------------------
+  AsyncLogger::Stats
+  GetAsyncStats() const
+  {
+    return mAsyncLogger->GetStats();
+  }
+
   //----------------------------------------------------------------------------
   //! Get current loglevel
   //----------------------------------------------------------------------------
@@ -628,6 +673,47 @@ public:
   //---------------------------------------------------------------------------
 
   bool rate_limit(struct timeval& tv, int priority, const char* file, int line);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Format the header of a log line i.e. everything up to the message
+  //!
+  //! @param buffer output buffer
+  //! @param size size of the output buffer
+  //! @param tv time of the message
+  //! @param func name of the calling function
+  //! @param tag source file name without directory and extension
+  //! @param tag_len length of the tag
+  //! @param line line in the source file
+  //! @param logid log message identifier
+  //! @param vid virtual id of the caller
+  //! @param cident client identifier
+  //! @param priority priority level of the message
+  //! @param truncname truncated user name of the caller
+  //! @param sourceline output buffer for the "<tag>:<line>" string
+  //! @param sourceline_size size of the sourceline buffer
+  //!
+  //! @return length of the header
+  //----------------------------------------------------------------------------
+  size_t FormatHeader(char* buffer, size_t size, const struct timeval& tv,
+                      const char* func, const char* tag, size_t tag_len,
+                      int line, const char* logid,
+                      const Mapping::VirtualIdentity& vid, const char* cident,
+                      int priority, const char* truncname, char* sourceline,
+                      size_t sourceline_size);
+
+  //----------------------------------------------------------------------------
+  //! Format a message and hand it over to the asynchronous writer
+  //!
+  //! @return pointer to the formatted log message
+  //----------------------------------------------------------------------------
+  const char* LogAsync(const char* func, const char* file, int line,
+                       const char* logid, const Mapping::VirtualIdentity& vid,
+                       const char* cident, int priority, const char* msg,
+                       va_list args);
+
+  std::atomic<bool> mAsync; ///< Mark if asynchronous logging is enabled
+  std::unique_ptr<AsyncLogger> mAsyncLogger; ///< Asynchronous writer
 };
 
 extern Logging& gLogging; ///< Global logging object
@@ -27,10 +27,13 @@
 #include "common/Logging.hh"
 #include "common/SecEntity.hh"
 #include "common/SymKeys.hh"
+#include "common/HazardPointer.hh"
 #include "XrdSys/XrdSysDNS.hh"
 #include "XrdOuc/XrdOucEnv.hh"
 #include <pwd.h>
 #include <grp.h>
+#include <mutex>
+#include <thread>
 
 EOSCOMMONNAMESPACE_BEGIN
 
@@ -41,7 +44,6 @@ const std::string Mapping::PROXY_GEOTAG = "proxy";
 // global mapping objects
 /*----------------------------------------------------------------------------*/
 RWMutex Mapping::gMapMutex;
-XrdSysMutex Mapping::gPhysicalIdMutex;
 
 Mapping::UserRoleMap_t Mapping::gUserRoleVector;
 Mapping::GroupRoleMap_t Mapping::gGroupRoleVector;
@@ -54,20 +56,34 @@ Mapping::GeoLocationMap_t Mapping::gGeoMap;
 
 Mapping::AllowedTidentMatches_t Mapping::gAllowedTidentMatches;
 
-XrdSysMutex Mapping::ActiveLock;
+Mapping::Rules* Mapping::gRules = new Mapping::Rules();
 
-google::dense_hash_map<std::string, time_t> Mapping::ActiveTidents;
+Mapping::ActiveTidentTable Mapping::ActiveTidents(65536, 300);
 
-XrdOucHash<Mapping::id_pair> Mapping::gPhysicalUidCache;
-XrdOucHash<Mapping::gid_vector> Mapping::gPhysicalGidCache;
+TtlCache<std::string, Mapping::id_pair> Mapping::gPhysicalUidCache(3600);
+TtlCache<std::string, Mapping::gid_vector> Mapping::gPhysicalGidCache(3600);
 
-XrdSysMutex Mapping::gPhysicalNameCacheMutex;
-std::map<uid_t, std::string> Mapping::gPhysicalUserNameCache;
-std::map<gid_t, std::string> Mapping::gPhysicalGroupNameCache;
-std::map<std::string, uid_t> Mapping::gPhysicalUserIdCache;
-std::map<std::string, gid_t> Mapping::gPhysicalGroupIdCache;
+TtlCache<uid_t, std::string> Mapping::gPhysicalUserNameCache(3600);
+TtlCache<gid_t, std::string> Mapping::gPhysicalGroupNameCache(3600);
+TtlCache<std::string, uid_t> Mapping::gPhysicalUserIdCache(3600);
+TtlCache<std::string, gid_t> Mapping::gPhysicalGroupIdCache(3600);
 
 Mapping::ip_cache Mapping::gIpCache(300);
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Get the value of a rule, the default value if there is no such rule
+//------------------------------------------------------------------------------
+template <typename Map>
+typename Map::mapped_type
+GetRule(const Map& map, const typename Map::key_type& key)
+{
+  auto it = map.find(key);
+  return (it != map.end()) ? it->second : typename Map::mapped_type();
+}
+}
+
 /*----------------------------------------------------------------------------*/
 /**
  * Initialize Google maps
@@ -79,9 +95,6 @@ Mapping::ip_cache Mapping::gIpCache(300);
 void
 Mapping::Init()
 {
-  ActiveTidents.set_empty_key("#__EMPTY__#");
-  ActiveTidents.set_deleted_key("#__DELETED__#");
-
   // allow FUSE client access as root via env variable
   if (getenv("EOS_FUSE_NO_ROOT_SQUASH") &&
       !strcmp("1", getenv("EOS_FUSE_NO_ROOT_SQUASH"))) {
@@ -95,58 +108,219 @@ Mapping::Init()
 void
 Mapping::Reset()
 {
-  {
-    XrdSysMutexHelper mLock(gPhysicalIdMutex);
-    gPhysicalUidCache.Purge();
-    gPhysicalGidCache.Purge();
+  gPhysicalUidCache.Clear();
+  gPhysicalGidCache.Clear();
+  gPhysicalGroupNameCache.Clear();
+  gPhysicalUserNameCache.Clear();
+  gPhysicalGroupIdCache.Clear();
+  gPhysicalUserIdCache.Clear();
+  ActiveTidents.Clear();
+}
+
+//------------------------------------------------------------------------------
+// Take the write lock on the rule maps
+//------------------------------------------------------------------------------
+Mapping::RulesWriteLock::RulesWriteLock(const char* file, int line):
+  mLock(gMapMutex, file, line)
+{}
+
+//------------------------------------------------------------------------------
+// Publish a snapshot of the rule maps and release the write lock. The old
+// snapshot is freed once no IdMap call uses it anymore.
+//------------------------------------------------------------------------------
+Mapping::RulesWriteLock::~RulesWriteLock()
+{
+  Rules* rules = new Rules();
+  rules->mUserRoleVector = gUserRoleVector;
+  rules->mGroupRoleVector = gGroupRoleVector;
+  rules->mVirtualUidMap = gVirtualUidMap;
+  rules->mVirtualGidMap = gVirtualGidMap;
+  rules->mSudoerMap = gSudoerMap;
+  rules->mGeoMap = gGeoMap;
+  rules->mAllowedTidentMatches = gAllowedTidentMatches;
+  Rules* old = gRules;
+  HazardPointer::Publish(gRules, rules);
+  HazardPointer::WaitUntilUnprotected(old);
+  delete old;
+}
+
+//------------------------------------------------------------------------------
+// ActiveTidentTable constructor
+//------------------------------------------------------------------------------
+Mapping::ActiveTidentTable::ActiveTidentTable(size_t capacity,
+    time_t reuse_after):
+  mReuseAfter(reuse_after), mMask(1)
+{
+  while (mMask < capacity) {
+    mMask <<= 1;
   }
-  {
-    XrdSysMutexHelper mLock(gPhysicalNameCacheMutex);
-    gPhysicalGroupNameCache.clear();
-    gPhysicalUserNameCache.clear();
-    gPhysicalGroupIdCache.clear();
-    gPhysicalUserIdCache.clear();
+
+  mSlots.reset(new Slot[mMask]);
+  mMask -= 1;
+}
+
+//------------------------------------------------------------------------------
+// ActiveTidentTable destructor
+//------------------------------------------------------------------------------
+Mapping::ActiveTidentTable::~ActiveTidentTable()
+{
+  for (size_t i = 0; i <= mMask; ++i) {
+    delete mSlots[i].mKey;
   }
-  {
-    XrdSysMutexHelper mLock(ActiveLock);
-    ActiveTidents.clear();
+}
+
+//------------------------------------------------------------------------------
+// Record the usage of a client
+//------------------------------------------------------------------------------
+void
+Mapping::ActiveTidentTable::Touch(const std::string& key, time_t now)
+{
+  uint64_t hash = std::hash<std::string>()(key);
+
+  if (!hash) {
+    hash = 1;
+  }
+
+  Slot* idle = nullptr;
+  time_t idle_since = 0;
+
+  for (size_t i = 0; i < sMaxProbes; ++i) {
+    Slot& slot = mSlots[(hash + i) & mMask];
+    uint64_t current = slot.mHash.load(std::memory_order_acquire);
+
+    if ((current == hash) && HoldsKey(slot, key)) {
+      slot.mLastUse.store(now, std::memory_order_relaxed);
+      return;
+    }
+
+    if (current == 0) {
+      // End of the probe sequence, the client is not in the table. Prefer an
+      // idle slot seen on the way to keep the sequences short.
+      if (idle) {
+        break;
+      }
+
+      if (slot.mHash.compare_exchange_strong(current, hash)) {
+        HazardPointer::Publish(slot.mKey, new std::string(key));
+        slot.mLastUse.store(now, std::memory_order_release);
+        return;
+      }
+
+      if ((current == hash) && HoldsKey(slot, key)) {
+        slot.mLastUse.store(now, std::memory_order_relaxed);
+        return;
+      }
+
+      continue;
+    }
+
+    if (!idle) {
+      time_t last = slot.mLastUse.load(std::memory_order_relaxed);
+
+      if (last && (now - last > mReuseAfter)) {
+        idle = &slot;
+        idle_since = last;
+      }
+    }
+  }
+
+  // Take over the idle slot, a zero usage time keeps others away from it
+  // until the new key is in place
+  if (idle && idle->mLastUse.compare_exchange_strong(idle_since, 0)) {
+    idle->mHash.store(hash, std::memory_order_release);
+    std::string* old = idle->mKey;
+    HazardPointer::Publish(idle->mKey, new std::string(key));
+    idle->mLastUse.store(now, std::memory_order_release);
+    HazardPointer::WaitUntilUnprotected(old);
+    delete old;
   }
 }
 
+//------------------------------------------------------------------------------
+// Check if a slot whose hash matches holds the given key
+//------------------------------------------------------------------------------
+bool
+Mapping::ActiveTidentTable::HoldsKey(const Slot& slot, const std::string& key)
+{
+  // The key of a slot being filled in is published before its usage time
+  while (!slot.mLastUse.load(std::memory_order_acquire)) {
+    std::this_thread::yield();
+  }
 
-/*----------------------------------------------------------------------------*/
-/**
- * Expire Active client entries which have not been used since interval
- *
- * @param interval seconds of idle time for expiration
- */
+  HazardPointer guard;
+  const std::string* held = guard.Protect(slot.mKey);
+  return (held && (*held == key));
+}
 
-/*----------------------------------------------------------------------------*/
+//------------------------------------------------------------------------------
+// Collect the clients used within the given interval
+//------------------------------------------------------------------------------
 void
-Mapping::ActiveExpire(int interval, bool force)
+Mapping::ActiveTidentTable::Collect(time_t interval,
+                                    std::vector<std::pair<std::string, time_t>>&
+                                    entries) const
 {
-  static time_t expire = 0;
-  // needs to have Active Lock locked
   time_t now = time(NULL);
+  HazardPointer guard;
 
-  if (force || (now > expire)) {
-    // expire tidents older than interval
-    google::dense_hash_map<std::string, time_t>::iterator it1;
-    google::dense_hash_map<std::string, time_t>::iterator it2;
-
-    for (it1 = Mapping::ActiveTidents.begin();
-         it1 != Mapping::ActiveTidents.end();) {
-      if ((now - it1->second) > interval) {
-        it2 = it1;
-        ++it1;
-        Mapping::ActiveTidents.erase(it2);
-      } else {
-        ++it1;
-      }
+  for (size_t i = 0; i <= mMask; ++i) {
+    const Slot& slot = mSlots[i];
+
+    if (!slot.mHash.load(std::memory_order_relaxed)) {
+      continue;
     }
 
-    Mapping::ActiveTidents.resize(0);
-    expire = now + 1800;
+    time_t last = slot.mLastUse.load(std::memory_order_acquire);
+
+    if (!last || (now - last > interval)) {
+      continue;
+    }
+
+    const std::string* key = guard.Protect(slot.mKey);
+
+    if (key) {
+      entries.emplace_back(*key, last);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Count the clients used within the given interval
+//------------------------------------------------------------------------------
+size_t
+Mapping::ActiveTidentTable::Count(time_t interval) const
+{
+  time_t now = time(NULL);
+  size_t count = 0;
+
+  for (size_t i = 0; i <= mMask; ++i) {
+    if (!mSlots[i].mHash.load(std::memory_order_relaxed)) {
+      continue;
+    }
+
+    time_t last = mSlots[i].mLastUse.load(std::memory_order_relaxed);
+
+    if (last && (now - last <= interval)) {
+      ++count;
+    }
+  }
+
+  return count;
+}
+
+//------------------------------------------------------------------------------
+// Mark all the clients as idle, the slots are reused by new clients
+//------------------------------------------------------------------------------
+void
+Mapping::ActiveTidentTable::Clear()
+{
+  for (size_t i = 0; i <= mMask; ++i) {
+    time_t last = mSlots[i].mLastUse.load(std::memory_order_relaxed);
+
+    // Slots being filled in are left alone
+    if (last) {
+      mSlots[i].mLastUse.compare_exchange_strong(last, 1);
+    }
   }
 }
 
@@ -187,7 +361,11 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   XrdOucString groupalias = useralias;
   useralias += "uid";
   groupalias += "gid";
-  RWMutexReadLock lock(gMapMutex);
+  // The rules stay valid until the guard goes out of scope
+  HazardPointer rules_guard;
+  const Rules* rules = rules_guard.Protect(gRules);
+  const VirtualUserMap_t& uid_map = rules->mVirtualUidMap;
+  const VirtualGroupMap_t& gid_map = rules->mVirtualGidMap;
   vid.prot = client->prot;
 
   if (vid.prot == "sss") {
@@ -200,14 +378,14 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "krb5")) {
     eos_static_debug("krb5 mapping");
 
-    if (gVirtualUidMap.count("krb5:\"<pwd>\":uid")) {
+    if (uid_map.count("krb5:\"<pwd>\":uid")) {
       // use physical mapping for kerberos names
       Mapping::getPhysicalIds(client->name, vid);
       vid.gid = 99;
       vid.gid_list.clear();
     }
 
-    if (gVirtualGidMap.count("krb5:\"<pwd>\":gid")) {
+    if (gid_map.count("krb5:\"<pwd>\":gid")) {
       // use physical mapping for kerberos names
       uid_t uid = vid.uid;
       Mapping::getPhysicalIds(client->name, vid);
@@ -224,14 +402,14 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "gsi")) {
     eos_static_debug("gsi mapping");
 
-    if (gVirtualUidMap.count("gsi:\"<pwd>\":uid")) {
+    if (uid_map.count("gsi:\"<pwd>\":uid")) {
       // use physical mapping for gsi names
       Mapping::getPhysicalIds(client->name, vid);
       vid.gid = 99;
       vid.gid_list.clear();
     }
 
-    if (gVirtualGidMap.count("gsi:\"<pwd>\":gid")) {
+    if (gid_map.count("gsi:\"<pwd>\":gid")) {
       // use physical mapping for gsi names
       uid_t uid = vid.uid;
       Mapping::getPhysicalIds(client->name, vid);
@@ -263,28 +441,29 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       vomsgidstring += ":gid";
 
       // mapping to user
-      if (gVirtualUidMap.count(vomsuidstring)) {
+      if (uid_map.count(vomsuidstring)) {
         vid.uid_list.clear();
         vid.gid_list.clear();
         // use physical mapping for VOMS roles
         // convert mapped uid to user name
         int errc = 0;
-        std::string cname = Mapping::UidToUserName(gVirtualUidMap[vomsuidstring], errc);
+        std::string cname = Mapping::UidToUserName(GetRule(uid_map,
+                            vomsuidstring), errc);
 
         if (!errc) {
           Mapping::getPhysicalIds(cname.c_str(), vid);
         } else {
           Nobody(vid);
           eos_static_err("voms-mapping: cannot translate uid=%d to user name with the password db",
-                         (int) gVirtualUidMap[vomsuidstring]);
+                         (int) GetRule(uid_map, vomsuidstring));
         }
       }
 
       // mapping to group
-      if (gVirtualGidMap.count(vomsgidstring)) {
+      if (gid_map.count(vomsgidstring)) {
         // use group mapping for VOMS roles
         vid.gid_list.clear();
-        vid.gid = gVirtualGidMap[vomsgidstring];
+        vid.gid = GetRule(gid_map, vomsgidstring);
         vid.gid_list.push_back(vid.gid);
       }
     }
@@ -296,23 +475,23 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "https")) {
     eos_static_debug("https mapping");
 
-    if (gVirtualUidMap.count("https:\"<pwd>\":uid")) {
-      if (gVirtualGidMap["https:\"<pwd>\":uid"] == 0) {
+    if (uid_map.count("https:\"<pwd>\":uid")) {
+      if (GetRule(gid_map, "https:\"<pwd>\":uid") == 0) {
         // use physical mapping for https names
         Mapping::getPhysicalIds(client->name, vid);
         vid.gid = 99;
         vid.gid_list.clear();
       } else {
         vid.uid_list.clear();
-        vid.uid_list.push_back(gVirtualGidMap["https:\"<pwd>\":uid"]);
+        vid.uid_list.push_back(GetRule(gid_map, "https:\"<pwd>\":uid"));
         vid.uid_list.push_back(99);
         vid.gid = 99;
         vid.gid_list.clear();
       }
     }
 
-    if (gVirtualGidMap.count("https:\"<pwd>\":gid")) {
-      if (gVirtualGidMap["https:\"<pwd>\":gid"] == 0) {
+    if (gid_map.count("https:\"<pwd>\":gid")) {
+      if (GetRule(gid_map, "https:\"<pwd>\":gid") == 0) {
         // use physical mapping for gsi names
         uid_t uid = vid.uid;
         Mapping::getPhysicalIds(client->name, vid);
@@ -322,7 +501,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         vid.uid_list.push_back(99);
       } else {
         vid.gid_list.clear();
-        vid.gid_list.push_back(gVirtualGidMap["https:\"<pwd>\":gid"]);
+        vid.gid_list.push_back(GetRule(gid_map, "https:\"<pwd>\":gid"));
         vid.gid_list.push_back(99);
       }
     }
@@ -334,8 +513,8 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "sss")) {
     eos_static_debug("sss mapping");
 
-    if (gVirtualUidMap.count("sss:\"<pwd>\":uid")) {
-      if (gVirtualUidMap["sss:\"<pwd>\":uid"] == 0) {
+    if (uid_map.count("sss:\"<pwd>\":uid")) {
+      if (GetRule(uid_map, "sss:\"<pwd>\":uid") == 0) {
         eos_static_debug("sss uid mapping");
         Mapping::getPhysicalIds(client->name, vid);
         vid.gid = 99;
@@ -344,7 +523,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         eos_static_debug("sss uid forced mapping");
         // map to the requested id
         vid.uid_list.clear();
-        vid.uid = gVirtualUidMap["sss:\"<pwd>\":uid"];
+        vid.uid = GetRule(uid_map, "sss:\"<pwd>\":uid");
         vid.uid_list.push_back(vid.uid);
 
         if (vid.uid != 99) {
@@ -357,8 +536,8 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       }
     }
 
-    if (gVirtualGidMap.count("sss:\"<pwd>\":gid")) {
-      if (gVirtualGidMap["sss:\"<pwd>\":gid"] == 0) {
+    if (gid_map.count("sss:\"<pwd>\":gid")) {
+      if (GetRule(gid_map, "sss:\"<pwd>\":gid") == 0) {
         eos_static_debug("sss gid mapping");
         // use physical mapping for sss names
         uid_t uid = vid.uid;
@@ -371,7 +550,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         eos_static_debug("sss forced gid mapping");
         // map to the requested id
         vid.gid_list.clear();
-        vid.gid = gVirtualGidMap["sss:\"<pwd>\":gid"];
+        vid.gid = GetRule(gid_map, "sss:\"<pwd>\":gid");
         vid.gid_list.push_back(vid.gid);
       }
     }
@@ -383,8 +562,8 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "unix")) {
     eos_static_debug("unix mapping");
 
-    if (gVirtualUidMap.count("unix:\"<pwd>\":uid")) {
-      if (gVirtualUidMap["unix:\"<pwd>\":uid"] == 0) {
+    if (uid_map.count("unix:\"<pwd>\":uid")) {
+      if (GetRule(uid_map, "unix:\"<pwd>\":uid") == 0) {
         eos_static_debug("unix uid mapping");
         // use physical mapping for unix names
         Mapping::getPhysicalIds(client->name, vid);
@@ -394,7 +573,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         eos_static_debug("unix uid forced mapping");
         // map to the requested id
         vid.uid_list.clear();
-        vid.uid = gVirtualUidMap["unix:\"<pwd>\":uid"];
+        vid.uid = GetRule(uid_map, "unix:\"<pwd>\":uid");
         vid.uid_list.push_back(vid.uid);
 
         if (vid.uid != 99) {
@@ -407,8 +586,8 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       }
     }
 
-    if (gVirtualGidMap.count("unix:\"<pwd>\":gid")) {
-      if (gVirtualGidMap["unix:\"<pwd>\":gid"] == 0) {
+    if (gid_map.count("unix:\"<pwd>\":gid")) {
+      if (GetRule(gid_map, "unix:\"<pwd>\":gid") == 0) {
         eos_static_debug("unix gid mapping");
         // use physical mapping for unix names
         uid_t uid = vid.uid;
@@ -421,7 +600,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         eos_static_debug("unix forced gid mapping");
         // map to the requested id
         vid.gid_list.clear();
-        vid.gid = gVirtualGidMap["unix:\"<pwd>\":gid"];
+        vid.gid = GetRule(gid_map, "unix:\"<pwd>\":gid");
         vid.gid_list.push_back(vid.gid);
       }
     }
@@ -467,9 +646,9 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   eos_static_debug("swcuidtident=%s sprotuidtident=%s myrole=%s",
                    swcuidtident.c_str(), sprotuidtident.c_str(), myrole.c_str());
 
-  if ((gVirtualUidMap.count(suidtident.c_str()))) {
+  if ((uid_map.count(suidtident.c_str()))) {
     //    eos_static_debug("tident mapping");
-    vid.uid = gVirtualUidMap[suidtident.c_str()];
+    vid.uid = GetRule(uid_map, suidtident.c_str());
 
     if (!HasUid(vid.uid, vid.uid_list)) {
       vid.uid_list.push_back(vid.uid);
@@ -480,9 +659,9 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
     }
   }
 
-  if ((gVirtualGidMap.count(sgidtident.c_str()))) {
+  if ((gid_map.count(sgidtident.c_str()))) {
     //    eos_static_debug("tident mapping");
-    vid.gid = gVirtualGidMap[sgidtident.c_str()];
+    vid.gid = GetRule(gid_map, sgidtident.c_str());
 
     if (!HasGid(vid.gid, vid.gid_list)) {
       vid.gid_list.push_back(vid.gid);
@@ -501,19 +680,19 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   XrdOucString tuid = "";
   XrdOucString tgid = "";
 
-  if (gVirtualUidMap.count(swcuidtident.c_str())) {
+  if (uid_map.count(swcuidtident.c_str())) {
     // there is an entry like "*@<host:uid" matching all protocols
     tuid = swcuidtident.c_str();
   } else {
-    if (gVirtualUidMap.count(sprotuidtident.c_str())) {
+    if (uid_map.count(sprotuidtident.c_str())) {
       // there is a protocol specific entry "<prot>@<host>:uid"
       tuid = sprotuidtident.c_str();
     } else {
-      if (gAllowedTidentMatches.size()) {
+      if (rules->mAllowedTidentMatches.size()) {
         std::string sprot = vid.prot.c_str();
 
-        for (auto it = gAllowedTidentMatches.begin(); it != gAllowedTidentMatches.end();
-             ++it) {
+        for (auto it = rules->mAllowedTidentMatches.begin();
+             it != rules->mAllowedTidentMatches.end(); ++it) {
           if (sprot != it->first.c_str()) {
             continue;
           }
@@ -521,7 +700,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
           if (host.matches(it->second.c_str())) {
             sprotuidtident.replace(host.c_str(), it->second.c_str());
 
-            if (gVirtualUidMap.count(sprotuidtident.c_str())) {
+            if (uid_map.count(sprotuidtident.c_str())) {
               tuid = sprotuidtident.c_str();
               break;
             }
@@ -531,19 +710,19 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
     }
   }
 
-  if (gVirtualGidMap.count(swcgidtident.c_str())) {
+  if (gid_map.count(swcgidtident.c_str())) {
     // there is an entry like "*@<host>:gid" matching all protocols
     tgid = swcgidtident.c_str();
   } else {
-    if (gVirtualGidMap.count(sprotgidtident.c_str())) {
+    if (gid_map.count(sprotgidtident.c_str())) {
       // there is a protocol specific entry "<prot>@<host>:uid"
       tgid = sprotgidtident.c_str();
     } else {
-      if (gAllowedTidentMatches.size()) {
+      if (rules->mAllowedTidentMatches.size()) {
         std::string sprot = vid.prot.c_str();
 
-        for (auto it = gAllowedTidentMatches.begin(); it != gAllowedTidentMatches.end();
-             ++it) {
+        for (auto it = rules->mAllowedTidentMatches.begin();
+             it != rules->mAllowedTidentMatches.end(); ++it) {
           if (sprot != it->first.c_str()) {
             continue;
           }
@@ -551,7 +730,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
           if (host.matches(it->second.c_str())) {
             sprotuidtident.replace(host.c_str(), it->second.c_str());
 
-            if (gVirtualUidMap.count(sprotuidtident.c_str())) {
+            if (uid_map.count(sprotuidtident.c_str())) {
               tuid = sprotuidtident.c_str();
               break;
             }
@@ -563,8 +742,8 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
 
   eos_static_debug("tuid=%s tgid=%s", tuid.c_str(), tgid.c_str());
 
-  if (gVirtualUidMap.count(tuid.c_str())) {
-    if (!gVirtualUidMap[tuid.c_str()]) {
+  if (uid_map.count(tuid.c_str())) {
+    if (!GetRule(uid_map, tuid.c_str())) {
       if (gRootSquash && (host != "localhost") && (host != "localhost.localdomain") &&
           (host != "localhost6.localdomain6") && (vid.name == "root") &&
           (myrole == "root")) {
@@ -594,7 +773,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       eos_static_debug("tident uid forced mapping");
       // map to the requested id
       vid.uid_list.clear();
-      vid.uid = gVirtualUidMap[tuid.c_str()];
+      vid.uid = GetRule(uid_map, tuid.c_str());
       vid.uid_list.push_back(vid.uid);
 
       if (vid.uid != 99) {
@@ -607,8 +786,8 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
     }
   }
 
-  if (gVirtualGidMap.count(tgid.c_str())) {
-    if (!gVirtualGidMap[tgid.c_str()]) {
+  if (gid_map.count(tgid.c_str())) {
+    if (!GetRule(gid_map, tgid.c_str())) {
       if (gRootSquash && (host != "localhost") && (host != "localhost.localdomain") &&
           (vid.name == "root") && (myrole == "root")) {
         eos_static_debug("tident root gid squash");
@@ -635,7 +814,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       eos_static_debug("tident gid forced mapping");
       // map to the requested id
       vid.gid_list.clear();
-      vid.gid = gVirtualGidMap[tgid.c_str()];
+      vid.gid = GetRule(gid_map, tgid.c_str());
       vid.gid_list.push_back(vid.gid);
     }
   }
@@ -664,15 +843,15 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   // ---------------------------------------------------------------------------
   // explicit virtual mapping overrules physical mappings - the second one comes from the physical mapping before
   // ---------------------------------------------------------------------------
-  vid.uid = (gVirtualUidMap.count(useralias.c_str())) ?
-            gVirtualUidMap[useralias.c_str() ] : vid.uid;
+  vid.uid = (uid_map.count(useralias.c_str())) ?
+            GetRule(uid_map, useralias.c_str()) : vid.uid;
 
   if (!HasUid(vid.uid, vid.uid_list)) {
     vid.uid_list.insert(vid.uid_list.begin(), vid.uid);
   }
 
-  vid.gid = (gVirtualGidMap.count(groupalias.c_str())) ?
-            gVirtualGidMap[groupalias.c_str()] : vid.gid;
+  vid.gid = (gid_map.count(groupalias.c_str())) ?
+            GetRule(gid_map, groupalias.c_str()) : vid.gid;
 
   // eos_static_debug("mapped %d %d", vid.uid,vid.gid);
 
@@ -683,21 +862,23 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   // ---------------------------------------------------------------------------
   // add virtual user and group roles - if any
   // ---------------------------------------------------------------------------
-  if (gUserRoleVector.count(vid.uid)) {
+  auto uroles = rules->mUserRoleVector.find(vid.uid);
+
+  if (uroles != rules->mUserRoleVector.end()) {
     uid_vector::const_iterator it;
 
-    for (it = gUserRoleVector[vid.uid].begin();
-         it != gUserRoleVector[vid.uid].end(); ++it)
+    for (it = uroles->second.begin(); it != uroles->second.end(); ++it)
       if (!HasUid((*it), vid.uid_list)) {
         vid.uid_list.push_back((*it));
       }
   }
 
-  if (gGroupRoleVector.count(vid.uid)) {
+  auto groles = rules->mGroupRoleVector.find(vid.uid);
+
+  if (groles != rules->mGroupRoleVector.end()) {
     gid_vector::const_iterator it;
 
-    for (it = gGroupRoleVector[vid.uid].begin();
-         it != gGroupRoleVector[vid.uid].end(); ++it)
+    for (it = groles->second.begin(); it != groles->second.end(); ++it)
       if (!HasGid((*it), vid.gid_list)) {
         vid.gid_list.push_back((*it));
       }
@@ -717,7 +898,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       int errc = 0;
       // try alias conversion
       std::string luid = ruid.c_str();
-      sel_uid = (gVirtualUidMap.count(ruid.c_str())) ? gVirtualUidMap[ruid.c_str() ] :
+      sel_uid = (uid_map.count(ruid.c_str())) ? GetRule(uid_map, ruid.c_str()) :
                 99;
 
       if (sel_uid == 99) {
@@ -735,7 +916,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       int errc = 0;
       // try alias conversion
       std::string lgid = rgid.c_str();
-      sel_gid = (gVirtualGidMap.count(rgid.c_str())) ? gVirtualGidMap[rgid.c_str()] :
+      sel_gid = (gid_map.count(rgid.c_str())) ? GetRule(gid_map, rgid.c_str()) :
                 99;
 
       if (sel_gid == 99) {
@@ -751,7 +932,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   // ---------------------------------------------------------------------------
   // Sudoer flag setting
   // ---------------------------------------------------------------------------
-  if (gSudoerMap.count(vid.uid)) {
+  if (rules->mSudoerMap.count(vid.uid)) {
     vid.sudoer = true;
   }
 
@@ -817,13 +998,15 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   // ---------------------------------------------------------------------------
   // Check the Geo Location
   // ---------------------------------------------------------------------------
-  if ((!vid.geolocation.length()) && (gGeoMap.size())) {
+  const GeoLocationMap_t& geo_map = rules->mGeoMap;
+
+  if ((!vid.geolocation.length()) && (geo_map.size())) {
     // if the geo location was not set externally and we have some recipe we try
     // to translate the host name and match a rule
 
     // if we have a default geo location we assume that a client in that one
-    if (gGeoMap.count("default")) {
-      vid.geolocation = gGeoMap["default"];
+    if (geo_map.count("default")) {
+      vid.geolocation = GetRule(geo_map, "default");
     }
 
     std::string ipstring = gIpCache.GetIp(host.c_str());
@@ -831,12 +1014,12 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
     if (ipstring.length()) {
       std::string sipstring = ipstring;
       GeoLocationMap_t::const_iterator it;
-      GeoLocationMap_t::const_iterator longuestmatch = gGeoMap.end();
+      GeoLocationMap_t::const_iterator longuestmatch = geo_map.end();
 
       // we use the geo location with the longest name match
-      for (it = gGeoMap.begin(); it != gGeoMap.end(); ++it) {
+      for (it = geo_map.begin(); it != geo_map.end(); ++it) {
         // if we have a previously matched geoloc and if it's longer that the current one, try the next one
-        if (longuestmatch != gGeoMap.end() &&
+        if (longuestmatch != geo_map.end() &&
             it->first.length() <= longuestmatch->first.length()) {
           continue;
         }
@@ -850,26 +1033,16 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   }
 
   // ---------------------------------------------------------------------------
-  // Maintain the active client map and expire old entries
+  // Maintain the active client table, it has a fixed size so 'nasty' clients
+  // cannot exceed the memory
   // ---------------------------------------------------------------------------
-  ActiveLock.Lock();
-
-  // ---------------------------------------------------------------------------
-  // safty measures not to exceed memory by 'nasty' clients
-  // ---------------------------------------------------------------------------
-  if (ActiveTidents.size() > 25000) {
-    ActiveExpire();
-  }
-
-  if (ActiveTidents.size() < 60000) {
+  {
     char actident[1024];
     snprintf(actident, sizeof(actident) - 1, "%d^%s^%s^%s^%s", vid.uid,
              mytident.c_str(), vid.prot.c_str(), vid.host.c_str(), vid.app.c_str());
-    std::string intident = actident;
-    ActiveTidents[intident] = now;
+    ActiveTidents.Touch(actident, now);
   }
 
-  ActiveLock.UnLock();
   eos_static_debug("selected %d %d [%s %s]", vid.uid, vid.gid, ruid.c_str(),
                    rgid.c_str());
 
@@ -1135,14 +1308,13 @@ Mapping::getPhysicalIds(const char* name, VirtualIdentity& vid)
     return;
   }
 
-  gid_vector* gv;
-  id_pair* id  = 0;
+  gid_vector gv;
+  id_pair id(0, 0);
   memset(&passwdinfo, 0, sizeof(passwdinfo));
   eos_static_debug("find in uid cache %s", name);
-  XrdSysMutexHelper gLock(gPhysicalIdMutex);
 
   // cache short cut's
-  if (!(id = gPhysicalUidCache.Find(name))) {
+  if (!gPhysicalUidCache.Get(name, id)) {
     eos_static_debug("not found in uid cache");
     XrdOucString sname = name;
     bool use_pw = true;
@@ -1173,7 +1345,7 @@ Mapping::getPhysicalIds(const char* name, VirtualIdentity& vid)
                              bituser, n_tohll(bituser));
           } else {
             eos_static_err("msg=\"decoded base-64 uid/gid/sid too long\" len=%d", outlen);
-            delete id;
+            free(out);
             return;
           }
 
@@ -1183,86 +1355,69 @@ Mapping::getPhysicalIds(const char* name, VirtualIdentity& vid)
             free(out);
           }
 
-          if (id) {
-            delete id;
-          }
-
           if (sname.beginswith("*")) {
-            id  = new id_pair((bituser >> 22) & 0xfffff, (bituser >> 6) & 0xffff);
+            id = id_pair((bituser >> 22) & 0xfffff, (bituser >> 6) & 0xffff);
           } else {
             // only user id got forwarded, we retrieve the corresponding group
             uid_t ruid = (bituser >> 6) & 0xfffffffff;
-            gPhysicalIdMutex.UnLock();
             struct passwd* pwbufp = 0;
 
             if (getpwuid_r(ruid, &passwdinfo, buffer, 16384, &pwbufp) || (!pwbufp)) {
-              gPhysicalIdMutex.Lock();
               return;
             }
 
-            id = new id_pair(passwdinfo.pw_uid, passwdinfo.pw_gid);
+            id = id_pair(passwdinfo.pw_uid, passwdinfo.pw_gid);
           }
 
-          eos_static_debug("using base64 mapping %s %d %d", sname.c_str(), id->uid,
-                           id->gid);
+          eos_static_debug("using base64 mapping %s %d %d", sname.c_str(), id.uid,
+                           id.gid);
         } else {
           eos_static_err("msg=\"failed to decoded base-64 uid/gid/sid\" id=%s",
                          sname.c_str());
-          gPhysicalIdMutex.UnLock();
-          delete id;
           return;
         }
       }
 
       if (known_tident) {
-        if (gRootSquash && (!id->uid || !id->gid)) {
+        if (gRootSquash && (!id.uid || !id.gid)) {
           return;
         }
 
-        vid.uid = id->uid;
-        vid.gid = id->gid;
+        vid.uid = id.uid;
+        vid.gid = id.gid;
         vid.uid_list.clear();
         vid.uid_list.push_back(vid.uid);
         vid.gid_list.clear();
         vid.gid_list.push_back(vid.gid);
-        gid_vector* vec = new uid_vector;
-        *vec = vid.gid_list;
-        gPhysicalUidCache.Add(name, id, 3600);
-        eos_static_debug("adding to cache uid=%u gid=%u", id->uid, id->gid);
-        gPhysicalGidCache.Add(name, vec, 3600);
+        gPhysicalUidCache.Store(name, id);
+        eos_static_debug("adding to cache uid=%u gid=%u", id.uid, id.gid);
+        gPhysicalGidCache.Store(name, vid.gid_list);
         use_pw = false;
       }
     }
 
     if (use_pw) {
-      gPhysicalIdMutex.UnLock();
       struct passwd* pwbufp = 0;
-      {
-        if (getpwnam_r(name, &passwdinfo, buffer, 16384, &pwbufp) || (!pwbufp)) {
-          gPhysicalIdMutex.Lock();
-          return;
-        }
+
+      if (getpwnam_r(name, &passwdinfo, buffer, 16384, &pwbufp) || (!pwbufp)) {
+        return;
       }
-      gPhysicalIdMutex.Lock();
-      id = new id_pair(passwdinfo.pw_uid, passwdinfo.pw_gid);
-      gPhysicalUidCache.Add(name, id, 3600);
-      eos_static_debug("adding to cache uid=%u gid=%u", id->uid, id->gid);
-    }
 
-    if (!id) {
-      return;
+      id = id_pair(passwdinfo.pw_uid, passwdinfo.pw_gid);
+      gPhysicalUidCache.Store(name, id);
+      eos_static_debug("adding to cache uid=%u gid=%u", id.uid, id.gid);
     }
   }
 
-  vid.uid = id->uid;
-  vid.gid = id->gid;
+  vid.uid = id.uid;
+  vid.gid = id.gid;
 
-  if ((gv = gPhysicalGidCache.Find(name))) {
-    vid.uid_list.push_back(id->uid);
-    vid.gid_list = *gv;
-    vid.uid = id->uid;
-    vid.gid = id->gid;
-    eos_static_debug("returning uid=%u gid=%u", id->uid, id->gid);
+  if (gPhysicalGidCache.Get(name, gv)) {
+    vid.uid_list.push_back(id.uid);
+    vid.gid_list = gv;
+    vid.uid = id.uid;
+    vid.gid = id.gid;
+    eos_static_debug("returning uid=%u gid=%u", id.uid, id.gid);
     return;
   }
 
@@ -1270,9 +1425,12 @@ Mapping::getPhysicalIds(const char* name, VirtualIdentity& vid)
                                  getenv("EOS_SECONDARY_GROUPS") : "";
 
   if (secondary_groups.length() && (secondary_groups == "1")) {
+    // the group database iteration is not reentrant
+    static std::mutex grent_mutex;
+    std::lock_guard<std::mutex> grent_lock(grent_mutex);
     struct group* gr;
     eos_static_debug("group lookup");
-    gid_t gid = id->gid;
+    gid_t gid = id.gid;
     setgrent();
 
     while ((gr = getgrent())) {
@@ -1299,9 +1457,7 @@ Mapping::getPhysicalIds(const char* name, VirtualIdentity& vid)
   }
 
   // add to the cache
-  gid_vector* vec = new uid_vector;
-  *vec = vid.gid_list;
-  gPhysicalGidCache.Add(name, vec, 3600);
+  gPhysicalGidCache.Store(name, vid.gid_list);
   return;
 }
 
@@ -1320,16 +1476,14 @@ std::string
 Mapping::UidToUserName(uid_t uid, int& errc)
 {
   errc = 0;
-  {
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
+  std::string uid_string = "";
 
-    if (gPhysicalUserNameCache.count(uid)) {
-      return gPhysicalUserNameCache[uid];
-    }
+  if (gPhysicalUserNameCache.Get(uid, uid_string)) {
+    return uid_string;
   }
+
   char buffer[131072];
   int buflen = sizeof(buffer);
-  std::string uid_string = "";
   struct passwd pwbuf;
   struct passwd* pwbufp = 0;
   (void) getpwuid_r(uid, &pwbuf, buffer, buflen, &pwbufp);
@@ -1352,18 +1506,16 @@ Mapping::UidToUserName(uid_t uid, int& errc)
         errc = 0;
       }
     }
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
-    gPhysicalUserNameCache[uid] = uid_string;
-    gPhysicalUserIdCache[uid_string] = uid;
+    gPhysicalUserNameCache.Store(uid, uid_string);
+    gPhysicalUserIdCache.Store(uid_string, uid);
     return uid_string;
   } else {
     uid_string = pwbuf.pw_name;
     errc = 0;
   }
 
-  XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
-  gPhysicalUserNameCache[uid] = uid_string;
-  gPhysicalUserIdCache[uid_string] = uid;
+  gPhysicalUserNameCache.Store(uid, uid_string);
+  gPhysicalUserIdCache.Store(uid_string, uid);
   return uid_string;
 }
 
@@ -1382,19 +1534,17 @@ std::string
 Mapping::GidToGroupName(gid_t gid, int& errc)
 {
   errc = 0;
-  {
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
+  std::string gid_string = "";
 
-    if (gPhysicalGroupNameCache.count(gid)) {
-      return gPhysicalGroupNameCache[gid];
-    }
+  if (gPhysicalGroupNameCache.Get(gid, gid_string)) {
+    return gid_string;
   }
+
   {
     char buffer[131072];
     int buflen = sizeof(buffer);
     struct group grbuf;
     struct group* grbufp = 0;
-    std::string gid_string = "";
 
     if (getgrgid_r(gid, &grbuf, buffer, buflen, &grbufp) || (!grbufp)) {
       // cannot translate this name
@@ -1408,9 +1558,8 @@ Mapping::GidToGroupName(gid_t gid, int& errc)
       errc = 0;
     }
 
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
-    gPhysicalGroupNameCache[gid] = gid_string;
-    gPhysicalGroupIdCache[gid_string] = gid;
+    gPhysicalGroupNameCache.Store(gid, gid_string);
+    gPhysicalGroupIdCache.Store(gid_string, gid);
     return gid_string;
   }
 }
@@ -1428,16 +1577,14 @@ Mapping::GidToGroupName(gid_t gid, int& errc)
 uid_t
 Mapping::UserNameToUid(const std::string& username, int& errc)
 {
-  {
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
+  uid_t uid = 99;
 
-    if (gPhysicalUserIdCache.count(username)) {
-      return gPhysicalUserIdCache[username];
-    }
+  if (gPhysicalUserIdCache.Get(username, uid)) {
+    return uid;
   }
+
   char buffer[131072];
   int buflen = sizeof(buffer);
-  uid_t uid = 99;
   struct passwd pwbuf;
   struct passwd* pwbufp = 0;
   errc = 0;
@@ -1469,9 +1616,8 @@ Mapping::UserNameToUid(const std::string& username, int& errc)
   }
 
   if (!errc) {
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
-    gPhysicalUserIdCache[username] = uid;
-    gPhysicalUserNameCache[uid] = username;
+    gPhysicalUserIdCache.Store(username, uid);
+    gPhysicalUserNameCache.Store(uid, username);
   }
 
   return uid;
@@ -1491,18 +1637,16 @@ Mapping::UserNameToUid(const std::string& username, int& errc)
 gid_t
 Mapping::GroupNameToGid(const std::string& groupname, int& errc)
 {
-  {
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
+  gid_t gid = 99;
 
-    if (gPhysicalGroupIdCache.count(groupname)) {
-      return gPhysicalGroupIdCache[groupname];
-    }
+  if (gPhysicalGroupIdCache.Get(groupname, gid)) {
+    return gid;
   }
+
   char buffer[131072];
   int buflen = sizeof(buffer);
   struct group grbuf;
   struct group* grbufp = 0;
-  gid_t gid = 99;
   errc = 0;
   (void) getgrnam_r(groupname.c_str(), &grbuf, buffer, buflen, &grbufp);
 
@@ -1531,9 +1675,8 @@ Mapping::GroupNameToGid(const std::string& groupname, int& errc)
   }
 
   if (!errc) {
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
-    gPhysicalGroupIdCache[groupname] = gid;
-    gPhysicalGroupNameCache[gid] = groupname;
+    gPhysicalGroupIdCache.Store(groupname, gid);
+    gPhysicalGroupNameCache.Store(gid, groupname);
   }
 
   return gid;
@@ -27,12 +27,15 @@
 
 #include "common/Namespace.hh"
 #include "common/RWMutex.hh"
+#include "common/TtlCache.hh"
 #include "XrdOuc/XrdOucString.hh"
 #include "XrdOuc/XrdOucHash.hh"
 #include <map>
 #include <set>
 #include <vector>
 #include <string>
+#include <atomic>
+#include <memory>
 #include <google/dense_hash_map>
 
 //! Forward declaration
@@ -116,6 +119,130 @@ public:
     int mLifeTime;
   };
 
+  //----------------------------------------------------------------------------
+  //! Immutable snapshot of the mapping rules used by IdMap. A new snapshot is
+  //! published by RulesWriteLock whenever the rule maps were modified.
+  //----------------------------------------------------------------------------
+  struct Rules {
+    UserRoleMap_t mUserRoleVector;
+    GroupRoleMap_t mGroupRoleVector;
+    VirtualUserMap_t mVirtualUidMap;
+    VirtualGroupMap_t mVirtualGidMap;
+    SudoerMap_t mSudoerMap;
+    GeoLocationMap_t mGeoMap;
+    AllowedTidentMatches_t mAllowedTidentMatches;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Write lock on the rule maps, publishes a new rule snapshot for IdMap once
+  //! the maps were modified and the lock goes out of scope
+  //----------------------------------------------------------------------------
+  class RulesWriteLock
+  {
+  public:
+    //--------------------------------------------------------------------------
+    //! Constructor
+    //!
+    //! @param file source file of the caller, used by the contention profiler
+    //! @param line source line of the caller, used by the contention profiler
+    //--------------------------------------------------------------------------
+    RulesWriteLock(const char* file = EOS_RWMUTEX_CALLER_FILE,
+                   int line = EOS_RWMUTEX_CALLER_LINE);
+
+    //--------------------------------------------------------------------------
+    //! Destructor, publishes the modified rules
+    //--------------------------------------------------------------------------
+    ~RulesWriteLock();
+
+    //--------------------------------------------------------------------------
+    //! Forbid copying
+    //--------------------------------------------------------------------------
+    RulesWriteLock(const RulesWriteLock&) = delete;
+    RulesWriteLock& operator=(const RulesWriteLock&) = delete;
+
+  private:
+    RWMutexWriteLock mLock; ///< Write lock on gMapMutex
+  };
+
+  //----------------------------------------------------------------------------
+  //! Table of the active client identifiers and their last usage time
+  //!
+  //! Fixed size open addressing table updated without locks: a known client
+  //! only stores the current time in its slot, a new one claims an empty slot
+  //! with a CAS or takes over one idle for longer than the reuse time. The
+  //! keys are published through hazard pointers so that readers can copy them
+  //! while slots get reused. Readers get a best effort snapshot.
+  //----------------------------------------------------------------------------
+  class ActiveTidentTable
+  {
+  public:
+    //--------------------------------------------------------------------------
+    //! Constructor
+    //!
+    //! @param capacity number of slots, rounded up to a power of two
+    //! @param reuse_after seconds of idle time after which a slot can be
+    //!        given to another client
+    //--------------------------------------------------------------------------
+    ActiveTidentTable(size_t capacity, time_t reuse_after);
+
+    //--------------------------------------------------------------------------
+    //! Destructor
+    //--------------------------------------------------------------------------
+    ~ActiveTidentTable();
+
+    //--------------------------------------------------------------------------
+    //! Record the usage of a client, dropped if no slot is free nearby
+    //!
+    //! @param key client identifier
+    //! @param now current time
+    //--------------------------------------------------------------------------
+    void Touch(const std::string& key, time_t now);
+
+    //--------------------------------------------------------------------------
+    //! Collect the clients used within the given interval
+    //!
+    //! @param interval maximum idle time in seconds
+    //! @param entries filled with client identifier and last usage time
+    //--------------------------------------------------------------------------
+    void Collect(time_t interval,
+                 std::vector<std::pair<std::string, time_t>>& entries) const;
+
+    //--------------------------------------------------------------------------
+    //! Count the clients used within the given interval
+    //!
+    //! @param interval maximum idle time in seconds
+    //--------------------------------------------------------------------------
+    size_t Count(time_t interval) const;
+
+    //--------------------------------------------------------------------------
+    //! Mark all the clients as idle
+    //--------------------------------------------------------------------------
+    void Clear();
+
+  private:
+    //! Slot of the table, a zero hash marks an empty slot and a zero usage
+    //! time a slot being filled in
+    struct Slot {
+      std::atomic<uint64_t> mHash {0}; ///< Hash of the key
+      std::atomic<time_t> mLastUse {0}; ///< Last usage time
+      std::string* mKey {nullptr}; ///< Key, replaced through HazardPointer
+    };
+
+    //--------------------------------------------------------------------------
+    //! Check if a slot whose hash matches holds the given key, waits for a
+    //! slot being filled in
+    //!
+    //! @param slot slot with the hash of the key
+    //! @param key client identifier
+    //--------------------------------------------------------------------------
+    static bool HoldsKey(const Slot& slot, const std::string& key);
+
+    static constexpr size_t sMaxProbes = 64; ///< Probe length of a lookup
+    const time_t mReuseAfter; ///< Idle time after which a slot is reused
+    size_t mMask; ///< Number of slots minus one
+    std::unique_ptr<Slot[]> mSlots; ///< Slots
+  };
+
   //----------------------------------------------------------------------------
   //! Struct defining the virtual identity of a client e.g. his memberships and
   //! authentication information
@@ -242,63 +369,50 @@ public:
 
   // ---------------------------------------------------------------------------
   //! A cache for physical user id caching (e.g. from user name to uid)
-  static XrdOucHash<id_pair> gPhysicalUidCache;
-
-  // ---------------------------------------------------------------------------
-  //! A cache for physical group id caching (e.g. from group name to gid)
   // ---------------------------------------------------------------------------
-  static XrdOucHash<gid_vector> gPhysicalGidCache;
+  static TtlCache<std::string, id_pair> gPhysicalUidCache;
 
   // ---------------------------------------------------------------------------
-  //! A mutex protecting the physical id->name caches
+  //! A cache for physical group id caching (e.g. from group name to gid)
   // ---------------------------------------------------------------------------
-  static XrdSysMutex gPhysicalNameCacheMutex;
+  static TtlCache<std::string, gid_vector> gPhysicalGidCache;
 
   // ---------------------------------------------------------------------------
   //! A cache for physical user name caching (e.g. from uid to name)
-  static std::map<uid_t, std::string> gPhysicalUserNameCache;
-  static std::map<std::string, uid_t> gPhysicalUserIdCache;
-
-  // ---------------------------------------------------------------------------
-  //! A cache for physical group id caching (e.g. from gid name to name)
   // ---------------------------------------------------------------------------
-  static std::map<gid_t, std::string> gPhysicalGroupNameCache;
-  static std::map<std::string, gid_t> gPhysicalGroupIdCache;
+  static TtlCache<uid_t, std::string> gPhysicalUserNameCache;
+  static TtlCache<std::string, uid_t> gPhysicalUserIdCache;
 
   // ---------------------------------------------------------------------------
-  //! Mutex to protect the physical ID caches
+  //! A cache for physical group id caching (e.g. from gid name to name)
   // ---------------------------------------------------------------------------
-  static XrdSysMutex gPhysicalIdMutex;
+  static TtlCache<gid_t, std::string> gPhysicalGroupNameCache;
+  static TtlCache<std::string, gid_t> gPhysicalGroupIdCache;
 
   // ---------------------------------------------------------------------------
-  //! RWMutex protecting all global hashmaps
+  //! RWMutex protecting the rule maps, IdMap reads the published snapshot
   // ---------------------------------------------------------------------------
   static RWMutex gMapMutex;
 
   // ---------------------------------------------------------------------------
-  //! Mutex protecting the active tident map
+  //! Rule snapshot read by IdMap, replaced by RulesWriteLock
   // ---------------------------------------------------------------------------
-  static XrdSysMutex ActiveLock;
+  static Rules* gRules;
 
   // ---------------------------------------------------------------------------
   //! Cache for host to ip translatiosn used by geo mapping
   // ---------------------------------------------------------------------------
   static ip_cache gIpCache;
 
-  // ---------------------------------------------------------------------------
-  //! Function to expire unused ActiveTident entries by default after 1 day
-  // ---------------------------------------------------------------------------
-  static void ActiveExpire(int interval = 300, bool force = false);
-
   // ---------------------------------------------------------------------------
   //! Function initializing static maps
   // ---------------------------------------------------------------------------
   static void Init();
 
   // ---------------------------------------------------------------------------
-  //! Map storing the client identifiers and last usage time
+  //! Table storing the client identifiers and last usage time
   // ---------------------------------------------------------------------------
-  static google::dense_hash_map<std::string, time_t> ActiveTidents;
+  static ActiveTidentTable ActiveTidents;
 
   // ---------------------------------------------------------------------------
   //! Variable to forbid remote root mounts - by default true
@@ -24,67 +24,33 @@
 /**
  * @file   Parallel.hh
  *
- * @brief  Class providing a parallel for function using lambda functions/threads
- *
+ * @brief  Class providing a parallel for function using lambda functions
+ *         executed on the shared "parallel" executor pool
  *
  */
 
-#include <thread>
-#include <mutex>
-#include <vector>
-#include <cmath>
-#include <features.h>
 #ifndef __EOSCOMMON__PARALLEL__HH
 #define __EOSCOMMON__PARALLEL__HH
 
-EOSCOMMONNAMESPACE_BEGIN
+#include "common/Namespace.hh"
+#include "common/Executor.hh"
 
-#if __GNUC_PREREQ(4,8) || defined(__clang__)
+EOSCOMMONNAMESPACE_BEGIN
 
 class Parallel
 {
 
 public:
 
+  //----------------------------------------------------------------------------
+  //! Run func(i) for every i in [start, end) and wait for completion. The
+  //! work is spread over the process wide "parallel" executor pool instead
+  //! of spawning new threads on every call.
+  //----------------------------------------------------------------------------
   template<typename Index, typename Callable>
   static void For(Index start, Index end, Callable func)
   {
-    // Estimate number of threads in the pool
-    const static unsigned nb_threads_hint = std::thread::hardware_concurrency();
-    const static unsigned nb_threads = (nb_threads_hint == 0u ? 8u :
-                                        nb_threads_hint);
-    // Size of a slice for the range functions
-    Index n = end - start + 1;
-    Index slice = (Index) std::round(n / static_cast<double>(nb_threads));
-    slice = std::max(slice, Index(1));
-    // [Helper] Inner loop
-    auto launchRange = [&func](int k1, int k2) {
-      for (Index k = k1; k < k2; k++) {
-        func(k);
-      }
-    };
-    // Create pool and launch jobs
-    std::vector<std::thread> pool;
-    pool.reserve(nb_threads);
-    Index i1 = start;
-    Index i2 = std::min(start + slice, end);
-
-    for (unsigned i = 0; i + 1 < nb_threads && i1 < end; ++i) {
-      pool.emplace_back(launchRange, i1, i2);
-      i1 = i2;
-      i2 = std::min(i2 + slice, end);
-    }
-
-    if (i1 < end) {
-      pool.emplace_back(launchRange, i1, end);
-    }
-
-    // Wait for jobs to finish
-    for (std::thread& t : pool) {
-      if (t.joinable()) {
-        t.join();
-      }
-    }
+    Executor::GetPool("parallel").ParallelFor(start, end, func);
   }
 
   // Serial version for easy comparison
@@ -97,8 +63,6 @@ public:
   }
 };
 
-#endif
-
 EOSCOMMONNAMESPACE_END
 
 #endif
@@ -114,6 +114,22 @@ pthread_rwlock_t RWMutex::mOrderChkLock;
 #define EOS_RWMUTEX_TIMER_STOP_AND_UPDATE(what) ++(what##LockCounter);
 #endif
 
+#define EOS_RWMUTEX_PROFILER_START                                         \
+  uint64_t prof_tstamp = 0;                                                \
+  if (RWMutexProfiler::IsEnabled() && RWMutexProfiler::ShouldSample()) {   \
+    prof_tstamp = RWMutexProfiler::GetNowInNs();                           \
+  }
+
+// write = true or false
+#define EOS_RWMUTEX_PROFILER_ACQUIRED(write)                               \
+  if (prof_tstamp) {                                                       \
+    RWMutexHold prof_hold = RWMutexProfiler::Acquired(this, write, file,   \
+                            line, prof_tstamp);                            \
+    if (write) {                                                           \
+      mProfiledWrite = prof_hold;                                          \
+    }                                                                      \
+  }
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -203,6 +219,7 @@ RWMutex::operator=(RWMutex&& other) noexcept
     this->mMutexImpl = other.mMutexImpl;
     other.mMutexImpl = nullptr;
     this->mBlocking = other.mBlocking;
+    this->mDebugName = std::move(other.mDebugName);
   }
 
   return *this;
@@ -221,10 +238,11 @@ RWMutex::RWMutex(RWMutex&& other) noexcept
 // Try to read lock the mutex within the timeout value
 //------------------------------------------------------------------------------
 bool
-RWMutex::TimedRdLock(uint64_t timeout_ns)
+RWMutex::TimedRdLock(uint64_t timeout_ns, const char* file, int line)
 {
   EOS_RWMUTEX_CHECKORDER_LOCK;
   EOS_RWMUTEX_TIMER_START;
+  EOS_RWMUTEX_PROFILER_START;
 #ifdef EOS_INSTRUMENTED_RWMUTEX
 
   if (sEnableGlobalDeadlockCheck) {
@@ -245,6 +263,11 @@ RWMutex::TimedRdLock(uint64_t timeout_ns)
 
 #endif
   EOS_RWMUTEX_TIMER_STOP_AND_UPDATE(mRd);
+
+  if (retc == 0) {
+    EOS_RWMUTEX_PROFILER_ACQUIRED(false);
+  }
+
   return (retc == 0);
 }
 
@@ -252,10 +275,11 @@ RWMutex::TimedRdLock(uint64_t timeout_ns)
 // Lock for read
 //------------------------------------------------------------------------------
 void
-RWMutex::LockRead()
+RWMutex::LockRead(const char* file, int line)
 {
   EOS_RWMUTEX_CHECKORDER_LOCK;
   EOS_RWMUTEX_TIMER_START;
+  EOS_RWMUTEX_PROFILER_START;
 #ifdef EOS_INSTRUMENTED_RWMUTEX
 
   if (sEnableGlobalDeadlockCheck) {
@@ -276,6 +300,7 @@ RWMutex::LockRead()
   }
 
   EOS_RWMUTEX_TIMER_STOP_AND_UPDATE(mRd);
+  EOS_RWMUTEX_PROFILER_ACQUIRED(false);
 }
 
 //------------------------------------------------------------------------------
@@ -300,6 +325,8 @@ RWMutex::UnLockRead()
     std::terminate();
   }
 
+  RWMutexProfiler::ReleasedRead(this);
+
 #ifdef EOS_INSTRUMENTED_RWMUTEX
 
   if (!sEnableGlobalDeadlockCheck) {
@@ -317,10 +344,11 @@ RWMutex::UnLockRead()
 // Lock for write
 //------------------------------------------------------------------------------
 void
-RWMutex::LockWrite()
+RWMutex::LockWrite(const char* file, int line)
 {
   EOS_RWMUTEX_CHECKORDER_LOCK;
   EOS_RWMUTEX_TIMER_START;
+  EOS_RWMUTEX_PROFILER_START;
 #ifdef EOS_INSTRUMENTED_RWMUTEX
 
   if (sEnableGlobalDeadlockCheck) {
@@ -384,6 +412,7 @@ RWMutex::LockWrite()
   mLastWriteLock = std::chrono::duration_cast<std::chrono::milliseconds>
                    (std::chrono::steady_clock::now().time_since_epoch()).count();
   EOS_RWMUTEX_TIMER_STOP_AND_UPDATE(mWr);
+  EOS_RWMUTEX_PROFILER_ACQUIRED(true);
 }
 
 //------------------------------------------------------------------------------
@@ -405,6 +434,10 @@ RWMutex::UnLockWrite()
   // mLastWriteLock must be checked _before_ we release the lock!
   int64_t blockedFor = std::chrono::duration_cast<std::chrono::milliseconds>
                        (std::chrono::steady_clock::now().time_since_epoch()).count() - mLastWriteLock;
+  // mProfiledWrite must be taken _before_ we release the lock, the next
+  // writer overwrites it and the unlocking thread may not be the locking one
+  RWMutexHold prof_hold = mProfiledWrite;
+  mProfiledWrite.mSite = nullptr;
 
   if ((retc = mMutexImpl->UnLockWrite())) {
     fprintf(stderr, "%s Failed to write-unlock: %s\n", __FUNCTION__,
@@ -412,6 +445,10 @@ RWMutex::UnLockWrite()
     std::terminate();
   }
 
+  if (prof_hold.mSite) {
+    RWMutexProfiler::ReleasedWrite(prof_hold);
+  }
+
   if (blockedFor >= mBlockedForInterval) {
     std::ostringstream ss;
     ss << "WARNING - write lock held for " << blockedFor <<
@@ -441,9 +478,10 @@ RWMutex::UnLockWrite()
 // Lock for write but give up after wlocktime
 //------------------------------------------------------------------------------
 bool
-RWMutex::TimedWrLock(uint64_t timeout_ns)
+RWMutex::TimedWrLock(uint64_t timeout_ns, const char* file, int line)
 {
   EOS_RWMUTEX_CHECKORDER_LOCK;
+  EOS_RWMUTEX_PROFILER_START;
 #ifdef EOS_INSTRUMENTED_RWMUTEX
 
   if (sEnableGlobalDeadlockCheck) {
@@ -468,6 +506,7 @@ RWMutex::TimedWrLock(uint64_t timeout_ns)
     // mLastWriteLock should be updated _after_ we acquire the lock!
     mLastWriteLock = std::chrono::duration_cast<std::chrono::milliseconds>
                      (std::chrono::steady_clock::now().time_since_epoch()).count();
+    EOS_RWMUTEX_PROFILER_ACQUIRED(true);
   }
 
   return (retc == 0);
@@ -1277,24 +1316,25 @@ RWMutex::ResetCheckOrder()
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-RWMutexWriteLock::RWMutexWriteLock(RWMutex& mutex):
+RWMutexWriteLock::RWMutexWriteLock(RWMutex& mutex, const char* file,
+                                   int line):
   mWrMutex(&mutex)
 {
-  mWrMutex->LockWrite();
+  mWrMutex->LockWrite(file, line);
 }
 
 //----------------------------------------------------------------------------
 // Grab mutex and write lock it
 //----------------------------------------------------------------------------
 void
-RWMutexWriteLock::Grab(RWMutex& mutex)
+RWMutexWriteLock::Grab(RWMutex& mutex, const char* file, int line)
 {
   if (mWrMutex) {
     throw std::runtime_error("already holding a mutex");
   }
 
   mWrMutex = &mutex;
-  mWrMutex->LockWrite();
+  mWrMutex->LockWrite(file, line);
 }
 
 
@@ -1325,23 +1365,23 @@ RWMutexWriteLock::~RWMutexWriteLock()
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-RWMutexReadLock::RWMutexReadLock(RWMutex& mutex)
+RWMutexReadLock::RWMutexReadLock(RWMutex& mutex, const char* file, int line)
 {
-  Grab(mutex);
+  Grab(mutex, file, line);
 }
 
 //----------------------------------------------------------------------------
 // Grab mutex and write lock it
 //----------------------------------------------------------------------------
 void
-RWMutexReadLock::Grab(RWMutex& mutex)
+RWMutexReadLock::Grab(RWMutex& mutex, const char* file, int line)
 {
   if (mRdMutex) {
     throw std::runtime_error("already holding a mutex");
   }
 
   mRdMutex = &mutex;
-  mRdMutex->LockRead();
+  mRdMutex->LockRead(file, line);
 
   // acquiredAt must be updated _after_ we get the lock, since LockRead
   // may take a long time to complete
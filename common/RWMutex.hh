@@ -54,11 +54,13 @@
 
 #include "common/Namespace.hh"
 #include "common/IRWMutex.hh"
+#include "common/RWMutexProfiler.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include <stdio.h>
 #include <stdint.h>
 #include <atomic>
 #include <chrono>
+#include <string>
 #ifdef EOS_INSTRUMENTED_RWMUTEX
 #include <map>
 #include <vector>
@@ -162,10 +164,30 @@ public:
     return mBlockedStackTracing;
   }
 
+  //----------------------------------------------------------------------------
+  //! Set the debug name
+  //----------------------------------------------------------------------------
+  inline void SetDebugName(const std::string& name)
+  {
+    mDebugName = name;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the debug name
+  //----------------------------------------------------------------------------
+  inline const std::string& GetDebugName() const
+  {
+    return mDebugName;
+  }
+
   //----------------------------------------------------------------------------
   //! Lock for read
+  //!
+  //! @param file source file of the caller, used by the contention profiler
+  //! @param line source line of the caller, used by the contention profiler
   //----------------------------------------------------------------------------
-  void LockRead();
+  void LockRead(const char* file = EOS_RWMUTEX_CALLER_FILE,
+                int line = EOS_RWMUTEX_CALLER_LINE);
 
   //----------------------------------------------------------------------------
   //! Unlock a read lock
@@ -176,15 +198,23 @@ public:
   //! Try to read lock the mutex within the timeout
   //!
   //! @param timeout_ns nanoseconds timeout
+  //! @param file source file of the caller, used by the contention profiler
+  //! @param line source line of the caller, used by the contention profiler
   //!
   //! @return true if lock acquired successfully, otherwise false
   //----------------------------------------------------------------------------
-  bool TimedRdLock(uint64_t timeout_ns);
+  bool TimedRdLock(uint64_t timeout_ns,
+                   const char* file = EOS_RWMUTEX_CALLER_FILE,
+                   int line = EOS_RWMUTEX_CALLER_LINE);
 
   //----------------------------------------------------------------------------
   //! Lock for write
+  //!
+  //! @param file source file of the caller, used by the contention profiler
+  //! @param line source line of the caller, used by the contention profiler
   //----------------------------------------------------------------------------
-  void LockWrite();
+  void LockWrite(const char* file = EOS_RWMUTEX_CALLER_FILE,
+                 int line = EOS_RWMUTEX_CALLER_LINE);
 
   //----------------------------------------------------------------------------
   //! Unlock a write lock
@@ -195,10 +225,14 @@ public:
   //! Try to write lock the mutex within the timeout
   //!
   //! @param timeout_ns nanoseconds timeout
+  //! @param file source file of the caller, used by the contention profiler
+  //! @param line source line of the caller, used by the contention profiler
   //!
   //! @return true if lock acquired successfully, otherwise false
   //----------------------------------------------------------------------------
-  bool TimedWrLock(uint64_t timeout_ns);
+  bool TimedWrLock(uint64_t timeout_ns,
+                   const char* file = EOS_RWMUTEX_CALLER_FILE,
+                   int line = EOS_RWMUTEX_CALLER_LINE);
 
   //----------------------------------------------------------------------------
   //! Get Readlock Counter
@@ -412,14 +446,6 @@ public:
     return mEnableTiming;
   }
 
-  //----------------------------------------------------------------------------
-  //! Set the debug name
-  //----------------------------------------------------------------------------
-  inline void SetDebugName(const std::string& name)
-  {
-    mDebugName = name;
-  }
-
   //----------------------------------------------------------------------------
   //! Enable sampling of timings
   //! @param $first turns on or off the sampling
@@ -508,9 +534,10 @@ private:
   bool mPreferRd; ///< If true reads go ahead of wr and are reentrant
   int64_t mBlockedForInterval; // interval in ms after which we might stacktrace a long-lasted mutex
   bool mBlockedStackTracing; // en-disable stacktracing long-lasted mutexes
+  std::string mDebugName; ///< Name used in debug and profiler messages
+  RWMutexHold mProfiledWrite; ///< Sampled write lock, accessed by the writer
 
 #ifdef EOS_INSTRUMENTED_RWMUTEX
-  std::string mDebugName;
   int mCounter;
   int mSamplingModulo;
   std::atomic<bool> mEnableTiming, mEnableSampling;
@@ -591,15 +618,21 @@ public:
   //! Constructor
   //!
   //! @param mutex mutex to lock for write
+  //! @param file source file of the caller, used by the contention profiler
+  //! @param line source line of the caller, used by the contention profiler
   //----------------------------------------------------------------------------
-  RWMutexWriteLock(RWMutex& mutex);
+  RWMutexWriteLock(RWMutex& mutex, const char* file = EOS_RWMUTEX_CALLER_FILE,
+                   int line = EOS_RWMUTEX_CALLER_LINE);
 
   //----------------------------------------------------------------------------
   //! Grab mutex and write lock it
   //!
   //! @param mutex mutex to lock for write
+  //! @param file source file of the caller, used by the contention profiler
+  //! @param line source line of the caller, used by the contention profiler
   //----------------------------------------------------------------------------
-  void Grab(RWMutex& mutex);
+  void Grab(RWMutex& mutex, const char* file = EOS_RWMUTEX_CALLER_FILE,
+            int line = EOS_RWMUTEX_CALLER_LINE);
 
   //----------------------------------------------------------------------------
   //! Release the write lock after grab
@@ -630,15 +663,21 @@ public:
   //! Constructor
   //!
   //! @param mutex mutex to handle
+  //! @param file source file of the caller, used by the contention profiler
+  //! @param line source line of the caller, used by the contention profiler
   //----------------------------------------------------------------------------
-  RWMutexReadLock(RWMutex& mutex);
+  RWMutexReadLock(RWMutex& mutex, const char* file = EOS_RWMUTEX_CALLER_FILE,
+                  int line = EOS_RWMUTEX_CALLER_LINE);
 
   //----------------------------------------------------------------------------
   //! Grab mutex and read lock it
   //!
   //! @param mutex mutex to lock for read
+  //! @param file source file of the caller, used by the contention profiler
+  //! @param line source line of the caller, used by the contention profiler
   //----------------------------------------------------------------------------
-  void Grab(RWMutex& mutex);
+  void Grab(RWMutex& mutex, const char* file = EOS_RWMUTEX_CALLER_FILE,
+            int line = EOS_RWMUTEX_CALLER_LINE);
 
   //----------------------------------------------------------------------------
   //! Release the write lock after grab
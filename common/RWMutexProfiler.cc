@@ -0,0 +1,448 @@
+//------------------------------------------------------------------------------
+//! @file RWMutexProfiler.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/RWMutexProfiler.hh"
+#include "common/RWMutex.hh"
+#include "common/StacktraceHere.hh"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <ctime>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+std::atomic<bool> RWMutexProfiler::sEnabled {false};
+thread_local uint32_t RWMutexProfiler::tlNumSampledHeld = 0;
+
+namespace
+{
+//------------------------------------------------------------------------------
+//! Key identifying a call site. The mutex is not part of the key so that the
+//! call sites locking per-object mutexes don't grow without bounds.
+//------------------------------------------------------------------------------
+struct SiteKey {
+  const char* mFile;
+  int mLine;
+  bool mWrite;
+
+  bool operator==(const SiteKey& other) const
+  {
+    return ((mFile == other.mFile) && (mLine == other.mLine) &&
+            (mWrite == other.mWrite));
+  }
+};
+
+struct SiteKeyHash {
+  size_t operator()(const SiteKey& key) const
+  {
+    size_t h = std::hash<const void*>()(key.mFile);
+    h ^= std::hash<int>()(key.mLine * 2 + key.mWrite) + 0x9e3779b97f4a7c15ull +
+         (h << 6) + (h >> 2);
+    return h;
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Sampled read lock held by the calling thread
+//------------------------------------------------------------------------------
+struct HeldLock {
+  const RWMutex* mMutex;
+  RWMutexHold mHold;
+};
+
+using SiteMapT = std::unordered_map<SiteKey, RWMutexCallSite*, SiteKeyHash>;
+
+std::mutex gSitesMutex; ///< Protects gSites and gSitesOwner
+SiteMapT gSites; ///< All the call sites
+std::vector<std::unique_ptr<RWMutexCallSite>> gSitesOwner; ///< Never freed
+std::atomic<uint32_t> gSamplingModulo {100}; ///< Sample 1 in modulo
+std::mutex gTopMutex; ///< Protects gTop
+std::vector<RWMutexHolder> gTop; ///< Longest holders, the longest first
+std::atomic<size_t> gTopSize {10}; ///< Number of longest holders kept
+std::atomic<uint64_t> gTopThreshold {0}; ///< Hold time to enter gTop
+thread_local SiteMapT tlSites; ///< Call sites already used by the thread
+thread_local std::vector<HeldLock> tlHeld; ///< Sampled read locks held
+thread_local uint32_t tlSampleCounter = 0; ///< Lock operations counter
+
+//------------------------------------------------------------------------------
+// Get the call site, creating it on first use
+//------------------------------------------------------------------------------
+RWMutexCallSite*
+GetCallSite(const RWMutex* mutex, bool write, const char* file, int line)
+{
+  SiteKey key {file, line, write};
+  auto it = tlSites.find(key);
+
+  if (it != tlSites.end()) {
+    return it->second;
+  }
+
+  RWMutexCallSite* site = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(gSitesMutex);
+    auto it_global = gSites.find(key);
+
+    if (it_global != gSites.end()) {
+      site = it_global->second;
+    } else {
+      gSitesOwner.emplace_back(new RWMutexCallSite());
+      site = gSitesOwner.back().get();
+      site->mMutex = mutex->GetDebugName();
+
+      if (site->mMutex.empty()) {
+        char addr[32];
+        snprintf(addr, sizeof(addr), "%p", (const void*) mutex);
+        site->mMutex = addr;
+      }
+
+      site->mFile = file;
+      site->mLine = line;
+      site->mWrite = write;
+      gSites.emplace(key, site);
+    }
+  }
+  tlSites.emplace(key, site);
+  return site;
+}
+
+//------------------------------------------------------------------------------
+// Keep the holder if it is among the longest ones
+//------------------------------------------------------------------------------
+void
+RecordTopHolder(const RWMutexCallSite* site, uint64_t hold_ns)
+{
+  RWMutexHolder holder;
+  holder.mMutex = site->mMutex;
+  holder.mFile = site->mFile;
+  holder.mLine = site->mLine;
+  holder.mWrite = site->mWrite;
+  holder.mHoldNs = hold_ns;
+  holder.mTimestamp = time(NULL);
+  // Taken outside the lock, still within the scope of the holder
+  holder.mStacktrace = getStacktrace();
+  std::lock_guard<std::mutex> lock(gTopMutex);
+  size_t top_size = gTopSize.load();
+
+  if (top_size == 0) {
+    return;
+  }
+
+  auto pos = std::upper_bound(gTop.begin(), gTop.end(), hold_ns,
+  [](uint64_t value, const RWMutexHolder & elem) {
+    return (value > elem.mHoldNs);
+  });
+  gTop.insert(pos, std::move(holder));
+
+  if (gTop.size() > top_size) {
+    gTop.resize(top_size);
+  }
+
+  gTopThreshold = ((gTop.size() == top_size) ? gTop.back().mHoldNs : 0);
+}
+}
+
+//------------------------------------------------------------------------------
+//                      ***** Class LatencyHistogram *****
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+LatencyHistogram::LatencyHistogram()
+{
+  Reset();
+}
+
+//------------------------------------------------------------------------------
+// Record a value
+//------------------------------------------------------------------------------
+void
+LatencyHistogram::Record(uint64_t ns)
+{
+  mBuckets[GetBucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+  mCount.fetch_add(1, std::memory_order_relaxed);
+  mSum.fetch_add(ns, std::memory_order_relaxed);
+  uint64_t max = mMax.load(std::memory_order_relaxed);
+
+  while ((ns > max) && !mMax.compare_exchange_weak(max, ns,
+         std::memory_order_relaxed)) {}
+}
+
+//------------------------------------------------------------------------------
+// Get the value of a percentile
+//------------------------------------------------------------------------------
+uint64_t
+LatencyHistogram::GetPercentile(double fraction) const
+{
+  uint64_t count = GetCount();
+
+  if (count == 0) {
+    return 0;
+  }
+
+  uint64_t target = std::max<uint64_t>(1, (uint64_t) std::ceil(fraction *
+                                        count));
+  uint64_t cumulated = 0;
+
+  for (uint32_t i = 0; i < sNumBuckets; ++i) {
+    cumulated += mBuckets[i].load(std::memory_order_relaxed);
+
+    if (cumulated >= target) {
+      return std::min(GetBucketUpperBound(i), GetMax());
+    }
+  }
+
+  return GetMax();
+}
+
+//------------------------------------------------------------------------------
+// Reset the histogram
+//------------------------------------------------------------------------------
+void
+LatencyHistogram::Reset()
+{
+  for (auto& bucket : mBuckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+
+  mCount = 0;
+  mSum = 0;
+  mMax = 0;
+}
+
+//------------------------------------------------------------------------------
+// Get the bucket index of a value
+//------------------------------------------------------------------------------
+uint32_t
+LatencyHistogram::GetBucketIndex(uint64_t ns)
+{
+  if (ns >= (1ull << sMaxBits)) {
+    ns = (1ull << sMaxBits) - 1;
+  }
+
+  if (ns < sSubCount) {
+    return ns;
+  }
+
+  uint32_t msb = 63 - __builtin_clzll(ns);
+  uint32_t sub = (ns >> (msb - sSubBits)) & (sSubCount - 1);
+  return sSubCount + (msb - sSubBits) * sSubCount + sub;
+}
+
+//------------------------------------------------------------------------------
+// Get the highest value falling in a bucket
+//------------------------------------------------------------------------------
+uint64_t
+LatencyHistogram::GetBucketUpperBound(uint32_t index)
+{
+  if (index < sSubCount) {
+    return index;
+  }
+
+  uint32_t msb = (index - sSubCount) / sSubCount + sSubBits;
+  uint64_t sub = (index - sSubCount) % sSubCount;
+  uint64_t width = 1ull << (msb - sSubBits);
+  return (1ull << msb) + sub * width + width - 1;
+}
+
+//------------------------------------------------------------------------------
+//                      ***** Class RWMutexProfiler *****
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Enable or disable the profiler
+//------------------------------------------------------------------------------
+void
+RWMutexProfiler::SetEnabled(bool on)
+{
+  sEnabled = on;
+}
+
+//------------------------------------------------------------------------------
+// Set the sampling rate
+//------------------------------------------------------------------------------
+void
+RWMutexProfiler::SetSamplingRate(double rate)
+{
+  if (rate <= 0.0) {
+    return;
+  }
+
+  gSamplingModulo = (rate >= 1.0) ? 1 : (uint32_t) std::lround(1.0 / rate);
+}
+
+//------------------------------------------------------------------------------
+// Get the sampling rate
+//------------------------------------------------------------------------------
+double
+RWMutexProfiler::GetSamplingRate()
+{
+  return 1.0 / gSamplingModulo.load();
+}
+
+//------------------------------------------------------------------------------
+// Set the number of longest holders kept
+//------------------------------------------------------------------------------
+void
+RWMutexProfiler::SetTopSize(size_t size)
+{
+  std::lock_guard<std::mutex> lock(gTopMutex);
+  gTopSize = size;
+
+  if (gTop.size() > size) {
+    gTop.resize(size);
+  }
+
+  gTopThreshold = ((size && (gTop.size() == size)) ? gTop.back().mHoldNs : 0);
+}
+
+//------------------------------------------------------------------------------
+// Get the number of longest holders kept
+//------------------------------------------------------------------------------
+size_t
+RWMutexProfiler::GetTopSize()
+{
+  return gTopSize.load();
+}
+
+//------------------------------------------------------------------------------
+// Decide if the current lock operation is sampled
+//------------------------------------------------------------------------------
+bool
+RWMutexProfiler::ShouldSample()
+{
+  return ((++tlSampleCounter % gSamplingModulo.load(std::memory_order_relaxed))
+          == 0);
+}
+
+//------------------------------------------------------------------------------
+// Record a sampled lock acquisition
+//------------------------------------------------------------------------------
+RWMutexHold
+RWMutexProfiler::Acquired(const RWMutex* mutex, bool write, const char* file,
+                          int line, uint64_t start_ns)
+{
+  RWMutexHold hold;
+  hold.mSite = GetCallSite(mutex, write, file, line);
+  hold.mAcquiredNs = GetNowInNs();
+  hold.mSite->mWait.Record(hold.mAcquiredNs - start_ns);
+
+  if (!write) {
+    tlHeld.push_back(HeldLock {mutex, hold});
+    ++tlNumSampledHeld;
+  }
+
+  return hold;
+}
+
+//------------------------------------------------------------------------------
+// Record the release of a sampled read lock
+//------------------------------------------------------------------------------
+void
+RWMutexProfiler::DoReleasedRead(const RWMutex* mutex)
+{
+  // Locks are mostly released in the reverse order
+  for (auto it = tlHeld.rbegin(); it != tlHeld.rend(); ++it) {
+    if (it->mMutex == mutex) {
+      RWMutexHold hold = it->mHold;
+      tlHeld.erase(std::next(it).base());
+      --tlNumSampledHeld;
+      RecordHold(hold.mSite, GetNowInNs() - hold.mAcquiredNs);
+      return;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Record the release of a sampled write lock
+//------------------------------------------------------------------------------
+void
+RWMutexProfiler::ReleasedWrite(const RWMutexHold& hold)
+{
+  if (hold.mSite) {
+    RecordHold(hold.mSite, GetNowInNs() - hold.mAcquiredNs);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Record the hold time of a sampled lock
+//------------------------------------------------------------------------------
+void
+RWMutexProfiler::RecordHold(RWMutexCallSite* site, uint64_t hold_ns)
+{
+  site->mHold.Record(hold_ns);
+
+  if (hold_ns > gTopThreshold.load(std::memory_order_relaxed) &&
+      gTopSize.load(std::memory_order_relaxed)) {
+    RecordTopHolder(site, hold_ns);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the call sites seen so far
+//------------------------------------------------------------------------------
+std::vector<const RWMutexCallSite*>
+RWMutexProfiler::GetCallSites()
+{
+  std::vector<const RWMutexCallSite*> sites;
+  std::lock_guard<std::mutex> lock(gSitesMutex);
+  sites.reserve(gSitesOwner.size());
+
+  for (const auto& site : gSitesOwner) {
+    sites.push_back(site.get());
+  }
+
+  return sites;
+}
+
+//------------------------------------------------------------------------------
+// Get the longest holders
+//------------------------------------------------------------------------------
+std::vector<RWMutexHolder>
+RWMutexProfiler::GetTopHolders()
+{
+  std::lock_guard<std::mutex> lock(gTopMutex);
+  return gTop;
+}
+
+//------------------------------------------------------------------------------
+// Reset the histograms and the longest holders
+//------------------------------------------------------------------------------
+void
+RWMutexProfiler::Reset()
+{
+  {
+    std::lock_guard<std::mutex> lock(gSitesMutex);
+
+    for (auto& site : gSitesOwner) {
+      site->mWait.Reset();
+      site->mHold.Reset();
+    }
+  }
+  std::lock_guard<std::mutex> lock(gTopMutex);
+  gTop.clear();
+  gTopThreshold = 0;
+}
+
+EOSCOMMONNAMESPACE_END
@@ -0,0 +1,297 @@
+//------------------------------------------------------------------------------
+//! @file RWMutexProfiler.hh
+//! @brief Sampling contention profiler for RWMutex call sites
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSCOMMON_RWMUTEXPROFILER_HH__
+#define __EOSCOMMON_RWMUTEXPROFILER_HH__
+
+#include "common/Namespace.hh"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+//! Call site of the lock operations, filled in by the compiler at the caller
+#if defined(__GNUC__) || defined(__clang__)
+#define EOS_RWMUTEX_CALLER_FILE __builtin_FILE()
+#define EOS_RWMUTEX_CALLER_LINE __builtin_LINE()
+#else
+#define EOS_RWMUTEX_CALLER_FILE "unknown"
+#define EOS_RWMUTEX_CALLER_LINE 0
+#endif
+
+EOSCOMMONNAMESPACE_BEGIN
+
+class RWMutex;
+
+//------------------------------------------------------------------------------
+//! Class LatencyHistogram
+//!
+//! @description HDR style histogram of latencies in nanoseconds. Every power
+//! of two is split in 16 linear sub-buckets which bounds the relative error
+//! of the reported values to ~6% between 1 ns and ~73 minutes. Recording is
+//! lock-free and can be done concurrently with reading.
+//------------------------------------------------------------------------------
+class LatencyHistogram
+{
+public:
+  static constexpr uint32_t sSubBits = 4; ///< Sub-buckets per power of two
+  static constexpr uint32_t sSubCount = 1 << sSubBits;
+  static constexpr uint32_t sMaxBits = 42; ///< Values above 2^42 are clamped
+  static constexpr uint32_t sNumBuckets = sSubCount +
+                                          (sMaxBits - sSubBits) * sSubCount;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  LatencyHistogram();
+
+  //----------------------------------------------------------------------------
+  //! Record a value
+  //!
+  //! @param ns latency in nanoseconds
+  //----------------------------------------------------------------------------
+  void Record(uint64_t ns);
+
+  //----------------------------------------------------------------------------
+  //! Get the value below which the given fraction of the recorded values is
+  //!
+  //! @param fraction fraction between 0 and 1 e.g. 0.99 for the 99th
+  //!        percentile
+  //!
+  //! @return upper bound of the bucket holding the percentile, 0 if empty
+  //----------------------------------------------------------------------------
+  uint64_t GetPercentile(double fraction) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the number of recorded values
+  //----------------------------------------------------------------------------
+  inline uint64_t GetCount() const
+  {
+    return mCount.load(std::memory_order_relaxed);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the sum of the recorded values
+  //----------------------------------------------------------------------------
+  inline uint64_t GetSum() const
+  {
+    return mSum.load(std::memory_order_relaxed);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the highest recorded value
+  //----------------------------------------------------------------------------
+  inline uint64_t GetMax() const
+  {
+    return mMax.load(std::memory_order_relaxed);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Reset the histogram
+  //----------------------------------------------------------------------------
+  void Reset();
+
+  //----------------------------------------------------------------------------
+  //! Get the bucket index of a value
+  //----------------------------------------------------------------------------
+  static uint32_t GetBucketIndex(uint64_t ns);
+
+  //----------------------------------------------------------------------------
+  //! Get the highest value falling in a bucket
+  //----------------------------------------------------------------------------
+  static uint64_t GetBucketUpperBound(uint32_t index);
+
+private:
+  std::atomic<uint64_t> mBuckets[sNumBuckets]; ///< Counts per bucket
+  std::atomic<uint64_t> mCount; ///< Number of recorded values
+  std::atomic<uint64_t> mSum; ///< Sum of the recorded values
+  std::atomic<uint64_t> mMax; ///< Highest recorded value
+};
+
+//------------------------------------------------------------------------------
+//! Contention statistics of a call site locking a mutex
+//------------------------------------------------------------------------------
+struct RWMutexCallSite {
+  std::string mMutex; ///< Name or address of the first mutex locked here
+  const char* mFile; ///< Source file of the call site
+  int mLine; ///< Source line of the call site
+  bool mWrite; ///< Write or read lock
+  LatencyHistogram mWait; ///< Time spent waiting for the lock
+  LatencyHistogram mHold; ///< Time the lock was held
+};
+
+//------------------------------------------------------------------------------
+//! Sampled lock acquisition whose hold time is not recorded yet
+//------------------------------------------------------------------------------
+struct RWMutexHold {
+  RWMutexCallSite* mSite {nullptr}; ///< Call site, null if not sampled
+  uint64_t mAcquiredNs {0}; ///< Time when the lock was acquired
+};
+
+//------------------------------------------------------------------------------
+//! One of the longest lock holders seen by the profiler
+//------------------------------------------------------------------------------
+struct RWMutexHolder {
+  std::string mMutex; ///< Debug name or address of the mutex
+  std::string mFile; ///< Source file of the call site
+  int mLine; ///< Source line of the call site
+  bool mWrite; ///< Write or read lock
+  uint64_t mHoldNs; ///< Time the lock was held
+  time_t mTimestamp; ///< Time when the lock was released
+  std::string mStacktrace; ///< Stacktrace of the release
+};
+
+//------------------------------------------------------------------------------
+//! Class RWMutexProfiler
+//!
+//! @description Samples the lock operations of all the RWMutex instances and
+//! records per call site (file:line of the lock) the wait and hold time
+//! histograms. The longest holds are kept with the stacktrace taken when the
+//! lock is released. When disabled, which is the default, every lock costs
+//! one relaxed atomic load and every unlock one thread local or member read.
+//!
+//! Sampled read locks are tracked per thread since they have to be released
+//! by the thread which acquired them. Sampled write locks are kept by the
+//! mutex itself so that they can be released by any thread.
+//------------------------------------------------------------------------------
+class RWMutexProfiler
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Check if the profiler is enabled
+  //----------------------------------------------------------------------------
+  static inline bool IsEnabled()
+  {
+    return sEnabled.load(std::memory_order_relaxed);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Enable or disable the profiler
+  //----------------------------------------------------------------------------
+  static void SetEnabled(bool on);
+
+  //----------------------------------------------------------------------------
+  //! Set the fraction of lock operations which are sampled
+  //!
+  //! @param rate fraction between 0 (excluded) and 1
+  //----------------------------------------------------------------------------
+  static void SetSamplingRate(double rate);
+
+  //----------------------------------------------------------------------------
+  //! Get the fraction of lock operations which are sampled
+  //----------------------------------------------------------------------------
+  static double GetSamplingRate();
+
+  //----------------------------------------------------------------------------
+  //! Set the number of longest holders kept
+  //----------------------------------------------------------------------------
+  static void SetTopSize(size_t size);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of longest holders kept
+  //----------------------------------------------------------------------------
+  static size_t GetTopSize();
+
+  //----------------------------------------------------------------------------
+  //! Decide if the current lock operation of the calling thread is sampled
+  //----------------------------------------------------------------------------
+  static bool ShouldSample();
+
+  //----------------------------------------------------------------------------
+  //! Get the current time in nanoseconds of the clock used for sampling
+  //----------------------------------------------------------------------------
+  static inline uint64_t GetNowInNs()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>
+           (std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Record a sampled lock acquisition. The hold time of a read lock is
+  //! recorded by the matching call to ReleasedRead by the same thread, the
+  //! one of a write lock by ReleasedWrite with the returned hold.
+  //!
+  //! @param mutex locked mutex
+  //! @param write true for a write lock
+  //! @param file source file of the call site
+  //! @param line source line of the call site
+  //! @param start_ns time when the lock was requested
+  //!
+  //! @return sampled hold to be kept by the mutex for a write lock
+  //----------------------------------------------------------------------------
+  static RWMutexHold Acquired(const RWMutex* mutex, bool write,
+                              const char* file, int line, uint64_t start_ns);
+
+  //----------------------------------------------------------------------------
+  //! Record the release of a read lock if its acquisition was sampled
+  //!
+  //! @param mutex unlocked mutex
+  //----------------------------------------------------------------------------
+  static inline void ReleasedRead(const RWMutex* mutex)
+  {
+    if (tlNumSampledHeld) {
+      DoReleasedRead(mutex);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Record the release of a sampled write lock, from any thread
+  //!
+  //! @param hold sampled hold returned by Acquired
+  //----------------------------------------------------------------------------
+  static void ReleasedWrite(const RWMutexHold& hold);
+
+  //----------------------------------------------------------------------------
+  //! Get the call sites seen so far. The call sites are never freed.
+  //----------------------------------------------------------------------------
+  static std::vector<const RWMutexCallSite*> GetCallSites();
+
+  //----------------------------------------------------------------------------
+  //! Get the longest holders, the longest first
+  //----------------------------------------------------------------------------
+  static std::vector<RWMutexHolder> GetTopHolders();
+
+  //----------------------------------------------------------------------------
+  //! Reset the histograms and the longest holders
+  //----------------------------------------------------------------------------
+  static void Reset();
+
+private:
+  //----------------------------------------------------------------------------
+  //! Record the release of a sampled read lock
+  //----------------------------------------------------------------------------
+  static void DoReleasedRead(const RWMutex* mutex);
+
+  //----------------------------------------------------------------------------
+  //! Record the hold time of a sampled lock
+  //----------------------------------------------------------------------------
+  static void RecordHold(RWMutexCallSite* site, uint64_t hold_ns);
+
+  static std::atomic<bool> sEnabled; ///< Profiler enabled
+  static thread_local uint32_t tlNumSampledHeld; ///< Sampled read locks held
+};
+
+EOSCOMMONNAMESPACE_END
+
+#endif // __EOSCOMMON_RWMUTEXPROFILER_HH__
@@ -0,0 +1,144 @@
+//------------------------------------------------------------------------------
+// File: TimerWheel.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "common/Namespace.hh"
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+#include <time.h>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Hashed timer wheel with a resolution of one second
+//!
+//! Every item goes into the slot "deadline % slots". Advancing the wheel only
+//! visits the slots of the seconds elapsed since the previous call, so the
+//! cost of an expiry sweep is proportional to the number of items due plus
+//! the items parked for a later turn of the wheel, instead of the total
+//! number of items. Deadlines more than "slots" seconds ahead are simply
+//! checked once per turn. Items are never removed explicitly: the owner
+//! re-validates every item it gets back and re-inserts it if the deadline
+//! moved. Thread-safe.
+//------------------------------------------------------------------------------
+template <typename T>
+class TimerWheel
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param slots number of one second slots, at least 1
+  //! @param now current time, items due at or before it expire on the next
+  //!        call to Advance
+  //----------------------------------------------------------------------------
+  TimerWheel(size_t slots, time_t now):
+    mSlots(slots ? slots : 1), mCurrent(now), mSize(0)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Schedule an item
+  //!
+  //! @param deadline time at which the item expires
+  //! @param item item returned by Advance once the deadline passed
+  //----------------------------------------------------------------------------
+  void Insert(time_t deadline, const T& item)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // Overdue items go into the next slot to be visited
+    if (deadline <= mCurrent) {
+      deadline = mCurrent + 1;
+    }
+
+    mSlots[deadline % mSlots.size()].push_back(Entry{deadline, item});
+    ++mSize;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Advance the wheel and collect the items whose deadline passed
+  //!
+  //! @param now current time, calls with a time in the past are no-ops
+  //! @param expired items due are appended here
+  //!
+  //! @return number of items appended
+  //----------------------------------------------------------------------------
+  size_t Advance(time_t now, std::vector<T>& expired)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (now <= mCurrent) {
+      return 0;
+    }
+
+    size_t count = 0;
+    uint64_t nslots = ((uint64_t)(now - mCurrent) < mSlots.size()) ?
+                      (now - mCurrent) : mSlots.size();
+
+    for (uint64_t i = 1; i <= nslots; ++i) {
+      std::vector<Entry>& slot = mSlots[(mCurrent + i) % mSlots.size()];
+
+      for (size_t pos = 0; pos < slot.size();) {
+        if (slot[pos].mDeadline <= now) {
+          expired.push_back(std::move(slot[pos].mItem));
+
+          if (pos != slot.size() - 1) {
+            slot[pos] = std::move(slot.back());
+          }
+
+          slot.pop_back();
+          ++count;
+        } else {
+          ++pos;
+        }
+      }
+    }
+
+    mCurrent = now;
+    mSize -= count;
+    return count;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the number of scheduled items
+  //----------------------------------------------------------------------------
+  size_t Size() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mSize;
+  }
+
+private:
+  //! Scheduled item
+  struct Entry {
+    time_t mDeadline; ///< Expiry time
+    T mItem; ///< Item
+  };
+
+  mutable std::mutex mMutex; ///< Protects all the members
+  std::vector<std::vector<Entry>> mSlots; ///< One bucket per second
+  time_t mCurrent; ///< Time up to which the wheel was advanced
+  size_t mSize; ///< Number of scheduled items
+};
+
+EOSCOMMONNAMESPACE_END
@@ -39,6 +39,7 @@
 /*----------------------------------------------------------------------------*/
 #include "XrdOuc/XrdOucString.hh"
 /*----------------------------------------------------------------------------*/
+#include <functional>
 #include <string>
 #include <stdint.h>
 /*----------------------------------------------------------------------------*/
@@ -223,6 +224,34 @@ public:
     return false;
   }
 
+  // ---------------------------------------------------------------------------
+  //! Register a listener called whenever a job is added to the queue
+  //!
+  //! @return listener id, 0 if the queue has no shared object manager
+  // ---------------------------------------------------------------------------
+
+  uint64_t
+  AddInsertListener(std::function<void()> listener)
+  {
+    if (mSom) {
+      return mSom->AddQueueListener(mFullQueue, std::move(listener));
+    }
+
+    return 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  //! Remove a listener registered with AddInsertListener
+  // ---------------------------------------------------------------------------
+
+  void
+  RemoveInsertListener(uint64_t id)
+  {
+    if (mSom && id) {
+      mSom->RemoveQueueListener(mFullQueue, id);
+    }
+  }
+
   // ---------------------------------------------------------------------------
   //! Destructor
   // ---------------------------------------------------------------------------
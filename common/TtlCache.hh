@@ -0,0 +1,182 @@
+//------------------------------------------------------------------------------
+// File: TtlCache.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "common/Namespace.hh"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <time.h>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Key-value cache where every entry expires a fixed time after it was stored
+//!
+//! The entries are spread over independently locked shards so that concurrent
+//! lookups of different keys rarely meet on the same mutex. Values are copied
+//! in and out, the cache is meant for small values like ids or names. When a
+//! shard is full, expired entries are dropped first and then arbitrary ones.
+//------------------------------------------------------------------------------
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class TtlCache
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param lifetime seconds an entry stays valid after it was stored
+  //! @param max_size maximum number of entries
+  //! @param num_shards number of shards
+  //----------------------------------------------------------------------------
+  TtlCache(time_t lifetime, size_t max_size = 1024 * 1024,
+           size_t num_shards = 64):
+    mLifetime(lifetime), mNumShards(num_shards ? num_shards : 1),
+    mMaxShardSize(max_size / mNumShards ? max_size / mNumShards : 1),
+    mShards(new Shard[mNumShards])
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Look up an entry
+  //!
+  //! @param key key
+  //! @param value filled with the cached value if found
+  //! @param now current time, 0 to read the clock
+  //!
+  //! @return true if a valid entry was found, otherwise false
+  //----------------------------------------------------------------------------
+  bool Get(const Key& key, Value& value, time_t now = 0)
+  {
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    auto it = shard.mEntries.find(key);
+
+    if (it == shard.mEntries.end()) {
+      return false;
+    }
+
+    if (it->second.mExpires <= (now ? now : time(NULL))) {
+      shard.mEntries.erase(it);
+      return false;
+    }
+
+    value = it->second.mValue;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Store or replace an entry
+  //!
+  //! @param key key
+  //! @param value value
+  //! @param now current time, 0 to read the clock
+  //----------------------------------------------------------------------------
+  void Store(const Key& key, const Value& value, time_t now = 0)
+  {
+    if (!now) {
+      now = time(NULL);
+    }
+
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+
+    if ((shard.mEntries.size() >= mMaxShardSize) &&
+        (shard.mEntries.find(key) == shard.mEntries.end())) {
+      for (auto it = shard.mEntries.begin(); it != shard.mEntries.end();) {
+        if (it->second.mExpires <= now) {
+          it = shard.mEntries.erase(it);
+        } else {
+          ++it;
+        }
+      }
+
+      if (shard.mEntries.size() >= mMaxShardSize) {
+        shard.mEntries.erase(shard.mEntries.begin());
+      }
+    }
+
+    auto it = shard.mEntries.find(key);
+
+    if (it != shard.mEntries.end()) {
+      it->second.mValue = value;
+      it->second.mExpires = now + mLifetime;
+    } else {
+      shard.mEntries.emplace(key, Entry{value, now + mLifetime});
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop all entries
+  //----------------------------------------------------------------------------
+  void Clear()
+  {
+    for (size_t i = 0; i < mNumShards; ++i) {
+      std::lock_guard<std::mutex> lock(mShards[i].mMutex);
+      mShards[i].mEntries.clear();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the number of entries, including the expired ones not dropped yet
+  //----------------------------------------------------------------------------
+  size_t Size()
+  {
+    size_t size = 0;
+
+    for (size_t i = 0; i < mNumShards; ++i) {
+      std::lock_guard<std::mutex> lock(mShards[i].mMutex);
+      size += mShards[i].mEntries.size();
+    }
+
+    return size;
+  }
+
+private:
+  //! Cached value with its expiry time
+  struct Entry {
+    Value mValue; ///< Cached value
+    time_t mExpires; ///< Time at which the entry becomes invalid
+  };
+
+  //! Independently locked part of the cache
+  struct Shard {
+    std::mutex mMutex; ///< Protects the entries
+    std::unordered_map<Key, Entry, Hash> mEntries; ///< Entries of the shard
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the shard holding a key
+  //----------------------------------------------------------------------------
+  Shard& GetShard(const Key& key)
+  {
+    return mShards[mHasher(key) % mNumShards];
+  }
+
+  const time_t mLifetime; ///< Lifetime of an entry in seconds
+  const size_t mNumShards; ///< Number of shards
+  const size_t mMaxShardSize; ///< Maximum number of entries per shard
+  std::unique_ptr<Shard[]> mShards; ///< Shards
+  Hash mHasher; ///< Hash function used to pick the shard
+};
+
+EOSCOMMONNAMESPACE_END
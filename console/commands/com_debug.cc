@@ -53,7 +53,23 @@ com_debug(char* arg1)
       return (0);
     }
 
-    if (level.length()) {
+    if (level == "async") {
+      XrdOucString mode = nodequeue;
+      nodequeue = subtokenizer.GetToken();
+
+      if ((mode == "on") || (mode == "off")) {
+        XrdOucString in = "mgm.cmd=debug&mgm.debugasync=";
+        in += mode;
+
+        if (nodequeue.length()) {
+          in += "&mgm.nodename=";
+          in += nodequeue;
+        }
+
+        global_retc = output_result(client_command(in, true));
+        return (0);
+      }
+    } else if (level.length()) {
       XrdOucString in = "mgm.cmd=debug&mgm.debuglevel=";
       in += level;
 
@@ -82,6 +98,8 @@ com_debug(char* arg1)
 
   fprintf(stdout,
           "Usage: debug [node-queue] this|<level> [--filter <unitlist>]\n");
+  fprintf(stdout,
+          "       debug async on|off [node-queue]\n");
   fprintf(stdout,
           "'[eos] debug ...' allows to modify the verbosity of the EOS log files in MGM and FST services.\n\n");
   fprintf(stdout, "Options:\n");
@@ -94,6 +112,9 @@ com_debug(char* arg1)
   fprintf(stdout, "debug  <level> <node-queue> [--filter <unitlist>] :\n");
   fprintf(stdout,
           "                                                  set the <node-queue> into debug level <level>. <node-queue> are internal EOS names e.g. '/eos/<hostname>:<port>/fst'\n");
+  fprintf(stdout, "debug  async on|off [node-queue] :\n");
+  fprintf(stdout,
+          "                                                  switch asynchronous logging on or off in the MGM or in <node-queue>. Dropped messages are reported by 'ns stat' and in the FST statistics\n");
   fprintf(stdout,
           "     <unitlist> : a comma separated list of strings of software units which should be filtered out in the message log!\n");
   fprintf(stdout,
@@ -109,6 +130,8 @@ com_debug(char* arg1)
           "  debug err /eos/*/fst                 set all FSTs into debug mode 'info'\n\n");
   fprintf(stdout,
           "  debug crit /eos/*/mgm                set MGM into debug mode 'crit'\n\n");
+  fprintf(stdout,
+          "  debug async on *                     switch asynchronous logging on in the MGM & all FSTs\n\n");
   fprintf(stdout,
           "  debug debug --filter MgmOfsMessage   set MGM into debug mode 'debug' and filter only messages coming from unit 'MgmOfsMessage'.\n\n");
   global_retc = EINVAL;
@@ -138,6 +138,9 @@ void com_fs_help()
       << "    scanrate=<MB/s>" << std::endl
       << "      configure the maximum scan rate"
       << std::endl
+      << "    scanstreams=<n>" << std::endl
+      << "      number of files scanned concurrently per filesystem (1-8)"
+      << std::endl
       << "    graceperiod=<seconds>" << std::endl
       << "      grace period before a filesystem with an operation error gets"
       << std::endl
@@ -119,6 +119,31 @@ NsHelper::ParseCommand(const char* arg)
           mutex->set_sample_rate10(true);
         } else if (soption == "--smplrate100") {
           mutex->set_sample_rate100(true);
+        } else if (soption == "--toggleprofile") {
+          mutex->set_toggle_profile(true);
+        } else if (soption == "--profilerate") {
+          if (!(option = tokenizer.GetToken())) {
+            return false;
+          }
+
+          soption = option;
+          float rate = 0.0;
+
+          try {
+            rate = std::stof(soption);
+          } catch (...) {
+            return false;
+          }
+
+          if ((rate <= 0.0) || (rate > 1.0)) {
+            return false;
+          }
+
+          mutex->set_profile_rate(rate);
+        } else if (soption == "--profile") {
+          mutex->set_profile(true);
+        } else if (soption == "--resetprofile") {
+          mutex->set_reset_profile(true);
         } else {
           return false;
         }
@@ -420,6 +445,14 @@ void com_ns_help()
       << std::endl
       << "    --smplrate100    : set timing sample rate at 100% (severe slow-down)"
       << std::endl
+      << "    --toggleprofile  : toggle the per call site contention profiler"
+      << std::endl
+      << "    --profilerate <r>: fraction of lock operations sampled by the profiler"
+      << " in (0, 1] (default 0.01)" << std::endl
+      << "    --profile        : print the profiler report in JSON format"
+      << std::endl
+      << "    --resetprofile   : reset the profiler histograms and top holders"
+      << std::endl
       << std::endl
       << "  ns compact off|on <delay> [<interval>] [<type>]" << std::endl
       << "    enable online compaction after <delay> seconds" << std::endl
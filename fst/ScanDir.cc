@@ -30,17 +30,20 @@
 #include "fst/io/FileIoPluginCommon.hh"
 #include "fst/FmdDbMap.hh"
 #include "fst/checksum/ChecksumPlugins.hh"
+#include "fst/checksum/MultiBufferHash.hh"
 #include <cstdlib>
 #include <cstring>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#include <sys/resource.h>
 #ifndef __APPLE__
 #include <sys/syscall.h>
 #endif
 #include <syslog.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <future>
 
 //------------------------------------------------------------------------------
 // We're missing ioprio.h and gettid
@@ -100,6 +103,26 @@ enum {
 
 EOSFSTNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+//! State of a file check carried from the preparation to the final step
+//------------------------------------------------------------------------------
+struct ScanDir::FileCheck {
+  std::unique_ptr<FileIo> mIo; ///< File IO object
+  std::string mPath; ///< Local file path
+  std::string mLfn; ///< Logical file name
+  char mChecksumVal[SHA_DIGEST_LENGTH]; ///< Stored file checksum
+  struct stat mStatBefore; ///< Stat of the file before the scan
+  unsigned long mLayoutId = 0; ///< Layout id carrying the checksum type
+  bool mRescan = false; ///< Data has to be scanned
+  bool mWasHealthy = false; ///< Previous scan found no checksum error
+  bool mDidntChange = false; ///< File not modified since the previous scan
+  bool mScanOk = true; ///< Scan found no error
+  bool mFileCxError = false; ///< File checksum error
+  bool mBlockCxError = false; ///< Block checksum error
+  unsigned long long mScanSize = 0; ///< Bytes scanned
+  float mScanTime = 0; ///< Scan duration in ms
+};
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -107,12 +130,14 @@ ScanDir::ScanDir(const char* dirpath, eos::common::FileSystem::fsid_t fsid,
                  eos::fst::Load* fstload, bool bgthread, long int testinterval,
                  int ratebandwidth, bool setchecksum) :
   fstLoad(fstload), fsId(fsid), dirPath(dirpath), mTestInterval(testinterval),
-  mRateBandwidth(ratebandwidth), setChecksum(setchecksum), forcedScan(false)
+  mRateBandwidth(ratebandwidth), mScanStreams(1), mStopRequested(false),
+  setChecksum(setchecksum), forcedScan(false)
 {
   thread = 0;
   noNoChecksumFiles = noScanFiles = 0;
   noHWCorruptFiles = noCorruptFiles = noTotalFiles = SkippedFiles = 0;
   durationScan = 0;
+  cpuScan = 0;
   totalScanSize = bufferSize = 0;
   buffer = 0;
   bgThread = bgthread;
@@ -155,6 +180,8 @@ ScanDir::ScanDir(const char* dirpath, eos::common::FileSystem::fsid_t fsid,
 //------------------------------------------------------------------------------
 ScanDir::~ScanDir()
 {
+  mStopRequested = true;
+
   if ((bgThread && thread)) {
     XrdSysThread::Cancel(thread);
     XrdSysThread::Join(thread, NULL);
@@ -164,6 +191,10 @@ ScanDir::~ScanDir()
   if (buffer) {
     free(buffer);
   }
+
+  for (auto buf : mStreamBuffers) {
+    free(buf);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -179,6 +210,9 @@ ScanDir::SetConfig(const std::string& key, long long value)
     mTestInterval = value;
   } else if (key == "scanrate") {
     mRateBandwidth = (int) value;
+  } else if (key == "scanstreams") {
+    mScanStreams = (int) std::max(1ll, std::min((long long)
+                                  MultiBufferHash::sLanes, value));
   }
 }
 
@@ -223,19 +257,66 @@ ScanDir::ScanFiles()
 
   pthread_cleanup_push(scandir_cleanup_handle, handle);
   std::string filePath;
+  // Files to be scanned together in multi-stream mode
+  std::vector<std::unique_ptr<FileCheck>> batch;
+  auto scan_batch = [&]() {
+    if (!ScanFilesMultiStream(batch)) {
+      if (mStopRequested) {
+        // interrupted by the shutdown, the files keep their old timestamp
+        // and are picked up again by the next scan
+        batch.clear();
+        return;
+      }
+
+      // the streams could not be set up, scan the files one by one so that
+      // they are not left without a timestamp and rescanned forever
+      for (auto& fc : batch) {
+        fc->mScanOk = ScanFileLoadAware(fc->mIo, fc->mScanSize, fc->mScanTime,
+                                        fc->mChecksumVal, fc->mLayoutId,
+                                        fc->mLfn.c_str(), fc->mFileCxError,
+                                        fc->mBlockCxError);
+      }
+    }
+
+    for (auto& fc : batch) {
+      FinishCheck(*fc);
+    }
+
+    batch.clear();
+  };
 
   while ((filePath = io->ftsRead(handle)) != "") {
     if (!bgThread) {
       fprintf(stderr, "[ScanDir] processing file %s\n", filePath.c_str());
     }
 
-    CheckFile(filePath.c_str());
+    int streams = mScanStreams;
+
+    if (streams <= 1) {
+      CheckFile(filePath.c_str());
+    } else {
+      std::unique_ptr<FileCheck> fc = PrepareCheck(filePath.c_str());
+
+      if (fc && fc->mRescan) {
+        batch.push_back(std::move(fc));
+
+        if ((int) batch.size() >= streams) {
+          scan_batch();
+        }
+      } else if (fc) {
+        FinishCheck(*fc);
+      }
+    }
 
     if (bgThread) {
       XrdSysThread::CancelPoint();
     }
   }
 
+  if (!batch.empty()) {
+    scan_batch();
+  }
+
   if (io->ftsClose(handle)) {
     if (bgThread) {
       eos_err("fts_close failed");
@@ -252,28 +333,46 @@ ScanDir::ScanFiles()
 void
 ScanDir::CheckFile(const char* filepath)
 {
-  float scantime;
-  unsigned long layoutid = 0;
-  unsigned long long scansize;
-  std::string filePath, checksumType, checksumStamp, logicalFileName,
-      previousFileCxError;
-  char checksumVal[SHA_DIGEST_LENGTH];
+  std::unique_ptr<FileCheck> fc = PrepareCheck(filepath);
+
+  if (!fc) {
+    return;
+  }
+
+  if (fc->mRescan) {
+    fc->mScanOk = ScanFileLoadAware(fc->mIo, fc->mScanSize, fc->mScanTime,
+                                    fc->mChecksumVal, fc->mLayoutId,
+                                    fc->mLfn.c_str(), fc->mFileCxError,
+                                    fc->mBlockCxError);
+  }
+
+  FinishCheck(*fc);
+}
+
+//------------------------------------------------------------------------------
+// Open a file and decide if it has to be scanned
+//------------------------------------------------------------------------------
+std::unique_ptr<ScanDir::FileCheck>
+ScanDir::PrepareCheck(const char* filepath)
+{
+  std::unique_ptr<FileCheck> fc(new FileCheck());
+  std::string checksumType, checksumStamp, previousFileCxError;
   size_t checksumLen;
-  filePath = filepath;
-  std::unique_ptr<FileIo> io(FileIoPluginHelper::GetIoObject(filepath));
+  fc->mPath = filepath;
+  fc->mIo.reset(FileIoPluginHelper::GetIoObject(filepath));
+  const std::string& filePath = fc->mPath;
+  const std::unique_ptr<FileIo>& io = fc->mIo;
   noTotalFiles++;
-  // get last modification time
-  struct stat buf1;
-  struct stat buf2;
 
-  if ((io->fileOpen(0, 0)) || io->fileStat(&buf1)) {
+  // get last modification time
+  if ((io->fileOpen(0, 0)) || io->fileStat(&fc->mStatBefore)) {
     if (bgThread) {
       eos_err("cannot open/stat %s", filePath.c_str());
     } else {
       fprintf(stderr, "error: cannot open/stat %s\n", filePath.c_str());
     }
 
-    return;
+    return nullptr;
   }
 
 #ifndef _NOOFS
@@ -289,236 +388,246 @@ ScanDir::CheckFile(const char* filepath)
              filePath.c_str(), fsId, (long long) fid);
       eos_warning("skipping scan of w-open file: localpath=%s fsid=%d fid=%llx",
                   filePath.c_str(), fsId, (long long) fid);
-      return;
+      return nullptr;
     }
   }
 
 #endif
   io->attrGet("user.eos.checksumtype", checksumType);
-  memset(checksumVal, 0, sizeof(checksumVal));
+  memset(fc->mChecksumVal, 0, sizeof(fc->mChecksumVal));
   checksumLen = SHA_DIGEST_LENGTH;
 
-  if (io->attrGet("user.eos.checksum", checksumVal, checksumLen)) {
+  if (io->attrGet("user.eos.checksum", fc->mChecksumVal, checksumLen)) {
     checksumLen = 0;
   }
 
   io->attrGet("user.eos.timestamp", checksumStamp);
-  io->attrGet("user.eos.lfn", logicalFileName);
+  io->attrGet("user.eos.lfn", fc->mLfn);
   io->attrGet("user.eos.filecxerror", previousFileCxError);
-  bool rescan = RescanFile(checksumStamp);
+  fc->mRescan = RescanFile(checksumStamp);
   // a file which was checked as ok, but got a checksum error
-  bool was_healthy = (previousFileCxError == "0");
+  fc->mWasHealthy = (previousFileCxError == "0");
   // check if this file has been modified since the last time we scanned it
-  bool didnt_change = false;
   time_t scanTime = atoll(checksumStamp.c_str()) / 1000000;
 
-  if (buf1.st_mtime < scanTime) {
-    didnt_change = true;
+  if (fc->mStatBefore.st_mtime < scanTime) {
+    fc->mDidntChange = true;
   }
 
-  if (rescan || forcedScan) {
-    if (1) {
-      bool blockcxerror = false;
-      bool filecxerror = false;
-      bool skiptosettime = false;
-      XrdOucString envstring = "eos.layout.checksum=";
-      envstring += checksumType.c_str();
-      XrdOucEnv env(envstring.c_str());
-      unsigned long checksumtype = eos::common::LayoutId::GetChecksumFromEnv(env);
-      layoutid = eos::common::LayoutId::GetId(eos::common::LayoutId::kPlain,
-                                              checksumtype);
+  if (!fc->mRescan && !forcedScan) {
+    SkippedFiles++;
+    io->fileClose();
+    return nullptr;
+  }
 
-      if (rescan && (!ScanFileLoadAware(io, scansize, scantime, checksumVal, layoutid,
-                                        logicalFileName.c_str(), filecxerror, blockcxerror))) {
-        bool reopened = false;
+  XrdOucString envstring = "eos.layout.checksum=";
+  envstring += checksumType.c_str();
+  XrdOucEnv env(envstring.c_str());
+  unsigned long checksumtype = eos::common::LayoutId::GetChecksumFromEnv(env);
+  fc->mLayoutId = eos::common::LayoutId::GetId(eos::common::LayoutId::kPlain,
+                  checksumtype);
+  return fc;
+}
+
+//------------------------------------------------------------------------------
+// Handle the outcome of the scan of a file
+//------------------------------------------------------------------------------
+void
+ScanDir::FinishCheck(FileCheck& fc)
+{
+  const std::string& filePath = fc.mPath;
+  const std::string& logicalFileName = fc.mLfn;
+  const std::unique_ptr<FileIo>& io = fc.mIo;
+  const bool rescan = fc.mRescan;
+  bool& filecxerror = fc.mFileCxError;
+  bool& blockcxerror = fc.mBlockCxError;
+  bool skiptosettime = false;
+  struct stat buf2;
+
+  if (rescan && !fc.mScanOk) {
+    bool reopened = false;
 #ifndef _NOOFS
 
-        if (bgThread) {
-          eos::common::Path cPath(filePath.c_str());
-          eos::common::FileId::fileid_t fid = strtoul(cPath.GetName(), 0, 16);
-          // Check if somebody is again writing on that file and skip in that case
-
-          if (gOFS.openedForWriting.isOpen(fsId, fid)) {
-            eos_err("file %s has been reopened for update during the scan ... "
-                    "ignoring checksum error", filePath.c_str());
-            reopened = true;
-          }
-        }
+    if (bgThread) {
+      eos::common::Path cPath(filePath.c_str());
+      eos::common::FileId::fileid_t fid = strtoul(cPath.GetName(), 0, 16);
+      // Check if somebody is again writing on that file and skip in that case
+
+      if (gOFS.openedForWriting.isOpen(fsId, fid)) {
+        eos_err("file %s has been reopened for update during the scan ... "
+                "ignoring checksum error", filePath.c_str());
+        reopened = true;
+      }
+    }
 
 #endif
 
-        if ((!io->fileStat(&buf2)) && (buf1.st_mtime == buf2.st_mtime) &&
-            !reopened) {
-          if (filecxerror) {
-            if (bgThread) {
-              syslog(LOG_ERR, "corrupted file checksum: localpath=%s lfn=\"%s\" \n",
-                     filePath.c_str(), logicalFileName.c_str());
-              eos_err("corrupted file checksum: localpath=%s lfn=\"%s\"", filePath.c_str(),
-                      logicalFileName.c_str());
-
-              if (was_healthy && didnt_change) {
-                syslog(LOG_ERR, "HW corrupted file found: localpath=%s lfn=\"%s\" \n",
-                       filePath.c_str(), logicalFileName.c_str());
-                noHWCorruptFiles++;
-              }
-            } else {
-              fprintf(stderr, "[ScanDir] corrupted  file checksum: localpath=%slfn=\"%s\" \n",
-                      filePath.c_str(), logicalFileName.c_str());
-
-              if (was_healthy && didnt_change) {
-                fprintf(stderr, "HW corrupted file found: localpath=%s lfn=\"%s\" \n",
-                        filePath.c_str(), logicalFileName.c_str());
-                noHWCorruptFiles++;
-              }
-            }
+    if ((!io->fileStat(&buf2)) && (fc.mStatBefore.st_mtime == buf2.st_mtime) &&
+        !reopened) {
+      if (filecxerror) {
+        if (bgThread) {
+          syslog(LOG_ERR, "corrupted file checksum: localpath=%s lfn=\"%s\" \n",
+                 filePath.c_str(), logicalFileName.c_str());
+          eos_err("corrupted file checksum: localpath=%s lfn=\"%s\"", filePath.c_str(),
+                  logicalFileName.c_str());
+
+          if (fc.mWasHealthy && fc.mDidntChange) {
+            syslog(LOG_ERR, "HW corrupted file found: localpath=%s lfn=\"%s\" \n",
+                   filePath.c_str(), logicalFileName.c_str());
+            noHWCorruptFiles++;
           }
         } else {
-          // If the file was changed in the meanwhile or is reopened for update,
-          // the checksum might have changed in the meanwhile, we cannot know
-          // now and leave it up to a later moment.
-          blockcxerror = false;
-          filecxerror = false;
-          skiptosettime = true;
+          fprintf(stderr, "[ScanDir] corrupted  file checksum: localpath=%slfn=\"%s\" \n",
+                  filePath.c_str(), logicalFileName.c_str());
 
-          if (bgThread) {
-            eos_err("file %s has been modified during the scan ... ignoring checksum error",
-                    filePath.c_str());
-          } else {
-            fprintf(stderr,
-                    "[ScanDir] file %s has been modified during the scan ... "
-                    "ignoring checksum error\n", filePath.c_str());
+          if (fc.mWasHealthy && fc.mDidntChange) {
+            fprintf(stderr, "HW corrupted file found: localpath=%s lfn=\"%s\" \n",
+                    filePath.c_str(), logicalFileName.c_str());
+            noHWCorruptFiles++;
           }
         }
       }
+    } else {
+      // If the file was changed in the meanwhile or is reopened for update,
+      // the checksum might have changed in the meanwhile, we cannot know
+      // now and leave it up to a later moment.
+      blockcxerror = false;
+      filecxerror = false;
+      skiptosettime = true;
 
-      // Collect statistics
-      if (rescan) {
-        durationScan += scantime;
-        totalScanSize += scansize;
+      if (bgThread) {
+        eos_err("file %s has been modified during the scan ... ignoring checksum error",
+                filePath.c_str());
+      } else {
+        fprintf(stderr,
+                "[ScanDir] file %s has been modified during the scan ... "
+                "ignoring checksum error\n", filePath.c_str());
       }
+    }
+  }
 
-      bool failedtoset = false;
-
-      if (rescan) {
-        if (!skiptosettime) {
-          if (io->attrSet("user.eos.timestamp", GetTimestampSmeared())) {
-            failedtoset |= true;
-          }
-        }
+  // Collect statistics
+  if (rescan) {
+    durationScan += fc.mScanTime;
+    totalScanSize += fc.mScanSize;
+  }
 
-        if ((io->attrSet("user.eos.filecxerror", filecxerror ? "1" : "0")) ||
-            (io->attrSet("user.eos.blockcxerror", blockcxerror ? "1" : "0"))) {
-          failedtoset |= true;
-        }
+  bool failedtoset = false;
 
-        if (failedtoset) {
-          if (bgThread) {
-            eos_err("Can not set extended attributes to file %s", filePath.c_str());
-          } else {
-            fprintf(stderr, "error: [CheckFile] Can not set extended "
-                    "attributes to file. \n");
-          }
-        }
+  if (rescan) {
+    if (!skiptosettime) {
+      if (io->attrSet("user.eos.timestamp", GetTimestampSmeared())) {
+        failedtoset |= true;
       }
+    }
 
-#ifndef _NOOFS
+    if ((io->attrSet("user.eos.filecxerror", filecxerror ? "1" : "0")) ||
+        (io->attrSet("user.eos.blockcxerror", blockcxerror ? "1" : "0"))) {
+      failedtoset |= true;
+    }
 
+    if (failedtoset) {
       if (bgThread) {
-        if (filecxerror || blockcxerror || forcedScan) {
-          XrdOucString manager = "";
-          {
-            XrdSysMutexHelper lock(eos::fst::Config::gConfig.Mutex);
-            manager = eos::fst::Config::gConfig.Manager.c_str();
-          }
+        eos_err("Can not set extended attributes to file %s", filePath.c_str());
+      } else {
+        fprintf(stderr, "error: [CheckFile] Can not set extended "
+                "attributes to file. \n");
+      }
+    }
+  }
 
-          if (manager.length()) {
-            errno = 0;
-            eos::common::Path cPath(filePath.c_str());
-            eos::common::FileId::fileid_t fid = strtoul(cPath.GetName(), 0, 16);
-
-            if (fid && !errno) {
-              // check if we have this file in the local DB, if not, we
-              // resync first the disk and then the mgm meta data
-              FmdHelper* fmd = gFmdDbMapHandler.LocalGetFmd(fid, fsId, 0, 0, false,
-                               true);
-              bool orphaned = false;
-
-              if (fmd) {
-                // real orphanes get rechecked
-                if (fmd->mProtoFmd.layouterror() & eos::common::LayoutId::kOrphan) {
-                  orphaned = true;
-                }
+#ifndef _NOOFS
 
-                // unregistered replicas get rechecked
-                if (fmd->mProtoFmd.layouterror() & eos::common::LayoutId::kUnregistered) {
-                  orphaned = true;
-                }
-              }
+  if (bgThread) {
+    if (filecxerror || blockcxerror || forcedScan) {
+      XrdOucString manager = "";
+      {
+        XrdSysMutexHelper lock(eos::fst::Config::gConfig.Mutex);
+        manager = eos::fst::Config::gConfig.Manager.c_str();
+      }
 
-              if (fmd) {
-                delete fmd;
-                fmd = nullptr;
-              }
+      if (manager.length()) {
+        errno = 0;
+        eos::common::Path cPath(filePath.c_str());
+        eos::common::FileId::fileid_t fid = strtoul(cPath.GetName(), 0, 16);
+
+        if (fid && !errno) {
+          // check if we have this file in the local DB, if not, we
+          // resync first the disk and then the mgm meta data
+          FmdHelper* fmd = gFmdDbMapHandler.LocalGetFmd(fid, fsId, 0, 0, false,
+                           true);
+          bool orphaned = false;
+
+          if (fmd) {
+            // real orphanes get rechecked
+            if (fmd->mProtoFmd.layouterror() & eos::common::LayoutId::kOrphan) {
+              orphaned = true;
+            }
 
-              if (filecxerror || blockcxerror || !fmd || orphaned) {
-                eos_notice("msg=\"resyncing from disk\" fsid=%d fid=%lx", fsId, fid);
-                // ask the meta data handling class to update the error flags for this file
-                gFmdDbMapHandler.ResyncDisk(filePath.c_str(), fsId, false);
-                eos_notice("msg=\"resyncing from mgm\" fsid=%d fid=%lx", fsId, fid);
-                bool resynced = false;
-                resynced = gFmdDbMapHandler.ResyncMgm(fsId, fid, manager.c_str());
-                fmd = gFmdDbMapHandler.LocalGetFmd(fid, fsId, 0, 0, 0, false, true);
-
-                if (resynced && fmd) {
-                  if ((fmd->mProtoFmd.layouterror() ==  eos::common::LayoutId::kOrphan) ||
-                      ((!(fmd->mProtoFmd.layouterror() & eos::common::LayoutId::kReplicaWrong))
-                       && (fmd->mProtoFmd.layouterror() & eos::common::LayoutId::kUnregistered))) {
-                    char oname[4096];
-                    snprintf(oname, sizeof(oname), "%s/.eosorphans/%08llx",
-                             dirPath.c_str(), (unsigned long long) fid);
-                    // store the original path name as an extended attribute in case ...
-                    io->attrSet("user.eos.orphaned", filePath.c_str());
-
-                    // if this is an orphaned file - we move it into the orphaned directory
-                    if (!rename(filePath.c_str(), oname)) {
-                      eos_warning("msg=\"orphaned/unregistered quarantined\" "
-                                  "fst-path=%s orphan-path=%s", filePath.c_str(),
-                                  oname);
-                    } else {
-                      eos_err("msg=\"failed to quarantine orphaned/unregistered"
-                              "\" fst-path=%s orphan-path=%s", filePath.c_str(),
-                              oname);
-                    }
+            // unregistered replicas get rechecked
+            if (fmd->mProtoFmd.layouterror() & eos::common::LayoutId::kUnregistered) {
+              orphaned = true;
+            }
+          }
 
-                    // remove the entry from the FMD database
-                    gFmdDbMapHandler.LocalDeleteFmd(fid, fsId);
-                  }
+          if (fmd) {
+            delete fmd;
+            fmd = nullptr;
+          }
 
-                  delete fmd;
-                  fmd = nullptr;
+          if (filecxerror || blockcxerror || !fmd || orphaned) {
+            eos_notice("msg=\"resyncing from disk\" fsid=%d fid=%lx", fsId, fid);
+            // ask the meta data handling class to update the error flags for this file
+            gFmdDbMapHandler.ResyncDisk(filePath.c_str(), fsId, false);
+            eos_notice("msg=\"resyncing from mgm\" fsid=%d fid=%lx", fsId, fid);
+            bool resynced = false;
+            resynced = gFmdDbMapHandler.ResyncMgm(fsId, fid, manager.c_str());
+            fmd = gFmdDbMapHandler.LocalGetFmd(fid, fsId, 0, 0, 0, false, true);
+
+            if (resynced && fmd) {
+              if ((fmd->mProtoFmd.layouterror() ==  eos::common::LayoutId::kOrphan) ||
+                  ((!(fmd->mProtoFmd.layouterror() & eos::common::LayoutId::kReplicaWrong))
+                   && (fmd->mProtoFmd.layouterror() & eos::common::LayoutId::kUnregistered))) {
+                char oname[4096];
+                snprintf(oname, sizeof(oname), "%s/.eosorphans/%08llx",
+                         dirPath.c_str(), (unsigned long long) fid);
+                // store the original path name as an extended attribute in case ...
+                io->attrSet("user.eos.orphaned", filePath.c_str());
+
+                // if this is an orphaned file - we move it into the orphaned directory
+                if (!rename(filePath.c_str(), oname)) {
+                  eos_warning("msg=\"orphaned/unregistered quarantined\" "
+                              "fst-path=%s orphan-path=%s", filePath.c_str(),
+                              oname);
+                } else {
+                  eos_err("msg=\"failed to quarantine orphaned/unregistered"
+                          "\" fst-path=%s orphan-path=%s", filePath.c_str(),
+                          oname);
                 }
 
-                // Call the autorepair method on the MGM - but not for orphaned
-                // or unregistered filed. If MGM autorepair is disabled then it
-                // doesn't do anything.
-                if (fmd && !orphaned &&
-                    (!(fmd->mProtoFmd.layouterror() & eos::common::LayoutId::kUnregistered))) {
-                  gFmdDbMapHandler.CallAutoRepair(manager.c_str(), fid);
-                }
+                // remove the entry from the FMD database
+                gFmdDbMapHandler.LocalDeleteFmd(fid, fsId);
               }
+
+              delete fmd;
+              fmd = nullptr;
+            }
+
+            // Call the autorepair method on the MGM - but not for orphaned
+            // or unregistered filed. If MGM autorepair is disabled then it
+            // doesn't do anything.
+            if (fmd && !orphaned &&
+                (!(fmd->mProtoFmd.layouterror() & eos::common::LayoutId::kUnregistered))) {
+              gFmdDbMapHandler.CallAutoRepair(manager.c_str(), fid);
             }
           }
         }
       }
-
-#endif
-    } else {
-      noNoChecksumFiles++;
     }
-  } else {
-    SkippedFiles++;
   }
 
+#endif
+
   io->fileClose();
 }
 
@@ -717,31 +826,49 @@ ScanDir::ThreadProc(void)
     noNoChecksumFiles = 0;
     noTotalFiles = 0;
     SkippedFiles = 0;
+    struct rusage ru_start, ru_end;
+#ifdef RUSAGE_THREAD
+    int ru_who = RUSAGE_THREAD;
+#else
+    int ru_who = RUSAGE_SELF;
+#endif
+    getrusage(ru_who, &ru_start);
     gettimeofday(&tv_start, &tz);
     ScanFiles();
     gettimeofday(&tv_end, &tz);
+    getrusage(ru_who, &ru_end);
     durationScan = ((tv_end.tv_sec - tv_start.tv_sec) * 1000.0) + ((
                      tv_end.tv_usec - tv_start.tv_usec) / 1000.0);
+    cpuScan = ((ru_end.ru_utime.tv_sec + ru_end.ru_stime.tv_sec -
+                ru_start.ru_utime.tv_sec - ru_start.ru_stime.tv_sec) * 1000.0) +
+              ((ru_end.ru_utime.tv_usec + ru_end.ru_stime.tv_usec -
+                ru_start.ru_utime.tv_usec - ru_start.ru_stime.tv_usec) / 1000.0);
+    // Scan rate in MB/s and CPU time of the scan thread in ns per byte
+    double scanrate = (durationScan > 0) ?
+                      (totalScanSize / 1000.0 / durationScan) : 0;
+    double cpuperbyte = (totalScanSize > 0) ?
+                        (cpuScan * 1000000.0 / totalScanSize) : 0;
+    int streams = mScanStreams;
 
     if (bgThread) {
       syslog(LOG_ERR,
-             "Directory: %s, files=%li scanduration=%.02f [s] scansize=%lli [Bytes] [ %lli MB ] scannedfiles=%li  corruptedfiles=%li hwcorrupted=%li nochecksumfiles=%li skippedfiles=%li\n",
+             "Directory: %s, files=%li scanduration=%.02f [s] scansize=%lli [Bytes] [ %lli MB ] scannedfiles=%li  corruptedfiles=%li hwcorrupted=%li nochecksumfiles=%li skippedfiles=%li scanrate=%.02f [MB/s] cpuperbyte=%.02f [ns/Byte] streams=%d\n",
              dirPath.c_str(), noTotalFiles, (durationScan / 1000.0), totalScanSize,
              ((totalScanSize / 1000) / 1000), noScanFiles, noCorruptFiles, noHWCorruptFiles,
              noNoChecksumFiles,
-             SkippedFiles);
-      eos_notice("Directory: %s, files=%li scanduration=%.02f [s] scansize=%lli [Bytes] [ %lli MB ] scannedfiles=%li  corruptedfiles=%li hwcorrupted=%li nochecksumfiles=%li skippedfiles=%li",
+             SkippedFiles, scanrate, cpuperbyte, streams);
+      eos_notice("Directory: %s, files=%li scanduration=%.02f [s] scansize=%lli [Bytes] [ %lli MB ] scannedfiles=%li  corruptedfiles=%li hwcorrupted=%li nochecksumfiles=%li skippedfiles=%li scanrate=%.02f [MB/s] cpuperbyte=%.02f [ns/Byte] streams=%d",
                  dirPath.c_str(), noTotalFiles, (durationScan / 1000.0), totalScanSize,
                  ((totalScanSize / 1000) / 1000), noScanFiles, noCorruptFiles, noHWCorruptFiles,
                  noNoChecksumFiles,
-                 SkippedFiles);
+                 SkippedFiles, scanrate, cpuperbyte, streams);
     } else {
       fprintf(stderr,
-              "[ScanDir] Directory: %s, files=%li scanduration=%.02f [s] scansize=%lli [Bytes] [ %lli MB ] scannedfiles=%li  corruptedfiles=%li hwcorrupted=%li nochecksumfiles=%li skippedfiles=%li\n",
+              "[ScanDir] Directory: %s, files=%li scanduration=%.02f [s] scansize=%lli [Bytes] [ %lli MB ] scannedfiles=%li  corruptedfiles=%li hwcorrupted=%li nochecksumfiles=%li skippedfiles=%li scanrate=%.02f [MB/s] cpuperbyte=%.02f [ns/Byte] streams=%d\n",
               dirPath.c_str(), noTotalFiles, (durationScan / 1000.0), totalScanSize,
               ((totalScanSize / 1000) / 1000), noScanFiles, noCorruptFiles, noHWCorruptFiles,
               noNoChecksumFiles,
-              SkippedFiles);
+              SkippedFiles, scanrate, cpuperbyte, streams);
     }
 
     if (!bgThread) {
@@ -782,8 +909,7 @@ ScanDir::ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>& io,
                            const char* checksumVal, unsigned long layoutid,
                            const char* lfn, bool& filecxerror, bool& blockcxerror)
 {
-  double load;
-  bool retVal, corruptBlockXS = false;
+  bool corruptBlockXS = false;
   int currentRate = mRateBandwidth;
   std::string filePath, fileXSPath;
   struct timezone tz;
@@ -835,49 +961,306 @@ ScanDir::ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>& io,
           corruptBlockXS = true;
         }
 
-      //      fprintf(stderr,"adding %ld %llu\n", nread,offset);
       if (normalXS) {
         normalXS->Add(buffer, nread, offset);
       }
 
       offset += nread;
+      RegulateRate(opentime, offset, currentRate);
+    }
+  } while (nread == bufferSize);
+
+  gettimeofday(&currenttime, &tz);
+  scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
+                currenttime.tv_usec - opentime.tv_usec) / 1000.0));
+  scansize = (unsigned long long) offset;
+
+  if (normalXS) {
+    normalXS->Finalize();
+  }
+
+  bool retVal = CheckScanResult(io, normalXS.get(), corruptBlockXS, checksumVal,
+                                lfn, scansize, fileXSPath, filecxerror,
+                                blockcxerror);
+
+  if (blockXS) {
+    blockXS->CloseMap();
+  }
+
+  normalXS.reset();
+
+  if (bgThread) {
+    XrdSysThread::CancelPoint();
+  }
 
-      if (currentRate) {
-        // regulate the verification rate
-        gettimeofday(&currenttime, &tz);
-        scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
-                      currenttime.tv_usec - opentime.tv_usec) / 1000.0));
-        float expecttime = (1.0 * offset / currentRate) / 1000.0;
+  return retVal;
+}
 
-        if (expecttime > scantime) {
-          std::this_thread::sleep_for
-          (std::chrono::milliseconds((int)(expecttime - scantime)));
+//------------------------------------------------------------------------------
+// Scan a batch of files concurrently
+//------------------------------------------------------------------------------
+bool
+ScanDir::ScanFilesMultiStream(std::vector<std::unique_ptr<FileCheck>>& batch)
+{
+  //! Per file state of the scan
+  struct Stream {
+    FileCheck* mFc;
+    std::unique_ptr<eos::fst::CheckSum> mNormalXS;
+    std::unique_ptr<eos::fst::CheckSum> mBlockXS;
+    std::string mXSPath;
+    MultiBufferHash* mEngine = nullptr; ///< Engine if MD5/SHA1, else Add
+    int mFd = -1; ///< Local file descriptor, -1 to read through FileIo
+    char* mBuffers[2]; ///< Buffer being processed and buffer read ahead
+    int mSlot = 0; ///< Buffer holding the data to process
+    off_t mOffset = 0; ///< Offset of the data to process
+    std::future<ssize_t> mRead; ///< Pending read
+    bool mCorruptBlockXS = false;
+    bool mDone = false;
+    bool mError = false;
+  };
+
+  // Reads and hashing are done outside of cancellation points, the shutdown
+  // is noticed through mStopRequested at the end of every round
+  int cancel_state;
+  pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancel_state);
+  std::unique_ptr<MultiBufferHash> engines[2];
+  std::vector<Stream> streams(batch.size());
+  size_t size = bufferSize;
+
+  while (mStreamBuffers.size() < 2 * batch.size()) {
+    void* ptr = nullptr;
+
+    if (posix_memalign(&ptr, alignment, bufferSize)) {
+      eos_err("msg=\"failed to allocate scan buffer\" dirpath=%s", dirPath.c_str());
+      pthread_setcancelstate(cancel_state, nullptr);
+      return false;
+    }
+
+    mStreamBuffers.push_back((char*) ptr);
+  }
+
+  if (!mReadPool) {
+    mReadPool.reset(new eos::common::ThreadPool(MultiBufferHash::sLanes,
+                    MultiBufferHash::sLanes, 10, 12, 10, "ScanRead"));
+  }
+
+  eos::common::ThreadPool* pool = mReadPool.get();
+  auto issue_read = [size, pool](Stream & st) {
+    char* buf = st.mBuffers[st.mSlot];
+    off_t off = st.mOffset;
+
+    if (st.mFd >= 0) {
+      int fd = st.mFd;
+      st.mRead = pool->PushTask<ssize_t>([fd, buf, size, off]() {
+        ssize_t nread = pread(fd, buf, size, off);
+#ifdef O_DIRECT
+
+        // Some filesystems accept O_DIRECT at open but not at read time
+        if ((nread < 0) && (errno == EINVAL)) {
+          fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+          nread = pread(fd, buf, size, off);
         }
 
-        //adjust the rate according to the load information
-        load = fstLoad->GetDiskRate(dirPath.c_str(), "millisIO") / 1000.0;
+#endif
+        return nread;
+      });
+    } else {
+      FileIo* io = st.mFc->mIo.get();
+      st.mRead = pool->PushTask<ssize_t>([io, buf, size, off]() {
+        return (ssize_t) io->fileRead(off, buf, size);
+      });
+    }
+  };
+  struct timezone tz;
+  struct timeval starttime, currenttime;
+  gettimeofday(&starttime, &tz);
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    Stream& st = streams[i];
+    FileCheck* fc = batch[i].get();
+    struct stat current_stat;
+    st.mFc = fc;
+    st.mBuffers[0] = mStreamBuffers[2 * i];
+    st.mBuffers[1] = mStreamBuffers[2 * i + 1];
+    st.mXSPath = fc->mPath + ".xsmap";
+    fc->mScanSize = 0;
+    fc->mScanTime = 0;
+    fc->mScanOk = false;
+
+    if (fc->mIo->fileStat(&current_stat)) {
+      st.mDone = st.mError = true;
+      continue;
+    }
+
+    st.mNormalXS = eos::fst::ChecksumPlugins::GetChecksumObjectPtr(fc->mLayoutId);
+    st.mBlockXS = GetBlockXS(st.mXSPath.c_str(), current_stat.st_size);
 
-        if (load > 0.7) {
-          //adjust currentRate
-          if (currentRate > 5) {
-            currentRate = 0.9 * currentRate;
-          }
-        } else {
-          currentRate = mRateBandwidth;
+    if ((!st.mNormalXS) && (!st.mBlockXS)) {
+      // there is nothing to do here
+      st.mDone = st.mError = true;
+      continue;
+    }
+
+    if (st.mNormalXS) {
+      MultiBufferHash::Type type;
+      st.mNormalXS->Reset();
+
+      if (MultiBufferHash::GetType(eos::common::LayoutId::GetChecksum(
+                                     fc->mLayoutId), type)) {
+        auto& engine = engines[type == MultiBufferHash::Type::kMD5 ? 0 : 1];
+
+        if (!engine) {
+          engine.reset(new MultiBufferHash(type));
         }
+
+        st.mEngine = engine.get();
+        st.mEngine->Reset(i);
       }
     }
-  } while (nread == bufferSize);
+
+    if (fc->mPath[0] == '/') {
+#ifdef O_DIRECT
+      st.mFd = open(fc->mPath.c_str(), O_RDONLY | O_DIRECT);
+#endif
+
+      if (st.mFd < 0) {
+        st.mFd = open(fc->mPath.c_str(), O_RDONLY);
+      }
+    }
+
+    issue_read(st);
+  }
+
+  unsigned long long total = 0;
+  int currentRate = mRateBandwidth;
+  bool interrupted = false;
+
+  while (true) {
+    const char* buffers[2][MultiBufferHash::sLanes] = {{nullptr}};
+    size_t lengths[2][MultiBufferHash::sLanes] = {{0}};
+    bool active = false;
+
+    for (size_t i = 0; i < streams.size(); ++i) {
+      Stream& st = streams[i];
+
+      if (st.mDone) {
+        continue;
+      }
+
+      ssize_t nread = st.mRead.get();
+
+      if (nread < 0) {
+        st.mDone = st.mError = true;
+        continue;
+      }
+
+      char* data = st.mBuffers[st.mSlot];
+      off_t offset = st.mOffset;
+      st.mOffset += nread;
+      total += nread;
+
+      if (nread == (ssize_t) size) {
+        // Read ahead in the other buffer while this one is processed
+        st.mSlot ^= 1;
+        issue_read(st);
+        active = true;
+      } else {
+        st.mDone = true;
+      }
+
+      if (nread == 0) {
+        continue;
+      }
+
+      if (!st.mCorruptBlockXS && st.mBlockXS &&
+          !st.mBlockXS->CheckBlockSum(offset, data, nread)) {
+        st.mCorruptBlockXS = true;
+      }
+
+      if (st.mEngine) {
+        int idx = (st.mEngine == engines[0].get()) ? 0 : 1;
+        buffers[idx][i] = data;
+        lengths[idx][i] = nread;
+      } else if (st.mNormalXS) {
+        st.mNormalXS->Add(data, nread, offset);
+      }
+    }
+
+    for (int idx = 0; idx < 2; ++idx) {
+      if (engines[idx]) {
+        engines[idx]->Update(buffers[idx], lengths[idx]);
+      }
+    }
+
+    if (!active) {
+      break;
+    }
+
+    RegulateRate(starttime, total, currentRate);
+
+    if (mStopRequested) {
+      interrupted = true;
+      break;
+    }
+  }
 
   gettimeofday(&currenttime, &tz);
-  scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
-                currenttime.tv_usec - opentime.tv_usec) / 1000.0));
-  scansize = (unsigned long long) offset;
+  float scantime = (((currenttime.tv_sec - starttime.tv_sec) * 1000.0) + ((
+                      currenttime.tv_usec - starttime.tv_usec) / 1000.0));
 
-  if (normalXS) {
-    normalXS->Finalize();
+  for (size_t i = 0; i < streams.size(); ++i) {
+    Stream& st = streams[i];
+    FileCheck* fc = st.mFc;
+
+    if (st.mRead.valid()) {
+      st.mRead.wait();
+    }
+
+    if (!interrupted && !st.mError) {
+      fc->mScanSize = st.mOffset;
+      fc->mScanTime = scantime;
+
+      if (st.mEngine) {
+        unsigned char digest[MultiBufferHash::sMaxDigestLen];
+        st.mEngine->Final(i, digest);
+        st.mNormalXS->SetBinChecksum(digest, st.mEngine->GetDigestLen());
+      } else if (st.mNormalXS) {
+        st.mNormalXS->Finalize();
+      }
+
+      fc->mScanOk = CheckScanResult(fc->mIo, st.mNormalXS.get(),
+                                    st.mCorruptBlockXS, fc->mChecksumVal,
+                                    fc->mLfn.c_str(), fc->mScanSize,
+                                    st.mXSPath, fc->mFileCxError,
+                                    fc->mBlockCxError);
+    }
+
+    if (st.mBlockXS) {
+      st.mBlockXS->CloseMap();
+    }
+
+    if (st.mFd >= 0) {
+      close(st.mFd);
+    }
   }
 
+  pthread_setcancelstate(cancel_state, nullptr);
+  return !interrupted;
+}
+
+//------------------------------------------------------------------------------
+// Compare the computed checksums of a scanned file with the stored ones
+//------------------------------------------------------------------------------
+bool
+ScanDir::CheckScanResult(const std::unique_ptr<eos::fst::FileIo>& io,
+                         eos::fst::CheckSum* normalXS, bool corruptBlockXS,
+                         const char* checksumVal, const char* lfn,
+                         unsigned long long scansize,
+                         const std::string& fileXSPath,
+                         bool& filecxerror, bool& blockcxerror)
+{
+  bool retVal;
+
   //check file checksum only for replica layouts
   if ((normalXS) && (!normalXS->Compare(checksumVal))) {
     if (bgThread) {
@@ -896,8 +1279,8 @@ ScanDir::ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>& io,
             io->attrSet("user.eos.filecxerror", "0")) {
           fprintf(stderr, "error: failed to reset existing checksum \n");
         } else {
-          fprintf(stdout, "success: reset checksum of %s to %s\n", filePath.c_str(),
-                  normalXS->GetHexChecksum());
+          fprintf(stdout, "success: reset checksum of %s to %s\n",
+                  io->GetPath().c_str(), normalXS->GetHexChecksum());
         }
       }
     }
@@ -932,22 +1315,44 @@ ScanDir::ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>& io,
 
   //collect statistics
   noScanFiles++;
+  return retVal;
+}
 
-  if (normalXS) {
-    normalXS->Finalize();
+//------------------------------------------------------------------------------
+// Keep the scan below the configured rate
+//------------------------------------------------------------------------------
+void
+ScanDir::RegulateRate(const struct timeval& start, unsigned long long nbytes,
+                      int& currentRate)
+{
+  if (!currentRate) {
+    return;
   }
 
-  if (blockXS) {
-    blockXS->CloseMap();
+  // regulate the verification rate
+  struct timezone tz;
+  struct timeval currenttime;
+  gettimeofday(&currenttime, &tz);
+  float scantime = (((currenttime.tv_sec - start.tv_sec) * 1000.0) + ((
+                      currenttime.tv_usec - start.tv_usec) / 1000.0));
+  float expecttime = (1.0 * nbytes / currentRate) / 1000.0;
+
+  if (expecttime > scantime) {
+    std::this_thread::sleep_for
+    (std::chrono::milliseconds((int)(expecttime - scantime)));
   }
 
-  normalXS.reset();
+  //adjust the rate according to the load information
+  double load = fstLoad->GetDiskRate(dirPath.c_str(), "millisIO") / 1000.0;
 
-  if (bgThread) {
-    XrdSysThread::CancelPoint();
+  if (load > 0.7) {
+    //adjust currentRate
+    if (currentRate > 5) {
+      currentRate = 0.9 * currentRate;
+    }
+  } else {
+    currentRate = mRateBandwidth;
   }
-
-  return retVal;
 }
 
 EOSFSTNAMESPACE_END
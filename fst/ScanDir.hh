@@ -28,8 +28,12 @@
 #include "fst/Namespace.hh"
 #include "common/Logging.hh"
 #include "common/FileSystem.hh"
+#include "common/ThreadPool.hh"
 #include "XrdOuc/XrdOucString.hh"
-
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <sys/time.h>
 #include <sys/syscall.h>
 #ifndef __APPLE__
 #include <asm/unistd.h>
@@ -66,7 +70,7 @@ public:
   //----------------------------------------------------------------------------
   //! Update scanner configuration
   //!
-  //! @param key configuration type
+  //! @param key configuration type i.e. scaninterval, scanrate or scanstreams
   //! @param value configuration value
   //----------------------------------------------------------------------------
   void SetConfig(const std::string&, long long value);
@@ -92,11 +96,76 @@ public:
   bool RescanFile(std::string);
 
 private:
+  struct FileCheck;
+
+  //----------------------------------------------------------------------------
+  //! Scan a batch of files concurrently. The files are read in parallel with
+  //! read-ahead (O_DIRECT when supported) and their MD5/SHA1 checksums are
+  //! computed together by the multi-buffer hash engine.
+  //!
+  //! @param batch files to scan, at most MultiBufferHash::sLanes
+  //!
+  //! @return false if the scan was interrupted by the shutdown of the scanner
+  //----------------------------------------------------------------------------
+  bool ScanFilesMultiStream(std::vector<std::unique_ptr<FileCheck>>& batch);
+
+  //----------------------------------------------------------------------------
+  //! Open a file and decide if it has to be scanned
+  //!
+  //! @param filepath local file path
+  //!
+  //! @return file check state or null if there is nothing more to do
+  //----------------------------------------------------------------------------
+  std::unique_ptr<FileCheck> PrepareCheck(const char* filepath);
+
+  //----------------------------------------------------------------------------
+  //! Handle the outcome of the scan of a file i.e. update the extended
+  //! attributes and trigger the resynchronization of corrupted files
+  //!
+  //! @param fc file check state
+  //----------------------------------------------------------------------------
+  void FinishCheck(FileCheck& fc);
+
+  //----------------------------------------------------------------------------
+  //! Compare the computed checksums of a scanned file with the stored ones
+  //!
+  //! @param io file IO object
+  //! @param normalXS finalized file checksum, can be null
+  //! @param corruptBlockXS true if a block checksum mismatch was found
+  //! @param checksumVal stored file checksum
+  //! @param lfn logical file name
+  //! @param scansize number of bytes scanned
+  //! @param fileXSPath path of the block checksum map
+  //! @param filecxerror set to true on file checksum error
+  //! @param blockcxerror set to true on block checksum error
+  //!
+  //! @return true if no error was found
+  //----------------------------------------------------------------------------
+  bool CheckScanResult(const std::unique_ptr<eos::fst::FileIo>& io,
+                       eos::fst::CheckSum* normalXS, bool corruptBlockXS,
+                       const char* checksumVal, const char* lfn,
+                       unsigned long long scansize,
+                       const std::string& fileXSPath,
+                       bool& filecxerror, bool& blockcxerror);
+
+  //----------------------------------------------------------------------------
+  //! Sleep to keep the scan below the configured rate and adjust the rate to
+  //! the disk load
+  //!
+  //! @param start time when the scan started
+  //! @param nbytes bytes scanned since start
+  //! @param currentRate current rate in MB/s, updated
+  //----------------------------------------------------------------------------
+  void RegulateRate(const struct timeval& start, unsigned long long nbytes,
+                    int& currentRate);
+
   eos::fst::Load* fstLoad;
   eos::common::FileSystem::fsid_t fsId;
   XrdOucString dirPath;
   std::atomic<long long> mTestInterval; ///< Test interval in seconds
   std::atomic<int> mRateBandwidth; ///< Max scan rate in MB/s
+  std::atomic<int> mScanStreams; ///< Files scanned concurrently
+  std::atomic<bool> mStopRequested; ///< Set when the scanner is destroyed
 
   // Statistics
   long int noScanFiles;
@@ -108,11 +177,15 @@ private:
   long int noNoChecksumFiles;
   long int noTotalFiles;
   long int SkippedFiles;
+  double cpuScan; ///< CPU time of the scan thread in ms
 
   bool setChecksum;
 
   long alignment;
   char* buffer;
+  std::vector<char*> mStreamBuffers; ///< Two buffers per concurrent file
+  //! Readers of the concurrent scan, one read in flight per file at most
+  std::unique_ptr<eos::common::ThreadPool> mReadPool;
   pthread_t thread;
   bool bgThread;
   bool forcedScan;
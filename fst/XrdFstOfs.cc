@@ -1061,7 +1061,15 @@ XrdFstOfs::SetDebug(XrdOucEnv& env)
   XrdOucString debugnode = env.Get("mgm.nodename");
   XrdOucString debuglevel = env.Get("mgm.debuglevel");
   XrdOucString filterlist = env.Get("mgm.filter");
+  XrdOucString asyncmode = env.Get("mgm.debugasync");
   eos::common::Logging& g_logging = eos::common::Logging::GetInstance();
+
+  if (asyncmode.length()) {
+    g_logging.SetAsync(asyncmode == "on");
+    eos_notice("switching asynchronous logging <%s>", asyncmode.c_str());
+    return;
+  }
+
   int debugval = g_logging.GetPriorityByString(debuglevel.c_str());
 
   if (debugval < 0) {
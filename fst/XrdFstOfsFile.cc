@@ -38,6 +38,7 @@
 #include "authz/XrdCapability.hh"
 #include "XrdOss/XrdOssApi.hh"
 #include "fst/io/FileIoPluginCommon.hh"
+#include "XrdSfs/XrdSfsAio.hh"
 
 extern XrdOssSys* XrdOfsOss;
 
@@ -45,6 +46,51 @@ EOSFSTNAMESPACE_BEGIN
 
 const uint16_t XrdFstOfsFile::msDefaultTimeout = 300; // default timeout value
 
+//------------------------------------------------------------------------------
+//! Asynchronous request handed to the OSS on behalf of a client request. Its
+//! completion runs the OFS bookkeeping (checksum, counters) in submission
+//! order and then completes the request of the client.
+//------------------------------------------------------------------------------
+class XrdFstOfsFile::AioRequest : public XrdSfsAio
+{
+public:
+  AioRequest(XrdFstOfsFile* file, XrdSfsAio* parent):
+    mFile(file), mParent(parent), mTicket(file->mAioSequencer.Next())
+  {
+    sfsAio = parent->sfsAio;
+    TIdent = parent->TIdent;
+    gettimeofday(&mStart, nullptr);
+  }
+
+  virtual ~AioRequest() = default;
+
+  void doneRead() override
+  {
+    XrdFstOfsFile* file = mFile;
+    file->mAioSequencer.Complete(mTicket, [file, this]() {
+      file->AioReadDone(this);
+    });
+  }
+
+  void doneWrite() override
+  {
+    XrdFstOfsFile* file = mFile;
+    file->mAioSequencer.Complete(mTicket, [file, this]() {
+      file->AioWriteDone(this);
+    });
+  }
+
+  void Recycle() override
+  {
+    delete this;
+  }
+
+  XrdFstOfsFile* mFile; ///< File the request belongs to
+  XrdSfsAio* mParent; ///< Request of the client
+  uint64_t mTicket; ///< Completion order ticket
+  struct timeval mStart; ///< Submission time
+};
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -1005,6 +1051,8 @@ XrdFstOfsFile::close()
   bool minimumsizeerror = false;
   bool consistencyerror = false;
   bool atomicoverlap = false;
+  // Asynchronous requests still in flight use the layout and the checksum
+  mAioSequencer.WaitAll();
 
   // Any close on a file opened in TPC mode invalidates tpc keys
   if (mTpcKey.length()) {
@@ -1768,7 +1816,15 @@ XrdFstOfsFile::readofs(XrdSfsFileOffset fileOffset, char* buffer,
   rCalls++;
   int rc = XrdOfsFile::read(fileOffset, buffer, buffer_size);
   eos_debug("read %llu %llu %i rc=%d", this, fileOffset, buffer_size, rc);
+  return ReadOfsDone(fileOffset, rc);
+}
 
+//------------------------------------------------------------------------------
+// Bookkeeping of a read of the local file
+//------------------------------------------------------------------------------
+XrdSfsXferSize
+XrdFstOfsFile::ReadOfsDone(XrdSfsFileOffset fileOffset, XrdSfsXferSize rc)
+{
   if (gOFS.Simulate_IO_read_error) {
     return gOFS.Emsg("readofs", error, EIO, "read file - simulated IO error fn=",
                      mCapOpaque ? (mCapOpaque->Get("mgm.path") ?
@@ -1847,7 +1903,16 @@ XrdFstOfsFile::read(XrdSfsFileOffset fileOffset, char* buffer,
 
   int rc = layOut->Read(fileOffset, buffer, buffer_size);
   eos_debug("layout read %d checkSum %d", rc, mCheckSum.get());
+  return ReadDone(fileOffset, buffer, buffer_size, rc);
+}
 
+//------------------------------------------------------------------------------
+// Bookkeeping of a read of the file
+//------------------------------------------------------------------------------
+XrdSfsXferSize
+XrdFstOfsFile::ReadDone(XrdSfsFileOffset fileOffset, const char* buffer,
+                        XrdSfsXferSize buffer_size, XrdSfsXferSize rc)
+{
   if ((rc > 0) && (mCheckSum)) {
     XrdSysMutexHelper cLock(ChecksumMutex);
     mCheckSum->Add(buffer, static_cast<size_t>(rc),
@@ -1946,7 +2011,29 @@ XrdFstOfsFile::readv(XrdOucIOVec* readV, int readCount)
 int
 XrdFstOfsFile::read(XrdSfsAio* aioparm)
 {
-  return SFS_ERROR;
+  char* buffer = (char*) aioparm->sfsAio.aio_buf;
+  XrdSfsFileOffset offset = aioparm->sfsAio.aio_offset;
+  XrdSfsXferSize length = aioparm->sfsAio.aio_nbytes;
+
+  if (!IsAioCapable()) {
+    XrdSfsXferSize rc = read(offset, buffer, length);
+    aioparm->Result = ((rc < 0) ? -(error.getErrInfo() ? error.getErrInfo() :
+                                    EIO) : rc);
+    aioparm->doneRead();
+    return SFS_OK;
+  }
+
+  AioRequest* req = new AioRequest(this, aioparm);
+  // EOS files are neither compressed nor persist-on-successful-close so the
+  // OFS hands the request over to the OSS
+  int rc = XrdOfsFile::read(req);
+
+  if (rc != SFS_OK) {
+    mAioSequencer.Complete(req->mTicket, nullptr);
+    delete req;
+  }
+
+  return rc;
 }
 
 //------------------------------------------------------------------------------
@@ -1955,6 +2042,24 @@ XrdFstOfsFile::read(XrdSfsAio* aioparm)
 XrdSfsXferSize
 XrdFstOfsFile::writeofs(XrdSfsFileOffset fileOffset, const char* buffer,
                         XrdSfsXferSize buffer_size)
+{
+  if (CheckWriteOfs(fileOffset, buffer_size) != SFS_OK) {
+    return SFS_ERROR;
+  }
+
+  gettimeofday(&cTime, &tz);
+  wCalls++;
+  int rc = XrdOfsFile::write(fileOffset, buffer, buffer_size);
+  WriteOfsDone(fileOffset, buffer_size, rc);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+// Check if a write of the local file is allowed
+//------------------------------------------------------------------------------
+int
+XrdFstOfsFile::CheckWriteOfs(XrdSfsFileOffset fileOffset,
+                             XrdSfsXferSize buffer_size)
 {
   if (gOFS.Simulate_IO_write_error) {
     writeErrorFlag = kOfsSimulatedIoError;
@@ -1996,10 +2101,16 @@ XrdFstOfsFile::writeofs(XrdSfsFileOffset fileOffset, const char* buffer,
     }
   }
 
-  gettimeofday(&cTime, &tz);
-  wCalls++;
-  int rc = XrdOfsFile::write(fileOffset, buffer, buffer_size);
+  return SFS_OK;
+}
 
+//------------------------------------------------------------------------------
+// Bookkeeping of a write of the local file
+//------------------------------------------------------------------------------
+void
+XrdFstOfsFile::WriteOfsDone(XrdSfsFileOffset fileOffset,
+                            XrdSfsXferSize buffer_size, XrdSfsXferSize rc)
+{
   if (rc != buffer_size) {
     // Tag an io error
     writeErrorFlag = kOfsIoError;
@@ -2040,7 +2151,6 @@ XrdFstOfsFile::writeofs(XrdSfsFileOffset fileOffset, const char* buffer,
 
   gettimeofday(&lwTime, &tz);
   AddWriteTime();
-  return rc;
 }
 
 //------------------------------------------------------------------------------
@@ -2069,6 +2179,16 @@ XrdFstOfsFile::write(XrdSfsFileOffset fileOffset, const char* buffer,
     rc = buffer_size;
   }
 
+  return WriteDone(fileOffset, buffer, buffer_size, rc);
+}
+
+//------------------------------------------------------------------------------
+// Bookkeeping of a write of the file
+//------------------------------------------------------------------------------
+XrdSfsXferSize
+XrdFstOfsFile::WriteDone(XrdSfsFileOffset fileOffset, const char* buffer,
+                         XrdSfsXferSize buffer_size, XrdSfsXferSize rc)
+{
   // Evt. add checksum
   if (rc > 0) {
     if (mCheckSum) {
@@ -2163,7 +2283,108 @@ XrdFstOfsFile::write(XrdSfsFileOffset fileOffset, const char* buffer,
 int
 XrdFstOfsFile::write(XrdSfsAio* aioparm)
 {
-  return SFS_ERROR;
+  const char* buffer = (const char*) aioparm->sfsAio.aio_buf;
+  XrdSfsFileOffset offset = aioparm->sfsAio.aio_offset;
+  XrdSfsXferSize length = aioparm->sfsAio.aio_nbytes;
+  bool sync = !IsAioCapable();
+
+  if (!sync && (CheckWriteOfs(offset, length) != SFS_OK)) {
+    // Let the synchronous path report the error once the previous requests
+    // are accounted for
+    mAioSequencer.WaitAll();
+    sync = true;
+  }
+
+  if (sync) {
+    XrdSfsXferSize rc = write(offset, buffer, length);
+    aioparm->Result = ((rc < 0) ? -(error.getErrInfo() ? error.getErrInfo() :
+                                    EIO) : rc);
+    aioparm->doneWrite();
+    return SFS_OK;
+  }
+
+  AioRequest* req = new AioRequest(this, aioparm);
+  int rc = XrdOfsFile::write(req);
+
+  if (rc != SFS_OK) {
+    mAioSequencer.Complete(req->mTicket, nullptr);
+    delete req;
+  }
+
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+// Check if asynchronous requests can go straight to the local disk
+//------------------------------------------------------------------------------
+bool
+XrdFstOfsFile::IsAioCapable() const
+{
+  if (!layOut || mIsDevNull || (mTpcFlag == kTpcSrcRead) ||
+      (eos::common::LayoutId::GetIoType(mFstPath.c_str()) !=
+       eos::common::LayoutId::kLocal)) {
+    return false;
+  }
+
+  // Replica layouts fan out to the other replicas on the entry server
+  unsigned long ltype = eos::common::LayoutId::GetLayoutType(mLid);
+  return ((ltype == eos::common::LayoutId::kPlain) ||
+          ((ltype == eos::common::LayoutId::kReplica) &&
+           !layOut->IsEntryServer()));
+}
+
+//------------------------------------------------------------------------------
+// Complete an asynchronous read
+//------------------------------------------------------------------------------
+void
+XrdFstOfsFile::AioReadDone(AioRequest* req)
+{
+  XrdSfsAio* aioparm = req->mParent;
+  char* buffer = (char*) aioparm->sfsAio.aio_buf;
+  XrdSfsFileOffset offset = aioparm->sfsAio.aio_offset;
+  XrdSfsXferSize length = aioparm->sfsAio.aio_nbytes;
+  XrdSfsXferSize rc = req->Result;
+  // Same accounting as a synchronous read going through the local layout
+  cTime = req->mStart;
+  rCalls++;
+
+  if (rc < 0) {
+    rc = gOFS.Emsg("aioread", error, -rc, "read file fn=", FName());
+  }
+
+  rc = ReadOfsDone(offset, rc);
+  rc = ReadDone(offset, buffer, length, rc);
+  aioparm->Result = ((rc < 0) ? -(error.getErrInfo() ? error.getErrInfo() :
+                                  EIO) : rc);
+  delete req;
+  aioparm->doneRead();
+}
+
+//------------------------------------------------------------------------------
+// Complete an asynchronous write
+//------------------------------------------------------------------------------
+void
+XrdFstOfsFile::AioWriteDone(AioRequest* req)
+{
+  XrdSfsAio* aioparm = req->mParent;
+  const char* buffer = (const char*) aioparm->sfsAio.aio_buf;
+  XrdSfsFileOffset offset = aioparm->sfsAio.aio_offset;
+  XrdSfsXferSize length = aioparm->sfsAio.aio_nbytes;
+  XrdSfsXferSize rc = req->Result;
+  // Same accounting as a synchronous write going through the local layout
+  cTime = req->mStart;
+  wCalls++;
+
+  if (rc < 0) {
+    rc = gOFS.Emsg("aiowrite", error, -rc, "write file fn=", FName());
+  }
+
+  WriteOfsDone(offset, length, rc);
+  rc = WriteDone(offset, buffer, length, rc);
+  aioparm->Result = ((rc < 0) ? -(error.getErrInfo() ? error.getErrInfo() :
+                                  EIO) : rc);
+  delete req;
+  aioparm->doneWrite();
 }
 
 //------------------------------------------------------------------------------
@@ -30,6 +30,7 @@
 #include "fst/Namespace.hh"
 #include "fst/checksum/CheckSum.hh"
 #include "fst/storage/Storage.hh"
+#include "fst/utils/CompletionSequencer.hh"
 #include "common/FileId.hh"
 #include "XrdOfs/XrdOfs.hh"
 #include "XrdOfs/XrdOfsTPCInfo.hh"
@@ -174,7 +175,13 @@ public:
                          XrdSfsXferSize buffer_size);
 
   //--------------------------------------------------------------------------
+  //! Asynchronous read. Files served from the local disk are read through
+  //! the IO engine of the disk without blocking the calling thread, the
+  //! others are read synchronously.
   //!
+  //! @param aioparm asynchronous request, completed through doneRead
+  //!
+  //! @return SFS_OK if the request was accepted, otherwise SFS_ERROR
   //--------------------------------------------------------------------------
   int read(XrdSfsAio* aioparm);
 
@@ -218,7 +225,11 @@ public:
                           XrdSfsXferSize buffer_size);
 
   //--------------------------------------------------------------------------
+  //! Asynchronous write, same rules as for the asynchronous read
+  //!
+  //! @param aioparm asynchronous request, completed through doneWrite
   //!
+  //! @return SFS_OK if the request was accepted, otherwise SFS_ERROR
   //--------------------------------------------------------------------------
   int write(XrdSfsAio* aioparm);
 
@@ -421,6 +432,21 @@ protected:
   Layout* layOut; //! pointer to a layout object
 
 private:
+  class AioRequest;
+
+  //! Runs the bookkeeping of the asynchronous requests in submission order
+  CompletionSequencer mAioSequencer;
+
+  //----------------------------------------------------------------------------
+  //! Complete an asynchronous read once all the previous requests completed
+  //----------------------------------------------------------------------------
+  void AioReadDone(AioRequest* req);
+
+  //----------------------------------------------------------------------------
+  //! Complete an asynchronous write once all the previous requests completed
+  //----------------------------------------------------------------------------
+  void AioWriteDone(AioRequest* req);
+
   // File statistics for monitoring purposes
   //! Largest byte position written of a newly created file
   unsigned long long maxOffsetWritten;
@@ -514,6 +540,53 @@ private:
   //--------------------------------------------------------------------------
   void AddReadTime();
 
+  //--------------------------------------------------------------------------
+  //! Check if asynchronous requests can go straight to the local disk i.e.
+  //! the layout does not need to fan out to other stripes or servers
+  //--------------------------------------------------------------------------
+  bool IsAioCapable() const;
+
+  //--------------------------------------------------------------------------
+  //! Bookkeeping of a read of the local file - monitoring counters and
+  //! simulated errors, shared by readofs and the asynchronous reads
+  //!
+  //! @return result of the read
+  //--------------------------------------------------------------------------
+  XrdSfsXferSize ReadOfsDone(XrdSfsFileOffset fileOffset, XrdSfsXferSize rc);
+
+  //--------------------------------------------------------------------------
+  //! Bookkeeping of a read of the file - checksum and error reporting,
+  //! shared by read and the asynchronous reads
+  //!
+  //! @return result of the read
+  //--------------------------------------------------------------------------
+  XrdSfsXferSize ReadDone(XrdSfsFileOffset fileOffset, const char* buffer,
+                          XrdSfsXferSize buffer_size, XrdSfsXferSize rc);
+
+  //--------------------------------------------------------------------------
+  //! Check if a write of the local file is allowed - simulated errors, disk
+  //! space and maximum file size
+  //!
+  //! @return SFS_OK if allowed, otherwise SFS_ERROR with the error set
+  //--------------------------------------------------------------------------
+  int CheckWriteOfs(XrdSfsFileOffset fileOffset, XrdSfsXferSize buffer_size);
+
+  //--------------------------------------------------------------------------
+  //! Bookkeeping of a write of the local file - monitoring counters, shared
+  //! by writeofs and the asynchronous writes
+  //--------------------------------------------------------------------------
+  void WriteOfsDone(XrdSfsFileOffset fileOffset, XrdSfsXferSize buffer_size,
+                    XrdSfsXferSize rc);
+
+  //--------------------------------------------------------------------------
+  //! Bookkeeping of a write of the file - checksum and error reporting,
+  //! shared by write and the asynchronous writes
+  //!
+  //! @return result of the write
+  //--------------------------------------------------------------------------
+  XrdSfsXferSize WriteDone(XrdSfsFileOffset fileOffset, const char* buffer,
+                           XrdSfsXferSize buffer_size, XrdSfsXferSize rc);
+
   //--------------------------------------------------------------------------
   //! Compute total time to serve vector read requests
   //--------------------------------------------------------------------------
@@ -28,6 +28,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/resource.h>
+#include <sys/sysmacros.h>
 #include <algorithm>
 #include "XrdVersion.hh"
 #include "XrdOuc/XrdOucUtils.hh"
@@ -36,6 +37,7 @@
 #include "fst/XrdFstOss.hh"
 #include "fst/checksum/ChecksumPlugins.hh"
 #include "fst/XrdFstOssFile.hh"
+#include "fst/io/AsyncIoEngine.hh"
 
 extern XrdSysError OssEroute;
 
@@ -75,7 +77,9 @@ XrdFstOss::XrdFstOss() :
   mPrBytes(0),
   mPrActive(0),
   mPrDepth(0),
-  mPrQSize(0)
+  mPrQSize(0),
+  mAioDepth(32),
+  mAioUring(true)
 {
   eos_debug("Calling the constructor of XrdFstOss.");
   mPrPBits = (long long)sysconf(_SC_PAGESIZE);
@@ -162,12 +166,18 @@ XrdFstOss::Configure(const char* configfn, XrdSysError& Eroute)
     if (!strncmp(var, "oss.", 4)) {
       if (!strncmp(var + 4, "preread", 7)) {
         NoGo = xprerd(Config, Eroute);
+      } else if (!strcmp(var + 4, "aio")) {
+        if (xaio(Config, Eroute)) {
+          NoGo = 1;
+        }
       }
     }
   }
 
   eos_info("preread depth=%i, queue_size=%i and bytes=%i",
            mPrDepth, mPrQSize, mPrBytes);
+  eos_info("aio depth=%i backend=%s", mAioDepth,
+           mAioUring ? "io_uring" : "threads");
   Config.Close();
   (void) close(cfgFD);
   return NoGo;
@@ -245,6 +255,69 @@ XrdFstOss::xprerd(XrdOucStream& Config, XrdSysError& Eroute)
 }
 
 
+//------------------------------------------------------------------------------
+// Function xaio to parse the aio directive
+//------------------------------------------------------------------------------
+int
+XrdFstOss::xaio(XrdOucStream& Config, XrdSysError& Eroute)
+{
+  char* val;
+  int depth;
+
+  if (!(val = Config.GetWord())) {
+    Eroute.Emsg("Config", "aio depth not specified");
+    return 1;
+  }
+
+  if (!strcmp(val, "off")) {
+    depth = 0;
+  } else if (XrdOuca2x::a2i(Eroute, "aio depth", val, &depth, 1, 4096)) {
+    return 1;
+  }
+
+  bool use_uring = true;
+
+  while ((val = Config.GetWord())) {
+    if (!strcmp(val, "threads")) {
+      use_uring = false;
+    } else {
+      Eroute.Emsg("Config", "invalid aio option -", val);
+      return 1;
+    }
+  }
+
+  mAioDepth = depth;
+  mAioUring = use_uring;
+  return 0;
+}
+
+
+//------------------------------------------------------------------------------
+// Get the asynchronous IO engine of a disk
+//------------------------------------------------------------------------------
+AsyncIoEngine*
+XrdFstOss::GetAioEngine(dev_t device)
+{
+  if (mAioDepth <= 0) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(mAioMutex);
+  auto it = mAioEngines.find(device);
+
+  if (it == mAioEngines.end()) {
+    char name[32];
+    snprintf(name, sizeof(name), "%u:%u", major(device), minor(device));
+    it = mAioEngines.emplace(device, std::unique_ptr<AsyncIoEngine>
+                             (new AsyncIoEngine(name, mAioDepth, mAioUring))).first;
+    eos_info("msg=\"started async IO engine\" %s",
+             it->second->GetInfo().c_str());
+  }
+
+  return it->second.get();
+}
+
+
 //------------------------------------------------------------------------------
 // New file
 //------------------------------------------------------------------------------
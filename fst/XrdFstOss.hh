@@ -26,7 +26,10 @@
 #define __EOSFST_FSTOSS_HH__
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <sys/types.h>
 #include "fst/Namespace.hh"
 #include "common/Logging.hh"
 #include "common/Namespace.hh"
@@ -39,6 +42,7 @@ EOSFSTNAMESPACE_BEGIN
 //! Forward declaration
 class XrdFstOssFile;
 class CheckSum;
+class AsyncIoEngine;
 
 //------------------------------------------------------------------------------
 //! Class XrdFstOss
@@ -274,6 +278,16 @@ public:
   void DropXs(const std::string& fileName, bool force = false);
 
 
+  //--------------------------------------------------------------------------
+  //! Get the asynchronous IO engine of a disk, created on first use
+  //!
+  //! @param device device number of the disk holding the file
+  //!
+  //! @return engine or nullptr if asynchronous IO is disabled
+  //--------------------------------------------------------------------------
+  AsyncIoEngine* GetAioEngine(dev_t device);
+
+
 private:
 
   XrdSysRWLock mRWMap; ///< rw lock for the file <-> xs map
@@ -289,6 +303,13 @@ private:
   short mPrDepth; ///< preread depth
   short mPrQSize; ///< preread maximum allowed
 
+  // Parameters for asynchronous IO
+  int mAioDepth; ///< requests in flight per disk, 0 disables async IO
+  bool mAioUring; ///< use io_uring if available, threads otherwise
+  std::mutex mAioMutex; ///< protects the engine map
+  //! map between device numbers and asynchronous IO engines
+  std::map<dev_t, std::unique_ptr<AsyncIoEngine>> mAioEngines;
+
   //--------------------------------------------------------------------------
   //! Delete link
   //!
@@ -327,6 +348,30 @@ private:
   //--------------------------------------------------------------------------
   int xprerd(XrdOucStream& Config, XrdSysError& Eroute);
 
+
+  //--------------------------------------------------------------------------
+  //! Function xaio to parse the directive
+  //!
+  //! aio {<depth> | off} [threads]
+  //!
+  //!         <depth>  the maximum number of asynchronous requests handed to
+  //!                  the kernel per disk, the others wait in a queue. The
+  //!                  default is 32, "off" serves asynchronous requests
+  //!                  synchronously.
+  //!         threads  use a pool of <depth> threads per disk instead of
+  //!                  io_uring
+  //!
+  //! The engine only sees requests which XRootD hands out asynchronously, so
+  //! "xrootd.async" must not be "off" in the FST configuration.
+  //!
+  //! @param Config configuration file stream object
+  //! @param Eroute error object
+  //!
+  //! @return 0 upon success or !0 upon failure.
+  //!
+  //--------------------------------------------------------------------------
+  int xaio(XrdOucStream& Config, XrdSysError& Eroute);
+
 };
 
 EOSFSTNAMESPACE_END
@@ -23,9 +23,12 @@
 
 #include <fcntl.h>
 #include <algorithm>
+#include <memory>
 #include "fst/XrdFstOss.hh"
 #include "fst/XrdFstOssFile.hh"
 #include "fst/checksum/ChecksumPlugins.hh"
+#include "fst/io/AsyncIoEngine.hh"
+#include "XrdSfs/XrdSfsAio.hh"
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -45,7 +48,9 @@ XrdFstOssFile::XrdFstOssFile(const char* tid) :
   eos::common::LogId(),
   mIsRW(false),
   mRWLockXs(0),
-  mBlockXs(0)
+  mBlockXs(0),
+  mAioEngine(nullptr),
+  mAioInFlight(0)
 {
   mPieceStart = new char[eos::common::LayoutId::OssXsBlockSize];
   mPieceEnd = new char[eos::common::LayoutId::OssXsBlockSize];
@@ -57,6 +62,8 @@ XrdFstOssFile::XrdFstOssFile(const char* tid) :
 //------------------------------------------------------------------------------
 XrdFstOssFile::~XrdFstOssFile()
 {
+  WaitAio();
+
   if (fd >= 0) {
     close(fd);
   }
@@ -165,6 +172,12 @@ XrdFstOssFile::Open(const char* path, int flags, mode_t mode, XrdOucEnv& env)
     }
 
     (void) fcntl(fd, F_SETFD, FD_CLOEXEC);
+    // Asynchronous requests are queued per disk
+    struct stat info;
+
+    if (!fstat(fd, &info)) {
+      mAioEngine = XrdFstSS->GetAioEngine(info.st_dev);
+    }
   }
 
   eos_info("fd=%d flags=%x", fd, flags);
@@ -178,12 +191,7 @@ XrdFstOssFile::Open(const char* path, int flags, mode_t mode, XrdOucEnv& env)
 ssize_t
 XrdFstOssFile::Read(void* buffer, off_t offset, size_t length)
 {
-  ssize_t retval = 0;
   ssize_t nread;
-  off_t off_copy;
-  size_t len_copy;
-  char* ptr_piece;
-  char* ptr_buff;
   std::vector<XrdOucIOVec> pieces;
   eos_debug("off=%ji len=%ji", offset, length);
 
@@ -202,11 +210,46 @@ XrdFstOssFile::Read(void* buffer, off_t offset, size_t length)
   }
 
   // Loop through all the pieces and read them in
+  std::vector<ssize_t> results;
+  results.reserve(pieces.size());
+
   for (auto piece = pieces.begin(); piece != pieces.end(); ++piece) {
     do {
       nread = pread(fd, piece->data, piece->size, piece->offset);
     } while ((nread < 0) && (errno == EINTR));
 
+    if (nread < 0) {
+      eos_err("error=failed read offset=%zu, length=%zu", piece->offset,
+              piece->size);
+      return -EIO;
+    }
+
+    results.push_back(nread);
+  }
+
+  return CheckPieces(pieces, results, buffer, offset, length);
+}
+
+
+//------------------------------------------------------------------------------
+// Verify the block checksum of pieces read in and copy back the edges
+//------------------------------------------------------------------------------
+ssize_t
+XrdFstOssFile::CheckPieces(const std::vector<XrdOucIOVec>& pieces,
+                           const std::vector<ssize_t>& results,
+                           void* buffer, off_t offset, size_t length)
+{
+  ssize_t retval = 0;
+  ssize_t nread;
+  off_t off_copy;
+  size_t len_copy;
+  char* ptr_piece;
+  char* ptr_buff;
+
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    const XrdOucIOVec* piece = &pieces[i];
+    nread = results[i];
+
     if (mBlockXs) {
       XrdSysRWLockHelper wr_lock(mRWLockXs, 0);
 
@@ -242,7 +285,8 @@ XrdFstOssFile::Read(void* buffer, off_t offset, size_t length)
         retval += nread;
       }
     } else {
-      eos_err("error=failed read offset=%zu, length=%zu", piece->offset, piece->size);
+      eos_err("error=failed read offset=%zu, length=%zu", piece->offset,
+              piece->size);
       return -EIO;
     }
   }
@@ -252,7 +296,76 @@ XrdFstOssFile::Read(void* buffer, off_t offset, size_t length)
     return -EIO;
   }
 
-  return (retval >= 0 ? retval : static_cast<ssize_t>(-errno));
+  return retval;
+}
+
+
+//------------------------------------------------------------------------------
+// Asynchronous read
+//------------------------------------------------------------------------------
+int
+XrdFstOssFile::Read(XrdSfsAio* aiop)
+{
+  //! State of an asynchronous read split in aligned pieces
+  struct AioRead {
+    std::vector<XrdOucIOVec> mPieces;
+    std::vector<ssize_t> mResults;
+    std::atomic<size_t> mRemaining {0};
+    std::unique_ptr<char[]> mEdges;
+  };
+
+  void* buffer = (void*) aiop->sfsAio.aio_buf;
+  off_t offset = aiop->sfsAio.aio_offset;
+  size_t length = aiop->sfsAio.aio_nbytes;
+
+  if (!mAioEngine || (fd < 0)) {
+    aiop->Result = Read(buffer, offset, length);
+    aiop->doneRead();
+    return XrdOssOK;
+  }
+
+  auto req = std::make_shared<AioRead>();
+
+  if (!mBlockXs) {
+    XrdOucIOVec piece = {(long long)offset, (int)length, 0, (char*)buffer};
+    req->mPieces.push_back(piece);
+  } else {
+    // The edge buffers of the file are reserved for the synchronous reads
+    const uint64_t blk_size = eos::common::LayoutId::OssXsBlockSize;
+    req->mEdges.reset(new char[2 * blk_size]);
+    req->mPieces = AlignBuffer(buffer, offset, length, req->mEdges.get(),
+                               req->mEdges.get() + blk_size);
+  }
+
+  req->mResults.resize(req->mPieces.size());
+  req->mRemaining = req->mPieces.size();
+  {
+    std::lock_guard<std::mutex> lock(mAioMutex);
+    ++mAioInFlight;
+  }
+
+  for (size_t i = 0; i < req->mPieces.size(); ++i) {
+    const XrdOucIOVec& piece = req->mPieces[i];
+    mAioEngine->Read(fd, piece.data, piece.size, piece.offset,
+    [this, req, i, aiop, buffer, offset, length](ssize_t nread) {
+      req->mResults[i] = nread;
+
+      if (--req->mRemaining) {
+        return;
+      }
+
+      aiop->Result = CheckPieces(req->mPieces, req->mResults, buffer, offset,
+                                 length);
+      aiop->doneRead();
+      std::lock_guard<std::mutex> lock(mAioMutex);
+
+      if (--mAioInFlight == 0) {
+        mAioCond.notify_all();
+      }
+    });
+  }
+
+  return XrdOssOK;
 }
 
 
@@ -262,6 +375,17 @@ XrdFstOssFile::Read(void* buffer, off_t offset, size_t length)
 //------------------------------------------------------------------------------
 std::vector<XrdOucIOVec>
 XrdFstOssFile::AlignBuffer(void* buffer, off_t offset, size_t length)
+{
+  return AlignBuffer(buffer, offset, length, mPieceStart, mPieceEnd);
+}
+
+
+//------------------------------------------------------------------------------
+// Align request to the blockchecksum offset using the given edge buffers
+//------------------------------------------------------------------------------
+std::vector<XrdOucIOVec>
+XrdFstOssFile::AlignBuffer(void* buffer, off_t offset, size_t length,
+                           char* piece_start, char* piece_end)
 {
   XrdOucIOVec piece;
   std::vector<XrdOucIOVec> resp;
@@ -275,7 +399,7 @@ XrdFstOssFile::AlignBuffer(void* buffer, off_t offset, size_t length)
     // Extra piece at the beginning
     piece = {(long long) align_start,
              (int) blk_size, 0,
-             mPieceStart
+             piece_start
             };
     resp.push_back(piece);
     align_start += blk_size;
@@ -298,7 +422,7 @@ XrdFstOssFile::AlignBuffer(void* buffer, off_t offset, size_t length)
       // Extra piece at the end
       piece = {(long long) align_end,
                (int) blk_size, 0,
-               mPieceEnd
+               piece_end
               };
       resp.push_back(piece);
     }
@@ -455,6 +579,56 @@ XrdFstOssFile::Write(const void* buffer, off_t offset, size_t length)
   return (retval >= 0 ? retval : static_cast<ssize_t>(-errno));
 }
 
+//------------------------------------------------------------------------------
+// Asynchronous write
+//------------------------------------------------------------------------------
+int
+XrdFstOssFile::Write(XrdSfsAio* aiop)
+{
+  const void* buffer = (const void*) aiop->sfsAio.aio_buf;
+  off_t offset = aiop->sfsAio.aio_offset;
+  size_t length = aiop->sfsAio.aio_nbytes;
+
+  if (!mAioEngine || (fd < 0)) {
+    aiop->Result = Write(buffer, offset, length);
+    aiop->doneWrite();
+    return XrdOssOK;
+  }
+
+  if (mBlockXs) {
+    XrdSysRWLockHelper wr_lock(mRWLockXs, 0);
+    mBlockXs->AddBlockSum(offset, static_cast<const char*>(buffer), length);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mAioMutex);
+    ++mAioInFlight;
+  }
+
+  mAioEngine->Write(fd, buffer, length, offset, [this, aiop](ssize_t nwrite) {
+    aiop->Result = nwrite;
+    aiop->doneWrite();
+    std::lock_guard<std::mutex> lock(mAioMutex);
+
+    if (--mAioInFlight == 0) {
+      mAioCond.notify_all();
+    }
+  });
+  return XrdOssOK;
+}
+
+//------------------------------------------------------------------------------
+// Wait for all the asynchronous requests in flight to complete
+//------------------------------------------------------------------------------
+void
+XrdFstOssFile::WaitAio()
+{
+  std::unique_lock<std::mutex> lock(mAioMutex);
+  mAioCond.wait(lock, [this]() {
+    return (mAioInFlight == 0);
+  });
+}
+
 //------------------------------------------------------------------------------
 // Get file status
 //------------------------------------------------------------------------------
@@ -520,6 +694,7 @@ XrdFstOssFile::Close(long long* retsz)
 {
   bool delete_mapping = false;
   bool unlinked = false;
+  WaitAio();
 
   if (fd < 0) {
     return -EBADF;
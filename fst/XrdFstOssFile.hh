@@ -26,7 +26,9 @@
 #define __EOSFST_FSTOSSFILE_HH__
 
 /*----------------------------------------------------------------------------*/
+#include <condition_variable>
 #include <map>
+#include <mutex>
 #include <string>
 /*----------------------------------------------------------------------------*/
 #include "fst/Namespace.hh"
@@ -37,6 +39,7 @@
 EOSFSTNAMESPACE_BEGIN
 
 class CheckSum;
+class AsyncIoEngine;
 
 //------------------------------------------------------------------------------
 //! Class XrdFstOssFile using blockxs information
@@ -87,6 +90,19 @@ public:
   ssize_t Read (void* buffer, off_t offset, size_t length);
 
 
+  //--------------------------------------------------------------------------
+  //! Asynchronous read through the IO engine of the disk. The block checksums
+  //! of all the pieces are verified once the last piece arrived, then the
+  //! request is completed. Served synchronously if async IO is disabled.
+  //!
+  //! @param aiop asynchronous request
+  //!
+  //! @return XrdOssOK, errors are reported through aiop->Result
+  //!
+  //--------------------------------------------------------------------------
+  int Read (XrdSfsAio* aiop);
+
+
   //--------------------------------------------------------------------------
   //! Read raw
   //!
@@ -137,6 +153,19 @@ public:
   ssize_t Write (const void* buffer, off_t offset, size_t length);
 
 
+  //--------------------------------------------------------------------------
+  //! Asynchronous write through the IO engine of the disk. The block
+  //! checksum is updated at submission, in the order in which the requests
+  //! arrive, as for synchronous writes.
+  //!
+  //! @param aiop asynchronous request
+  //!
+  //! @return XrdOssOK, errors are reported through aiop->Result
+  //!
+  //--------------------------------------------------------------------------
+  int Write (XrdSfsAio* aiop);
+
+
   //--------------------------------------------------------------------------
   //! Chmod function
   //!
@@ -199,6 +228,31 @@ private:
   CheckSum* mBlockXs; ///< block xs object
   char* mPieceStart; ///< start piece aligned to the blockxs offset
   char* mPieceEnd; ///< end piece aligned to the blockxs offset
+  AsyncIoEngine* mAioEngine; ///< engine of the disk, null if aio disabled
+  std::mutex mAioMutex; ///< mutex protecting the in-flight counter
+  std::condition_variable mAioCond; ///< signals the last aio completion
+  uint64_t mAioInFlight; ///< number of asynchronous requests in flight
+
+  //--------------------------------------------------------------------------
+  //! Verify the block checksum of pieces read in and copy back the edges
+  //!
+  //! @param pieces pieces as returned by AlignBuffer
+  //! @param nread result of the read of every piece, -errno on error
+  //! @param buffer data container of the request
+  //! @param offset offset of the request
+  //! @param length length of the request
+  //!
+  //! @return number of bytes read or -errno
+  //!
+  //--------------------------------------------------------------------------
+  ssize_t CheckPieces(const std::vector<XrdOucIOVec>& pieces,
+                      const std::vector<ssize_t>& nread,
+                      void* buffer, off_t offset, size_t length);
+
+  //--------------------------------------------------------------------------
+  //! Wait for all the asynchronous requests in flight to complete
+  //--------------------------------------------------------------------------
+  void WaitAio();
 
 #ifdef IN_TEST_HARNESS
 public:
@@ -217,6 +271,14 @@ public:
   //!
   //--------------------------------------------------------------------------
   std::vector<XrdOucIOVec> AlignBuffer(void* buffer, off_t offset, size_t length);
+
+  //--------------------------------------------------------------------------
+  //! Align request to the blockchecksum offset using the given buffers for
+  //! the extra pieces, each of them OssXsBlockSize long
+  //--------------------------------------------------------------------------
+  std::vector<XrdOucIOVec> AlignBuffer(void* buffer, off_t offset,
+                                       size_t length, char* piece_start,
+                                       char* piece_end);
 };
 
 EOSFSTNAMESPACE_END
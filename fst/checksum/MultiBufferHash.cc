@@ -0,0 +1,624 @@
+//------------------------------------------------------------------------------
+//! @file MultiBufferHash.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/checksum/MultiBufferHash.hh"
+#include "common/LayoutId.hh"
+#include <algorithm>
+#include <cstring>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+EOSFSTNAMESPACE_BEGIN
+
+namespace
+{
+//! MD5 additive constants
+const uint32_t kMd5K[64] = {
+  0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+  0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+  0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+  0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+  0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+  0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+  0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+  0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+  0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+  0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+  0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+//! MD5 per round left rotations
+const int kMd5S[64] = {
+  7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+  5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+  4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+  6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+//! SHA1 additive constants per group of 20 rounds
+const uint32_t kSha1K[4] = {
+  0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6
+};
+
+const uint32_t kMd5Init[4] = {
+  0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476
+};
+
+const uint32_t kSha1Init[5] = {
+  0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+};
+
+//! Block fed to the idle SIMD lanes
+const unsigned char kZeroBlock[MultiBufferHash::sBlockSize] = {0};
+
+inline uint32_t
+Rotl(uint32_t x, int n)
+{
+  return (x << n) | (x >> (32 - n));
+}
+
+inline uint32_t
+LoadLE32(const unsigned char* p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint32_t
+LoadBE32(const unsigned char* p)
+{
+  return __builtin_bswap32(LoadLE32(p));
+}
+
+//! Message word index of the MD5 rounds
+inline int
+Md5Index(int i)
+{
+  return (i < 16) ? i : (i < 32) ? ((5 * i + 1) & 15) :
+         (i < 48) ? ((3 * i + 5) & 15) : ((7 * i) & 15);
+}
+
+//------------------------------------------------------------------------------
+// Compress MD5 blocks of one stream
+//------------------------------------------------------------------------------
+void
+Md5Blocks(uint32_t* st, const unsigned char* data, size_t nblocks)
+{
+  for (; nblocks; --nblocks, data += MultiBufferHash::sBlockSize) {
+    uint32_t m[16];
+
+    for (int j = 0; j < 16; ++j) {
+      m[j] = LoadLE32(data + 4 * j);
+    }
+
+    uint32_t a = st[0], b = st[1], c = st[2], d = st[3];
+
+    for (int i = 0; i < 64; ++i) {
+      uint32_t f;
+
+      if (i < 16) {
+        f = (b & c) | (~b & d);
+      } else if (i < 32) {
+        f = (d & b) | (~d & c);
+      } else if (i < 48) {
+        f = b ^ c ^ d;
+      } else {
+        f = c ^ (b | ~d);
+      }
+
+      uint32_t tmp = d;
+      d = c;
+      c = b;
+      b = b + Rotl(a + f + kMd5K[i] + m[Md5Index(i)], kMd5S[i]);
+      a = tmp;
+    }
+
+    st[0] += a;
+    st[1] += b;
+    st[2] += c;
+    st[3] += d;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Compress SHA1 blocks of one stream
+//------------------------------------------------------------------------------
+void
+Sha1Blocks(uint32_t* st, const unsigned char* data, size_t nblocks)
+{
+  for (; nblocks; --nblocks, data += MultiBufferHash::sBlockSize) {
+    uint32_t w[16];
+
+    for (int j = 0; j < 16; ++j) {
+      w[j] = LoadBE32(data + 4 * j);
+    }
+
+    uint32_t a = st[0], b = st[1], c = st[2], d = st[3], e = st[4];
+
+    for (int t = 0; t < 80; ++t) {
+      if (t >= 16) {
+        w[t & 15] = Rotl(w[(t - 3) & 15] ^ w[(t - 8) & 15] ^ w[(t - 14) & 15] ^
+                         w[t & 15], 1);
+      }
+
+      uint32_t f;
+
+      if (t < 20) {
+        f = (b & c) | (~b & d);
+      } else if ((t >= 40) && (t < 60)) {
+        f = (b & c) | (b & d) | (c & d);
+      } else {
+        f = b ^ c ^ d;
+      }
+
+      uint32_t tmp = Rotl(a, 5) + f + e + kSha1K[t / 20] + w[t & 15];
+      e = d;
+      d = c;
+      c = Rotl(b, 30);
+      b = a;
+      a = tmp;
+    }
+
+    st[0] += a;
+    st[1] += b;
+    st[2] += c;
+    st[3] += d;
+    st[4] += e;
+  }
+}
+
+#if defined(__x86_64__)
+#define EOS_MBH_AVX2 __attribute__((target("avx2")))
+
+EOS_MBH_AVX2 inline __m256i
+Rotl8(__m256i x, int n)
+{
+  return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n));
+}
+
+//------------------------------------------------------------------------------
+// Load the current block of the 8 lanes as 16 vectors, vector j holding the
+// message word j of every lane
+//------------------------------------------------------------------------------
+EOS_MBH_AVX2 inline void
+LoadBlocks8(const unsigned char* const* ptrs, __m256i* m, bool big_endian)
+{
+  const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8,
+                                         15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4,
+                                         11, 10, 9, 8, 15, 14, 13, 12);
+
+  for (int half = 0; half < 2; ++half) {
+    __m256i r[8];
+
+    for (int l = 0; l < 8; ++l) {
+      r[l] = _mm256_loadu_si256((const __m256i*)(ptrs[l] + 32 * half));
+    }
+
+    // 8x8 transpose of 32-bit words
+    __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+    __m256i* out = m + 8 * half;
+    out[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    out[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    out[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    out[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    out[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    out[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    out[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    out[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+
+    if (big_endian) {
+      for (int j = 0; j < 8; ++j) {
+        out[j] = _mm256_shuffle_epi8(out[j], bswap);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Load/store one state word of the 8 lanes
+//------------------------------------------------------------------------------
+EOS_MBH_AVX2 inline __m256i
+LoadState8(uint32_t st[][5], int word)
+{
+  return _mm256_setr_epi32(st[0][word], st[1][word], st[2][word], st[3][word],
+                           st[4][word], st[5][word], st[6][word], st[7][word]);
+}
+
+EOS_MBH_AVX2 inline void
+StoreState8(uint32_t st[][5], int word, __m256i v)
+{
+  uint32_t tmp[8];
+  _mm256_storeu_si256((__m256i*) tmp, v);
+
+  for (int l = 0; l < 8; ++l) {
+    st[l][word] = tmp[l];
+  }
+}
+
+//------------------------------------------------------------------------------
+// Compress MD5 blocks of 8 streams, one stream per 32-bit lane
+//------------------------------------------------------------------------------
+EOS_MBH_AVX2 void
+Md5BlocksX8(uint32_t st[][5], const unsigned char** ptrs, const size_t* steps,
+            size_t nblocks)
+{
+  const __m256i ones = _mm256_set1_epi32(-1);
+  __m256i a = LoadState8(st, 0), b = LoadState8(st, 1);
+  __m256i c = LoadState8(st, 2), d = LoadState8(st, 3);
+
+  for (; nblocks; --nblocks) {
+    __m256i m[16];
+    LoadBlocks8(ptrs, m, false);
+
+    __m256i aa = a, bb = b, cc = c, dd = d;
+
+    for (int i = 0; i < 64; ++i) {
+      __m256i f;
+
+      if (i < 16) {
+        f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_andnot_si256(b, d));
+      } else if (i < 32) {
+        f = _mm256_or_si256(_mm256_and_si256(d, b), _mm256_andnot_si256(d, c));
+      } else if (i < 48) {
+        f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+      } else {
+        f = _mm256_xor_si256(c, _mm256_or_si256(b, _mm256_xor_si256(d, ones)));
+      }
+
+      __m256i sum = _mm256_add_epi32(_mm256_add_epi32(a, f),
+                                     _mm256_add_epi32(_mm256_set1_epi32(kMd5K[i]),
+                                         m[Md5Index(i)]));
+      __m256i tmp = d;
+      d = c;
+      c = b;
+      b = _mm256_add_epi32(b, Rotl8(sum, kMd5S[i]));
+      a = tmp;
+    }
+
+    a = _mm256_add_epi32(a, aa);
+    b = _mm256_add_epi32(b, bb);
+    c = _mm256_add_epi32(c, cc);
+    d = _mm256_add_epi32(d, dd);
+
+    for (int l = 0; l < 8; ++l) {
+      ptrs[l] += steps[l];
+    }
+  }
+
+  StoreState8(st, 0, a);
+  StoreState8(st, 1, b);
+  StoreState8(st, 2, c);
+  StoreState8(st, 3, d);
+}
+
+//------------------------------------------------------------------------------
+// Compress SHA1 blocks of 8 streams, one stream per 32-bit lane
+//------------------------------------------------------------------------------
+EOS_MBH_AVX2 void
+Sha1BlocksX8(uint32_t st[][5], const unsigned char** ptrs, const size_t* steps,
+             size_t nblocks)
+{
+  __m256i a = LoadState8(st, 0), b = LoadState8(st, 1);
+  __m256i c = LoadState8(st, 2), d = LoadState8(st, 3);
+  __m256i e = LoadState8(st, 4);
+
+  for (; nblocks; --nblocks) {
+    __m256i w[16];
+    LoadBlocks8(ptrs, w, true);
+
+    __m256i aa = a, bb = b, cc = c, dd = d, ee = e;
+
+    for (int t = 0; t < 80; ++t) {
+      if (t >= 16) {
+        w[t & 15] = Rotl8(_mm256_xor_si256(
+                            _mm256_xor_si256(w[(t - 3) & 15], w[(t - 8) & 15]),
+                            _mm256_xor_si256(w[(t - 14) & 15], w[t & 15])), 1);
+      }
+
+      __m256i f;
+
+      if (t < 20) {
+        f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_andnot_si256(b, d));
+      } else if ((t >= 40) && (t < 60)) {
+        f = _mm256_or_si256(_mm256_and_si256(b, c),
+                            _mm256_and_si256(d, _mm256_or_si256(b, c)));
+      } else {
+        f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+      }
+
+      __m256i tmp = _mm256_add_epi32(_mm256_add_epi32(Rotl8(a, 5), f),
+                                     _mm256_add_epi32(_mm256_add_epi32(e, w[t & 15]),
+                                         _mm256_set1_epi32(kSha1K[t / 20])));
+      e = d;
+      d = c;
+      c = Rotl8(b, 30);
+      b = a;
+      a = tmp;
+    }
+
+    a = _mm256_add_epi32(a, aa);
+    b = _mm256_add_epi32(b, bb);
+    c = _mm256_add_epi32(c, cc);
+    d = _mm256_add_epi32(d, dd);
+    e = _mm256_add_epi32(e, ee);
+
+    for (int l = 0; l < 8; ++l) {
+      ptrs[l] += steps[l];
+    }
+  }
+
+  StoreState8(st, 0, a);
+  StoreState8(st, 1, b);
+  StoreState8(st, 2, c);
+  StoreState8(st, 3, d);
+  StoreState8(st, 4, e);
+}
+#endif
+}
+
+static_assert(MultiBufferHash::sLanes == 8, "SIMD kernels handle 8 lanes");
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+MultiBufferHash::MultiBufferHash(Type type):
+  mType(type)
+{
+  for (size_t lane = 0; lane < sLanes; ++lane) {
+    Reset(lane);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Map a layout checksum type to a hash type
+//------------------------------------------------------------------------------
+bool
+MultiBufferHash::GetType(unsigned long xs_type, Type& type)
+{
+  if (xs_type == eos::common::LayoutId::kMD5) {
+    type = Type::kMD5;
+    return true;
+  } else if (xs_type == eos::common::LayoutId::kSHA1) {
+    type = Type::kSHA1;
+    return true;
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Check if the SIMD kernels are used on this CPU
+//------------------------------------------------------------------------------
+bool
+MultiBufferHash::HasSimd()
+{
+#if defined(__x86_64__)
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2;
+#else
+  return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Start a new stream in a lane
+//------------------------------------------------------------------------------
+void
+MultiBufferHash::Reset(size_t lane)
+{
+  if (mType == Type::kMD5) {
+    memcpy(mState[lane], kMd5Init, sizeof(kMd5Init));
+    mState[lane][4] = 0;
+  } else {
+    memcpy(mState[lane], kSha1Init, sizeof(kSha1Init));
+  }
+
+  mLength[lane] = 0;
+  mTailLen[lane] = 0;
+}
+
+//------------------------------------------------------------------------------
+// Append one buffer to each lane
+//------------------------------------------------------------------------------
+void
+MultiBufferHash::Update(const char* const* buffers, const size_t* lengths)
+{
+  const unsigned char* ptrs[sLanes];
+  size_t nblocks[sLanes];
+  size_t rest[sLanes];
+
+  for (size_t lane = 0; lane < sLanes; ++lane) {
+    const unsigned char* ptr = (const unsigned char*) buffers[lane];
+    size_t len = lengths[lane];
+    mLength[lane] += len;
+
+    // Complete the pending block first
+    if (len && mTailLen[lane]) {
+      size_t fill = std::min(sBlockSize - mTailLen[lane], len);
+      memcpy(mTail[lane] + mTailLen[lane], ptr, fill);
+      mTailLen[lane] += fill;
+      ptr += fill;
+      len -= fill;
+
+      if (mTailLen[lane] == sBlockSize) {
+        CompressOne(lane, mTail[lane], 1);
+        mTailLen[lane] = 0;
+      }
+    }
+
+    ptrs[lane] = ptr;
+    nblocks[lane] = len / sBlockSize;
+    rest[lane] = len % sBlockSize;
+  }
+
+  CompressLanes(ptrs, nblocks);
+
+  for (size_t lane = 0; lane < sLanes; ++lane) {
+    if (rest[lane]) {
+      memcpy(mTail[lane] + mTailLen[lane], ptrs[lane], rest[lane]);
+      mTailLen[lane] += rest[lane];
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Append a buffer to a single lane
+//------------------------------------------------------------------------------
+void
+MultiBufferHash::Update(size_t lane, const char* buffer, size_t length)
+{
+  const char* buffers[sLanes] = {nullptr};
+  size_t lengths[sLanes] = {0};
+  buffers[lane] = buffer;
+  lengths[lane] = length;
+  Update(buffers, lengths);
+}
+
+//------------------------------------------------------------------------------
+// Finish the stream of a lane
+//------------------------------------------------------------------------------
+void
+MultiBufferHash::Final(size_t lane, unsigned char* digest)
+{
+  unsigned char* tail = mTail[lane];
+  size_t len = mTailLen[lane];
+  uint64_t bits = mLength[lane] * 8;
+  tail[len++] = 0x80;
+
+  if (len > sBlockSize - 8) {
+    memset(tail + len, 0, sBlockSize - len);
+    CompressOne(lane, tail, 1);
+    len = 0;
+  }
+
+  memset(tail + len, 0, sBlockSize - 8 - len);
+
+  for (int i = 0; i < 8; ++i) {
+    int shift = (mType == Type::kMD5) ? (8 * i) : (56 - 8 * i);
+    tail[sBlockSize - 8 + i] = (unsigned char)(bits >> shift);
+  }
+
+  CompressOne(lane, tail, 1);
+  mTailLen[lane] = 0;
+
+  for (size_t i = 0; i < GetDigestLen() / 4; ++i) {
+    uint32_t word = (mType == Type::kMD5) ? mState[lane][i] :
+                    __builtin_bswap32(mState[lane][i]);
+    memcpy(digest + 4 * i, &word, sizeof(word));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Compress full blocks of all the lanes
+//------------------------------------------------------------------------------
+void
+MultiBufferHash::CompressLanes(const unsigned char** ptrs, size_t* nblocks)
+{
+  while (true) {
+    size_t active = 0;
+    size_t common = 0;
+
+    for (size_t lane = 0; lane < sLanes; ++lane) {
+      if (nblocks[lane]) {
+        common = (active++ == 0) ? nblocks[lane] : std::min(common, nblocks[lane]);
+      }
+    }
+
+    if (active == 0) {
+      return;
+    }
+
+    if ((active == 1) || !HasSimd()) {
+      for (size_t lane = 0; lane < sLanes; ++lane) {
+        if (nblocks[lane]) {
+          CompressOne(lane, ptrs[lane], nblocks[lane]);
+          ptrs[lane] += nblocks[lane] * sBlockSize;
+          nblocks[lane] = 0;
+        }
+      }
+
+      return;
+    }
+
+#if defined(__x86_64__)
+    // The idle lanes hash a zero block in place and get their state back
+    uint32_t saved[sLanes][5];
+    const unsigned char* simd_ptrs[sLanes];
+    size_t steps[sLanes];
+    memcpy(saved, mState, sizeof(saved));
+
+    for (size_t lane = 0; lane < sLanes; ++lane) {
+      simd_ptrs[lane] = nblocks[lane] ? ptrs[lane] : kZeroBlock;
+      steps[lane] = nblocks[lane] ? sBlockSize : 0;
+    }
+
+    if (mType == Type::kMD5) {
+      Md5BlocksX8(mState, simd_ptrs, steps, common);
+    } else {
+      Sha1BlocksX8(mState, simd_ptrs, steps, common);
+    }
+
+    for (size_t lane = 0; lane < sLanes; ++lane) {
+      if (nblocks[lane]) {
+        ptrs[lane] = simd_ptrs[lane];
+        nblocks[lane] -= common;
+      } else {
+        memcpy(mState[lane], saved[lane], sizeof(saved[lane]));
+      }
+    }
+
+#endif
+  }
+}
+
+//------------------------------------------------------------------------------
+// Compress consecutive blocks of a single lane
+//------------------------------------------------------------------------------
+void
+MultiBufferHash::CompressOne(size_t lane, const unsigned char* data,
+                             size_t nblocks)
+{
+  if (mType == Type::kMD5) {
+    Md5Blocks(mState[lane], data, nblocks);
+  } else {
+    Sha1Blocks(mState[lane], data, nblocks);
+  }
+}
+
+EOSFSTNAMESPACE_END
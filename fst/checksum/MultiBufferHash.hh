@@ -0,0 +1,143 @@
+//------------------------------------------------------------------------------
+//! @file MultiBufferHash.hh
+//! @brief Multi-buffer MD5/SHA1 computing several independent streams at once
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSFST_MULTIBUFFERHASH_HH__
+#define __EOSFST_MULTIBUFFERHASH_HH__
+
+#include "fst/Namespace.hh"
+#include <stddef.h>
+#include <stdint.h>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class MultiBufferHash
+//!
+//! @description Computes the MD5 or SHA1 digest of up to sLanes independent
+//! streams (e.g. several files scanned concurrently). The 64-byte blocks of
+//! the different streams are compressed together, one stream per 32-bit lane
+//! of an AVX2 register, which makes these hashes - otherwise bound by the
+//! serial dependency chain inside a single stream - run close to the memory
+//! bandwidth. Without AVX2 the lanes are compressed one after the other.
+//------------------------------------------------------------------------------
+class MultiBufferHash
+{
+public:
+  static constexpr size_t sLanes = 8; ///< Number of streams
+  static constexpr size_t sBlockSize = 64; ///< Compression block size
+  static constexpr size_t sMaxDigestLen = 20; ///< Longest digest (SHA1)
+
+  //! Supported algorithms
+  enum class Type {
+    kMD5,
+    kSHA1
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param type hash algorithm used by all the lanes
+  //----------------------------------------------------------------------------
+  explicit MultiBufferHash(Type type);
+
+  //----------------------------------------------------------------------------
+  //! Check if a layout checksum type can be computed by this class
+  //!
+  //! @param xs_type checksum type as in LayoutId::eChecksum
+  //! @param type output hash type
+  //!
+  //! @return true if supported
+  //----------------------------------------------------------------------------
+  static bool GetType(unsigned long xs_type, Type& type);
+
+  //----------------------------------------------------------------------------
+  //! Check if the SIMD kernels are used on this CPU
+  //----------------------------------------------------------------------------
+  static bool HasSimd();
+
+  //----------------------------------------------------------------------------
+  //! Get the length of the digest in bytes
+  //----------------------------------------------------------------------------
+  inline size_t GetDigestLen() const
+  {
+    return (mType == Type::kMD5) ? 16 : 20;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Start a new stream in a lane
+  //!
+  //! @param lane lane index
+  //----------------------------------------------------------------------------
+  void Reset(size_t lane);
+
+  //----------------------------------------------------------------------------
+  //! Append one buffer to each lane. The lanes given an empty buffer are left
+  //! untouched. Buffers of equal length give the best throughput.
+  //!
+  //! @param buffers sLanes buffer pointers
+  //! @param lengths sLanes buffer lengths
+  //----------------------------------------------------------------------------
+  void Update(const char* const* buffers, const size_t* lengths);
+
+  //----------------------------------------------------------------------------
+  //! Append a buffer to a single lane
+  //!
+  //! @param lane lane index
+  //! @param buffer data
+  //! @param length data length
+  //----------------------------------------------------------------------------
+  void Update(size_t lane, const char* buffer, size_t length);
+
+  //----------------------------------------------------------------------------
+  //! Finish the stream of a lane. The lane must be reset before being reused.
+  //!
+  //! @param lane lane index
+  //! @param digest output buffer of at least GetDigestLen() bytes
+  //----------------------------------------------------------------------------
+  void Final(size_t lane, unsigned char* digest);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Compress full blocks of all the lanes with blocks left, the lanes with
+  //! the fewest blocks first
+  //!
+  //! @param ptrs per lane data, advanced past the compressed blocks
+  //! @param nblocks per lane number of blocks, set to 0 on return
+  //----------------------------------------------------------------------------
+  void CompressLanes(const unsigned char** ptrs, size_t* nblocks);
+
+  //----------------------------------------------------------------------------
+  //! Compress consecutive blocks of a single lane
+  //----------------------------------------------------------------------------
+  void CompressOne(size_t lane, const unsigned char* data, size_t nblocks);
+
+  Type mType; ///< Hash algorithm
+  uint32_t mState[sLanes][5]; ///< Chaining state per lane
+  uint64_t mLength[sLanes]; ///< Bytes appended per lane
+  unsigned char mTail[sLanes][sBlockSize]; ///< Incomplete block per lane
+  size_t mTailLen[sLanes]; ///< Bytes in the incomplete block
+};
+
+EOSFSTNAMESPACE_END
+
+#endif
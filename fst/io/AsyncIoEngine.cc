@@ -0,0 +1,566 @@
+//------------------------------------------------------------------------------
+// File: AsyncIoEngine.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/io/AsyncIoEngine.hh"
+#include "common/Logging.hh"
+#include <algorithm>
+#include <sstream>
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define EOS_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+EOSFSTNAMESPACE_BEGIN
+
+#ifdef EOS_HAVE_IO_URING
+//------------------------------------------------------------------------------
+//! Mapped io_uring, the liburing helpers are not available on all the
+//! supported platforms so the rings are driven through the raw system calls
+//------------------------------------------------------------------------------
+struct AsyncIoEngine::Ring {
+  int mFd = -1; ///< Ring file descriptor
+  void* mSqPtr = MAP_FAILED; ///< Submission ring mapping
+  size_t mSqSize = 0; ///< Size of the submission ring mapping
+  void* mCqPtr = MAP_FAILED; ///< Completion ring mapping, may be mSqPtr
+  size_t mCqSize = 0; ///< Size of the completion ring mapping
+  struct io_uring_sqe* mSqes = nullptr; ///< Submission queue entries
+  size_t mSqesSize = 0; ///< Size of the submission entries mapping
+  unsigned* mSqHead = nullptr; ///< Submission ring head, moved by the kernel
+  unsigned* mSqTail = nullptr; ///< Submission ring tail
+  unsigned* mSqMask = nullptr; ///< Submission ring mask
+  unsigned* mSqArray = nullptr; ///< Submission ring index array
+  unsigned* mCqHead = nullptr; ///< Completion ring head
+  unsigned* mCqTail = nullptr; ///< Completion ring tail, moved by the kernel
+  unsigned* mCqMask = nullptr; ///< Completion ring mask
+  struct io_uring_cqe* mCqes = nullptr; ///< Completion queue entries
+  std::mutex mSubmitMutex; ///< Serializes the producers of the submission ring
+
+  ~Ring()
+  {
+    if (mSqes) {
+      munmap(mSqes, mSqesSize);
+    }
+
+    if ((mCqPtr != MAP_FAILED) && (mCqPtr != mSqPtr)) {
+      munmap(mCqPtr, mCqSize);
+    }
+
+    if (mSqPtr != MAP_FAILED) {
+      munmap(mSqPtr, mSqSize);
+    }
+
+    if (mFd >= 0) {
+      close(mFd);
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+// Helpers for the raw system calls
+//------------------------------------------------------------------------------
+static int
+sys_io_uring_setup(unsigned entries, struct io_uring_params* p)
+{
+  return (int) syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int
+sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                   unsigned flags)
+{
+  return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                       flags, nullptr, 0);
+}
+#else
+struct AsyncIoEngine::Ring {};
+#endif
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+AsyncIoEngine::AsyncIoEngine(const std::string& name, unsigned int depth,
+                             bool use_uring):
+  mName(name), mDepth(std::min(std::max(depth, 1u), 4096u)),
+  mBackend(Backend::Threads), mRing(nullptr), mInFlight(0), mStop(false),
+  mSubmitted(0), mCompleted(0)
+{
+  if (use_uring && SetupRing()) {
+    mBackend = Backend::IoUring;
+    mThreads.emplace_back(&AsyncIoEngine::RingReap, this);
+  } else {
+    for (unsigned int i = 0; i < mDepth; ++i) {
+      mThreads.emplace_back(&AsyncIoEngine::WorkerLoop, this);
+    }
+  }
+
+  // Thread names are limited to 15 characters
+  std::string tname = "aio:" + mName.substr(0, 11);
+
+  for (auto& thread : mThreads) {
+    pthread_setname_np(thread.native_handle(), tname.c_str());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+AsyncIoEngine::~AsyncIoEngine()
+{
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCond.wait(lock, [this]() {
+      return mQueue.empty() && (mInFlight == 0);
+    });
+    mStop = true;
+  }
+  mCond.notify_all();
+#ifdef EOS_HAVE_IO_URING
+
+  if (mRing) {
+    // Wake up the reaper with a no-op carrying no request
+    std::lock_guard<std::mutex> lock(mRing->mSubmitMutex);
+    unsigned tail = *mRing->mSqTail;
+    unsigned index = tail & *mRing->mSqMask;
+    struct io_uring_sqe* sqe = &mRing->mSqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = 0;
+    mRing->mSqArray[index] = index;
+    __atomic_store_n(mRing->mSqTail, tail + 1, __ATOMIC_RELEASE);
+
+    while ((sys_io_uring_enter(mRing->mFd, 1, 0, 0) < 0) &&
+           ((errno == EINTR) || (errno == EAGAIN) || (errno == EBUSY)));
+  }
+
+#endif
+
+  for (auto& thread : mThreads) {
+    thread.join();
+  }
+
+  delete mRing;
+}
+
+//------------------------------------------------------------------------------
+// Check if io_uring can be used on this machine
+//------------------------------------------------------------------------------
+bool
+AsyncIoEngine::IoUringAvailable()
+{
+#ifdef EOS_HAVE_IO_URING
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = sys_io_uring_setup(1, &params);
+
+  if (fd < 0) {
+    return false;
+  }
+
+  close(fd);
+  return true;
+#else
+  return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Submit a positional read
+//------------------------------------------------------------------------------
+void
+AsyncIoEngine::Read(int fd, void* buffer, size_t length, off_t offset,
+                    Callback cb)
+{
+  Request* req = new Request{fd, false, {buffer, length}, offset,
+                             std::move(cb), Clock::now()};
+  Submit(req);
+}
+
+//------------------------------------------------------------------------------
+// Submit a positional write
+//------------------------------------------------------------------------------
+void
+AsyncIoEngine::Write(int fd, const void* buffer, size_t length, off_t offset,
+                     Callback cb)
+{
+  Request* req = new Request{fd, true, {const_cast<void*>(buffer), length},
+                             offset, std::move(cb), Clock::now()};
+  Submit(req);
+}
+
+//------------------------------------------------------------------------------
+// Queue a request and hand it to the backend if a slot is free
+//------------------------------------------------------------------------------
+void
+AsyncIoEngine::Submit(Request* req)
+{
+  std::vector<Request*> batch;
+  mSubmitted++;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mQueue.push_back(req);
+
+    if (mBackend == Backend::IoUring) {
+      while (!mQueue.empty() && (mInFlight < mDepth)) {
+        batch.push_back(mQueue.front());
+        mQueue.pop_front();
+        ++mInFlight;
+      }
+    }
+  }
+
+  if (mBackend == Backend::IoUring) {
+    if (!batch.empty()) {
+      RingSubmit(batch);
+    }
+  } else {
+    mCond.notify_one();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Account for a completed request, run its callback and free its slot
+//------------------------------------------------------------------------------
+void
+AsyncIoEngine::Complete(Request* req, ssize_t result)
+{
+  mLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>
+                  (Clock::now() - req->mSubmitted).count());
+  Callback cb = std::move(req->mCallback);
+  delete req;
+  std::vector<Request*> batch;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    --mInFlight;
+    mCompleted++;
+
+    if (mBackend == Backend::IoUring) {
+      while (!mQueue.empty() && (mInFlight < mDepth)) {
+        batch.push_back(mQueue.front());
+        mQueue.pop_front();
+        ++mInFlight;
+      }
+    }
+  }
+
+  // Refill the ring before running the callback so the disk stays busy
+  if (!batch.empty()) {
+    RingSubmit(batch);
+  }
+
+  if (cb) {
+    cb(result);
+  }
+
+  // The destructor waits for the last completion
+  mCond.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Set up the io_uring backend
+//------------------------------------------------------------------------------
+bool
+AsyncIoEngine::SetupRing()
+{
+#ifdef EOS_HAVE_IO_URING
+  std::unique_ptr<Ring> ring(new Ring());
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  // The completion ring is twice as large, at most mDepth requests are ever
+  // in flight so it can not overflow
+  ring->mFd = sys_io_uring_setup(mDepth, &params);
+
+  if (ring->mFd < 0) {
+    eos_static_info("msg=\"io_uring not available, using threads\" "
+                    "engine=%s errno=%d", mName.c_str(), errno);
+    return false;
+  }
+
+  ring->mSqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->mCqSize = params.cq_off.cqes +
+                  params.cq_entries * sizeof(struct io_uring_cqe);
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->mSqSize = ring->mCqSize = std::max(ring->mSqSize, ring->mCqSize);
+  }
+
+  ring->mSqPtr = mmap(nullptr, ring->mSqSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->mFd, IORING_OFF_SQ_RING);
+
+  if (ring->mSqPtr == MAP_FAILED) {
+    eos_static_err("msg=\"failed to map submission ring\" engine=%s errno=%d",
+                   mName.c_str(), errno);
+    return false;
+  }
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->mCqPtr = ring->mSqPtr;
+  } else {
+    ring->mCqPtr = mmap(nullptr, ring->mCqSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->mFd, IORING_OFF_CQ_RING);
+
+    if (ring->mCqPtr == MAP_FAILED) {
+      eos_static_err("msg=\"failed to map completion ring\" engine=%s "
+                     "errno=%d", mName.c_str(), errno);
+      return false;
+    }
+  }
+
+  ring->mSqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+  void* sqes = mmap(nullptr, ring->mSqesSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring->mFd, IORING_OFF_SQES);
+
+  if (sqes == MAP_FAILED) {
+    eos_static_err("msg=\"failed to map submission entries\" engine=%s "
+                   "errno=%d", mName.c_str(), errno);
+    return false;
+  }
+
+  ring->mSqes = static_cast<struct io_uring_sqe*>(sqes);
+  char* sq = static_cast<char*>(ring->mSqPtr);
+  char* cq = static_cast<char*>(ring->mCqPtr);
+  ring->mSqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  ring->mSqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  ring->mSqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  ring->mSqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  ring->mCqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  ring->mCqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  ring->mCqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  ring->mCqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+  mRing = ring.release();
+  return true;
+#else
+  return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Put requests on the submission ring and notify the kernel
+//------------------------------------------------------------------------------
+void
+AsyncIoEngine::RingSubmit(const std::vector<Request*>& reqs)
+{
+#ifdef EOS_HAVE_IO_URING
+  std::vector<Request*> failed;
+  int err = 0;
+  {
+    std::lock_guard<std::mutex> lock(mRing->mSubmitMutex);
+    unsigned tail = *mRing->mSqTail;
+
+    // The kernel consumes the entries during io_uring_enter and at most
+    // mDepth requests are in flight, so there is always room on the ring
+    for (Request* req : reqs) {
+      unsigned index = tail & *mRing->mSqMask;
+      struct io_uring_sqe* sqe = &mRing->mSqes[index];
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = (req->mWrite ? IORING_OP_WRITEV : IORING_OP_READV);
+      sqe->fd = req->mFd;
+      sqe->off = req->mOffset;
+      sqe->addr = reinterpret_cast<uint64_t>(&req->mIov);
+      sqe->len = 1;
+      sqe->user_data = reinterpret_cast<uint64_t>(req);
+      mRing->mSqArray[index] = index;
+      ++tail;
+    }
+
+    __atomic_store_n(mRing->mSqTail, tail, __ATOMIC_RELEASE);
+    unsigned to_submit = reqs.size();
+
+    while (to_submit) {
+      int rc = sys_io_uring_enter(mRing->mFd, to_submit, 0, 0);
+
+      if (rc < 0) {
+        if ((errno == EINTR) || (errno == EAGAIN) || (errno == EBUSY)) {
+          continue;
+        }
+
+        err = errno;
+        break;
+      }
+
+      to_submit -= std::min<unsigned>(rc, to_submit);
+    }
+
+    if (err) {
+      // The entries the kernel did not consume are the last ones of this
+      // batch: take them back off the ring, so that the next submission does
+      // not pick them up, and fail their requests
+      unsigned pending = tail - __atomic_load_n(mRing->mSqHead,
+                         __ATOMIC_ACQUIRE);
+      pending = std::min<unsigned>(pending, reqs.size());
+      __atomic_store_n(mRing->mSqTail, tail - pending, __ATOMIC_RELEASE);
+      failed.assign(reqs.end() - pending, reqs.end());
+    }
+  }
+
+  if (err) {
+    eos_static_err("msg=\"io_uring submission failed\" engine=%s errno=%d "
+                   "failed_requests=%lu", mName.c_str(), err,
+                   (unsigned long) failed.size());
+  }
+
+  // Outside of the submission lock, completing may submit queued requests
+  for (Request* req : failed) {
+    Complete(req, -err);
+  }
+
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Reaper loop of the io_uring backend
+//------------------------------------------------------------------------------
+void
+AsyncIoEngine::RingReap()
+{
+#ifdef EOS_HAVE_IO_URING
+
+  while (true) {
+    unsigned head = *mRing->mCqHead;
+
+    if (head == __atomic_load_n(mRing->mCqTail, __ATOMIC_ACQUIRE)) {
+      if ((sys_io_uring_enter(mRing->mFd, 0, 1, IORING_ENTER_GETEVENTS) < 0) &&
+          (errno != EINTR) && (errno != EAGAIN) && (errno != EBUSY)) {
+        eos_static_crit("msg=\"io_uring wait failed\" engine=%s errno=%d",
+                        mName.c_str(), errno);
+      }
+
+      continue;
+    }
+
+    struct io_uring_cqe* cqe = &mRing->mCqes[head & *mRing->mCqMask];
+    Request* req = reinterpret_cast<Request*>(cqe->user_data);
+    ssize_t result = cqe->res;
+    __atomic_store_n(mRing->mCqHead, head + 1, __ATOMIC_RELEASE);
+
+    if (!req) {
+      // Shutdown marker, all requests have completed already
+      std::lock_guard<std::mutex> lock(mMutex);
+
+      if (mStop) {
+        return;
+      }
+
+      continue;
+    }
+
+    if ((result == -EAGAIN) || (result == -EINTR)) {
+      RingSubmit({req});
+      continue;
+    }
+
+    Complete(req, result);
+  }
+
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Worker loop of the thread pool backend
+//------------------------------------------------------------------------------
+void
+AsyncIoEngine::WorkerLoop()
+{
+  while (true) {
+    Request* req = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCond.wait(lock, [this]() {
+        return mStop || !mQueue.empty();
+      });
+
+      if (mQueue.empty()) {
+        return;
+      }
+
+      req = mQueue.front();
+      mQueue.pop_front();
+      ++mInFlight;
+    }
+    ssize_t result;
+
+    do {
+      if (req->mWrite) {
+        result = pwrite(req->mFd, req->mIov.iov_base, req->mIov.iov_len,
+                        req->mOffset);
+      } else {
+        result = pread(req->mFd, req->mIov.iov_base, req->mIov.iov_len,
+                       req->mOffset);
+      }
+    } while ((result < 0) && (errno == EINTR));
+
+    Complete(req, (result < 0) ? -errno : result);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the statistics
+//------------------------------------------------------------------------------
+AsyncIoEngine::Stats
+AsyncIoEngine::GetStats() const
+{
+  Stats stats;
+  stats.mName = mName;
+  stats.mBackend = mBackend;
+  stats.mDepth = mDepth;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    stats.mInFlight = mInFlight;
+    stats.mQueued = mQueue.size();
+  }
+  stats.mSubmitted = mSubmitted.load();
+  stats.mCompleted = mCompleted.load();
+  stats.mLatencyP50 = mLatency.GetPercentile(0.5);
+  stats.mLatencyP99 = mLatency.GetPercentile(0.99);
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+// Get the statistics as a "key=value" string
+//------------------------------------------------------------------------------
+std::string
+AsyncIoEngine::GetInfo() const
+{
+  Stats stats = GetStats();
+  std::ostringstream oss;
+  oss << "engine=" << stats.mName
+      << " backend=" << ((stats.mBackend == Backend::IoUring) ? "io_uring" :
+                         "threads")
+      << " depth=" << stats.mDepth
+      << " inflight=" << stats.mInFlight
+      << " queued=" << stats.mQueued
+      << " submitted=" << stats.mSubmitted
+      << " completed=" << stats.mCompleted
+      << " latency.p50=" << stats.mLatencyP50 / 1000 << "us"
+      << " latency.p99=" << stats.mLatencyP99 / 1000 << "us";
+  return oss.str();
+}
+
+EOSFSTNAMESPACE_END
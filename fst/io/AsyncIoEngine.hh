@@ -0,0 +1,218 @@
+//------------------------------------------------------------------------------
+//! @file AsyncIoEngine.hh
+//! @brief Per-disk asynchronous pread/pwrite engine based on io_uring with a
+//!        thread pool fallback
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSFST_ASYNCIOENGINE_HH__
+#define __EOSFST_ASYNCIOENGINE_HH__
+
+#include "fst/Namespace.hh"
+#include "common/RWMutexProfiler.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class AsyncIoEngine
+//!
+//! @description Executes positional reads and writes for all the files of one
+//! disk without blocking the submitter. At most "depth" requests are handed
+//! to the kernel at any time, the rest wait in FIFO order, so the queue depth
+//! seen by the device is bounded independently of the number of clients.
+//!
+//! The io_uring backend uses one ring and a single reaper thread per engine.
+//! When io_uring is not available (old kernel, seccomp) the engine falls back
+//! to "depth" threads doing pread/pwrite. In both cases the callbacks run on
+//! an engine thread and must not block.
+//------------------------------------------------------------------------------
+class AsyncIoEngine
+{
+public:
+  //! Backend executing the requests
+  enum class Backend {
+    IoUring,
+    Threads
+  };
+
+  //! Completion callback, receives the number of bytes or -errno
+  using Callback = std::function<void(ssize_t)>;
+
+  //! Statistics of an engine
+  struct Stats {
+    std::string mName; ///< Engine name
+    Backend mBackend = Backend::Threads; ///< Backend in use
+    unsigned int mDepth = 0; ///< Maximum number of requests in flight
+    uint64_t mInFlight = 0; ///< Requests handed to the kernel
+    uint64_t mQueued = 0; ///< Requests waiting for a free slot
+    uint64_t mSubmitted = 0; ///< Requests submitted since start
+    uint64_t mCompleted = 0; ///< Requests completed since start
+    uint64_t mLatencyP50 = 0; ///< Median completion latency in ns
+    uint64_t mLatencyP99 = 0; ///< 99th percentile of the latency in ns
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param name engine name, used for the thread names
+  //! @param depth maximum number of requests in flight, at least 1
+  //! @param use_uring if false always use the thread pool backend
+  //----------------------------------------------------------------------------
+  AsyncIoEngine(const std::string& name, unsigned int depth,
+                bool use_uring = true);
+
+  //----------------------------------------------------------------------------
+  //! Destructor - waits for all the submitted requests to complete
+  //----------------------------------------------------------------------------
+  ~AsyncIoEngine();
+
+  //----------------------------------------------------------------------------
+  //! Submit a positional read
+  //!
+  //! @param fd file descriptor, must stay open until the callback ran
+  //! @param buffer destination buffer
+  //! @param length number of bytes to read
+  //! @param offset file offset
+  //! @param cb completion callback
+  //----------------------------------------------------------------------------
+  void Read(int fd, void* buffer, size_t length, off_t offset, Callback cb);
+
+  //----------------------------------------------------------------------------
+  //! Submit a positional write, same semantics as Read
+  //----------------------------------------------------------------------------
+  void Write(int fd, const void* buffer, size_t length, off_t offset,
+             Callback cb);
+
+  //----------------------------------------------------------------------------
+  //! Get the backend in use
+  //----------------------------------------------------------------------------
+  inline Backend GetBackend() const
+  {
+    return mBackend;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the maximum number of requests in flight
+  //----------------------------------------------------------------------------
+  inline unsigned int GetDepth() const
+  {
+    return mDepth;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the statistics
+  //----------------------------------------------------------------------------
+  Stats GetStats() const;
+
+  //----------------------------------------------------------------------------
+  //! Get the statistics as a "key=value" string
+  //----------------------------------------------------------------------------
+  std::string GetInfo() const;
+
+  //----------------------------------------------------------------------------
+  //! Check if io_uring can be used on this machine
+  //----------------------------------------------------------------------------
+  static bool IoUringAvailable();
+
+  // Disable copy/move constructors and assignment operators
+  AsyncIoEngine(const AsyncIoEngine&) = delete;
+  AsyncIoEngine(AsyncIoEngine&&) = delete;
+  AsyncIoEngine& operator=(const AsyncIoEngine&) = delete;
+  AsyncIoEngine& operator=(AsyncIoEngine&&) = delete;
+
+private:
+  using Clock = std::chrono::steady_clock;
+  struct Ring;
+
+  //! Queued or in-flight request
+  struct Request {
+    int mFd; ///< File descriptor
+    bool mWrite; ///< True for writes
+    struct iovec mIov; ///< Buffer, the io_uring backend uses vectored ops
+    off_t mOffset; ///< File offset
+    Callback mCallback; ///< Completion callback
+    Clock::time_point mSubmitted; ///< Submission time
+  };
+
+  //----------------------------------------------------------------------------
+  //! Queue a request and hand it to the backend if a slot is free
+  //----------------------------------------------------------------------------
+  void Submit(Request* req);
+
+  //----------------------------------------------------------------------------
+  //! Account for a completed request, run its callback and free its slot
+  //!
+  //! @param req completed request, deleted by this method
+  //! @param result number of bytes or -errno
+  //----------------------------------------------------------------------------
+  void Complete(Request* req, ssize_t result);
+
+  //----------------------------------------------------------------------------
+  //! Set up the io_uring backend
+  //!
+  //! @return true if successful
+  //----------------------------------------------------------------------------
+  bool SetupRing();
+
+  //----------------------------------------------------------------------------
+  //! Put requests on the submission ring and notify the kernel
+  //----------------------------------------------------------------------------
+  void RingSubmit(const std::vector<Request*>& reqs);
+
+  //----------------------------------------------------------------------------
+  //! Reaper loop of the io_uring backend
+  //----------------------------------------------------------------------------
+  void RingReap();
+
+  //----------------------------------------------------------------------------
+  //! Worker loop of the thread pool backend
+  //----------------------------------------------------------------------------
+  void WorkerLoop();
+
+  std::string mName; ///< Engine name
+  unsigned int mDepth; ///< Maximum number of requests in flight
+  Backend mBackend; ///< Backend in use
+  Ring* mRing; ///< io_uring state, null for the thread pool backend
+  mutable std::mutex mMutex; ///< Protects the queue and the counters below
+  std::condition_variable mCond; ///< Signals new requests and completions
+  std::deque<Request*> mQueue; ///< Requests waiting for a slot
+  uint64_t mInFlight; ///< Requests handed to the backend
+  bool mStop; ///< Set when shutting down
+  std::vector<std::thread> mThreads; ///< Reaper or worker threads
+  std::atomic<uint64_t> mSubmitted; ///< Requests submitted since start
+  std::atomic<uint64_t> mCompleted; ///< Requests completed since start
+  eos::common::LatencyHistogram mLatency; ///< Submission to completion time
+};
+
+EOSFSTNAMESPACE_END
+
+#endif
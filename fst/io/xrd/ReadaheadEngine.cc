@@ -0,0 +1,569 @@
+//------------------------------------------------------------------------------
+// File: ReadaheadEngine.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/io/xrd/ReadaheadEngine.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+EOSFSTNAMESPACE_BEGIN
+
+namespace
+{
+//! Counters summed over all the engines of the process
+struct GlobalCounters {
+  std::atomic<uint64_t> mHits {0};
+  std::atomic<uint64_t> mLateHits {0};
+  std::atomic<uint64_t> mMisses {0};
+  std::atomic<uint64_t> mWasted {0};
+  std::atomic<uint64_t> mPrefetched {0};
+  std::atomic<uint64_t> mPrefetchedBytes {0};
+  std::atomic<uint64_t> mStreams {0};
+} sGlobal;
+}
+
+//------------------------------------------------------------------------------
+//! Buffers of the blocks dropped by an engine, kept for the next requests.
+//! Shared with the blocks, which return their buffer when destroyed even if
+//! a slice kept them alive beyond the engine.
+//------------------------------------------------------------------------------
+class ReadaheadEngine::BufferPool
+{
+public:
+  BufferPool(uint32_t size, uint32_t max): mSize(size), mMax(max) {}
+
+  std::unique_ptr<char[]> Get()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mFree.empty()) {
+      return std::unique_ptr<char[]>(new char[mSize]);
+    }
+
+    std::unique_ptr<char[]> buffer = std::move(mFree.back());
+    mFree.pop_back();
+    return buffer;
+  }
+
+  void Put(std::unique_ptr<char[]> buffer)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (buffer && (mFree.size() < mMax)) {
+      mFree.push_back(std::move(buffer));
+    }
+  }
+
+private:
+  std::mutex mMutex;
+  const uint32_t mSize;
+  const uint32_t mMax;
+  std::vector<std::unique_ptr<char[]>> mFree;
+};
+
+//------------------------------------------------------------------------------
+// Block constructor
+//------------------------------------------------------------------------------
+ReadaheadEngine::Block::Block(std::shared_ptr<BufferPool> pool):
+  mPool(std::move(pool)), mBuffer(mPool->Get())
+{}
+
+//------------------------------------------------------------------------------
+// Block destructor
+//------------------------------------------------------------------------------
+ReadaheadEngine::Block::~Block()
+{
+  mPool->Put(std::move(mBuffer));
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ReadaheadEngine::ReadaheadEngine(const Config& config, Fetcher fetcher):
+  mConfig(config), mFetcher(std::move(fetcher)), mEnabled(true),
+  mPool(std::make_shared<BufferPool>(config.mBlockSize, config.mMaxBlocks)),
+  mNextStreamId(1), mClock(0), mInFlight(0),
+  mEnd(std::numeric_limits<uint64_t>::max())
+{}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+ReadaheadEngine::~ReadaheadEngine()
+{
+  Drain();
+}
+
+//------------------------------------------------------------------------------
+// Copy out a read from the prefetched blocks
+//------------------------------------------------------------------------------
+ReadaheadEngine::Result
+ReadaheadEngine::Read(uint64_t offset, char* buffer, uint32_t length)
+{
+  Result result;
+
+  if (!mEnabled) {
+    return result;
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  uint64_t id = MatchStream(offset).mId;
+  uint64_t pos = offset;
+  uint32_t left = length;
+
+  while (left && !result.mEof) {
+    Slice slice;
+
+    if (!ServeBlock(lock, pos, left, slice, result)) {
+      break;
+    }
+
+    // the slice pins the buffer, copy without blocking the completions
+    uint32_t n = slice.mLength;
+    lock.unlock();
+    memcpy(buffer + (pos - offset), slice.mData, n);
+    slice = Slice();
+    lock.lock();
+    pos += n;
+    left -= n;
+    result.mBytes += n;
+  }
+
+  Stream* stream = FindStream(id);
+
+  if (stream) {
+    Advance(*stream, offset, length);
+    Prefetch(*stream);
+  }
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+// Get the data at offset without copy
+//------------------------------------------------------------------------------
+ReadaheadEngine::Result
+ReadaheadEngine::Get(uint64_t offset, uint32_t length, Slice& slice)
+{
+  Result result;
+  slice = Slice();
+
+  if (!mEnabled) {
+    return result;
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  uint64_t id = MatchStream(offset).mId;
+
+  if (ServeBlock(lock, offset, length, slice, result)) {
+    result.mBytes = slice.mLength;
+  }
+
+  Stream* stream = FindStream(id);
+
+  if (stream) {
+    Advance(*stream, offset, length);
+    Prefetch(*stream);
+  }
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+// Wait for the requests in flight and drop everything
+//------------------------------------------------------------------------------
+void
+ReadaheadEngine::Drain()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mCv.wait(lock, [&]() {
+    return mInFlight == 0;
+  });
+
+  while (!mBlocks.empty()) {
+    Drop(mBlocks.begin());
+  }
+
+  mStreams.clear();
+}
+
+//------------------------------------------------------------------------------
+// Get the counters of the engine
+//------------------------------------------------------------------------------
+ReadaheadEngine::Stats
+ReadaheadEngine::GetStats()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mStats;
+}
+
+//------------------------------------------------------------------------------
+// Get the counters summed over all the engines
+//------------------------------------------------------------------------------
+ReadaheadEngine::Stats
+ReadaheadEngine::GetGlobalStats()
+{
+  Stats stats;
+  stats.mHits = sGlobal.mHits;
+  stats.mLateHits = sGlobal.mLateHits;
+  stats.mMisses = sGlobal.mMisses;
+  stats.mWasted = sGlobal.mWasted;
+  stats.mPrefetched = sGlobal.mPrefetched;
+  stats.mPrefetchedBytes = sGlobal.mPrefetchedBytes;
+  stats.mStreams = sGlobal.mStreams;
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+// Get the window of the stream whose cursor is at offset
+//------------------------------------------------------------------------------
+uint32_t
+ReadaheadEngine::GetWindow(uint64_t offset)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (const auto& stream : mStreams) {
+    if (stream.mNext == offset) {
+      return stream.mWindow;
+    }
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Find or open the stream of a read
+//------------------------------------------------------------------------------
+ReadaheadEngine::Stream&
+ReadaheadEngine::MatchStream(uint64_t offset)
+{
+  const uint64_t bs = mConfig.mBlockSize;
+  Stream* best = nullptr;
+  uint64_t distance = 0;
+  ++mClock;
+
+  // a read continues a confirmed stream if it starts at most one block before
+  // its cursor or inside the blocks prefetched ahead of it, an unconfirmed
+  // stream only if it starts exactly at its cursor
+  for (auto& stream : mStreams) {
+    uint64_t ahead = bs * std::max<uint32_t>(1, stream.mWindow);
+    bool match = stream.mSequential ?
+                 ((offset + bs >= stream.mNext) &&
+                  (offset <= stream.mNext + ahead)) :
+                 (offset == stream.mNext);
+
+    if (match) {
+      uint64_t d = (offset > stream.mNext) ? (offset - stream.mNext) :
+                   (stream.mNext - offset);
+
+      if (!best || (d < distance)) {
+        best = &stream;
+        distance = d;
+      }
+    }
+  }
+
+  if (best) {
+    best->mSequential++;
+    best->mLastUse = mClock;
+    return *best;
+  }
+
+  if (mStreams.size() >= mConfig.mMaxStreams) {
+    // replace the least recently used stream, its blocks get reclaimed
+    auto lru = std::min_element(mStreams.begin(), mStreams.end(),
+    [](const Stream & a, const Stream & b) {
+      return a.mLastUse < b.mLastUse;
+    });
+    mStreams.erase(lru);
+  }
+
+  Stream stream;
+  stream.mId = mNextStreamId++;
+  stream.mNext = offset;
+  stream.mLastUse = mClock;
+  stream.mWindow = std::max<uint32_t>(1, mConfig.mMinWindow);
+  stream.mSequential = 0;
+  stream.mBytes = 0;
+  stream.mStart = std::chrono::steady_clock::now();
+  mStreams.push_back(stream);
+  mStats.mStreams++;
+  sGlobal.mStreams++;
+  return mStreams.back();
+}
+
+//------------------------------------------------------------------------------
+// Serve one block of a read
+//------------------------------------------------------------------------------
+bool
+ReadaheadEngine::ServeBlock(std::unique_lock<std::mutex>& lock,
+                            uint64_t offset, uint32_t length, Slice& slice,
+                            Result& result)
+{
+  auto it = mBlocks.find(Align(offset));
+
+  if (it == mBlocks.end()) {
+    mStats.mMisses++;
+    sGlobal.mMisses++;
+    return false;
+  }
+
+  std::shared_ptr<Block> block = it->second;
+
+  if (block->mState == Block::State::InFlight) {
+    mCv.wait(lock, [&]() {
+      return block->mState != Block::State::InFlight;
+    });
+
+    if (!block->mUsed) {
+      mStats.mLateHits++;
+      sGlobal.mLateHits++;
+      // the window did not cover the round trip time
+      Stream* stream = FindStream(block->mStream);
+
+      if (stream && mConfig.mAdaptive) {
+        stream->mWindow = std::min(mConfig.mMaxWindow, stream->mWindow * 2);
+      }
+    }
+  } else if (!block->mUsed) {
+    mStats.mHits++;
+    sGlobal.mHits++;
+  }
+
+  block->mUsed = true;
+
+  if (block->mState == Block::State::Failed) {
+    mEnabled = false;
+    result.mError = true;
+    return false;
+  }
+
+  uint64_t shift = offset - block->mOffset;
+
+  if (shift >= block->mLength) {
+    // a short block marks the end of the file
+    result.mEof = (block->mLength < mConfig.mBlockSize);
+    return false;
+  }
+
+  uint32_t n = std::min<uint64_t>(length, block->mLength - shift);
+  slice.mBlock = block;
+  slice.mData = block->mBuffer.get() + shift;
+  slice.mLength = n;
+
+  if (shift + n == block->mLength) {
+    // consumed up to its end, nobody will come back to it
+    if ((n < length) && (block->mLength < mConfig.mBlockSize)) {
+      result.mEof = true;
+    }
+
+    auto cur = mBlocks.find(block->mOffset);
+
+    if ((cur != mBlocks.end()) && (cur->second == block)) {
+      Drop(cur);
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Advance a stream past a read and adapt its window
+//------------------------------------------------------------------------------
+void
+ReadaheadEngine::Advance(Stream& stream, uint64_t offset, uint64_t length)
+{
+  stream.mNext = std::max(stream.mNext, offset + length);
+  stream.mBytes += length;
+
+  if (!mConfig.mAdaptive || (mStats.mRttMs <= 0)) {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed = now - stream.mStart;
+
+  if (elapsed.count() < 0.01) {
+    return;
+  }
+
+  // blocks consumed by the stream during one round trip
+  double rate = stream.mBytes / elapsed.count();
+  uint32_t target = static_cast<uint32_t>(std::ceil(mStats.mRttMs / 1000.0 *
+                                          rate / mConfig.mBlockSize)) + 1;
+  target = std::min(std::max(target, mConfig.mMinWindow), mConfig.mMaxWindow);
+
+  if (target > stream.mWindow) {
+    stream.mWindow = target;
+  } else if (stream.mWindow > 2 * target) {
+    stream.mWindow--;
+  }
+
+  if (elapsed.count() > 1) {
+    // follow changes of the consumption rate
+    stream.mStart = now;
+    stream.mBytes = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Issue the missing prefetch requests of a stream window
+//------------------------------------------------------------------------------
+void
+ReadaheadEngine::Prefetch(Stream& stream)
+{
+  // a stream is confirmed by its second sequential read
+  if (!mEnabled || !stream.mSequential) {
+    return;
+  }
+
+  const uint64_t bs = mConfig.mBlockSize;
+  uint32_t window = mConfig.mAdaptive ? stream.mWindow : mConfig.mMinWindow;
+  // cover window blocks worth of data ahead of the cursor
+  uint64_t last = Align(stream.mNext + window * bs - 1);
+
+  for (uint64_t offset = Align(stream.mNext); offset <= last; offset += bs) {
+    if (offset >= mEnd) {
+      return;
+    }
+
+    if (mBlocks.count(offset)) {
+      continue;
+    }
+
+    if (mBlocks.size() >= mConfig.mMaxBlocks) {
+      Reclaim();
+
+      if (mBlocks.size() >= mConfig.mMaxBlocks) {
+        return;
+      }
+    }
+
+    auto block = std::make_shared<Block>(mPool);
+    block->mOffset = offset;
+    block->mStream = stream.mId;
+    block->mIssued = std::chrono::steady_clock::now();
+    char* buffer = block->mBuffer.get();
+    mBlocks[offset] = block;
+    mInFlight++;
+
+    if (!mFetcher(offset, mConfig.mBlockSize, buffer, [this, block](int64_t nbytes) {
+    Complete(block, nbytes);
+    })) {
+      mBlocks.erase(offset);
+      mInFlight--;
+      return;
+    }
+
+    mStats.mPrefetched++;
+    sGlobal.mPrefetched++;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop the blocks nobody will read anymore
+//------------------------------------------------------------------------------
+void
+ReadaheadEngine::Reclaim()
+{
+  for (auto it = mBlocks.begin(); it != mBlocks.end();) {
+    auto cur = it++;
+    const std::shared_ptr<Block>& block = cur->second;
+
+    if (block->mState == Block::State::InFlight) {
+      continue;
+    }
+
+    Stream* stream = FindStream(block->mStream);
+
+    if ((block->mState == Block::State::Failed) || !stream ||
+        (block->mOffset + mConfig.mBlockSize <= stream->mNext)) {
+      Drop(cur);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop a block
+//------------------------------------------------------------------------------
+void
+ReadaheadEngine::Drop(std::map<uint64_t, std::shared_ptr<Block>>::iterator it)
+{
+  if (!it->second->mUsed) {
+    mStats.mWasted++;
+    sGlobal.mWasted++;
+    Stream* stream = FindStream(it->second->mStream);
+
+    if (stream && mConfig.mAdaptive) {
+      stream->mWindow = std::max(mConfig.mMinWindow, stream->mWindow / 2);
+    }
+  }
+
+  mBlocks.erase(it);
+}
+
+//------------------------------------------------------------------------------
+// Completion of a prefetch request
+//------------------------------------------------------------------------------
+void
+ReadaheadEngine::Complete(const std::shared_ptr<Block>& block, int64_t nbytes)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  std::chrono::duration<double, std::milli> rtt =
+    std::chrono::steady_clock::now() - block->mIssued;
+
+  if (nbytes >= 0) {
+    block->mLength = static_cast<uint32_t>(nbytes);
+    block->mState = Block::State::Done;
+
+    if (block->mLength < mConfig.mBlockSize) {
+      mEnd = std::min(mEnd, block->mOffset + block->mLength);
+    }
+    mStats.mPrefetchedBytes += nbytes;
+    sGlobal.mPrefetchedBytes += nbytes;
+  } else {
+    block->mState = Block::State::Failed;
+  }
+
+  mStats.mRttMs = (mStats.mRttMs > 0) ?
+                  (0.875 * mStats.mRttMs + 0.125 * rtt.count()) : rtt.count();
+  mInFlight--;
+  mCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Get the stream with the given id
+//------------------------------------------------------------------------------
+ReadaheadEngine::Stream*
+ReadaheadEngine::FindStream(uint64_t id)
+{
+  for (auto& stream : mStreams) {
+    if (stream.mId == id) {
+      return &stream;
+    }
+  }
+
+  return nullptr;
+}
+
+EOSFSTNAMESPACE_END
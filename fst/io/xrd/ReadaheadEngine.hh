@@ -0,0 +1,276 @@
+//------------------------------------------------------------------------------
+// File: ReadaheadEngine.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSFST_READAHEADENGINE_HH__
+#define __EOSFST_READAHEADENGINE_HH__
+
+#include "fst/Namespace.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class ReadaheadEngine
+//!
+//! @description Adaptive prefetching of the blocks of one remote file. The
+//! engine follows several interleaved sequential cursors (streams) per file:
+//! a read continuing close to where a stream stopped advances that stream,
+//! any other read opens a new one, replacing the least recently used stream
+//! once the maximum is reached. A stream starts prefetching once a second
+//! read exactly contiguous to the first one confirms it.
+//!
+//! Every stream keeps a window of blocks requested ahead of its cursor. The
+//! window doubles whenever a read has to wait for a block still in flight,
+//! is raised to the bandwidth-delay product of the stream (observed round
+//! trip time times consumption rate), is halved whenever a prefetched block
+//! is dropped unread and slowly decays while it is larger than needed. All
+//! streams share a fixed budget of buffers.
+//!
+//! The remote reads are issued through a fetcher so the engine does not
+//! depend on the transport. Completed blocks can be handed over to the
+//! caller without copy as slices pinning the buffer.
+//------------------------------------------------------------------------------
+class ReadaheadEngine
+{
+public:
+  //! Completion callback, receives the number of bytes read or -errno
+  using Callback = std::function<void(int64_t)>;
+
+  //! Issue an asynchronous read of length bytes at offset into buffer and
+  //! call done on completion, from another thread. Returns false if the
+  //! request could not be sent, in which case done is never called.
+  using Fetcher = std::function<bool(uint64_t offset, uint32_t length,
+                                     char* buffer, Callback done)>;
+
+  //! Engine configuration
+  struct Config {
+    uint32_t mBlockSize = 1024 * 1024; ///< Size of a prefetched block
+    uint32_t mMaxBlocks = 16; ///< Buffers shared by all the streams
+    uint32_t mMaxStreams = 4; ///< Sequential cursors followed per file
+    uint32_t mMinWindow = 1; ///< Minimum number of blocks ahead of a cursor
+    uint32_t mMaxWindow = 8; ///< Maximum number of blocks ahead of a cursor
+    bool mAdaptive = true; ///< Adapt the window, otherwise keep mMinWindow
+  };
+
+  //! Counters of an engine
+  struct Stats {
+    uint64_t mHits = 0; ///< Blocks read which were already complete
+    uint64_t mLateHits = 0; ///< Blocks read which were still in flight
+    uint64_t mMisses = 0; ///< Reads of blocks which were not prefetched
+    uint64_t mWasted = 0; ///< Prefetched blocks dropped unread
+    uint64_t mPrefetched = 0; ///< Prefetch requests sent
+    uint64_t mPrefetchedBytes = 0; ///< Bytes received by prefetch requests
+    uint64_t mStreams = 0; ///< Streams opened
+    double mRttMs = 0; ///< Average round trip time of the prefetch requests
+  };
+
+  //! Outcome of a read served by the engine
+  struct Result {
+    int64_t mBytes = 0; ///< Bytes served from prefetched blocks
+    bool mEof = false; ///< End of file reached, nothing more to read
+    bool mError = false; ///< A prefetch failed, the engine is disabled
+  };
+
+  class BufferPool;
+  struct Block;
+
+  //! Zero-copy view of the data of a completed block, the buffer stays valid
+  //! as long as the slice exists
+  struct Slice {
+    std::shared_ptr<const Block> mBlock; ///< Block owning the data
+    const char* mData = nullptr; ///< First byte
+    uint32_t mLength = 0; ///< Number of bytes
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param config engine configuration
+  //! @param fetcher issues the remote reads
+  //----------------------------------------------------------------------------
+  ReadaheadEngine(const Config& config, Fetcher fetcher);
+
+  //----------------------------------------------------------------------------
+  //! Destructor, waits for the requests in flight
+  //----------------------------------------------------------------------------
+  ~ReadaheadEngine();
+
+  //----------------------------------------------------------------------------
+  //! Copy out as much as possible of a read from the prefetched blocks and
+  //! prefetch ahead of the stream of the read. The caller reads the rest
+  //! directly, unless the end of file was reached.
+  //!
+  //! @param offset file offset
+  //! @param buffer destination
+  //! @param length number of bytes
+  //----------------------------------------------------------------------------
+  Result Read(uint64_t offset, char* buffer, uint32_t length);
+
+  //----------------------------------------------------------------------------
+  //! Get the data at offset without copy, at most up to the end of its block,
+  //! and prefetch ahead of the stream of the read
+  //!
+  //! @param offset file offset
+  //! @param length maximum number of bytes
+  //! @param slice filled with the data, empty on miss, error or end of file
+  //!
+  //! @return outcome, mBytes being the length of the slice
+  //----------------------------------------------------------------------------
+  Result Get(uint64_t offset, uint32_t length, Slice& slice);
+
+  //----------------------------------------------------------------------------
+  //! Wait for the requests in flight and drop all blocks and streams
+  //----------------------------------------------------------------------------
+  void Drain();
+
+  //----------------------------------------------------------------------------
+  //! Check if the engine is enabled, a failed prefetch disables it
+  //----------------------------------------------------------------------------
+  bool IsEnabled() const
+  {
+    return mEnabled.load();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the counters of the engine
+  //----------------------------------------------------------------------------
+  Stats GetStats();
+
+  //----------------------------------------------------------------------------
+  //! Get the counters summed over all the engines of the process
+  //----------------------------------------------------------------------------
+  static Stats GetGlobalStats();
+
+  //----------------------------------------------------------------------------
+  //! Get the current window of the stream whose cursor is at offset, 0 if no
+  //! such stream
+  //----------------------------------------------------------------------------
+  uint32_t GetWindow(uint64_t offset);
+
+  //! Prefetched block
+  struct Block {
+    enum class State {
+      InFlight,
+      Done,
+      Failed
+    };
+
+    Block(std::shared_ptr<BufferPool> pool);
+    ~Block();
+
+    std::shared_ptr<BufferPool> mPool; ///< Pool the buffer returns to
+    std::unique_ptr<char[]> mBuffer; ///< Data
+    uint64_t mOffset = 0; ///< File offset of the first byte
+    uint32_t mLength = 0; ///< Bytes received
+    State mState = State::InFlight; ///< Request state
+    uint64_t mStream = 0; ///< Stream which requested the block
+    bool mUsed = false; ///< Block was read at least once
+    std::chrono::steady_clock::time_point mIssued; ///< Request time
+  };
+
+private:
+  //! Sequential cursor
+  struct Stream {
+    uint64_t mId; ///< Stream id
+    uint64_t mNext; ///< Offset following the last read
+    uint64_t mLastUse; ///< Logical time of the last read
+    uint32_t mWindow; ///< Blocks prefetched ahead of the cursor
+    uint32_t mSequential; ///< Consecutive sequential reads
+    uint64_t mBytes; ///< Bytes read since mStart
+    std::chrono::steady_clock::time_point mStart; ///< Start of the rate window
+  };
+
+  //----------------------------------------------------------------------------
+  //! Find or open the stream of a read, lock held
+  //----------------------------------------------------------------------------
+  Stream& MatchStream(uint64_t offset);
+
+  //----------------------------------------------------------------------------
+  //! Serve one block of a read, lock held
+  //!
+  //! @return false if the read can not go on from the prefetched blocks
+  //----------------------------------------------------------------------------
+  bool ServeBlock(std::unique_lock<std::mutex>& lock, uint64_t offset,
+                  uint32_t length, Slice& slice, Result& result);
+
+  //----------------------------------------------------------------------------
+  //! Advance a stream past a read and adapt its window, lock held
+  //----------------------------------------------------------------------------
+  void Advance(Stream& stream, uint64_t offset, uint64_t length);
+
+  //----------------------------------------------------------------------------
+  //! Issue the missing prefetch requests of a stream window, lock held
+  //----------------------------------------------------------------------------
+  void Prefetch(Stream& stream);
+
+  //----------------------------------------------------------------------------
+  //! Drop the blocks behind their stream cursor or of closed streams to make
+  //! room for new requests, lock held
+  //----------------------------------------------------------------------------
+  void Reclaim();
+
+  //----------------------------------------------------------------------------
+  //! Drop a block, counting it as wasted if never read, lock held
+  //----------------------------------------------------------------------------
+  void Drop(std::map<uint64_t, std::shared_ptr<Block>>::iterator it);
+
+  //----------------------------------------------------------------------------
+  //! Completion of a prefetch request
+  //----------------------------------------------------------------------------
+  void Complete(const std::shared_ptr<Block>& block, int64_t nbytes);
+
+  //----------------------------------------------------------------------------
+  //! Get the stream with the given id, nullptr if closed, lock held
+  //----------------------------------------------------------------------------
+  Stream* FindStream(uint64_t id);
+
+  inline uint64_t Align(uint64_t offset) const
+  {
+    return offset - (offset % mConfig.mBlockSize);
+  }
+
+  const Config mConfig; ///< Configuration
+  Fetcher mFetcher; ///< Issues the remote reads
+  std::atomic<bool> mEnabled; ///< Cleared by a failed prefetch
+  std::mutex mMutex; ///< Protects all the members below
+  std::condition_variable mCv; ///< Signals completions
+  std::map<uint64_t, std::shared_ptr<Block>> mBlocks; ///< Blocks by offset
+  std::vector<Stream> mStreams; ///< Active streams
+  std::shared_ptr<BufferPool> mPool; ///< Recycled buffers
+  uint64_t mNextStreamId; ///< Id of the next stream
+  uint64_t mClock; ///< Logical time, incremented by every read
+  uint32_t mInFlight; ///< Prefetch requests in flight
+  uint64_t mEnd; ///< End of file once a short block was received
+  Stats mStats; ///< Counters
+};
+
+EOSFSTNAMESPACE_END
+
+#endif
@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <cstdlib>
+#include <algorithm>
 #include "fst/io/xrd/XrdIo.hh"
 #include "fst/io/ChunkHandler.hh"
 #include "fst/io/VectChunkHandler.hh"
@@ -60,6 +61,42 @@ std::string getAttrUrl(std::string path)
   path += ".xattr";
   return path;
 }
+
+//------------------------------------------------------------------------------
+//! Handler of a prefetch request, forwards the outcome to the readahead
+//! engine and deletes itself
+//------------------------------------------------------------------------------
+class ReadaheadHandler: public XrdCl::ResponseHandler
+{
+public:
+  ReadaheadHandler(ReadaheadEngine::Callback done): mDone(std::move(done)) {}
+
+  virtual void HandleResponse(XrdCl::XRootDStatus* status,
+                              XrdCl::AnyObject* response)
+  {
+    int64_t nbytes = -EIO;
+
+    if (status && status->IsOK()) {
+      XrdCl::ChunkInfo* chunk = 0;
+
+      if (response) {
+        response->Get(chunk);
+      }
+
+      nbytes = (chunk ? chunk->length : 0);
+    } else if (status && status->errNo) {
+      nbytes = -static_cast<int64_t>(status->errNo);
+    }
+
+    delete status;
+    delete response;
+    mDone(nbytes);
+    delete this;
+  }
+
+private:
+  ReadaheadEngine::Callback mDone;
+};
 }
 
 //------------------------------------------------------------------------------
@@ -97,10 +134,12 @@ XrdIo::XrdIo(std::string path) :
   FileIo(path, "XrdIo"),
   mDoReadahead(false),
   mNumRdAheadBlocks(InitNumRdAheadBlocks()),
+  mNumRdAheadStreams(InitNumRdAheadStreams()),
   mDefaultBlocksize(InitBlocksize()),
   mBlocksize(mDefaultBlocksize),
   mXrdFile(NULL),
   mMetaHandler(new AsyncMetaHandler()),
+  mReadaheadTimeout(0),
   mXrdIdHelper(nullptr)
 {
   // Set the TimeoutResolution to 1
@@ -131,15 +170,18 @@ XrdIo::~XrdIo()
     fileClose();
   }
 
-  while (!mQueueBlocks.empty()) {
-    ReadaheadBlock* ptr_readblock = mQueueBlocks.front();
-    mQueueBlocks.pop();
-    delete ptr_readblock;
-  }
-
-  while (!mMapBlocks.empty()) {
-    delete mMapBlocks.begin()->second;
-    mMapBlocks.erase(mMapBlocks.begin());
+  if (mReadahead) {
+    ReadaheadEngine::Stats stats = mReadahead->GetStats();
+    eos_debug("msg=\"readahead stats\" hits=%llu late_hits=%llu misses=%llu "
+              "wasted=%llu prefetched=%llu streams=%llu rtt_ms=%.02f",
+              (unsigned long long) stats.mHits,
+              (unsigned long long) stats.mLateHits,
+              (unsigned long long) stats.mMisses,
+              (unsigned long long) stats.mWasted,
+              (unsigned long long) stats.mPrefetched,
+              (unsigned long long) stats.mStreams, stats.mRttMs);
+    // the prefetch requests in flight reference the file object
+    mReadahead.reset();
   }
 
   delete mMetaHandler;
@@ -188,9 +230,7 @@ XrdIo::fileOpen(XrdSfsFileOpenMode flags,
       mBlocksize = static_cast<uint64_t>(atoll(val));
     }
 
-    for (unsigned int i = 0; i < mNumRdAheadBlocks; i++) {
-      mQueueBlocks.push(new ReadaheadBlock(mBlocksize));
-    }
+    EnableReadahead();
   }
 
   // Final path + opaque info used in the open
@@ -277,9 +317,7 @@ XrdIo::fileOpenAsync(void* io_handler,
       mBlocksize = static_cast<uint64_t>(atoll(val));
     }
 
-    for (unsigned int i = 0; i < mNumRdAheadBlocks; i++) {
-      mQueueBlocks.push(new ReadaheadBlock(mBlocksize));
-    }
+    EnableReadahead();
   }
 
   request = mFilePath;
@@ -378,7 +416,7 @@ XrdIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
   XrdCl::XRootDStatus status;
   ChunkHandler* handler = NULL;
 
-  if (!mDoReadahead) {
+  if (!mDoReadahead || !mReadahead) {
     readahead = false;
     eos_debug("Readahead is disabled");
   }
@@ -410,104 +448,19 @@ XrdIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
     nread = length;
   } else {
     eos_debug("readahead enabled, request offset=%lli, length=%i", offset, length);
-    uint64_t read_length = 0;
-    uint32_t aligned_length;
-    uint32_t shift;
-    std::map<uint64_t, ReadaheadBlock*>::iterator iter;
-    mPrefetchMutex.Lock(); // -->
-
-    while (length) {
-      iter = FindBlock(offset);
-
-      if (iter != mMapBlocks.end()) {
-        // Block found in prefetched blocks
-        SimpleHandler* sh = iter->second->handler;
-        shift = offset - iter->first;
-
-        // We can prefetch another block if we still have available blocks in
-        // the queue or if first read was from second prefetched block
-        if (!mQueueBlocks.empty() || (iter != mMapBlocks.begin())) {
-          if (iter != mMapBlocks.begin()) {
-            eos_debug("recycle the oldest block");
-            mQueueBlocks.push(mMapBlocks.begin()->second);
-            mMapBlocks.erase(mMapBlocks.begin());
-          }
-
-          eos_debug("prefetch new block(2)");
-
-          if (!PrefetchBlock(offset + mBlocksize, false, timeout)) {
-            eos_warning("failed to send prefetch request(2)");
-            break;
-          }
-        }
-
-        if (sh->WaitOK()) {
-          eos_debug("block in cache, blk_off=%lld, req_off= %lld", iter->first, offset);
-
-          if (sh->GetRespLength() <= 0) {
-            // The request got a response but it read 0 bytes
-            eos_debug("response contains 0 bytes");
-            done_read = true;
-            nread = sh->GetRespLength();
-            break;
-          }
-
-          aligned_length = sh->GetRespLength() - shift;
-          read_length = ((uint32_t) length < aligned_length) ? length : aligned_length;
-
-          // If prefetch block smaller than mBlocksize and current offset at end
-          // of the prefetch block then we reached the end of file
-          if ((sh->GetRespLength() != mBlocksize) &&
-              ((uint64_t) offset >= iter->first + sh->GetRespLength())) {
-            done_read = true;
-            break;
-          }
-
-          pBuff = static_cast<char*>(memcpy(pBuff, iter->second->buffer + shift,
-                                            read_length));
-          pBuff += read_length;
-          offset += read_length;
-          length -= read_length;
-          nread += read_length;
-        } else {
-          // Error while prefetching, remove block from map
-          mQueueBlocks.push(iter->second);
-          mMapBlocks.erase(iter);
-          eos_err("error=prefetching failed, disable it and remove block from map");
-          mDoReadahead = false;
-          break;
-        }
-      } else {
-        // Remove all elements from map so that we can align with the new
-        // requests and prefetch a new block. But first we need to collect any
-        // responses which are in-flight as otherwise these response might
-        // arrive later on, when we are expecting replies for other blocks since
-        // we are recycling the SimpleHandler objects.
-        while (!mMapBlocks.empty()) {
-          SimpleHandler* sh = mMapBlocks.begin()->second->handler;
-
-          if (sh->HasRequest()) {
-            // Not interested in the result - discard it
-            sh->WaitOK();
-          }
-
-          mQueueBlocks.push(mMapBlocks.begin()->second);
-          mMapBlocks.erase(mMapBlocks.begin());
-        }
+    mReadaheadTimeout = timeout;
+    ReadaheadEngine::Result res = mReadahead->Read(offset, buffer, length);
 
-        if (!mQueueBlocks.empty()) {
-          eos_debug("prefetch new block(1)");
-
-          if (!PrefetchBlock(offset, false, timeout)) {
-            eos_err("error=failed to send prefetch request(1)");
-            mDoReadahead = false;
-            break;
-          }
-        }
-      }
+    if (res.mError) {
+      eos_err("error=prefetching failed, disable it");
+      mDoReadahead = false;
     }
 
-    mPrefetchMutex.UnLock(); // <--
+    pBuff += res.mBytes;
+    offset += res.mBytes;
+    length -= res.mBytes;
+    nread = res.mBytes;
+    done_read = res.mEof;
 
     // If readahead not useful, use the classic way to read
     if (length && !done_read) {
@@ -534,7 +487,7 @@ XrdIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
         nread = -1;
       } else {
         if (mMetaHandler->WaitOK() == 0) {
-          nread = length;
+          nread += length;
         } else {
           nread = -1;
         }
@@ -545,38 +498,6 @@ XrdIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
   return nread;
 }
 
-//------------------------------------------------------------------------------
-// Try to find a block in cache which contains the required offset
-//------------------------------------------------------------------------------
-PrefetchMap::iterator
-XrdIo::FindBlock(uint64_t offset)
-{
-  if (mMapBlocks.empty()) {
-    return mMapBlocks.end();
-  }
-
-  PrefetchMap::iterator iter = mMapBlocks.lower_bound(offset);
-
-  if ((iter != mMapBlocks.end()) && (iter->first == offset)) {
-    // Found exactly the block needed
-    return iter;
-  } else {
-    if (iter == mMapBlocks.begin()) {
-      // Only blocks with bigger offsets, return pointer to end of the map
-      return mMapBlocks.end();
-    } else {
-      // Check if the previous block, we know the map is not empty
-      iter--;
-
-      if ((iter->first <= offset) && (offset < (iter->first + mBlocksize))) {
-        return iter;
-      } else {
-        return mMapBlocks.end();
-      }
-    }
-  }
-}
-
 //------------------------------------------------------------------------------
 // Vector read - sync
 //------------------------------------------------------------------------------
@@ -730,20 +651,11 @@ int
 XrdIo::fileWaitAsyncIO()
 {
   bool async_ok = true;
-  {
-    XrdSysMutexHelper scope_lock(mPrefetchMutex);
-
-    // Wait for any requests on the fly and then close
-    while (!mMapBlocks.empty()) {
-      SimpleHandler* shandler = mMapBlocks.begin()->second->handler;
-
-      if (shandler->HasRequest()) {
-        async_ok = shandler->WaitOK();
-      }
 
-      delete mMapBlocks.begin()->second;
-      mMapBlocks.erase(mMapBlocks.begin());
-    }
+  // Wait for any prefetch requests on the fly, their failure only disables
+  // the readahead
+  if (mReadahead) {
+    mReadahead->Drain();
   }
 
   // Wait for any async requests before closing
@@ -1004,49 +916,34 @@ void
 XrdIo::CleanReadCache()
 {
   fileWaitAsyncIO();
-
-  if (mQueueBlocks.empty()) {
-    for (unsigned int i = 0; i < mNumRdAheadBlocks; i++) {
-      mQueueBlocks.push(new ReadaheadBlock(mBlocksize));
-    }
-  }
 }
 
 //------------------------------------------------------------------------------
-// Prefetch block using the readahead mechanism
+// Create the readahead engine of the file
 //------------------------------------------------------------------------------
-bool
-XrdIo::PrefetchBlock(int64_t offset, bool isWrite, uint16_t timeout)
+void
+XrdIo::EnableReadahead()
 {
-  bool done = true;
-  XrdCl::XRootDStatus status;
-  ReadaheadBlock* block = NULL;
-  eos_debug("try to prefetch with offset: %lli, length: %lu",
-            offset, mBlocksize);
+  ReadaheadEngine::Config config;
+  config.mBlockSize = mBlocksize;
+  config.mMaxBlocks = std::max(1u, mNumRdAheadBlocks);
+  config.mMaxStreams = std::max(1u, mNumRdAheadStreams);
+  config.mMaxWindow = config.mMaxBlocks;
+  mReadahead.reset(new ReadaheadEngine(config, [this](uint64_t offset,
+                                       uint32_t length, char* buffer,
+  ReadaheadEngine::Callback done) {
+    eos_debug("try to prefetch with offset: %llu, length: %u", offset, length);
+    ReadaheadHandler* handler = new ReadaheadHandler(std::move(done));
+    XrdCl::XRootDStatus status = mXrdFile->Read(offset, length, buffer, handler,
+                                 mReadaheadTimeout.load());
 
-  if (!mQueueBlocks.empty()) {
-    block = mQueueBlocks.front();
-    mQueueBlocks.pop();
-  } else {
-    done = false;
-    return done;
-  }
-
-  block->handler->Update(offset, mBlocksize, isWrite);
-  status = mXrdFile->Read(offset, mBlocksize, block->buffer, block->handler,
-                          timeout);
-
-  if (!status.IsOK()) {
-    // Create tmp status which is deleted in the HandleResponse method
-    XrdCl::XRootDStatus* tmp_status = new XrdCl::XRootDStatus(status);
-    block->handler->HandleResponse(tmp_status, NULL);
-    mQueueBlocks.push(block);
-    done = false;
-  } else {
-    mMapBlocks.insert(std::make_pair(offset, block));
-  }
+    if (!status.IsOK()) {
+      delete handler;
+      return false;
+    }
 
-  return done;
+    return true;
+  }));
 }
 
 //------------------------------------------------------------------------------
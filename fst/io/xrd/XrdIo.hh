@@ -26,18 +26,16 @@
 #define __EOSFST_XRDFILEIO_HH__
 
 #include "fst/io/FileIo.hh"
-#include "fst/io/SimpleHandler.hh"
+#include "fst/io/xrd/ReadaheadEngine.hh"
 #include "common/FileMap.hh"
 #include "common/XrdConnPool.hh"
 #include "XrdCl/XrdClFile.hh"
-#include <queue>
 
 EOSFSTNAMESPACE_BEGIN
 
 //! Forward declarations
 class XrdIo;
 class AsyncMetaHandler;
-struct ReadaheadBlock;
 
 //------------------------------------------------------------------------------
 //! Class used for handling asynchronous open responses
@@ -76,50 +74,6 @@ private:
   XrdCl::ResponseHandler* mLayoutOpenHandler; ///< Open handler for the layout
 };
 
-typedef std::map<uint64_t, ReadaheadBlock*> PrefetchMap;
-
-//------------------------------------------------------------------------------
-//! Struct that holds a readahead buffer and corresponding handler
-//------------------------------------------------------------------------------
-struct ReadaheadBlock {
-
-  //----------------------------------------------------------------------------
-  //! Constuctor
-  //!
-  //! @param blocksize the size of the readahead
-  //----------------------------------------------------------------------------
-  ReadaheadBlock(uint64_t blocksize)
-  {
-    buffer = new char[blocksize];
-    handler = new SimpleHandler();
-  }
-
-  //----------------------------------------------------------------------------
-  //! Update current request
-  //!
-  //! @param offset offset
-  //! @param length length
-  //! @param isWrite true if write request, otherwise false
-  //----------------------------------------------------------------------------
-  void Update(uint64_t offset, uint32_t length, bool isWrite)
-  {
-    handler->Update(offset, length, isWrite);
-  }
-
-  //----------------------------------------------------------------------------
-  //! Destructor
-  //----------------------------------------------------------------------------
-  virtual ~ReadaheadBlock()
-  {
-    delete[] buffer;
-    delete handler;
-  }
-
-  char* buffer; ///< pointer to where the data is read
-  SimpleHandler* handler; ///< async handler for the requests
-};
-
-
 //------------------------------------------------------------------------------
 //! Class used for doing remote IO operations using the Xrd client
 //------------------------------------------------------------------------------
@@ -143,13 +97,33 @@ public:
   //----------------------------------------------------------------------------
   //! InitInitNumRdAheadBlocks
   //!
-  //! @return : number of blocks that should be read ahead
+  //! @return : number of blocks shared by the readahead streams of a file
   //----------------------------------------------------------------------------
   static uint32_t InitNumRdAheadBlocks()
   {
     char* ptr = getenv("EOS_FST_XRDIO_RDAHEAD_BLOCKS");
-    // default is 2 if envar is not set
-    return (ptr ? strtoul(ptr, 0, 10) : 2ul);
+    // default is 8 if envar is not set
+    return (ptr ? strtoul(ptr, 0, 10) : 8ul);
+  }
+
+  //----------------------------------------------------------------------------
+  //! InitNumRdAheadStreams
+  //!
+  //! @return : number of sequential streams followed by the readahead
+  //----------------------------------------------------------------------------
+  static uint32_t InitNumRdAheadStreams()
+  {
+    char* ptr = getenv("EOS_FST_XRDIO_RDAHEAD_STREAMS");
+    // default is 4 if envar is not set
+    return (ptr ? strtoul(ptr, 0, 10) : 4ul);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the readahead counters of the file, all zero if readahead is disabled
+  //----------------------------------------------------------------------------
+  ReadaheadEngine::Stats GetReadaheadStats()
+  {
+    return (mReadahead ? mReadahead->GetStats() : ReadaheadEngine::Stats());
   }
 
   //----------------------------------------------------------------------------
@@ -537,13 +511,15 @@ private:
   static eos::common::XrdConnPool mXrdConnPool; ///< Xrd connection pool
   bool mDoReadahead; ///< mark if readahead is enabled
   const uint32_t mNumRdAheadBlocks; ///< no. of blocks used for readahead
+  const uint32_t mNumRdAheadStreams; ///< no. of streams followed by readahead
   const uint64_t mDefaultBlocksize;
   int32_t mBlocksize; ///< block size for rd/wr opertations
   XrdCl::File* mXrdFile; ///< handler to xrd file
   AsyncMetaHandler* mMetaHandler; ///< async requests meta handler
-  PrefetchMap mMapBlocks; ///< map of block read/prefetched
-  std::queue<ReadaheadBlock*> mQueueBlocks; ///< queue containing available blocks
-  XrdSysMutex mPrefetchMutex; ///< mutex to serialise the prefetch step
+  std::unique_ptr<ReadaheadEngine> mReadahead; ///< adaptive readahead
+  //! Timeout of the prefetch requests, set by the reader and used by the
+  //! prefetches which the engine issues from the response handlers
+  std::atomic<uint16_t> mReadaheadTimeout;
   eos::common::FileMap mFileMap; ///< extended attribute file map
   std::string mAttrUrl; ///< extended attribute url
   std::string mOpaque; ///< opaque tags in original url
@@ -556,25 +532,9 @@ private:
   XrdCl::XRootDStatus mWriteStatus;
 
   //----------------------------------------------------------------------------
-  //! Method used to prefetch the next block using the readahead mechanism
-  //!
-  //! @param offset begin offset of the current block we are reading
-  //! @param isWrite true if block is for write, false otherwise
-  //! @param timeout timeout value
-  //!
-  //! @return true if prefetch request was sent, otherwise false
-  //----------------------------------------------------------------------------
-  bool PrefetchBlock(int64_t offset, bool isWrite, uint16_t timeout = 0);
-
-  //----------------------------------------------------------------------------
-  //! Try to find a block in cache with contains the provided offset
-  //!
-  //! @param offset offset to be searched for
-  //!
-  //! @return iterator to the block containing the offset or if no such block
-  //!         is found we return the iterator to the end of the map
+  //! Create the readahead engine of the file
   //----------------------------------------------------------------------------
-  PrefetchMap::iterator FindBlock(uint64_t offset);
+  void EnableReadahead();
 
   //----------------------------------------------------------------------------
   //! Download a remote file into a string object
@@ -0,0 +1,109 @@
+//------------------------------------------------------------------------------
+// File: ErasureCodec.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/layout/ErasureCodec.hh"
+#include "fst/layout/JerasureCodec.hh"
+#include "fst/layout/GfSplitCodec.hh"
+#include <map>
+#include <tuple>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Get codec for the given type and geometry
+//------------------------------------------------------------------------------
+std::shared_ptr<ErasureCodec>
+ErasureCodec::Get(Type type, unsigned int k, unsigned int m, size_t blocksize)
+{
+  typedef std::tuple<int, unsigned int, unsigned int, size_t> CodecKey;
+  static std::mutex mutex;
+  static std::map<CodecKey, std::shared_ptr<ErasureCodec>> codecs;
+
+  if ((k == 0) || (m == 0) || (k + m > 64) || (blocksize == 0)) {
+    return nullptr;
+  }
+
+  CodecKey key(static_cast<int>(type), k, m, blocksize);
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = codecs.find(key);
+
+  if (it != codecs.end()) {
+    return it->second;
+  }
+
+  std::shared_ptr<ErasureCodec> codec;
+
+  if (type == Type::kJerasureCauchy) {
+    auto jcodec = std::make_shared<JerasureCodec>(k, m, blocksize);
+
+    if (jcodec->IsValid()) {
+      codec = jcodec;
+    }
+  } else if (type == Type::kGfSplit) {
+    auto gcodec = std::make_shared<GfSplitCodec>(k, m, blocksize);
+
+    if (gcodec->IsValid()) {
+      codec = gcodec;
+    }
+  }
+
+  if (codec) {
+    codecs.emplace(key, codec);
+  }
+
+  return codec;
+}
+
+//------------------------------------------------------------------------------
+// Get string representation of the codec type
+//------------------------------------------------------------------------------
+const char*
+ErasureCodec::TypeToString(Type type)
+{
+  switch (type) {
+  case Type::kJerasureCauchy:
+    return "jerasure-cauchy";
+
+  case Type::kGfSplit:
+    return "gf-split";
+
+  default:
+    return "unknown";
+  }
+}
+
+//------------------------------------------------------------------------------
+// Convert set of erasures to decode cache key
+//------------------------------------------------------------------------------
+uint64_t
+ErasureCodec::GetErasureKey(const std::set<unsigned int>& erasures)
+{
+  uint64_t key = 0;
+
+  for (auto id : erasures) {
+    key |= (1ull << id);
+  }
+
+  return key;
+}
+
+EOSFSTNAMESPACE_END
@@ -0,0 +1,237 @@
+//------------------------------------------------------------------------------
+//! @file ErasureCodec.hh
+//! @brief Pluggable erasure coding backend used by the RAIN layouts
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSFST_ERASURECODEC_HH__
+#define __EOSFST_ERASURECODEC_HH__
+
+#include "fst/Namespace.hh"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! LRU cache of decoding structures (inverted matrices, schedules) keyed by
+//! the erasure pattern i.e. the bitmask of the missing stripes. All the groups
+//! of a file, and all the files sharing the same geometry, which miss the
+//! same stripes reuse one entry.
+//------------------------------------------------------------------------------
+template <typename T>
+class DecodeCache
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param capacity max number of erasure patterns kept in the cache
+  //----------------------------------------------------------------------------
+  explicit DecodeCache(size_t capacity):
+    mCapacity(capacity ? capacity : 1), mHits(0), mMisses(0)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Get entry for the given erasure pattern, building it if not cached
+  //!
+  //! @param key erasure pattern
+  //! @param build function used to build a missing entry, it's called without
+  //!        holding the cache lock and can return nullptr on failure
+  //!
+  //! @return cached entry or nullptr if it could not be built
+  //----------------------------------------------------------------------------
+  std::shared_ptr<const T>
+  Get(uint64_t key, const std::function<std::shared_ptr<const T>()>& build)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      auto it = mMap.find(key);
+
+      if (it != mMap.end()) {
+        mLru.splice(mLru.begin(), mLru, it->second);
+        ++mHits;
+        return it->second->second;
+      }
+    }
+
+    ++mMisses;
+    std::shared_ptr<const T> entry = build();
+
+    if (!entry) {
+      return entry;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mMap.find(key);
+
+    if (it != mMap.end()) {
+      // Somebody else built it in the meantime
+      return it->second->second;
+    }
+
+    mLru.emplace_front(key, entry);
+    mMap[key] = mLru.begin();
+
+    while (mLru.size() > mCapacity) {
+      mMap.erase(mLru.back().first);
+      mLru.pop_back();
+    }
+
+    return entry;
+  }
+
+  //! Number of lookups served from the cache
+  uint64_t GetHits() const
+  {
+    return mHits;
+  }
+
+  //! Number of lookups which required building a new entry
+  uint64_t GetMisses() const
+  {
+    return mMisses;
+  }
+
+private:
+  typedef std::list<std::pair<uint64_t, std::shared_ptr<const T>>> LruList;
+  size_t mCapacity; ///< max number of entries
+  std::mutex mMutex; ///< mutex protecting the list and the map
+  LruList mLru; ///< entries ordered from most to least recently used
+  std::unordered_map<uint64_t, typename LruList::iterator> mMap; ///< index
+  std::atomic<uint64_t> mHits; ///< number of hits
+  std::atomic<uint64_t> mMisses; ///< number of misses
+};
+
+
+//------------------------------------------------------------------------------
+//! Erasure coding backend interface. A codec is immutable after construction
+//! (apart from its decode cache) and is shared between all the files using
+//! the same geometry, see ErasureCodec::Get.
+//------------------------------------------------------------------------------
+class ErasureCodec
+{
+public:
+  //! Available erasure coding backends
+  enum class Type {
+    //! Cauchy Reed-Solomon bitmatrix code from Jerasure - this defines the
+    //! on-disk parity format of the ReedSLayout (RAID6 and archive) files
+    kJerasureCauchy = 0,
+    //! Vandermonde Reed-Solomon over GF(2^8) using SIMD split tables
+    kGfSplit = 1
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get codec for the given type and geometry. Codecs are created only once
+  //! per (type, k, m, blocksize) and then shared.
+  //!
+  //! @param type codec type
+  //! @param k number of data stripes
+  //! @param m number of parity stripes
+  //! @param blocksize size of a stripe block in bytes
+  //!
+  //! @return codec object or nullptr if the geometry is not supported
+  //----------------------------------------------------------------------------
+  static std::shared_ptr<ErasureCodec>
+  Get(Type type, unsigned int k, unsigned int m, size_t blocksize);
+
+  //----------------------------------------------------------------------------
+  //! Get string representation of the codec type
+  //----------------------------------------------------------------------------
+  static const char* TypeToString(Type type);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~ErasureCodec() = default;
+
+  //----------------------------------------------------------------------------
+  //! Compute the parity blocks
+  //!
+  //! @param data array of k data blocks
+  //! @param coding array of m parity blocks to be filled in
+  //! @param size size of each block, must be a multiple of the block size
+  //!        granularity of the codec (typically the block size itself)
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  virtual bool Encode(char** data, char** coding, size_t size) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Reconstruct the erased data and parity blocks in place
+  //!
+  //! @param erasures ids of the erased blocks, data blocks are [0, k) and
+  //!        parity blocks are [k, k + m)
+  //! @param data array of k data blocks
+  //! @param coding array of m parity blocks
+  //! @param size size of each block
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  virtual bool Decode(const std::set<unsigned int>& erasures, char** data,
+                      char** coding, size_t size) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Get decode cache statistics
+  //!
+  //! @param hits number of decodes reusing a cached erasure pattern
+  //! @param misses number of decodes which built a new decoding structure
+  //----------------------------------------------------------------------------
+  virtual void GetDecodeCacheStats(uint64_t& hits, uint64_t& misses) const = 0;
+
+  //----------------------------------------------------------------------------
+  //! Get codec type
+  //----------------------------------------------------------------------------
+  Type GetType() const
+  {
+    return mType;
+  }
+
+protected:
+  //! Max number of erasure patterns cached per codec
+  static constexpr size_t sDecodeCacheSize = 64;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  ErasureCodec(Type type, unsigned int k, unsigned int m, size_t blocksize):
+    mType(type), mK(k), mM(m), mBlockSize(blocksize)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Convert set of erasures to the bitmask used as decode cache key
+  //----------------------------------------------------------------------------
+  static uint64_t GetErasureKey(const std::set<unsigned int>& erasures);
+
+  Type mType; ///< codec type
+  unsigned int mK; ///< number of data stripes
+  unsigned int mM; ///< number of parity stripes
+  size_t mBlockSize; ///< block size
+};
+
+EOSFSTNAMESPACE_END
+
+#endif // __EOSFST_ERASURECODEC_HH__
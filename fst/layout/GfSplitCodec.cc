@@ -0,0 +1,347 @@
+//------------------------------------------------------------------------------
+// File: GfSplitCodec.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/layout/GfSplitCodec.hh"
+#include "common/Logging.hh"
+#include "fst/layout/jerasure/include/jerasure.h"
+#include "fst/layout/jerasure/include/reed_sol.h"
+#include "fst/layout/jerasure/include/galois.h"
+#include <cstdlib>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define EOS_GF_X86 1
+#endif
+
+EOSFSTNAMESPACE_BEGIN
+
+namespace
+{
+//! Word size of the Galois field
+const int sWordSize = 8;
+//! Size of the chunks processed across all sources to stay in cache
+const size_t sChunkSize = 16 * 1024;
+
+//------------------------------------------------------------------------------
+// Scalar region multiply
+//------------------------------------------------------------------------------
+void
+MultiplyScalar(const uint8_t* tables, const uint8_t* src, uint8_t* dst,
+               size_t begin, size_t size, bool accumulate)
+{
+  for (size_t pos = begin; pos < size; ++pos) {
+    uint8_t val = tables[src[pos] & 0x0f] ^ tables[16 + (src[pos] >> 4)];
+    dst[pos] = accumulate ? (dst[pos] ^ val) : val;
+  }
+}
+
+#ifdef EOS_GF_X86
+//------------------------------------------------------------------------------
+// SSSE3 region multiply - 16 bytes per shuffle
+//------------------------------------------------------------------------------
+__attribute__((target("ssse3"))) void
+MultiplySSSE3(const uint8_t* tables, const uint8_t* src, uint8_t* dst,
+              size_t size, bool accumulate)
+{
+  const __m128i lo = _mm_loadu_si128((const __m128i*) tables);
+  const __m128i hi = _mm_loadu_si128((const __m128i*)(tables + 16));
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  size_t pos = 0;
+
+  for (; pos + sizeof(__m128i) <= size; pos += sizeof(__m128i)) {
+    __m128i val = _mm_loadu_si128((const __m128i*)(src + pos));
+    __m128i prod = _mm_xor_si128(
+                     _mm_shuffle_epi8(lo, _mm_and_si128(val, mask)),
+                     _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi64(val, 4), mask)));
+
+    if (accumulate) {
+      prod = _mm_xor_si128(prod, _mm_loadu_si128((const __m128i*)(dst + pos)));
+    }
+
+    _mm_storeu_si128((__m128i*)(dst + pos), prod);
+  }
+
+  MultiplyScalar(tables, src, dst, pos, size, accumulate);
+}
+
+//------------------------------------------------------------------------------
+// AVX2 region multiply - 32 bytes per shuffle
+//------------------------------------------------------------------------------
+__attribute__((target("avx2"))) void
+MultiplyAVX2(const uint8_t* tables, const uint8_t* src, uint8_t* dst,
+             size_t size, bool accumulate)
+{
+  const __m256i lo = _mm256_broadcastsi128_si256(
+                       _mm_loadu_si128((const __m128i*) tables));
+  const __m256i hi = _mm256_broadcastsi128_si256(
+                       _mm_loadu_si128((const __m128i*)(tables + 16)));
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  size_t pos = 0;
+
+  for (; pos + sizeof(__m256i) <= size; pos += sizeof(__m256i)) {
+    __m256i val = _mm256_loadu_si256((const __m256i*)(src + pos));
+    __m256i prod = _mm256_xor_si256(
+                     _mm256_shuffle_epi8(lo, _mm256_and_si256(val, mask)),
+                     _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi64(val, 4),
+                                         mask)));
+
+    if (accumulate) {
+      prod = _mm256_xor_si256(prod,
+                              _mm256_loadu_si256((const __m256i*)(dst + pos)));
+    }
+
+    _mm256_storeu_si256((__m256i*)(dst + pos), prod);
+  }
+
+  _mm256_zeroupper();
+  MultiplyScalar(tables, src, dst, pos, size, accumulate);
+}
+#endif
+
+//! Region multiply implementation selected at load time
+typedef void (*MultiplyFn)(const uint8_t*, const uint8_t*, uint8_t*, size_t,
+                           bool);
+
+//------------------------------------------------------------------------------
+// Select the best region multiply implementation for the current CPU
+//------------------------------------------------------------------------------
+MultiplyFn
+SelectMultiply()
+{
+#ifdef EOS_GF_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2")) {
+    return MultiplyAVX2;
+  }
+
+  if (__builtin_cpu_supports("ssse3")) {
+    return MultiplySSSE3;
+  }
+
+#endif
+  return [](const uint8_t* tables, const uint8_t* src, uint8_t* dst,
+  size_t size, bool accumulate) {
+    MultiplyScalar(tables, src, dst, 0, size, accumulate);
+  };
+}
+
+const MultiplyFn sMultiply = SelectMultiply();
+
+//------------------------------------------------------------------------------
+// Compute out = sum(coef_i * src_i) chunk by chunk so that the output stays
+// in cache while all the sources are folded into it
+//------------------------------------------------------------------------------
+void
+DotProduct(const uint8_t* tables, const char* const* srcs, size_t nsrcs,
+           char* out, size_t size)
+{
+  for (size_t off = 0; off < size; off += sChunkSize) {
+    size_t len = std::min(sChunkSize, size - off);
+
+    for (size_t i = 0; i < nsrcs; ++i) {
+      sMultiply(tables + 32 * i, (const uint8_t*) srcs[i] + off,
+                (uint8_t*) out + off, len, (i != 0));
+    }
+  }
+}
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+GfSplitCodec::GfSplitCodec(unsigned int k, unsigned int m, size_t blocksize):
+  ErasureCodec(Type::kGfSplit, k, m, blocksize),
+  mDecodeCache(sDecodeCacheSize)
+{
+  int* matrix = reed_sol_vandermonde_coding_matrix(mK, mM, sWordSize);
+
+  if (matrix == nullptr) {
+    eos_static_err("msg=\"failed to build coding matrix\" k=%u m=%u", mK, mM);
+    return;
+  }
+
+  mMatrix.assign(matrix, matrix + mK * mM);
+  free(matrix);
+  mEncodeTables.resize(32 * mK * mM);
+
+  for (unsigned int i = 0; i < mK * mM; ++i) {
+    BuildTables(mMatrix[i], mEncodeTables.data() + 32 * i);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Fill in the split tables for a given coefficient
+//------------------------------------------------------------------------------
+void
+GfSplitCodec::BuildTables(int coef, uint8_t* tables)
+{
+  for (int x = 0; x < 16; ++x) {
+    tables[x] = galois_single_multiply(coef, x, sWordSize);
+    tables[16 + x] = galois_single_multiply(coef, x << 4, sWordSize);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Multiply a region by a constant
+//------------------------------------------------------------------------------
+void
+GfSplitCodec::MultiplyRegion(const uint8_t* tables, const char* src,
+                             char* dst, size_t size, bool accumulate)
+{
+  sMultiply(tables, (const uint8_t*) src, (uint8_t*) dst, size, accumulate);
+}
+
+//------------------------------------------------------------------------------
+// Compute one parity block
+//------------------------------------------------------------------------------
+void
+GfSplitCodec::EncodeRow(unsigned int row, char** data, char* out,
+                        size_t size) const
+{
+  DotProduct(mEncodeTables.data() + 32 * mK * row, data, mK, out, size);
+}
+
+//------------------------------------------------------------------------------
+// Compute the parity blocks
+//------------------------------------------------------------------------------
+bool
+GfSplitCodec::Encode(char** data, char** coding, size_t size)
+{
+  if (!IsValid()) {
+    return false;
+  }
+
+  for (unsigned int row = 0; row < mM; ++row) {
+    EncodeRow(row, data, coding[row], size);
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Build the decode plan for a given set of erasures
+//------------------------------------------------------------------------------
+std::shared_ptr<const GfSplitCodec::DecodePlan>
+GfSplitCodec::BuildDecodePlan(const std::set<unsigned int>& erasures) const
+{
+  auto plan = std::make_shared<DecodePlan>();
+
+  for (unsigned int id = 0; (id < mK + mM) && (plan->mSources.size() < mK);
+       ++id) {
+    if (erasures.find(id) == erasures.end()) {
+      plan->mSources.push_back(id);
+    }
+  }
+
+  if (plan->mSources.size() < mK) {
+    return nullptr;
+  }
+
+  for (auto id : erasures) {
+    if (id < mK) {
+      plan->mDataIds.push_back(id);
+    }
+  }
+
+  if (plan->mDataIds.empty()) {
+    // Only parity is missing, it's simply re-encoded
+    return plan;
+  }
+
+  // Matrix mapping the original data to the surviving sources
+  std::vector<int> mat(mK * mK, 0);
+  std::vector<int> inv(mK * mK, 0);
+
+  for (unsigned int row = 0; row < mK; ++row) {
+    unsigned int src = plan->mSources[row];
+
+    if (src < mK) {
+      mat[row * mK + src] = 1;
+    } else {
+      memcpy(&mat[row * mK], &mMatrix[(src - mK) * mK], mK * sizeof(int));
+    }
+  }
+
+  if (jerasure_invert_matrix(mat.data(), inv.data(), mK, sWordSize) != 0) {
+    return nullptr;
+  }
+
+  plan->mTables.resize(32 * mK * plan->mDataIds.size());
+
+  for (size_t i = 0; i < plan->mDataIds.size(); ++i) {
+    for (unsigned int j = 0; j < mK; ++j) {
+      BuildTables(inv[plan->mDataIds[i] * mK + j],
+                  plan->mTables.data() + 32 * (i * mK + j));
+    }
+  }
+
+  return plan;
+}
+
+//------------------------------------------------------------------------------
+// Reconstruct the erased blocks
+//------------------------------------------------------------------------------
+bool
+GfSplitCodec::Decode(const std::set<unsigned int>& erasures, char** data,
+                     char** coding, size_t size)
+{
+  if (!IsValid() || erasures.empty() || (erasures.size() > mM)) {
+    return false;
+  }
+
+  auto plan = mDecodeCache.Get(GetErasureKey(erasures),
+  [&]() {
+    return BuildDecodePlan(erasures);
+  });
+
+  if (!plan) {
+    eos_static_err("msg=\"failed to build decode plan\" k=%u m=%u "
+                   "erasures=%zu", mK, mM, erasures.size());
+    return false;
+  }
+
+  if (!plan->mDataIds.empty()) {
+    std::vector<const char*> srcs;
+    srcs.reserve(mK);
+
+    for (auto id : plan->mSources) {
+      srcs.push_back((id < mK) ? data[id] : coding[id - mK]);
+    }
+
+    for (size_t i = 0; i < plan->mDataIds.size(); ++i) {
+      DotProduct(plan->mTables.data() + 32 * mK * i, srcs.data(), mK,
+                 data[plan->mDataIds[i]], size);
+    }
+  }
+
+  // Data is now complete, recompute the missing parity
+  for (auto id : erasures) {
+    if (id >= mK) {
+      EncodeRow(id - mK, data, coding[id - mK], size);
+    }
+  }
+
+  return true;
+}
+
+EOSFSTNAMESPACE_END
@@ -0,0 +1,137 @@
+//------------------------------------------------------------------------------
+//! @file GfSplitCodec.hh
+//! @brief Reed-Solomon erasure coding backend using SIMD GF(2^8) split tables
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSFST_GFSPLITCODEC_HH__
+#define __EOSFST_GFSPLITCODEC_HH__
+
+#include "fst/layout/ErasureCodec.hh"
+#include <vector>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Systematic Vandermonde Reed-Solomon code over GF(2^8). Every coefficient
+//! of the coding and decoding matrices is expanded into a pair of 16 entry
+//! lookup tables (low and high nibble) so that multiplying a region by a
+//! constant is done with SSSE3/AVX2 byte shuffles, 16 or 32 bytes at a time.
+//! Inverted decoding matrices are cached per erasure pattern.
+//!
+//! Note: the parity produced is different from the JerasureCodec one, so this
+//! codec can not be used to read files written with the Cauchy code.
+//------------------------------------------------------------------------------
+class GfSplitCodec: public ErasureCodec
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param k number of data stripes
+  //! @param m number of parity stripes
+  //! @param blocksize size of a stripe block
+  //----------------------------------------------------------------------------
+  GfSplitCodec(unsigned int k, unsigned int m, size_t blocksize);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~GfSplitCodec() = default;
+
+  //----------------------------------------------------------------------------
+  //! Check if the codec was initialised successfully
+  //----------------------------------------------------------------------------
+  bool IsValid() const
+  {
+    return !mEncodeTables.empty();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Compute the parity blocks
+  //----------------------------------------------------------------------------
+  bool Encode(char** data, char** coding, size_t size) override;
+
+  //----------------------------------------------------------------------------
+  //! Reconstruct the erased data and parity blocks in place
+  //----------------------------------------------------------------------------
+  bool Decode(const std::set<unsigned int>& erasures, char** data,
+              char** coding, size_t size) override;
+
+  //----------------------------------------------------------------------------
+  //! Get decode cache statistics
+  //----------------------------------------------------------------------------
+  void GetDecodeCacheStats(uint64_t& hits, uint64_t& misses) const override
+  {
+    hits = mDecodeCache.GetHits();
+    misses = mDecodeCache.GetMisses();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Multiply a region by a constant using its split tables
+  //!
+  //! @param tables 32 bytes: products of the low nibbles followed by the
+  //!        products of the high nibbles
+  //! @param src source region
+  //! @param dst destination region
+  //! @param size size of the regions
+  //! @param accumulate if true XOR the product into dst, otherwise store it
+  //----------------------------------------------------------------------------
+  static void MultiplyRegion(const uint8_t* tables, const char* src, char* dst,
+                             size_t size, bool accumulate);
+
+  //----------------------------------------------------------------------------
+  //! Fill in the split tables for a given coefficient
+  //!
+  //! @param coef coefficient
+  //! @param tables 32 bytes output buffer
+  //----------------------------------------------------------------------------
+  static void BuildTables(int coef, uint8_t* tables);
+
+private:
+  //! Decoding structure for one erasure pattern
+  struct DecodePlan {
+    //! Ids of the k surviving blocks used as decode sources
+    std::vector<unsigned int> mSources;
+    //! Erased data block ids reconstructed from the sources
+    std::vector<unsigned int> mDataIds;
+    //! Split tables, k per erased data block, from the inverted matrix
+    std::vector<uint8_t> mTables;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Build the decode plan for a given set of erasures
+  //----------------------------------------------------------------------------
+  std::shared_ptr<const DecodePlan>
+  BuildDecodePlan(const std::set<unsigned int>& erasures) const;
+
+  //----------------------------------------------------------------------------
+  //! Compute one parity block out of the data blocks
+  //----------------------------------------------------------------------------
+  void EncodeRow(unsigned int row, char** data, char* out, size_t size) const;
+
+  std::vector<int> mMatrix; ///< m x k coding matrix
+  std::vector<uint8_t> mEncodeTables; ///< split tables of the coding matrix
+  DecodeCache<DecodePlan> mDecodeCache; ///< cached decode plans
+};
+
+EOSFSTNAMESPACE_END
+
+#endif // __EOSFST_GFSPLITCODEC_HH__
@@ -0,0 +1,137 @@
+//------------------------------------------------------------------------------
+// File: JerasureCodec.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/layout/JerasureCodec.hh"
+#include "common/Logging.hh"
+#include "fst/layout/jerasure/include/jerasure.h"
+#include "fst/layout/jerasure/include/cauchy.h"
+#include <cstdlib>
+#include <vector>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+JerasureCodec::JerasureCodec(unsigned int k, unsigned int m, size_t blocksize):
+  ErasureCodec(Type::kJerasureCauchy, k, m, blocksize),
+  mPacketSize(0), mMatrix(nullptr), mBitmatrix(nullptr), mSchedule(nullptr),
+  mDecodeCache(sDecodeCacheSize)
+{
+  // Same packet size as used historically by the ReedSLayout i.e.
+  // size_line / (k * w * sizeof(int)) with size_line = k * blocksize
+  mPacketSize = blocksize / (sWordSize * sizeof(int));
+
+  if ((mPacketSize == 0) || (blocksize % (mPacketSize * sWordSize) != 0)) {
+    eos_static_err("msg=\"packet size could not be computed correctly\" "
+                   "blocksize=%zu", blocksize);
+    return;
+  }
+
+  mMatrix = cauchy_good_general_coding_matrix(mK, mM, sWordSize);
+
+  if (mMatrix == nullptr) {
+    eos_static_err("msg=\"failed to build coding matrix\" k=%u m=%u", mK, mM);
+    return;
+  }
+
+  mBitmatrix = jerasure_matrix_to_bitmatrix(mK, mM, sWordSize, mMatrix);
+  mSchedule = jerasure_smart_bitmatrix_to_schedule(mK, mM, sWordSize,
+              mBitmatrix);
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+JerasureCodec::~JerasureCodec()
+{
+  if (mSchedule) {
+    jerasure_free_schedule(mSchedule);
+  }
+
+  free(mBitmatrix);
+  free(mMatrix);
+}
+
+//------------------------------------------------------------------------------
+// Decode schedule destructor
+//------------------------------------------------------------------------------
+JerasureCodec::DecodeSchedule::~DecodeSchedule()
+{
+  if (mSchedule) {
+    jerasure_free_schedule(mSchedule);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Compute the parity blocks
+//------------------------------------------------------------------------------
+bool
+JerasureCodec::Encode(char** data, char** coding, size_t size)
+{
+  if (!IsValid() || (size % (mPacketSize * sWordSize))) {
+    return false;
+  }
+
+  jerasure_schedule_encode(mK, mM, sWordSize, mSchedule, data, coding, size,
+                           mPacketSize);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Reconstruct the erased blocks
+//------------------------------------------------------------------------------
+bool
+JerasureCodec::Decode(const std::set<unsigned int>& erasures, char** data,
+                      char** coding, size_t size)
+{
+  if (!IsValid() || erasures.empty() || (erasures.size() > mM) ||
+      (size % (mPacketSize * sWordSize))) {
+    return false;
+  }
+
+  std::vector<int> ids(erasures.begin(), erasures.end());
+  ids.push_back(-1);
+  auto sched = mDecodeCache.Get(GetErasureKey(erasures),
+  [&]() -> std::shared_ptr<const DecodeSchedule> {
+    int** schedule = jerasure_generate_decoding_schedule(mK, mM, sWordSize,
+                     mBitmatrix, ids.data(), 1);
+
+    if (schedule == nullptr)
+    {
+      return nullptr;
+    }
+
+    return std::make_shared<const DecodeSchedule>(schedule);
+  });
+
+  if (!sched) {
+    eos_static_err("msg=\"failed to generate decoding schedule\" k=%u m=%u "
+                   "erasures=%zu", mK, mM, erasures.size());
+    return false;
+  }
+
+  return (jerasure_schedule_decode_with_schedule(mK, mM, sWordSize,
+          sched->mSchedule, ids.data(), data, coding, size, mPacketSize) == 0);
+}
+
+EOSFSTNAMESPACE_END
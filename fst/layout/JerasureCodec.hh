@@ -0,0 +1,100 @@
+//------------------------------------------------------------------------------
+//! @file JerasureCodec.hh
+//! @brief Cauchy Reed-Solomon erasure coding backend based on Jerasure
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSFST_JERASURECODEC_HH__
+#define __EOSFST_JERASURECODEC_HH__
+
+#include "fst/layout/ErasureCodec.hh"
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Cauchy Reed-Solomon bitmatrix codec with w = 8. The encoding schedule is
+//! computed once per geometry and the decoding schedules are cached per
+//! erasure pattern instead of being rebuilt for every group like
+//! jerasure_schedule_decode_lazy does.
+//------------------------------------------------------------------------------
+class JerasureCodec: public ErasureCodec
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param k number of data stripes
+  //! @param m number of parity stripes
+  //! @param blocksize size of a stripe block
+  //----------------------------------------------------------------------------
+  JerasureCodec(unsigned int k, unsigned int m, size_t blocksize);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~JerasureCodec();
+
+  //----------------------------------------------------------------------------
+  //! Check if the codec was initialised successfully
+  //----------------------------------------------------------------------------
+  bool IsValid() const
+  {
+    return (mSchedule != nullptr);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Compute the parity blocks
+  //----------------------------------------------------------------------------
+  bool Encode(char** data, char** coding, size_t size) override;
+
+  //----------------------------------------------------------------------------
+  //! Reconstruct the erased data and parity blocks in place
+  //----------------------------------------------------------------------------
+  bool Decode(const std::set<unsigned int>& erasures, char** data,
+              char** coding, size_t size) override;
+
+  //----------------------------------------------------------------------------
+  //! Get decode cache statistics
+  //----------------------------------------------------------------------------
+  void GetDecodeCacheStats(uint64_t& hits, uint64_t& misses) const override
+  {
+    hits = mDecodeCache.GetHits();
+    misses = mDecodeCache.GetMisses();
+  }
+
+private:
+  //! Decoding schedule owning the memory allocated by Jerasure
+  struct DecodeSchedule {
+    explicit DecodeSchedule(int** schedule): mSchedule(schedule) {}
+    ~DecodeSchedule();
+    int** mSchedule;
+  };
+
+  static constexpr int sWordSize = 8; ///< Jerasure word size
+  int mPacketSize; ///< Jerasure packet size
+  int* mMatrix; ///< coding matrix
+  int* mBitmatrix; ///< coding bitmatrix
+  int** mSchedule; ///< encoding schedule
+  DecodeCache<DecodeSchedule> mDecodeCache; ///< cached decoding schedules
+};
+
+EOSFSTNAMESPACE_END
+
+#endif // __EOSFST_JERASURECODEC_HH__
@@ -24,16 +24,16 @@
 /*----------------------------------------------------------------------------*/
 #include <cmath>
 #include <map>
+#include <mutex>
 #include <sys/types.h>
 /*----------------------------------------------------------------------------*/
 #include "fst/layout/RaidDpLayout.hh"
+#include "fst/layout/XorKernel.hh"
 #include "fst/io/AsyncMetaHandler.hh"
 /*----------------------------------------------------------------------------*/
 
 EOSFSTNAMESPACE_BEGIN
 
-typedef long v2do __attribute__((vector_size(VECTOR_SIZE)));
-
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -53,6 +53,7 @@ RaidDpLayout::RaidDpLayout(XrdFstOfsFile* file,
   mNbTotalBlocks = mNbDataBlocks + 2 * mNbDataFiles;
   mSizeGroup = mNbDataBlocks * mStripeWidth;
   mSizeLine = mNbDataFiles * mStripeWidth;
+  mSchedule = GetParitySchedule();
 }
 
 
@@ -66,70 +67,131 @@ RaidDpLayout::~RaidDpLayout()
 
 
 //------------------------------------------------------------------------------
-// Compute simple and double parity blocks
+// Get the block schedule for the current layout geometry
 //------------------------------------------------------------------------------
-bool
-RaidDpLayout::ComputeParity()
+std::shared_ptr<const RaidDpLayout::ParitySchedule>
+RaidDpLayout::GetParitySchedule()
+{
+  static std::mutex mutex;
+  static std::map<unsigned int, std::shared_ptr<const ParitySchedule>> cache;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = cache.find(mNbDataFiles);
+
+  if (it == cache.end()) {
+    it = cache.emplace(mNbDataFiles, BuildParitySchedule()).first;
+  }
+
+  return it->second;
+}
+
+
+//------------------------------------------------------------------------------
+// Build the block schedule for the current layout geometry
+//------------------------------------------------------------------------------
+std::shared_ptr<const RaidDpLayout::ParitySchedule>
+RaidDpLayout::BuildParitySchedule()
 {
-  // Compute simple parity
+  auto schedule = std::make_shared<ParitySchedule>();
+  schedule->mIsParity.resize(mNbTotalBlocks, false);
+
+  for (auto id : GetSimpleParityIndices()) {
+    schedule->mIsParity[id] = true;
+  }
+
+  for (auto id : GetDoubleParityIndices()) {
+    schedule->mIsParity[id] = true;
+  }
+
+  // Simple parity - XOR of all the data blocks on the same line
   for (unsigned int i = 0; i < mNbDataFiles; i++) {
-    int index_pblock = (i + 1) * mNbDataFiles + 2 * i;
-    int current_block = i * (mNbDataFiles + 2); //beginning of current line
-    OperationXOR(mDataBlocks[current_block],
-                 mDataBlocks[current_block + 1],
-                 mDataBlocks[index_pblock],
-                 mStripeWidth);
-    current_block += 2;
-
-    while (current_block < index_pblock) {
-      OperationXOR(mDataBlocks[index_pblock],
-                   mDataBlocks[current_block],
-                   mDataBlocks[index_pblock],
-                   mStripeWidth);
-      current_block++;
+    unsigned int index_pblock = (i + 1) * mNbDataFiles + 2 * i;
+    std::vector<unsigned int> blocks;
+
+    for (unsigned int id = i * (mNbDataFiles + 2); id < index_pblock; id++) {
+      blocks.push_back(id);
     }
+
+    schedule->mSimple.emplace_back(index_pblock, std::move(blocks));
   }
 
-  // Compute double parity
+  // Double parity - XOR of the blocks on the same diagonal
   unsigned int jump_blocks = mNbTotalFiles + 1;
-  vector<int> used_blocks;
+  std::vector<bool> used_blocks(mNbTotalBlocks, false);
+  auto is_used = [&used_blocks](unsigned int id) {
+    return ((id < used_blocks.size()) && used_blocks[id]);
+  };
+  auto mark_used = [&used_blocks](unsigned int id) {
+    if (id >= used_blocks.size()) {
+      used_blocks.resize(id + 1, false);
+    }
+
+    used_blocks[id] = true;
+  };
 
   for (unsigned int i = 0; i < mNbDataFiles; i++) {
-    unsigned int index_dpblock = (i + 1) * (mNbDataFiles + 1) + i;
-    used_blocks.push_back(index_dpblock);
+    mark_used((i + 1) * (mNbDataFiles + 1) + i);
   }
 
   for (unsigned int i = 0; i < mNbDataFiles; i++) {
     unsigned int index_dpblock = (i + 1) * (mNbDataFiles + 1) + i;
     unsigned int next_block = i + jump_blocks;
-    OperationXOR(mDataBlocks[i],
-                 mDataBlocks[next_block],
-                 mDataBlocks[index_dpblock],
-                 mStripeWidth);
-    used_blocks.push_back(i);
-    used_blocks.push_back(next_block);
+    std::vector<unsigned int> blocks {i, next_block};
+    mark_used(i);
+    mark_used(next_block);
 
     for (unsigned int j = 0; j < mNbDataFiles - 2; j++) {
       unsigned int aux_block = next_block + jump_blocks;
 
-      if ((aux_block < mNbTotalBlocks) &&
-          (find(used_blocks.begin(), used_blocks.end(),
-                aux_block) == used_blocks.end())) {
+      if ((aux_block < mNbTotalBlocks) && !is_used(aux_block)) {
         next_block = aux_block;
       } else {
         next_block++;
 
-        while (find(used_blocks.begin(), used_blocks.end(),
-                    next_block) != used_blocks.end()) {
+        while (is_used(next_block)) {
           next_block++;
         }
       }
 
-      OperationXOR(mDataBlocks[index_dpblock],
-                   mDataBlocks[next_block],
-                   mDataBlocks[index_dpblock],
-                   mStripeWidth);
-      used_blocks.push_back(next_block);
+      blocks.push_back(next_block);
+      mark_used(next_block);
+    }
+
+    schedule->mDouble.emplace_back(index_dpblock, std::move(blocks));
+  }
+
+  // Diagonal stripes used during recovery
+  schedule->mDiagStripes.reserve(mNbTotalBlocks);
+
+  for (unsigned int id = 0; id < mNbTotalBlocks; id++) {
+    schedule->mDiagStripes.push_back(GetDiagonalStripe(id));
+  }
+
+  return schedule;
+}
+
+
+//------------------------------------------------------------------------------
+// Compute simple and double parity blocks
+//------------------------------------------------------------------------------
+bool
+RaidDpLayout::ComputeParity()
+{
+  std::vector<const char*> srcs;
+  srcs.reserve(mNbTotalBlocks);
+
+  // Simple parity must be computed first as it's part of the diagonals
+  for (auto* sched : {
+         &mSchedule->mSimple, &mSchedule->mDouble
+       }) {
+    for (const auto& elem : *sched) {
+      srcs.clear();
+
+      for (auto id : elem.second) {
+        srcs.push_back(mDataBlocks[id]);
+      }
+
+      XorKernel::Xor(mDataBlocks[elem.first], srcs.data(), srcs.size(),
+                     mStripeWidth);
     }
   }
 
@@ -138,40 +200,23 @@ RaidDpLayout::ComputeParity()
 
 
 //------------------------------------------------------------------------------
-// XOR the two blocks using 128 bits and return the result
+// XOR all the blocks of the stripe except blockId and store the result in
+// blockId
 //------------------------------------------------------------------------------
 void
-RaidDpLayout::OperationXOR(char* pBlock1, char* pBlock2, char* pResult,
-                           size_t totalBytes)
+RaidDpLayout::XorStripe(const std::vector<unsigned int>& rStripe,
+                        unsigned int blockId)
 {
-  v2do* xor_res;
-  v2do* idx1;
-  v2do* idx2;
-  char* byte_res;
-  char* byte_idx1;
-  char* byte_idx2;
-  long int noPices = -1;
-  idx1 = (v2do*) pBlock1;
-  idx2 = (v2do*) pBlock2;
-  xor_res = (v2do*) pResult;
-  noPices = totalBytes / sizeof(v2do);
-
-  for (unsigned int i = 0; i < noPices; idx1++, idx2++, xor_res++, i++) {
-    *xor_res = *idx1 ^ *idx2;
-  }
-
-  // If the block does not devide perfectly to 128 ...
-  if (totalBytes % sizeof(v2do) != 0) {
-    byte_res = (char*) xor_res;
-    byte_idx1 = (char*) idx1;
-    byte_idx2 = (char*) idx2;
-
-    for (unsigned int i = noPices * sizeof(v2do);
-         i < totalBytes;
-         byte_res++, byte_idx1++, byte_idx2++, i++) {
-      *byte_res = *byte_idx1 ^ *byte_idx2;
+  std::vector<const char*> srcs;
+  srcs.reserve(rStripe.size());
+
+  for (auto id : rStripe) {
+    if (id != blockId) {
+      srcs.push_back(mDataBlocks[id]);
     }
   }
+
+  XorKernel::Xor(mDataBlocks[blockId], srcs.data(), srcs.size(), mStripeWidth);
 }
 
 
@@ -195,8 +240,6 @@ RaidDpLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
   uint64_t offset_group = (offset / mSizeGroup) * mSizeGroup;
   AsyncMetaHandler* phandler = 0;
   XrdCl::ChunkList found_errs;
-  vector<unsigned int> simple_parity = GetSimpleParityIndices();
-  vector<unsigned int> double_parity = GetDoubleParityIndices();
   status_blocks = static_cast<bool*>(calloc(mNbTotalBlocks, sizeof(bool)));
 
   // Reset all the async handlers
@@ -292,16 +335,7 @@ RaidDpLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
 
     if (ValidHorizStripe(horizontal_stripe, status_blocks, id_corrupted)) {
       // Try to recover using simple parity
-      memset(mDataBlocks[id_corrupted], 0, mStripeWidth);
-
-      for (unsigned int ind = 0; ind < horizontal_stripe.size(); ind++) {
-        if (horizontal_stripe[ind] != id_corrupted) {
-          OperationXOR(mDataBlocks[id_corrupted],
-                       mDataBlocks[horizontal_stripe[ind]],
-                       mDataBlocks[id_corrupted],
-                       mStripeWidth);
-        }
-      }
+      XorStripe(horizontal_stripe, id_corrupted);
 
       // Return recovered block and also write it to the file
       stripe_id = id_corrupted % mNbTotalFiles;
@@ -328,10 +362,7 @@ RaidDpLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
         offset = chunk->offset;
 
         // If not SP or DP, maybe we have to return it
-        if (find(simple_parity.begin(), simple_parity.end(),
-                 id_corrupted) == simple_parity.end() &&
-            find(double_parity.begin(), double_parity.end(),
-                 id_corrupted) == double_parity.end()) {
+        if (!mSchedule->mIsParity[id_corrupted]) {
           if ((offset >= (offset_group + MapBigToSmall(id_corrupted) * mStripeWidth)) &&
               (offset < (offset_group + (MapBigToSmall(id_corrupted) + 1) * mStripeWidth))) {
             chunk->buffer = static_cast<char*>
@@ -351,16 +382,7 @@ RaidDpLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
     } else {
       // Try to recover using double parity
       if (ValidDiagStripe(diagonal_stripe, status_blocks, id_corrupted)) {
-        memset(mDataBlocks[id_corrupted], 0, mStripeWidth);
-
-        for (unsigned int ind = 0; ind < diagonal_stripe.size(); ind++) {
-          if (diagonal_stripe[ind] != id_corrupted) {
-            OperationXOR(mDataBlocks[id_corrupted],
-                         mDataBlocks[diagonal_stripe[ind]],
-                         mDataBlocks[id_corrupted],
-                         mStripeWidth);
-          }
-        }
+        XorStripe(diagonal_stripe, id_corrupted);
 
         // Return recovered block and also write them to the files
         stripe_id = id_corrupted % mNbTotalFiles;
@@ -387,10 +409,7 @@ RaidDpLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
           offset = chunk->offset;
 
           // If not SP or DP, maybe we have to return it
-          if (find(simple_parity.begin(), simple_parity.end(),
-                   id_corrupted) == simple_parity.end() &&
-              find(double_parity.begin(), double_parity.end(),
-                   id_corrupted) == double_parity.end()) {
+          if (!mSchedule->mIsParity[id_corrupted]) {
             if ((offset >= (offset_group + MapBigToSmall(id_corrupted) * mStripeWidth)) &&
                 (offset < (offset_group + (MapBigToSmall(id_corrupted) + 1) * mStripeWidth))) {
               chunk->buffer = static_cast<char*>
@@ -618,8 +637,7 @@ RaidDpLayout::ValidDiagStripe(std::vector<unsigned int>& rStripes,
                               unsigned int blockId)
 {
   int corrupted = 0;
-  rStripes.clear();
-  rStripes = GetDiagonalStripe(blockId);
+  rStripes = mSchedule->mDiagStripes[blockId];
 
   if (rStripes.size() == 0) {
     return false;
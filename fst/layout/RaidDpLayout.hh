@@ -27,13 +27,11 @@
 
 /*----------------------------------------------------------------------------*/
 #include "fst/layout/RaidMetaLayout.hh"
+#include <memory>
 /*----------------------------------------------------------------------------*/
 
 EOSFSTNAMESPACE_BEGIN
 
-//! Used for computing XOR or 128 bits = 8 * 16
-#define VECTOR_SIZE 16
-
 
 //------------------------------------------------------------------------------
 //! Implementation of the RAID-double parity layout
@@ -109,6 +107,45 @@ public:
 
 private:
 
+  //----------------------------------------------------------------------------
+  //! Block schedule of a RAID-DP group which depends only on the layout
+  //! geometry (number of data files) and is therefore computed only once and
+  //! shared between all the files using the same geometry.
+  //----------------------------------------------------------------------------
+  struct ParitySchedule {
+    //! Simple parity block index and the blocks XOR-ed to compute it
+    std::vector<std::pair<unsigned int, std::vector<unsigned int>>> mSimple;
+    //! Double parity block index and the blocks XOR-ed to compute it
+    std::vector<std::pair<unsigned int, std::vector<unsigned int>>> mDouble;
+    //! Diagonal stripe for each block id, empty for the ommited diagonal
+    std::vector<std::vector<unsigned int>> mDiagStripes;
+    //! True if the block id is a simple or double parity block
+    std::vector<bool> mIsParity;
+  };
+
+  std::shared_ptr<const ParitySchedule> mSchedule; ///< block schedule
+
+  //----------------------------------------------------------------------------
+  //! Get the block schedule for the current layout geometry, building it if
+  //! this is the first time the geometry is used
+  //----------------------------------------------------------------------------
+  std::shared_ptr<const ParitySchedule> GetParitySchedule();
+
+  //----------------------------------------------------------------------------
+  //! Build the block schedule for the current layout geometry
+  //----------------------------------------------------------------------------
+  std::shared_ptr<const ParitySchedule> BuildParitySchedule();
+
+  //----------------------------------------------------------------------------
+  //! XOR together all the blocks of a stripe except one and store the result
+  //! in the excluded block
+  //!
+  //! @param rStripe blocks making up the stripe
+  //! @param blockId block to be recomputed
+  //----------------------------------------------------------------------------
+  void XorStripe(const std::vector<unsigned int>& rStripe,
+                 unsigned int blockId);
+
   //----------------------------------------------------------------------------
   //! Add data block to compute parity stripes for current group of blocks
   //! - used for the streaming mode
@@ -141,21 +178,6 @@ private:
   virtual int WriteParityToFiles(uint64_t offsetGroup);
 
 
-  //----------------------------------------------------------------------------
-  //! Compute XOR operation for two blocks of any size
-  //!
-  //! @param pBlock1 first input block
-  //! @param pBlock2 second input block
-  //! @param pResult result of XOR operation
-  //! @param totalBytes size of input blocks
-  //!
-  //----------------------------------------------------------------------------
-  void OperationXOR(char* pBlock1,
-                    char* pBlock2,
-                    char* pResult,
-                    size_t totalBytes);
-
-
   //----------------------------------------------------------------------------
   //! Recover corrupted chunks from the current group
   //!
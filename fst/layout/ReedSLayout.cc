@@ -28,11 +28,6 @@
 #include "common/Timing.hh"
 #include "fst/layout/ReedSLayout.hh"
 #include "fst/io/AsyncMetaHandler.hh"
-#include "fst/layout/jerasure/include/jerasure.h"
-#include "fst/layout/jerasure/include/reed_sol.h"
-#include "fst/layout/jerasure/include/galois.h"
-#include "fst/layout/jerasure/include/cauchy.h"
-#include "fst/layout/jerasure/include/liberation.h"
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -49,16 +44,15 @@ ReedSLayout::ReedSLayout(XrdFstOfsFile* file,
                          off_t targetSize,
                          std::string bookingOpaque) :
   RaidMetaLayout(file, lid, client, outError, path, timeout,
-                 storeRecovery, targetSize, bookingOpaque),
-  mDoneInitialisation(false),
-  mPacketSize(0), matrix(0), bitmatrix(0), schedule(0)
+                 storeRecovery, targetSize, bookingOpaque)
 {
   mNbDataBlocks = mNbDataFiles;
   mNbTotalBlocks = mNbDataFiles + mNbParityFiles;
   mSizeGroup = mNbDataFiles * mStripeWidth;
   mSizeLine = mSizeGroup;
-  // Set the parameters for the Jerasure codes
-  w = 8;      // "word size" this can be adjusted between 4..32
+  // The Cauchy code defines the on-disk format of the parity stripes
+  mCodec = ErasureCodec::Get(ErasureCodec::Type::kJerasureCauchy,
+                             mNbDataFiles, mNbParityFiles, mStripeWidth);
 }
 
 
@@ -71,46 +65,16 @@ ReedSLayout::~ReedSLayout()
 }
 
 
-//------------------------------------------------------------------------------
-// Initialise the Jerasure data structures
-//------------------------------------------------------------------------------
-bool
-ReedSLayout::InitialiseJerasure()
-{
-  mPacketSize = mSizeLine / (mNbDataBlocks * w * sizeof(int));
-  eos_debug("mStripeWidth=%zu, mSizeLine=%zu, mNbDataBlocks=%u, mNbParityFiles=%u,"
-            " w=%u, mPacketSize=%u", mStripeWidth, mSizeLine, mNbDataBlocks,
-            mNbParityFiles, w, mPacketSize);
-
-  if (mSizeLine % mPacketSize != 0) {
-    eos_err("packet size could not be computed correctly");
-    return false;
-  }
-
-  // Initialise Jerasure data structures
-  matrix = cauchy_good_general_coding_matrix(mNbDataBlocks, mNbParityFiles, w);
-  bitmatrix = jerasure_matrix_to_bitmatrix(mNbDataBlocks, mNbParityFiles, w,
-              matrix);
-  schedule = jerasure_smart_bitmatrix_to_schedule(mNbDataBlocks, mNbParityFiles,
-             w, bitmatrix);
-  return true;
-}
-
-
 //------------------------------------------------------------------------------
 // Compute the error correction blocks
 //------------------------------------------------------------------------------
 bool
 ReedSLayout::ComputeParity()
 {
-  // Initialise Jerasure structures if not done already
-  if (!mDoneInitialisation) {
-    if (!InitialiseJerasure()) {
-      eos_err("failed to initialise Jerasure");
-      return false;
-    }
-
-    mDoneInitialisation = true;
+  if (!mCodec) {
+    eos_err("msg=\"no erasure codec for geometry\" k=%u m=%u blocksize=%zu",
+            mNbDataFiles, mNbParityFiles, mStripeWidth);
+    return false;
   }
 
   // Get pointers to data and parity informatio
@@ -126,9 +90,7 @@ ReedSLayout::ComputeParity()
   }
 
   // Encode the blocks
-  jerasure_schedule_encode(mNbDataBlocks, mNbParityFiles, w, schedule, data,
-                           coding, mStripeWidth, mPacketSize);
-  return true;
+  return mCodec->Encode(data, coding, mStripeWidth);
 }
 
 
@@ -139,14 +101,10 @@ ReedSLayout::ComputeParity()
 bool
 ReedSLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
 {
-  // Initialise Jerasure structures if not done already
-  if (!mDoneInitialisation) {
-    if (!InitialiseJerasure()) {
-      eos_err("failed to initialise Jerasure library");
-      return false;
-    }
-
-    mDoneInitialisation = true;
+  if (!mCodec) {
+    eos_err("msg=\"no erasure codec for geometry\" k=%u m=%u blocksize=%zu",
+            mNbDataFiles, mNbParityFiles, mStripeWidth);
+    return false;
   }
 
   // Obs: RecoverPiecesInGroup also checks the parity blocks
@@ -234,24 +192,9 @@ ReedSLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
     coding[i] = (char*) mDataBlocks[mNbDataFiles + i];
   }
 
-  // Array of ids of erased pieces (corrupted)
-  int* erasures = new int[invalid_ids.size() + 1];
-  int index = 0;
-
-  for (auto iter = invalid_ids.begin();
-       iter != invalid_ids.end(); ++iter, ++index) {
-    erasures[index] = *iter;
-  }
-
-  erasures[invalid_ids.size()] = -1;
   // ******* DECODE ******
-  int decode = jerasure_schedule_decode_lazy(mNbDataBlocks, mNbParityFiles, w,
-               bitmatrix, erasures, data, coding,
-               mStripeWidth, mPacketSize, 1);
-  // Free memory
-  delete[] erasures;
-
-  if (decode == -1) {
+  // The decoding schedule is cached per erasure pattern by the codec
+  if (!mCodec->Decode(invalid_ids, data, coding, mStripeWidth)) {
     eos_err("decoding was unsuccessful");
     return false;
   }
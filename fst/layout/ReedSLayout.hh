@@ -27,6 +27,7 @@
 
 /*----------------------------------------------------------------------------*/
 #include "fst/layout/RaidMetaLayout.hh"
+#include "fst/layout/ErasureCodec.hh"
 /*----------------------------------------------------------------------------*/
 
 EOSFSTNAMESPACE_BEGIN
@@ -105,22 +106,8 @@ public:
 
 private:
 
-  //! Values use by Jerasure codes
-  bool mDoneInitialisation; ///< Jerasure codes initialisation status
-  unsigned int w;           ///< word size for Jerasure
-  unsigned int mPacketSize; ///< packet size for Jerasure
-  int* matrix;
-  int* bitmatrix;
-  int** schedule;
-
-
-  //----------------------------------------------------------------------------
-  //! Initialise the Jerasure structures used for encoding and decoding
-  //!
-  //! @return true if initalisation successful, otherwise false
-  //!
-  //----------------------------------------------------------------------------
-  bool InitialiseJerasure();
+  //! Erasure coding backend shared between all files with the same geometry
+  std::shared_ptr<ErasureCodec> mCodec;
 
 
   //----------------------------------------------------------------------------
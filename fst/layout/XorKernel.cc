@@ -0,0 +1,311 @@
+//------------------------------------------------------------------------------
+// File: XorKernel.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/layout/XorKernel.hh"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define EOS_XOR_X86 1
+#endif
+
+EOSFSTNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Scalar tail handling, also used as generic fallback
+//------------------------------------------------------------------------------
+void
+XorScalar(char* dst, const char* const* srcs, size_t nsrcs, size_t begin,
+          size_t length)
+{
+  size_t pos = begin;
+
+  for (; pos + sizeof(uint64_t) <= length; pos += sizeof(uint64_t)) {
+    uint64_t acc;
+    memcpy(&acc, srcs[0] + pos, sizeof(acc));
+
+    for (size_t i = 1; i < nsrcs; ++i) {
+      uint64_t val;
+      memcpy(&val, srcs[i] + pos, sizeof(val));
+      acc ^= val;
+    }
+
+    memcpy(dst + pos, &acc, sizeof(acc));
+  }
+
+  for (; pos < length; ++pos) {
+    char acc = srcs[0][pos];
+
+    for (size_t i = 1; i < nsrcs; ++i) {
+      acc ^= srcs[i][pos];
+    }
+
+    dst[pos] = acc;
+  }
+}
+
+#ifdef EOS_XOR_X86
+//------------------------------------------------------------------------------
+// SSE2 implementation - 4 x 128 bits per iteration
+//------------------------------------------------------------------------------
+__attribute__((target("sse2"))) void
+XorSSE2(char* dst, const char* const* srcs, size_t nsrcs, size_t length)
+{
+  const size_t step = 4 * sizeof(__m128i);
+  size_t pos = 0;
+
+  for (; pos + step <= length; pos += step) {
+    const __m128i* src = (const __m128i*)(srcs[0] + pos);
+    __m128i a0 = _mm_loadu_si128(src);
+    __m128i a1 = _mm_loadu_si128(src + 1);
+    __m128i a2 = _mm_loadu_si128(src + 2);
+    __m128i a3 = _mm_loadu_si128(src + 3);
+
+    for (size_t i = 1; i < nsrcs; ++i) {
+      src = (const __m128i*)(srcs[i] + pos);
+      a0 = _mm_xor_si128(a0, _mm_loadu_si128(src));
+      a1 = _mm_xor_si128(a1, _mm_loadu_si128(src + 1));
+      a2 = _mm_xor_si128(a2, _mm_loadu_si128(src + 2));
+      a3 = _mm_xor_si128(a3, _mm_loadu_si128(src + 3));
+    }
+
+    __m128i* out = (__m128i*)(dst + pos);
+    _mm_storeu_si128(out, a0);
+    _mm_storeu_si128(out + 1, a1);
+    _mm_storeu_si128(out + 2, a2);
+    _mm_storeu_si128(out + 3, a3);
+  }
+
+  XorScalar(dst, srcs, nsrcs, pos, length);
+}
+
+//------------------------------------------------------------------------------
+// AVX2 implementation - 4 x 256 bits per iteration
+//------------------------------------------------------------------------------
+__attribute__((target("avx2"))) void
+XorAVX2(char* dst, const char* const* srcs, size_t nsrcs, size_t length)
+{
+  const size_t step = 4 * sizeof(__m256i);
+  size_t pos = 0;
+
+  for (; pos + step <= length; pos += step) {
+    const __m256i* src = (const __m256i*)(srcs[0] + pos);
+    __m256i a0 = _mm256_loadu_si256(src);
+    __m256i a1 = _mm256_loadu_si256(src + 1);
+    __m256i a2 = _mm256_loadu_si256(src + 2);
+    __m256i a3 = _mm256_loadu_si256(src + 3);
+
+    for (size_t i = 1; i < nsrcs; ++i) {
+      src = (const __m256i*)(srcs[i] + pos);
+      a0 = _mm256_xor_si256(a0, _mm256_loadu_si256(src));
+      a1 = _mm256_xor_si256(a1, _mm256_loadu_si256(src + 1));
+      a2 = _mm256_xor_si256(a2, _mm256_loadu_si256(src + 2));
+      a3 = _mm256_xor_si256(a3, _mm256_loadu_si256(src + 3));
+    }
+
+    __m256i* out = (__m256i*)(dst + pos);
+    _mm256_storeu_si256(out, a0);
+    _mm256_storeu_si256(out + 1, a1);
+    _mm256_storeu_si256(out + 2, a2);
+    _mm256_storeu_si256(out + 3, a3);
+  }
+
+  _mm256_zeroupper();
+  XorScalar(dst, srcs, nsrcs, pos, length);
+}
+
+//------------------------------------------------------------------------------
+// AVX-512 implementation - 4 x 512 bits per iteration
+//------------------------------------------------------------------------------
+__attribute__((target("avx512f"))) void
+XorAVX512(char* dst, const char* const* srcs, size_t nsrcs, size_t length)
+{
+  const size_t step = 4 * sizeof(__m512i);
+  size_t pos = 0;
+
+  for (; pos + step <= length; pos += step) {
+    const char* src = srcs[0] + pos;
+    __m512i a0 = _mm512_loadu_si512(src);
+    __m512i a1 = _mm512_loadu_si512(src + 64);
+    __m512i a2 = _mm512_loadu_si512(src + 128);
+    __m512i a3 = _mm512_loadu_si512(src + 192);
+
+    for (size_t i = 1; i < nsrcs; ++i) {
+      src = srcs[i] + pos;
+      a0 = _mm512_xor_si512(a0, _mm512_loadu_si512(src));
+      a1 = _mm512_xor_si512(a1, _mm512_loadu_si512(src + 64));
+      a2 = _mm512_xor_si512(a2, _mm512_loadu_si512(src + 128));
+      a3 = _mm512_xor_si512(a3, _mm512_loadu_si512(src + 192));
+    }
+
+    char* out = dst + pos;
+    _mm512_storeu_si512(out, a0);
+    _mm512_storeu_si512(out + 64, a1);
+    _mm512_storeu_si512(out + 128, a2);
+    _mm512_storeu_si512(out + 192, a3);
+  }
+
+  _mm256_zeroupper();
+  XorScalar(dst, srcs, nsrcs, pos, length);
+}
+#endif
+
+//------------------------------------------------------------------------------
+// Check if the CPU supports the given instruction set
+//------------------------------------------------------------------------------
+bool
+IsSupported(XorKernel::Isa isa)
+{
+#ifdef EOS_XOR_X86
+  // Might be called from static initialization before the cpu model is set
+  __builtin_cpu_init();
+#endif
+
+  switch (isa) {
+  case XorKernel::Isa::kScalar:
+    return true;
+#ifdef EOS_XOR_X86
+
+  case XorKernel::Isa::kSSE2:
+    return __builtin_cpu_supports("sse2");
+
+  case XorKernel::Isa::kAVX2:
+    return __builtin_cpu_supports("avx2");
+
+  case XorKernel::Isa::kAVX512:
+    return __builtin_cpu_supports("avx512f");
+#endif
+
+  default:
+    return false;
+  }
+}
+
+//! Instruction set in use, selected at load time
+std::atomic<int> sIsa {static_cast<int>(XorKernel::GetBestIsa())};
+}
+
+//------------------------------------------------------------------------------
+// XOR all source blocks into the destination
+//------------------------------------------------------------------------------
+void
+XorKernel::Xor(char* dst, const char* const* srcs, size_t nsrcs,
+               size_t length)
+{
+  if (nsrcs == 0) {
+    memset(dst, 0, length);
+    return;
+  }
+
+  if (nsrcs == 1) {
+    memcpy(dst, srcs[0], length);
+    return;
+  }
+
+  switch (static_cast<Isa>(sIsa.load(std::memory_order_relaxed))) {
+#ifdef EOS_XOR_X86
+
+  case Isa::kAVX512:
+    XorAVX512(dst, srcs, nsrcs, length);
+    break;
+
+  case Isa::kAVX2:
+    XorAVX2(dst, srcs, nsrcs, length);
+    break;
+
+  case Isa::kSSE2:
+    XorSSE2(dst, srcs, nsrcs, length);
+    break;
+#endif
+
+  default:
+    XorScalar(dst, srcs, nsrcs, 0, length);
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the instruction set currently used
+//------------------------------------------------------------------------------
+XorKernel::Isa
+XorKernel::GetIsa()
+{
+  return static_cast<Isa>(sIsa.load());
+}
+
+//------------------------------------------------------------------------------
+// Force a given instruction set
+//------------------------------------------------------------------------------
+bool
+XorKernel::SetIsa(Isa isa)
+{
+  if (!IsSupported(isa)) {
+    return false;
+  }
+
+  sIsa = static_cast<int>(isa);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get the best instruction set supported by the CPU
+//------------------------------------------------------------------------------
+XorKernel::Isa
+XorKernel::GetBestIsa()
+{
+  for (auto isa : {
+         Isa::kAVX512, Isa::kAVX2, Isa::kSSE2
+       }) {
+    if (IsSupported(isa)) {
+      return isa;
+    }
+  }
+
+  return Isa::kScalar;
+}
+
+//------------------------------------------------------------------------------
+// Get string representation of an instruction set
+//------------------------------------------------------------------------------
+const char*
+XorKernel::IsaToString(Isa isa)
+{
+  switch (isa) {
+  case Isa::kSSE2:
+    return "sse2";
+
+  case Isa::kAVX2:
+    return "avx2";
+
+  case Isa::kAVX512:
+    return "avx512";
+
+  default:
+    return "scalar";
+  }
+}
+
+EOSFSTNAMESPACE_END
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+//! @file XorKernel.hh
+//! @brief Runtime-dispatched multi-source XOR kernel used for parity blocks
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSFST_XORKERNEL_HH__
+#define __EOSFST_XORKERNEL_HH__
+
+#include "fst/Namespace.hh"
+#include <cstddef>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Multi-source XOR kernel. All the source blocks are folded into the
+//! destination block in a single pass over memory, so computing a parity
+//! block out of N data blocks costs one store per vector instead of N-1
+//! read-modify-write passes. The implementation (SSE2, AVX2 or AVX-512) is
+//! selected once at runtime depending on the capabilities of the CPU.
+//------------------------------------------------------------------------------
+class XorKernel
+{
+public:
+  //! Instruction set used by the kernel
+  enum class Isa {
+    kScalar = 0,
+    kSSE2 = 1,
+    kAVX2 = 2,
+    kAVX512 = 3
+  };
+
+  //----------------------------------------------------------------------------
+  //! XOR all source blocks and store the result in the destination block
+  //!
+  //! @param dst destination block, must not overlap with any of the sources
+  //! @param srcs array of source blocks
+  //! @param nsrcs number of source blocks, if 0 then dst is zeroed
+  //! @param length size in bytes of every block
+  //----------------------------------------------------------------------------
+  static void Xor(char* dst, const char* const* srcs, size_t nsrcs,
+                  size_t length);
+
+  //----------------------------------------------------------------------------
+  //! Get the instruction set currently used
+  //----------------------------------------------------------------------------
+  static Isa GetIsa();
+
+  //----------------------------------------------------------------------------
+  //! Force a given instruction set - used for benchmarking and testing
+  //!
+  //! @param isa requested instruction set
+  //!
+  //! @return true if the CPU supports it and it was set, otherwise false
+  //----------------------------------------------------------------------------
+  static bool SetIsa(Isa isa);
+
+  //----------------------------------------------------------------------------
+  //! Get the best instruction set supported by the current CPU
+  //----------------------------------------------------------------------------
+  static Isa GetBestIsa();
+
+  //----------------------------------------------------------------------------
+  //! Get string representation of an instruction set
+  //----------------------------------------------------------------------------
+  static const char* IsaToString(Isa isa);
+};
+
+EOSFSTNAMESPACE_END
+
+#endif // __EOSFST_XORKERNEL_HH__
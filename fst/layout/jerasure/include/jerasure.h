@@ -198,6 +198,18 @@ int jerasure_schedule_decode_lazy(int k, int m, int w, int *bitmatrix, int *eras
 int jerasure_schedule_decode_cache(int k, int m, int w, int ***scache, int *erasures,
                             char **data_ptrs, char **coding_ptrs, int size, int packetsize);
 
+/* jerasure_generate_decoding_schedule returns the decoding schedule for the
+   given erasures so that it can be cached by the caller and applied later
+   with jerasure_schedule_decode_with_schedule to any number of stripes
+   sharing the same erasure pattern. Free it with jerasure_free_schedule. */
+
+int **jerasure_generate_decoding_schedule(int k, int m, int w, int *bitmatrix,
+                            int *erasures, int smart);
+
+int jerasure_schedule_decode_with_schedule(int k, int m, int w, int **schedule,
+                            int *erasures, char **data_ptrs, char **coding_ptrs,
+                            int size, int packetsize);
+
 int jerasure_make_decoding_matrix(int k, int m, int w, int *matrix, int *erased, 
                                   int *decoding_matrix, int *dm_ids);
 
@@ -995,7 +995,7 @@ static int set_up_ids_for_scheduled_decoding(int k, int m, int* erasures,
   return 0;
 }
 
-static int** jerasure_generate_decoding_schedule(int k, int m, int w,
+int** jerasure_generate_decoding_schedule(int k, int m, int w,
     int* bitmatrix, int* erasures, int smart)
 {
   int i, j, x, drive, y, index, z;
@@ -1210,6 +1210,31 @@ int jerasure_schedule_decode_lazy(int k, int m, int w, int* bitmatrix,
   return 0;
 }
 
+int jerasure_schedule_decode_with_schedule(int k, int m, int w,
+    int** schedule, int* erasures,
+    char** data_ptrs, char** coding_ptrs, int size, int packetsize)
+{
+  int i, tdone;
+  char** ptrs;
+  ptrs = set_up_ptrs_for_scheduled_decoding(k, m, erasures, data_ptrs,
+         coding_ptrs);
+
+  if (ptrs == NULL) {
+    return -1;
+  }
+
+  for (tdone = 0; tdone < size; tdone += packetsize * w) {
+    jerasure_do_scheduled_operations(ptrs, schedule, packetsize);
+
+    for (i = 0; i < k + m; i++) {
+      ptrs[i] += (packetsize * w);
+    }
+  }
+
+  free(ptrs);
+  return 0;
+}
+
 int jerasure_schedule_decode_cache(int k, int m, int w, int** *scache,
                                    int* erasures,
                                    char** data_ptrs, char** coding_ptrs, int size, int packetsize)
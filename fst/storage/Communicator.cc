@@ -39,6 +39,7 @@ Storage::Communicator(ThreadAssistant &assistant)
   std::string watch_bootsenttime = "bootsenttime";
   std::string watch_scaninterval = "scaninterval";
   std::string watch_scanrate = "scanrate";
+  std::string watch_scanstreams = "scanstreams";
   std::string watch_symkey = "symkey";
   std::string watch_manager = "manager";
   std::string watch_publishinterval = "publish.interval";
@@ -57,6 +58,8 @@ Storage::Communicator(ThreadAssistant &assistant)
         XrdMqSharedObjectChangeNotifier::kMqSubjectModification);
   ok &= gOFS.ObjectNotifier.SubscribesToKey("communicator", watch_scaninterval,
         XrdMqSharedObjectChangeNotifier::kMqSubjectModification);
+  ok &= gOFS.ObjectNotifier.SubscribesToKey("communicator", watch_scanstreams,
+        XrdMqSharedObjectChangeNotifier::kMqSubjectModification);
   ok &= gOFS.ObjectNotifier.SubscribesToKey("communicator", watch_symkey,
         XrdMqSharedObjectChangeNotifier::kMqSubjectModification);
   ok &= gOFS.ObjectNotifier.SubscribesToKey("communicator", watch_manager,
@@ -394,7 +397,8 @@ Storage::Communicator(ThreadAssistant &assistant)
                                    queue.c_str());
                   }
                 } else {
-                  if ((key == "scaninterval") || (key == "scanrate")) {
+                  if ((key == "scaninterval") || (key == "scanrate") ||
+                      (key == "scanstreams")) {
                     auto it_fs = mQueue2FsMap.find(queue.c_str());
 
                     if (it_fs != mQueue2FsMap.end()) {
@@ -25,6 +25,8 @@
 #include "fst/XrdFstOfs.hh"
 #include "fst/txqueue/TransferQueue.hh"
 #include "fst/storage/FileSystem.hh"
+#include "fst/storage/PublishFilter.hh"
+#include "fst/io/xrd/ReadaheadEngine.hh"
 #include "fst/FmdDbMap.hh"
 #include "namespace/ns_quarkdb/BackendClient.hh"
 #include "qclient/Formatting.hh"
@@ -32,6 +34,11 @@
 #include "common/ShellCmd.hh"
 #include "common/Timing.hh"
 #include "XrdVersion.hh"
+#include <algorithm>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
 
 XrdVERSIONINFOREF(XrdgetProtocol);
 
@@ -232,6 +239,12 @@ Storage::getFSTStatistics(const std::string& tmpfile,
   output["debug.state"] = eos::common::StringConversion::ToLower
                           (g_logging.GetPriorityString
                            (g_logging.gPriorityLevel)).c_str();
+  // asynchronous logging pipeline
+  eos::common::AsyncLogger::Stats logstats = g_logging.GetAsyncStats();
+  output["stat.log.async"] = (g_logging.IsAsync() ? "on" : "off");
+  output["stat.log.async.queued"] = SSTR(logstats.mQueued);
+  output["stat.log.async.dropped"] = SSTR(logstats.mDropped);
+  output["stat.log.async.blocked"] = SSTR(logstats.mBlocked);
   // net info
   output["stat.net.ethratemib"] = SSTR(netspeed / (8 * 1024 * 1024));
   output["stat.net.inratemib"] = SSTR(
@@ -240,6 +253,13 @@ Storage::getFSTStatistics(const std::string& tmpfile,
   output["stat.net.outratemib"] = SSTR(
                                     mFstLoad.GetNetRate(getNetworkInterface().c_str(),
                                         "txbytes") / 1024.0 / 1024.0);
+  // readahead of the files read remotely e.g. RAIN stripes
+  ReadaheadEngine::Stats readahead = ReadaheadEngine::GetGlobalStats();
+  output["stat.readahead.hits"] = SSTR(readahead.mHits + readahead.mLateHits);
+  output["stat.readahead.misses"] = SSTR(readahead.mMisses);
+  output["stat.readahead.wasted"] = SSTR(readahead.mWasted);
+  output["stat.readahead.prefetchedmib"] = SSTR(readahead.mPrefetchedBytes /
+                                          1024.0 / 1024.0);
   // publish timestamp
   output["stat.publishtimestamp"] = SSTR(
                                       eos::common::getEpochInMilliseconds().count());
@@ -265,6 +285,155 @@ std::string makeTemporaryFile()
   return tmp_name;
 }
 
+//------------------------------------------------------------------------------
+//! Values of a filesystem which require accessing the disk
+//------------------------------------------------------------------------------
+struct FsSample {
+  std::unique_ptr<eos::common::Statfs> mStatfs; ///< statfs, null on failure
+  bool mHasIoStats = false; ///< IO stats provided by the storage plugin
+  std::map<std::string, std::string> mIoStats; ///< IO stats of the plugin
+  bool mHasHealth = false; ///< Health provided by the storage plugin
+  std::map<std::string, std::string> mHealth; ///< Health of the plugin
+  long long mUsedFiles = 0; ///< Number of files attached to the filesystem
+  bool mHasFsckStats = false; ///< Consistency stats were requested
+  std::map<std::string, size_t> mFsckStats; ///< Consistency stats
+};
+
+//------------------------------------------------------------------------------
+// Collect the disk and metadata values of a filesystem
+//------------------------------------------------------------------------------
+static FsSample
+CollectSample(eos::common::FileSystem::fsid_t fsid, FileSystem* fs,
+              bool consistency)
+{
+  FsSample sample;
+  sample.mStatfs = fs->GetStatfs();
+  sample.mHasIoStats = fs->getFileIOStats(sample.mIoStats);
+  sample.mHasHealth = fs->getHealth(sample.mHealth);
+  sample.mUsedFiles = gFmdDbMapHandler.GetNumFiles(fsid);
+
+  if (consistency) {
+    XrdSysMutexHelper ISLock(fs->InconsistencyStatsMutex);
+    gFmdDbMapHandler.GetInconsistencyStatistics(fsid,
+        *fs->GetInconsistencyStats(), *fs->GetInconsistencySets());
+    sample.mHasFsckStats = true;
+    sample.mFsckStats = *fs->GetInconsistencyStats();
+  }
+
+  return sample;
+}
+
+//------------------------------------------------------------------------------
+//! Worker collecting the values of one filesystem, one collection at a time.
+//! The thread is detached and only shares its state with the publisher, so
+//! that a hanging disk only keeps its own worker busy. Filesystem objects are
+//! never deleted, the thread can safely outlive the publisher.
+//------------------------------------------------------------------------------
+class FsCollector
+{
+public:
+  FsCollector(eos::common::FileSystem::fsid_t fsid, FileSystem* fs):
+    mState(std::make_shared<State>())
+  {
+    mState->mFsid = fsid;
+    mState->mFs = fs;
+
+    try {
+      std::thread(&FsCollector::Run, mState).detach();
+      mState->mRunning = true;
+    } catch (const std::system_error& e) {
+      eos_static_err("msg=\"failed to start collection thread\" fs=%s "
+                     "err=\"%s\"", fs->GetPath().c_str(), e.what());
+    }
+  }
+
+  ~FsCollector()
+  {
+    std::lock_guard<std::mutex> lock(mState->mMutex);
+    mState->mStop = true;
+    mState->mCond.notify_one();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the filesystem the worker collects the values of
+  //----------------------------------------------------------------------------
+  FileSystem*
+  GetFileSystem() const
+  {
+    return mState->mFs;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Start a collection, the previous one must be done
+  //----------------------------------------------------------------------------
+  std::future<FsSample>
+  Start(bool consistency)
+  {
+    std::lock_guard<std::mutex> lock(mState->mMutex);
+    mState->mPromise = std::promise<FsSample>();
+    std::future<FsSample> future = mState->mPromise.get_future();
+
+    if (!mState->mRunning) {
+      mState->mPromise.set_value(FsSample());
+      return future;
+    }
+
+    mState->mConsistency = consistency;
+    mState->mRequested = true;
+    mState->mCond.notify_one();
+    return future;
+  }
+
+private:
+  //! State shared with the worker thread
+  struct State {
+    eos::common::FileSystem::fsid_t mFsid = 0;
+    FileSystem* mFs = nullptr;
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    bool mRunning = false; ///< Worker thread started
+    bool mStop = false; ///< Worker thread has to exit
+    bool mRequested = false; ///< Collection requested
+    bool mConsistency = false; ///< Collect the consistency stats
+    std::promise<FsSample> mPromise; ///< Result of the requested collection
+  };
+
+  static void
+  Run(std::shared_ptr<State> state)
+  {
+    std::unique_lock<std::mutex> lock(state->mMutex);
+
+    while (true) {
+      state->mCond.wait(lock, [&state]() {
+        return state->mStop || state->mRequested;
+      });
+
+      if (state->mStop) {
+        return;
+      }
+
+      state->mRequested = false;
+      bool consistency = state->mConsistency;
+      std::promise<FsSample> promise = std::move(state->mPromise);
+      lock.unlock();
+      promise.set_value(CollectSample(state->mFsid, state->mFs, consistency));
+      lock.lock();
+    }
+  }
+
+  std::shared_ptr<State> mState;
+};
+
+//------------------------------------------------------------------------------
+// Get a publisher setting from the environment
+//------------------------------------------------------------------------------
+static double
+GetPublishEnv(const char* name, double default_value)
+{
+  const char* ptr = getenv(name);
+  return (ptr ? strtod(ptr, nullptr) : default_value);
+}
+
 //------------------------------------------------------------------------------
 // Publish
 //------------------------------------------------------------------------------
@@ -284,206 +453,328 @@ Storage::Publish(ThreadAssistant& assistant)
   unsigned long long netspeed = getNetspeed(tmp_name);
   eos_static_info("publishing:networkspeed=%.02f GB/s",
                   1.0 * netspeed / 1000000000.0);
+  // Maximum time to wait for the disk values of a filesystem, a relative
+  // change below which numbers are not published again and the period after
+  // which everything is published again
+  const std::chrono::milliseconds disk_timeout((long long)
+      GetPublishEnv("EOS_FST_PUBLISH_DISK_TIMEOUT_MS", 2000));
+  // Number of consecutive cycles without disk values after which a
+  // filesystem is reported as unresponsive
+  const long long max_misses = GetPublishEnv("EOS_FST_PUBLISH_MAX_MISSES", 3);
+  PublishFilter filter(GetPublishEnv("EOS_FST_PUBLISH_THRESHOLD", 0.01),
+                       std::chrono::seconds((long long)
+                           GetPublishEnv("EOS_FST_PUBLISH_REFRESH", 60)));
+  // heartbeat of the filesystems and of the node
+  filter.AddAlwaysKey("stat.publishtimestamp");
+  // space values used by the MGM for placement and fullness: a relative
+  // threshold would hide gigabytes on a large disk
+  for (const char* key : {
+         "stat.statfs.freebytes", "stat.statfs.usedbytes", "stat.statfs.filled",
+         "stat.statfs.capacity", "stat.statfs.bfree", "stat.statfs.bavail",
+         "stat.statfs.ffree", "stat.statfs.fused", "stat.usedfiles"
+       }) {
+    filter.AddExactKey(key);
+  }
+
   // The following line acts as a barrier that prevents progress
   // until the config queue becomes known.
   eos::fst::Config::gConfig.getFstNodeConfigQueue("Publish");
   std::chrono::steady_clock::time_point next_consistency_stats;
   std::chrono::steady_clock::time_point last_consistency_stats;
+  //! One collection worker per filesystem
+  std::map<eos::common::FileSystem::fsid_t, std::unique_ptr<FsCollector>>
+      collectors;
+  //! Collections in flight, left behind by a hanging disk
+  std::map<eos::common::FileSystem::fsid_t, std::future<FsSample>> pending;
+  //! Consecutive cycles without disk values per filesystem
+  std::map<eos::common::FileSystem::fsid_t, long long> misses;
 
   while (!assistant.terminationRequested()) {
-    std::string publish_uptime = getUptime(tmp_name);
-    std::string publish_sockets = getNumberOfTCPSockets(tmp_name);
     std::chrono::steady_clock::time_point cycleStart =
       std::chrono::steady_clock::now();
     std::chrono::milliseconds randomizedReportInterval =
       eos::fst::Config::gConfig.getRandomizedPublishInterval();
+    bool consistency = (next_consistency_stats < cycleStart);
+    std::vector<std::pair<eos::common::FileSystem::fsid_t, FileSystem*>> fss;
     {
-      // run through our defined filesystems and publish with a MuxTransaction all changes
       eos::common::RWMutexReadLock lock(mFsMutex);
 
-      if (!gOFS.ObjectManager.OpenMuxTransaction()) {
-        eos_static_err("cannot open mux transaction");
+      for (size_t i = 0; i < mFsVect.size(); i++) {
+        if (!mFsVect[i]) {
+          eos_static_err("found 0 vector in filesystems vector %u", i);
+          continue;
+        }
+
+        eos::common::FileSystem::fsid_t fsid = mFsVect[i]->GetId();
+
+        // during the boot phase we can find a filesystem without ID
+        if (fsid) {
+          fss.emplace_back(fsid, mFsVect[i]);
+        }
+      }
+    }
+    // Collect the disk values of all the filesystems in parallel, never
+    // waiting past the deadline and skipping the ones still hanging
+    std::map<eos::common::FileSystem::fsid_t, FsSample> samples;
+    std::chrono::steady_clock::time_point deadline = cycleStart +
+        std::min(disk_timeout, randomizedReportInterval / 2);
+
+    for (const auto& elem : fss) {
+      auto it = pending.find(elem.first);
+
+      if ((it == pending.end()) ||
+          (it->second.wait_for(std::chrono::seconds(0)) ==
+           std::future_status::ready)) {
+        std::unique_ptr<FsCollector>& collector = collectors[elem.first];
+
+        if (!collector || (collector->GetFileSystem() != elem.second)) {
+          collector.reset(new FsCollector(elem.first, elem.second));
+        }
+
+        pending[elem.first] = collector->Start(consistency &&
+                                               (elem.second->GetStatus() ==
+                                                eos::common::FileSystem::kBooted));
       } else {
-        // copy out statfs info
-        for (size_t i = 0; i < mFsVect.size(); i++) {
-          if (!mFsVect[i]) {
-            eos_static_err("found 0 vector in filesystems vector %u", i);
-            continue;
-          }
+        eos_static_warning("msg=\"disk values still not collected, skipping\" "
+                           "fsid=%lu path=%s", (unsigned long) elem.first,
+                           elem.second->GetPath().c_str());
+      }
+    }
 
-          eos::common::FileSystem::fsid_t fsid = 0;
+    // Workers of the filesystems gone from this FST exit once idle
+    for (auto it = collectors.begin(); it != collectors.end();) {
+      if (!pending.count(it->first) &&
+          std::none_of(fss.begin(), fss.end(), [&it](const auto & elem) {
+          return elem.first == it->first;
+        })) {
+        it = collectors.erase(it);
+      } else {
+        ++it;
+      }
+    }
 
-          if (!(fsid = mFsVect[i]->GetId())) {
-            // during the boot phase we can find a filesystem without ID
-            continue;
-          }
+    for (auto it = pending.begin(); it != pending.end();) {
+      if (it->second.wait_until(deadline) == std::future_status::ready) {
+        samples[it->first] = it->second.get();
+        it = pending.erase(it);
+      } else {
+        ++it;
+      }
+    }
 
-          std::string r_open_hotfiles =
-            hotFilesToString(gOFS.openedForReading.getHotFiles(fsid, 10));
-          std::string w_open_hotfiles =
-            hotFilesToString(gOFS.openedForWriting.getHotFiles(fsid, 10));
-          // Retrieve Statistics from the local db
-          std::map<std::string, size_t>::const_iterator isit;
-          bool success = true;
-
-          if (mFsVect[i]->GetStatus() == eos::common::FileSystem::kBooted) {
-            if (next_consistency_stats < cycleStart) {
-              eos_static_debug("msg=\"publish consistency stats\"");
-              last_consistency_stats = cycleStart;
-              XrdSysMutexHelper ISLock(mFsVect[i]->InconsistencyStatsMutex);
-              gFmdDbMapHandler.GetInconsistencyStatistics(fsid,
-                  *mFsVect[i]->GetInconsistencyStats(),
-                  *mFsVect[i]->GetInconsistencySets());
-
-              for (isit = mFsVect[i]->GetInconsistencyStats()->begin();
-                   isit != mFsVect[i]->GetInconsistencyStats()->end(); isit++) {
-                //eos_static_debug("%-24s => %lu", isit->first.c_str(), isit->second);
-                std::string sname = "stat.fsck.";
-                sname += isit->first;
-                success &= mFsVect[i]->SetLongLong(sname.c_str(), isit->second);
-              }
-            }
-          }
+    // Compute all the values, nothing below accesses the disks
+    std::map<std::string, std::map<std::string, std::string>> fs_values;
+
+    for (const auto& elem : fss) {
+      eos::common::FileSystem::fsid_t fsid = elem.first;
+      FileSystem* fs = elem.second;
+      std::map<std::string, std::string>& values = fs_values[fs->GetQueuePath()];
+      auto set = [&values](const char* key, const auto & value) {
+        values[key] = eos::common::StringConversion::stringify(value);
+      };
+
+      auto it_sample = samples.find(fsid);
+
+      if (it_sample == samples.end()) {
+        long long missed = ++misses[fsid];
+
+        if (missed < max_misses) {
+          eos_static_warning("msg=\"disk values timed out, keeping the previous "
+                             "ones\" fsid=%lu path=%s misses=%lld",
+                             (unsigned long) fsid, fs->GetPath().c_str(), missed);
+        } else {
+          // don't let the previous values pass for current ones forever
+          eos_static_err("msg=\"disk values timed out, reporting the "
+                         "filesystem as unresponsive\" fsid=%lu path=%s "
+                         "misses=%lld", (unsigned long) fsid,
+                         fs->GetPath().c_str(), missed);
+          values["stat.health"] = "unresponsive";
+        }
+      } else {
+        misses.erase(fsid);
+        FsSample& sample = it_sample->second;
 
-          std::unique_ptr<eos::common::Statfs> statfs = mFsVect[i]->GetStatfs();
+        if (sample.mHasFsckStats) {
+          eos_static_debug("msg=\"publish consistency stats\"");
+          last_consistency_stats = cycleStart;
 
-          // call the update function which stores into the filesystem shared hash
-          if (statfs) {
-            // call the update function which stores into the filesystem shared hash
-            if (!mFsVect[i]->SetStatfs(statfs->GetStatfs())) {
-              eos_static_err("cannot SetStatfs on filesystem %s",
-                             mFsVect[i]->GetPath().c_str());
-            }
+          for (const auto& stat : sample.mFsckStats) {
+            set(("stat.fsck." + stat.first).c_str(), (long long) stat.second);
           }
+        }
 
-          // Set current load stats, io-target specific implementation may override
-          // fst load implementation
-          {
-            double readratemb;
-            double writeratemb;
-            double diskload;
-            std::map<std::string, std::string> iostats;
-
-            if (mFsVect[i]->getFileIOStats(iostats)) {
-              readratemb = strtod(iostats["read-mb-second"].c_str(), 0);
-              writeratemb = strtod(iostats["write-mb-second"].c_str(), 0);
-              diskload = strtod(iostats["load"].c_str(), 0);
-            } else {
-              readratemb = mFstLoad.GetDiskRate(mFsVect[i]->GetPath().c_str(),
-                                                "readSectors") * 512.0 / 1000000.0;
-              writeratemb = mFstLoad.GetDiskRate(mFsVect[i]->GetPath().c_str(),
-                                                 "writeSectors") * 512.0 / 1000000.0;
-              diskload = mFstLoad.GetDiskRate(mFsVect[i]->GetPath().c_str(),
-                                              "millisIO") / 1000.0;
-            }
-
-            success &= mFsVect[i]->SetDouble("stat.disk.readratemb", readratemb);
-            success &= mFsVect[i]->SetDouble("stat.disk.writeratemb",
-                                             writeratemb);
-            success &= mFsVect[i]->SetDouble("stat.disk.load", diskload);
-          }
-          // copy out net info
-          {
-            // File system implementation may override standard implementation
-            std::map<std::string, std::string> health;
-
-            if (!mFsVect[i]->getHealth(health)) {
-              health = mFstHealth.getDiskHealth(mFsVect[i]->GetPath());
-            }
-
-            success &= mFsVect[i]->SetString("stat.health",
-                                             (health.count("summary") ? health["summary"].c_str() : "N/A"));
-            success &= mFsVect[i]->SetLongLong("stat.health.indicator",
-                                               strtoll(health["indicator"].c_str(), 0, 10));
-            success &= mFsVect[i]->SetLongLong("stat.health.drives_total",
-                                               strtoll(health["drives_total"].c_str(), 0, 10));
-            success &= mFsVect[i]->SetLongLong("stat.health.drives_failed",
-                                               strtoll(health["drives_failed"].c_str(), 0, 10));
-            success &= mFsVect[i]->SetLongLong("stat.health.redundancy_factor",
-                                               strtoll(health["redundancy_factor"].c_str(), 0, 10));
-          }
-          long long r_open = (long long) gOFS.openedForReading.getOpenOnFilesystem(fsid);
-          long long w_open = (long long) gOFS.openedForWriting.getOpenOnFilesystem(fsid);
-          success &= mFsVect[i]->SetLongLong("stat.ropen", r_open);
-          success &= mFsVect[i]->SetLongLong("stat.wopen", w_open);
-          success &= mFsVect[i]->SetLongLong("stat.statfs.freebytes",
-                                             mFsVect[i]->GetLongLong("stat.statfs.bfree") *
-                                             mFsVect[i]->GetLongLong("stat.statfs.bsize"));
-          success &= mFsVect[i]->SetLongLong("stat.statfs.usedbytes",
-                                             (mFsVect[i]->GetLongLong("stat.statfs.blocks") -
-                                              mFsVect[i]->GetLongLong("stat.statfs.bfree")) *
-                                             mFsVect[i]->GetLongLong("stat.statfs.bsize"));
-          success &= mFsVect[i]->SetDouble("stat.statfs.filled",
-                                           100.0 * ((mFsVect[i]->GetLongLong("stat.statfs.blocks") -
-                                               mFsVect[i]->GetLongLong("stat.statfs.bfree"))) /
-                                           (1 + mFsVect[i]->GetLongLong("stat.statfs.blocks")));
-          success &= mFsVect[i]->SetLongLong("stat.statfs.capacity",
-                                             mFsVect[i]->GetLongLong("stat.statfs.blocks") *
-                                             mFsVect[i]->GetLongLong("stat.statfs.bsize"));
-          success &= mFsVect[i]->SetLongLong("stat.statfs.fused",
-                                             (mFsVect[i]->GetLongLong("stat.statfs.files") -
-                                              mFsVect[i]->GetLongLong("stat.statfs.ffree")) *
-                                             mFsVect[i]->GetLongLong("stat.statfs.bsize"));
-          success &= mFsVect[i]->SetLongLong("stat.usedfiles",
-                                             gFmdDbMapHandler.GetNumFiles(fsid));
-          success &= mFsVect[i]->SetString("stat.boot",
-                                           mFsVect[i]->GetStatusAsString(mFsVect[i]->GetStatus()));
-          success &= mFsVect[i]->SetString("stat.geotag", lNodeGeoTag.c_str());
-          success &= mFsVect[i]->SetLongLong("stat.publishtimestamp",
-                                             eos::common::getEpochInMilliseconds().count());
-          success &= mFsVect[i]->SetLongLong("stat.drainer.running",
-                                             mFsVect[i]->GetDrainQueue()->GetRunningAndQueued());
-          success &= mFsVect[i]->SetLongLong("stat.balancer.running",
-                                             mFsVect[i]->GetBalanceQueue()->GetRunningAndQueued());
-          success &= mFsVect[i]->SetLongLong("stat.disk.iops",
-                                             mFsVect[i]->getIOPS());
-          success &= mFsVect[i]->SetDouble("stat.disk.bw",
-                                           mFsVect[i]->getSeqBandwidth()); // in MB
-          success &= mFsVect[i]->SetLongLong("stat.http.port", gOFS.mHttpdPort);
-          // Copy out hot file list
-          success &= mFsVect[i]->SetString("stat.ropen.hotfiles",
-                                           r_open_hotfiles.c_str());
-          success &= mFsVect[i]->SetString("stat.wopen.hotfiles",
-                                           w_open_hotfiles.c_str());
-          CheckFilesystemFullness(i, fsid);
-
-          if (!success) {
+        set("stat.usedfiles", sample.mUsedFiles);
+
+        if (sample.mStatfs) {
+          // derive the space values once from the statfs result
+          struct statfs* st = sample.mStatfs->GetStatfs();
+          long long bsize = st->f_bsize;
+          long long blocks = st->f_blocks;
+          long long bfree = st->f_bfree;
+          long long freebytes = bfree * bsize;
+          set("stat.statfs.type", (long long) st->f_type);
+          set("stat.statfs.bsize", bsize);
+          set("stat.statfs.blocks", blocks);
+          set("stat.statfs.bfree", bfree);
+          set("stat.statfs.bavail", (long long) st->f_bavail);
+          set("stat.statfs.files", (long long) st->f_files);
+          set("stat.statfs.ffree", (long long) st->f_ffree);
+#ifdef __APPLE__
+          set("stat.statfs.namelen", (long long) MNAMELEN);
+#else
+          set("stat.statfs.namelen", (long long) st->f_namelen);
+#endif
+          set("stat.statfs.freebytes", freebytes);
+          set("stat.statfs.usedbytes", (blocks - bfree) * bsize);
+          set("stat.statfs.filled", 100.0 * (blocks - bfree) / (1 + blocks));
+          set("stat.statfs.capacity", blocks * bsize);
+          set("stat.statfs.fused", ((long long) st->f_files -
+                                    (long long) st->f_ffree) * bsize);
+          CheckFilesystemFullness(fs, fsid, freebytes);
+        }
+
+        // Set current load stats, io-target specific implementation may
+        // override fst load implementation
+        double readratemb;
+        double writeratemb;
+        double diskload;
+
+        if (sample.mHasIoStats) {
+          readratemb = strtod(sample.mIoStats["read-mb-second"].c_str(), 0);
+          writeratemb = strtod(sample.mIoStats["write-mb-second"].c_str(), 0);
+          diskload = strtod(sample.mIoStats["load"].c_str(), 0);
+        } else {
+          readratemb = mFstLoad.GetDiskRate(fs->GetPath().c_str(),
+                                            "readSectors") * 512.0 / 1000000.0;
+          writeratemb = mFstLoad.GetDiskRate(fs->GetPath().c_str(),
+                                             "writeSectors") * 512.0 / 1000000.0;
+          diskload = mFstLoad.GetDiskRate(fs->GetPath().c_str(),
+                                          "millisIO") / 1000.0;
+        }
+
+        set("stat.disk.readratemb", readratemb);
+        set("stat.disk.writeratemb", writeratemb);
+        set("stat.disk.load", diskload);
+        // File system implementation may override standard implementation
+        std::map<std::string, std::string>& health = sample.mHealth;
+
+        if (!sample.mHasHealth) {
+          health = mFstHealth.getDiskHealth(fs->GetPath());
+        }
+
+        values["stat.health"] = (health.count("summary") ? health["summary"] :
+                                 "N/A");
+        set("stat.health.indicator",
+            strtoll(health["indicator"].c_str(), 0, 10));
+        set("stat.health.drives_total",
+            strtoll(health["drives_total"].c_str(), 0, 10));
+        set("stat.health.drives_failed",
+            strtoll(health["drives_failed"].c_str(), 0, 10));
+        set("stat.health.redundancy_factor",
+            strtoll(health["redundancy_factor"].c_str(), 0, 10));
+      }
+
+      set("stat.ropen", (long long) gOFS.openedForReading.getOpenOnFilesystem(fsid));
+      set("stat.wopen", (long long) gOFS.openedForWriting.getOpenOnFilesystem(fsid));
+      values["stat.boot"] = fs->GetStatusAsString(fs->GetStatus());
+      values["stat.geotag"] = lNodeGeoTag.c_str();
+      set("stat.publishtimestamp",
+          (long long) eos::common::getEpochInMilliseconds().count());
+      set("stat.drainer.running",
+          (long long) fs->GetDrainQueue()->GetRunningAndQueued());
+      set("stat.balancer.running",
+          (long long) fs->GetBalanceQueue()->GetRunningAndQueued());
+      // wait time in ms, finished jobs per second and MB/s per queue
+      TransferQueue::Stats drain = fs->GetDrainQueue()->CollectStats();
+      TransferQueue::Stats balance = fs->GetBalanceQueue()->CollectStats();
+      set("stat.drainer.waittime", drain.mWaitMs);
+      set("stat.drainer.jobrate", drain.mJobRate);
+      set("stat.drainer.bandwidth", drain.mBandwidth);
+      set("stat.balancer.waittime", balance.mWaitMs);
+      set("stat.balancer.jobrate", balance.mJobRate);
+      set("stat.balancer.bandwidth", balance.mBandwidth);
+      set("stat.disk.iops", (long long) fs->getIOPS());
+      set("stat.disk.bw", (double) fs->getSeqBandwidth()); // in MB
+      set("stat.http.port", (long long) gOFS.mHttpdPort);
+      // Copy out hot file list
+      values["stat.ropen.hotfiles"] =
+        hotFilesToString(gOFS.openedForReading.getHotFiles(fsid, 10));
+      values["stat.wopen.hotfiles"] =
+        hotFilesToString(gOFS.openedForWriting.getHotFiles(fsid, 10));
+    }
+
+    std::string node_queue =
+      Config::gConfig.getFstNodeConfigQueue("Publish").c_str();
+    std::map<std::string, std::string> fstStats =
+      filter.Filter(node_queue, getFSTStatistics(tmp_name, netspeed));
+
+    for (auto& elem : fs_values) {
+      elem.second = filter.Filter(elem.first, elem.second);
+    }
+
+    // Publish the changes of all the filesystems and of the node in a single
+    // mux transaction, kept open only while setting the values
+    if (!gOFS.ObjectManager.OpenMuxTransaction()) {
+      eos_static_err("cannot open mux transaction");
+
+      // nothing went out, publish everything again in the next cycle
+      for (const auto& elem : fs_values) {
+        filter.Forget(elem.first);
+      }
+
+      filter.Forget(node_queue);
+    } else {
+      {
+        eos::common::RWMutexReadLock hash_lock(gOFS.ObjectManager.HashMutex);
+
+        for (const auto& elem : fs_values) {
+          XrdMqSharedHash* hash = gOFS.ObjectManager.GetObject(elem.first.c_str(),
+                                  "hash");
+
+          if (!hash) {
             eos_static_err("cannot set net parameters on filesystem %s",
-                           mFsVect[i]->GetPath().c_str());
+                           elem.first.c_str());
+            // publish everything once the hash is there
+            filter.Forget(elem.first);
+            continue;
           }
-        }
 
-        {
-          std::map<std::string, std::string> fstStats = getFSTStatistics(tmp_name,
-              netspeed);
-          // set node status values
-          gOFS.ObjectManager.HashMutex.LockRead();
-          // we received a new symkey
-          XrdMqSharedHash* hash = gOFS.ObjectManager.GetObject(
-                                    Config::gConfig.getFstNodeConfigQueue("Publish").c_str(),
-                                    "hash");
-
-          if (hash) {
-            for (auto it = fstStats.begin(); it != fstStats.end(); it++) {
-              hash->Set(it->first.c_str(), it->second.c_str());
-            }
+          for (const auto& kv : elem.second) {
+            hash->Set(kv.first.c_str(), kv.second.c_str());
           }
+        }
+
+        // set node status values
+        XrdMqSharedHash* hash = gOFS.ObjectManager.GetObject(node_queue.c_str(),
+                                "hash");
 
-          gOFS.ObjectManager.HashMutex.UnLockRead();
+        if (hash) {
+          for (auto it = fstStats.begin(); it != fstStats.end(); it++) {
+            hash->Set(it->first.c_str(), it->second.c_str());
+          }
+        } else {
+          filter.Forget(node_queue);
         }
+      }
+      gOFS.ObjectManager.CloseMuxTransaction();
 
-        gOFS.ObjectManager.CloseMuxTransaction();
-        // Report the consistency stats only once every 5 min
+      // Report the consistency stats only once every 5 min
+      if (consistency) {
         next_consistency_stats = last_consistency_stats + sConsistencyTimeout;
       }
     }
+
     std::chrono::steady_clock::time_point cycleEnd =
       std::chrono::steady_clock::now();
     std::chrono::milliseconds cycleDuration =
       std::chrono::duration_cast<std::chrono::milliseconds>(cycleEnd - cycleStart);
     std::chrono::milliseconds sleepTime = randomizedReportInterval - cycleDuration;
-    eos_static_debug("msg=\"publish interval\" %d %d",
-                     randomizedReportInterval.count(), cycleDuration.count());
+    eos_static_debug("msg=\"publish interval\" %d %d published=%llu "
+                     "suppressed=%llu hanging=%lu",
+                     randomizedReportInterval.count(), cycleDuration.count(),
+                     (unsigned long long) filter.GetPublished(),
+                     (unsigned long long) filter.GetSuppressed(),
+                     (unsigned long) pending.size());
 
     if (cycleDuration > randomizedReportInterval) {
       eos_static_warning("Publisher cycle exceeded %d millisecons - took %d milliseconds",
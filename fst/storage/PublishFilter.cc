@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+// File: PublishFilter.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/storage/PublishFilter.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+EOSFSTNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Parse a string which is a number and nothing else
+//------------------------------------------------------------------------------
+bool ParseNumber(const std::string& str, double& value)
+{
+  if (str.empty()) {
+    return false;
+  }
+
+  char* end = 0;
+  value = strtod(str.c_str(), &end);
+  return (*end == 0) && std::isfinite(value);
+}
+}
+
+//------------------------------------------------------------------------------
+// Select the values of a subject to publish
+//------------------------------------------------------------------------------
+std::map<std::string, std::string>
+PublishFilter::Filter(const std::string& subject,
+                      const std::map<std::string, std::string>& values,
+                      Clock::time_point now)
+{
+  std::map<std::string, std::string> out;
+  auto it_subj = mSubjects.find(subject);
+  bool refresh = (it_subj == mSubjects.end()) ||
+                 (now - it_subj->second.mLastRefresh >= mRefresh);
+  Subject& subj = mSubjects[subject];
+
+  if (refresh) {
+    subj.mLastRefresh = now;
+  }
+
+  for (const auto& elem : values) {
+    auto it = subj.mValues.find(elem.first);
+
+    if (refresh || (it == subj.mValues.end()) || mAlways.count(elem.first) ||
+        (mExact.count(elem.first) ? (it->second != elem.second) :
+         IsChanged(it->second, elem.second))) {
+      subj.mValues[elem.first] = elem.second;
+      out.insert(elem);
+      ++mPublished;
+    } else {
+      ++mSuppressed;
+    }
+  }
+
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Check if a value differs enough from the one last published
+//------------------------------------------------------------------------------
+bool
+PublishFilter::IsChanged(const std::string& published,
+                         const std::string& value) const
+{
+  if (published == value) {
+    return false;
+  }
+
+  double old_val, new_val;
+
+  if ((mThreshold <= 0) || !ParseNumber(published, old_val) ||
+      !ParseNumber(value, new_val)) {
+    return true;
+  }
+
+  return (std::fabs(new_val - old_val) >
+          mThreshold * std::max(std::fabs(old_val), std::fabs(new_val)));
+}
+
+EOSFSTNAMESPACE_END
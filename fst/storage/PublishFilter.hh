@@ -0,0 +1,131 @@
+//------------------------------------------------------------------------------
+// File: PublishFilter.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "fst/Namespace.hh"
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+#include <stdint.h>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class PublishFilter
+//!
+//! Keeps the values last published for every subject (filesystem queue) and
+//! lets through only the ones worth publishing again: strings which changed,
+//! numbers which moved by more than a relative threshold from the value last
+//! published, so slow drifts still get published once they add up. Keys
+//! marked as always published (heartbeats) and all the keys of a subject
+//! once per refresh period are let through regardless, so that a receiver
+//! which missed updates converges. Keys marked as exact (space values used
+//! for placement) are published on any change. Not thread-safe, owned by the
+//! publisher.
+//------------------------------------------------------------------------------
+class PublishFilter
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param threshold relative change of a number triggering its publication,
+  //!        0 publishes every change
+  //! @param refresh period after which all the keys are published again
+  //----------------------------------------------------------------------------
+  PublishFilter(double threshold, std::chrono::seconds refresh):
+    mThreshold(threshold), mRefresh(refresh)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Always publish the given key
+  //----------------------------------------------------------------------------
+  void AddAlwaysKey(const std::string& key)
+  {
+    mAlways.insert(key);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Publish the given key on any change, ignoring the threshold
+  //----------------------------------------------------------------------------
+  void AddExactKey(const std::string& key)
+  {
+    mExact.insert(key);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Select the values of a subject to publish and remember them as published
+  //!
+  //! @param subject subject the values belong to
+  //! @param values current values
+  //! @param now current time
+  //!
+  //! @return values to publish
+  //----------------------------------------------------------------------------
+  std::map<std::string, std::string>
+  Filter(const std::string& subject,
+         const std::map<std::string, std::string>& values,
+         Clock::time_point now = Clock::now());
+
+  //----------------------------------------------------------------------------
+  //! Forget what was published for a subject, its next values all go out
+  //----------------------------------------------------------------------------
+  void Forget(const std::string& subject)
+  {
+    mSubjects.erase(subject);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if a value differs enough from the one last published
+  //----------------------------------------------------------------------------
+  bool IsChanged(const std::string& published, const std::string& value) const;
+
+  uint64_t GetPublished() const
+  {
+    return mPublished;
+  }
+
+  uint64_t GetSuppressed() const
+  {
+    return mSuppressed;
+  }
+
+private:
+  //! Values last published for a subject
+  struct Subject {
+    std::map<std::string, std::string> mValues; ///< Published values
+    Clock::time_point mLastRefresh; ///< Last time all the keys went out
+  };
+
+  const double mThreshold; ///< Relative change threshold for numbers
+  const std::chrono::seconds mRefresh; ///< Full refresh period
+  std::set<std::string> mAlways; ///< Keys published every time
+  std::set<std::string> mExact; ///< Keys published on any change
+  std::map<std::string, Subject> mSubjects; ///< Published values by subject
+  uint64_t mPublished = 0; ///< Values let through
+  uint64_t mSuppressed = 0; ///< Values held back as unchanged
+};
+
+EOSFSTNAMESPACE_END
@@ -1023,16 +1023,12 @@ Storage::IsNodeActive() const
 
 //----------------------------------------------------------------------------
 // Check if the selected FST needs to be registered as "full" or "warning"
-// CAUTION: mFsMutex must be at-least-read locked before calling
-// this function.
-//
-// Parameter i is the index into mFsVect.
 //----------------------------------------------------------------------------
 void
-Storage::CheckFilesystemFullness(size_t index, eos::common::FileSystem::fsid_t fsid)
+Storage::CheckFilesystemFullness(FileSystem* fs,
+                                 eos::common::FileSystem::fsid_t fsid,
+                                 long long freebytes)
 {
-  long long freebytes = mFsVect[index]->GetLongLong("stat.statfs.freebytes");
-
   XrdSysMutexHelper lock(mFsFullMapMutex);
   // stop the writers if it get's critical under 5 GB space
   int full_gb = 5;
@@ -1048,7 +1044,7 @@ Storage::CheckFilesystemFullness(size_t index, eos::common::FileSystem::fsid_t f
   }
 
   if ((freebytes < 1024ll * 1024ll * 1024ll) ||
-      (freebytes <= mFsVect[index]->GetLongLong("headroom"))) {
+      (freebytes <= fs->GetLongLong("headroom"))) {
     mFsFullWarnMap[fsid] = true;
   } else {
     mFsFullWarnMap[fsid] = false;
@@ -391,13 +391,13 @@ private:
 
   //----------------------------------------------------------------------------
   //! Check if the selected FST needs to be registered as "full" or "warning"
-  //! CAUTION: mFsMutex must be at-least-read locked before calling
-  //! this function.
   //!
-  //! Parameter i is the index into mFsVect.
+  //! @param fs filesystem
+  //! @param fsid filesystem id
+  //! @param freebytes free space just measured on the filesystem
   //----------------------------------------------------------------------------
-  void CheckFilesystemFullness(size_t index,
-    eos::common::FileSystem::fsid_t fsid);
+  void CheckFilesystemFullness(FileSystem* fs,
+    eos::common::FileSystem::fsid_t fsid, long long freebytes);
 
 
 private:
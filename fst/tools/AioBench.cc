@@ -0,0 +1,337 @@
+//------------------------------------------------------------------------------
+// File: AioBench.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @file AioBench.cc
+//! @brief Random read IOPS and latency of the synchronous local IO, where
+//!        every outstanding request holds a thread, compared to the per-disk
+//!        asynchronous IO engine, at queue depths from 1 to 256.
+//------------------------------------------------------------------------------
+
+#include "fst/io/AsyncIoEngine.hh"
+#include "fst/io/FileIoPluginCommon.hh"
+#include "common/RWMutexProfiler.hh"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using Clock = std::chrono::steady_clock;
+
+//------------------------------------------------------------------------------
+//! Benchmark parameters
+//------------------------------------------------------------------------------
+struct BenchConfig {
+  std::string mPath; ///< File to read from
+  uint64_t mFileSize; ///< Size of the file in bytes
+  size_t mBlockSize; ///< Size of every read
+  double mSeconds; ///< Duration of every run
+  int mFlags; ///< Open flags
+};
+
+//------------------------------------------------------------------------------
+//! Result of a run
+//------------------------------------------------------------------------------
+struct BenchResult {
+  uint64_t mOps = 0; ///< Completed reads
+  uint64_t mErrors = 0; ///< Failed or short reads
+  double mSeconds = 0; ///< Real duration
+  eos::common::LatencyHistogram mLatency; ///< Latency of the reads
+};
+
+//------------------------------------------------------------------------------
+// Allocate a buffer suitable for direct IO
+//------------------------------------------------------------------------------
+static char*
+AllocBuffer(size_t size)
+{
+  void* ptr = nullptr;
+
+  if (posix_memalign(&ptr, 4096, size)) {
+    fprintf(stderr, "error: failed to allocate %zu bytes\n", size);
+    exit(ENOMEM);
+  }
+
+  memset(ptr, 0, size);
+  return static_cast<char*>(ptr);
+}
+
+//------------------------------------------------------------------------------
+// Create or extend the test file to the requested size
+//------------------------------------------------------------------------------
+static void
+PrepareFile(const BenchConfig& config)
+{
+  struct stat info;
+
+  if (!stat(config.mPath.c_str(), &info) &&
+      ((uint64_t) info.st_size >= config.mFileSize)) {
+    return;
+  }
+
+  int fd = open(config.mPath.c_str(), O_CREAT | O_WRONLY, 0600);
+
+  if (fd < 0) {
+    fprintf(stderr, "error: cannot create %s errno=%d\n", config.mPath.c_str(),
+            errno);
+    exit(errno);
+  }
+
+  const size_t chunk = 1024 * 1024;
+  std::unique_ptr<char, decltype(&free)> buffer(AllocBuffer(chunk), &free);
+  std::mt19937_64 rng(42);
+
+  for (uint64_t off = 0; off < config.mFileSize; off += chunk) {
+    for (size_t i = 0; i < chunk; i += sizeof(uint64_t)) {
+      uint64_t value = rng();
+      memcpy(buffer.get() + i, &value, sizeof(value));
+    }
+
+    size_t len = std::min<uint64_t>(chunk, config.mFileSize - off);
+
+    if (pwrite(fd, buffer.get(), len, off) != (ssize_t) len) {
+      fprintf(stderr, "error: cannot write %s errno=%d\n", config.mPath.c_str(),
+              errno);
+      exit(errno);
+    }
+  }
+
+  fsync(fd);
+  close(fd);
+}
+
+//------------------------------------------------------------------------------
+// Synchronous reads through the local file IO, one thread per outstanding
+// request as when XRootD threads serve the requests
+//------------------------------------------------------------------------------
+static void
+RunSync(const BenchConfig& config, unsigned int depth, BenchResult& result)
+{
+  std::atomic<bool> stop {false};
+  std::atomic<uint64_t> ops {0};
+  std::atomic<uint64_t> errors {0};
+  std::vector<std::thread> threads;
+  uint64_t nblocks = config.mFileSize / config.mBlockSize;
+  Clock::time_point start = Clock::now();
+
+  for (unsigned int t = 0; t < depth; ++t) {
+    threads.emplace_back([&, t]() {
+      std::unique_ptr<eos::fst::FileIo> io
+      (eos::fst::FileIoPluginHelper::GetIoObject(config.mPath));
+
+      if (io->fileOpen(config.mFlags)) {
+        errors++;
+        return;
+      }
+
+      std::unique_ptr<char, decltype(&free)>
+      buffer(AllocBuffer(config.mBlockSize), &free);
+      std::mt19937_64 rng(t + 1);
+
+      while (!stop) {
+        uint64_t off = (rng() % nblocks) * config.mBlockSize;
+        Clock::time_point begin = Clock::now();
+        int64_t nread = io->fileRead(off, buffer.get(), config.mBlockSize);
+        result.mLatency.Record(std::chrono::duration_cast
+                               <std::chrono::nanoseconds>(Clock::now() - begin).count());
+
+        if (nread != (int64_t) config.mBlockSize) {
+          errors++;
+        }
+
+        ops++;
+      }
+
+      io->fileClose();
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::duration<double>(config.mSeconds));
+  stop = true;
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  result.mSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+  result.mOps = ops;
+  result.mErrors = errors;
+}
+
+//------------------------------------------------------------------------------
+// Asynchronous reads through the engine, keeping "depth" requests in flight
+//------------------------------------------------------------------------------
+static void
+RunAsync(const BenchConfig& config, unsigned int depth, bool use_uring,
+         BenchResult& result)
+{
+  int fd = open(config.mPath.c_str(), config.mFlags);
+
+  if (fd < 0) {
+    fprintf(stderr, "error: cannot open %s errno=%d\n", config.mPath.c_str(),
+            errno);
+    exit(errno);
+  }
+
+  //! Slot keeping one request in flight
+  struct Slot {
+    char* mBuffer;
+    Clock::time_point mBegin;
+    std::mt19937_64 mRng;
+  };
+
+  std::atomic<bool> stop {false};
+  std::atomic<uint64_t> ops {0};
+  std::atomic<uint64_t> errors {0};
+  uint64_t nblocks = config.mFileSize / config.mBlockSize;
+  std::vector<Slot> slots(depth);
+  Clock::time_point start = Clock::now();
+  {
+    eos::fst::AsyncIoEngine engine("bench", depth, use_uring);
+    std::function<void(Slot*)> submit;
+    submit = [&](Slot * slot) {
+      uint64_t off = (slot->mRng() % nblocks) * config.mBlockSize;
+      slot->mBegin = Clock::now();
+      engine.Read(fd, slot->mBuffer, config.mBlockSize, off,
+      [&, slot](ssize_t nread) {
+        result.mLatency.Record(std::chrono::duration_cast
+                               <std::chrono::nanoseconds>(Clock::now() - slot->mBegin).count());
+
+        if (nread != (ssize_t) config.mBlockSize) {
+          errors++;
+        }
+
+        ops++;
+
+        if (!stop) {
+          submit(slot);
+        }
+      });
+    };
+
+    for (unsigned int i = 0; i < depth; ++i) {
+      slots[i].mBuffer = AllocBuffer(config.mBlockSize);
+      slots[i].mRng.seed(i + 1);
+      submit(&slots[i]);
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(config.mSeconds));
+    stop = true;
+    // The engine destructor waits for the requests still in flight
+  }
+  result.mSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+  result.mOps = ops;
+  result.mErrors = errors;
+
+  for (auto& slot : slots) {
+    free(slot.mBuffer);
+  }
+
+  close(fd);
+}
+
+//------------------------------------------------------------------------------
+// Print a result line
+//------------------------------------------------------------------------------
+static void
+Print(const char* mode, unsigned int depth, const BenchResult& result)
+{
+  fprintf(stdout, "%-9s %5u %12.0f %10.1f %10.1f %10.1f %8llu\n", mode, depth,
+          result.mOps / result.mSeconds,
+          result.mLatency.GetPercentile(0.5) / 1000.0,
+          result.mLatency.GetPercentile(0.99) / 1000.0,
+          result.mLatency.GetPercentile(0.999) / 1000.0,
+          (unsigned long long) result.mErrors);
+  fflush(stdout);
+}
+
+//------------------------------------------------------------------------------
+// Main function
+//------------------------------------------------------------------------------
+int
+main(int argc, char** argv)
+{
+  if (argc < 2 || argc > 6) {
+    fprintf(stderr, "usage: eos-aio-bench <path> [<file-size-MB> "
+            "[<block-size> [<seconds> [<direct 0|1>]]]]\n"
+            "  default: 1024 MB file, 4096 byte reads, 5 s per run, "
+            "O_DIRECT\n");
+    return EINVAL;
+  }
+
+  BenchConfig config;
+  config.mPath = argv[1];
+  config.mFileSize = ((argc > 2) ? strtoull(argv[2], 0, 10) : 1024) << 20;
+  config.mBlockSize = (argc > 3) ? strtoull(argv[3], 0, 10) : 4096;
+  config.mSeconds = (argc > 4) ? atof(argv[4]) : 5.0;
+  bool direct = (argc > 5) ? (atoi(argv[5]) != 0) : true;
+  config.mFlags = O_RDONLY;
+
+  if (direct) {
+    config.mFlags |= O_DIRECT;
+  }
+
+  if (!config.mBlockSize || (config.mFileSize < config.mBlockSize) ||
+      (direct && (config.mBlockSize % 4096))) {
+    fprintf(stderr, "error: invalid file or block size\n");
+    return EINVAL;
+  }
+
+  PrepareFile(config);
+  bool have_uring = eos::fst::AsyncIoEngine::IoUringAvailable();
+
+  if (!have_uring) {
+    fprintf(stderr, "# io_uring not available, skipping the io_uring runs\n");
+  }
+
+  fprintf(stdout, "# %-7s %5s %12s %10s %10s %10s %8s\n", "mode", "depth",
+          "iops", "p50[us]", "p99[us]", "p99.9[us]", "errors");
+
+  for (unsigned int depth = 1; depth <= 256; depth *= 2) {
+    {
+      BenchResult result;
+      RunSync(config, depth, result);
+      Print("sync", depth, result);
+    }
+    {
+      BenchResult result;
+      RunAsync(config, depth, false, result);
+      Print("threads", depth, result);
+    }
+
+    if (have_uring) {
+      BenchResult result;
+      RunAsync(config, depth, true, result);
+      Print("io_uring", depth, result);
+    }
+  }
+
+  return 0;
+}
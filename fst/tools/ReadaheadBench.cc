@@ -0,0 +1,389 @@
+//------------------------------------------------------------------------------
+// File: ReadaheadBench.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @file ReadaheadBench.cc
+//! @brief Throughput and prefetch efficiency of the XrdIo readahead against
+//!        an in-process stand-in of a remote server with a configurable round
+//!        trip time and link bandwidth. The previous prefetcher (one cursor,
+//!        one fixed block ahead) is compared to the adaptive multi-stream
+//!        engine, copying or handing over the blocks without copy, for a
+//!        sequential reader, interleaved sequential cursors and random reads.
+//------------------------------------------------------------------------------
+
+#include "fst/io/xrd/ReadaheadEngine.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using eos::fst::ReadaheadEngine;
+using Clock = std::chrono::steady_clock;
+
+//------------------------------------------------------------------------------
+//! Stand-in of a remote file: every request pays the round trip time and
+//! shares the bandwidth of the link with the other requests in flight, the
+//! responses are delivered by a separate thread as by the XRootD client
+//------------------------------------------------------------------------------
+class StandInRemote
+{
+public:
+  StandInRemote(uint64_t size, double rtt_ms, double mbps):
+    mSize(size), mHalfRtt(std::chrono::duration_cast<Clock::duration>
+                          (std::chrono::duration<double, std::milli>(rtt_ms / 2))),
+    mBytesPerSec(mbps * 1e6), mLinkFree(Clock::now()), mStop(false)
+  {
+    mThread = std::thread(&StandInRemote::Deliver, this);
+  }
+
+  ~StandInRemote()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStop = true;
+    }
+    mCv.notify_all();
+    mThread.join();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Asynchronous read, the signature of a readahead fetcher
+  //----------------------------------------------------------------------------
+  bool Fetch(uint64_t offset, uint32_t length, char* buffer,
+             ReadaheadEngine::Callback done)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    Clock::time_point now = Clock::now();
+    uint32_t n = (offset < mSize) ? std::min<uint64_t>(length,
+                 mSize - offset) : 0;
+    // the request reaches the server after half a round trip, the response
+    // is serialized on the link after the previous ones
+    mLinkFree = std::max(mLinkFree, now + mHalfRtt);
+    mLinkFree += std::chrono::duration_cast<Clock::duration>
+                 (std::chrono::duration<double>(n / mBytesPerSec));
+    mQueue.push(Request{mLinkFree + mHalfRtt, offset, n, buffer, std::move(done)});
+    mCv.notify_all();
+    mRequests++;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Synchronous read
+  //----------------------------------------------------------------------------
+  int64_t Read(uint64_t offset, uint32_t length, char* buffer)
+  {
+    auto promise = std::make_shared<std::promise<int64_t>>();
+    std::future<int64_t> future = promise->get_future();
+    Fetch(offset, length, buffer, [promise](int64_t n) {
+      promise->set_value(n);
+    });
+    return future.get();
+  }
+
+  uint64_t GetRequests()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mRequests;
+  }
+
+private:
+  struct Request {
+    Clock::time_point mReady;
+    uint64_t mOffset;
+    uint32_t mLength;
+    char* mBuffer;
+    ReadaheadEngine::Callback mDone;
+
+    bool operator<(const Request& other) const
+    {
+      return mReady > other.mReady;
+    }
+  };
+
+  void Deliver()
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    while (!mStop || !mQueue.empty()) {
+      if (mQueue.empty()) {
+        mCv.wait(lock);
+        continue;
+      }
+
+      if (mQueue.top().mReady > Clock::now()) {
+        mCv.wait_until(lock, mQueue.top().mReady);
+        continue;
+      }
+
+      Request req = mQueue.top();
+      mQueue.pop();
+      lock.unlock();
+
+      // the content only depends on the offset so readers can verify it
+      for (uint32_t i = 0; i < req.mLength; ++i) {
+        req.mBuffer[i] = static_cast<char>((req.mOffset + i) % 251);
+      }
+
+      req.mDone(req.mLength);
+      lock.lock();
+    }
+  }
+
+  const uint64_t mSize;
+  const Clock::duration mHalfRtt;
+  const double mBytesPerSec;
+  std::mutex mMutex;
+  std::condition_variable mCv;
+  std::priority_queue<Request> mQueue;
+  Clock::time_point mLinkFree;
+  uint64_t mRequests = 0;
+  bool mStop;
+  std::thread mThread;
+};
+
+//------------------------------------------------------------------------------
+//! Benchmark parameters
+//------------------------------------------------------------------------------
+struct BenchConfig {
+  double mRttMs; ///< Round trip time of the stand-in server
+  double mMBps; ///< Bandwidth of the link
+  uint64_t mFileSize; ///< Size of the file
+  uint32_t mReadSize; ///< Size of every read of the application
+  uint32_t mBlockSize; ///< Size of a prefetched block
+};
+
+enum class Mode { Legacy, Adaptive, ZeroCopy };
+enum class Workload { Sequential, Interleaved, Random };
+
+//------------------------------------------------------------------------------
+//! Result of a run
+//------------------------------------------------------------------------------
+struct BenchResult {
+  uint64_t mBytes = 0; ///< Bytes delivered to the application
+  uint64_t mErrors = 0; ///< Reads with wrong content
+  uint64_t mRequests = 0; ///< Requests sent to the server
+  double mSeconds = 0; ///< Duration
+  ReadaheadEngine::Stats mStats; ///< Readahead counters
+};
+
+//------------------------------------------------------------------------------
+// Check the content of a read
+//------------------------------------------------------------------------------
+static bool
+Verify(uint64_t offset, const char* data, uint32_t length)
+{
+  for (uint32_t i = 0; i < length; i += 4093) {
+    if (data[i] != static_cast<char>((offset + i) % 251)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Run one workload through the readahead in the given mode
+//------------------------------------------------------------------------------
+static void
+Run(const BenchConfig& config, Mode mode, Workload workload,
+    BenchResult& result)
+{
+  StandInRemote remote(config.mFileSize, config.mRttMs, config.mMBps);
+  ReadaheadEngine::Config ra;
+  ra.mBlockSize = config.mBlockSize;
+
+  if (mode == Mode::Legacy) {
+    // one cursor, the block being read and the next one
+    ra.mMaxBlocks = 2;
+    ra.mMaxStreams = 1;
+    ra.mMinWindow = 1;
+    ra.mMaxWindow = 1;
+    ra.mAdaptive = false;
+  } else {
+    ra.mMaxBlocks = 16;
+    ra.mMaxStreams = 4;
+    ra.mMaxWindow = 16;
+  }
+
+  ReadaheadEngine engine(ra, [&remote](uint64_t offset, uint32_t length,
+  char* buffer, ReadaheadEngine::Callback done) {
+    return remote.Fetch(offset, length, buffer, std::move(done));
+  });
+  // the cursors of the application, one per quarter of the file when
+  // interleaved
+  const int ncursors = (workload == Workload::Interleaved) ? 4 : 1;
+  const uint64_t span = config.mFileSize / ncursors;
+  std::vector<uint64_t> cursors;
+
+  for (int i = 0; i < ncursors; ++i) {
+    cursors.push_back(i * span);
+  }
+
+  std::vector<char> buffer(config.mReadSize);
+  std::mt19937_64 rng(42);
+  const uint64_t nreads = config.mFileSize / config.mReadSize;
+  Clock::time_point start = Clock::now();
+
+  for (uint64_t r = 0; r < nreads; ++r) {
+    uint64_t offset;
+
+    if (workload == Workload::Random) {
+      offset = (rng() % nreads) * config.mReadSize;
+    } else {
+      int c = r % ncursors;
+      offset = cursors[c];
+      cursors[c] += config.mReadSize;
+    }
+
+    uint32_t length = config.mReadSize;
+    uint32_t served = 0;
+    bool eof = false;
+
+    if (mode == Mode::ZeroCopy) {
+      while (served < length) {
+        ReadaheadEngine::Slice slice;
+        ReadaheadEngine::Result res = engine.Get(offset + served,
+                                      length - served, slice);
+
+        if (!res.mBytes) {
+          eof = res.mEof;
+          break;
+        }
+
+        if (!Verify(offset + served, slice.mData, slice.mLength)) {
+          result.mErrors++;
+        }
+
+        served += slice.mLength;
+      }
+    } else {
+      ReadaheadEngine::Result res = engine.Read(offset, buffer.data(), length);
+      served = res.mBytes;
+      eof = res.mEof;
+
+      if (served && !Verify(offset, buffer.data(), served)) {
+        result.mErrors++;
+      }
+    }
+
+    if ((served < length) && !eof) {
+      // miss, read the rest directly
+      int64_t n = remote.Read(offset + served, length - served,
+                              buffer.data() + served);
+
+      if ((n > 0) && !Verify(offset + served, buffer.data() + served, n)) {
+        result.mErrors++;
+      }
+
+      served += std::max<int64_t>(0, n);
+    }
+
+    result.mBytes += served;
+  }
+
+  engine.Drain();
+  result.mSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+  result.mStats = engine.GetStats();
+  result.mRequests = remote.GetRequests();
+}
+
+//------------------------------------------------------------------------------
+// Print a result line
+//------------------------------------------------------------------------------
+static void
+Print(const char* workload, const char* mode, const BenchResult& result)
+{
+  const ReadaheadEngine::Stats& st = result.mStats;
+  fprintf(stdout, "%-12s %-9s %10.1f %8llu %8llu %8llu %8llu %8llu %8.2f %6llu\n",
+          workload, mode, result.mBytes / result.mSeconds / 1e6,
+          (unsigned long long) st.mHits, (unsigned long long) st.mLateHits,
+          (unsigned long long) st.mMisses, (unsigned long long) st.mWasted,
+          (unsigned long long) result.mRequests, st.mRttMs,
+          (unsigned long long) result.mErrors);
+  fflush(stdout);
+}
+
+//------------------------------------------------------------------------------
+// Main function
+//------------------------------------------------------------------------------
+int
+main(int argc, char** argv)
+{
+  if (argc > 6) {
+    fprintf(stderr, "usage: eos-readahead-bench [<rtt-ms> [<bandwidth-MB/s> "
+            "[<file-size-MB> [<read-size-KB> [<block-size-KB>]]]]]\n"
+            "  default: 5 ms, 1000 MB/s, 256 MB file, 128 KB reads, "
+            "1024 KB blocks\n");
+    return EINVAL;
+  }
+
+  BenchConfig config;
+  config.mRttMs = (argc > 1) ? atof(argv[1]) : 5.0;
+  config.mMBps = (argc > 2) ? atof(argv[2]) : 1000.0;
+  config.mFileSize = ((argc > 3) ? strtoull(argv[3], 0, 10) : 256) << 20;
+  config.mReadSize = ((argc > 4) ? strtoul(argv[4], 0, 10) : 128) << 10;
+  config.mBlockSize = ((argc > 5) ? strtoul(argv[5], 0, 10) : 1024) << 10;
+
+  if ((config.mRttMs < 0) || (config.mMBps <= 0) || !config.mReadSize ||
+      !config.mBlockSize || (config.mFileSize < config.mReadSize)) {
+    fprintf(stderr, "error: invalid parameters\n");
+    return EINVAL;
+  }
+
+  fprintf(stdout, "# rtt=%.1fms bandwidth=%.0fMB/s file=%lluMB read=%uKB "
+          "block=%uKB\n", config.mRttMs, config.mMBps,
+          (unsigned long long)(config.mFileSize >> 20), config.mReadSize >> 10,
+          config.mBlockSize >> 10);
+  fprintf(stdout, "# %-10s %-9s %10s %8s %8s %8s %8s %8s %8s %6s\n", "workload",
+          "mode", "MB/s", "hits", "late", "misses", "wasted", "requests",
+          "rtt[ms]", "errors");
+  const std::pair<Workload, const char*> workloads[] = {
+    {Workload::Sequential, "sequential"},
+    {Workload::Interleaved, "interleaved"},
+    {Workload::Random, "random"}
+  };
+  const std::pair<Mode, const char*> modes[] = {
+    {Mode::Legacy, "legacy"},
+    {Mode::Adaptive, "adaptive"},
+    {Mode::ZeroCopy, "zerocopy"}
+  };
+
+  for (const auto& workload : workloads) {
+    for (const auto& mode : modes) {
+      BenchResult result;
+      Run(config, mode.first, workload.first, result);
+      Print(workload.second, mode.second, result);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,140 @@
+//------------------------------------------------------------------------------
+// File: TokenBucket.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "fst/Namespace.hh"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class TokenBucket
+//!
+//! Deficit token bucket limiting the average rate of a transfer queue. The
+//! bucket fills up at the configured rate up to its burst size. The size of
+//! a transfer is only known while it progresses, therefore transfers are
+//! admitted as long as the bucket is not in debt and their bytes are consumed
+//! as they are reported, possibly driving the bucket into debt: no new
+//! transfer is admitted until the debt has been paid back at the configured
+//! rate.
+//------------------------------------------------------------------------------
+class TokenBucket
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param rate tokens per second, 0 means unlimited
+  //! @param burst maximum number of tokens
+  //----------------------------------------------------------------------------
+  TokenBucket(double rate = 0, double burst = 0):
+    mRate(rate), mBurst(burst), mTokens(burst), mLast(Clock::now())
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Change the rate and the burst size, the current debt is kept. A bucket
+  //! which was unlimited so far starts full.
+  //----------------------------------------------------------------------------
+  void Configure(double rate, double burst, Clock::time_point now = Clock::now())
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    Refill(now);
+    mTokens = (mRate <= 0) ? burst : std::min(mTokens, burst);
+    mRate = rate;
+    mBurst = burst;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if a new transfer can be admitted
+  //----------------------------------------------------------------------------
+  bool IsAvailable(Clock::time_point now = Clock::now())
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    Refill(now);
+    return (mRate <= 0) || (mTokens >= 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Consume tokens, the bucket may go into debt
+  //----------------------------------------------------------------------------
+  void Consume(double tokens, Clock::time_point now = Clock::now())
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    Refill(now);
+
+    if (mRate > 0) {
+      mTokens -= tokens;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the time until a new transfer can be admitted, zero if it can now
+  //----------------------------------------------------------------------------
+  std::chrono::milliseconds TimeToAvailable(Clock::time_point now = Clock::now())
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    Refill(now);
+
+    if ((mRate <= 0) || (mTokens >= 0)) {
+      return std::chrono::milliseconds(0);
+    }
+
+    // round up, waking up early would only find the bucket still in debt
+    return std::chrono::milliseconds(static_cast<long long>
+                                     (1000.0 * -mTokens / mRate) + 1);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the current number of tokens, negative while in debt
+  //----------------------------------------------------------------------------
+  double GetTokens(Clock::time_point now = Clock::now())
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    Refill(now);
+    return mTokens;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Add the tokens accumulated since the last refill, lock held
+  //----------------------------------------------------------------------------
+  void Refill(Clock::time_point now)
+  {
+    if (now > mLast) {
+      std::chrono::duration<double> elapsed = now - mLast;
+      mTokens = std::min(mBurst, mTokens + elapsed.count() * mRate);
+      mLast = now;
+    }
+  }
+
+  std::mutex mMutex; ///< Mutex protecting the bucket
+  double mRate; ///< Tokens per second, 0 for unlimited
+  double mBurst; ///< Maximum number of tokens
+  double mTokens; ///< Current number of tokens
+  Clock::time_point mLast; ///< Time of the last refill
+};
+
+EOSFSTNAMESPACE_END
@@ -68,6 +68,7 @@ TransferJob::TransferJob(TransferQueue* queue, eos::common::TransferJob* job,
   mProgressThread = 0;
   mProgressFile = "";
   mLastProgress = 0.0;
+  mBytesCharged = 0;
   mDoItThread = 0;
   mCanceled = false;
   mLastState = 0;
@@ -108,10 +109,15 @@ TransferJob::Progress()
     FILE* fd = fopen(mProgressFile.c_str(), "r");
 
     if (fd) {
-      int item = fscanf(fd, "%f\n", &progress);
+      unsigned long long bytes_copied = 0;
+      int item = fscanf(fd, "%f %llu\n", &progress, &bytes_copied);
       eos_static_debug("progress=%.02f", progress);
 
-      if (item == 1) {
+      if (item == 2) {
+        ChargeBytes(bytes_copied);
+      }
+
+      if (item >= 1) {
         if (fabs(mLastProgress - progress) > 1) {
           // send only if there is a significant change
           int rc = SendState(0, 0, progress);
@@ -211,6 +217,41 @@ TransferJob::GetTargetUrl()
   return mTargetUrl.c_str();
 }
 
+/* ------------------------------------------------------------------------- */
+unsigned long long
+TransferJob::GetBytesCopied(const std::string& progress_file)
+{
+  unsigned long long bytes_copied = 0;
+  FILE* fprogress = fopen(progress_file.c_str(), "r");
+
+  if (fprogress) {
+    float progress = 0;
+
+    if (fscanf(fprogress, "%f %llu", &progress, &bytes_copied) != 2) {
+      bytes_copied = 0;
+    }
+
+    fclose(fprogress);
+  }
+
+  return bytes_copied;
+}
+
+/* ------------------------------------------------------------------------- */
+void
+TransferJob::ChargeBytes(unsigned long long bytes_copied)
+{
+  // the progress thread and the job thread both report, charge only once
+  unsigned long long charged = mBytesCharged.load();
+
+  while ((bytes_copied > charged) &&
+         !mBytesCharged.compare_exchange_weak(charged, bytes_copied)) {}
+
+  if (bytes_copied > charged) {
+    mQueue->Charge(bytes_copied - charged);
+  }
+}
+
 /* ------------------------------------------------------------------------- */
 int
 TransferJob::SendState(int state, const char* logfile, float progress)
@@ -864,7 +905,17 @@ TransferJob::DoIt()
     }
   } else {
     eos::common::ShellCmd scmd(command.str().c_str());
-    eos::common::cmd_status rcst = scmd.wait(24 * 3600);
+
+    // charge the bytes copied to the queue bandwidth while the copy runs
+    for (size_t i = 0; (i < 24 * 3600 * 10) && scmd.is_active(); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+      if (i % 10 == 9) {
+        ChargeBytes(GetBytesCopied(progressFileName));
+      }
+    }
+
+    eos::common::cmd_status rcst = scmd.wait(0);
     rc = rcst.exit_code;
   }
 
@@ -1008,6 +1059,8 @@ TransferJob::DoIt()
   // ---- release the static log lock mutex ----
   eoscpLogMutex.UnLock();
 cleanup:
+  // the last progress report of eoscp holds the number of bytes copied
+  unsigned long long bytes_copied = GetBytesCopied(progressFileName);
   // Remove the result files
   (void) unlink(fileOutput.c_str());
   (void) unlink(fileStageOutput.c_str());
@@ -1022,7 +1075,8 @@ cleanup:
   }
 
   // we are over running
-  mQueue->DecRunning();
+  ChargeBytes(bytes_copied);
+  mQueue->DecRunning(bytes_copied);
   delete this;
 }
 
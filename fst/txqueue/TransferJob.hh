@@ -27,6 +27,7 @@
 #include "fst/Namespace.hh"
 #include "Xrd/XrdJob.hh"
 #include "XrdOuc/XrdOucString.hh"
+#include <atomic>
 #include <string>
 
 //! Forward declaration
@@ -54,6 +55,7 @@ private:
   XrdOucString mTargetUrl;
   XrdOucString mProgressFile;
   float mLastProgress; // last progress value which was broadcasted to the MGM
+  std::atomic<unsigned long long> mBytesCharged; // bytes charged to the queue bandwidth
   int mLastState; // last state set
   long long mId; // the ID is only used for scheduled gateway transfers (managed via 'transfer' console)
 
@@ -81,6 +83,12 @@ public:
 
   static void* StaticProgress(void*);
   void* Progress();
+
+  //! Get the bytes copied so far from the eoscp progress file, 0 if unknown
+  static unsigned long long GetBytesCopied(const std::string& progress_file);
+
+  //! Charge the bytes copied so far which were not charged yet to the queue
+  void ChargeBytes(unsigned long long bytes_copied);
 };
 
 EOSFSTNAMESPACE_END
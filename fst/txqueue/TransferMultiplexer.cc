@@ -26,15 +26,18 @@
 #include "fst/XrdFstOfs.hh"
 #include "common/Logging.hh"
 #include "Xrd/XrdScheduler.hh"
+#include <algorithm>
 #include <cstdio>
 
 EOSFSTNAMESPACE_BEGIN
 
+constexpr std::chrono::seconds TransferMultiplexer::cIdlePeriod;
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 TransferMultiplexer::TransferMultiplexer():
-  mTid(0)
+  mWakeUp(false), mRunning(false)
 {}
 
 //------------------------------------------------------------------------------
@@ -51,11 +54,23 @@ TransferMultiplexer::~TransferMultiplexer()
 void
 TransferMultiplexer::Stop()
 {
-  if (mTid) {
-    XrdSysThread::Cancel(mTid);
-    XrdSysThread::Join(mTid, NULL);
-    mTid = 0;
+  if (!mRunning) {
+    return;
   }
+
+  mThread.join();
+  eos::common::RWMutexReadLock lock(mMutex);
+
+  for (size_t i = 0; i < mQueues.size(); i++) {
+    mQueues[i]->SetDispatchNotify(nullptr);
+
+    if (mQueues[i]->GetQueue()) {
+      mQueues[i]->GetQueue()->RemoveInsertListener(mListeners[i]);
+    }
+  }
+
+  mListeners.clear();
+  mRunning = false;
 }
 
 //------------------------------------------------------------------------------
@@ -64,11 +79,37 @@ TransferMultiplexer::Stop()
 void
 TransferMultiplexer::Run()
 {
-  if (!mTid) {
-    XrdSysThread::Run(&mTid, TransferMultiplexer::StaticThreadProc,
-                      static_cast<void*>(this), XRDSYSTHREAD_HOLD,
-                      "Multiplexer Thread");
+  if (mRunning) {
+    return;
+  }
+
+  {
+    eos::common::RWMutexReadLock lock(mMutex);
+
+    for (size_t i = 0; i < mQueues.size(); i++) {
+      TransferQueue* queue = mQueues[i];
+      queue->SetDispatchNotify([this]() {
+        Notify();
+      });
+      uint64_t id = 0;
+
+      if (queue->GetQueue()) {
+        id = queue->GetQueue()->AddInsertListener([this, queue]() {
+          queue->NotifyInsert();
+          Notify();
+        });
+      }
+
+      mListeners.push_back(id);
+    }
   }
+
+  mRunning = true;
+  mThread.reset(&TransferMultiplexer::ThreadProc, this);
+  mThread.registerCallback([this]() {
+    Notify();
+  });
+  mThread.setName("Multiplexer Thread");
 }
 
 //------------------------------------------------------------------------------
@@ -87,13 +128,14 @@ TransferMultiplexer::Add(TransferQueue* queue)
 void
 TransferMultiplexer::SetBandwidth(size_t band)
 {
-  eos::common::RWMutexWriteLock lock(mMutex);
+  {
+    eos::common::RWMutexWriteLock lock(mMutex);
 
-  for (size_t i = 0; i < mQueues.size(); i++) {
-    mQueues[i]->SetBandwidth(band);
+    for (size_t i = 0; i < mQueues.size(); i++) {
+      mQueues[i]->SetBandwidth(band);
+    }
   }
-
-  return;
+  Notify();
 }
 
 //------------------------------------------------------------------------------
@@ -102,79 +144,105 @@ TransferMultiplexer::SetBandwidth(size_t band)
 void
 TransferMultiplexer::SetSlots(size_t slots)
 {
-  eos::common::RWMutexWriteLock lock(mMutex);
+  {
+    eos::common::RWMutexWriteLock lock(mMutex);
 
-  for (size_t i = 0; i < mQueues.size(); i++) {
-    mQueues[i]->SetSlots(slots);
+    for (size_t i = 0; i < mQueues.size(); i++) {
+      mQueues[i]->SetSlots(slots);
+    }
   }
-
-  return;
+  Notify();
 }
 
 //------------------------------------------------------------------------------
-// Static helper function to run the thread
+// Wake up the multiplexer thread
 //------------------------------------------------------------------------------
-void*
-TransferMultiplexer::StaticThreadProc(void* arg)
+void
+TransferMultiplexer::Notify()
 {
-  return reinterpret_cast<TransferMultiplexer*>(arg)->ThreadProc();
+  std::lock_guard<std::mutex> lock(mWakeUpMutex);
+  mWakeUp = true;
+  mWakeUpCv.notify_one();
 }
 
 //------------------------------------------------------------------------------
 // Multiplexer thread loop
 //------------------------------------------------------------------------------
-void*
-TransferMultiplexer::ThreadProc(void)
+void
+TransferMultiplexer::ThreadProc(ThreadAssistant& assistant) noexcept
 {
-  std::string sTmp, src, dest;
   eos_static_info("running transfer multiplexer with %d queues", mQueues.size());
 
-  while (1) {
-    {
-      XrdSysThread::SetCancelOff();
-      eos::common::RWMutexReadLock lock(mMutex);
-
-      for (size_t i = 0; i < mQueues.size(); i++) {
-        while (mQueues[i]->GetQueue()->Size()) {
-          // look in all registered queues
-          // take an entry from the queue
-          int freeslots = mQueues[i]->GetSlots() - mQueues[i]->GetRunning();
-
-          if (freeslots <= 0) {
-            break;
-          }
-
-          eos_static_info("Found %u transfers in queue %s", (unsigned int)
-                          mQueues[i]->GetQueue()->Size(), mQueues[i]->GetName());
-          mQueues[i]->GetQueue()->OpenTransaction();
-          eos::common::TransferJob* cjob = mQueues[i]->GetQueue()->Get();
-          mQueues[i]->GetQueue()->CloseTransaction();
-
-          if (!cjob) {
-            eos_static_err("No transfer job created");
-            break;
-          }
-
-          XrdOucString out = "";
-          cjob->PrintOut(out);
-          eos_static_info("New transfer %s", out.c_str());
-          //create new TransferJob and submit it to the scheduler
-          TransferJob* job = new TransferJob(mQueues[i], cjob,
-                                             mQueues[i]->GetBandwidth());
-          gOFS.TransferSchedulerMutex.Lock();
-          gOFS.TransferScheduler->Schedule(job);
-          gOFS.TransferSchedulerMutex.UnLock();
-          mQueues[i]->IncRunning();
-        }
+  while (!assistant.terminationRequested()) {
+    std::chrono::milliseconds wait = DispatchQueues();
+    std::unique_lock<std::mutex> lock(mWakeUpMutex);
+    mWakeUpCv.wait_for(lock, wait, [&]() {
+      return mWakeUp || assistant.terminationRequested();
+    });
+    mWakeUp = false;
+  }
+
+  // Running jobs still call back into their queues, which outlive us
+}
+
+//------------------------------------------------------------------------------
+// Dispatch the jobs of all queues
+//------------------------------------------------------------------------------
+std::chrono::milliseconds
+TransferMultiplexer::DispatchQueues()
+{
+  std::chrono::milliseconds wait = cIdlePeriod;
+  eos::common::RWMutexReadLock lock(mMutex);
+
+  for (size_t i = 0; i < mQueues.size(); i++) {
+    TransferQueue* queue = mQueues[i];
+
+    if (!queue->GetQueue()) {
+      continue;
+    }
+
+    size_t queued;
+
+    while ((queued = queue->GetQueue()->Size())) {
+      // a finishing job wakes us up again
+      if (queue->GetRunning() >= queue->GetSlots()) {
+        break;
       }
+
+      std::chrono::milliseconds admission = queue->TimeToAdmission();
+
+      if (admission.count()) {
+        // the bucket is in debt, come back once it is paid back
+        wait = std::min(wait, admission);
+        break;
+      }
+
+      eos_static_info("Found %u transfers in queue %s", (unsigned int) queued,
+                      queue->GetName());
+      queue->GetQueue()->OpenTransaction();
+      eos::common::TransferJob* cjob = queue->GetQueue()->Get();
+      queue->GetQueue()->CloseTransaction();
+
+      if (!cjob) {
+        eos_static_err("No transfer job created");
+        break;
+      }
+
+      queue->Dispatched(queued);
+      XrdOucString out = "";
+      cjob->PrintOut(out);
+      eos_static_info("New transfer %s", out.c_str());
+      // create new TransferJob and submit it to the scheduler, the job
+      // decrements the running count when it is over
+      TransferJob* job = new TransferJob(queue, cjob, queue->GetBandwidth());
+      queue->IncRunning();
+      gOFS.TransferSchedulerMutex.Lock();
+      gOFS.TransferScheduler->Schedule(job);
+      gOFS.TransferSchedulerMutex.UnLock();
     }
-    XrdSysThread::SetCancelOn();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
   }
 
-  // Wait that the scheduler is empty, otherwise we might have callbacks
-  // to our queues
-  return NULL;
+  return wait;
 }
 
 EOSFSTNAMESPACE_END
@@ -25,15 +25,26 @@
 #define __EOSFST_TRANSFERMULTIPLEXER__
 
 #include "fst/Namespace.hh"
+#include "common/AssistedThread.hh"
 #include "common/RWMutex.hh"
 #include "fst/txqueue/TransferJob.hh"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <vector>
-#include <pthread.h>
 
 EOSFSTNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
 //! Class TransferMultiplexer
+//!
+//! Dispatches the jobs of a set of transfer queues to the transfer scheduler.
+//! The dispatcher thread sleeps until a job is inserted into one of the
+//! shared queues, a job finishes, the configuration changes or the bandwidth
+//! limit of a queue lets a new job start. A queue runs at most its number of
+//! slots jobs at a time. Each job is limited to the queue bandwidth by eoscp,
+//! a token bucket over the bytes moved by the jobs at bandwidth times slots
+//! smooths the bursts of job starts.
 //------------------------------------------------------------------------------
 class TransferMultiplexer
 {
@@ -81,19 +92,35 @@ public:
   void Stop();
 
   //----------------------------------------------------------------------------
-  //! Static helper function to start the thread.
+  //! Wake up the multiplexer thread
   //----------------------------------------------------------------------------
-  static void* StaticThreadProc(void*);
+  void Notify();
+
+private:
+  //! Longest sleep without any event, only catches changes done behind the
+  //! back of the shared queues
+  static constexpr std::chrono::seconds cIdlePeriod {5};
 
   //----------------------------------------------------------------------------
-  //! Multiplexer thread loop.
+  //! Multiplexer thread loop
   //----------------------------------------------------------------------------
-  void* ThreadProc();
+  void ThreadProc(ThreadAssistant& assistant) noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Dispatch the jobs of all queues as far as slots and bandwidth allow
+  //!
+  //! @return time after which a queue limited by its bandwidth can go on
+  //----------------------------------------------------------------------------
+  std::chrono::milliseconds DispatchQueues();
 
-private:
   eos::common::RWMutex mMutex;
   std::vector<TransferQueue*> mQueues;
-  pthread_t mTid;
+  std::vector<uint64_t> mListeners; ///< Insert listener ids of the queues
+  std::mutex mWakeUpMutex; ///< Mutex protecting the wake up flag
+  std::condition_variable mWakeUpCv; ///< Wakes up the multiplexer thread
+  bool mWakeUp; ///< Pending wake up
+  bool mRunning; ///< Multiplexer thread is running
+  AssistedThread mThread; ///< Multiplexer thread
 };
 
 EOSFSTNAMESPACE_END
@@ -43,6 +43,13 @@ TransferQueue::TransferQueue(eos::common::TransferQueue** queue,
   nslots = slots;
   bandwidth = band;
   mJobEndCallback = 0;
+  mBytesDone = 0;
+  mWaitSumMs = 0;
+  mWaitCount = 0;
+  mStatsTime = TokenBucket::Clock::now();
+  mStatsDone = 0;
+  mStatsBytes = 0;
+  SetBandwidth(band);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -62,6 +69,19 @@ TransferQueue::SetBandwidth(size_t band)
 {
   XrdSysMutexHelper lock(mBandwidthMutex);
   bandwidth = band;
+  ConfigureBucket();
+}
+
+/* ------------------------------------------------------------------------- */
+void
+TransferQueue::ConfigureBucket()
+{
+  // bandwidth is given in MB/s for every running transfer and is enforced by
+  // eoscp, the queue may use it for all its slots. The bucket therefore only
+  // smooths bursts, e.g. bytes charged late at the end of a job, by holding
+  // back new jobs until the debt is paid back at the aggregate rate.
+  double rate = bandwidth * 1000000.0 * GetSlots();
+  mBucket.Configure(rate, rate);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -76,7 +96,73 @@ TransferQueue::GetSlots()
 void
 TransferQueue::SetSlots(size_t slots)
 {
-  XrdSysMutexHelper lock(mSlotsMutex);
-  nslots = slots;
+  {
+    XrdSysMutexHelper lock(mSlotsMutex);
+    nslots = slots;
+  }
+  XrdSysMutexHelper lock(mBandwidthMutex);
+  ConfigureBucket();
+}
+
+/* ------------------------------------------------------------------------- */
+void
+TransferQueue::NotifyInsert()
+{
+  XrdSysMutexHelper lock(mStatsMutex);
+  mInsertTimes.push_back(TokenBucket::Clock::now());
+}
+
+/* ------------------------------------------------------------------------- */
+void
+TransferQueue::Dispatched(size_t queued)
+{
+  XrdSysMutexHelper lock(mStatsMutex);
+
+  // jobs removed by the manager leave their insertion time behind, the
+  // remaining ones are the most recent insertions
+  while (mInsertTimes.size() > queued) {
+    mInsertTimes.pop_front();
+  }
+
+  // jobs queued before the multiplexer started have no insertion time
+  if (!mInsertTimes.empty()) {
+    std::chrono::duration<double, std::milli> wait =
+      TokenBucket::Clock::now() - mInsertTimes.front();
+    mInsertTimes.pop_front();
+    mWaitSumMs += wait.count();
+    mWaitCount++;
+  }
+}
+
+/* ------------------------------------------------------------------------- */
+TransferQueue::Stats
+TransferQueue::CollectStats()
+{
+  Stats stats {0, 0, 0};
+  unsigned long long done, bytes;
+  {
+    XrdSysMutexHelper lock(mJobsRunningMutex);
+    done = mJobsDone;
+    bytes = mBytesDone;
+  }
+  XrdSysMutexHelper lock(mStatsMutex);
+  TokenBucket::Clock::time_point now = TokenBucket::Clock::now();
+  std::chrono::duration<double> elapsed = now - mStatsTime;
+
+  if (mWaitCount) {
+    stats.mWaitMs = mWaitSumMs / mWaitCount;
+  }
+
+  if (elapsed.count() > 0) {
+    stats.mJobRate = (done - mStatsDone) / elapsed.count();
+    stats.mBandwidth = (bytes - mStatsBytes) / elapsed.count() / 1000000.0;
+  }
+
+  mWaitSumMs = 0;
+  mWaitCount = 0;
+  mStatsTime = now;
+  mStatsDone = done;
+  mStatsBytes = bytes;
+  return stats;
 }
 EOSFSTNAMESPACE_END
@@ -26,9 +26,12 @@
 
 /* ------------------------------------------------------------------------- */
 #include "fst/Namespace.hh"
+#include "fst/txqueue/TokenBucket.hh"
 #include "common/TransferQueue.hh"
 /* ------------------------------------------------------------------------- */
 /* ------------------------------------------------------------------------- */
+#include <deque>
+#include <functional>
 #include <string>
 #include <pthread.h>
 
@@ -53,8 +56,30 @@ private:
   XrdSysMutex mCallbackMutex;
 
   XrdSysCondVar* mJobEndCallback;
+  std::function<void()> mDispatchNotify; ///< Wakes up the multiplexer
+
+  TokenBucket mBucket; ///< Bandwidth limit over the transferred bytes
+  unsigned long long mBytesDone; ///< Bytes moved by the finished jobs
+
+  XrdSysMutex mStatsMutex; ///< Protects the wait time statistics
+  std::deque<TokenBucket::Clock::time_point> mInsertTimes; ///< Queued jobs
+  double mWaitSumMs; ///< Sum of the wait times since the last collection
+  unsigned long long mWaitCount; ///< Jobs waited for since last collection
+  TokenBucket::Clock::time_point mStatsTime; ///< Time of last collection
+  unsigned long long mStatsDone; ///< Jobs done at the last collection
+  unsigned long long mStatsBytes; ///< Bytes done at the last collection
+
+  //! Apply the bandwidth and the slots to the limit, mBandwidthMutex held
+  void ConfigureBucket();
 
 public:
+  //! Statistics of a queue between two collections
+  struct Stats {
+    double mWaitMs; ///< Average time spent by the dispatched jobs in the queue
+    double mJobRate; ///< Finished jobs per second
+    double mBandwidth; ///< Transferred MB per second
+  };
+
 
   TransferQueue(eos::common::TransferQueue** queue, const char* name,
                 int slots = 2, int band = 100);
@@ -93,11 +118,27 @@ public:
   }
 
   void
-  DecRunning()
+  SetDispatchNotify(std::function<void()> notify)
   {
+    XrdSysMutexHelper lock(mCallbackMutex);
+    mDispatchNotify = std::move(notify);
+  }
+
+  //! Charge bytes moved by a running job to the bandwidth limit
+  void
+  Charge(unsigned long long bytes)
+  {
+    mBucket.Consume(bytes);
+  }
+
+  void
+  DecRunning(unsigned long long bytes = 0)
+  {
+    // the bytes were charged to the bandwidth limit while the job ran
     XrdSysMutexHelper lock_jobs(mJobsRunningMutex);
     mJobsRunning--;
     mJobsDone++;
+    mBytesDone += bytes;
 
     // signal a call-back condition variable
     {
@@ -106,9 +147,29 @@ public:
       if (mJobEndCallback) {
         mJobEndCallback->Signal();
       }
+
+      if (mDispatchNotify) {
+        mDispatchNotify();
+      }
     }
   }
 
+  //! Check if the bandwidth limit lets a new job start
+  std::chrono::milliseconds
+  TimeToAdmission()
+  {
+    return mBucket.TimeToAvailable();
+  }
+
+  //! Record the insertion of a job into the shared queue
+  void NotifyInsert();
+
+  //! Record the dispatch of a job, drop insertion times of removed jobs
+  void Dispatched(size_t queued);
+
+  //! Collect the statistics since the previous call
+  Stats CollectStats();
+
   size_t
   GetRunning()
   {
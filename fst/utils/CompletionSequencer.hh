@@ -0,0 +1,122 @@
+//------------------------------------------------------------------------------
+// File: CompletionSequencer.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef EOS_FST_UTILS_COMPLETIONSEQUENCER_HH
+#define EOS_FST_UTILS_COMPLETIONSEQUENCER_HH
+
+#include "fst/Namespace.hh"
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Runs the completion handlers of asynchronous requests in submission order
+//!
+//! Every request takes a ticket when it is submitted. Handlers of requests
+//! completing early are parked until all the previous tickets completed, and
+//! only one thread at a time runs handlers, so the handlers never run
+//! concurrently and may update per-file state without further locking.
+//! Header only, it is used both by the OFS and the OSS plugin.
+//------------------------------------------------------------------------------
+class CompletionSequencer
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Take the ticket of a new request
+  //----------------------------------------------------------------------------
+  uint64_t Next()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mNextTicket++;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Mark a request as complete. The handler runs either in the calling
+  //! thread or in the thread completing the last missing previous ticket.
+  //!
+  //! @param ticket ticket obtained from Next
+  //! @param handler function to run in ticket order
+  //----------------------------------------------------------------------------
+  void Complete(uint64_t ticket, std::function<void()> handler)
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mParked.emplace(ticket, std::move(handler));
+
+    if (mDraining) {
+      return;
+    }
+
+    mDraining = true;
+
+    while (!mParked.empty() && (mParked.begin()->first == mNextToRun)) {
+      std::function<void()> next = std::move(mParked.begin()->second);
+      mParked.erase(mParked.begin());
+      lock.unlock();
+
+      if (next) {
+        next();
+      }
+
+      lock.lock();
+      ++mNextToRun;
+    }
+
+    mDraining = false;
+    mCond.notify_all();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Wait until all the tickets taken so far completed
+  //----------------------------------------------------------------------------
+  void WaitAll()
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCond.wait(lock, [this]() {
+      return (mNextToRun == mNextTicket) && !mDraining;
+    });
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the number of requests not completed yet
+  //----------------------------------------------------------------------------
+  uint64_t GetPending()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mNextTicket - mNextToRun;
+  }
+
+private:
+  std::mutex mMutex; ///< Protects all the members
+  std::condition_variable mCond; ///< Signals drained handlers
+  uint64_t mNextTicket = 0; ///< Ticket of the next request
+  uint64_t mNextToRun = 0; ///< Ticket whose handler runs next
+  bool mDraining = false; ///< True while a thread runs handlers
+  std::map<uint64_t, std::function<void()>> mParked; ///< Early completions
+};
+
+EOSFSTNAMESPACE_END
+
+#endif
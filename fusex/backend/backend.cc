@@ -226,6 +226,36 @@ backend::getMD(fuse_req_t req,
   }
 }
 
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+backend::getMDPage(fuse_req_t req,
+                   uint64_t inode,
+                   uint64_t myclock,
+                   const std::string& cursor,
+                   uint32_t limit,
+                   std::vector<eos::fusex::container>& contv,
+                   std::string authid
+                  )
+/* -------------------------------------------------------------------------- */
+{
+  // one page of a listing: the parent record carries the cursor of the next
+  // page or an empty cursor for the last one. Servers without pagination
+  // ignore the parameters and return the complete listing without cursor.
+  XrdCl::URL url(getURL(req, inode, myclock, "fuseX" , "getfusex", "LS",
+                        authid, true));
+  XrdCl::URL::ParamsMap query = url.GetParams();
+  query["mgm.ls.limit"] = std::to_string(limit);
+
+  if (cursor.length()) {
+    query["mgm.ls.cursor"] = cursor;
+  }
+
+  url.SetParams(query);
+  std::string requestURL = url.GetURL();
+  return fetchResponse(requestURL, contv);
+}
+
 /* -------------------------------------------------------------------------- */
 int
 backend::getCAP(fuse_req_t req,
@@ -69,6 +69,15 @@ public:
             std::string authid = ""
            );
 
+  int getMDPage(fuse_req_t req,
+                uint64_t inode,
+                uint64_t myclock,
+                const std::string& cursor,
+                uint32_t limit,
+                std::vector<eos::fusex::container>& cont,
+                std::string authid = ""
+               );
+
   int doLock(fuse_req_t req,
              eos::fusex::md& md,
              XrdSysMutex* locker);
@@ -1,10 +1,13 @@
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <dirent.h>
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 
+#include <chrono>
+
 #include "common/Timing.hh"
 #include "common/ShellCmd.hh"
 
@@ -22,6 +25,7 @@
 #define LOOP_14 100
 #define LOOP_15 100
 #define LOOP_16 100
+#define LISTING_17 10000 // default max entries, override with FUSEX_BENCHMARK_LISTING
 
 int main(int argc, char* argv[])
 {
@@ -632,6 +636,76 @@ int main(int argc, char* argv[])
     COMMONTIMING("mkdir-symlink-loop", &tm);
   }
 
+  // ------------------------------------------------------------------------ //
+  testno = 17;
+
+  if ((testno >= test_start) && (testno <= test_stop)) {
+    fprintf(stderr, ">>> test %04d\n", testno);
+    // directories of 10k, 100k and 1M entries up to the configured maximum,
+    // they are kept: list them again after a remount to measure a cold listing
+    size_t max_entries = getenv("FUSEX_BENCHMARK_LISTING") ?
+                         strtoul(getenv("FUSEX_BENCHMARK_LISTING"), 0, 10) : LISTING_17;
+
+    for (size_t n_entries = 10000; n_entries <= max_entries; n_entries *= 10) {
+      char dname[1024];
+      snprintf(dname, sizeof(dname), "test-listing-%lu", n_entries);
+
+      if (mkdir(dname, S_IRWXU) == 0) {
+        for (size_t i = 0; i < n_entries; i++) {
+          snprintf(name, sizeof(name), "%s/f-%08lu", dname, i);
+          int fd = creat(name, S_IRWXU);
+
+          if (fd < 0) {
+            fprintf(stderr, "[test=%03d] creat failed i=%lu\n", testno, i);
+            exit(testno);
+          }
+
+          close(fd);
+        }
+      } else if (errno != EEXIST) {
+        fprintf(stderr, "[test=%03d] mkdir failed errno=%d\n", testno, errno);
+        exit(testno);
+      }
+
+      snprintf(name, sizeof(name), "listing-create-%lu", n_entries);
+      COMMONTIMING(name, &tm);
+      auto t_start = std::chrono::steady_clock::now();
+      DIR* dir = opendir(dname);
+
+      if (!dir) {
+        fprintf(stderr, "[test=%03d] opendir failed errno=%d\n", testno, errno);
+        exit(testno);
+      }
+
+      size_t n_listed = 0;
+      double first_ms = 0;
+      struct dirent* entry;
+
+      while ((entry = readdir(dir))) {
+        if (!n_listed++) {
+          first_ms = std::chrono::duration<double, std::milli>
+                     (std::chrono::steady_clock::now() - t_start).count();
+        }
+      }
+
+      closedir(dir);
+      double total_ms = std::chrono::duration<double, std::milli>
+                        (std::chrono::steady_clock::now() - t_start).count();
+      snprintf(name, sizeof(name), "listing-readdir-%lu", n_entries);
+      COMMONTIMING(name, &tm);
+
+      // '.' and '..' are listed as well
+      if (n_listed < n_entries + 2) {
+        fprintf(stderr, "[test=%03d] listing incomplete %lu/%lu\n", testno,
+                n_listed, n_entries + 2);
+        exit(testno);
+      }
+
+      fprintf(stderr, "listing entries=%lu first-entry=%.02f ms total=%.02f ms\n",
+              n_entries, first_ms, total_ms);
+    }
+  }
+
 
   tm.Print();
   fprintf(stdout, "realtime = %.02f", tm.RealTime());
@@ -545,6 +545,10 @@ EosFuse::run(int argc, char* argv[], void* userdata)
         root["options"]["md-backend.put.timeout"] = 120;
       }
 
+      if (!root["options"].isMember("md-backend.listing.page")) {
+        root["options"]["md-backend.listing.page"] = 4096;
+      }
+
       if (!root["options"].isMember("data-kernelcache")) {
         root["options"]["data-kernelcache"] = 1;
       }
@@ -804,6 +808,8 @@ EosFuse::run(int argc, char* argv[], void* userdata)
             root["options"]["md-backend.timeout"].asDouble();
     config.options.md_backend_put_timeout =
             root["options"]["md-backend.put.timeout"].asDouble();
+    config.options.md_backend_listing_page =
+            root["options"]["md-backend.listing.page"].asUInt();
     config.options.data_kernelcache = root["options"]["data-kernelcache"].asInt();
     config.options.mkdir_is_sync = root["options"]["mkdir-is-sync"].asInt();
     config.options.create_is_sync = root["options"]["create-is-sync"].asInt();
@@ -2540,6 +2546,31 @@ EosFuse::listdir(fuse_req_t req, fuse_ino_t ino, metad::shared_md& md)
   return rc;
 }
 
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+EosFuse::listdir_next_page(fuse_req_t req, fuse_ino_t ino,
+                           metad::shared_md& md)
+/* -------------------------------------------------------------------------- */
+{
+  eos_static_debug("");
+  int rc = 0;
+  // retrieve cap
+  cap::shared_cap pcap = Instance().caps.acquire(req, ino,
+                                                 S_IFDIR | X_OK | R_OK, true);
+  XrdSysMutexHelper cLock(pcap->Locker());
+
+  if (pcap->errc()) {
+    rc = pcap->errc();
+  } else {
+    std::string authid = pcap->authid();
+    cLock.UnLock();
+    rc = Instance().mds.get_next_page(req, md, authid);
+  }
+
+  return rc;
+}
+
 /* -------------------------------------------------------------------------- */
 void
 /* -------------------------------------------------------------------------- */
@@ -2702,6 +2733,27 @@ EBADF  Invalid directory stream descriptor fi->fh
           break;
         }
 
+        if (pmd->ls_cursor().length()) {
+          // partial listing: serve what we have and pull the next page only
+          // once every known entry has been shown
+          size_t n_shown = 0;
+
+          if (off) {
+            XrdSysMutexHelper lLock(md->items_lock);
+            n_shown = md->readdir_items.size();
+          }
+
+          if (n_shown < pmd->local_children().size()) {
+            break;
+          }
+
+          pmd->Locker().UnLock();
+          eos_static_debug("next listing page int=%#lx", ino);
+          rc = listdir_next_page(req, ino, pmd);
+          pmd->Locker().Lock();
+          continue;
+        }
+
         pmd->Locker().UnLock();
         // refresh the listing
         eos_static_debug("refresh listing int=%#lx", ino);
@@ -2847,6 +2899,8 @@ EBADF  Invalid directory stream descriptor fi->fh
 
         if (strncmp(bname.c_str(), "...eos.ino...",
                     13) == 0) { /* hard link deleted inodes */
+          // skipped entries count as shown for a partial listing
+          md->readdir_items.insert(it->first);
           continue;
         }
 
@@ -2857,6 +2911,7 @@ EBADF  Invalid directory stream descriptor fi->fh
 
           // skip deleted entries or hidden entries
           if (cmd->deleted()) {
+            md->readdir_items.insert(it->first);
             continue;
           }
         }
@@ -53,7 +53,7 @@
 #include <google/dense_hash_map>
 
 // PROTOBUF protocol version announced via heartbeats and attached to URLs by the backend
-#define FUSEPROTOCOLVERSION eos::fusex::heartbeat::PROTOCOLV4
+#define FUSEPROTOCOLVERSION eos::fusex::heartbeat::PROTOCOLV5
 
 class EosFuse : public llfusexx::FuseBase<EosFuse>
 {
@@ -92,6 +92,9 @@ public:
 
   static int listdir(fuse_req_t req, fuse_ino_t ino, metad::shared_md& md);
 
+  static int listdir_next_page(fuse_req_t req, fuse_ino_t ino,
+                               metad::shared_md& md);
+
   static void opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi);
 
   static void readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
@@ -230,6 +233,7 @@ public:
       double md_kernelcache_enoent_timeout;
       double md_backend_timeout;
       double md_backend_put_timeout;
+      uint32_t md_backend_listing_page;
       int data_kernelcache;
       int mkdir_is_sync;
       int create_is_sync;
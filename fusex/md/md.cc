@@ -735,9 +735,19 @@ metad::get(fuse_req_t req,
       }
        */
       eos_static_info("ino=%016lx type=%d", md->md_ino(), md->type());
-      rc = mdbackend->getMD(req, md->md_ino(), listing ? ((md->type() != md->MDLS)
-                            ? 0 : md->clock()) : md->clock(),
-                            contv, listing, authid);
+      uint32_t listing_page =
+        EosFuse::Instance().Config().options.md_backend_listing_page;
+
+      if (listing && listing_page) {
+        // fetch the first page only, readdir pulls the following ones
+        rc = mdbackend->getMDPage(req, md->md_ino(),
+                                  (md->type() != md->MDLS) ? 0 : md->clock(),
+                                  "", listing_page, contv, authid);
+      } else {
+        rc = mdbackend->getMD(req, md->md_ino(), listing ? ((md->type() != md->MDLS)
+                              ? 0 : md->clock()) : md->clock(),
+                              contv, listing, authid);
+      }
     } else {
       if (md->id()) {
         // that can be a locally created entry which is not yet upstream
@@ -1641,9 +1651,50 @@ metad::cleanup(fuse_ino_t ino, bool force)
   }
 }
 
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+metad::get_next_page(fuse_req_t req,
+                     shared_md md,
+                     const std::string authid)
+{
+  uint64_t md_ino = 0;
+  std::string cursor;
+  {
+    XrdSysMutexHelper mLock(md->Locker());
+    md_ino = md->md_ino();
+    cursor = md->ls_cursor();
+  }
+
+  if (!md_ino || cursor.empty()) {
+    return 0;
+  }
+
+  eos_static_info("ino=%016lx cursor=%s", md_ino, cursor.c_str());
+  std::vector<eos::fusex::container> contv;
+  int rc = mdbackend->getMDPage(req, md_ino, 0, cursor,
+                                EosFuse::Instance().Config().options.md_backend_listing_page,
+                                contv, authid);
+
+  if (!rc) {
+    for (auto it = contv.begin(); it != contv.end(); ++it) {
+      if (it->ref_inode_() && !apply(req, *it, true, true)) {
+        eos_static_crit("msg=\"failed to apply listing page\"");
+      }
+    }
+  } else {
+    // drop the partial listing, the next listdir starts over
+    XrdSysMutexHelper mLock(md->Locker());
+    md->clear_ls_cursor();
+  }
+
+  return rc;
+}
+
 /* -------------------------------------------------------------------------- */
 uint64_t
-metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
+metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing,
+             bool next_page)
 {
   // apply receives either a single MD record or a parent MD + all children MD
   // we have to make sure that the modification of children is atomic in the parent object
@@ -1754,6 +1805,13 @@ metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
     return ino;
   } else if (cont.type() == cont.MDMAP) {
     uint64_t p_ino = inomap.forward(cont.ref_inode_());
+    // a paginated listing has more pages to come if the parent has a cursor
+    std::string ls_cursor;
+    auto pit = cont.md_map_().md_map_().find(cont.ref_inode_());
+
+    if (pit != cont.md_map_().md_map_().end()) {
+      ls_cursor = pit->second.ls_cursor();
+    }
 
     for (auto map = cont.md_map_().md_map_().begin();
          map != cont.md_map_().md_map_().end(); ++map) {
@@ -1910,7 +1968,8 @@ metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
               eos_static_debug("cap count %d\n", pmd->cap_count());
             }
 
-            if (!pmd->cap_count()) {
+            // the following pages of a listing add to the first one
+            if (!pmd->cap_count() && !next_page) {
               if (EOS_LOGS_DEBUG) {
                 eos_static_debug("clearing out %0016lx", pmd->id());
               }
@@ -1972,7 +2031,7 @@ metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
             eos_static_debug("cap count %d\n", pmd->cap_count());
           }
 
-          if (!pmd->cap_count()) {
+          if (!pmd->cap_count() && !next_page) {
             if (EOS_LOGS_DEBUG) {
               eos_static_debug("clearing out %0016lx", pmd->id());
             }
@@ -2018,8 +2077,15 @@ metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
           eos_static_debug("listing: %s [%#lx]", map->first.c_str(), map->second);
         }
 
-      // now flag as a complete listing
-      pmd->set_type(pmd->MDLS);
+      pmd->set_ls_cursor(ls_cursor);
+
+      if (ls_cursor.empty()) {
+        // now flag as a complete listing
+        pmd->set_type(pmd->MDLS);
+      } else {
+        // partial listing, readdir pulls the next page once it is consumed
+        pmd->set_type(pmd->MD);
+      }
     }
 
     if (pmd) {
@@ -2486,9 +2552,22 @@ metad::mdcommunicate(ThreadAssistant& assistant)
           } while (more);
 
           std::string s((const char*) zmq_msg_data(&message), zmq_msg_size(&message));
+          std::vector<eos::fusex::response> rsps;
           rsp.Clear();
 
-          if (rsp.ParseFromString(s)) {
+          if (!rsp.ParseFromString(s)) {
+            eos_static_err("unable to parse message");
+          } else if (rsp.type() == rsp.BATCH) {
+            // a PROTOCOLV5 server sends several messages for us in one go
+            rsps.assign(rsp.batch_().begin(), rsp.batch_().end());
+          } else {
+            rsps.resize(1);
+            rsps.back().Swap(&rsp);
+          }
+
+          for (auto& next : rsps) {
+            rsp.Swap(&next);
+
             if (rsp.type() == rsp.EVICT) {
               eos_static_crit("evict message from MD server - instruction: %s",
                               rsp.evict_().reason().c_str());
@@ -2873,8 +2952,6 @@ metad::mdcommunicate(ThreadAssistant& assistant)
                 }
               }
             }
-          } else {
-            eos_static_err("unable to parse message");
           }
 
           zmq_msg_close(&message);
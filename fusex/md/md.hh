@@ -500,6 +500,14 @@ public:
                 bool readdir = false
                );
 
+  //----------------------------------------------------------------------------
+  //! Fetch the next page of a paginated listing and merge it into the
+  //! children of md. Does nothing if the listing of md is complete.
+  //----------------------------------------------------------------------------
+  int get_next_page(fuse_req_t req,
+                    shared_md md,
+                    const std::string authid = "");
+
   uint64_t insert(fuse_req_t req,
                   shared_md md,
                   std::string authid);
@@ -532,7 +540,8 @@ public:
   std::string dump_md(eos::fusex::md& md);
   std::string dump_container(eos::fusex::container& cont);
 
-  uint64_t apply(fuse_req_t req, eos::fusex::container& cont, bool listing);
+  uint64_t apply(fuse_req_t req, eos::fusex::container& cont, bool listing,
+                 bool next_page = false);
 
   int getlk(fuse_req_t req, shared_md md, struct flock* lock);
   int setlk(fuse_req_t req, shared_md md, struct flock* lock, int sleep);
@@ -0,0 +1,212 @@
+//------------------------------------------------------------------------------
+// File: FsAggregate.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/FsAggregate.hh"
+#include "common/StringConversion.hh"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Compare two values computed in a different order
+//------------------------------------------------------------------------------
+bool
+Close(double a, double b, double scale)
+{
+  return (std::fabs(a - b) <= 1e-6 * (std::fabs(scale) + std::fabs(a) +
+          std::fabs(b)) + 1e-9);
+}
+}
+
+//------------------------------------------------------------------------------
+// Parse a query string
+//------------------------------------------------------------------------------
+FsAggregate::Query::Query(const std::string& query):
+  mParam(query)
+{
+  size_t qpos = mParam.find("?");
+
+  if (qpos != std::string::npos) {
+    std::string selection = mParam.substr(qpos + 1);
+    mParam.erase(qpos);
+    std::vector<std::string> token;
+    std::string delimiter = "@";
+    eos::common::StringConversion::Tokenize(selection, token, delimiter);
+
+    if (token.size()) {
+      mKey = token[0];
+    }
+
+    if (token.size() > 1) {
+      mValue = token[1];
+    }
+
+    mIsQuery = true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+FsAggregate::FsAggregate(const std::string& query):
+  mQuery(query)
+{}
+
+//------------------------------------------------------------------------------
+// Insert or replace the contribution of a filesystem
+//------------------------------------------------------------------------------
+void
+FsAggregate::Set(unsigned int fsid, const Sample& sample)
+{
+  auto it = mSamples.find(fsid);
+
+  if (it != mSamples.end()) {
+    if ((it->second.mLongValue == sample.mLongValue) &&
+        (it->second.mValue == sample.mValue) &&
+        (it->second.mConsidered == sample.mConsidered)) {
+      return;
+    }
+
+    Accumulate(it->second, -1);
+    it->second = sample;
+  } else {
+    mSamples.emplace(fsid, sample);
+  }
+
+  Accumulate(sample, 1);
+}
+
+//------------------------------------------------------------------------------
+// Remove the contribution of a filesystem
+//------------------------------------------------------------------------------
+void
+FsAggregate::Remove(unsigned int fsid)
+{
+  auto it = mSamples.find(fsid);
+
+  if (it != mSamples.end()) {
+    Accumulate(it->second, -1);
+    mSamples.erase(it);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop all the contributions
+//------------------------------------------------------------------------------
+void
+FsAggregate::Clear()
+{
+  mSamples.clear();
+  mConsidered.clear();
+  mLongSum = 0;
+  mSum = 0;
+  mShift = 0;
+  mHasShift = false;
+  mShiftedSum = 0;
+  mShiftedSumSq = 0;
+}
+
+//------------------------------------------------------------------------------
+// Add or subtract a sample to the running sums
+//------------------------------------------------------------------------------
+void
+FsAggregate::Accumulate(const Sample& sample, int sign)
+{
+  mLongSum += sign * sample.mLongValue;
+  mSum += sign * sample.mValue;
+
+  if (!sample.mConsidered) {
+    return;
+  }
+
+  if (sign > 0) {
+    if (!mHasShift) {
+      mShift = sample.mValue;
+      mHasShift = true;
+    }
+
+    mConsidered.insert(sample.mValue);
+  } else {
+    auto it = mConsidered.find(sample.mValue);
+
+    if (it != mConsidered.end()) {
+      mConsidered.erase(it);
+    }
+  }
+
+  double shifted = sample.mValue - mShift;
+  mShiftedSum += sign * shifted;
+  mShiftedSumSq += sign * shifted * shifted;
+
+  if (mConsidered.empty()) {
+    // Restart from exact zeros once nothing is left
+    mHasShift = false;
+    mShift = 0;
+    mShiftedSum = 0;
+    mShiftedSumSq = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the statistics
+//------------------------------------------------------------------------------
+FsAggregate::Stats
+FsAggregate::GetStats() const
+{
+  Stats stats;
+  stats.mLongSum = mLongSum;
+  stats.mSum = mSum;
+  stats.mCount = mConsidered.size();
+
+  if (stats.mCount) {
+    double mean = mShiftedSum / stats.mCount;
+    double var = mShiftedSumSq / stats.mCount - mean * mean;
+    stats.mAvg = mShift + mean;
+    stats.mSigma = (var > 0) ? std::sqrt(var) : 0;
+    stats.mMin = *mConsidered.begin();
+    stats.mMax = *mConsidered.rbegin();
+  }
+
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+// Compare with another aggregate
+//------------------------------------------------------------------------------
+bool
+FsAggregate::Matches(const FsAggregate& other) const
+{
+  Stats a = GetStats();
+  Stats b = other.GetStats();
+  double scale = std::max(std::fabs(a.mMin), std::fabs(a.mMax));
+  return ((a.mLongSum == b.mLongSum) && (a.mCount == b.mCount) &&
+          (mSamples.size() == other.mSamples.size()) &&
+          Close(a.mSum, b.mSum, 0) && Close(a.mAvg, b.mAvg, 0) &&
+          Close(a.mSigma, b.mSigma, scale) &&
+          (a.mMin == b.mMin) && (a.mMax == b.mMax));
+}
+
+EOSMGMNAMESPACE_END
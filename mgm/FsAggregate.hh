@@ -0,0 +1,173 @@
+//------------------------------------------------------------------------------
+//! @file FsAggregate.hh
+//! @brief Running aggregate of a filesystem parameter over a view
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSMGM_FSAGGREGATE_HH__
+#define __EOSMGM_FSAGGREGATE_HH__
+
+#include "mgm/Namespace.hh"
+#include <ctime>
+#include <map>
+#include <set>
+#include <string>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class FsAggregate
+//!
+//! Keeps the contribution of every filesystem of a view to one parameter
+//! together with the running sum, count, sum of squares, min and max, so that
+//! a changed filesystem value is folded in by replacing its contribution
+//! instead of rescanning the whole view. The squares are accumulated relative
+//! to a shift value taken at the first insertion to limit the cancellation
+//! when computing the standard deviation of large values.
+//------------------------------------------------------------------------------
+class FsAggregate
+{
+public:
+  //! Parsed "<param>[?<key>@<value>]" query
+  struct Query {
+    std::string mParam; ///< Parameter to aggregate
+    std::string mKey; ///< Selection key, empty if no selection
+    std::string mValue; ///< Selection value
+    bool mIsQuery = false; ///< True if a selection is given
+
+    //--------------------------------------------------------------------------
+    //! Parse a query string
+    //!
+    //! @param query "<param>[?<key>@<value>]"
+    //--------------------------------------------------------------------------
+    explicit Query(const std::string& query);
+  };
+
+  //! Contribution of one filesystem
+  struct Sample {
+    long long mLongValue = 0; ///< Value taken into the integer sum
+    double mValue = 0; ///< Value taken into the floating point statistics
+    bool mConsidered = false; ///< Value counted in average/deviations
+  };
+
+  //! Statistics over the considered samples
+  struct Stats {
+    long long mLongSum = 0; ///< Integer sum over all the samples
+    double mSum = 0; ///< Sum over all the samples
+    long long mCount = 0; ///< Number of considered samples
+    double mAvg = 0; ///< Average of the considered samples
+    double mSigma = 0; ///< Standard deviation of the considered samples
+    double mMin = 0; ///< Minimum of the considered samples
+    double mMax = 0; ///< Maximum of the considered samples
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param query query string the aggregate is computed for
+  //----------------------------------------------------------------------------
+  explicit FsAggregate(const std::string& query);
+
+  //----------------------------------------------------------------------------
+  //! Get the parsed query
+  //----------------------------------------------------------------------------
+  inline const Query& GetQuery() const
+  {
+    return mQuery;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Insert or replace the contribution of a filesystem
+  //!
+  //! @param fsid filesystem id
+  //! @param sample new contribution
+  //----------------------------------------------------------------------------
+  void Set(unsigned int fsid, const Sample& sample);
+
+  //----------------------------------------------------------------------------
+  //! Remove the contribution of a filesystem
+  //!
+  //! @param fsid filesystem id
+  //----------------------------------------------------------------------------
+  void Remove(unsigned int fsid);
+
+  //----------------------------------------------------------------------------
+  //! Check if a filesystem contributes to the aggregate
+  //----------------------------------------------------------------------------
+  inline bool Has(unsigned int fsid) const
+  {
+    return (mSamples.count(fsid) != 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the number of contributing filesystems
+  //----------------------------------------------------------------------------
+  inline size_t Size() const
+  {
+    return mSamples.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop all the contributions
+  //----------------------------------------------------------------------------
+  void Clear();
+
+  //----------------------------------------------------------------------------
+  //! Get the statistics, O(1)
+  //----------------------------------------------------------------------------
+  Stats GetStats() const;
+
+  //----------------------------------------------------------------------------
+  //! Check if the statistics match the ones of another aggregate up to
+  //! rounding errors of the incremental updates
+  //!
+  //! @param other aggregate to compare with e.g. a full recomputation
+  //!
+  //! @return true if matching
+  //----------------------------------------------------------------------------
+  bool Matches(const FsAggregate& other) const;
+
+  //! Set when the view membership changed and a full recomputation is needed
+  bool mInvalid = false;
+  time_t mLastAccess = 0; ///< Last time the aggregate was read
+
+private:
+  //----------------------------------------------------------------------------
+  //! Add or subtract a sample to the running sums
+  //!
+  //! @param sample contribution
+  //! @param sign +1 to add, -1 to subtract
+  //----------------------------------------------------------------------------
+  void Accumulate(const Sample& sample, int sign);
+
+  Query mQuery; ///< Parsed query
+  std::map<unsigned int, Sample> mSamples; ///< Contribution by filesystem
+  std::multiset<double> mConsidered; ///< Values of the considered samples
+  long long mLongSum = 0; ///< Integer sum over all the samples
+  double mSum = 0; ///< Sum over all the samples
+  double mShift = 0; ///< Shift applied to the considered values
+  bool mHasShift = false; ///< True once mShift is set
+  double mShiftedSum = 0; ///< Sum of the shifted considered values
+  double mShiftedSumSq = 0; ///< Sum of squares of the shifted considered values
+};
+
+EOSMGMNAMESPACE_END
+
+#endif
@@ -22,6 +22,7 @@
  ************************************************************************/
 
 #include <cfloat>
+#include <cstring>
 #include <curl/curl.h>
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/IMaster.hh"
@@ -44,6 +45,9 @@ std::string FsGroup::gConfigQueuePrefix;
 std::string FsNode::gConfigQueuePrefix;
 std::atomic<bool> FsSpace::gDisableDefaults {false};
 IConfigEngine* FsView::sConfEngine {nullptr};
+constexpr time_t BaseView::sAggregateExpiry;
+constexpr const char* FsView::sAggregateSubscriber;
+constexpr time_t FsView::sAggregateCheckInterval;
 
 //------------------------------------------------------------------------------
 // Destructor - destructs all the branches starting at this node
@@ -2387,6 +2391,149 @@ FsView::HeartBeatCheck(ThreadAssistant& assistant) noexcept
   }
 }
 
+//------------------------------------------------------------------------------
+// Subscribe the aggregate updater to the modifications of file system keys
+//------------------------------------------------------------------------------
+void
+FsView::WatchAggregateKeys(const std::set<std::string>& keys)
+{
+  std::lock_guard<std::mutex> lock(mAggregateKeysMutex);
+
+  for (const auto& key : keys) {
+    if (mAggregateKeys.insert(key).second) {
+      gOFS->ObjectNotifier.SubscribesToKey(sAggregateSubscriber, key,
+                                           XrdMqSharedObjectChangeNotifier::kMqSubjectModification);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Thread loop function updating the view aggregates from the modifications
+// of the file system keys they use
+//------------------------------------------------------------------------------
+void
+FsView::AggregateUpdater(ThreadAssistant& assistant) noexcept
+{
+  gOFS->ObjectNotifier.BindCurrentThread(sAggregateSubscriber);
+
+  if (!gOFS->ObjectNotifier.StartNotifyCurrentThread()) {
+    eos_crit("%s", "msg=\"error starting shared objects change notifications "
+             "for the view aggregates\"");
+    return;
+  }
+
+  mAggregatesEnabled = true;
+  // Queue path to file system id lookup, checked on every use
+  std::map<std::string, eos::common::FileSystem::fsid_t> queue2fsid;
+  time_t last_check = time(NULL);
+
+  while (!assistant.terminationRequested()) {
+    gOFS->ObjectNotifier.tlSubscriber->mSubjSem.Wait(1);
+    // Modified keys by file system queue path
+    std::map<std::string, std::set<std::string>> modified;
+    gOFS->ObjectNotifier.tlSubscriber->mSubjMtx.Lock();
+
+    while (gOFS->ObjectNotifier.tlSubscriber->NotificationSubjects.size()) {
+      XrdMqSharedObjectManager::Notification event =
+        gOFS->ObjectNotifier.tlSubscriber->NotificationSubjects.front();
+      gOFS->ObjectNotifier.tlSubscriber->NotificationSubjects.pop_front();
+      size_t dpos = event.mSubject.find(";");
+
+      if ((event.mType == XrdMqSharedObjectManager::kMqSubjectModification) &&
+          (dpos != std::string::npos)) {
+        modified[event.mSubject.substr(0, dpos)].insert(
+          event.mSubject.substr(dpos + 1));
+      }
+    }
+
+    gOFS->ObjectNotifier.tlSubscriber->mSubjMtx.UnLock();
+    time_t now = time(NULL);
+    bool check = (now - last_check >= sAggregateCheckInterval);
+
+    if (modified.empty() && !check) {
+      continue;
+    }
+
+    eos::common::RWMutexReadLock lock(ViewMutex);
+
+    for (const auto& elem : modified) {
+      FileSystem* fs = nullptr;
+      auto it_q = queue2fsid.find(elem.first);
+
+      if (it_q != queue2fsid.end()) {
+        auto it_fs = mIdView.find(it_q->second);
+
+        if ((it_fs != mIdView.end()) && it_fs->second &&
+            (it_fs->second->GetQueuePath() == elem.first)) {
+          fs = it_fs->second;
+        }
+      }
+
+      if (fs == nullptr) {
+        // Unknown queue path e.g. a node queue or a new file system
+        queue2fsid.clear();
+
+        for (auto it_fs = mIdView.begin(); it_fs != mIdView.end(); ++it_fs) {
+          if (it_fs->second) {
+            queue2fsid[it_fs->second->GetQueuePath()] = it_fs->first;
+          }
+        }
+
+        it_q = queue2fsid.find(elem.first);
+
+        if (it_q == queue2fsid.end()) {
+          continue;
+        }
+
+        fs = mIdView[it_q->second];
+      }
+
+      std::string group = fs->GetString("schedgroup");
+      std::string space = group.substr(0, group.find("."));
+      auto it_space = mSpaceView.find(space);
+      auto it_group = mGroupView.find(group);
+      auto it_node = mNodeView.find(fs->GetQueue());
+
+      if (it_space != mSpaceView.end()) {
+        it_space->second->UpdateAggregates(it_q->second, elem.second);
+      }
+
+      if (it_group != mGroupView.end()) {
+        it_group->second->UpdateAggregates(it_q->second, elem.second);
+      }
+
+      if (it_node != mNodeView.end()) {
+        it_node->second->UpdateAggregates(it_q->second, elem.second);
+      }
+    }
+
+    if (check) {
+      size_t num_drifted = 0;
+      last_check = now;
+
+      for (auto& elem : mSpaceView) {
+        num_drifted += elem.second->CheckAggregates(now);
+      }
+
+      for (auto& elem : mGroupView) {
+        num_drifted += elem.second->CheckAggregates(now);
+      }
+
+      for (auto& elem : mNodeView) {
+        num_drifted += elem.second->CheckAggregates(now);
+      }
+
+      if (num_drifted) {
+        eos_warning("msg=\"recomputed drifted view aggregates\" count=%lu",
+                    num_drifted);
+      }
+    }
+  }
+
+  mAggregatesEnabled = false;
+  gOFS->ObjectNotifier.StopNotifyCurrentThread();
+}
+
 //------------------------------------------------------------------------------
 // Return a view member variable
 //------------------------------------------------------------------------------
@@ -3169,6 +3316,16 @@ FsView::BroadcastMasterId(const std::string master_id)
   }
 }
 
+//------------------------------------------------------------------------------
+// Check if a query only counts the file systems i.e. "<param>?*@*"
+//------------------------------------------------------------------------------
+static bool
+IsCountQuery(const char* param)
+{
+  size_t len = strlen(param);
+  return ((len >= 4) && !strcmp(param + len - 4, "?*@*"));
+}
+
 //------------------------------------------------------------------------------
 // Computes the sum for <param> as long
 // param="<param>[?<key>=<value] allows to select with matches
@@ -3182,89 +3339,38 @@ BaseView::SumLongLong(const char* param, bool lock,
   }
 
   long long sum = 0;
-  std::string sparam = param;
-  size_t qpos = 0;
-  std::string key = "";
-  std::string value = "";
-  bool isquery = false;
-
-  if ((qpos = sparam.find("?")) != std::string::npos) {
-    std::string query = sparam;
-    query.erase(0, qpos + 1);
-    sparam.erase(qpos);
-    std::vector<std::string> token;
-    std::string delimiter = "@";
-    eos::common::StringConversion::Tokenize(query, token, delimiter);
-    key = token[0];
-    value = token[1];
-    isquery = true;
-  }
-
-  if (isquery && key == "*" && value == "*") {
-    // we just count the number of entries
-    if (subset) {
-      return subset->size();
-    } else {
-      return size();
-    }
-  }
+  FsAggregate::Stats stats;
 
-  if (subset) {
-    for (auto it = subset->begin(); it != subset->end(); it++) {
-      eos::common::FileSystem::fs_snapshot snapshot;
-
-      // for query sum's we always fold in that a group and host has to be enabled
-      if ((!key.length())
-          || (FsView::gFsView.mIdView[*it]->GetString(key.c_str()) == value)) {
-        if (isquery &&
-            ((!eos::common::FileSystem::GetActiveStatusFromString(
-                FsView::gFsView.mIdView[*it]->GetString("stat.active").c_str())) ||
-             (eos::common::FileSystem::GetStatusFromString(
-                FsView::gFsView.mIdView[*it]->GetString("stat.boot").c_str()) !=
-              eos::common::FileSystem::kBooted))) {
-          continue;
-        }
-
-        long long v = FsView::gFsView.mIdView[*it]->GetLongLong(sparam.c_str());
+  if (!subset && !IsCountQuery(param) &&
+      GetAggregateStats(kSum, param, stats)) {
+    sum = stats.mLongSum;
+  } else {
+    FsAggregate::Query query(param);
 
-        if (isquery && v && (sparam == "stat.statfs.capacity")) {
-          // Correct the capacity(rw) value for headroom
-          v -= FsView::gFsView.mIdView[*it]->GetLongLong("headroom");
-        }
+    if (query.mIsQuery && query.mKey == "*" && query.mValue == "*") {
+      // we just count the number of entries
+      sum = (subset ? subset->size() : size());
 
-        sum += v;
+      if (lock) {
+        FsView::gFsView.ViewMutex.UnLockRead();
       }
-    }
-  } else {
-    for (auto it = begin(); it != end(); ++it) {
-      eos::common::FileSystem::fs_snapshot snapshot;
-
-      // for query sum's we always fold in that a group and host has to be enabled
-      if ((!key.length())
-          || (FsView::gFsView.mIdView[*it]->GetString(key.c_str()) == value)) {
-        if (isquery &&
-            ((!eos::common::FileSystem::GetActiveStatusFromString(
-                FsView::gFsView.mIdView[*it]->GetString("stat.active").c_str())) ||
-             (eos::common::FileSystem::GetStatusFromString(
-                FsView::gFsView.mIdView[*it]->GetString("stat.boot").c_str()) !=
-              eos::common::FileSystem::kBooted))) {
-          continue;
-        }
 
-        long long v = FsView::gFsView.mIdView[*it]->GetLongLong(sparam.c_str());
-
-        if (isquery && v && (sparam == "stat.statfs.capacity")) {
-          // correct the capacity(rw) value for headroom
-          v -= FsView::gFsView.mIdView[*it]->GetLongLong("headroom");
-        }
+      return sum;
+    }
 
-        sum += v;
+    if (subset) {
+      for (auto it = subset->begin(); it != subset->end(); it++) {
+        sum += GetSample(kSum, query, *it).mLongValue;
+      }
+    } else {
+      for (auto it = begin(); it != end(); ++it) {
+        sum += GetSample(kSum, query, *it).mLongValue;
       }
     }
   }
 
   // We have to rescale the stat.net parameters because they arrive for each filesystem
-  if (!sparam.compare(0, 8, "stat.net")) {
+  if (!strncmp(param, "stat.net", 8)) {
     if (mType == "spaceview") {
       // divide by the number of "cfg.groupmod"
       std::string gsize = "";
@@ -3306,6 +3412,16 @@ BaseView::SumDouble(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
+  FsAggregate::Stats stats;
+
+  if (!subset && GetAggregateStats(kDouble, param, stats)) {
+    if (lock) {
+      FsView::gFsView.ViewMutex.UnLockRead();
+    }
+
+    return stats.mSum;
+  }
+
   double sum = 0;
 
   if (subset) {
@@ -3338,6 +3454,16 @@ BaseView::AverageDouble(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
+  FsAggregate::Stats stats;
+
+  if (!subset && GetAggregateStats(kDouble, param, stats)) {
+    if (lock) {
+      FsView::gFsView.ViewMutex.UnLockRead();
+    }
+
+    return stats.mAvg;
+  }
+
   double sum = 0;
   int cnt = 0;
 
@@ -3403,6 +3529,17 @@ BaseView::MaxAbsDeviation(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
+  FsAggregate::Stats stats;
+
+  if (!subset && GetAggregateStats(kDouble, param, stats)) {
+    if (lock) {
+      FsView::gFsView.ViewMutex.UnLockRead();
+    }
+
+    return std::max(fabs(stats.mAvg - stats.mMin),
+                    fabs(stats.mMax - stats.mAvg));
+  }
+
   double avg = AverageDouble(param, false);
   double maxabsdev = 0;
   double dev = 0;
@@ -3476,6 +3613,16 @@ BaseView::MaxDeviation(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
+  FsAggregate::Stats stats;
+
+  if (!subset && GetAggregateStats(kDouble, param, stats)) {
+    if (lock) {
+      FsView::gFsView.ViewMutex.UnLockRead();
+    }
+
+    return (stats.mCount ? (stats.mMax - stats.mAvg) : -DBL_MAX);
+  }
+
   double avg = AverageDouble(param, false);
   double maxdev = -DBL_MAX;
   double dev = 0;
@@ -3548,6 +3695,16 @@ BaseView::MinDeviation(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
+  FsAggregate::Stats stats;
+
+  if (!subset && GetAggregateStats(kDouble, param, stats)) {
+    if (lock) {
+      FsView::gFsView.ViewMutex.UnLockRead();
+    }
+
+    return (stats.mCount ? (stats.mMin - stats.mAvg) : DBL_MAX);
+  }
+
   double avg = AverageDouble(param, false);
   double mindev = DBL_MAX;
   double dev = 0;
@@ -3620,6 +3777,16 @@ BaseView::SigmaDouble(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
+  FsAggregate::Stats stats;
+
+  if (!subset && GetAggregateStats(kDouble, param, stats)) {
+    if (lock) {
+      FsView::gFsView.ViewMutex.UnLockRead();
+    }
+
+    return stats.mSigma;
+  }
+
   double avg = AverageDouble(param, false);
   double sumsquare = 0;
   int cnt = 0;
@@ -3688,6 +3855,16 @@ BaseView::ConsiderCount(bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
+  FsAggregate::Stats stats;
+
+  if (!subset && GetAggregateStats(kDouble, "", stats)) {
+    if (lock) {
+      FsView::gFsView.ViewMutex.UnLockRead();
+    }
+
+    return stats.mCount;
+  }
+
   long long cnt = 0;
 
   if (subset) {
@@ -3739,6 +3916,258 @@ BaseView::ConsiderCount(bool lock,
   return cnt;
 }
 
+//------------------------------------------------------------------------------
+// Insert a file system into the view
+//------------------------------------------------------------------------------
+bool
+BaseView::insert(const eos::common::FileSystem::fsid_t& fs)
+{
+  bool done = GeoTree::insert(fs);
+  std::lock_guard<std::mutex> lock(mAggregateMutex);
+
+  for (auto& aggregates : mAggregates) {
+    for (auto& elem : aggregates) {
+      elem.second->mInvalid = true;
+    }
+  }
+
+  return done;
+}
+
+//------------------------------------------------------------------------------
+// Remove a file system from the view
+//------------------------------------------------------------------------------
+bool
+BaseView::erase(const eos::common::FileSystem::fsid_t& fs)
+{
+  bool done = GeoTree::erase(fs);
+  std::lock_guard<std::mutex> lock(mAggregateMutex);
+
+  for (auto& aggregates : mAggregates) {
+    for (auto& elem : aggregates) {
+      elem.second->mInvalid = true;
+    }
+  }
+
+  return done;
+}
+
+//------------------------------------------------------------------------------
+// Check if a file system is taken into averages and deviations
+//------------------------------------------------------------------------------
+bool
+BaseView::IsConsidered(FileSystem* fs)
+{
+  if (mType == "groupview") {
+    // we only count filesystem which are >=kRO and booted for averages in the group view
+    if ((fs->GetConfigStatus() < eos::common::FileSystem::kRO) ||
+        (fs->GetStatus() != eos::common::FileSystem::kBooted) ||
+        (fs->GetActiveStatus() == eos::common::FileSystem::kOffline)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Compute the contribution of a file system to an aggregate
+//------------------------------------------------------------------------------
+FsAggregate::Sample
+BaseView::GetSample(AggregateType type, const FsAggregate::Query& query,
+                    eos::common::FileSystem::fsid_t fsid)
+{
+  FsAggregate::Sample sample;
+  auto it = FsView::gFsView.mIdView.find(fsid);
+
+  if ((it == FsView::gFsView.mIdView.end()) || (it->second == nullptr)) {
+    return sample;
+  }
+
+  FileSystem* fs = it->second;
+
+  if (type == kDouble) {
+    sample.mValue = fs->GetDouble(query.mParam.c_str());
+    sample.mConsidered = IsConsidered(fs);
+    return sample;
+  }
+
+  if (query.mKey.length() && (fs->GetString(query.mKey.c_str()) != query.mValue)) {
+    return sample;
+  }
+
+  // for query sum's we always fold in that a group and host has to be enabled
+  if (query.mIsQuery &&
+      ((!eos::common::FileSystem::GetActiveStatusFromString(
+          fs->GetString("stat.active").c_str())) ||
+       (eos::common::FileSystem::GetStatusFromString(
+          fs->GetString("stat.boot").c_str()) != eos::common::FileSystem::kBooted))) {
+    return sample;
+  }
+
+  long long v = fs->GetLongLong(query.mParam.c_str());
+
+  if (query.mIsQuery && v && (query.mParam == "stat.statfs.capacity")) {
+    // correct the capacity(rw) value for headroom
+    v -= fs->GetLongLong("headroom");
+  }
+
+  sample.mLongValue = v;
+  return sample;
+}
+
+//------------------------------------------------------------------------------
+// Get the file system keys an aggregate depends on
+//------------------------------------------------------------------------------
+void
+BaseView::GetAggregateKeys(AggregateType type, const FsAggregate::Query& query,
+                           std::set<std::string>& keys) const
+{
+  if (query.mParam.length()) {
+    keys.insert(query.mParam);
+  }
+
+  if (type == kDouble) {
+    if (mType == "groupview") {
+      keys.insert("configstatus");
+      keys.insert("stat.boot");
+      keys.insert("stat.active");
+    }
+  } else if (query.mIsQuery) {
+    if (query.mKey.length()) {
+      keys.insert(query.mKey);
+    }
+
+    keys.insert("stat.boot");
+    keys.insert("stat.active");
+
+    if (query.mParam == "stat.statfs.capacity") {
+      keys.insert("headroom");
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Fill an aggregate with the values of all the file systems of the view
+//------------------------------------------------------------------------------
+void
+BaseView::FillAggregate(AggregateType type, FsAggregate& aggregate)
+{
+  aggregate.Clear();
+
+  for (auto it = begin(); it != end(); ++it) {
+    aggregate.Set(*it, GetSample(type, aggregate.GetQuery(), *it));
+  }
+
+  aggregate.mInvalid = false;
+}
+
+//------------------------------------------------------------------------------
+// Get the statistics of an aggregate, creating or recomputing it if needed
+//------------------------------------------------------------------------------
+bool
+BaseView::GetAggregateStats(AggregateType type, const char* param,
+                            FsAggregate::Stats& stats)
+{
+  if (!FsView::gFsView.AggregatesEnabled()) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mAggregateMutex);
+  auto& aggregates = mAggregates[type];
+  auto it = aggregates.find(param);
+
+  if (it == aggregates.end()) {
+    std::unique_ptr<FsAggregate> aggregate(new FsAggregate(param));
+    std::set<std::string> keys;
+    GetAggregateKeys(type, aggregate->GetQuery(), keys);
+    // Subscribe before filling so that no modification is lost in between
+    FsView::gFsView.WatchAggregateKeys(keys);
+    FillAggregate(type, *aggregate);
+    it = aggregates.emplace(param, std::move(aggregate)).first;
+  } else if (it->second->mInvalid) {
+    FillAggregate(type, *it->second);
+  }
+
+  it->second->mLastAccess = time(NULL);
+  stats = it->second->GetStats();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Fold the current values of a file system into the aggregates
+//------------------------------------------------------------------------------
+void
+BaseView::UpdateAggregates(eos::common::FileSystem::fsid_t fsid,
+                           const std::set<std::string>& keys)
+{
+  std::lock_guard<std::mutex> lock(mAggregateMutex);
+
+  for (int type = 0; type < kNumAggregateTypes; ++type) {
+    for (auto& elem : mAggregates[type]) {
+      FsAggregate& aggregate = *elem.second;
+
+      if (aggregate.mInvalid || !aggregate.Has(fsid)) {
+        continue;
+      }
+
+      std::set<std::string> used;
+      GetAggregateKeys((AggregateType) type, aggregate.GetQuery(), used);
+
+      for (const auto& key : keys) {
+        if (used.count(key)) {
+          aggregate.Set(fsid, GetSample((AggregateType) type, aggregate.GetQuery(),
+                                        fsid));
+          break;
+        }
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Recompute all the aggregates and report the ones which drifted
+//------------------------------------------------------------------------------
+size_t
+BaseView::CheckAggregates(time_t now)
+{
+  size_t num_drifted = 0;
+  std::lock_guard<std::mutex> lock(mAggregateMutex);
+
+  for (int type = 0; type < kNumAggregateTypes; ++type) {
+    auto& aggregates = mAggregates[type];
+
+    for (auto it = aggregates.begin(); it != aggregates.end();) {
+      if (now - it->second->mLastAccess > sAggregateExpiry) {
+        it = aggregates.erase(it);
+        continue;
+      }
+
+      if (!it->second->mInvalid) {
+        std::unique_ptr<FsAggregate> full(new FsAggregate(it->first));
+        FillAggregate((AggregateType) type, *full);
+
+        if (!it->second->Matches(*full)) {
+          FsAggregate::Stats cached = it->second->GetStats();
+          FsAggregate::Stats expected = full->GetStats();
+          eos_static_warning("msg=\"view aggregate drifted\" view=%s param=\"%s\" "
+                             "sum=%lld/%lld avg=%f/%f count=%lld/%lld",
+                             mName.c_str(), it->first.c_str(), cached.mLongSum,
+                             expected.mLongSum, cached.mAvg, expected.mAvg,
+                             cached.mCount, expected.mCount);
+          full->mLastAccess = it->second->mLastAccess;
+          it->second = std::move(full);
+          ++num_drifted;
+        }
+      }
+
+      ++it;
+    }
+  }
+
+  return num_drifted;
+}
+
 //------------------------------------------------------------------------------
 // Print user defined format to out
 //
@@ -26,6 +26,7 @@
 
 #include "mgm/Namespace.hh"
 #include "mgm/FileSystem.hh"
+#include "mgm/FsAggregate.hh"
 #include "mgm/config/IConfigEngine.hh"
 #include "common/RWMutex.hh"
 #include "common/SymKeys.hh"
@@ -38,6 +39,9 @@
 #include <sys/param.h>
 #include <sys/mount.h>
 #endif
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 //------------------------------------------------------------------------------
 //! @file FsView.hh
@@ -504,6 +508,48 @@ public:
     mInQueue = iq;
   }
 
+  //----------------------------------------------------------------------------
+  //! Insert a file system into the view, the aggregates get recomputed on
+  //! their next use
+  //!
+  //! @param fs file system id
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool insert(const eos::common::FileSystem::fsid_t& fs);
+
+  //----------------------------------------------------------------------------
+  //! Remove a file system from the view, the aggregates get recomputed on
+  //! their next use
+  //!
+  //! @param fs file system id
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool erase(const eos::common::FileSystem::fsid_t& fs);
+
+  //----------------------------------------------------------------------------
+  //! Fold the current values of a file system into the aggregates using any
+  //! of the modified keys
+  //!
+  //! @param fsid file system id
+  //! @param keys modified keys of the file system
+  //! @warning needs to be called with a read-lock on the ViewMutex
+  //----------------------------------------------------------------------------
+  void UpdateAggregates(eos::common::FileSystem::fsid_t fsid,
+                        const std::set<std::string>& keys);
+
+  //----------------------------------------------------------------------------
+  //! Recompute all the aggregates from scratch, report and fix the ones
+  //! which drifted and drop the ones not used for a while
+  //!
+  //! @param now current time
+  //!
+  //! @return number of aggregates which drifted
+  //! @warning needs to be called with a read-lock on the ViewMutex
+  //----------------------------------------------------------------------------
+  size_t CheckAggregates(time_t now);
+
   //----------------------------------------------------------------------------
   //! Calculate the sum of <param> as long long
   //----------------------------------------------------------------------------
@@ -555,10 +601,56 @@ public:
                 const std::set<eos::common::FileSystem::fsid_t>* subset);
 
 private:
+  //! Aggregate types, kSum for SumLongLong and kDouble for the others
+  enum AggregateType {kSum = 0, kDouble = 1, kNumAggregateTypes = 2};
+  //! Aggregates not read for this long are dropped by CheckAggregates
+  static constexpr time_t sAggregateExpiry = 3600;
+
+  //----------------------------------------------------------------------------
+  //! Get the statistics of an aggregate, creating or recomputing it if needed
+  //!
+  //! @param type aggregate type
+  //! @param param query string
+  //! @param stats output statistics
+  //!
+  //! @return true if the aggregates are maintained, otherwise false and the
+  //!         caller has to scan the view
+  //! @warning needs to be called with a read-lock on the ViewMutex
+  //----------------------------------------------------------------------------
+  bool GetAggregateStats(AggregateType type, const char* param,
+                         FsAggregate::Stats& stats);
+
+  //----------------------------------------------------------------------------
+  //! Fill an aggregate with the values of all the file systems of the view
+  //----------------------------------------------------------------------------
+  void FillAggregate(AggregateType type, FsAggregate& aggregate);
+
+  //----------------------------------------------------------------------------
+  //! Compute the contribution of a file system to an aggregate
+  //----------------------------------------------------------------------------
+  FsAggregate::Sample GetSample(AggregateType type,
+                                const FsAggregate::Query& query,
+                                eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Get the file system keys an aggregate depends on
+  //----------------------------------------------------------------------------
+  void GetAggregateKeys(AggregateType type, const FsAggregate::Query& query,
+                        std::set<std::string>& keys) const;
+
+  //----------------------------------------------------------------------------
+  //! Check if a file system is taken into averages and deviations
+  //----------------------------------------------------------------------------
+  bool IsConsidered(FileSystem* fs);
+
   time_t mHeartBeat; ///< Last heartbeat time
   std::string mStatus; ///< Status (meaning depends on inheritor)
   std::string mSize; ///< Size of base object (meaning depends on inheritor)
   size_t mInQueue; ///< Number of items in queue(meaning depends on inheritor)
+  std::mutex mAggregateMutex; ///< Mutex protecting mAggregates
+  //! Running aggregates by type and query string
+  std::map<std::string, std::unique_ptr<FsAggregate>>
+      mAggregates[kNumAggregateTypes];
 };
 
 //------------------------------------------------------------------------------
@@ -804,6 +896,7 @@ public:
   //----------------------------------------------------------------------------
   virtual ~FsView()
   {
+    StopAggregateUpdater();
     StopHeartBeat();
   }
 
@@ -990,6 +1083,40 @@ public:
     mHeartBeatThread.join();
   }
 
+  //----------------------------------------------------------------------------
+  //! Start the thread folding the file system changes published through the
+  //! shared object notifier into the view aggregates
+  //----------------------------------------------------------------------------
+  void StartAggregateUpdater()
+  {
+    mAggregateThread.reset(&FsView::AggregateUpdater, this);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Stop the aggregate updater thread, the views fall back to scans
+  //----------------------------------------------------------------------------
+  void StopAggregateUpdater()
+  {
+    mAggregateThread.join();
+    mAggregatesEnabled = false;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if the view aggregates are maintained by the updater thread
+  //----------------------------------------------------------------------------
+  inline bool AggregatesEnabled() const
+  {
+    return mAggregatesEnabled;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Subscribe the aggregate updater to the modifications of some file
+  //! system keys
+  //!
+  //! @param keys file system keys
+  //----------------------------------------------------------------------------
+  void WatchAggregateKeys(const std::set<std::string>& keys);
+
   //----------------------------------------------------------------------------
   //! Set config queues
   //----------------------------------------------------------------------------
@@ -1045,7 +1172,21 @@ public:
   void BroadcastMasterId(const std::string master_id);
 
 private:
+  //! Name of the aggregate updater in the shared object notifier
+  static constexpr const char* sAggregateSubscriber = "fsviewaggregates";
+  //! Interval between two full recomputations of the aggregates
+  static constexpr time_t sAggregateCheckInterval = 300;
+
+  //----------------------------------------------------------------------------
+  //! Thread loop function updating the view aggregates
+  //----------------------------------------------------------------------------
+  void AggregateUpdater(ThreadAssistant& assistant) noexcept;
+
   AssistedThread mHeartBeatThread; ///< Thread monitoring heart-beats
+  AssistedThread mAggregateThread; ///< Thread updating the view aggregates
+  std::atomic<bool> mAggregatesEnabled {false}; ///< Aggregate updater running
+  std::mutex mAggregateKeysMutex; ///< Mutex protecting mAggregateKeys
+  std::set<std::string> mAggregateKeys; ///< Keys watched by the updater
   //! Next free filesystem ID if a new one has to be registered
   eos::common::FileSystem::fsid_t NextFsId;
   //! Mutex protecting all ...Map variables
@@ -27,6 +27,7 @@
 #include "mgm/FuseServer/Caps.hh"
 #include <thread>
 #include <regex>
+#include <algorithm>
 
 #include "common/Logging.hh"
 #include "common/Timing.hh"
@@ -39,6 +40,169 @@
 
 EOSMGMNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+FuseServer::Caps::Caps():
+  mNumCaps(0), mExpiry(4096, time(NULL))
+{}
+
+//------------------------------------------------------------------------------
+// Add a cap to the indices
+//------------------------------------------------------------------------------
+void
+FuseServer::Caps::Insert(shared_cap cap)
+{
+  time_t deadline = cap->vtime() + sExpiryGrace;
+  bool schedule = true;
+  {
+    CapShard& shard = GetCapShard(cap->authid());
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    auto it = shard.mCaps.find(cap->authid());
+
+    if (it != shard.mCaps.end()) {
+      // the cap is re-issued - the scheduled expiry is re-validated when it
+      // fires, only an earlier deadline needs a new entry
+      Unindex(it->second.mCap);
+      it.value().mCap = cap;
+
+      if (deadline < it->second.mDeadline) {
+        it.value().mDeadline = deadline;
+      } else {
+        schedule = false;
+      }
+    } else {
+      shard.mCaps[cap->authid()] = CapEntry{cap, deadline};
+      ++mNumCaps;
+    }
+
+    {
+      InodeShard& ishard = GetInodeShard(cap->id());
+      std::lock_guard<std::mutex> ilock(ishard.mMutex);
+      ishard.mInodeCaps[cap->id()].insert(cap->authid());
+    }
+    {
+      ClientShard& cshard = GetClientShard(cap->clientid());
+      std::lock_guard<std::mutex> clock(cshard.mMutex);
+      cshard.mClientInoCaps[cap->clientid()][cap->id()].insert(cap->authid());
+    }
+  }
+
+  if (schedule) {
+    mExpiry.Insert(deadline, std::make_pair(cap->authid(), deadline));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop a cap from the inode and client indices
+//------------------------------------------------------------------------------
+void
+FuseServer::Caps::Unindex(const shared_cap& cap)
+{
+  {
+    InodeShard& ishard = GetInodeShard(cap->id());
+    std::lock_guard<std::mutex> ilock(ishard.mMutex);
+    auto it = ishard.mInodeCaps.find(cap->id());
+
+    if (it != ishard.mInodeCaps.end()) {
+      it.value().erase(cap->authid());
+
+      if (it->second.empty()) {
+        ishard.mInodeCaps.erase(it);
+      }
+    }
+  }
+  ClientShard& cshard = GetClientShard(cap->clientid());
+  std::lock_guard<std::mutex> clock(cshard.mMutex);
+  auto it = cshard.mClientInoCaps.find(cap->clientid());
+
+  if (it == cshard.mClientInoCaps.end()) {
+    return;
+  }
+
+  auto iit = it.value().find(cap->id());
+
+  if (iit != it->second.end()) {
+    iit.value().erase(cap->authid());
+
+    if (iit->second.empty()) {
+      it.value().erase(iit);
+
+      if (it->second.empty()) {
+        cshard.mClientInoCaps.erase(it);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Remove a cap from all the indices
+//------------------------------------------------------------------------------
+bool
+FuseServer::Caps::Remove(shared_cap cap)
+{
+  if (!cap) {
+    return false;
+  }
+
+  CapShard& shard = GetCapShard(cap->authid());
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  auto it = shard.mCaps.find(cap->authid());
+
+  if (it == shard.mCaps.end()) {
+    return false;
+  }
+
+  Unindex(it->second.mCap);
+  shard.mCaps.erase(it);
+  --mNumCaps;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Remove the caps whose validity time passed
+//------------------------------------------------------------------------------
+size_t
+FuseServer::Caps::Expire(time_t now)
+{
+  std::vector<std::pair<authid_t, time_t>> due;
+  size_t nexpired = 0;
+  mExpiry.Advance(now, due);
+
+  for (auto& item : due) {
+    time_t deadline = 0;
+    {
+      CapShard& shard = GetCapShard(item.first);
+      std::lock_guard<std::mutex> lock(shard.mMutex);
+      auto it = shard.mCaps.find(item.first);
+
+      // skip removed caps and entries superseded by an earlier deadline
+      if ((it == shard.mCaps.end()) || (it->second.mDeadline != item.second)) {
+        continue;
+      }
+
+      const shared_cap& cap = it->second.mCap;
+
+      if ((time_t)(cap->vtime() + sExpiryGrace) <= now) {
+        Unindex(cap);
+        shard.mCaps.erase(it);
+        --mNumCaps;
+        ++nexpired;
+      } else {
+        // the cap was extended in the meanwhile
+        deadline = cap->vtime() + sExpiryGrace;
+        it.value().mDeadline = deadline;
+      }
+    }
+
+    if (deadline) {
+      mExpiry.Insert(deadline, std::make_pair(item.first, deadline));
+    }
+  }
+
+  return nexpired;
+}
+
 //------------------------------------------------------------------------------
 //
 //------------------------------------------------------------------------------
@@ -48,26 +212,14 @@ FuseServer::Caps::Store(const eos::fusex::cap& ecap,
 {
   gOFS->MgmStats.Add("Eosxd::int::Store", 0, 0, 1);
   EXEC_TIMING_BEGIN("Eosxd::int::Store");
-  eos::common::RWMutexWriteLock lLock(*this);
   eos_static_info("id=%lx clientid=%s authid=%s",
                   ecap.id(),
                   ecap.clientid().c_str(),
                   ecap.authid().c_str());
-
-  // avoid to have multiple time entries for the same cap
-  if (!mCaps.count(ecap.authid())) {
-    // fill the three views on caps
-    mTimeOrderedCap.insert(std::pair<time_t, authid_t>(ecap.vtime(),
-                           ecap.authid()));
-  }
-
-  mClientCaps[ecap.clientid()].insert(ecap.authid());
-  mClientInoCaps[ecap.clientid()][ecap.id()].insert(ecap.authid());
   shared_cap cap = std::make_shared<capx>();
   *cap = ecap;
   cap->set_vid(vid);
-  mCaps[ecap.authid()] = cap;
-  mInodeCaps[ecap.id()].insert(ecap.authid());
+  Insert(cap);
   EXEC_TIMING_END("Eosxd::int::Store");
 }
 
@@ -84,7 +236,7 @@ FuseServer::Caps::Imply(uint64_t md_ino,
                   authid.c_str(),
                   implied_authid.c_str());
   shared_cap implied_cap = std::make_shared<capx>();
-  shared_cap cap = Get(authid);
+  shared_cap cap = GetTS(authid);
 
   if (!cap->id() || !implied_authid.length()) {
     return false;
@@ -96,23 +248,14 @@ FuseServer::Caps::Imply(uint64_t md_ino,
   implied_cap->set_vid(cap->vid());
   struct timespec ts;
   eos::common::Timing::GetTimeSpec(ts, true);
+  size_t leasetime = 0;
   {
-    size_t leasetime = 0;
-    {
-      eos::common::RWMutexReadLock lLock(gOFS->zMQ->gFuseServer.Client());
-      leasetime = gOFS->zMQ->gFuseServer.Client().leasetime(cap->clientuuid());
-    }
-    eos::common::RWMutexWriteLock lock(*this);
-    implied_cap->set_vtime(ts.tv_sec + (leasetime ? leasetime : 300));
-    implied_cap->set_vtime_ns(ts.tv_nsec);
-    // fill the three views on caps
-    mTimeOrderedCap.insert(std::pair<time_t, authid_t>(implied_cap->vtime(),
-                           implied_authid));
-    mClientCaps[cap->clientid()].insert(implied_authid);
-    mClientInoCaps[cap->clientid()][cap->id()].insert(implied_authid);
-    mCaps[implied_authid] = implied_cap;
-    mInodeCaps[md_ino].insert(implied_authid);
+    eos::common::RWMutexReadLock lLock(gOFS->zMQ->gFuseServer.Client());
+    leasetime = gOFS->zMQ->gFuseServer.Client().leasetime(cap->clientuuid());
   }
+  implied_cap->set_vtime(ts.tv_sec + (leasetime ? leasetime : 300));
+  implied_cap->set_vtime_ns(ts.tv_nsec);
+  Insert(implied_cap);
   return true;
 }
 
@@ -120,28 +263,120 @@ FuseServer::Caps::Imply(uint64_t md_ino,
 //
 //------------------------------------------------------------------------------
 FuseServer::Caps::shared_cap
-FuseServer::Caps::Get(FuseServer::Caps::authid_t id)
+FuseServer::Caps::GetTS(FuseServer::Caps::authid_t id)
 {
-  if (mCaps.count(id)) {
-    return mCaps[id];
+  CapShard& shard = GetCapShard(id);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  auto it = shard.mCaps.find(id);
+
+  if (it != shard.mCaps.end()) {
+    return it->second.mCap;
   } else {
     return std::make_shared<capx>();
   }
 }
 
-FuseServer::Caps::shared_cap
-FuseServer::Caps::GetTS(FuseServer::Caps::authid_t id)
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+bool
+FuseServer::Caps::HasCap(FuseServer::Caps::authid_t authid)
 {
-  eos::common::RWMutexWriteLock lLock(*this);
+  CapShard& shard = GetCapShard(authid);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  return (shard.mCaps.count(authid) ? true : false);
+}
 
-  if (mCaps.count(id)) {
-    return mCaps[id];
-  } else {
-    return std::make_shared<capx>();
+//------------------------------------------------------------------------------
+// Check if a client holds a cap on an inode
+//------------------------------------------------------------------------------
+bool
+FuseServer::Caps::HasClientInoCap(const clientid_t& clientid, uint64_t id)
+{
+  ClientShard& shard = GetClientShard(clientid);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  auto it = shard.mClientInoCaps.find(clientid);
+  return ((it != shard.mClientInoCaps.end()) && it->second.count(id));
+}
+
+//------------------------------------------------------------------------------
+// Get the authids of the caps a client holds on an inode
+//------------------------------------------------------------------------------
+FuseServer::Caps::authid_set_t
+FuseServer::Caps::GetClientInoCaps(const clientid_t& clientid, uint64_t id)
+{
+  ClientShard& shard = GetClientShard(clientid);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  auto it = shard.mClientInoCaps.find(clientid);
+
+  if (it != shard.mClientInoCaps.end()) {
+    auto iit = it->second.find(id);
+
+    if (iit != it->second.end()) {
+      return iit->second;
+    }
+  }
+
+  return authid_set_t();
+}
+
+//------------------------------------------------------------------------------
+// Call a function for every cap
+//------------------------------------------------------------------------------
+void
+FuseServer::Caps::ForEach(const std::function<void(const shared_cap&)>& func)
+{
+  for (size_t i = 0; i < sNumShards; ++i) {
+    std::lock_guard<std::mutex> lock(mCapShards[i].mMutex);
+
+    for (auto it = mCapShards[i].mCaps.begin(); it != mCapShards[i].mCaps.end();
+         ++it) {
+      func(it->second.mCap);
+    }
   }
 }
 
+//------------------------------------------------------------------------------
+// Get the caps held on an inode
+//------------------------------------------------------------------------------
+std::vector<FuseServer::Caps::shared_cap>
+FuseServer::Caps::GetInodeCaps(uint64_t id)
+{
+  authid_set_t authids;
+  {
+    InodeShard& shard = GetInodeShard(id);
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    auto it = shard.mInodeCaps.find(id);
+
+    if (it != shard.mInodeCaps.end()) {
+      authids = it->second;
+    }
+  }
+  std::vector<shared_cap> caps;
+  caps.reserve(authids.size());
 
+  for (const auto& authid : authids) {
+    shared_cap cap = GetTS(authid);
+
+    // skip caps removed in the meanwhile
+    if (cap->id()) {
+      caps.push_back(cap);
+    }
+  }
+
+  return caps;
+}
+
+//------------------------------------------------------------------------------
+// Send the responses collected by a broadcast
+//------------------------------------------------------------------------------
+void
+FuseServer::Caps::Flush(batch_t& batch)
+{
+  gOFS->zMQ->gFuseServer.Client().SendBatch(batch);
+  errno = 0 ; // seems that ZMQ function might set errno
+  batch.clear();
+}
 
 /*----------------------------------------------------------------------------*/
 int
@@ -151,38 +386,16 @@ FuseServer::Caps::BroadcastReleaseFromExternal(uint64_t id)
   gOFS->MgmStats.Add("Eosxd::int::BcReleaseExt", 0, 0, 1);
   EXEC_TIMING_BEGIN("Eosxd::int::BcReleaseExt");
   // broad-cast release for a given inode
-  eos::common::RWMutexReadLock lLock(*this);
   eos_static_info("id=%lx ",
                   id);
-  std::vector<shared_cap> bccaps;
+  batch_t batch;
 
-  if (mInodeCaps.count(id)) {
-    for (auto it = mInodeCaps[id].begin();
-         it != mInodeCaps[id].end(); ++it) {
-      shared_cap cap;
-
-      // loop over all caps for that inode
-      if (mCaps.count(*it)) {
-        cap = mCaps[*it];
-      } else {
-        continue;
-      }
-
-      if (cap->id()) {
-        bccaps.push_back(cap);
-      }
-    }
-  }
-
-  lLock.Release();
-
-  for (auto it : bccaps) {
-    gOFS->zMQ->gFuseServer.Client().ReleaseCAP((uint64_t) it->id(),
-        it->clientuuid(),
-        it->clientid());
-    errno = 0 ; // seems that ZMQ function might set errno
+  for (const auto& cap : GetInodeCaps(id)) {
+    batch[cap->clientuuid()].push_back(Clients::MakeReleaseCAP(cap->id(),
+                                       cap->clientid()));
   }
 
+  Flush(batch);
   EXEC_TIMING_END("Eosxd::int::BcReleaseExt");
   return 0;
 }
@@ -195,103 +408,62 @@ FuseServer::Caps::BroadcastRefreshFromExternal(uint64_t id, uint64_t pid)
   gOFS->MgmStats.Add("Eosxd::int::BcRefreshExt", 0, 0, 1);
   EXEC_TIMING_BEGIN("Eosxd::int::BcRefreshExt");
   // broad-cast refresh for a given inode
-  eos::common::RWMutexReadLock lLock(*this);
   eos_static_info("id=%lx pid=%lx",
                   id,
                   pid);
-  std::vector<shared_cap> bccaps;
-
-  if (mInodeCaps.count(pid)) {
-    for (auto it = mInodeCaps[pid].begin();
-         it != mInodeCaps[pid].end(); ++it) {
-      shared_cap cap;
-
-      // loop over all caps for that inode
-      if (mCaps.count(*it)) {
-        cap = mCaps[*it];
-      } else {
-        continue;
-      }
+  batch_t batch;
 
-      if (cap->id()) {
-        bccaps.push_back(cap);
-      }
-    }
-  }
-
-  lLock.Release();
-
-  for (auto it : bccaps) {
-    gOFS->zMQ->gFuseServer.Client().RefreshEntry((uint64_t) id,
-        it->clientuuid(),
-        it->clientid());
-    errno = 0 ; // seems that ZMQ function might set errno
+  for (const auto& cap : GetInodeCaps(pid)) {
+    batch[cap->clientuuid()].push_back(Clients::MakeRefreshEntry(id));
   }
 
+  Flush(batch);
   EXEC_TIMING_END("Eosxd::int::BcRefreshExt");
   return 0;
 }
 
 int
-FuseServer::Caps::BroadcastRelease(const eos::fusex::md& md)
+FuseServer::Caps::BroadcastRelease(const eos::fusex::md& md, batch_t* batch)
 {
   gOFS->MgmStats.Add("Eosxd::int::BcRelease", 0, 0, 1);
   EXEC_TIMING_BEGIN("Eosxd::int::BcRelease");
-  FuseServer::Caps::shared_cap refcap = Get(md.authid());
-  eos::common::RWMutexReadLock lLock(*this);
+  FuseServer::Caps::shared_cap refcap = GetTS(md.authid());
   eos_static_info("id=%lx/%lx clientid=%s clientuuid=%s authid=%s",
                   refcap->id(),
                   md.md_pino(),
                   refcap->clientid().c_str(),
                   refcap->clientuuid().c_str(),
                   refcap->authid().c_str());
-  std::vector<shared_cap> bccaps;
+  batch_t local_batch;
+  batch_t& out = batch ? *batch : local_batch;
   uint64_t md_pino = refcap->id();
 
   if (!md_pino) {
     md_pino = md.md_pino();
   }
 
-  if (mInodeCaps.count(md_pino)) {
-    for (auto it = mInodeCaps[md_pino].begin();
-         it != mInodeCaps[md_pino].end(); ++it) {
-      shared_cap cap;
-
-      // loop over all caps for that inode
-      if (mCaps.count(*it)) {
-        cap = mCaps[*it];
-      } else {
-        continue;
-      }
-
-      // skip our own cap!
-      if (cap->authid() == md.authid()) {
-        continue;
-      }
-
-      // skip identical client mounts!
-      if (cap->clientuuid() == refcap->clientuuid()) {
-        continue;
-      }
+  for (const auto& cap : GetInodeCaps(md_pino)) {
+    // skip our own cap!
+    if (cap->authid() == md.authid()) {
+      continue;
+    }
 
-      // skip same source
-      if (cap->clientuuid() == md.clientuuid()) {
-        continue;
-      }
+    // skip identical client mounts!
+    if (cap->clientuuid() == refcap->clientuuid()) {
+      continue;
+    }
 
-      if (cap->id()) {
-        bccaps.push_back(cap);
-      }
+    // skip same source
+    if (cap->clientuuid() == md.clientuuid()) {
+      continue;
     }
-  }
 
-  lLock.Release();
+    out[cap->clientuuid()].push_back(Clients::MakeReleaseCAP(cap->id(),
+                                     cap->clientid()));
+  }
 
-  for (auto it : bccaps) {
-    gOFS->zMQ->gFuseServer.Client().ReleaseCAP((uint64_t) it->id(),
-        it->clientuuid(),
-        it->clientid());
-    errno = 0 ;
+  if (!batch) {
+    Flush(local_batch);
   }
 
   EXEC_TIMING_END("Eosxd::int::BcRelease");
@@ -307,40 +479,17 @@ FuseServer::Caps::BroadcastDeletionFromExternal(uint64_t id,
   gOFS->MgmStats.Add("Eosxd::int::BcDeletionExt", 0, 0, 1);
   EXEC_TIMING_BEGIN("Eosxd::int::BcDeletionExt");
   // broad-cast deletion for a given name in a container
-  eos::common::RWMutexReadLock lLock(*this);
   eos_static_info("id=%lx name=%s",
                   id,
                   name.c_str());
-  std::vector<shared_cap> bccaps;
-
-  if (mInodeCaps.count(id)) {
-    for (auto it = mInodeCaps[id].begin();
-         it != mInodeCaps[id].end(); ++it) {
-      shared_cap cap;
+  batch_t batch;
 
-      // loop over all caps for that inode
-      if (mCaps.count(*it)) {
-        cap = mCaps[*it];
-      } else {
-        continue;
-      }
-
-      if (cap->id()) {
-        bccaps.push_back(cap);
-      }
-    }
-  }
-
-  lLock.Release();
-
-  for (auto it : bccaps) {
-    gOFS->zMQ->gFuseServer.Client().DeleteEntry((uint64_t) it->id(),
-        it->clientuuid(),
-        it->clientid(),
-        name);
-    errno = 0 ; // seems that ZMQ function might set errno
+  for (const auto& cap : GetInodeCaps(id)) {
+    batch[cap->clientuuid()].push_back(Clients::MakeDeleteEntry(cap->id(),
+                                       cap->clientid(), name));
   }
 
+  Flush(batch);
   EXEC_TIMING_END("Eosxd::int::BcDeletionExt");
   return 0;
 }
@@ -348,59 +497,40 @@ FuseServer::Caps::BroadcastDeletionFromExternal(uint64_t id,
 /*----------------------------------------------------------------------------*/
 int
 FuseServer::Caps::BroadcastDeletion(uint64_t id, const eos::fusex::md& md,
-                                    const std::string& name)
+                                    const std::string& name, batch_t* batch)
 /*----------------------------------------------------------------------------*/
 {
   gOFS->MgmStats.Add("Eosxd::int::BcDeletion", 0, 0, 1);
   EXEC_TIMING_BEGIN("Eosxd::int::BcDeletion");
-  FuseServer::Caps::shared_cap refcap = Get(md.authid());
-  eos::common::RWMutexReadLock lLock(*this);
+  FuseServer::Caps::shared_cap refcap = GetTS(md.authid());
   eos_static_info("id=%lx name=%s",
                   id,
                   name.c_str());
-  std::vector<shared_cap> bccaps;
-
-  if (mInodeCaps.count(refcap->id())) {
-    for (auto it = mInodeCaps[refcap->id()].begin();
-         it != mInodeCaps[refcap->id()].end(); ++it) {
-      shared_cap cap;
-
-      // loop over all caps for that inode
-      if (mCaps.count(*it)) {
-        cap = mCaps[*it];
-      } else {
-        continue;
-      }
-
-      // skip our own cap!
-      if (cap->authid() == refcap->authid()) {
-        continue;
-      }
+  batch_t local_batch;
+  batch_t& out = batch ? *batch : local_batch;
 
-      // skip identical client mounts!
-      if (cap->clientuuid() == refcap->clientuuid()) {
-        continue;
-      }
+  for (const auto& cap : GetInodeCaps(refcap->id())) {
+    // skip our own cap!
+    if (cap->authid() == refcap->authid()) {
+      continue;
+    }
 
-      // skip same source
-      if (cap->clientuuid() == md.clientuuid()) {
-        continue;
-      }
+    // skip identical client mounts!
+    if (cap->clientuuid() == refcap->clientuuid()) {
+      continue;
+    }
 
-      if (cap->id()) {
-        bccaps.push_back(cap);
-      }
+    // skip same source
+    if (cap->clientuuid() == md.clientuuid()) {
+      continue;
     }
-  }
 
-  lLock.Release();
+    out[cap->clientuuid()].push_back(Clients::MakeDeleteEntry(cap->id(),
+                                     cap->clientid(), name));
+  }
 
-  for (auto it : bccaps) {
-    gOFS->zMQ->gFuseServer.Client().DeleteEntry((uint64_t) it->id(),
-        it->clientuuid(),
-        it->clientid(),
-        name);
-    errno = 0;
+  if (!batch) {
+    Flush(local_batch);
   }
 
   EXEC_TIMING_END("Eosxd::int::BcDeletion");
@@ -411,54 +541,35 @@ FuseServer::Caps::BroadcastDeletion(uint64_t id, const eos::fusex::md& md,
 int
 FuseServer::Caps::BroadcastRefresh(uint64_t inode,
                                    const eos::fusex::md& md,
-                                   uint64_t parent_inode)
+                                   uint64_t parent_inode,
+                                   batch_t* batch)
 /*----------------------------------------------------------------------------*/
 {
   gOFS->MgmStats.Add("Eosxd::int::BcRefresh", 0, 0, 1);
   EXEC_TIMING_BEGIN("Eosxd::int::BcRefresh");
-  FuseServer::Caps::shared_cap refcap = Get(md.authid());
-  eos::common::RWMutexReadLock lLock(*this);
+  FuseServer::Caps::shared_cap refcap = GetTS(md.authid());
   eos_static_info("id=%lx parent=%lx",
                   inode,
                   parent_inode);
-  std::vector<shared_cap> bccaps;
-
-  if (mInodeCaps.count(parent_inode)) {
-    for (auto it = mInodeCaps[parent_inode].begin();
-         it != mInodeCaps[parent_inode].end(); ++it) {
-      shared_cap cap;
-
-      // loop over all caps for that inode
-      if (mCaps.count(*it)) {
-        cap = mCaps[*it];
-      } else {
-        continue;
-      }
+  batch_t local_batch;
+  batch_t& out = batch ? *batch : local_batch;
 
-      // skip identical client mounts!
-      if (cap->clientuuid() == refcap->clientuuid()) {
-        continue;
-      }
-
-      // skip same source
-      if (cap->clientuuid() == md.clientuuid()) {
-        continue;
-      }
+  for (const auto& cap : GetInodeCaps(parent_inode)) {
+    // skip identical client mounts!
+    if (cap->clientuuid() == refcap->clientuuid()) {
+      continue;
+    }
 
-      if (cap->id()) {
-        bccaps.push_back(cap);
-      }
+    // skip same source
+    if (cap->clientuuid() == md.clientuuid()) {
+      continue;
     }
-  }
 
-  lLock.Release();
+    out[cap->clientuuid()].push_back(Clients::MakeRefreshEntry(inode));
+  }
 
-  for (auto it : bccaps) {
-    gOFS->zMQ->gFuseServer.Client().RefreshEntry((uint64_t) inode,
-        it->clientuuid(),
-        it->clientid()
-                                                );
-    errno = 0;
+  if (!batch) {
+    Flush(local_batch);
   }
 
   EXEC_TIMING_END("Eosxd::int::BcRefresh");
@@ -485,72 +596,46 @@ FuseServer::Caps::BroadcastMD(const eos::fusex::md& md,
 {
   gOFS->MgmStats.Add("Eosxd::int::BcMD", 0, 0, 1);
   EXEC_TIMING_BEGIN("Eosxd::int::BcMD");
-  FuseServer::Caps::shared_cap refcap = Get(md.authid());
-  eos::common::RWMutexReadLock lLock(*this);
+  FuseServer::Caps::shared_cap refcap = GetTS(md.authid());
   eos_static_info("id=%lx/%lx clientid=%s clientuuid=%s authid=%s",
                   refcap->id(),
                   md_pino,
                   refcap->clientid().c_str(),
                   refcap->clientuuid().c_str(),
                   refcap->authid().c_str());
-  std::set<std::string> clients_sent;
-  std::vector<shared_cap> bccaps;
-
-  if (mInodeCaps.count(md_pino)) {
-    for (auto it = mInodeCaps[md_pino].begin();
-         it != mInodeCaps[md_pino].end(); ++it) {
-      shared_cap cap;
-
-      // loop over all caps for that inode
-      if (mCaps.count(*it)) {
-        cap = mCaps[*it];
-      } else {
-        continue;
-      }
-
-      eos_static_info("id=%lx clientid=%s clientuuid=%s authid=%s",
-                      cap->id(),
-                      cap->clientid().c_str(),
-                      cap->clientuuid().c_str(),
-                      cap->authid().c_str());
-
-      // skip our own cap!
-      if (cap->authid() == md.authid()) {
-        continue;
-      }
-
-      // skip identical client mounts, the have it anyway!
-      if (cap->clientuuid() == refcap->clientuuid()) {
-        continue;
-      }
-
-      // skip same source
-      if (cap->clientuuid() == md.clientuuid()) {
-        continue;
-      }
+  batch_t batch;
+
+  for (const auto& cap : GetInodeCaps(md_pino)) {
+    eos_static_info("id=%lx clientid=%s clientuuid=%s authid=%s",
+                    cap->id(),
+                    cap->clientid().c_str(),
+                    cap->clientuuid().c_str(),
+                    cap->authid().c_str());
+
+    // skip our own cap!
+    if (cap->authid() == md.authid()) {
+      continue;
+    }
 
-      if (cap->id() && !clients_sent.count(cap->clientuuid())) {
-        bccaps.push_back(cap);
-        // make sure we sent the update only once to each client, eveh if this
-        // one has many caps
-        clients_sent.insert(cap->clientuuid());
-      }
+    // skip identical client mounts, the have it anyway!
+    if (cap->clientuuid() == refcap->clientuuid()) {
+      continue;
     }
-  }
 
-  lLock.Release();
+    // skip same source
+    if (cap->clientuuid() == md.clientuuid()) {
+      continue;
+    }
 
-  for (auto it : bccaps) {
-    gOFS->zMQ->gFuseServer.Client().SendMD(md,
-                                           it->clientuuid(),
-                                           it->clientid(),
-                                           md_ino,
-                                           md_pino,
-                                           clock,
-                                           p_mtime);
-    errno = 0;
+    // make sure we sent the update only once to each client, eveh if this
+    // one has many caps
+    if (!batch.count(cap->clientuuid())) {
+      batch[cap->clientuuid()].push_back(Clients::MakeMD(md, cap->clientid(),
+                                         md_ino, md_pino, clock, p_mtime));
+    }
   }
 
+  Flush(batch);
   EXEC_TIMING_END("Eosxd::int::BcMD");
   return 0;
 }
@@ -570,7 +655,6 @@ FuseServer::Caps::Print(std::string option, std::string filter)
     lock.Grab(gOFS->eosViewRWMutex);
   }
 
-  eos::common::RWMutexReadLock lLock(*this);
   eos_static_info("option=%s string=%s", option.c_str(), filter.c_str());
   regex_t regex;
 
@@ -584,14 +668,18 @@ FuseServer::Caps::Print(std::string option, std::string filter)
 
   if (option == "t") {
     // print by time order
-    for (auto it = mTimeOrderedCap.begin(); it != mTimeOrderedCap.end();) {
-      if (!mCaps.count(it->second)) {
-        it = mTimeOrderedCap.erase(it);
-        continue;
-      }
-
+    std::vector<shared_cap> caps;
+    ForEach([&caps](const shared_cap & cap) {
+      caps.push_back(cap);
+    });
+    std::stable_sort(caps.begin(), caps.end(),
+    [](const shared_cap & a, const shared_cap & b) {
+      return a->vtime() < b->vtime();
+    });
+
+    for (auto it = caps.begin(); it != caps.end();) {
       char ahex[256];
-      shared_cap cap = mCaps[it->second];
+      shared_cap cap = *it;
       snprintf(ahex, sizeof(ahex), "%016lx", (unsigned long) cap->id());
       std::string match = "";
       match += "# i:";
@@ -628,9 +716,23 @@ FuseServer::Caps::Print(std::string option, std::string filter)
     }
   }
 
+  // snapshot of the inode index, sorted by inode
+  std::map<uint64_t, authid_set_t> inode_caps;
+
+  if ((option == "i") || (option == "p")) {
+    for (size_t i = 0; i < sNumShards; ++i) {
+      std::lock_guard<std::mutex> ilock(mInodeShards[i].mMutex);
+
+      for (auto it = mInodeShards[i].mInodeCaps.begin();
+           it != mInodeShards[i].mInodeCaps.end(); ++it) {
+        inode_caps[it->first] = it->second;
+      }
+    }
+  }
+
   if (option == "i") {
     // print by inode
-    for (auto it = mInodeCaps.begin(); it != mInodeCaps.end(); ++it) {
+    for (auto it = inode_caps.begin(); it != inode_caps.end(); ++it) {
       char ahex[256];
       snprintf(ahex, sizeof(ahex), "%016lx", (unsigned long) it->first);
 
@@ -646,10 +748,11 @@ FuseServer::Caps::Print(std::string option, std::string filter)
         out += "___ a:";
         out += *sit;
 
-        if (!mCaps.count(*sit)) {
+        shared_cap cap = GetTS(*sit);
+
+        if (!cap->id()) {
           out += " c:<unfound> u:<unfound> m:<unfound> v:<unfound>\n";
         } else {
-          shared_cap cap = mCaps[*sit];
           out += " c:";
           out += cap->clientid();
           out += " u:";
@@ -668,7 +771,7 @@ FuseServer::Caps::Print(std::string option, std::string filter)
 
   if (option == "p") {
     // print by inode
-    for (auto it = mInodeCaps.begin(); it != mInodeCaps.end(); ++it) {
+    for (auto it = inode_caps.begin(); it != inode_caps.end(); ++it) {
       std::string spath;
 
       try {
@@ -702,10 +805,11 @@ FuseServer::Caps::Print(std::string option, std::string filter)
         out += "___ a:";
         out += *sit;
 
-        if (!mCaps.count(*sit)) {
+        shared_cap cap = GetTS(*sit);
+
+        if (!cap->id()) {
           out += " c:<unfound> u:<unfound> m:<unfound> v:<unfound>\n";
         } else {
-          shared_cap cap = mCaps[*sit];
           out += " c:";
           out += cap->clientid();
           out += " u:";
@@ -732,33 +836,34 @@ FuseServer::Caps::Print(std::string option, std::string filter)
 int
 FuseServer::Caps::Delete(uint64_t md_ino)
 {
-  eos::common::RWMutexWriteLock lLock(*this);
-
-  if (!mInodeCaps.count(md_ino)) {
-    return ENOENT;
-  }
+  authid_set_t authids;
+  {
+    InodeShard& ishard = GetInodeShard(md_ino);
+    std::lock_guard<std::mutex> ilock(ishard.mMutex);
+    auto it = ishard.mInodeCaps.find(md_ino);
 
-  for (auto sit = mInodeCaps[md_ino].begin() ;
-       sit != mInodeCaps[md_ino].end();
-       ++sit) {
-    for (auto it = mClientCaps.begin(); it != mClientCaps.end(); it++) {
-      // erase authid from the client set
-      it->second.erase(*sit);
+    if (it == ishard.mInodeCaps.end()) {
+      return ENOENT;
     }
 
-    if (mCaps.count(*sit)) {
-      shared_cap cap = mCaps[*sit];
+    // erase inode from the inode caps
+    authids = std::move(it.value());
+    ishard.mInodeCaps.erase(it);
+  }
 
-      if (mClientInoCaps.count(cap->clientid())) {
-        mClientInoCaps[cap->clientid()].erase(md_ino);
-      }
+  for (const auto& authid : authids) {
+    CapShard& shard = GetCapShard(authid);
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    auto it = shard.mCaps.find(authid);
 
-      mCaps.erase(*sit);
+    // the authid might have been re-issued for another inode meanwhile
+    if ((it != shard.mCaps.end()) && (it->second.mCap->id() == md_ino)) {
+      Unindex(it->second.mCap);
+      shard.mCaps.erase(it);
+      --mNumCaps;
     }
   }
 
-  // erase inode from the inode caps
-  mInodeCaps.erase(md_ino);
   return 0;
 }
 
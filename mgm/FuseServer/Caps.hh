@@ -26,6 +26,12 @@
 
 #include <thread>
 #include <map>
+#include <set>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
 
 #include "mgm/Namespace.hh"
 #include "mgm/fusex.pb.h"
@@ -34,13 +40,28 @@
 #include "common/Timing.hh"
 #include "common/Logging.hh"
 #include "common/RWMutex.hh"
+#include "common/TimerWheel.hh"
+#include "common/Murmur3.hh"
+#include "common/hopscotch_map.hh"
 
 EOSFUSESERVERNAMESPACE_BEGIN
 
   //----------------------------------------------------------------------------
   //! Class Caps
+  //!
+  //! Store of the capabilities handed out to fusex clients. Caps are kept in
+  //! three hash indices: authid => cap, inode => authids and
+  //! client => inode => authids. Each index is split into shards with their
+  //! own mutex, so that operations on different inodes and clients do not
+  //! contend. The caps are sharded by authid rather than by inode since the
+  //! client requests (GetTS, HasCap) only carry the authid, the per inode
+  //! work goes through the inode index which is sharded by inode. Locks are
+  //! taken in the order cap shard, inode shard, client shard and never the
+  //! other way around. All the public methods lock internally.
+  //!
+  //! Expiry uses a timer wheel, so a sweep only looks at the caps due.
   //----------------------------------------------------------------------------
-  class Caps : public eos::common::RWMutex
+  class Caps
   {
     friend class FuseServer;
   public:
@@ -74,7 +95,7 @@ EOSFUSESERVERNAMESPACE_BEGIN
 
     typedef std::shared_ptr<capx> shared_cap;
 
-    Caps() = default;
+    Caps();
 
     virtual ~Caps() = default;
 
@@ -82,59 +103,25 @@ EOSFUSESERVERNAMESPACE_BEGIN
     typedef std::string clientid_t;
     typedef std::pair<uint64_t, authid_t> ino_authid_t;
     typedef std::set<authid_t> authid_set_t;
-    typedef std::map<uint64_t, authid_set_t> ino_map_t;
+    typedef tsl::hopscotch_map<uint64_t, authid_set_t,
+            Murmur3::MurmurHasher<uint64_t>> ino_map_t;
     typedef std::set<uint64_t> ino_set_t;
-    typedef std::map<uint64_t, authid_set_t> notify_set_t; // inode=>set(authid_t)
-    typedef std::map<clientid_t, authid_set_t> client_set_t;
-    typedef std::map<clientid_t, ino_map_t> client_ino_map_t;
-
+    // client uuid => responses to deliver in one go
+    typedef std::map<std::string, std::vector<eos::fusex::response>> batch_t;
 
     ssize_t ncaps()
     {
-      eos::common::RWMutexReadLock lock(*this);
-      return mTimeOrderedCap.size();
-    }
-
-    void pop()
-    {
-      eos::common::RWMutexWriteLock lock(*this);
-
-      if (!mTimeOrderedCap.empty()) {
-        mTimeOrderedCap.erase(mTimeOrderedCap.begin());
-      }
+      return mNumCaps.load();
     }
 
-    bool expire()
-    {
-      eos::common::RWMutexWriteLock lock(*this);
-      authid_t id;
-
-      if (!mTimeOrderedCap.empty()) {
-        id = mTimeOrderedCap.begin()->second;
-      } else {
-        return false;
-      }
-
-      if (mCaps.count(id)) {
-        shared_cap cap = mCaps[id];
-        uint64_t now = (uint64_t) time(NULL);
-
-        if ((cap->vtime() + 10) <= now) {
-          mCaps.erase(id);
-          mInodeCaps[cap->id()].erase(id);
-
-          if (!mInodeCaps[cap->id()].size()) {
-            mInodeCaps.erase(cap->id());
-          }
-
-          return true;
-        } else {
-          return false;
-        }
-      }
-
-      return true;
-    }
+    //--------------------------------------------------------------------------
+    //! Remove the caps whose validity time passed
+    //!
+    //! @param now current time
+    //!
+    //! @return number of caps removed
+    //--------------------------------------------------------------------------
+    size_t Expire(time_t now);
 
     void Store(const eos::fusex::cap& cap,
                eos::common::Mapping::VirtualIdentity* vid);
@@ -144,51 +131,53 @@ EOSFUSESERVERNAMESPACE_BEGIN
                authid_t authid,
                authid_t implied_authid);
 
-    bool Remove(shared_cap cap)
-    {
-      // you have to have a write lock for the caps
-      if (mCaps.count(cap->authid())) {
-        mCaps.erase(cap->authid());
-        mInodeCaps[cap->id()].erase(cap->authid());
+    //--------------------------------------------------------------------------
+    //! Remove a cap from all the indices
+    //!
+    //! @return true if the cap was known
+    //--------------------------------------------------------------------------
+    bool Remove(shared_cap cap);
 
-        if (!mInodeCaps[cap->id()].size()) {
-          mInodeCaps.erase(cap->id());
-        }
+    int Delete(uint64_t id);
 
-        mClientInoCaps[cap->clientid()][cap->id()].erase(cap->authid());
+    //--------------------------------------------------------------------------
+    //! Get a cap by authid, returns an empty cap (id 0) if unknown
+    //--------------------------------------------------------------------------
+    shared_cap GetTS(authid_t id);
 
-        if (!mClientInoCaps[cap->clientid()][cap->id()].size()) {
-          mClientInoCaps[cap->clientid()].erase(cap->id());
+    bool HasCap(authid_t authid);
 
-          if (!mClientInoCaps[cap->clientid()].size()) {
-            mClientInoCaps.erase(cap->clientid());
-          }
-        }
+    //--------------------------------------------------------------------------
+    //! Check if a client holds a cap on an inode
+    //--------------------------------------------------------------------------
+    bool HasClientInoCap(const clientid_t& clientid, uint64_t id);
 
-        return true;
-      } else {
-        return false;
-      }
-    }
+    //--------------------------------------------------------------------------
+    //! Get the authids of the caps a client holds on an inode
+    //--------------------------------------------------------------------------
+    authid_set_t GetClientInoCaps(const clientid_t& clientid, uint64_t id);
 
-    int Delete(uint64_t id);
-
-    shared_cap GetTS(authid_t id);
-    shared_cap Get(authid_t id);
+    //--------------------------------------------------------------------------
+    //! Call a function for every cap. The shard holding the cap is locked
+    //! during the call, which must therefore not call back into Caps.
+    //--------------------------------------------------------------------------
+    void ForEach(const std::function<void(const shared_cap&)>& func);
 
     int BroadcastCap(shared_cap cap);
-    int BroadcastRelease(const eos::fusex::md&
-                         md); // broad cast triggered by fuse network
+    int BroadcastRelease(const eos::fusex::md& md,
+                         batch_t* batch = 0); // broad cast triggered by fuse network
 
     int BroadcastDeletion(uint64_t inode,
                           const eos::fusex::md& md,
-                          const std::string& name);
+                          const std::string& name,
+                          batch_t* batch = 0);
 
     int BroadcastRefresh(uint64_t
                          inode,
                          const eos::fusex::md& md,
                          uint64_t
-                         parent_inode); // broad cast triggered by fuse network
+                         parent_inode,
+                         batch_t* batch = 0); // broad cast triggered by fuse network
 
 
     int BroadcastReleaseFromExternal(uint64_t
@@ -211,42 +200,83 @@ EOSFUSESERVERNAMESPACE_BEGIN
                    ); // broad cast changed md around
     std::string Print(std::string option, std::string filter);
 
-    std::map<authid_t, shared_cap>& GetCaps()
-    {
-      return mCaps;
-    }
+  protected:
+    static constexpr size_t sNumShards = 64;
 
-    bool HasCap(authid_t authid)
-    {
-      return (this->mCaps.count(authid) ? true : false);
-    }
+    //! Seconds a cap is kept after its validity time
+    static constexpr time_t sExpiryGrace = 10;
 
-    notify_set_t& InodeCaps()
+    //! Stored cap
+    struct CapEntry {
+      shared_cap mCap; ///< The cap
+      time_t mDeadline; ///< Expiry time scheduled in the timer wheel
+    };
+
+    //! Shard of the authid => cap index
+    struct CapShard {
+      std::mutex mMutex;
+      tsl::hopscotch_map<authid_t, CapEntry,
+          Murmur3::MurmurHasher<std::string>> mCaps;
+    };
+
+    //! Shard of the inode => authids index
+    struct InodeShard {
+      std::mutex mMutex;
+      ino_map_t mInodeCaps;
+    };
+
+    //! Shard of the client => inode => authids index
+    struct ClientShard {
+      std::mutex mMutex;
+      tsl::hopscotch_map<clientid_t, ino_map_t,
+          Murmur3::MurmurHasher<std::string>> mClientInoCaps;
+    };
+
+    CapShard& GetCapShard(const authid_t& authid)
     {
-      return mInodeCaps;
+      return mCapShards[Murmur3::MurmurHasher<std::string>()(authid) %
+                        sNumShards];
     }
 
-    client_set_t& ClientCaps()
+    InodeShard& GetInodeShard(uint64_t id)
     {
-      return mClientCaps;
+      return mInodeShards[Murmur3::MurmurHasher<uint64_t>()(id) % sNumShards];
     }
 
-    client_ino_map_t& ClientInoCaps()
+    ClientShard& GetClientShard(const clientid_t& clientid)
     {
-      return mClientInoCaps;
+      return mClientShards[Murmur3::MurmurHasher<std::string>()(clientid) %
+                           sNumShards];
     }
 
-  protected:
-    // a time ordered multimap pointing to caps
-    std::multimap< time_t, authid_t > mTimeOrderedCap;
-    // authid=>cap lookup map
-    std::map<authid_t, shared_cap> mCaps;
-    // clientid=>list of authid
-    client_set_t mClientCaps;
-    // clientid=>list of inodes
-    client_ino_map_t mClientInoCaps;
-    // inode=>authid_t
-    notify_set_t mInodeCaps;
+    //--------------------------------------------------------------------------
+    //! Add a cap to the indices, replacing a cap with the same authid.
+    //! Schedules its expiry if it is new or expires earlier than before.
+    //--------------------------------------------------------------------------
+    void Insert(shared_cap cap);
+
+    //--------------------------------------------------------------------------
+    //! Drop a cap from the inode and client indices, the cap shard of its
+    //! authid must be locked by the caller
+    //--------------------------------------------------------------------------
+    void Unindex(const shared_cap& cap);
+
+    //--------------------------------------------------------------------------
+    //! Get the caps held on an inode
+    //--------------------------------------------------------------------------
+    std::vector<shared_cap> GetInodeCaps(uint64_t id);
+
+    //--------------------------------------------------------------------------
+    //! Send the responses collected by a broadcast
+    //--------------------------------------------------------------------------
+    void Flush(batch_t& batch);
+
+    CapShard mCapShards[sNumShards]; ///< authid => cap
+    InodeShard mInodeShards[sNumShards]; ///< inode => authids
+    ClientShard mClientShards[sNumShards]; ///< client => inode => authids
+    std::atomic<ssize_t> mNumCaps; ///< Number of caps stored
+    //! Caps by expiry time, as (authid, deadline)
+    eos::common::TimerWheel<std::pair<authid_t, time_t>> mExpiry;
   };
-  
+
 EOSFUSESERVERNAMESPACE_END
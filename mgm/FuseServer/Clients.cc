@@ -24,6 +24,7 @@
 #include <string>
 #include <cstdlib>
 #include <thread>
+#include <algorithm>
 
 #include "mgm/FuseServer/Clients.hh"
 #include "common/Logging.hh"
@@ -126,7 +127,7 @@ FuseServer::Clients::MonitorHeartBeat()
     // delete client ot be evicted because of a version mismatch
     for (auto it = evictversionmap.begin(); it != evictversionmap.end(); ++it) {
       std::string versionerror =
-        "Server supports PROTOCOLV4 and requires atleast PROTOCOLV2";
+        "Server supports PROTOCOLV5 and requires atleast PROTOCOLV2";
       std::string uuid = it->first;
       Evict(uuid, versionerror);
       mMap.erase(it->second);
@@ -134,6 +135,7 @@ FuseServer::Clients::MonitorHeartBeat()
     }
 
     gOFS->zMQ->gFuseServer.Flushs().expireFlush();
+    gOFS->zMQ->gFuseServer.Listing().Expire();
     std::this_thread::sleep_for(std::chrono::seconds(1));
 
     if (should_terminate()) {
@@ -228,7 +230,6 @@ FuseServer::Clients::Dispatch(const std::string identity,
 
       // revoke LEASES by cap
       for (auto it = caps_to_revoke.begin(); it != caps_to_revoke.end(); ++it) {
-        eos::common::RWMutexWriteLock lLock(gOFS->zMQ->gFuseServer.Cap());
         gOFS->zMQ->gFuseServer.Cap().Remove(*it);
       }
 
@@ -249,20 +250,11 @@ FuseServer::Clients::Print(std::string& out, std::string options)
   struct timespec tsnow;
   eos::common::Timing::GetTimeSpec(tsnow);
   std::map<std::string, size_t> clientcaps;
-  {
-    eos::common::RWMutexReadLock lLock(gOFS->zMQ->gFuseServer.Cap());
-
-    // count caps per client uuid
-    for (auto it = gOFS->zMQ->gFuseServer.Cap().InodeCaps().begin();
-         it != gOFS->zMQ->gFuseServer.Cap().InodeCaps().end(); ++it) {
-      for (auto sit = it->second.begin(); sit != it->second.end(); ++sit) {
-        if (gOFS->zMQ->gFuseServer.Cap().GetCaps().count(*sit)) {
-          FuseServer::Caps::shared_cap cap = gOFS->zMQ->gFuseServer.Cap().GetCaps()[*sit];
-          clientcaps[cap->clientuuid()]++;
-        }
-      }
-    }
-  }
+  // count caps per client uuid
+  gOFS->zMQ->gFuseServer.Cap().ForEach([&clientcaps](const
+  FuseServer::Caps::shared_cap & cap) {
+    clientcaps[cap->clientuuid()]++;
+  });
   struct timespec now_time;
   eos::common::Timing::GetTimeSpec(now_time, true);
   eos::common::RWMutexReadLock lLock(*this);
@@ -662,208 +654,109 @@ FuseServer::Clients::Evict(std::string& uuid, std::string reason, std::vector<st
 int
 FuseServer::Clients::Dropcaps(const std::string& uuid, std::string& out)
 {
-  eos::common::RWMutexWriteLock lLock(gOFS->zMQ->gFuseServer.Cap());
   out += " dropping caps of '";
   out += uuid;
   out += "' : ";
+  {
+    eos::common::RWMutexReadLock lLock(*this);
 
-  if (!mUUIDView.count(uuid)) {
-    return ENOENT;
-  }
-
-  std::string id = mUUIDView[uuid];
-  Caps::ino_set_t cleanup_authids;
-
-  for (auto it = gOFS->zMQ->gFuseServer.Cap().InodeCaps().begin();
-       it != gOFS->zMQ->gFuseServer.Cap().InodeCaps().end(); ++it) {
-    std::set<FuseServer::Caps::shared_cap> cap2delete;
-
-    for (auto sit = it->second.begin(); sit != it->second.end(); ++sit) {
-      if (gOFS->zMQ->gFuseServer.Cap().HasCap(*sit)) {
-        FuseServer::Caps::shared_cap cap = gOFS->zMQ->gFuseServer.Cap().GetCaps()[*sit];
-
-        if (cap->clientuuid() == uuid) {
-          cap2delete.insert(cap);
-          out += "\n ";
-          char ahex[20];
-          snprintf(ahex, sizeof(ahex), "%016lx", (unsigned long) cap->id());
-          std::string match = "";
-          match += "# i:";
-          match += ahex;
-          match += " a:";
-          match += cap->authid();
-          out += match;
-        }
-      }
-    }
-
-    for (auto scap = cap2delete.begin(); scap != cap2delete.end(); ++scap) {
-      gOFS->zMQ->gFuseServer.Client().ReleaseCAP((uint64_t)(*scap)->id(),
-          (*scap)->clientuuid(),
-          (*scap)->clientid());
-      eos_static_info("erasing %llx %s %s", (*scap)->id(),
-                      (*scap)->clientid().c_str(), (*scap)->authid().c_str());
-      // erase cap by auth id
-      gOFS->zMQ->gFuseServer.Cap().GetCaps().erase((*scap)->authid());
-      // erase cap by inode
-      gOFS->zMQ->gFuseServer.Cap().InodeCaps()[(*scap)->id()].erase((
-            *scap)->authid());
-
-      if (!gOFS->zMQ->gFuseServer.Cap().InodeCaps()[(*scap)->id()].size()) {
-        cleanup_authids.insert((*scap)->id());
-      }
-
-      gOFS->zMQ->gFuseServer.Cap().ClientCaps()[(*scap)->clientid()].erase((
-            *scap)->authid());
-
-      if (!gOFS->zMQ->gFuseServer.Cap().ClientCaps()[(*scap)->clientid()].size()) {
-        gOFS->zMQ->gFuseServer.Cap().ClientCaps().erase((*scap)->clientid());
-      }
-
-      gOFS->zMQ->gFuseServer.Cap().ClientCaps()[(*scap)->clientid()].insert((
-            *scap)->authid());
+    if (!mUUIDView.count(uuid)) {
+      return ENOENT;
     }
   }
-
-  for (auto it = cleanup_authids.begin(); it != cleanup_authids.end(); ++it) {
-    if (!gOFS->zMQ->gFuseServer.Cap().InodeCaps()[*it].size()) {
-      gOFS->zMQ->gFuseServer.Cap().InodeCaps().erase(*it);
+  Caps& caps = gOFS->zMQ->gFuseServer.Cap();
+  std::vector<FuseServer::Caps::shared_cap> cap2delete;
+  caps.ForEach([&](const FuseServer::Caps::shared_cap & cap) {
+    if (cap->clientuuid() == uuid) {
+      cap2delete.push_back(cap);
     }
+  });
+  std::sort(cap2delete.begin(), cap2delete.end(),
+  [](const FuseServer::Caps::shared_cap & a,
+  const FuseServer::Caps::shared_cap & b) {
+    return a->id() < b->id();
+  });
+  Caps::batch_t batch;
+
+  for (auto scap = cap2delete.begin(); scap != cap2delete.end(); ++scap) {
+    out += "\n ";
+    char ahex[20];
+    snprintf(ahex, sizeof(ahex), "%016lx", (unsigned long)(*scap)->id());
+    std::string match = "";
+    match += "# i:";
+    match += ahex;
+    match += " a:";
+    match += (*scap)->authid();
+    out += match;
+    batch[uuid].push_back(MakeReleaseCAP((*scap)->id(), (*scap)->clientid()));
+    eos_static_info("erasing %llx %s %s", (*scap)->id(),
+                    (*scap)->clientid().c_str(), (*scap)->authid().c_str());
+    caps.Remove(*scap);
   }
 
+  SendBatch(batch);
   return 0;
 }
 
 //------------------------------------------------------------------------------
-//
+// Build a cap release message
 //------------------------------------------------------------------------------
-int
-FuseServer::Clients::ReleaseCAP(uint64_t md_ino,
-                                const std::string& uuid,
-                                const std::string& clientid
-                               )
+eos::fusex::response
+FuseServer::Clients::MakeReleaseCAP(uint64_t md_ino,
+                                    const std::string& clientid)
 {
   gOFS->MgmStats.Add("Eosxd::int::ReleaseCap", 0, 0, 1);
-  EXEC_TIMING_BEGIN("Eosxd::int::ReleaseCap");
-  // prepare release cap message
   eos::fusex::response rsp;
   rsp.set_type(rsp.LEASE);
   rsp.mutable_lease_()->set_type(eos::fusex::lease::RELEASECAP);
   rsp.mutable_lease_()->set_md_ino(md_ino);
   rsp.mutable_lease_()->set_clientid(clientid);
-  std::string rspstream;
-  rsp.SerializeToString(&rspstream);
-  eos::common::RWMutexReadLock lLock(*this);
-
-  if (!mUUIDView.count(uuid)) {
-    return ENOENT;
-  }
-
-  std::string id = mUUIDView[uuid];
-  lLock.Release();
-  eos_static_info("msg=\"asking cap release\" uuid=%s clientid=%s id=%lx",
-                  uuid.c_str(), clientid.c_str(), md_ino);
-  gOFS->zMQ->mTask->reply(id, rspstream);
-  EXEC_TIMING_END("Eosxd::int::ReleaseCap");
-  return 0;
+  return rsp;
 }
 
 //------------------------------------------------------------------------------
-//
+// Build a dentry deletion message
 //------------------------------------------------------------------------------
-int
-FuseServer::Clients::DeleteEntry(uint64_t md_ino,
-                                 const std::string& uuid,
-                                 const std::string& clientid,
-                                 const std::string& name
-                                )
+eos::fusex::response
+FuseServer::Clients::MakeDeleteEntry(uint64_t md_ino,
+                                     const std::string& clientid,
+                                     const std::string& name)
 {
   gOFS->MgmStats.Add("Eosxd::int::DeleteEntry", 0, 0, 1);
-  EXEC_TIMING_BEGIN("Eosxd::int::DeleteEntry");
-  // prepare release cap message
   eos::fusex::response rsp;
   rsp.set_type(rsp.DENTRY);
   rsp.mutable_dentry_()->set_type(eos::fusex::dentry::REMOVE);
   rsp.mutable_dentry_()->set_name(name);
   rsp.mutable_dentry_()->set_md_ino(md_ino);
   rsp.mutable_dentry_()->set_clientid(clientid);
-  std::string rspstream;
-  rsp.SerializeToString(&rspstream);
-  eos::common::RWMutexReadLock lLock(*this);
-
-  if (!mUUIDView.count(uuid)) {
-    return ENOENT;
-  }
-
-  std::string id = mUUIDView[uuid];
-  lLock.Release();
-  eos_static_info("msg=\"asking dentry deletion\" uuid=%s clientid=%s id=%lx name=%s",
-                  uuid.c_str(), clientid.c_str(), md_ino, name.c_str());
-  gOFS->zMQ->mTask->reply(id, rspstream);
-  EXEC_TIMING_END("Eosxd::int::DeleteEntry");
-  return 0;
+  return rsp;
 }
 
 //------------------------------------------------------------------------------
-//
+// Build a dentry refresh message
 //------------------------------------------------------------------------------
-int
-FuseServer::Clients::RefreshEntry(uint64_t md_ino,
-                                  const std::string& uuid,
-                                  const std::string& clientid
-                                 )
+eos::fusex::response
+FuseServer::Clients::MakeRefreshEntry(uint64_t md_ino)
 {
   gOFS->MgmStats.Add("Eosxd::int::RefreshEntry", 0, 0, 1);
-  EXEC_TIMING_BEGIN("Eosxd::int::RefreshEntry");
-  // prepare release cap message
   eos::fusex::response rsp;
   rsp.set_type(rsp.REFRESH);
   rsp.mutable_refresh_()->set_md_ino(md_ino);
-  std::string rspstream;
-  rsp.SerializeToString(&rspstream);
-  eos::common::RWMutexReadLock lLock(*this);
-
-  if (!mUUIDView.count(uuid)) {
-    return ENOENT;
-  }
-
-  std::string id = mUUIDView[uuid];
-  eos_static_info("client=%s\n", map()[id].heartbeat().version().c_str());
-
-  if (DeferClient(map()[id].heartbeat().version(), "4.4.18")) {
-    // dont' send refresh to client version < 4.4.18 (4.4.17 deadlocks, others ignore)
-    eos_static_info("suppressing refresh to client '%s' version='%s'",
-                    clientid.c_str(), map()[id].heartbeat().version().c_str());
-  } else {
-    std::string id = mUUIDView[uuid];
-    lLock.Release();
-    eos_static_info("msg=\"asking dentry refresh\" uuid=%s clientid=%s id=%lx",
-                    uuid.c_str(), clientid.c_str(), md_ino);
-    gOFS->zMQ->mTask->reply(id, rspstream);
-  }
-
-  EXEC_TIMING_END("Eosxd::int::RefreshEntry");
-  return 0;
+  return rsp;
 }
 
 //------------------------------------------------------------------------------
-//
+// Build a metadata update message
 //------------------------------------------------------------------------------
-int
-FuseServer::Clients::SendMD(const eos::fusex::md& md,
-                            const std::string& uuid,
+eos::fusex::response
+FuseServer::Clients::MakeMD(const eos::fusex::md& md,
                             const std::string& clientid,
                             uint64_t md_ino,
                             uint64_t md_pino,
                             uint64_t clock,
-                            struct timespec& p_mtime
-                           )
-/*----------------------------------------------------------------------------*/
-
+                            struct timespec& p_mtime)
 {
   gOFS->MgmStats.Add("Eosxd::int::SendMD", 0, 0, 1);
-  EXEC_TIMING_BEGIN("Eosxd::int::SendMD");
-  // prepare update message
   eos::fusex::response rsp;
   rsp.set_type(rsp.MD);
   *(rsp.mutable_md_()) = md;
@@ -880,23 +773,86 @@ FuseServer::Clients::SendMD(const eos::fusex::md& md,
   }
 
   rsp.mutable_md_()->set_clock(clock);
+  return rsp;
+}
+
+//------------------------------------------------------------------------------
+// Send messages to a client
+//------------------------------------------------------------------------------
+int
+FuseServer::Clients::SendResponses(const std::string& uuid,
+                                   const std::vector<eos::fusex::response>& rsps)
+{
+  if (rsps.empty()) {
+    return 0;
+  }
+
+  std::string id;
+  bool batching = false;
+  bool refresh = true;
+  {
+    eos::common::RWMutexReadLock lLock(*this);
+    auto uit = mUUIDView.find(uuid);
+
+    if (uit == mUUIDView.end()) {
+      return ENOENT;
+    }
+
+    id = uit->second;
+    auto cit = mMap.find(id);
+
+    if (cit != mMap.end()) {
+      eos::fusex::heartbeat& hb = cit->second.heartbeat();
+      batching = (hb.protversion() >= eos::fusex::heartbeat::PROTOCOLV5);
+      // dont' send refresh to client version < 4.4.18 (4.4.17 deadlocks, others ignore)
+      refresh = !DeferClient(hb.version(), "4.4.18");
+    }
+  }
+  eos::fusex::response batch;
+  batch.set_type(batch.BATCH);
+
+  for (const auto& rsp : rsps) {
+    if ((rsp.type() == rsp.REFRESH) && !refresh) {
+      eos_static_info("suppressing refresh to client '%s'", id.c_str());
+      continue;
+    }
+
+    *batch.add_batch_() = rsp;
+  }
+
   std::string rspstream;
-  rsp.SerializeToString(&rspstream);
-  eos::common::RWMutexReadLock lLock(*this);
 
-  if (!mUUIDView.count(uuid)) {
-    return ENOENT;
+  if (batching && (batch.batch__size() > 1)) {
+    gOFS->MgmStats.Add("Eosxd::int::SendBatch", 0, 0, 1);
+    eos_static_info("msg=\"sending batch\" uuid=%s id=%s n=%d",
+                    uuid.c_str(), id.c_str(), batch.batch__size());
+    batch.SerializeToString(&rspstream);
+    gOFS->zMQ->mTask->reply(id, rspstream);
+    return 0;
+  }
+
+  for (const auto& rsp : batch.batch_()) {
+    eos_static_info("msg=\"sending message\" uuid=%s id=%s type=%s",
+                    uuid.c_str(), id.c_str(),
+                    eos::fusex::response::Type_Name(rsp.type()).c_str());
+    rsp.SerializeToString(&rspstream);
+    gOFS->zMQ->mTask->reply(id, rspstream);
   }
 
-  lLock.Release();
-  std::string id = mUUIDView[uuid];
-  eos_static_info("msg=\"sending md update\" uuid=%s clientid=%s id=%lx",
-                  uuid.c_str(), clientid.c_str(), md_ino);
-  gOFS->zMQ->mTask->reply(id, rspstream);
-  EXEC_TIMING_END("Eosxd::int::SendMD");
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Send the messages collected for several clients
+//------------------------------------------------------------------------------
+void
+FuseServer::Clients::SendBatch(const Caps::batch_t& batch)
+{
+  for (auto it = batch.begin(); it != batch.end(); ++it) {
+    SendResponses(it->first, it->second);
+  }
+}
+
 //------------------------------------------------------------------------------
 //
 //------------------------------------------------------------------------------
@@ -169,31 +169,33 @@ EOSFUSESERVERNAMESPACE_BEGIN
     // evict a client by force
     int Evict(std::string& uuid, std::string reason, std::vector<std::string>* evicted_out=0);
 
-    // release CAPs
-    int ReleaseCAP(uint64_t id,
-                   const std::string& uuid,
-                   const std::string& clientid);
-
-    // delete entry
-    int DeleteEntry(uint64_t id,
-                    const std::string& uuid,
-                    const std::string& clientid,
-                    const std::string& name);
-
-    // refresh entry
-    int RefreshEntry(uint64_t id,
-                     const std::string& uuid,
-                     const std::string& clientid);
-
-    // send MD after update
-    int SendMD(const eos::fusex::md& md,
-               const std::string& uuid,
-               const std::string& clientid,
-               uint64_t md_ino,
-               uint64_t md_pino,
-               uint64_t clock,
-               struct timespec& p_mtime
-              );
+    // build a cap release message
+    static eos::fusex::response MakeReleaseCAP(uint64_t id,
+        const std::string& clientid);
+
+    // build a dentry deletion message
+    static eos::fusex::response MakeDeleteEntry(uint64_t id,
+        const std::string& clientid,
+        const std::string& name);
+
+    // build a dentry refresh message
+    static eos::fusex::response MakeRefreshEntry(uint64_t id);
+
+    // build an MD update message
+    static eos::fusex::response MakeMD(const eos::fusex::md& md,
+                                       const std::string& clientid,
+                                       uint64_t md_ino,
+                                       uint64_t md_pino,
+                                       uint64_t clock,
+                                       struct timespec& p_mtime);
+
+    // send messages to a client - clients speaking PROTOCOLV5 get all of
+    // them in a single BATCH message
+    int SendResponses(const std::string& uuid,
+                      const std::vector<eos::fusex::response>& rsps);
+
+    // send the messages collected by cap broadcasts, grouped by client uuid
+    void SendBatch(const Caps::batch_t& batch);
 
     // broadcast a new cap
     int SendCAP(FuseServer::Caps::shared_cap cap);
@@ -0,0 +1,144 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#include "mgm/FuseServer/Listings.hh"
+
+EOSFUSESERVERNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Register the snapshot of the children of a directory
+//------------------------------------------------------------------------------
+uint64_t
+Listings::Create(uint64_t ino, shared_children children)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mListings.size() >= cMaxListings) {
+    // evict the listing closest to expiry, its client restarts if it comes back
+    auto oldest = mListings.begin();
+
+    for (auto it = mListings.begin(); it != mListings.end(); ++it) {
+      if (it->second.expires < oldest->second.expires) {
+        oldest = it;
+      }
+    }
+
+    mListings.erase(oldest);
+  }
+
+  uint64_t id = mNextId++;
+  mListings[id] = listing_info_t {ino, std::move(children),
+                                  time(NULL) + cListingTTL
+                                 };
+  return id;
+}
+
+//------------------------------------------------------------------------------
+// Get the snapshot of a listing, extending its lifetime
+//------------------------------------------------------------------------------
+Listings::shared_children
+Listings::Get(uint64_t id, uint64_t ino)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mListings.find(id);
+
+  if ((it == mListings.end()) || (it->second.ino != ino)) {
+    return nullptr;
+  }
+
+  it->second.expires = time(NULL) + cListingTTL;
+  return it->second.children;
+}
+
+//------------------------------------------------------------------------------
+// Drop a completed listing
+//------------------------------------------------------------------------------
+void
+Listings::Drop(uint64_t id)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mListings.erase(id);
+}
+
+//------------------------------------------------------------------------------
+// Drop the expired listings
+//------------------------------------------------------------------------------
+void
+Listings::Expire(time_t now)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (auto it = mListings.begin(); it != mListings.end();) {
+    if (it->second.expires < now) {
+      it = mListings.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get number of listings in flight
+//------------------------------------------------------------------------------
+size_t
+Listings::Size()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mListings.size();
+}
+
+//------------------------------------------------------------------------------
+// Build the cursor pointing to an offset of a listing
+//------------------------------------------------------------------------------
+std::string
+Listings::MakeCursor(uint64_t id, size_t offset)
+{
+  char cursor[64];
+  snprintf(cursor, sizeof(cursor), "%lx:%lx", (unsigned long) id,
+           (unsigned long) offset);
+  return cursor;
+}
+
+//------------------------------------------------------------------------------
+// Parse a cursor
+//------------------------------------------------------------------------------
+bool
+Listings::ParseCursor(const std::string& cursor, uint64_t& id, size_t& offset)
+{
+  size_t pos = cursor.find(':');
+
+  if ((pos == std::string::npos) || (pos == 0)) {
+    return false;
+  }
+
+  char* end = 0;
+  id = strtoull(cursor.c_str(), &end, 16);
+
+  if (end != cursor.c_str() + pos) {
+    return false;
+  }
+
+  offset = strtoull(cursor.c_str() + pos + 1, &end, 16);
+  return (*end == 0) && (end != cursor.c_str() + pos + 1);
+}
+
+EOSFUSESERVERNAMESPACE_END
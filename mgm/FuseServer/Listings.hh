@@ -0,0 +1,117 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mgm/Namespace.hh"
+
+EOSFUSESERVERNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class Listings
+//!
+//! Directory listings served page by page to fusex clients. The first page
+//! request takes a snapshot of the (name, inode) pairs of the directory
+//! children and registers it under a listing id; every page returns a cursor
+//! made of the listing id and the offset of the next page. The snapshot only
+//! holds names and inodes, the meta-data of the children is filled page by
+//! page. Unknown or expired cursors make the server restart the listing from
+//! a new snapshot, clients merge the pages by name so restarting is harmless.
+//------------------------------------------------------------------------------
+class Listings
+{
+public:
+  typedef std::vector<std::pair<std::string, uint64_t>> children_t;
+  typedef std::shared_ptr<const children_t> shared_children;
+
+  static constexpr int cListingTTL = 60; ///< Seconds a cursor stays valid
+  static constexpr size_t cMaxListings = 1024; ///< Max listings in flight
+  static constexpr size_t cMaxPageSize = 65536; ///< Max children per page
+
+  Listings() = default;
+
+  virtual ~Listings() = default;
+
+  //----------------------------------------------------------------------------
+  //! Register the snapshot of the children of a directory
+  //!
+  //! @param ino directory inode
+  //! @param children snapshot of the children
+  //!
+  //! @return listing id
+  //----------------------------------------------------------------------------
+  uint64_t Create(uint64_t ino, shared_children children);
+
+  //----------------------------------------------------------------------------
+  //! Get the snapshot of a listing, extending its lifetime
+  //!
+  //! @param id listing id
+  //! @param ino directory inode the listing is expected to belong to
+  //!
+  //! @return snapshot or nullptr if unknown, expired or of another directory
+  //----------------------------------------------------------------------------
+  shared_children Get(uint64_t id, uint64_t ino);
+
+  //----------------------------------------------------------------------------
+  //! Drop a completed listing
+  //----------------------------------------------------------------------------
+  void Drop(uint64_t id);
+
+  //----------------------------------------------------------------------------
+  //! Drop the expired listings
+  //!
+  //! @param now current time
+  //----------------------------------------------------------------------------
+  void Expire(time_t now = time(NULL));
+
+  //----------------------------------------------------------------------------
+  //! Get number of listings in flight
+  //----------------------------------------------------------------------------
+  size_t Size();
+
+  //----------------------------------------------------------------------------
+  //! Build the cursor pointing to an offset of a listing
+  //----------------------------------------------------------------------------
+  static std::string MakeCursor(uint64_t id, size_t offset);
+
+  //----------------------------------------------------------------------------
+  //! Parse a cursor, return false if empty or malformed
+  //----------------------------------------------------------------------------
+  static bool ParseCursor(const std::string& cursor, uint64_t& id,
+                          size_t& offset);
+
+private:
+  typedef struct listing_info {
+    uint64_t ino; ///< Directory inode
+    shared_children children; ///< Snapshot of the children
+    time_t expires; ///< Expiration time
+  } listing_info_t;
+
+  std::mutex mMutex; ///< Mutex protecting the listings
+  std::map<uint64_t, listing_info_t> mListings; ///< Listings by id
+  uint64_t mNextId {1}; ///< Next listing id
+};
+
+EOSFUSESERVERNAMESPACE_END
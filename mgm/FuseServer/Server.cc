@@ -25,6 +25,7 @@
 #include <cstdlib>
 #include <thread>
 #include <regex>
+#include <algorithm>
 
 #include <google/protobuf/util/json_util.h>
 
@@ -43,6 +44,7 @@
 #include "namespace/interface/IContainerMD.hh"
 #include "namespace/interface/ContainerIterators.hh"
 #include "namespace/Prefetcher.hh"
+#include "namespace/MDException.hh"
 
 #include "common/Logging.hh"
 #include "common/Path.hh"
@@ -59,6 +61,98 @@ EOSFUSESERVERNAMESPACE_BEGIN
         const char* k_mdino = "sys.eos.mdino";
 const char* k_nlink = "sys.eos.nlink";
 
+//------------------------------------------------------------------------------
+//! Lock the entries of a fusex file update: the target container, the
+//! container currently holding the file, the file and the file it may
+//! replace. They are looked up without the locks, so the lookup is retried
+//! until it is stable under the locks.
+//------------------------------------------------------------------------------
+static void
+LockFileUpdate(eos::MDLocker& locker,
+               const std::shared_ptr<eos::IContainerMD>& pcmd,
+               const std::shared_ptr<eos::IFileMD>& fmd,
+               const std::string& name)
+{
+  for (int attempt = 0; attempt < 16; ++attempt) {
+    eos::IContainerMD::id_t cid = fmd->getContainerId();
+    std::shared_ptr<eos::IFileMD> ofmd = pcmd->findFile(name);
+    locker.clear();
+    locker.addContainer(pcmd->getId()).addContainer(cid).addFile(fmd->getId());
+
+    if (ofmd) {
+      locker.addFile(ofmd->getId());
+    }
+
+    locker.lock();
+    std::shared_ptr<eos::IFileMD> nfmd = pcmd->findFile(name);
+
+    if ((fmd->getContainerId() == cid) &&
+        ((ofmd ? ofmd->getId() : 0) == (nfmd ? nfmd->getId() : 0))) {
+      return;
+    }
+
+    locker.unlock();
+  }
+
+  throw_mdexception(EAGAIN, "file " << fmd->getId() << " keeps moving");
+}
+
+//------------------------------------------------------------------------------
+//! Lock the entries of a fusex deletion: the parent container sent by the
+//! client, the entry to delete and, for a hard link, the file holding the
+//! inode together with its container. Once locked, the entry must still be
+//! a child of the given parent, otherwise a concurrent move took it away and
+//! the deletion fails with ENOENT instead of touching a container which is
+//! not locked.
+//------------------------------------------------------------------------------
+static void
+LockEntryDelete(eos::MDLocker& locker,
+                const std::shared_ptr<eos::IContainerMD>& pcmd,
+                const std::shared_ptr<eos::IContainerMD>& cmd,
+                const std::shared_ptr<eos::IFileMD>& fmd,
+                const std::shared_ptr<eos::IFileMD>& gmd)
+{
+  for (int attempt = 0; attempt < 16; ++attempt) {
+    eos::IContainerMD::id_t gcid = (gmd ? gmd->getContainerId() : 0);
+    locker.clear();
+    locker.addContainer(pcmd->getId());
+
+    if (cmd) {
+      locker.addContainer(cmd->getId());
+    }
+
+    if (fmd) {
+      locker.addFile(fmd->getId());
+    }
+
+    if (gmd) {
+      locker.addFile(gmd->getId());
+
+      if (gcid) {
+        locker.addContainer(gcid);
+      }
+    }
+
+    locker.lock();
+
+    if ((cmd && (cmd->getParentId() != pcmd->getId())) ||
+        (fmd && (fmd->getContainerId() != pcmd->getId()))) {
+      locker.unlock();
+      throw_mdexception(ENOENT, "entry is no longer in container "
+                        << pcmd->getId());
+    }
+
+    if (!gmd || (gmd->getContainerId() == gcid)) {
+      return;
+    }
+
+    locker.unlock();
+  }
+
+  throw_mdexception(EAGAIN, "hard link target " << gmd->getId()
+                    << " keeps moving");
+}
+
 
 USE_EOSFUSESERVERNAMESPACE
 
@@ -141,16 +235,9 @@ Server::MonitorCaps() noexcept
   while (1) {
     EXEC_TIMING_BEGIN("Eosxd::int::MonitorCaps");
 
-    // expire caps
-    do {
-      if (Cap().expire()) {
-        Cap().pop();
-      } else {
-        break;
-      }
-    } while (1);
-
     time_t now = time(NULL);
+    // expire caps
+    Cap().Expire(now);
 
     if (!(cnt % Clients().QuotaCheckInterval())) {
       // check quota nodes every mQuotaCheckInterval iterations
@@ -179,40 +266,32 @@ Server::MonitorCaps() noexcept
         }
       } quotainfo_t;
       std::map<std::string, quotainfo_t> qmap;
-      {
-        eos::common::RWMutexReadLock lLock(Cap());
+      if (EOS_LOGS_DEBUG) {
+        eos_static_debug("looping over caps n=%ld", (long) Cap().ncaps());
+      }
 
+      Cap().ForEach([&](const FuseServer::Caps::shared_cap & cap) {
         if (EOS_LOGS_DEBUG) {
-          eos_static_debug("looping over caps n=%d", Cap().GetCaps().size());
+          eos_static_debug("cap q-node %lx", cap->_quota().quota_inode());
         }
 
-        std::map<FuseServer::Caps::authid_t, FuseServer::Caps::shared_cap>& allcaps =
-                Cap().GetCaps();
-
-        for (auto it = allcaps.begin(); it != allcaps.end(); ++it) {
-          if (EOS_LOGS_DEBUG) {
-            eos_static_debug("cap q-node %lx", it->second->_quota().quota_inode());
-          }
-
-          // if we find a cap with 'noquota' contents, we just ignore this one
-          if (it->second->_quota().inode_quota() == noquota) {
-            continue;
-          }
+        // if we find a cap with 'noquota' contents, we just ignore this one
+        if (cap->_quota().inode_quota() == noquota) {
+          return;
+        }
 
-          if (it->second->_quota().quota_inode()) {
-            quotainfo_t qi(it->second->uid(), it->second->gid(),
-                           it->second->_quota().quota_inode());
+        if (cap->_quota().quota_inode()) {
+          quotainfo_t qi(cap->uid(), cap->gid(), cap->_quota().quota_inode());
 
-            // skip if we did this already ...
-            if (qmap.count(qi.id())) {
-              qmap[qi.id()].authids.push_back(it->second->authid());
-            } else {
-              qmap[qi.id()] = qi;
-              qmap[qi.id()].authids.push_back(it->second->authid());
-            }
+          // skip if we did this already ...
+          if (qmap.count(qi.id())) {
+            qmap[qi.id()].authids.push_back(cap->authid());
+          } else {
+            qmap[qi.id()] = qi;
+            qmap[qi.id()].authids.push_back(cap->authid());
           }
         }
-      }
+      });
 
       for (auto it = qmap.begin(); it != qmap.end(); ++it) {
         eos::IContainerMD::id_t qino_id = it->second.qid;
@@ -237,16 +316,9 @@ Server::MonitorCaps() noexcept
                 ((avail_files && avail_bytes) &&
                  (outofquota.count(*auit)))) { // first time back to quota
               // send the changed quota information via a cap update
-              FuseServer::Caps::shared_cap cap;
-              {
-                eos::common::RWMutexReadLock lLock(Cap());
+              FuseServer::Caps::shared_cap cap = Cap().GetTS(*auit);
 
-                if (Cap().GetCaps().count(*auit)) {
-                  cap = Cap().GetCaps()[*auit];
-                }
-              }
-
-              if (cap) {
+              if (cap->id()) {
                 cap->mutable__quota()->set_inode_quota(avail_files);
                 cap->mutable__quota()->set_volume_quota(avail_bytes);
                 // send this cap (again)
@@ -539,27 +611,13 @@ Server::FillContainerCAP(uint64_t id,
 
     // check if the client has already a cap, in case yes, we don't return a new
     // one
-    eos::common::RWMutexReadLock lLock(Cap());
-
-    if (Cap().ClientInoCaps().count(dir.clientid())) {
-      if (Cap().ClientInoCaps()[dir.clientid()].count(id)) {
-        return true;
-      }
+    if (Cap().HasClientInoCap(dir.clientid(), id)) {
+      return true;
     }
   } else {
     // avoid to pile-up caps for the same client, delete previous ones
-    eos::common::RWMutexReadLock lLock(Cap());
-
-    if (Cap().ClientInoCaps().count(dir.clientid())) {
-      if (Cap().ClientInoCaps()[dir.clientid()].count(id)) {
-	for (auto it = Cap().ClientInoCaps()[dir.clientid()][id].begin();
-	     it != Cap().ClientInoCaps()[dir.clientid()][id].end(); ++it) {
-	  if (*it != reuse_uuid) {
-	    duplicated_caps.insert(*it);
-	  }
-	}
-      }
-    }
+    duplicated_caps = Cap().GetClientInoCaps(dir.clientid(), id);
+    duplicated_caps.erase(reuse_uuid);
   }
 
   dir.mutable_capability()->set_id(id);
@@ -802,14 +860,10 @@ Server::FillContainerCAP(uint64_t id,
   EXEC_TIMING_END("Eosxd::int::FillContainerCAP");
   Cap().Store(dir.capability(), &vid);
 
-  if (duplicated_caps.size()) {
-    eos::common::RWMutexWriteLock lLock(Cap());
-
-    for (auto it = duplicated_caps.begin(); it != duplicated_caps.end(); ++it) {
-      eos_static_debug("removing duplicated cap %s\n", it->c_str());
-      Caps::shared_cap cap = Cap().Get(*it);
-      Cap().Remove(cap);
-    }
+  for (auto it = duplicated_caps.begin(); it != duplicated_caps.end(); ++it) {
+    eos_static_debug("removing duplicated cap %s\n", it->c_str());
+    Caps::shared_cap cap = Cap().GetTS(*it);
+    Cap().Remove(cap);
   }
 
   return true;
@@ -1039,7 +1093,12 @@ Server::prefetchMD(const eos::fusex::md& md)
   if (md.operation() == md.GET) {
     Prefetcher::prefetchInodeAndWait(gOFS->eosView, md.md_ino());
   } else if (md.operation() == md.LS) {
-    Prefetcher::prefetchInodeWithChildrenAndWait(gOFS->eosView, md.md_ino());
+    if (md.ls_limit()) {
+      // paginated listings prefetch the children of each page on their own
+      Prefetcher::prefetchInodeAndWait(gOFS->eosView, md.md_ino());
+    } else {
+      Prefetcher::prefetchInodeWithChildrenAndWait(gOFS->eosView, md.md_ino());
+    }
   }
 }
 
@@ -1101,6 +1160,11 @@ Server::OpGetLs(const std::string& id,
     *clock = 0;
   }
 
+  if ((md.operation() == md.LS) && md.ls_limit() &&
+      !eos::common::FileId::IsFileInode(md.md_ino())) {
+    return OpGetLsPage(id, md, vid, response, clock);
+  }
+
   eos::fusex::container cont;
   eos::common::RWMutexReadLock rd_fs_lock(eos::mgm::FsView::gFsView.ViewMutex);
   eos::common::RWMutexReadLock rd_ns_lock(gOFS->eosViewRWMutex);
@@ -1284,6 +1348,189 @@ Server::OpGetLs(const std::string& id,
 
 
 
+//------------------------------------------------------------------------------
+// Serve one page of a paginated LS operation
+//------------------------------------------------------------------------------
+
+int
+Server::OpGetLsPage(const std::string& id,
+                    const eos::fusex::md& md,
+                    eos::common::Mapping::VirtualIdentity& vid,
+                    std::string* response,
+                    uint64_t* clock)
+{
+  gOFS->MgmStats.Add("Eosxd::ext::LS-PAGE", vid.uid, vid.gid, 1);
+  EXEC_TIMING_BEGIN("Eosxd::ext::LS-PAGE");
+  eos_info("ino=%lx cursor=%s limit=%u ls-page", (long) md.md_ino(),
+           md.ls_cursor().c_str(), md.ls_limit());
+  eos::fusex::container cont;
+  cont.set_type(cont.MDMAP);
+  cont.set_ref_inode_(md.md_ino());
+  auto parent = cont.mutable_md_map_()->mutable_md_map_();
+  eos::fusex::md& dir = (*parent)[md.md_ino()];
+  dir.set_md_ino(md.md_ino());
+  dir.set_clientuuid(md.clientuuid());
+  dir.set_clientid(md.clientid());
+  size_t limit = std::min((size_t) md.ls_limit(), Listings::cMaxPageSize);
+  Listings::shared_children children;
+  uint64_t listing_id = 0;
+  size_t offset = 0;
+  int retc = 0;
+  std::shared_ptr<eos::IContainerMD> cmd;
+  {
+    eos::common::RWMutexReadLock rd_fs_lock(eos::mgm::FsView::gFsView.ViewMutex);
+    eos::common::RWMutexReadLock rd_ns_lock(gOFS->eosViewRWMutex);
+
+    // retrieve directory meta data, without the children
+    if ((retc = FillContainerMD(md.md_ino(), dir, vid))) {
+      eos_err("ino=%lx errc=%d", (long) md.md_ino(), retc);
+      return retc;
+    }
+
+    // refresh the cap with the same authid
+    FillContainerCAP(md.md_ino(), dir, vid, md.authid());
+
+    if (clock) {
+      *clock = dir.clock();
+    }
+
+    if (!Listings::ParseCursor(md.ls_cursor(), listing_id, offset) ||
+        !(children = mListings.Get(listing_id, md.md_ino()))) {
+      try {
+        cmd = gOFS->eosDirectoryService->getContainerMD(md.md_ino());
+      } catch (eos::MDException& e) {
+        eos_err("ino=%lx err-no=%d err-msg=%s", (long) md.md_ino(),
+                e.getErrno(), e.getMessage().str().c_str());
+        return e.getErrno();
+      }
+    }
+  }
+
+  if (cmd) {
+    // first page or forgotten cursor: snapshot the names and inodes of the
+    // children, their meta data is filled page by page. The map iterators
+    // hold the shared lock of this container only, so copying a huge
+    // directory does not keep the namespace read lock and only delays the
+    // writers of this directory. Names are encoded after the copy.
+    auto snapshot = std::make_shared<Listings::children_t>();
+
+    try {
+      snapshot->reserve(cmd->getNumFiles() + cmd->getNumContainers());
+
+      for (auto it = eos::FileMapIterator(cmd); it.valid(); it.next()) {
+        snapshot->emplace_back(it.key(),
+                               eos::common::FileId::FidToInode(it.value()));
+      }
+
+      for (auto it = ContainerMapIterator(cmd); it.valid(); it.next()) {
+        snapshot->emplace_back(it.key(), it.value());
+      }
+    } catch (eos::MDException& e) {
+      eos_err("ino=%lx err-no=%d err-msg=%s", (long) md.md_ino(),
+              e.getErrno(), e.getMessage().str().c_str());
+      return e.getErrno();
+    }
+
+    for (auto& child : *snapshot) {
+      child.first = eos::common::StringConversion::EncodeInvalidUTF8(
+                      child.first);
+    }
+
+    children = snapshot;
+    listing_id = mListings.Create(md.md_ino(), snapshot);
+    offset = 0;
+  }
+
+  size_t end = std::min(offset + limit, children->size());
+
+  if (offset > end) {
+    offset = end;
+  }
+
+  // load the meta data of this page only, without any namespace lock
+  eos::Prefetcher prefetcher(gOFS->eosView);
+
+  for (size_t i = offset; i < end; ++i) {
+    uint64_t ino = (*children)[i].second;
+
+    if (eos::common::FileId::IsFileInode(ino)) {
+      prefetcher.stageFileMD(eos::common::FileId::InodeToFid(ino));
+    } else {
+      prefetcher.stageContainerMD(ino);
+    }
+  }
+
+  prefetcher.wait();
+  {
+    eos::common::RWMutexReadLock rd_fs_lock(eos::mgm::FsView::gFsView.ViewMutex);
+    eos::common::RWMutexReadLock rd_ns_lock(gOFS->eosViewRWMutex);
+    size_t n_caps = 0;
+    size_t items_per_lock_cycle = 128;
+
+    for (size_t i = offset; i < end; ++i) {
+      const std::string& name = (*children)[i].first;
+      uint64_t ino = (*children)[i].second;
+      (*parent)[ino].set_md_ino(ino);
+      auto child_md = &((*parent)[ino]);
+
+      if (!((i - offset + 1) % items_per_lock_cycle)) {
+        // after <n> entries release the lock and grab again
+        rd_ns_lock.Release();
+        rd_ns_lock.Grab(gOFS->eosViewRWMutex);
+      }
+
+      if (eos::common::FileId::IsFileInode(ino)) {
+        // this is a file
+        FillFileMD(ino, *child_md, vid);
+      } else {
+        // we don't fill the LS information for the children, just the MD
+        child_md->set_operation(md.GET);
+        child_md->set_clientuuid(md.clientuuid());
+        child_md->set_clientid(md.clientid());
+        FillContainerMD(ino, *child_md, vid);
+
+        // add maximum 16 caps for hidden directories of a listing page
+        if ((n_caps < 16) && (name.substr(0, 1) == ".")) {
+          FillContainerCAP(ino, *child_md, vid, "", true);
+          n_caps++;
+        }
+
+        child_md->clear_operation();
+      }
+    }
+  }
+
+  // the children of this page, the map entries of the parent record might
+  // have moved while the children were added
+  eos::fusex::md& pdir = (*parent)[md.md_ino()];
+
+  for (size_t i = offset; i < end; ++i) {
+    (*pdir.mutable_children())[(*children)[i].first] = (*children)[i].second;
+  }
+
+  // indicate that this MD record contains children information
+  pdir.set_type(pdir.MDLS);
+
+  if (end < children->size()) {
+    pdir.set_ls_cursor(Listings::MakeCursor(listing_id, end));
+  } else {
+    mListings.Drop(listing_id);
+  }
+
+  std::string rspstream;
+  cont.SerializeToString(&rspstream);
+
+  if (!response) {
+    gOFS->zMQ->mTask->reply(id, rspstream);
+  } else {
+    *response += Header(rspstream);
+    response->append(rspstream.c_str(), rspstream.size());
+  }
+
+  EXEC_TIMING_END("Eosxd::ext::LS-PAGE");
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 // Server a meta-data SET operation
 //------------------------------------------------------------------------------/*----------------------------------------------------------------------------*/
@@ -1593,13 +1840,20 @@ Server::OpSetDirectory(const std::string& id,
       Cap().BroadcastMD(md, md_ino, md.md_pino(), clock, pmtime);
       break;
     case MOVE:
-      Cap().BroadcastRelease(mv_md);
     case UPDATE:
-    case RENAME:
-      Cap().BroadcastRelease(md);
-      Cap().BroadcastRefresh(md.md_ino(), md, md.md_pino());
+    case RENAME: {
+      Caps::batch_t batch;
+
+      if (op == MOVE) {
+        Cap().BroadcastRelease(mv_md, &batch);
+      }
+
+      Cap().BroadcastRelease(md, &batch);
+      Cap().BroadcastRefresh(md.md_ino(), md, md.md_pino(), &batch);
+      Client().SendBatch(batch);
       break;
     }
+    }
   } catch (eos::MDException& e) {
     eos_err("ino=%lx err-no=%d err-msg=%s", (long) md.md_ino(),
             e.getErrno(), e.getMessage().str().c_str());
@@ -1647,7 +1901,10 @@ Server::OpSetFile(const std::string& id,
   eos_info("ino=%lx pin=%lx authid=%s file", (long) md.md_ino(),
            (long) md.md_pino(),
            md.authid().c_str());
-  eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+  // Only the touched containers and files are locked exclusively
+  eos::MDMutationLock lock(gOFS->eosViewRWMutex, gOFS->eosMdLocks,
+                           gOFS->NsInQDB);
+  eos::MDLocker& md_lock = lock.locker();
   std::shared_ptr<eos::IFileMD> fmd;
   std::shared_ptr<eos::IFileMD> ofmd;
   std::shared_ptr<eos::IContainerMD> pcmd;
@@ -1669,6 +1926,7 @@ Server::OpSetFile(const std::string& id,
       op = UPDATE;
       // dir update
       fmd = gOFS->eosFileService->getFileMD(fid);
+      LockFileUpdate(md_lock, pcmd, fmd, md.name());
 
       if (EOS_LOGS_DEBUG) eos_debug("updating %s => %s ",
                                     fmd->getName().c_str(),
@@ -1751,6 +2009,9 @@ Server::OpSetFile(const std::string& id,
     } else if (strncmp(md.target().c_str(), "////hlnk",
                        8) == 0) { /* creation of a hard link */
       uint64_t tgt_md_ino = atoll(md.target().c_str() + 8);
+      md_lock.addContainer(pcmd->getId());
+      md_lock.addFile(eos::common::FileId::InodeToFid(tgt_md_ino));
+      md_lock.lock();
 
       if (pcmd->findContainer(
                               md.name())) {
@@ -1792,6 +2053,7 @@ Server::OpSetFile(const std::string& id,
       resp.mutable_ack_()->set_transactionid(md.reqid());
       resp.mutable_ack_()->set_md_ino(eos::common::FileId::FidToInode(gmd->getId()));
       // release the namespace lock before serialization/broadcasting
+      md_lock.unlock();
       lock.Release();
       resp.SerializeToString(response);
       struct timespec pt_mtime;
@@ -1812,6 +2074,9 @@ Server::OpSetFile(const std::string& id,
         return EPERM;
       }
 
+      md_lock.addContainer(pcmd->getId());
+      md_lock.lock();
+
       if (pcmd->findContainer(
                               md.name())) {
         return EEXIST;
@@ -1921,6 +2186,7 @@ Server::OpSetFile(const std::string& id,
                                           &clock);
     eos_info("ino=%llx clock=%llx", md_ino, clock);
     // release the namespace lock before serialization/broadcasting
+    md_lock.unlock();
     lock.Release();
     eos::fusex::response resp;
     resp.set_type(resp.ACK);
@@ -2212,9 +2478,11 @@ Server::OpDeleteDirectory(const std::string& id,
       resp.mutable_ack_()->set_code(resp.ack_().OK);
       resp.mutable_ack_()->set_transactionid(md.reqid());
       resp.SerializeToString(response);
-      Cap().BroadcastRelease(md);
-      Cap().BroadcastDeletion(pcmd->getId(), md, cmd->getName());
-      Cap().BroadcastRefresh(pcmd->getId(), md, pcmd->getParentId());
+      Caps::batch_t batch;
+      Cap().BroadcastRelease(md, &batch);
+      Cap().BroadcastDeletion(pcmd->getId(), md, cmd->getName(), &batch);
+      Cap().BroadcastRefresh(pcmd->getId(), md, pcmd->getParentId(), &batch);
+      Client().SendBatch(batch);
       Cap().Delete(md.md_ino());
     }
   } catch (eos::MDException& e) {
@@ -2266,11 +2534,15 @@ Server::OpDeleteFile(const std::string& id,
   std::shared_ptr<eos::IContainerMD> cmd;
   std::shared_ptr<eos::IContainerMD> pcmd;
   std::shared_ptr<eos::IFileMD> fmd;
+  std::shared_ptr<eos::IFileMD> gmd;
   eos::IFileMD::ctime_t mtime;
   mtime.tv_sec = md.mtime();
   mtime.tv_nsec = md.mtime_ns();
 
-  eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+  // Only the parent container and the file(s) are locked exclusively
+  eos::MDMutationLock lock(gOFS->eosViewRWMutex, gOFS->eosMdLocks,
+                           gOFS->NsInQDB);
+  eos::MDLocker& md_lock = lock.locker();
 
   try {
     pcmd = gOFS->eosDirectoryService->getContainerMD(md.md_pino());
@@ -2280,8 +2552,16 @@ Server::OpDeleteFile(const std::string& id,
     } else {
       fmd = gOFS->eosFileService->getFileMD(eos::common::FileId::InodeToFid(
                                                                             md.md_ino()));
+
+      if (fmd->hasAttribute(k_mdino)) {
+        // the file holding the inode of a hard link is updated as well
+        gmd = gOFS->eosFileService->getFileMD(eos::common::FileId::InodeToFid(
+                                                std::stoll(fmd->getAttribute(k_mdino))));
+      }
     }
 
+    LockEntryDelete(md_lock, pcmd, cmd, fmd, gmd);
+
     pcmd->setMTime(mtime);
 
     eos_info("ino=%lx delete-file", (long) md.md_ino());
@@ -2295,11 +2575,11 @@ Server::OpDeleteFile(const std::string& id,
       // this is vulnerable to a hard to trigger race conditions
       std::string fullpath = gOFS->eosView->getUri(fmd.get());
       gOFS->WriteRecycleRecord(fmd);
-      gOFS->eosViewRWMutex.UnLockWrite();
+      lock.Release();
       XrdOucErrInfo error;
       (void) gOFS->_rem(fullpath.c_str(), error, vid, "", false, false,
                         false, true);
-      gOFS->eosViewRWMutex.LockWrite();
+      lock.Grab();
     } else {
       try {
         // handle quota
@@ -2316,12 +2596,8 @@ Server::OpDeleteFile(const std::string& id,
 
       if (fmd->hasAttribute(k_mdino)) {
         /* this is a hard link, update reference count on underlying file */
+        /* gmd = the file holding the inode, locked together with fmd */
         tgt_md_ino = std::stoll(fmd->getAttribute(k_mdino));
-        uint64_t clock;
-        /* gmd = the file holding the inode */
-        std::shared_ptr<eos::IFileMD> gmd =
-                gOFS->eosFileService->getFileMD(
-                                                eos::common::FileId::InodeToFid(tgt_md_ino), &clock);
 
         long nlink = std::stol(gmd->getAttribute(k_nlink)) - 1;
 
@@ -2333,7 +2609,16 @@ Server::OpDeleteFile(const std::string& id,
         } else { // remove target file as well
           eos_info("hlnk unlink target %s for %s nlink %ld",
                    gmd->getName().c_str(), fmd->getName().c_str(), nlink);
-          pcmd->removeFile(gmd->getName());
+          if (gmd->getContainerId() == pcmd->getId()) {
+            pcmd->removeFile(gmd->getName());
+          } else if (gmd->getContainerId()) {
+            // the inode holder was moved away, its container is locked too
+            std::shared_ptr<eos::IContainerMD> gcmd =
+              gOFS->eosDirectoryService->getContainerMD(gmd->getContainerId());
+            gcmd->removeFile(gmd->getName());
+            gOFS->eosDirectoryService->updateStore(gcmd.get());
+          }
+
           gmd->setContainerId(0);
           gmd->unlinkAllLocations();
           gOFS->eosFileService->updateStore(gmd.get());
@@ -2373,13 +2658,16 @@ Server::OpDeleteFile(const std::string& id,
     }
 
     // release the namespace lock before serialization/broadcasting
+    md_lock.unlock();
     lock.Release();
     resp.mutable_ack_()->set_code(resp.ack_().OK);
     resp.mutable_ack_()->set_transactionid(md.reqid());
     resp.SerializeToString(response);
-    Cap().BroadcastRelease(md);
-    Cap().BroadcastDeletion(pcmd->getId(), md, md.name());
-    Cap().BroadcastRefresh(pcmd->getId(), md, pcmd->getParentId());
+    Caps::batch_t batch;
+    Cap().BroadcastRelease(md, &batch);
+    Cap().BroadcastDeletion(pcmd->getId(), md, md.name(), &batch);
+    Cap().BroadcastRefresh(pcmd->getId(), md, pcmd->getParentId(), &batch);
+    Client().SendBatch(batch);
     Cap().Delete(md.md_ino());
   } catch (eos::MDException& e) {
 
@@ -2433,7 +2721,10 @@ Server::OpDeleteLink(const std::string& id,
   mtime.tv_sec = md.mtime();
   mtime.tv_nsec = md.mtime_ns();
 
-  eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+  // Only the parent container and the file(s) are locked exclusively
+  eos::MDMutationLock lock(gOFS->eosViewRWMutex, gOFS->eosMdLocks,
+                           gOFS->NsInQDB);
+  eos::MDLocker& md_lock = lock.locker();
 
   try {
     pcmd = gOFS->eosDirectoryService->getContainerMD(md.md_pino());
@@ -2445,6 +2736,8 @@ Server::OpDeleteLink(const std::string& id,
                                                                             md.md_ino()));
     }
 
+    LockEntryDelete(md_lock, pcmd, cmd, fmd, nullptr);
+
     pcmd->setMTime(mtime);
 
     eos_info("ino=%lx delete-link", (long) md.md_ino());
@@ -2459,9 +2752,11 @@ Server::OpDeleteLink(const std::string& id,
     resp.mutable_ack_()->set_code(resp.ack_().OK);
     resp.mutable_ack_()->set_transactionid(md.reqid());
     resp.SerializeToString(response);
-    Cap().BroadcastRelease(md);
-    Cap().BroadcastDeletion(pcmd->getId(), md, md.name());
-    Cap().BroadcastRefresh(pcmd->getId(), md, pcmd->getParentId());
+    Caps::batch_t batch;
+    Cap().BroadcastRelease(md, &batch);
+    Cap().BroadcastDeletion(pcmd->getId(), md, md.name(), &batch);
+    Cap().BroadcastRefresh(pcmd->getId(), md, pcmd->getParentId(), &batch);
+    Client().SendBatch(batch);
     Cap().Delete(md.md_ino());
   } catch (eos::MDException& e) {
 
@@ -34,6 +34,7 @@
 #include "mgm/FuseServer/Caps.hh"
 #include "mgm/FuseServer/Clients.hh"
 #include "mgm/FuseServer/Flush.hh"
+#include "mgm/FuseServer/Listings.hh"
 #include "mgm/FuseServer/Locks.hh"
 
 #include "namespace/interface/IFileMD.hh"
@@ -76,6 +77,11 @@ public:
     return mFlushs;
   }
 
+  Listings& Listing()
+  {
+    return mListings;
+  }
+
   void Print(std::string& out, std::string options = "");
 
   int FillContainerMD(uint64_t id, eos::fusex::md& dir,
@@ -117,6 +123,12 @@ public:
               std::string* response = 0,
               uint64_t* clock = 0);
 
+  int OpGetLsPage(const std::string& identity,
+                  const eos::fusex::md& md,
+                  eos::common::Mapping::VirtualIdentity& vid,
+                  std::string* response = 0,
+                  uint64_t* clock = 0);
+
   int OpSet(const std::string& identity,
             const eos::fusex::md& md,
             eos::common::Mapping::VirtualIdentity& vid,
@@ -215,6 +227,7 @@ protected:
   Caps mCaps;
   Lock mLocks;
   Flush mFlushs;
+  Listings mListings;
 
 private:
   std::atomic<bool> terminate_;
@@ -1011,7 +1011,6 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 {
   assert(nNewReplicas);
   assert(newReplicas);
-  std::vector<SchedTME*> entries;
   // find the entry in the map
   tlCurrentGroup = group;
   SchedTME* entry;
@@ -1026,8 +1025,11 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
     entry = pGroup2SchedTME[group];
     AtomicInc(entry->fastStructLockWaitersCount);
   }
-  // readlock the original fast structure
-  entry->doubleBufferMutex.LockRead();
+  // protect the current fast structures, they are not modified by the updater
+  // as long as the guard holds them
+  eos::common::HazardPointer fgGuard;
+  FastStructSched* fg = entry->acquireForegroundFastStruct(fgGuard);
+  std::vector<FastStructSched*> entries;
   // locate the existing replicas and the excluded fs in the tree
   vector<SchedTreeBase::tFastTreeIdx> newReplicasIdx(nNewReplicas),
          *existingReplicasIdx = NULL, *excludeFsIdx = NULL, *forceBrIdx = NULL;
@@ -1044,7 +1046,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
       const SchedTreeBase::tFastTreeIdx* idx =
         static_cast<const SchedTreeBase::tFastTreeIdx*>(0);
 
-      if (!entry->foregroundFastStruct->fs2TreeIdx->get(*it, idx) &&
+      if (!fg->fs2TreeIdx->get(*it, idx) &&
           !(*fsidsgeotags)[count].empty()) {
         // the fs is not in that group.
         // this could happen because the former file scheduler
@@ -1052,11 +1054,11 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
         // with the new geoscheduler, it should not happen
         // in that case, we try to match a filesystem having the same geotag
         SchedTreeBase::tFastTreeIdx idx =
-          entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode((
+          fg->tag2NodeIdx->getClosestFastTreeNode((
                 *fsidsgeotags)[count].c_str());
 
         if (idx &&
-            (*entry->foregroundFastStruct->treeInfo)[idx].nodeType ==
+            (*fg->treeInfo)[idx].nodeType ==
             SchedTreeBase::TreeNodeInfo::fs) {
           if ((std::find(existingReplicasIdx->begin(), existingReplicasIdx->end(),
                          idx) == existingReplicasIdx->end())) {
@@ -1085,7 +1087,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
     for (auto it = excludeFs->begin(); it != excludeFs->end(); ++it) {
       const SchedTreeBase::tFastTreeIdx* idx;
 
-      if (!entry->foregroundFastStruct->fs2TreeIdx->get(*it, idx)) {
+      if (!fg->fs2TreeIdx->get(*it, idx)) {
         // the excluded fs might belong to another group
         // so it's not an error condition
         // eos_warning("could not place excluded fs on the fast tree");
@@ -1104,7 +1106,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 
     for (auto it = excludeGeoTags->begin(); it != excludeGeoTags->end(); ++it) {
       SchedTreeBase::tFastTreeIdx idx;
-      idx = entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+      idx = fg->tag2NodeIdx->getClosestFastTreeNode(
               it->c_str());
       excludeFsIdx->push_back(idx);
     }
@@ -1115,7 +1117,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 
     for (auto it = forceGeoTags->begin(); it != forceGeoTags->end(); ++it) {
       SchedTreeBase::tFastTreeIdx idx;
-      idx = entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+      idx = fg->tag2NodeIdx->getClosestFastTreeNode(
               it->c_str());
       forceBrIdx->push_back(idx);
     }
@@ -1125,11 +1127,11 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 
   if (!startFromGeoTag.empty()) {
     startFromNode =
-      entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+      fg->tag2NodeIdx->getClosestFastTreeNode(
         startFromGeoTag.c_str());
   } else if (!clientGeoTag.empty()) {
     startFromNode =
-      entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+      fg->tag2NodeIdx->getClosestFastTreeNode(
         clientGeoTag.c_str());
   }
 
@@ -1140,7 +1142,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
   case regularRO:
   case regularRW:
     success = placeNewReplicas(entry, nNewReplicas, &newReplicasIdx,
-                               entry->foregroundFastStruct->placementTree,
+                               fg->placementTree,
                                existingReplicasIdx, bookingSize, startFromNode,
                                nCollocatedReplicas, excludeFsIdx, forceBrIdx,
                                pSkipSaturatedPlct);
@@ -1148,7 +1150,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 
   case draining:
     success = placeNewReplicas(entry, nNewReplicas, &newReplicasIdx,
-                               entry->foregroundFastStruct->drnPlacementTree,
+                               fg->drnPlacementTree,
                                existingReplicasIdx, bookingSize, startFromNode,
                                nCollocatedReplicas, excludeFsIdx, forceBrIdx,
                                pSkipSaturatedDrnPlct);
@@ -1156,7 +1158,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 
   case balancing:
     success = placeNewReplicas(entry, nNewReplicas, &newReplicasIdx,
-                               entry->foregroundFastStruct->blcPlacementTree,
+                               fg->blcPlacementTree,
                                existingReplicasIdx, bookingSize, startFromNode,
                                nCollocatedReplicas, excludeFsIdx, forceBrIdx,
                                pSkipSaturatedBlcPlct);
@@ -1176,9 +1178,9 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 
   for (auto it = newReplicasIdx.begin(); it != newReplicasIdx.end(); ++it) {
     const SchedTreeBase::tFastTreeIdx* idx = NULL;
-    const unsigned int fsid = (*entry->foregroundFastStruct->treeInfo)[*it].fsId;
+    const unsigned int fsid = (*fg->treeInfo)[*it].fsId;
 
-    if (!entry->foregroundFastStruct->fs2TreeIdx->get(fsid, idx)) {
+    if (!fg->fs2TreeIdx->get(fsid, idx)) {
       eos_crit("inconsistency : cannot retrieve index of selected fs though "
                "it should be in the tree");
       success = false;
@@ -1186,25 +1188,25 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
     }
 
     const char netSpeedClass =
-      (*entry->foregroundFastStruct->treeInfo)[*idx].netSpeedClass;
+      (*fg->treeInfo)[*idx].netSpeedClass;
     newReplicas->push_back(fsid);
 
     // Apply the penalties
-    if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.dlScore >
+    if (fg->placementTree->pNodes[*idx].fsData.dlScore >
         0) {
-      applyDlScorePenalty(entry, *idx,
+      applyDlScorePenalty(fg, *idx,
                           pPenaltySched.pPlctDlScorePenalty[netSpeedClass]);
     }
 
-    if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.ulScore >
+    if (fg->placementTree->pNodes[*idx].fsData.ulScore >
         0) {
-      applyUlScorePenalty(entry, *idx,
+      applyUlScorePenalty(fg, *idx,
                           pPenaltySched.pPlctUlScorePenalty[netSpeedClass]);
     }
   }
 
   if (dataProxys || firewallEntryPoint) {
-    entries.assign(newReplicasIdx.size(), entry);
+    entries.assign(newReplicasIdx.size(), fg);
   }
 
   // find proxy for filesticky scheduling
@@ -1225,10 +1227,10 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
       for (size_t i = 0; i < newReplicasIdx.size(); i++) {
         if (clientGeoTag.empty() ||
             accessReqFwEP((
-                            *entries[i]->foregroundFastStruct->treeInfo)[newReplicasIdx[i]].fullGeotag ,
+                            *entries[i]->treeInfo)[newReplicasIdx[i]].fullGeotag ,
                           clientGeoTag)) {
           firewallProxyGroups[i] = accessGetProxygroup((
-                                     *entries[i]->foregroundFastStruct->treeInfo)[newReplicasIdx[i]].fullGeotag);
+                                     *entries[i]->treeInfo)[newReplicasIdx[i]].fullGeotag);
         }
       }
 
@@ -1267,7 +1269,7 @@ cleanup:
     newReplicas->clear();
   }
 
-  entry->doubleBufferMutex.UnLockRead();
+  fgGuard.Reset();
   AtomicDec(entry->fastStructLockWaitersCount);
 
   if (existingReplicasIdx) {
@@ -1302,7 +1304,7 @@ struct TreeInfoFsIdComparator {
 
 bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
                               fsIdxs,
-                              std::vector<SchedTME*> entries,
+                              const std::vector<FastStructSched*>& entries,
                               ino64_t inode,
                               std::vector<std::string>* dataProxys,
                               std::vector<std::string>* proxyGroups,
@@ -1319,7 +1321,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
   for (size_t i = 0; i < fsIdxs.size(); i++) {
     const std::string* geotag = NULL;
     // get the proxygroup
-    // WARNING: entries[i]->doubleBufferMutex should be locked by the caller of findProxy
+    // WARNING: entries[i] should be protected by the caller of findProxy
 
     if (!(*dataProxys)[i].empty() && (*dataProxys)[i] != "<none>") {
       if (pPxyHost2DpTMEs.count((*dataProxys)[i])) {
@@ -1343,22 +1345,14 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
 
         {
           auto entry = (*TMEs.begin());
-
-          // we don't want to lock the pxyentry which is already locked
-          if (entry != pxyentry) {
-            AtomicInc(entry->fastStructLockWaitersCount);
-            entry->doubleBufferMutex.LockRead();
-          }
-
+          AtomicInc(entry->fastStructLockWaitersCount);
+          entry->doubleBufferMutex.LockRead();
           // if they don't, take their geotag as a staring point
           sgeotag =
             (*TMEs.begin())->host2SlowTreeNode[(*dataProxys)[i]]->pNodeInfo.fullGeotag;
           geotag = &sgeotag;
-
-          if (entry != pxyentry) {
-            entry->doubleBufferMutex.UnLockRead();
-            AtomicDec(entry->fastStructLockWaitersCount);
-          }
+          entry->doubleBufferMutex.UnLockRead();
+          AtomicDec(entry->fastStructLockWaitersCount);
         }
       }
     }
@@ -1367,7 +1361,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
       fsproxygroup = &((*proxyGroups)[i]);
     } else {
       fsproxygroup = &
-                     (*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].proxygroup;
+                     (*entries[i]->treeInfo)[fsIdxs[i]].proxygroup;
     }
 
     if (fsproxygroup->empty() ||
@@ -1383,7 +1377,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
 
     if (!geotag) {
       geotag = (clientgeotag.empty() ? &
-                ((*(entries[i]->foregroundFastStruct->treeInfo))[fsIdxs[i]].fullGeotag) :
+                ((*(entries[i]->treeInfo))[fsIdxs[i]].fullGeotag) :
                 &clientgeotag);
     }
 
@@ -1401,15 +1395,16 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
 
     pxyentry = pPxyGrp2DpTME[*fsproxygroup];
     AtomicInc(pxyentry->fastStructLockWaitersCount);
-    // readlock the original fast structure
-    pxyentry->doubleBufferMutex.LockRead();
+    // protect the original fast structure
+    eos::common::HazardPointer pxyGuard;
+    FastStructProxy* pxyfg = pxyentry->acquireForegroundFastStruct(pxyGuard);
 
     // copy the fasttree
-    if (pxyentry->foregroundFastStruct->proxyAccessTree->copyToBuffer((
+    if (pxyfg->proxyAccessTree->copyToBuffer((
           char*)tlGeoBuffer, gGeoBufferSize)) {
       eos_crit("could not make a working copy of the fast tree for proxygroup %s",
                fsproxygroup->c_str());
-      pxyentry->doubleBufferMutex.UnLockRead();
+      pxyGuard.Reset();
       AtomicDec(pxyentry->fastStructLockWaitersCount);
       return false;
     }
@@ -1417,7 +1412,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
     tree = (FastGatewayAccessTree*)tlGeoBuffer;
     // get the closest node from the filesystem
     SchedTreeBase::tFastTreeIdx idx;
-    idx = pxyentry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+    idx = pxyfg->tag2NodeIdx->getClosestFastTreeNode(
             trimlastlevel ? std::string(*geotag, 0,
                                         geotag->rfind("::")).c_str() : geotag->c_str());
     bool schedsuccess = false;
@@ -1427,7 +1422,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
       // scheduling should consistently go through the same (firewallentrypoint,proxy)
       // this is to do the caching of the file only on one proxy
       // serving a same file from two proxies is not optimal but it is not mendatory neither
-      if ((*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
+      if ((*entries[i]->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
           < 0) {
         schedsuccess = true;
       }
@@ -1435,9 +1430,9 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
       else {
         // then consider all the possible proxy in the same proxygroup
         // within the subtree starting at the best proxy and going uproot by
-        // (*pxyentry->foregroundFastStruct->treeInfo)[idx].fileStickyProxyDepth
+        // (*pxyfg->treeInfo)[idx].fileStickyProxyDepth
         // allocate a vectors to get the proxies
-        auto s = pxyentry->foregroundFastStruct->treeInfo->size();
+        auto s = pxyfg->treeInfo->size();
         std::vector<SchedTreeBase::tFastTreeIdx> proxiesIdxs(s), upRootLevels(s),
             upRootLevelsIdxs(s);
         SchedTreeBase::tFastTreeIdx upRootLevelsCount = 0;
@@ -1455,8 +1450,8 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
               ss << " all proxys are:";
 
               for (auto it = proxiesIdxs.begin(); it != proxiesIdxs.end(); it++) {
-                ss << (*pxyentry->foregroundFastStruct->treeInfo)[*it].hostport;
-                ss << "(" << (*pxyentry->foregroundFastStruct->treeInfo)[*it].fullGeotag << ")";
+                ss << (*pxyfg->treeInfo)[*it].hostport;
+                ss << "(" << (*pxyfg->treeInfo)[*it].fullGeotag << ")";
 
                 if (it != proxiesIdxs.end() - 1) {
                   ss << ",";
@@ -1493,7 +1488,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
             while (
               uprlev < upRootLevelsCount &&
               upRootLevels[uprlev] <=
-              (*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
+              (*entries[i]->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
             ) {
               uprlev++;
             }
@@ -1511,24 +1506,24 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
               }
 
               // sort the proxies by fsid
-              TreeInfoFsIdComparator cmp(pxyentry->foregroundFastStruct->treeInfo);
+              TreeInfoFsIdComparator cmp(pxyfg->treeInfo);
               std::sort(proxiesIdxs.begin(), proxiesIdxs.end(), cmp);
               // take the proxy
               idx = proxiesIdxs[inode % proxiesIdxs.size()];
               // if it succeeds, feel the corresponding element of the return vector
-              (*dataProxys)[i] = (*pxyentry->foregroundFastStruct->treeInfo)[idx].hostport;
+              (*dataProxys)[i] = (*pxyfg->treeInfo)[idx].hostport;
 
               if (g_logging.gLogMask & LOG_MASK(LOG_DEBUG)) {
                 stringstream ss;
                 ss << "file sticky proxy scheduling fs:" <<
-                   (*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fsId;
+                   (*entries[i]->treeInfo)[fsIdxs[i]].fsId;
                 ss << " | fileStickyProxyDepth:" << (int)(
-                     *entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fileStickyProxyDepth;
+                     *entries[i]->treeInfo)[fsIdxs[i]].fileStickyProxyDepth;
                 ss << " | possible proxys are:";
 
                 for (auto it = proxiesIdxs.begin(); it != proxiesIdxs.end(); it++) {
-                  ss << (*pxyentry->foregroundFastStruct->treeInfo)[*it].hostport;
-                  ss << "(" << (*pxyentry->foregroundFastStruct->treeInfo)[*it].fullGeotag << ")";
+                  ss << (*pxyfg->treeInfo)[*it].hostport;
+                  ss << "(" << (*pxyfg->treeInfo)[*it].fullGeotag << ")";
 
                   if (it != proxiesIdxs.end() - 1) {
                     ss << ",";
@@ -1537,7 +1532,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
 
                 ss << " | inode:" << inode;
                 ss << " | selected host is:" <<
-                   (*pxyentry->foregroundFastStruct->treeInfo)[idx].hostport;
+                   (*pxyfg->treeInfo)[idx].hostport;
                 eos_debug("%s", ss.str().c_str());
               }
             }
@@ -1546,18 +1541,18 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
       }
     } else {
       if (proxyschedtype == any
-          || ((*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
+          || ((*entries[i]->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
               < 0 && proxyschedtype == regular)) {
         // get the proxy
         if (!(schedsuccess = tree->findFreeSlot(idx, idx,
                                                 true /*allow uproot if necessary*/, false, true /*skipSaturated*/))) {
-          (*dataProxys)[i] = (*pxyentry->foregroundFastStruct->treeInfo)[idx].hostport;
+          (*dataProxys)[i] = (*pxyfg->treeInfo)[idx].hostport;
         } else {
           if ((schedsuccess = tree->findFreeSlot(idx, idx,
                                                  true /*allow uproot if necessary*/, false, false /*skipSaturated*/)))
             // if it succeeds, feel the corresponding element of the return vector
           {
-            (*dataProxys)[i] = (*pxyentry->foregroundFastStruct->treeInfo)[idx].hostport;
+            (*dataProxys)[i] = (*pxyfg->treeInfo)[idx].hostport;
           }
         }
       } else {
@@ -1571,13 +1566,13 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
       std::stringstream ss;
       ss << "tree is as follow\n" << (*tree);
       eos_err(ss.str().c_str());
-      pxyentry->doubleBufferMutex.UnLockRead();
+      pxyGuard.Reset();
       AtomicDec(pxyentry->fastStructLockWaitersCount);
       return false;
     }
 
     // unlock it for each new fs
-    pxyentry->doubleBufferMutex.UnLockRead();
+    pxyGuard.Reset();
     AtomicDec(pxyentry->fastStructLockWaitersCount);
   }
 
@@ -1626,8 +1621,10 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
     entry = pGroup2SchedTME[group];
     AtomicInc(entry->fastStructLockWaitersCount);
   }
-  // readlock the original fast structure
-  entry->doubleBufferMutex.LockRead();
+  // protect the current fast structures, they are not modified by the updater
+  // as long as the guard holds them
+  eos::common::HazardPointer fgGuard;
+  FastStructSched* fg = entry->acquireForegroundFastStruct(fgGuard);
   // locate the existing replicas and the excluded fs in the tree
   vector<SchedTreeBase::tFastTreeIdx> accessedReplicasIdx(nAccessReplicas),
          *existingReplicasIdx = NULL, *excludeFsIdx = NULL, *forceBrIdx = NULL;
@@ -1639,7 +1636,7 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
   for (auto it = existingReplicas->begin(); it != existingReplicas->end(); ++it) {
     const SchedTreeBase::tFastTreeIdx* idx;
 
-    if (!entry->foregroundFastStruct->fs2TreeIdx->get(*it, idx)) {
+    if (!fg->fs2TreeIdx->get(*it, idx)) {
       eos_warning("could not place preexisting replica on the fast tree");
       continue;
     }
@@ -1654,7 +1651,7 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
     for (auto it = excludeFs->begin(); it != excludeFs->end(); ++it) {
       const SchedTreeBase::tFastTreeIdx* idx;
 
-      if (!entry->foregroundFastStruct->fs2TreeIdx->get(*it, idx)) {
+      if (!fg->fs2TreeIdx->get(*it, idx)) {
         eos_warning("could not place excluded fs on the fast tree");
         continue;
       }
@@ -1671,7 +1668,7 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
 
     for (auto it = excludeGeoTags->begin(); it != excludeGeoTags->end(); ++it) {
       SchedTreeBase::tFastTreeIdx idx;
-      idx = entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+      idx = fg->tag2NodeIdx->getClosestFastTreeNode(
               it->c_str());
       excludeFsIdx->push_back(idx);
     }
@@ -1682,7 +1679,7 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
 
     for (auto it = forceGeoTags->begin(); it != forceGeoTags->end(); ++it) {
       SchedTreeBase::tFastTreeIdx idx;
-      idx = entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+      idx = fg->tag2NodeIdx->getClosestFastTreeNode(
               it->c_str());
       forceBrIdx->push_back(idx);
     }
@@ -1690,7 +1687,7 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
 
   // find the closest tree node to the accesser
   SchedTreeBase::tFastTreeIdx accesserNode =
-    entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+    fg->tag2NodeIdx->getClosestFastTreeNode(
       accesserGeotag.c_str());;
   // actually do the job
   unsigned char success = 0;
@@ -1699,28 +1696,28 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
   case regularRO:
     success = accessReplicas(entry, nAccessReplicas, &accessedReplicasIdx,
                              accesserNode, existingReplicasIdx,
-                             entry->foregroundFastStruct->rOAccessTree, excludeFsIdx,
+                             fg->rOAccessTree, excludeFsIdx,
                              forceBrIdx, pSkipSaturatedAccess);
     break;
 
   case regularRW:
     success = accessReplicas(entry, nAccessReplicas, &accessedReplicasIdx,
                              accesserNode, existingReplicasIdx,
-                             entry->foregroundFastStruct->rWAccessTree, excludeFsIdx,
+                             fg->rWAccessTree, excludeFsIdx,
                              forceBrIdx, pSkipSaturatedAccess);
     break;
 
   case draining:
     success = accessReplicas(entry, nAccessReplicas, &accessedReplicasIdx,
                              accesserNode, existingReplicasIdx,
-                             entry->foregroundFastStruct->drnAccessTree, excludeFsIdx,
+                             fg->drnAccessTree, excludeFsIdx,
                              forceBrIdx, pSkipSaturatedDrnAccess);
     break;
 
   case balancing:
     success = accessReplicas(entry, nAccessReplicas, &accessedReplicasIdx,
                              accesserNode, existingReplicasIdx,
-                             entry->foregroundFastStruct->blcAccessTree, excludeFsIdx, forceBrIdx,
+                             fg->blcAccessTree, excludeFsIdx, forceBrIdx,
                              pSkipSaturatedBlcAccess);
     break;
 
@@ -1739,9 +1736,9 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
   for (auto it = accessedReplicasIdx.begin(); it != accessedReplicasIdx.end();
        ++it) {
     const SchedTreeBase::tFastTreeIdx* idx = NULL;
-    const unsigned int fsid = (*entry->foregroundFastStruct->treeInfo)[*it].fsId;
+    const unsigned int fsid = (*fg->treeInfo)[*it].fsId;
 
-    if (!entry->foregroundFastStruct->fs2TreeIdx->get(fsid, idx)) {
+    if (!fg->fs2TreeIdx->get(fsid, idx)) {
       eos_crit("inconsistency : cannot retrieve index of selected fs though it "
                "should be in the tree");
       success = false;
@@ -1749,26 +1746,26 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
     }
 
     const char netSpeedClass =
-      (*entry->foregroundFastStruct->treeInfo)[*idx].netSpeedClass;
+      (*fg->treeInfo)[*idx].netSpeedClass;
     accessedReplicas->push_back(fsid);
 
     // apply the penalties
-    if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.dlScore >=
+    if (fg->placementTree->pNodes[*idx].fsData.dlScore >=
         pPenaltySched.pAccessDlScorePenalty[netSpeedClass]) {
-      applyDlScorePenalty(entry, *idx,
+      applyDlScorePenalty(fg, *idx,
                           pPenaltySched.pAccessDlScorePenalty[netSpeedClass]);
     }
 
-    if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.ulScore >=
+    if (fg->placementTree->pNodes[*idx].fsData.ulScore >=
         pPenaltySched.pAccessUlScorePenalty[netSpeedClass]) {
-      applyUlScorePenalty(entry, *idx,
+      applyUlScorePenalty(fg, *idx,
                           pPenaltySched.pAccessUlScorePenalty[netSpeedClass]);
     }
   }
 
   // unlock, cleanup
 cleanup:
-  entry->doubleBufferMutex.UnLockRead();
+  fgGuard.Reset();
   AtomicDec(entry->fastStructLockWaitersCount);
   delete existingReplicasIdx;
 
@@ -1823,8 +1820,12 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
   std::vector<eos::common::FileSystem::fsid_t>::iterator it;
   std::vector<SchedTreeBase::tFastTreeIdx> ERIdx;
   ERIdx.reserve(existingReplicas->size());
-  std::vector<SchedTME*> entries;
+  std::vector<FastStructSched*> entries;
   entries.reserve(existingReplicas->size());
+  // Maps tree maps entries to their protected fast structures
+  map<SchedTME*, FastStructSched*> entry2Fg;
+  std::vector<eos::common::HazardPointer> fgGuards;
+  fgGuards.reserve(existingReplicas->size());
   // Maps tree maps entries (i.e. scheduling groups) to fs ids containing an
   // available replica and the corresponding fastTreeIndex
   map<SchedTME*, vector< pair<FileSystem::fsid_t, SchedTreeBase::tFastTreeIdx> > >
@@ -1846,31 +1847,31 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
       }
 
       entry = mentry->second;
+      FastStructSched* fg;
+      auto fgIt = entry2Fg.find(entry);
 
-      // lock the double buffering to make sure all the fast trees are not modified
-      if (!entry2FsId.count(entry)) {
-        // if the entry is already there, it was locked already
-        entry->doubleBufferMutex.LockRead();
+      // protect the fast structures to make sure they are not modified
+      if (fgIt == entry2Fg.end()) {
         // to prevent the destruction of the entry
         AtomicInc(entry->fastStructLockWaitersCount);
+        fgGuards.emplace_back();
+        fg = entry->acquireForegroundFastStruct(fgGuards.back());
+        entry2Fg[entry] = fg;
+      } else {
+        // if the entry is already there, it was protected already
+        fg = fgIt->second;
       }
 
       const SchedTreeBase::tFastTreeIdx* idx;
 
-      if (!entry->foregroundFastStruct->fs2TreeIdx->get(*exrepIt, idx)) {
+      if (!fg->fs2TreeIdx->get(*exrepIt, idx)) {
         eos_warning("cannot find fs in the scheduling group in the 2nd pass");
-
-        if (!entry2FsId.count(entry)) {
-          entry->doubleBufferMutex.UnLockRead();
-          AtomicDec(entry->fastStructLockWaitersCount);
-        }
-
         continue;
       }
 
       // take the fastindex of each existing replica
       ERIdx.push_back(*idx);
-      entries.push_back(entry);
+      entries.push_back(fg);
       // check if the fs is available
       bool isValid = false;
 
@@ -1878,23 +1879,23 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
                     *exrepIt) == unavailableFs->end()) {
         switch (type) {
         case regularRO:
-          isValid = entry->foregroundFastStruct->rOAccessTree->pBranchComp.isValidSlot(
-                      &entry->foregroundFastStruct->rOAccessTree->pNodes[*idx].fsData, &freeSlot);
+          isValid = fg->rOAccessTree->pBranchComp.isValidSlot(
+                      &fg->rOAccessTree->pNodes[*idx].fsData, &freeSlot);
           break;
 
         case regularRW:
-          isValid = entry->foregroundFastStruct->rWAccessTree->pBranchComp.isValidSlot(
-                      &entry->foregroundFastStruct->rWAccessTree->pNodes[*idx].fsData, &freeSlot);
+          isValid = fg->rWAccessTree->pBranchComp.isValidSlot(
+                      &fg->rWAccessTree->pNodes[*idx].fsData, &freeSlot);
           break;
 
         case draining:
-          isValid = entry->foregroundFastStruct->drnAccessTree->pBranchComp.isValidSlot(
-                      &entry->foregroundFastStruct->drnAccessTree->pNodes[*idx].fsData, &freeSlot);
+          isValid = fg->drnAccessTree->pBranchComp.isValidSlot(
+                      &fg->drnAccessTree->pNodes[*idx].fsData, &freeSlot);
           break;
 
         case balancing:
-          isValid = entry->foregroundFastStruct->blcAccessTree->pBranchComp.isValidSlot(
-                      &entry->foregroundFastStruct->blcAccessTree->pNodes[*idx].fsData, &freeSlot);
+          isValid = fg->blcAccessTree->pBranchComp.isValidSlot(
+                      &fg->blcAccessTree->pNodes[*idx].fsData, &freeSlot);
           break;
 
         default:
@@ -1945,6 +1946,8 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
 
       for (auto entryIt = entry2FsId.begin(); entryIt != entry2FsId.end();
            entryIt ++) {
+        FastStructSched* entryFg = entry2Fg[entryIt->first];
+
         if (g_logging.gLogMask & LOG_MASK(LOG_DEBUG)) {
           char buffer[1024];
           buffer[0] = 0;
@@ -1960,7 +1963,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
 
           for (auto it = entryIt->second.begin(); it != entryIt->second.end(); ++it) {
             buf += sprintf(buf, "%s  ",
-                           (*entryIt->first->foregroundFastStruct->treeInfo)[it->second].fullGeotag.c_str());
+                           (*entryFg->treeInfo)[it->second].fullGeotag.c_str());
           }
 
           eos_debug("existing replicas geotags in geotree -> %s", buffer);
@@ -1974,7 +1977,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
 
         entry = entryIt->first;
         // find the closest tree node to the accesser
-        accesserNode = entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+        accesserNode = entryFg->tag2NodeIdx->getClosestFastTreeNode(
                          accesserGeotag.c_str());;
         // fill a vector with the indices of the replicas
         vector<SchedTreeBase::tFastTreeIdx> existingReplicasIdx(entryIt->second.size());
@@ -1991,28 +1994,28 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
         case regularRO:
           retCode = accessReplicas(entryIt->first, 1, &accessedReplicasIdx,
                                    accesserNode, &existingReplicasIdx,
-                                   entry->foregroundFastStruct->rOAccessTree,
+                                   entryFg->rOAccessTree,
                                    NULL, NULL, pSkipSaturatedAccess);
           break;
 
         case regularRW:
           retCode = accessReplicas(entryIt->first, 1, &accessedReplicasIdx,
                                    accesserNode, &existingReplicasIdx,
-                                   entry->foregroundFastStruct->rWAccessTree,
+                                   entryFg->rWAccessTree,
                                    NULL, NULL, pSkipSaturatedAccess);
           break;
 
         case draining:
           retCode = accessReplicas(entryIt->first, 1, &accessedReplicasIdx,
                                    accesserNode, &existingReplicasIdx,
-                                   entry->foregroundFastStruct->drnAccessTree,
+                                   entryFg->drnAccessTree,
                                    NULL, NULL, pSkipSaturatedDrnAccess);
           break;
 
         case balancing:
           retCode = accessReplicas(entryIt->first, 1, &accessedReplicasIdx,
                                    accesserNode, &existingReplicasIdx,
-                                   entry->foregroundFastStruct->blcAccessTree,
+                                   entryFg->blcAccessTree,
                                    NULL, NULL, pSkipSaturatedBlcAccess);
           break;
 
@@ -2025,7 +2028,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
         }
 
         const string& fsGeotag =
-          (*entryIt->first->foregroundFastStruct->treeInfo)[*accessedReplicasIdx.begin()].fullGeotag;
+          (*entryFg->treeInfo)[*accessedReplicasIdx.begin()].fullGeotag;
         unsigned geoScore = 0;
         size_t kmax = min(accesserGeotag.length(), fsGeotag.length());
 
@@ -2046,7 +2049,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
         }
 
         geoScore2Fs[geoScore].push_back(
-          (*entryIt->first->foregroundFastStruct->treeInfo)[*accessedReplicasIdx.begin()].fsId);
+          (*entryFg->treeInfo)[*accessedReplicasIdx.begin()].fsId);
       }
 
       // randomly choose a fs among the highest scored ones
@@ -2083,7 +2086,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
       if (entry) {
         eos_debug("accesser closest node to %s index -> %d / %s",
                   accesserGeotag.c_str(), (int)accesserNode,
-                  (*entry->foregroundFastStruct->treeInfo)[accesserNode].fullGeotag.c_str());
+                  (*entry2Fg[entry]->treeInfo)[accesserNode].fullGeotag.c_str());
       }
 
       eos_debug("selected FsId -> %d / idx %d", (int)selectedFsId, (int)fsIndex);
@@ -2109,24 +2112,32 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
       }
 
       entry = pFs2SchedTME[fs];
+      auto fgIt = entry2Fg.find(entry);
+
+      // Only the groups found in the first pass are protected
+      if (fgIt == entry2Fg.end()) {
+        continue;
+      }
+
+      FastStructSched* fg = fgIt->second;
       const SchedTreeBase::tFastTreeIdx* idx;
 
-      if (entry->foregroundFastStruct->fs2TreeIdx->get(fs, idx)) {
+      if (fg->fs2TreeIdx->get(fs, idx)) {
         const char netSpeedClass =
-          (*entry->foregroundFastStruct->treeInfo)[*idx].netSpeedClass;
+          (*fg->treeInfo)[*idx].netSpeedClass;
 
         // every available box will push data
-        if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.ulScore >=
+        if (fg->placementTree->pNodes[*idx].fsData.ulScore >=
             pPenaltySched.pAccessUlScorePenalty[netSpeedClass]) {
-          applyUlScorePenalty(entry, *idx,
+          applyUlScorePenalty(fg, *idx,
                               pPenaltySched.pAccessUlScorePenalty[netSpeedClass]);
         }
 
         // every available box will have to pull data if it's a RW access (or if it's a gateway)
         if ((type == regularRW) || (j == fsIndex && nAccessReplicas > 1)) {
-          if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.dlScore >=
+          if (fg->placementTree->pNodes[*idx].fsData.dlScore >=
               pPenaltySched.pAccessDlScorePenalty[netSpeedClass]) {
-            applyDlScorePenalty(entry, *idx,
+            applyDlScorePenalty(fg, *idx,
                                 pPenaltySched.pAccessDlScorePenalty[netSpeedClass]);
           }
         }
@@ -2156,10 +2167,10 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
     if (pAccessGeotagMapping.inuse && pAccessProxygroup.inuse)
       for (size_t i = 0; i < ERIdx.size(); i++) {
         if (accesserGeotag.empty() ||
-            accessReqFwEP((*entries[i]->foregroundFastStruct->treeInfo)[ERIdx[i]].fullGeotag
+            accessReqFwEP((*entries[i]->treeInfo)[ERIdx[i]].fullGeotag
                           , accesserGeotag)) {
           firewallProxyGroups[i] = accessGetProxygroup((
-                                     *entries[i]->foregroundFastStruct->treeInfo)[ERIdx[i]].fullGeotag);
+                                     *entries[i]->treeInfo)[ERIdx[i]].fullGeotag);
         }
       }
 
@@ -2191,8 +2202,9 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
   // cleanup and exit
 cleanup:
 
-  for (auto cit = entry2FsId.begin(); cit != entry2FsId.end(); cit++) {
-    cit->first->doubleBufferMutex.UnLockRead();
+  fgGuards.clear();
+
+  for (auto cit = entry2Fg.begin(); cit != entry2Fg.end(); cit++) {
     AtomicDec(cit->first->fastStructLockWaitersCount);
   }
 
@@ -34,6 +34,7 @@
 #include "mgm/geotree/SchedulingSlowTree.hh"
 #include "mgm/TableFormatter/TableFormatterBase.hh"
 #include "common/Timing.hh"
+#include "common/HazardPointer.hh"
 /*----------------------------------------------------------------------------*/
 #include "XrdOuc/XrdOucString.hh"
 #include "XrdSys/XrdSysAtomics.hh"
@@ -716,8 +717,10 @@ class GeoTreeEngine : public eos::common::LogId
     // the pointed object is accessed in read /write only by the thread update
     FastStruct* backgroundFastStruct;
     // the two previous pointers are swapped once an update is done. To do so, we need a mutex and a counter (for deletion)
-    // every access to *mForegroundFastStruct for reading should be protected by a LockRead to mDoubleBufferMutex
-    // when swapping mForegroundFastStruct and mBackgroundFastStruct is needed a LockWrite is taken to mDoubleBufferMutex
+    // the placement and access paths read *foregroundFastStruct without locking through acquireForegroundFastStruct
+    // other readers of *foregroundFastStruct should be protected by a LockRead to doubleBufferMutex
+    // when swapping foregroundFastStruct and backgroundFastStruct a LockWrite is taken to doubleBufferMutex
+    // and the swap returns only once no lock-free reader uses the new background anymore
     eos::common::RWMutex doubleBufferMutex;
     size_t fastStructLockWaitersCount;
     bool fastStructModified;
@@ -741,10 +744,26 @@ class GeoTreeEngine : public eos::common::LogId
       }
     }
 
+    // protect the current foreground fast structures without locking, they
+    // are not modified by the updater as long as the guard protects them
+    FastStruct* acquireForegroundFastStruct(eos::common::HazardPointer& guard)
+    {
+      return guard.Protect(foregroundFastStruct);
+    }
+
     void swapFastStructBuffers()
     {
-      eos::common::RWMutexWriteLock lock(doubleBufferMutex);
-      std::swap(foregroundFastStruct, backgroundFastStruct);
+      FastStruct* previous;
+      {
+        eos::common::RWMutexWriteLock lock(doubleBufferMutex);
+        previous = foregroundFastStruct;
+        eos::common::HazardPointer::Publish(foregroundFastStruct,
+                                            backgroundFastStruct);
+        backgroundFastStruct = previous;
+      }
+      // the previous foreground is the next background, wait for the lock-free
+      // readers still working on it before handing it over to the updater
+      eos::common::HazardPointer::WaitUntilUnprotected(previous);
     }
 
     void updateBGFastStructuresConfigParam(
@@ -1310,6 +1329,18 @@ protected:
   static void tlFree(void* arg);
   static char* tlAlloc(size_t size);
 
+  inline void applyDlScorePenalty(FastStructSched* ft,
+                                  const SchedTreeBase::tFastTreeIdx& idx, const char& penalty)
+  {
+    ft->applyDlScorePenalty(idx, penalty, false);
+  }
+
+  inline void applyUlScorePenalty(FastStructSched* ft,
+                                  const SchedTreeBase::tFastTreeIdx& idx, const char& penalty)
+  {
+    ft->applyUlScorePenalty(idx, penalty, false);
+  }
+
   inline void applyDlScorePenalty(SchedTME* entry,
                                   const SchedTreeBase::tFastTreeIdx& idx, const char& penalty,
                                   bool background = false)
@@ -1810,7 +1841,7 @@ protected:
     any         // do the regular scheduling for all the filesystems
   } tProxySchedType;
   bool findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>& fsidxs,
-                 std::vector<SchedTME*> entries,
+                 const std::vector<FastStructSched*>& entries,
                  ino64_t inode,
                  std::vector<std::string>* proxies,
                  std::vector<std::string>* proxyGroups = NULL,
@@ -222,44 +222,7 @@ Iostat::Receive(ThreadAssistant& assistant) noexcept
 
       XrdOucEnv ioreport(body.c_str());
       eos::common::Report* report = new eos::common::Report(ioreport);
-      Add("bytes_read", report->uid, report->gid, report->rb, report->ots,
-          report->cts);
-      Add("bytes_read", report->uid, report->gid, report->rvb_sum, report->ots,
-          report->cts);
-      Add("bytes_written", report->uid, report->gid, report->wb, report->ots,
-          report->cts);
-      Add("read_calls", report->uid, report->gid, report->nrc, report->ots,
-          report->cts);
-      Add("readv_calls", report->uid, report->gid, report->rv_op, report->ots,
-          report->cts);
-      Add("write_calls", report->uid, report->gid, report->nwc, report->ots,
-          report->cts);
-      Add("fwd_seeks", report->uid, report->gid, report->nfwds, report->ots,
-          report->cts);
-      Add("bwd_seeks", report->uid, report->gid, report->nbwds, report->ots,
-          report->cts);
-      Add("xl_fwd_seeks", report->uid, report->gid, report->nxlfwds, report->ots,
-          report->cts);
-      Add("xl_bwd_seeks", report->uid, report->gid, report->nxlbwds, report->ots,
-          report->cts);
-      Add("bytes_fwd_seek", report->uid, report->gid, report->sfwdb, report->ots,
-          report->cts);
-      Add("bytes_bwd_wseek", report->uid, report->gid, report->sbwdb, report->ots,
-          report->cts);
-      Add("bytes_xl_fwd_seek", report->uid, report->gid, report->sxlfwdb, report->ots,
-          report->cts);
-      Add("bytes_xl_bwd_wseek", report->uid, report->gid, report->sxlbwdb,
-          report->ots, report->cts);
-      Add("disk_time_read", report->uid, report->gid, (unsigned long long) report->rt,
-          report->ots, report->cts);
-      Add("disk_time_write", report->uid, report->gid,
-          (unsigned long long) report->wt, report->ots, report->cts);
-      {
-        // track deletions
-        time_t now = time(NULL);
-        Add("bytes_deleted", 0, 0, report->dsize, now - 30, now);
-        Add("files_deleted", 0, 0, 1, now - 30, now);
-      }
+      AddReport(*report);
       // do the UDP broadcasting here
       {
         XrdSysMutexHelper mLock(BroadcastMutex);
@@ -269,107 +232,6 @@ Iostat::Receive(ThreadAssistant& assistant) noexcept
         }
       }
 
-      // do the domain accounting here
-      if (report->path.substr(0, 11) == "/replicate:") {
-        // check if this is a replication path
-        // push into the 'eos' domain
-        Mutex.Lock();
-
-        if (report->rb) {
-          IostatAvgDomainIOrb["eos"].Add(report->rb, report->ots, report->cts);
-        }
-
-        if (report->wb) {
-          IostatAvgDomainIOwb["eos"].Add(report->wb, report->ots, report->cts);
-        }
-
-        Mutex.UnLock();
-      } else {
-        bool dfound = false;
-
-        if (mReportPopularity) {
-          // do the popularity accounting here for everything which is not replication!
-          AddToPopularity(report->path, report->rb, report->ots, report->cts);
-        }
-
-        size_t pos = 0;
-
-        if ((pos = report->sec_domain.rfind(".")) != std::string::npos) {
-          // we can sort in by domain
-          std::string sdomain = report->sec_domain.substr(pos);
-
-          if (IoDomains.find(sdomain) != IoDomains.end()) {
-            Mutex.Lock();
-
-            if (report->rb) {
-              IostatAvgDomainIOrb[sdomain].Add(report->rb, report->ots, report->cts);
-            }
-
-            if (report->wb) {
-              IostatAvgDomainIOwb[sdomain].Add(report->wb, report->ots, report->cts);
-            }
-
-            Mutex.UnLock();
-            dfound = true;
-          }
-        }
-
-        // do the node accounting here - keep the node list small !!!
-        std::set<std::string>::const_iterator nit;
-
-        for (nit = IoNodes.begin(); nit != IoNodes.end(); nit++) {
-          if (*nit == report->sec_host.substr(0, nit->length())) {
-            Mutex.Lock();
-
-            if (report->rb) {
-              IostatAvgDomainIOrb[*nit].Add(report->rb, report->ots, report->cts);
-            }
-
-            if (report->wb) {
-              IostatAvgDomainIOwb[*nit].Add(report->wb, report->ots, report->cts);
-            }
-
-            Mutex.UnLock();
-            dfound = true;
-          }
-        }
-
-        if (!dfound) {
-          // push into the 'other' domain
-          Mutex.Lock();
-
-          if (report->rb) {
-            IostatAvgDomainIOrb["other"].Add(report->rb, report->ots, report->cts);
-          }
-
-          if (report->wb) {
-            IostatAvgDomainIOwb["other"].Add(report->wb, report->ots, report->cts);
-          }
-
-          Mutex.UnLock();
-        }
-      }
-
-      // do the application accounting here
-      std::string apptag = "other";
-
-      if (report->sec_app.length()) {
-        apptag = report->sec_app;
-      }
-
-      // Push into app accounting
-      Mutex.Lock();
-
-      if (report->rb) {
-        IostatAvgAppIOrb[apptag].Add(report->rb, report->ots, report->cts);
-      }
-
-      if (report->wb) {
-        IostatAvgAppIOwb[apptag].Add(report->wb, report->ots, report->cts);
-      }
-
-      Mutex.UnLock();
-
       if (mReport) {
         // add the record to a daily report log file
         static XrdOucString openreportfile = "";
@@ -445,6 +307,30 @@ Iostat::Receive(ThreadAssistant& assistant) noexcept
 }
 
 
+//------------------------------------------------------------------------------
+// Account a transfer report
+//------------------------------------------------------------------------------
+void
+Iostat::AddReport(const eos::common::Report& report)
+{
+  mCounters.AddReport(report);
+  {
+    // track deletions
+    time_t now = time(NULL);
+    mCounters.Add(IostatCounters::kBytesDeleted, 0, 0, report.dsize, now - 30,
+                  now);
+    mCounters.Add(IostatCounters::kFilesDeleted, 0, 0, 1, now - 30, now);
+  }
+
+  if (mReportPopularity && (report.path.compare(0, 11, "/replicate:") != 0)) {
+    // do the popularity accounting here for everything which is not replication!
+    AddToPopularity(report.path, report.rb, report.ots, report.cts);
+  }
+
+  // do the domain and application accounting here
+  AddToDomainAndApp(report);
+}
+
 /* ------------------------------------------------------------------------- */
 void
 Iostat::WriteRecord(std::string& record)
@@ -465,17 +351,14 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
                  bool monitoring, bool numerical, bool top,
                  bool domain, bool apps, XrdOucString option)
 {
-  Mutex.Lock();
   std::string format_s = (!monitoring ? "s" : "os");
   std::string format_ss = (!monitoring ? "-s" : "os");
   std::string format_l = (!monitoring ? "+l" : "ol");
   std::string format_ll = (!monitoring ? "l." : "ol");
-  std::vector<std::string> tags;
-
-  for (auto tit = IostatUid.begin(); tit != IostatUid.end(); ++tit) {
-    tags.push_back(tit->first);
-  }
-
+  // pairs of tag name and tag id sorted by name
+  std::vector<std::pair<std::string, size_t>> tags;
+  std::vector<IostatCounters::Entry> entries;
+  mCounters.GetActiveTags(tags);
   std::sort(tags.begin(), tags.end());
 
   if (summary) {
@@ -506,7 +389,8 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
     }
 
     for (const auto& elem : tags) {
-      const char* tag = elem.c_str();
+      const char* tag = elem.first.c_str();
+      IostatCounters::Entry sum = mCounters.GetSummary(elem.second);
       table_data.emplace_back();
       TableRow& row = table_data.back();
       row.emplace_back("all", format_ss);
@@ -516,11 +400,11 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
       }
 
       row.emplace_back(tag, format_s);
-      row.emplace_back(GetTotal(tag), format_l);
-      row.emplace_back(GetTotalAvg60(tag), format_l);
-      row.emplace_back(GetTotalAvg300(tag), format_l);
-      row.emplace_back(GetTotalAvg3600(tag), format_l);
-      row.emplace_back(GetTotalAvg86400(tag), format_l);
+      row.emplace_back(sum.mTotal, format_l);
+      row.emplace_back(sum.mAvg60, format_l);
+      row.emplace_back(sum.mAvg300, format_l);
+      row.emplace_back(sum.mAvg3600, format_l);
+      row.emplace_back(sum.mAvg86400, format_l);
     }
 
     table.AddRows(table_data);
@@ -581,21 +465,27 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
       });
     }
 
-    for (auto tuit = IostatAvgUid.begin(); tuit != IostatAvgUid.end(); tuit++) {
-      for (auto it = tuit->second.begin(); it != tuit->second.end(); ++it) {
+    for (const auto& elem : tags) {
+      mCounters.Collect(elem.second, false, entries);
+
+      for (const auto& entry : entries) {
+        // counters only restored from the dump have no averages to show
+        if (!entry.mHasAvg) {
+          continue;
+        }
+
         std::string username;
 
         if (numerical) {
-          username = std::to_string(it->first);
+          username = std::to_string(entry.mId);
         } else {
           int terrc = 0;
-          username = eos::common::Mapping::UidToUserName(it->first, terrc);
+          username = eos::common::Mapping::UidToUserName(entry.mId, terrc);
         }
 
-        uidout.emplace_back(std::make_tuple(username, tuit->first.c_str(),
-                                            IostatUid[tuit->first][it->first],
-                                            it->second.GetAvg60(), it->second.GetAvg300(),
-                                            it->second.GetAvg3600(), it->second.GetAvg86400()));
+        uidout.emplace_back(std::make_tuple(username, elem.first, entry.mTotal,
+                                            entry.mAvg60, entry.mAvg300,
+                                            entry.mAvg3600, entry.mAvg86400));
       }
     }
 
@@ -641,21 +531,27 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
       });
     }
 
-    for (auto tgit = IostatAvgGid.begin(); tgit != IostatAvgGid.end(); tgit++) {
-      for (auto it = tgit->second.begin(); it != tgit->second.end(); ++it) {
+    for (const auto& elem : tags) {
+      mCounters.Collect(elem.second, true, entries);
+
+      for (const auto& entry : entries) {
+        // counters only restored from the dump have no averages to show
+        if (!entry.mHasAvg) {
+          continue;
+        }
+
         std::string groupname;
 
         if (numerical) {
-          groupname = std::to_string(it->first);
+          groupname = std::to_string(entry.mId);
         } else {
           int terrc = 0;
-          groupname = eos::common::Mapping::GidToGroupName(it->first, terrc);
+          groupname = eos::common::Mapping::GidToGroupName(entry.mId, terrc);
         }
 
-        gidout.emplace_back(std::make_tuple(groupname, tgit->first.c_str(),
-                                            IostatGid[tgit->first][it->first],
-                                            it->second.GetAvg60(), it->second.GetAvg300(),
-                                            it->second.GetAvg3600(), it->second.GetAvg86400()));
+        gidout.emplace_back(std::make_tuple(groupname, elem.first, entry.mTotal,
+                                            entry.mAvg60, entry.mAvg300,
+                                            entry.mAvg3600, entry.mAvg86400));
       }
     }
 
@@ -702,10 +598,11 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
     for (auto it = tags.begin(); it != tags.end(); ++it) {
       std::vector <std::tuple<unsigned long long, uid_t>> uidout, gidout;
       table.AddSeparator();
-
       // by uid name
-      for (auto sit : IostatUid[*it]) {
-        uidout.push_back(std::make_tuple(sit.second, sit.first));
+      mCounters.Collect(it->second, false, entries);
+
+      for (const auto& entry : entries) {
+        uidout.push_back(std::make_tuple(entry.mTotal, entry.mId));
       }
 
       std::sort(uidout.begin(), uidout.end());
@@ -727,7 +624,7 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
 
         table_data.emplace_back();
         TableRow& row = table_data.back();
-        row.emplace_back(it->c_str(), format_ss);
+        row.emplace_back(it->first.c_str(), format_ss);
 
         if (!monitoring) {
           row.emplace_back("user", format_s);
@@ -744,8 +641,10 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
       }
 
       // by gid name
-      for (auto sit : IostatGid[*it]) {
-        gidout.push_back(std::make_tuple(sit.second, sit.first));
+      mCounters.Collect(it->second, true, entries);
+
+      for (const auto& entry : entries) {
+        gidout.push_back(std::make_tuple(entry.mTotal, entry.mId));
       }
 
       std::sort(gidout.begin(), gidout.end());
@@ -767,7 +666,7 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
 
         table_data.emplace_back();
         TableRow& row = table_data.back();
-        row.emplace_back(it->c_str(), format_ss);
+        row.emplace_back(it->first.c_str(), format_ss);
 
         if (!monitoring) {
           row.emplace_back("group", format_s);
@@ -812,6 +711,8 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
       });
     }
 
+    XrdSysMutexHelper mLock(Mutex);
+
     // IO out bytes
     for (auto it = IostatAvgDomainIOrb.begin(); it != IostatAvgDomainIOrb.end();
          ++it) {
@@ -868,6 +769,8 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
       });
     }
 
+    XrdSysMutexHelper mLock(Mutex);
+
     // IO out bytes
     for (auto it = IostatAvgAppIOrb.begin(); it != IostatAvgAppIOrb.end(); ++it) {
       table_data.emplace_back();
@@ -897,8 +800,6 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
     table.AddRows(table_data);
     out += table.GenerateTable(HEADER).c_str();
   }
-
-  Mutex.UnLock();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -1307,33 +1208,30 @@ Iostat::Store()
     return false;
   }
 
-  google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, unsigned long long> >::iterator
-  tuit;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, unsigned long long> >::iterator
-  tgit;
-  Mutex.Lock();
+  std::vector<std::pair<std::string, size_t>> tags;
+  std::vector<IostatCounters::Entry> entries;
+  mCounters.GetActiveTags(tags);
 
   // store user counters
-  for (tuit = IostatUid.begin(); tuit != IostatUid.end(); tuit++) {
-    google::sparse_hash_map<uid_t, unsigned long long>::iterator it;
+  for (const auto& tag : tags) {
+    mCounters.Collect(tag.second, false, entries);
 
-    for (it = tuit->second.begin(); it != tuit->second.end(); ++it) {
-      fprintf(fout, "tag=%s&uid=%u&val=%llu\n", tuit->first.c_str(), it->first,
-              it->second);
+    for (const auto& entry : entries) {
+      fprintf(fout, "tag=%s&uid=%u&val=%llu\n", tag.first.c_str(), entry.mId,
+              entry.mTotal);
     }
   }
 
   // store group counter
-  for (tgit = IostatGid.begin(); tgit != IostatGid.end(); tgit++) {
-    google::sparse_hash_map<uid_t, unsigned long long>::iterator it;
+  for (const auto& tag : tags) {
+    mCounters.Collect(tag.second, true, entries);
 
-    for (it = tgit->second.begin(); it != tgit->second.end(); ++it) {
-      fprintf(fout, "tag=%s&gid=%u&val=%llu\n", tgit->first.c_str(), it->first,
-              it->second);
+    for (const auto& entry : entries) {
+      fprintf(fout, "tag=%s&gid=%u&val=%llu\n", tag.first.c_str(), entry.mId,
+              entry.mTotal);
     }
   }
 
-  Mutex.UnLock();
   fclose(fout);
   return rename(tmpname.c_str(), mStoreFileName.c_str()) == 0;
 }
@@ -1355,7 +1253,6 @@ Iostat::Restore()
     return false;
   }
 
-  Mutex.Lock();
   int item = 0;
   char line[16384];
 
@@ -1364,21 +1261,20 @@ Iostat::Restore()
     XrdOucEnv env(line);
 
     if (env.Get("tag") && env.Get("uid") && env.Get("val")) {
-      std::string tag = env.Get("tag");
+      size_t tag = mCounters.InternTag(env.Get("tag"));
       uid_t uid = atoi(env.Get("uid"));
       unsigned long long val = strtoull(env.Get("val"), 0, 10);
-      IostatUid[tag][uid] = val;
+      mCounters.SetTotal(tag, false, uid, val);
     }
 
     if (env.Get("tag") && env.Get("gid") && env.Get("val")) {
-      std::string tag = env.Get("tag");
+      size_t tag = mCounters.InternTag(env.Get("tag"));
       gid_t gid = atoi(env.Get("gid"));
       unsigned long long val = strtoull(env.Get("val"), 0, 10);
-      IostatGid[tag][gid] = val;
+      mCounters.SetTotal(tag, true, gid, val);
     }
   }
 
-  Mutex.UnLock();
   fclose(fin);
   return true;
 }
@@ -1456,32 +1352,18 @@ Iostat::Circulate(ThreadAssistant& assistant) noexcept
       }
     }
 
+    // save the namespace warm-up list ~ every 10 minutes, so that a crash or
+    // a failover to another MGM does not lose it
+    if (sc && !(sc % 1170)) {
+      gOFS->SaveNsWarmupHotList(*this);
+    }
+
     sc++;
     assistant.wait_for(std::chrono::milliseconds(512));
+    mCounters.StampZero();
     Mutex.Lock();
-    google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, IostatAvg> >::iterator
-    tit;
     google::sparse_hash_map<std::string, IostatAvg >::iterator dit;
 
-    // loop over tags
-    for (tit = IostatAvgUid.begin(); tit != IostatAvgUid.end(); ++tit) {
-      // loop over vids
-      google::sparse_hash_map<uid_t, IostatAvg>::iterator it;
-
-      for (it = tit->second.begin(); it != tit->second.end(); ++it) {
-        it->second.StampZero();
-      }
-    }
-
-    for (tit = IostatAvgGid.begin(); tit != IostatAvgGid.end(); ++tit) {
-      // loop over vids
-      google::sparse_hash_map<uid_t, IostatAvg>::iterator it;
-
-      for (it = tit->second.begin(); it != tit->second.end(); ++it) {
-        it->second.StampZero();
-      }
-    }
-
     // loop over domain accounting
     for (dit = IostatAvgDomainIOrb.begin(); dit != IostatAvgDomainIOrb.end();
          dit++) {
@@ -2037,158 +1919,135 @@ Iostat::UdpBroadCast(eos::common::Report* report)
   }
 }
 
+//------------------------------------------------------------------------------
+// Account the transferred bytes per client domain/node and application
+//------------------------------------------------------------------------------
 void
-Iostat::AddToPopularity(std::string path, unsigned long long rb,
-                        time_t starttime,
-                        time_t stoptime)
-{
-  size_t popularitybin = (((starttime + stoptime) / 2) % (IOSTAT_POPULARITY_DAY *
-                          IOSTAT_POPULARITY_HISTORY_DAYS)) / IOSTAT_POPULARITY_DAY;
-  PopularityMutex.Lock();
-  eos::common::Path cPath(path.c_str());
-
-  for (size_t k = 0; k < cPath.GetSubPathSize(); k++) {
-    std::string sp = cPath.GetSubPath(k);
-    IostatPopularity[popularitybin][sp].rb += rb;
-    IostatPopularity[popularitybin][sp].nread++;
-  }
-
-  IostatLastPopularityBin = popularitybin;
-  PopularityMutex.UnLock();
-}
-
-/* ------------------------------------------------------------------------- */
-void
-IostatAvg::Add(unsigned long val, time_t starttime, time_t stoptime)
+Iostat::AddToDomainAndApp(const eos::common::Report& report)
 {
-  time_t now = time(0);
-  size_t tdiff = stoptime - starttime;
-  size_t toff = now - stoptime;
-
-  if (toff < 86400) {
-    // if the measurements was done in the last 86400 seconds
-    unsigned int mbins = tdiff / 1440; // number of bins the measurement was hitting
-
-    if (mbins == 0) {
-      mbins = 1;
+  static const std::string sEosTag = "eos";
+  static const std::string sOtherTag = "other";
+  auto add_io = [&](google::sparse_hash_map<std::string, IostatAvg>& rb_map,
+                    google::sparse_hash_map<std::string, IostatAvg>& wb_map,
+                    const std::string& key) {
+    if (report.rb) {
+      rb_map[key].Add(report.rb, report.ots, report.cts);
     }
 
-    unsigned long norm_val = (1.0 * val / mbins);
-
-    for (size_t bins = 0; bins < mbins; bins++) {
-      unsigned int bin86400 = (((stoptime - (bins * 1440)) / 1440) % 60);
-      avg86400[bin86400] += norm_val;
+    if (report.wb) {
+      wb_map[key].Add(report.wb, report.ots, report.cts);
     }
-  }
+  };
+  XrdSysMutexHelper mLock(Mutex);
 
-  if (toff < 3600) {
-    // if the measurements was done in the last 3600 seconds
-    unsigned int mbins = tdiff / 60; // number of bins the measurement was hitting
-
-    if (mbins == 0) {
-      mbins = 1;
-    }
+  if (report.path.compare(0, 11, "/replicate:") == 0) {
+    // check if this is a replication path
+    // push into the 'eos' domain
+    add_io(IostatAvgDomainIOrb, IostatAvgDomainIOwb, sEosTag);
+  } else {
+    bool dfound = false;
+    size_t pos = 0;
 
-    unsigned long norm_val = 1.0 * val / mbins;
+    if ((pos = report.sec_domain.rfind(".")) != std::string::npos) {
+      // we can sort in by domain
+      auto dit = IoDomains.find(report.sec_domain.c_str() + pos);
 
-    for (size_t bins = 0; bins < mbins; bins++) {
-      unsigned int bin3600 = (((stoptime - (bins * 60)) / 60) % 60);
-      avg3600[bin3600] += norm_val;
+      if (dit != IoDomains.end()) {
+        add_io(IostatAvgDomainIOrb, IostatAvgDomainIOwb, *dit);
+        dfound = true;
+      }
     }
-  }
 
-  if (toff < 300) {
-    // if the measurements was done in the last 300 seconds
-    unsigned int mbins = tdiff / 5; // number of bins the measurement was hitting
-
-    if (mbins == 0) {
-      mbins = 1;
+    // do the node accounting here - keep the node list small !!!
+    for (const auto& node : IoNodes) {
+      if (report.sec_host.compare(0, node.length(), node) == 0) {
+        add_io(IostatAvgDomainIOrb, IostatAvgDomainIOwb, node);
+        dfound = true;
+      }
     }
 
-    unsigned long norm_val = 1.0 * val / mbins;
-
-    for (size_t bins = 0; bins < mbins; bins++) {
-      unsigned int bin300 = (((stoptime - (bins * 5)) / 5) % 60);
-      avg300[bin300] += norm_val;
+    if (!dfound) {
+      // push into the 'other' domain
+      add_io(IostatAvgDomainIOrb, IostatAvgDomainIOwb, sOtherTag);
     }
   }
 
-  if (toff < 60) {
-    // if the measurements was done in the last 60 seconds
-    unsigned int mbins = tdiff / 1; // number of bins the measurement was hitting
-
-    if (mbins == 0) {
-      mbins = 1;
-    }
-
-    unsigned long norm_val = 1.0 * val / mbins;
-
-    for (size_t bins = 0; bins < mbins; ++bins) {
-      unsigned int bin60 = (((stoptime - (bins * 1)) / 1) % 60);
-      avg60[bin60] += norm_val;
-    }
-  }
+  // Push into app accounting
+  add_io(IostatAvgAppIOrb, IostatAvgAppIOwb,
+         report.sec_app.length() ? report.sec_app : sOtherTag);
 }
 
+//------------------------------------------------------------------------------
+// Account a read access for the path and all its parent directories
+//------------------------------------------------------------------------------
 void
-IostatAvg::StampZero()
-{
-  unsigned int bin86400 = (time(0) / 1440);
-  unsigned int bin3600 = (time(0) / 60);
-  unsigned int bin300 = (time(0) / 5);
-  unsigned int bin60 = (time(0) / 1);
-  avg86400[(bin86400 + 1) % 60] = 0;
-  avg3600[(bin3600 + 1) % 60] = 0;
-  avg300[(bin300 + 1) % 60] = 0;
-  avg60[(bin60 + 1) % 60] = 0;
-}
-
-double
-IostatAvg::GetAvg86400()
-{
-  double sum = 0;
-
-  for (int i = 0; i < 60; i++) {
-    sum += avg86400[i];
-  }
-
-  return sum;
-}
-
-double
-IostatAvg::GetAvg3600()
+Iostat::AddToPopularity(const std::string& path, unsigned long long rb,
+                        time_t starttime,
+                        time_t stoptime)
 {
-  double sum = 0;
+  size_t popularitybin = (((starttime + stoptime) / 2) % (IOSTAT_POPULARITY_DAY *
+                          IOSTAT_POPULARITY_HISTORY_DAYS)) / IOSTAT_POPULARITY_DAY;
+  XrdSysMutexHelper mLock(PopularityMutex);
+  google::sparse_hash_map<std::string, struct Popularity>& popularity =
+    IostatPopularity[popularitybin];
+
+  if (path.length() && (path[0] == '/') &&
+      (path.find("//") == std::string::npos) &&
+      (path.find("/.") == std::string::npos)) {
+    // Already normalized absolute path: the sub paths are the prefixes ending
+    // with a '/', except a trailing one. They are built in the reused key
+    // buffer so only new map entries allocate.
+    size_t len = path.length() - ((path.back() == '/') ? 1 : 0);
+
+    for (size_t pos = path.find('/'); (pos != std::string::npos) && (pos < len);
+         pos = path.find('/', pos + 1)) {
+      mPopularityKey.assign(path, 0, pos + 1);
+      struct Popularity& entry = popularity[mPopularityKey];
+      entry.rb += rb;
+      entry.nread++;
+    }
+  } else {
+    eos::common::Path cPath(path.c_str());
 
-  for (int i = 0; i < 60; i++) {
-    sum += avg3600[i];
+    for (size_t k = 0; k < cPath.GetSubPathSize(); k++) {
+      mPopularityKey = cPath.GetSubPath(k);
+      struct Popularity& entry = popularity[mPopularityKey];
+      entry.rb += rb;
+      entry.nread++;
+    }
   }
 
-  return sum;
+  IostatLastPopularityBin = popularitybin;
 }
 
-double
-IostatAvg::GetAvg300()
+//------------------------------------------------------------------------------
+// Get the most accessed directories over the whole popularity history
+//------------------------------------------------------------------------------
+void
+Iostat::GetPopularPaths(size_t max, std::vector<std::string>& paths)
 {
-  double sum = 0;
+  google::sparse_hash_map<std::string, struct Popularity> total;
+  {
+    XrdSysMutexHelper mLock(PopularityMutex);
 
-  for (int i = 0; i < 60; i++) {
-    sum += avg300[i];
+    for (size_t bin = 0; bin < IOSTAT_POPULARITY_HISTORY_DAYS; ++bin) {
+      for (const auto& elem : IostatPopularity[bin]) {
+        struct Popularity& entry = total[elem.first];
+        entry.rb += elem.second.rb;
+        entry.nread += elem.second.nread;
+      }
+    }
   }
-
-  return sum;
-}
-
-double
-IostatAvg::GetAvg60()
-{
-  double sum = 0;
-
-  for (int i = 0; i < 60; i++) {
-    sum += avg60[i];
+  std::vector<popularity_t> sorted(total.begin(), total.end());
+  max = std::min(max, sorted.size());
+  std::partial_sort(sorted.begin(), sorted.begin() + max, sorted.end(),
+                    PopularityCmp_nread());
+  paths.clear();
+  paths.reserve(max);
+
+  for (size_t i = 0; i < max; ++i) {
+    paths.push_back(sorted[i].first);
   }
-
-  return sum;
 }
 
 EOSMGMNAMESPACE_END
@@ -25,6 +25,7 @@
 #define __EOSMGM_IOSTAT__HH__
 
 #include "mgm/Namespace.hh"
+#include "mgm/IostatCounters.hh"
 #include "mq/XrdMqClient.hh"
 #include "common/Logging.hh"
 #include "common/AssistedThread.hh"
@@ -33,6 +34,7 @@
 #include <sys/types.h>
 #include <string>
 #include <set>
+#include <vector>
 #include <atomic>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -52,43 +54,6 @@ EOSMGMNAMESPACE_BEGIN
 #define IOSTAT_POPULARITY_HISTORY_DAYS 7
 #define IOSTAT_POPULARITY_DAY 86400
 
-class IostatAvg
-{
-public:
-  unsigned long avg86400[60];
-  unsigned long avg3600[60];
-  unsigned long avg300[60];
-  unsigned long avg60[60];
-
-  IostatAvg()
-  {
-    memset(avg86400, 0, sizeof(avg86400));
-    memset(avg3600, 0, sizeof(avg3600));
-    memset(avg300, 0, sizeof(avg300));
-    memset(avg60, 0, sizeof(avg60));
-  }
-
-  ~IostatAvg() { };
-
-  void
-  Add(unsigned long val, time_t starttime, time_t stoptime);
-
-  void
-  StampZero();
-
-  double
-  GetAvg86400();
-
-  double
-  GetAvg3600();
-
-  double
-  GetAvg300();
-
-  double
-  GetAvg60();
-};
-
 class Iostat
 {
   // -------------------------------------------------------------
@@ -96,15 +61,8 @@ class Iostat
   // -------------------------------------------------------------
 private:
 
-  XrdSysMutex Mutex;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, unsigned long long> >
-  IostatUid;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<gid_t, unsigned long long> >
-  IostatGid;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, IostatAvg> >
-  IostatAvgUid;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<gid_t, IostatAvg> >
-  IostatAvgGid;
+  XrdSysMutex Mutex; // protecting domain/app accounting, flags and report file
+  IostatCounters mCounters; // per uid/gid counters, locked internally
 
   google::sparse_hash_map<std::string, IostatAvg> IostatAvgDomainIOrb;
   google::sparse_hash_map<std::string, IostatAvg> IostatAvgDomainIOwb;
@@ -112,7 +70,8 @@ private:
   google::sparse_hash_map<std::string, IostatAvg> IostatAvgAppIOrb;
   google::sparse_hash_map<std::string, IostatAvg> IostatAvgAppIOwb;
 
-  std::set<std::string> IoDomains;
+  // transparent comparison allows lookups by const char* without a copy
+  std::set<std::string, std::less<>> IoDomains;
   std::set<std::string> IoNodes;
 
   // -----------------------------------------------------------
@@ -132,6 +91,9 @@ private:
   google::sparse_hash_map<std::string, struct Popularity>
     IostatPopularity[ IOSTAT_POPULARITY_HISTORY_DAYS ];
 
+  // Scratch key for the popularity maps (protected by PopularityMutex)
+  std::string mPopularityKey;
+
   typedef std::pair<std::string, struct Popularity> popularity_t;
 
   struct PopularityCmp_nread {
@@ -251,9 +213,32 @@ public:
   static bool NamespaceReport(const char* path, XrdOucString& stdOut,
                               XrdOucString& stdErr);
 
+  //----------------------------------------------------------------------------
+  //! Account a transfer report in the user/group counters, the popularity
+  //! and the domain/application statistics
+  //!
+  //! @param report transfer report
+  //----------------------------------------------------------------------------
+  void AddReport(const eos::common::Report& report);
+
   void
-  AddToPopularity(std::string path, unsigned long long rb, time_t starttime,
-                  time_t stoptime);
+  AddToPopularity(const std::string& path, unsigned long long rb,
+                  time_t starttime, time_t stoptime);
+
+  //----------------------------------------------------------------------------
+  //! Get the most accessed directories over the whole popularity history
+  //!
+  //! @param max maximum number of paths returned
+  //! @param paths filled with the paths, most accessed first
+  //----------------------------------------------------------------------------
+  void GetPopularPaths(size_t max, std::vector<std::string>& paths);
+
+  //----------------------------------------------------------------------------
+  //! Account the bytes of a report per client domain/node and application
+  //!
+  //! @param report transfer report
+  //----------------------------------------------------------------------------
+  void AddToDomainAndApp(const eos::common::Report& report);
 
   // stats collection
 
@@ -261,105 +246,13 @@ public:
   Add(const char* tag, uid_t uid, gid_t gid, unsigned long val, time_t starttime,
       time_t stoptime)
   {
-    Mutex.Lock();
-    IostatUid[tag][uid] += val;
-    IostatGid[tag][gid] += val;
-    IostatAvgUid[tag][uid].Add(val, starttime, stoptime);
-    IostatAvgGid[tag][gid].Add(val, starttime, stoptime);
-    Mutex.UnLock();
+    mCounters.Add(mCounters.InternTag(tag), uid, gid, val, starttime, stoptime);
   }
 
   unsigned long long
   GetTotal(const char* tag)
   {
-    google::sparse_hash_map<uid_t, unsigned long long>::const_iterator it;
-    unsigned long long val = 0;
-
-    if (!IostatUid.count(tag)) {
-      return 0;
-    }
-
-    for (it = IostatUid[tag].begin(); it != IostatUid[tag].end(); ++it) {
-      val += it->second;
-    }
-
-    return val;
-  }
-
-  // warning: you have to lock the mutex if directly used
-
-  double
-  GetTotalAvg86400(const char* tag)
-  {
-    google::sparse_hash_map<uid_t, IostatAvg>::iterator it;
-    double val = 0;
-
-    if (!IostatAvgUid.count(tag)) {
-      return 0;
-    }
-
-    for (it = IostatAvgUid[tag].begin(); it != IostatAvgUid[tag].end(); ++it) {
-      val += it->second.GetAvg86400();
-    }
-
-    return val;
-  }
-
-  // warning: you have to lock the mutex if directly used
-
-  double
-  GetTotalAvg3600(const char* tag)
-  {
-    google::sparse_hash_map<uid_t, IostatAvg>::iterator it;
-    double val = 0;
-
-    if (!IostatAvgUid.count(tag)) {
-      return 0;
-    }
-
-    for (it = IostatAvgUid[tag].begin(); it != IostatAvgUid[tag].end(); ++it) {
-      val += it->second.GetAvg3600();
-    }
-
-    return val;
-  }
-
-  // warning: you have to lock the mutex if directly used
-
-  double
-  GetTotalAvg300(const char* tag)
-  {
-    google::sparse_hash_map<uid_t, IostatAvg>::iterator it;
-    double val = 0;
-
-    if (!IostatAvgUid.count(tag)) {
-      return 0;
-    }
-
-    for (it = IostatAvgUid[tag].begin(); it != IostatAvgUid[tag].end(); ++it) {
-      val += it->second.GetAvg300();
-    }
-
-    return val;
-  }
-
-  // warning: you have to lock the mutex if directly used
-
-  double
-  GetTotalAvg60(const char* tag)
-  {
-    google::sparse_hash_map<uid_t, IostatAvg>::iterator it;
-    double val = 0;
-
-    if (!IostatAvgUid.count(tag)) {
-      return 0;
-    }
-
-    for (it = IostatAvgUid[tag].begin(); it != IostatAvgUid[tag].end(); ++it) {
-      val += it->second.GetAvg60();
-    }
-
-    return val;
+    return mCounters.GetSummary(mCounters.InternTag(tag)).mTotal;
   }
 
 private:
@@ -0,0 +1,442 @@
+//------------------------------------------------------------------------------
+//! @file IostatCounters.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/IostatCounters.hh"
+#include "common/Report.hh"
+
+EOSMGMNAMESPACE_BEGIN
+
+namespace
+{
+//! Names of the tags with fixed ids, same order as IostatCounters::Tag
+const char* sFixedTags[IostatCounters::kNumFixedTags] = {
+  "bytes_read",
+  "bytes_written",
+  "read_calls",
+  "readv_calls",
+  "write_calls",
+  "fwd_seeks",
+  "bwd_seeks",
+  "xl_fwd_seeks",
+  "xl_bwd_seeks",
+  "bytes_fwd_seek",
+  "bytes_bwd_wseek",
+  "bytes_xl_fwd_seek",
+  "bytes_xl_bwd_wseek",
+  "disk_time_read",
+  "disk_time_write",
+  "bytes_deleted",
+  "files_deleted"
+};
+}
+
+//------------------------------------------------------------------------------
+// Shard constructor
+//------------------------------------------------------------------------------
+IostatCounters::Shard::Shard()
+{
+  // Keys are 32-bit ids stored in 64 bits so the empty key is never used
+  mSlots.set_empty_key(UINT64_MAX);
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+IostatCounters::IostatCounters():
+  mNumTags(0)
+{
+  for (size_t i = 0; i < kNumFixedTags; ++i) {
+    (void) InternTag(sFixedTags[i]);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the id of a tag, registering it if needed
+//------------------------------------------------------------------------------
+size_t
+IostatCounters::InternTag(const char* tag)
+{
+  std::lock_guard<std::mutex> lock(mTagMutex);
+  auto it = mTagIds.find(tag);
+
+  if (it != mTagIds.end()) {
+    return it->second;
+  }
+
+  size_t id = mTagNames.size();
+  mTagIds.emplace(tag, id);
+  mTagNames.emplace_back(tag);
+  mNumTags = mTagNames.size();
+  return id;
+}
+
+//------------------------------------------------------------------------------
+// Get the name of a tag
+//------------------------------------------------------------------------------
+std::string
+IostatCounters::GetTagName(size_t tag) const
+{
+  std::lock_guard<std::mutex> lock(mTagMutex);
+  return ((tag < mTagNames.size()) ? mTagNames[tag] : std::string());
+}
+
+//------------------------------------------------------------------------------
+// Get the counter of a tag for an id, creating it if needed
+//------------------------------------------------------------------------------
+IostatCounters::Counter&
+IostatCounters::GetCounter(Shard& shard, uint32_t id, size_t tag)
+{
+  auto it = shard.mSlots.find(id);
+  Row* row;
+
+  if (it != shard.mSlots.end()) {
+    row = &shard.mRows[it->second];
+  } else {
+    shard.mSlots[id] = shard.mRows.size();
+    shard.mRows.emplace_back();
+    row = &shard.mRows.back();
+    row->mId = id;
+    // Size the row for all the known tags to avoid growing it later
+    row->mCounters.resize(mNumTags);
+  }
+
+  if (tag >= row->mCounters.size()) {
+    row->mCounters.resize(tag + 1);
+  }
+
+  return row->mCounters[tag];
+}
+
+//------------------------------------------------------------------------------
+// Add samples to the shards of uids or gids
+//------------------------------------------------------------------------------
+void
+IostatCounters::AddToShard(Shard* shards, uint32_t id, const Sample* samples,
+                           size_t nsamples, time_t starttime, time_t stoptime)
+{
+  Shard& shard = shards[GetShardIndex(id)];
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+
+  for (size_t i = 0; i < nsamples; ++i) {
+    Counter& counter = GetCounter(shard, id, samples[i].mTag);
+    counter.mUsed = true;
+    counter.mHasAvg = true;
+    counter.mTotal += samples[i].mVal;
+    counter.mAvg.Add(samples[i].mVal, starttime, stoptime);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Add several values for the same uid, gid and measurement period
+//------------------------------------------------------------------------------
+void
+IostatCounters::AddBatch(uid_t uid, gid_t gid, const Sample* samples,
+                         size_t nsamples, time_t starttime, time_t stoptime)
+{
+  AddToShard(mUidShards, uid, samples, nsamples, starttime, stoptime);
+  AddToShard(mGidShards, gid, samples, nsamples, starttime, stoptime);
+}
+
+//------------------------------------------------------------------------------
+// Add all the counters of a transfer report
+//------------------------------------------------------------------------------
+void
+IostatCounters::AddReport(const eos::common::Report& report)
+{
+  // Read and readv bytes are added one after the other like two reports so
+  // that the averages are rounded the same way as before
+  const Sample samples[] = {
+    {kBytesRead, (unsigned long) report.rb},
+    {kBytesRead, (unsigned long) report.rvb_sum},
+    {kBytesWritten, (unsigned long) report.wb},
+    {kReadCalls, (unsigned long) report.nrc},
+    {kReadvCalls, (unsigned long) report.rv_op},
+    {kWriteCalls, (unsigned long) report.nwc},
+    {kFwdSeeks, (unsigned long) report.nfwds},
+    {kBwdSeeks, (unsigned long) report.nbwds},
+    {kXlFwdSeeks, (unsigned long) report.nxlfwds},
+    {kXlBwdSeeks, (unsigned long) report.nxlbwds},
+    {kBytesFwdSeek, (unsigned long) report.sfwdb},
+    {kBytesBwdSeek, (unsigned long) report.sbwdb},
+    {kBytesXlFwdSeek, (unsigned long) report.sxlfwdb},
+    {kBytesXlBwdSeek, (unsigned long) report.sxlbwdb},
+    {kDiskTimeRead, (unsigned long)(unsigned long long) report.rt},
+    {kDiskTimeWrite, (unsigned long)(unsigned long long) report.wt}
+  };
+  AddBatch(report.uid, report.gid, samples, sizeof(samples) / sizeof(Sample),
+           report.ots, report.cts);
+}
+
+//------------------------------------------------------------------------------
+// Set the total of a counter
+//------------------------------------------------------------------------------
+void
+IostatCounters::SetTotal(size_t tag, bool by_gid, uint32_t id,
+                         unsigned long long val)
+{
+  Shard& shard = (by_gid ? mGidShards : mUidShards)[GetShardIndex(id)];
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  Counter& counter = GetCounter(shard, id, tag);
+  counter.mUsed = true;
+  counter.mTotal = val;
+}
+
+//------------------------------------------------------------------------------
+// Get the tags which have at least one uid counter
+//------------------------------------------------------------------------------
+void
+IostatCounters::GetActiveTags(std::vector<std::pair<std::string, size_t>>&
+                              tags) const
+{
+  std::vector<bool> active;
+
+  for (const auto& shard : mUidShards) {
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+
+    for (const auto& row : shard.mRows) {
+      if (active.size() < row.mCounters.size()) {
+        active.resize(row.mCounters.size(), false);
+      }
+
+      for (size_t tag = 0; tag < row.mCounters.size(); ++tag) {
+        if (row.mCounters[tag].mUsed) {
+          active[tag] = true;
+        }
+      }
+    }
+  }
+
+  tags.clear();
+  std::lock_guard<std::mutex> lock(mTagMutex);
+
+  for (size_t tag = 0; tag < active.size(); ++tag) {
+    if (active[tag]) {
+      tags.emplace_back(mTagNames[tag], tag);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get snapshot of the counters of a tag
+//------------------------------------------------------------------------------
+void
+IostatCounters::Collect(size_t tag, bool by_gid,
+                        std::vector<Entry>& entries) const
+{
+  entries.clear();
+
+  for (const auto& shard : (by_gid ? mGidShards : mUidShards)) {
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+
+    for (const auto& row : shard.mRows) {
+      if ((tag >= row.mCounters.size()) || !row.mCounters[tag].mUsed) {
+        continue;
+      }
+
+      const IostatAvg& avg = row.mCounters[tag].mAvg;
+      entries.push_back({row.mId, row.mCounters[tag].mTotal,
+                         row.mCounters[tag].mHasAvg, avg.GetAvg60(),
+                         avg.GetAvg300(), avg.GetAvg3600(), avg.GetAvg86400()});
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the sum of the uid counters of a tag
+//------------------------------------------------------------------------------
+IostatCounters::Entry
+IostatCounters::GetSummary(size_t tag) const
+{
+  Entry sum {0, 0, false, 0, 0, 0, 0};
+  std::vector<Entry> entries;
+  Collect(tag, false, entries);
+
+  for (const auto& entry : entries) {
+    sum.mTotal += entry.mTotal;
+    sum.mHasAvg |= entry.mHasAvg;
+    sum.mAvg60 += entry.mAvg60;
+    sum.mAvg300 += entry.mAvg300;
+    sum.mAvg3600 += entry.mAvg3600;
+    sum.mAvg86400 += entry.mAvg86400;
+  }
+
+  return sum;
+}
+
+//------------------------------------------------------------------------------
+// Zero the next bin of all the averages
+//------------------------------------------------------------------------------
+void
+IostatCounters::StampZero()
+{
+  for (Shard* shards : {
+         mUidShards, mGidShards
+       }) {
+    for (size_t i = 0; i < sNumShards; ++i) {
+      std::lock_guard<std::mutex> lock(shards[i].mMutex);
+
+      for (auto& row : shards[i].mRows) {
+        for (auto& counter : row.mCounters) {
+          if (counter.mHasAvg) {
+            counter.mAvg.StampZero();
+          }
+        }
+      }
+    }
+  }
+}
+
+/* ------------------------------------------------------------------------- */
+void
+IostatAvg::Add(unsigned long val, time_t starttime, time_t stoptime)
+{
+  time_t now = time(0);
+  size_t tdiff = stoptime - starttime;
+  size_t toff = now - stoptime;
+
+  if (toff < 86400) {
+    // if the measurements was done in the last 86400 seconds
+    unsigned int mbins = tdiff / 1440; // number of bins the measurement was hitting
+
+    if (mbins == 0) {
+      mbins = 1;
+    }
+
+    unsigned long norm_val = (1.0 * val / mbins);
+
+    for (size_t bins = 0; bins < mbins; bins++) {
+      unsigned int bin86400 = (((stoptime - (bins * 1440)) / 1440) % 60);
+      avg86400[bin86400] += norm_val;
+    }
+  }
+
+  if (toff < 3600) {
+    // if the measurements was done in the last 3600 seconds
+    unsigned int mbins = tdiff / 60; // number of bins the measurement was hitting
+
+    if (mbins == 0) {
+      mbins = 1;
+    }
+
+    unsigned long norm_val = 1.0 * val / mbins;
+
+    for (size_t bins = 0; bins < mbins; bins++) {
+      unsigned int bin3600 = (((stoptime - (bins * 60)) / 60) % 60);
+      avg3600[bin3600] += norm_val;
+    }
+  }
+
+  if (toff < 300) {
+    // if the measurements was done in the last 300 seconds
+    unsigned int mbins = tdiff / 5; // number of bins the measurement was hitting
+
+    if (mbins == 0) {
+      mbins = 1;
+    }
+
+    unsigned long norm_val = 1.0 * val / mbins;
+
+    for (size_t bins = 0; bins < mbins; bins++) {
+      unsigned int bin300 = (((stoptime - (bins * 5)) / 5) % 60);
+      avg300[bin300] += norm_val;
+    }
+  }
+
+  if (toff < 60) {
+    // if the measurements was done in the last 60 seconds
+    unsigned int mbins = tdiff / 1; // number of bins the measurement was hitting
+
+    if (mbins == 0) {
+      mbins = 1;
+    }
+
+    unsigned long norm_val = 1.0 * val / mbins;
+
+    for (size_t bins = 0; bins < mbins; ++bins) {
+      unsigned int bin60 = (((stoptime - (bins * 1)) / 1) % 60);
+      avg60[bin60] += norm_val;
+    }
+  }
+}
+
+void
+IostatAvg::StampZero()
+{
+  unsigned int bin86400 = (time(0) / 1440);
+  unsigned int bin3600 = (time(0) / 60);
+  unsigned int bin300 = (time(0) / 5);
+  unsigned int bin60 = (time(0) / 1);
+  avg86400[(bin86400 + 1) % 60] = 0;
+  avg3600[(bin3600 + 1) % 60] = 0;
+  avg300[(bin300 + 1) % 60] = 0;
+  avg60[(bin60 + 1) % 60] = 0;
+}
+
+double
+IostatAvg::GetAvg86400() const
+{
+  double sum = 0;
+
+  for (int i = 0; i < 60; i++) {
+    sum += avg86400[i];
+  }
+
+  return sum;
+}
+
+double
+IostatAvg::GetAvg3600() const
+{
+  double sum = 0;
+
+  for (int i = 0; i < 60; i++) {
+    sum += avg3600[i];
+  }
+
+  return sum;
+}
+
+double
+IostatAvg::GetAvg300() const
+{
+  double sum = 0;
+
+  for (int i = 0; i < 60; i++) {
+    sum += avg300[i];
+  }
+
+  return sum;
+}
+
+double
+IostatAvg::GetAvg60() const
+{
+  double sum = 0;
+
+  for (int i = 0; i < 60; i++) {
+    sum += avg60[i];
+  }
+
+  return sum;
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,306 @@
+//------------------------------------------------------------------------------
+//! @file IostatCounters.hh
+//! @brief Sharded per uid/gid io statistics counters
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSMGM_IOSTATCOUNTERS_HH__
+#define __EOSMGM_IOSTATCOUNTERS_HH__
+
+#include "mgm/Namespace.hh"
+#include <google/dense_hash_map>
+#include <sys/types.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace eos
+{
+namespace common
+{
+class Report;
+}
+}
+
+EOSMGMNAMESPACE_BEGIN
+
+class IostatAvg
+{
+public:
+  unsigned long avg86400[60];
+  unsigned long avg3600[60];
+  unsigned long avg300[60];
+  unsigned long avg60[60];
+
+  IostatAvg()
+  {
+    memset(avg86400, 0, sizeof(avg86400));
+    memset(avg3600, 0, sizeof(avg3600));
+    memset(avg300, 0, sizeof(avg300));
+    memset(avg60, 0, sizeof(avg60));
+  }
+
+  ~IostatAvg() { };
+
+  void
+  Add(unsigned long val, time_t starttime, time_t stoptime);
+
+  void
+  StampZero();
+
+  double
+  GetAvg86400() const;
+
+  double
+  GetAvg3600() const;
+
+  double
+  GetAvg300() const;
+
+  double
+  GetAvg60() const;
+};
+
+//------------------------------------------------------------------------------
+//! Class IostatCounters
+//!
+//! Holds the io statistics counters per tag and uid/gid. Tag names are
+//! interned to small integer ids, the tags filled from every transfer report
+//! have fixed ids so the report path never looks up a string. The uids and
+//! gids are spread over independently locked shards, inside a shard every
+//! id owns a row of counters indexed by tag which is found through an open
+//! addressing table. Once the row of an id exists, accounting a report takes
+//! one lock and one table lookup per uid and gid and does not allocate.
+//------------------------------------------------------------------------------
+class IostatCounters
+{
+public:
+  //! Tags with fixed ids, interned in this order by the constructor
+  enum Tag : size_t {
+    kBytesRead = 0,
+    kBytesWritten,
+    kReadCalls,
+    kReadvCalls,
+    kWriteCalls,
+    kFwdSeeks,
+    kBwdSeeks,
+    kXlFwdSeeks,
+    kXlBwdSeeks,
+    kBytesFwdSeek,
+    kBytesBwdSeek,
+    kBytesXlFwdSeek,
+    kBytesXlBwdSeek,
+    kDiskTimeRead,
+    kDiskTimeWrite,
+    kBytesDeleted,
+    kFilesDeleted,
+    kNumFixedTags
+  };
+
+  //! Single value to be accounted for a tag
+  struct Sample {
+    size_t mTag; ///< Tag id
+    unsigned long mVal; ///< Value
+  };
+
+  //! Snapshot of the counter of a tag for one uid or gid
+  struct Entry {
+    uint32_t mId; ///< uid or gid
+    unsigned long long mTotal; ///< Sum of all the values
+    bool mHasAvg; ///< Values were added since start i.e. not only restored
+    double mAvg60; ///< Sum over the last minute
+    double mAvg300; ///< Sum over the last 5 minutes
+    double mAvg3600; ///< Sum over the last hour
+    double mAvg86400; ///< Sum over the last day
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  IostatCounters();
+
+  //----------------------------------------------------------------------------
+  //! Get the id of a tag, registering it if needed
+  //!
+  //! @param tag tag name
+  //!
+  //! @return tag id
+  //----------------------------------------------------------------------------
+  size_t InternTag(const char* tag);
+
+  //----------------------------------------------------------------------------
+  //! Get the name of a tag
+  //!
+  //! @param tag tag id
+  //!
+  //! @return tag name or empty string if id is unknown
+  //----------------------------------------------------------------------------
+  std::string GetTagName(size_t tag) const;
+
+  //----------------------------------------------------------------------------
+  //! Add value for a uid and gid
+  //!
+  //! @param tag tag id
+  //! @param uid user id
+  //! @param gid group id
+  //! @param val value
+  //! @param starttime start of the measurement
+  //! @param stoptime end of the measurement
+  //----------------------------------------------------------------------------
+  void
+  Add(size_t tag, uid_t uid, gid_t gid, unsigned long val, time_t starttime,
+      time_t stoptime)
+  {
+    Sample sample {tag, val};
+    AddBatch(uid, gid, &sample, 1, starttime, stoptime);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Add several values for the same uid, gid and measurement period taking
+  //! the uid and gid shard locks only once
+  //!
+  //! @param uid user id
+  //! @param gid group id
+  //! @param samples values to add
+  //! @param nsamples number of values
+  //! @param starttime start of the measurement
+  //! @param stoptime end of the measurement
+  //----------------------------------------------------------------------------
+  void AddBatch(uid_t uid, gid_t gid, const Sample* samples, size_t nsamples,
+                time_t starttime, time_t stoptime);
+
+  //----------------------------------------------------------------------------
+  //! Add all the counters of a transfer report
+  //!
+  //! @param report transfer report
+  //----------------------------------------------------------------------------
+  void AddReport(const eos::common::Report& report);
+
+  //----------------------------------------------------------------------------
+  //! Set the total of a counter, used when restoring a dump
+  //!
+  //! @param tag tag id
+  //! @param by_gid if true id is a gid otherwise a uid
+  //! @param id uid or gid
+  //! @param val total value
+  //----------------------------------------------------------------------------
+  void SetTotal(size_t tag, bool by_gid, uint32_t id, unsigned long long val);
+
+  //----------------------------------------------------------------------------
+  //! Get the tags which have at least one uid counter
+  //!
+  //! @param tags filled with pairs of tag name and tag id
+  //----------------------------------------------------------------------------
+  void GetActiveTags(std::vector<std::pair<std::string, size_t>>& tags) const;
+
+  //----------------------------------------------------------------------------
+  //! Get snapshot of the counters of a tag
+  //!
+  //! @param tag tag id
+  //! @param by_gid if true collect gid counters otherwise uid counters
+  //! @param entries filled with the counters of all uids or gids
+  //----------------------------------------------------------------------------
+  void Collect(size_t tag, bool by_gid, std::vector<Entry>& entries) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the sum of the uid counters of a tag
+  //!
+  //! @param tag tag id
+  //!
+  //! @return entry holding the sums, mId is not set
+  //----------------------------------------------------------------------------
+  Entry GetSummary(size_t tag) const;
+
+  //----------------------------------------------------------------------------
+  //! Zero the next bin of all the averages
+  //----------------------------------------------------------------------------
+  void StampZero();
+
+  //----------------------------------------------------------------------------
+  //! Forbid copying or moving IostatCounters objects
+  //----------------------------------------------------------------------------
+  IostatCounters(const IostatCounters&) = delete;
+  IostatCounters& operator=(const IostatCounters&) = delete;
+
+private:
+  //! Number of shards for uids and for gids, must be a power of two
+  static constexpr size_t sNumShards = 16;
+
+  //! Counter of one tag for a uid or gid
+  struct Counter {
+    unsigned long long mTotal = 0; ///< Sum of all the values
+    bool mUsed = false; ///< Counter was touched
+    bool mHasAvg = false; ///< Values were added since start
+    IostatAvg mAvg; ///< Sliding window sums
+  };
+
+  //! Counters of a uid or gid indexed by tag id
+  struct Row {
+    uint32_t mId; ///< uid or gid
+    std::vector<Counter> mCounters; ///< Counters indexed by tag id
+  };
+
+  //! Independently locked part of the uids or gids
+  struct Shard {
+    Shard();
+
+    mutable std::mutex mMutex; ///< Mutex protecting the shard
+    google::dense_hash_map<uint64_t, uint32_t> mSlots; ///< id -> row index
+    std::vector<Row> mRows; ///< Rows of all the ids in the shard
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the shard of an id
+  //----------------------------------------------------------------------------
+  static inline size_t
+  GetShardIndex(uint32_t id)
+  {
+    return (id * 0x9e3779b1u) >> 28;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the counter of a tag for an id, creating it if needed. The shard
+  //! must be locked.
+  //----------------------------------------------------------------------------
+  Counter& GetCounter(Shard& shard, uint32_t id, size_t tag);
+
+  //----------------------------------------------------------------------------
+  //! Add samples to the shards of uids or gids
+  //----------------------------------------------------------------------------
+  void AddToShard(Shard* shards, uint32_t id, const Sample* samples,
+                  size_t nsamples, time_t starttime, time_t stoptime);
+
+  Shard mUidShards[sNumShards]; ///< Shards of the uid counters
+  Shard mGidShards[sNumShards]; ///< Shards of the gid counters
+  mutable std::mutex mTagMutex; ///< Mutex protecting the tag registry
+  std::map<std::string, size_t> mTagIds; ///< Tag name -> tag id
+  std::vector<std::string> mTagNames; ///< Tag names indexed by tag id
+  std::atomic<size_t> mNumTags; ///< Number of interned tags
+};
+
+EOSMGMNAMESPACE_END
+
+#endif // __EOSMGM_IOSTATCOUNTERS_HH__
@@ -26,6 +26,7 @@
 #include "namespace/interface/IFsView.hh"
 #include "namespace/interface/IView.hh"
 #include "namespace/interface/IQuota.hh"
+#include "namespace/MetadataWarmup.hh"
 #include "namespace/ns_quarkdb/BackendClient.hh"
 #include "namespace/ns_quarkdb/Constants.hh"
 #include "common/plugin_manager/PluginManager.hh"
@@ -53,6 +54,7 @@ QdbMaster::QdbMaster(const eos::QdbContactDetails& qdb_info,
 QdbMaster::~QdbMaster()
 {
   mThread.join();
+  mWarmupThread.join();
 }
 
 //------------------------------------------------------------------------------
@@ -189,6 +191,65 @@ QdbMaster::BootNamespace()
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Load the most accessed entries into the namespace caches
+//------------------------------------------------------------------------------
+void
+QdbMaster::WarmupNamespace(ThreadAssistant& assistant) noexcept
+{
+  eos::MetadataWarmup warmup(gOFS->eosView);
+  // Saved by the previous master, possibly on another host
+  int64_t entries = warmup.addList(*mQcl, XrdMgmOfs::sNsWarmupHotKey);
+
+  if (entries < 0) {
+    eos_notice("msg=\"no namespace warm-up list\" key=%s",
+               XrdMgmOfs::sNsWarmupHotKey.c_str());
+  } else {
+    eos_notice("msg=\"loaded namespace warm-up list\" key=%s entries=%lli",
+               XrdMgmOfs::sNsWarmupHotKey.c_str(), (long long) entries);
+  }
+
+  if (!gOFS->mNsWarmupList.empty()) {
+    entries = warmup.addList(gOFS->mNsWarmupList);
+
+    if (entries < 0) {
+      eos_notice("msg=\"no namespace warm-up list\" path=%s",
+                 gOFS->mNsWarmupList.c_str());
+    } else {
+      eos_notice("msg=\"loaded namespace warm-up list\" path=%s entries=%lli",
+                 gOFS->mNsWarmupList.c_str(), (long long) entries);
+    }
+  }
+
+  if (warmup.getPending() == 0) {
+    return;
+  }
+
+  // Stop early if we lose the master role in the meantime
+  assistant.registerCallback([&warmup]() {
+    warmup.stop();
+  });
+
+  eos_notice("msg=\"namespace warm-up starting\" entries=%zu timeout=%llus",
+             warmup.getPending(),
+             (unsigned long long) gOFS->mNsWarmupTimeout);
+  eos::WarmupStats stats = warmup.run(
+  std::chrono::seconds(gOFS->mNsWarmupTimeout),
+  [](const eos::WarmupStats & progress) {
+    eos_static_notice("msg=\"namespace warm-up progress\" loaded=%llu "
+                      "failed=%llu rate=%.0f/s",
+                      (unsigned long long) progress.loaded,
+                      (unsigned long long) progress.failed, progress.rate());
+  });
+  assistant.dropCallbacks();
+  eos_notice("msg=\"namespace warm-up done\" loaded=%llu failed=%llu "
+             "abandoned=%llu skipped=%zu duration=%.02fs rate=%.0f/s",
+             (unsigned long long) stats.loaded,
+             (unsigned long long) stats.failed,
+             (unsigned long long) stats.abandoned, warmup.getPending(),
+             stats.elapsed, stats.rate());
+}
+
 //------------------------------------------------------------------------------
 // Thread supervising the master/slave status
 //------------------------------------------------------------------------------
@@ -300,6 +361,13 @@ QdbMaster::SlaveToMaster()
   stall_thread.detach();
   Quota::LoadNodes();
   EnableNsCaching();
+
+  // Warm up the caches just enabled, in the background so that the lease
+  // keeps being renewed
+  if (gOFS->mNsWarmupTimeout) {
+    mWarmupThread.reset(&QdbMaster::WarmupNamespace, this);
+  }
+
   WFE::MoveFromRBackToQ();
   // Notify all the nodes about the new master identity
   FsView::gFsView.BroadcastMasterId(GetMasterId());
@@ -328,6 +396,7 @@ QdbMaster::MasterToSlave()
     new_master_id.clear();
   }
 
+  mWarmupThread.join();
   DisableNsCaching();
   Access::SetMasterToSlaveRules(new_master_id);
   gOFS->mDrainEngine.Stop();
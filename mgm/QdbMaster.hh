@@ -175,6 +175,15 @@ private:
   //----------------------------------------------------------------------------
   void Supervisor(ThreadAssistant& assistant) noexcept;
 
+  //----------------------------------------------------------------------------
+  //! Load the most accessed entries saved by the previous master and the
+  //! configured warm-up list into the namespace caches, within the configured
+  //! timeout. Started when becoming master, stopped when losing the role.
+  //!
+  //! @param assistant thread executing the method
+  //----------------------------------------------------------------------------
+  void WarmupNamespace(ThreadAssistant& assistant) noexcept;
+
   //----------------------------------------------------------------------------
   //! Try to acquire lease
   //!
@@ -234,6 +243,7 @@ private:
   ///! give the chance to other MGMs to become masters
   std::atomic<time_t> mAcquireDelay;
   AssistedThread mThread; ///< Supervisor thread updating master/slave state
+  AssistedThread mWarmupThread; ///< Thread warming up the namespace caches
   qclient::QClient* mQcl; ///< qclient for talking to the QDB cluster
 };
 
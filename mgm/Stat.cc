@@ -29,6 +29,7 @@
 #include "mq/XrdMqSharedObject.hh"
 #include "mgm/Quota.hh"
 #include "XrdOuc/XrdOucString.hh"
+#include <set>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -36,11 +37,11 @@ EOSMGMNAMESPACE_BEGIN
 void
 Stat::Add(const char* tag, uid_t uid, gid_t gid, unsigned long val)
 {
-  XrdSysMutexHelper lock(mMutex);
-  StatsUid[tag][uid] += val;
-  StatsGid[tag][gid] += val;
-  StatAvgUid[tag][uid].Add(val);
-  StatAvgGid[tag][gid].Add(val);
+  uint32_t tag_id = mCounters.InternTag(tag);
+
+  if (tag_id != StatCounters::sInvalidTag) {
+    mCounters.Add(tag_id, uid, gid, val, (uint32_t) time(0));
+  }
 }
 
 /*----------------------------------------------------------------------------*/
@@ -48,7 +49,7 @@ void
 Stat::AddExt(const char* tag, uid_t uid, gid_t gid, unsigned long nsample,
              const double& avgv, const double& minv, const double& maxv)
 {
-  XrdSysMutexHelper lock(mMutex);
+  XrdSysMutexHelper lock(mExtMutex);
   StatExtUid[tag][uid].Insert(nsample, avgv, minv, maxv);
   StatExtGid[tag][gid].Insert(nsample, avgv, minv, maxv);
 }
@@ -57,55 +58,82 @@ Stat::AddExt(const char* tag, uid_t uid, gid_t gid, unsigned long nsample,
 void
 Stat::AddExec(const char* tag, float exectime)
 {
-  XrdSysMutexHelper lock(mMutex);
-  StatExec[tag].push_back(exectime);
+  uint32_t tag_id = mCounters.InternTag(tag);
 
-  // we average over 100 entries
-  if (StatExec[tag].size() > 100) {
-    StatExec[tag].pop_front();
+  if (tag_id != StatCounters::sInvalidTag) {
+    mCounters.AddExec(tag_id, exectime);
   }
 }
 
 /*----------------------------------------------------------------------------*/
-unsigned long long
-Stat::GetTotal(const char* tag)
+StatCounters::Entry
+Stat::GetTotalEntry(const char* tag)
 {
-  google::sparse_hash_map<uid_t, unsigned long long>::const_iterator it;
-  unsigned long long val = 0;
+  StatCounters::Entry sum {0, false, 0, false, 0, 0, 0, 0, 0};
+  uint32_t tag_id = mCounters.LookupTag(tag);
 
-  if (!StatsUid.count(tag)) {
-    return 0;
+  if (tag_id == StatCounters::sInvalidTag) {
+    return sum;
   }
 
-  for (it = StatsUid[tag].begin(); it != StatsUid[tag].end(); ++it) {
-    val += it->second;
+  std::vector<StatCounters::Entry> entries;
+  mCounters.Collect(entries, (uint32_t) time(0), tag_id);
+
+  for (const auto& entry : entries) {
+    if (!entry.mByGid) {
+      sum.mTotal += entry.mTotal;
+      sum.mAvg5 += entry.mAvg5;
+      sum.mAvg60 += entry.mAvg60;
+      sum.mAvg300 += entry.mAvg300;
+      sum.mAvg3600 += entry.mAvg3600;
+    }
   }
 
-  return val;
+  return sum;
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+unsigned long long
+Stat::GetTotal(const char* tag)
+{
+  return GetTotalEntry(tag).mTotal;
+}
 
+/*----------------------------------------------------------------------------*/
 double
-Stat::GetTotalAvg3600(const char* tag)
+Stat::GetUserAvg5(const char* tag, uid_t uid)
 {
-  google::sparse_hash_map<uid_t, StatAvg>::iterator it;
-  double val = 0;
+  uint32_t tag_id = mCounters.LookupTag(tag);
 
-  if (!StatAvgUid.count(tag)) {
+  if (tag_id == StatCounters::sInvalidTag) {
     return 0;
   }
 
-  for (it = StatAvgUid[tag].begin(); it != StatAvgUid[tag].end(); ++it) {
-    val += it->second.GetAvg3600();
+  return mCounters.GetAvg5(tag_id, false, uid, (uint32_t) time(0));
+}
+
+/*----------------------------------------------------------------------------*/
+double
+Stat::GetGroupAvg5(const char* tag, gid_t gid)
+{
+  uint32_t tag_id = mCounters.LookupTag(tag);
+
+  if (tag_id == StatCounters::sInvalidTag) {
+    return 0;
   }
 
-  return val;
+  return mCounters.GetAvg5(tag_id, true, gid, (uint32_t) time(0));
+}
+
+/*----------------------------------------------------------------------------*/
+double
+Stat::GetTotalAvg3600(const char* tag)
+{
+  return GetTotalEntry(tag).mAvg3600;
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalNExt3600(const char* tag)
@@ -127,7 +155,7 @@ Stat::GetTotalNExt3600(const char* tag)
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalAvgExt3600(const char* tag)
@@ -155,7 +183,7 @@ Stat::GetTotalAvgExt3600(const char* tag)
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalMinExt3600(const char* tag)
@@ -175,7 +203,7 @@ Stat::GetTotalMinExt3600(const char* tag)
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalMaxExt3600(const char* tag)
@@ -195,27 +223,14 @@ Stat::GetTotalMaxExt3600(const char* tag)
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
-
 double
 Stat::GetTotalAvg300(const char* tag)
 {
-  google::sparse_hash_map<uid_t, StatAvg>::iterator it;
-  double val = 0;
-
-  if (!StatAvgUid.count(tag)) {
-    return 0;
-  }
-
-  for (it = StatAvgUid[tag].begin(); it != StatAvgUid[tag].end(); ++it) {
-    val += it->second.GetAvg300();
-  }
-
-  return val;
+  return GetTotalEntry(tag).mAvg300;
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalNExt300(const char* tag)
@@ -237,7 +252,7 @@ Stat::GetTotalNExt300(const char* tag)
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalAvgExt300(const char* tag)
@@ -265,7 +280,7 @@ Stat::GetTotalAvgExt300(const char* tag)
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalMinExt300(const char* tag)
@@ -285,7 +300,7 @@ Stat::GetTotalMinExt300(const char* tag)
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalMaxExt300(const char* tag)
@@ -306,27 +321,14 @@ Stat::GetTotalMaxExt300(const char* tag)
 
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
-
 double
 Stat::GetTotalAvg60(const char* tag)
 {
-  google::sparse_hash_map<uid_t, StatAvg>::iterator it;
-  double val = 0;
-
-  if (!StatAvgUid.count(tag)) {
-    return 0;
-  }
-
-  for (it = StatAvgUid[tag].begin(); it != StatAvgUid[tag].end(); ++it) {
-    val += it->second.GetAvg60();
-  }
-
-  return val;
+  return GetTotalEntry(tag).mAvg60;
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalNExt60(const char* tag)
@@ -348,7 +350,7 @@ Stat::GetTotalNExt60(const char* tag)
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalAvgExt60(const char* tag)
@@ -376,7 +378,7 @@ Stat::GetTotalAvgExt60(const char* tag)
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalMinExt60(const char* tag)
@@ -396,7 +398,7 @@ Stat::GetTotalMinExt60(const char* tag)
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalMaxExt60(const char* tag)
@@ -417,27 +419,14 @@ Stat::GetTotalMaxExt60(const char* tag)
 
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
-
 double
 Stat::GetTotalAvg5(const char* tag)
 {
-  google::sparse_hash_map<uid_t, StatAvg>::iterator it;
-  double val = 0;
-
-  if (!StatAvgUid.count(tag)) {
-    return 0;
-  }
-
-  for (it = StatAvgUid[tag].begin(); it != StatAvgUid[tag].end(); ++it) {
-    val += it->second.GetAvg5();
-  }
-
-  return val;
+  return GetTotalEntry(tag).mAvg5;
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalNExt5(const char* tag)
@@ -459,7 +448,7 @@ Stat::GetTotalNExt5(const char* tag)
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalAvgExt5(const char* tag)
@@ -487,7 +476,7 @@ Stat::GetTotalAvgExt5(const char* tag)
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalMinExt5(const char* tag)
@@ -507,7 +496,7 @@ Stat::GetTotalMinExt5(const char* tag)
 }
 
 /*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
+// warning: you have to lock the ext mutex if directly used
 
 double
 Stat::GetTotalMaxExt5(const char* tag)
@@ -528,100 +517,69 @@ Stat::GetTotalMaxExt5(const char* tag)
 
 
 //------------------------------------------------------------------------------
-// Calculate the average execution time for 'tag'
-// warning: you have to lock the mutex if directly used
+// Compute the average and standard deviation of execution times
 //------------------------------------------------------------------------------
 double
-Stat::GetExec(const char* tag, double& deviation)
+Stat::GetExecAvg(const std::vector<float>& samples, double& deviation)
 {
+  double sum = 0;
   double avg = 0;
   deviation = 0;
 
-  if (StatExec.count(tag)) {
-    std::deque<float>::const_iterator it;
-    double sum = 0;
-    int cnt = 0;
-
-    for (it = StatExec[tag].begin(); it != StatExec[tag].end(); ++it) {
-      cnt++;
-      sum += *it;
-    }
-
-    if (!cnt) {
-      return avg;
-    }
+  if (samples.empty()) {
+    return avg;
+  }
 
-    avg = sum / cnt;
+  for (auto sample : samples) {
+    sum += sample;
+  }
 
-    for (it = StatExec[tag].begin(); it != StatExec[tag].end(); ++it) {
-      deviation += pow((*it - avg), 2);
-    }
+  avg = sum / samples.size();
 
-    deviation = sqrt(deviation / cnt);
+  for (auto sample : samples) {
+    deviation += pow((sample - avg), 2);
   }
 
+  deviation = sqrt(deviation / samples.size());
   return avg;
 }
 
-/*----------------------------------------------------------------------------*/
-// warning: you have to lock the mutex if directly used
-
+//------------------------------------------------------------------------------
+// Calculate the average execution time for 'tag'
+//------------------------------------------------------------------------------
 double
-Stat::GetTotalExec(double& deviation)
+Stat::GetExec(const char* tag, double& deviation)
 {
-  // calculates average execution time for all commands
-  google::sparse_hash_map<std::string, std::deque<float> >::const_iterator ittag;
-  double sum = 0;
-  double avg = 0;
-  deviation = 0;
-  int cnt = 0;
+  std::vector<float> samples;
+  uint32_t tag_id = mCounters.LookupTag(tag);
 
-  for (ittag = StatExec.begin(); ittag != StatExec.end(); ittag++) {
-    std::deque<float>::const_iterator it;
-
-    for (it = ittag->second.begin(); it != ittag->second.end(); it++) {
-      cnt++;
-      sum += *it;
-    }
+  if (tag_id != StatCounters::sInvalidTag) {
+    mCounters.GetExecSamples(tag_id, samples);
   }
 
-  if (cnt) {
-    avg = sum / cnt;
-  }
-
-  for (ittag = StatExec.begin(); ittag != StatExec.end(); ittag++) {
-    std::deque<float>::const_iterator it;
+  return GetExecAvg(samples, deviation);
+}
 
-    for (it = ittag->second.begin(); it != ittag->second.end(); it++) {
-      deviation += pow((*it - avg), 2);
-    }
-  }
+/*----------------------------------------------------------------------------*/
+double
+Stat::GetTotalExec(double& deviation)
+{
+  // calculates average execution time for all commands
+  std::vector<float> samples, all_samples;
 
-  if (cnt) {
-    deviation = sqrt(deviation / cnt);
+  for (uint32_t tag_id = 0; tag_id < mCounters.GetNumTags(); ++tag_id) {
+    mCounters.GetExecSamples(tag_id, samples);
+    all_samples.insert(all_samples.end(), samples.begin(), samples.end());
   }
 
-  return avg;
+  return GetExecAvg(all_samples, deviation);
 }
 
 /*----------------------------------------------------------------------------*/
 void
 Stat::Clear()
 {
-  XrdSysMutexHelper lock(mMutex);
-
-  for (auto ittag = StatsUid.begin(); ittag != StatsUid.end(); ittag++) {
-    StatsUid[ittag->first].clear();
-    StatsUid[ittag->first].resize(1000);
-    StatsGid[ittag->first].clear();
-    StatsGid[ittag->first].resize(1000);
-    StatAvgUid[ittag->first].clear();
-    StatAvgUid[ittag->first].resize(1000);
-    StatAvgGid[ittag->first].clear();
-    StatAvgGid[ittag->first].resize(1000);
-    StatExec[ittag->first].clear();
-    StatExec[ittag->first].resize(1000);
-  }
+  mCounters.Clear();
 }
 
 /*----------------------------------------------------------------------------*/
@@ -629,23 +587,45 @@ void
 Stat::PrintOutTotal(XrdOucString& out, bool details, bool monitoring,
                     bool numerical)
 {
-  mMutex.Lock();
-  std::vector<std::string> tags, tags_ext;
+  std::vector<StatCounters::Entry> entries;
+  mCounters.Collect(entries, (uint32_t) time(0));
+  std::vector<std::string> tag_names;
+
+  for (uint32_t tag_id = 0; tag_id < mCounters.GetNumTags(); ++tag_id) {
+    tag_names.push_back(mCounters.GetTagName(tag_id));
+  }
+
+  // Sum the uid counters of every tag, sorted by tag name
+  std::map<std::string, StatCounters::Entry> totals;
+
+  for (const auto& entry : entries) {
+    if (entry.mByGid || (entry.mTag >= tag_names.size())) {
+      continue;
+    }
+
+    auto it_tot = totals.find(tag_names[entry.mTag]);
+
+    if (it_tot == totals.end()) {
+      totals[tag_names[entry.mTag]] = entry;
+    } else {
+      it_tot->second.mTotal += entry.mTotal;
+      it_tot->second.mAvg5 += entry.mAvg5;
+      it_tot->second.mAvg60 += entry.mAvg60;
+      it_tot->second.mAvg300 += entry.mAvg300;
+      it_tot->second.mAvg3600 += entry.mAvg3600;
+    }
+  }
+
+  mExtMutex.Lock();
+  std::vector<std::string> tags_ext;
   std::vector<std::string>::iterator it;
-  google::sparse_hash_map < std::string,
-         google::sparse_hash_map<uid_t, unsigned long long> >::iterator tit;
   google::sparse_hash_map < std::string,
          google::sparse_hash_map<uid_t, StatExt > >::iterator tit_ext;
 
-  for (tit = StatsUid.begin(); tit != StatsUid.end(); ++tit) {
-    tags.push_back(tit->first);
-  }
-
   for (tit_ext = StatExtUid.begin(); tit_ext != StatExtUid.end(); ++tit_ext) {
     tags_ext.push_back(tit_ext->first);
   }
 
-  std::sort(tags.begin(), tags.end());
   std::sort(tags_ext.begin(), tags_ext.end());
   char outline[1024];
   double avg = 0;
@@ -698,8 +678,8 @@ Stat::PrintOutTotal(XrdOucString& out, bool details, bool monitoring,
     });
   }
 
-  for (it = tags.begin(); it != tags.end(); ++it) {
-    const char* tag = it->c_str();
+  for (auto it_tot = totals.begin(); it_tot != totals.end(); ++it_tot) {
+    const char* tag = it_tot->first.c_str();
     double avg = 0, sig = 0;
     avg = GetExec(tag, sig);
     TableData table_data;
@@ -711,11 +691,11 @@ Stat::PrintOutTotal(XrdOucString& out, bool details, bool monitoring,
     }
 
     table_data.back().push_back(TableCell(tag, format_cmd));
-    table_data.back().push_back(TableCell(GetTotal(tag), format_l));
-    table_data.back().push_back(TableCell(GetTotalAvg5(tag), format_f));
-    table_data.back().push_back(TableCell(GetTotalAvg60(tag), format_f));
-    table_data.back().push_back(TableCell(GetTotalAvg300(tag), format_f));
-    table_data.back().push_back(TableCell(GetTotalAvg3600(tag), format_f));
+    table_data.back().push_back(TableCell(it_tot->second.mTotal, format_l));
+    table_data.back().push_back(TableCell(it_tot->second.mAvg5, format_f));
+    table_data.back().push_back(TableCell(it_tot->second.mAvg60, format_f));
+    table_data.back().push_back(TableCell(it_tot->second.mAvg300, format_f));
+    table_data.back().push_back(TableCell(it_tot->second.mAvg3600, format_f));
 
     if (avg || monitoring) {
       table_data.back().push_back(TableCell(avg, format_f));
@@ -823,60 +803,51 @@ Stat::PrintOutTotal(XrdOucString& out, bool details, bool monitoring,
   out += table_all.GenerateTable(HEADER).c_str();
 
   if (details) {
-    google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, StatAvg > >::iterator
-    tuit;
-    google::sparse_hash_map<std::string, google::sparse_hash_map<gid_t, StatAvg > >::iterator
-    tgit;
     google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, StatExt > >::iterator
     tuit_ext;
     google::sparse_hash_map<std::string, google::sparse_hash_map<gid_t, StatExt > >::iterator
     tgit_ext;
-    mMutex.UnLock();
-    // Don't translate names with a mutex lock
-    std::map<uid_t, std::string> umap;
-    std::map<gid_t, std::string> gmap;
+    std::set<uid_t> uids;
+    std::set<gid_t> gids;
 
-    for (tuit = StatAvgUid.begin(); tuit != StatAvgUid.end(); tuit++) {
-      google::sparse_hash_map<uid_t, StatAvg>::iterator it;
-
-      for (it = tuit->second.begin(); it != tuit->second.end(); ++it) {
-        int terrc = 0;
-        std::string username = eos::common::Mapping::UidToUserName(it->first, terrc);
-        umap[it->first] = username;
+    for (const auto& entry : entries) {
+      if (entry.mUsed) {
+        if (entry.mByGid) {
+          gids.insert(entry.mId);
+        } else {
+          uids.insert(entry.mId);
+        }
       }
     }
 
     for (tuit_ext = StatExtUid.begin(); tuit_ext != StatExtUid.end(); tuit_ext++) {
-      google::sparse_hash_map<uid_t, StatExt>::iterator it;
-
-      for (it = tuit_ext->second.begin(); it != tuit_ext->second.end(); ++it) {
-        int terrc = 0;
-        std::string username = eos::common::Mapping::UidToUserName(it->first, terrc);
-        umap[it->first] = username;
+      for (auto it = tuit_ext->second.begin(); it != tuit_ext->second.end(); ++it) {
+        uids.insert(it->first);
       }
     }
 
-    for (tgit = StatAvgGid.begin(); tgit != StatAvgGid.end(); tgit++) {
-      google::sparse_hash_map<gid_t, StatAvg>::iterator it;
-
-      for (it = tgit->second.begin(); it != tgit->second.end(); ++it) {
-        int terrc = 0;
-        std::string groupname = eos::common::Mapping::GidToGroupName(it->first, terrc);
-        gmap[it->first] = groupname;
+    for (tgit_ext = StatExtGid.begin(); tgit_ext != StatExtGid.end(); tgit_ext++) {
+      for (auto it = tgit_ext->second.begin(); it != tgit_ext->second.end(); ++it) {
+        gids.insert(it->first);
       }
     }
 
-    for (tgit_ext = StatExtGid.begin(); tgit_ext != StatExtGid.end(); tgit_ext++) {
-      google::sparse_hash_map<gid_t, StatExt>::iterator it;
+    mExtMutex.UnLock();
+    // Don't translate names with a mutex lock
+    std::map<uid_t, std::string> umap;
+    std::map<gid_t, std::string> gmap;
 
-      for (it = tgit_ext->second.begin(); it != tgit_ext->second.end(); ++it) {
-        int terrc = 0;
-        std::string groupname = eos::common::Mapping::GidToGroupName(it->first, terrc);
-        gmap[it->first] = groupname;
-      }
+    for (auto uid : uids) {
+      int terrc = 0;
+      umap[uid] = eos::common::Mapping::UidToUserName(uid, terrc);
+    }
+
+    for (auto gid : gids) {
+      int terrc = 0;
+      gmap[gid] = eos::common::Mapping::GidToGroupName(gid, terrc);
     }
 
-    mMutex.Lock();
+    mExtMutex.Lock();
     //! User statistic
     TableFormatterBase table_user;
 
@@ -908,25 +879,25 @@ Stat::PrintOutTotal(XrdOucString& out, bool details, bool monitoring,
         double, double, double, double, double, double, double, double,
         double, double, double, double, double, double>> table_data_ext;
 
-    for (tuit = StatAvgUid.begin(); tuit != StatAvgUid.end(); tuit++) {
-      google::sparse_hash_map<uid_t, StatAvg>::iterator it;
+    for (const auto& entry : entries) {
+      if (!entry.mUsed || entry.mByGid || (entry.mTag >= tag_names.size())) {
+        continue;
+      }
 
-      for (it = tuit->second.begin(); it != tuit->second.end(); ++it) {
-        std::string username;
+      std::string username;
 
-        if (numerical) {
-          username = std::to_string(it->first);
-        } else {
-          username = umap.count(it->first) ? umap[it->first] :
-                     eos::common::StringConversion::GetSizeString(username,
-                         (unsigned long long)it->first);
-        }
-
-        table_data.push_back(std::make_tuple(0, username, tuit->first.c_str(),
-                                             StatsUid[tuit->first.c_str()][it->first],
-                                             it->second.GetAvg5(), it->second.GetAvg60(),
-                                             it->second.GetAvg300(), it->second.GetAvg3600()));
+      if (numerical) {
+        username = std::to_string(entry.mId);
+      } else {
+        username = umap.count(entry.mId) ? umap[entry.mId] :
+                   eos::common::StringConversion::GetSizeString(username,
+                       (unsigned long long) entry.mId);
       }
+
+      table_data.push_back(std::make_tuple(0, username, tag_names[entry.mTag],
+                                           entry.mTotal, entry.mAvg5,
+                                           entry.mAvg60, entry.mAvg300,
+                                           entry.mAvg3600));
     }
 
     for (tuit_ext = StatExtUid.begin(); tuit_ext != StatExtUid.end(); tuit_ext++) {
@@ -981,25 +952,25 @@ Stat::PrintOutTotal(XrdOucString& out, bool details, bool monitoring,
       });
     }
 
-    for (tgit = StatAvgGid.begin(); tgit != StatAvgGid.end(); tgit++) {
-      google::sparse_hash_map<gid_t, StatAvg>::iterator it;
-
-      for (it = tgit->second.begin(); it != tgit->second.end(); ++it) {
-        std::string groupname;
+    for (const auto& entry : entries) {
+      if (!entry.mUsed || !entry.mByGid || (entry.mTag >= tag_names.size())) {
+        continue;
+      }
 
-        if (numerical) {
-          groupname = std::to_string(it->first);
-        } else {
-          groupname = gmap.count(it->first) ? gmap[it->first] :
-                      eos::common::StringConversion::GetSizeString(groupname,
-                          (unsigned long long)it->first);
-        }
+      std::string groupname;
 
-        table_data.push_back(std::make_tuple(1, groupname, tgit->first.c_str(),
-                                             StatsGid[tgit->first.c_str()][it->first],
-                                             it->second.GetAvg5(), it->second.GetAvg60(),
-                                             it->second.GetAvg300(), it->second.GetAvg3600()));
+      if (numerical) {
+        groupname = std::to_string(entry.mId);
+      } else {
+        groupname = gmap.count(entry.mId) ? gmap[entry.mId] :
+                    eos::common::StringConversion::GetSizeString(groupname,
+                        (unsigned long long) entry.mId);
       }
+
+      table_data.push_back(std::make_tuple(1, groupname, tag_names[entry.mTag],
+                                           entry.mTotal, entry.mAvg5,
+                                           entry.mAvg60, entry.mAvg300,
+                                           entry.mAvg3600));
     }
 
     for (tgit_ext = StatExtGid.begin(); tgit_ext != StatExtGid.end(); tgit_ext++) {
@@ -1147,7 +1118,7 @@ Stat::PrintOutTotal(XrdOucString& out, bool details, bool monitoring,
     out += table_group.GenerateTable(HEADER).c_str();
   }
 
-  mMutex.UnLock();
+  mExtMutex.UnLock();
 }
 
 /*----------------------------------------------------------------------------*/
@@ -1232,24 +1203,11 @@ Stat::Circulate()
     l1 = l1tmp;
     l2 = l2tmp;
     l3 = l3tmp;
-    XrdSysMutexHelper lock(mMutex);
+    // The counter rates expire by themselves, only the extended statistics
+    // need their next bin zeroed
+    XrdSysMutexHelper lock(mExtMutex);
 
-    // loop over tags
-    for (auto tit = StatAvgUid.begin(); tit != StatAvgUid.end(); ++tit) {
-      // loop over vids
-      for (auto it = tit->second.begin(); it != tit->second.end(); ++it) {
-        it->second.StampZero();
-      }
-    }
-
-    for (auto tit = StatAvgGid.begin(); tit != StatAvgGid.end(); ++tit) {
-      // loop over vids
-      for (auto it = tit->second.begin(); it != tit->second.end(); ++it) {
-        it->second.StampZero();
-      }
-    }
-
-    for (auto tit_ext = StatExtGid.begin(); tit_ext != StatExtGid.end();
+    for (auto tit_ext = StatExtUid.begin(); tit_ext != StatExtUid.end();
          ++tit_ext) {
       // loop over vids
       for (auto it = tit_ext->second.begin(); it != tit_ext->second.end(); ++it) {
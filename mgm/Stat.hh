@@ -26,128 +26,20 @@
 
 /*----------------------------------------------------------------------------*/
 #include "mgm/Namespace.hh"
+#include "mgm/StatCounters.hh"
 /*----------------------------------------------------------------------------*/
 #include "XrdOuc/XrdOucString.hh"
+#include "XrdSys/XrdSysPthread.hh"
 /*----------------------------------------------------------------------------*/
 #include <google/sparse_hash_map>
 /*----------------------------------------------------------------------------*/
 #include <vector>
 #include <map>
 #include <string>
-#include <deque>
 #include <math.h>
 
 EOSMGMNAMESPACE_BEGIN
 
-class StatAvg
-{
-public:
-  unsigned long avg3600[3600];
-  unsigned long avg300[300];
-  unsigned long avg60[60];
-  unsigned long avg5[5];
-
-  StatAvg()
-  {
-    memset(avg3600, 0, sizeof(avg3600));
-    memset(avg300, 0, sizeof(avg300));
-    memset(avg60, 0, sizeof(avg60));
-    memset(avg5, 0, sizeof(avg5));
-  }
-
-  ~StatAvg() { };
-
-  void
-  Add(unsigned long val)
-  {
-    int64_t time_val = time(0);
-
-    if (time_val < 0) {
-      time_val = 0;
-    }
-
-    unsigned int bin3600 = time_val % 3600;
-    unsigned int bin300 = time_val % 300;
-    unsigned int bin60 = time_val % 60;
-    unsigned int bin5 = time_val % 5;
-    avg3600[(bin3600 + 1) % 3600] = 0;
-    avg3600[bin3600] += val;
-    avg300[(bin300 + 1) % 300] = 0;
-    avg300[bin300] += val;
-    avg60[(bin60 + 1) % 60] = 0;
-    avg60[bin60] += val;
-    avg5[(bin5 + 1) % 5] = 0;
-    avg5[bin5] += val;
-  }
-
-  void
-  StampZero()
-  {
-    int64_t time_val = time(0);
-
-    if (time_val < 0) {
-      time_val = 0;
-    }
-
-    unsigned int bin3600 = time_val % 3600;
-    unsigned int bin300 = time_val % 300;
-    unsigned int bin60 = time_val % 60;
-    unsigned int bin5 = time_val % 5;
-    avg3600[(bin3600 + 1) % 3600] = 0;
-    avg300[(bin300 + 1) % 300] = 0;
-    avg60[(bin60 + 1) % 60] = 0;
-    avg5[(bin5 + 1) % 5] = 0;
-  }
-
-  double
-  GetAvg3600()
-  {
-    double sum = 0;
-
-    for (int i = 0; i < 3600; i++) {
-      sum += avg3600[i];
-    }
-
-    return (sum / 3599);
-  }
-
-  double
-  GetAvg300()
-  {
-    double sum = 0;
-
-    for (int i = 0; i < 300; i++) {
-      sum += avg300[i];
-    }
-
-    return (sum / 299);
-  }
-
-  double
-  GetAvg60()
-  {
-    double sum = 0;
-
-    for (int i = 0; i < 60; i++) {
-      sum += avg60[i];
-    }
-
-    return (sum / 59);
-  }
-
-  double
-  GetAvg5()
-  {
-    double sum = 0;
-
-    for (int i = 0; i < 5; i++) {
-      sum += avg5[i];
-    }
-
-    return (sum / 4);
-  }
-};
-
 class StatExt
 {
 public:
@@ -494,26 +386,17 @@ public:
   gettimeofday(&stop__ID__, &tz__ID__);                                 \
   gOFS->MgmStats.AddExec(__ID__, ((stop__ID__.tv_sec-start__ID__.tv_sec)*1000.0) + ((stop__ID__.tv_usec-start__ID__.tv_usec)/1000.0) );
 
+//------------------------------------------------------------------------------
+//! Class Stat
+//!
+//! MGM operation statistics shown by 'ns stat'. The counters, rates and
+//! execution times are kept by a lock-free StatCounters object so that
+//! accounting an operation never serializes the callers. Only the extended
+//! statistics, filled by the Circulate thread, are protected by a mutex.
+//------------------------------------------------------------------------------
 class Stat
 {
 public:
-  XrdSysMutex mMutex;
-
-  // first is name of value, then the map
-  google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, unsigned long long> >
-  StatsUid;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<gid_t, unsigned long long> >
-  StatsGid;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, StatAvg> >
-  StatAvgUid;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<gid_t, StatAvg> >
-  StatAvgGid;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, StatExt> >
-  StatExtUid;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<gid_t, StatExt> >
-  StatExtGid;
-  google::sparse_hash_map<std::string, std::deque<float> > StatExec;
-
   void Add(const char* tag, uid_t uid, gid_t gid, unsigned long val);
 
   void AddExt(const char* tag, uid_t uid, gid_t gid, unsigned long nsample,
@@ -523,38 +406,57 @@ public:
 
   unsigned long long GetTotal(const char* tag);
 
-  // warning: you have to lock the mutex if directly used
   double GetTotalAvg3600(const char* tag);
+  double GetTotalAvg300(const char* tag);
+  double GetTotalAvg60(const char* tag);
+  double GetTotalAvg5(const char* tag);
+
+  //----------------------------------------------------------------------------
+  //! Get the 5s average rate of a tag for a user
+  //!
+  //! @param tag tag name
+  //! @param uid user id
+  //!
+  //! @return average rate, 0 if nothing was accounted
+  //----------------------------------------------------------------------------
+  double GetUserAvg5(const char* tag, uid_t uid);
+
+  //----------------------------------------------------------------------------
+  //! Get the 5s average rate of a tag for a group
+  //!
+  //! @param tag tag name
+  //! @param gid group id
+  //!
+  //! @return average rate, 0 if nothing was accounted
+  //----------------------------------------------------------------------------
+  double GetGroupAvg5(const char* tag, gid_t gid);
+
+  // warning: you have to lock the ext mutex if directly used
   double GetTotalNExt3600(const char* tag);
   double GetTotalAvgExt3600(const char* tag);
   double GetTotalMinExt3600(const char* tag);
   double GetTotalMaxExt3600(const char* tag);
 
-  // warning: you have to lock the mutex if directly used
-  double GetTotalAvg300(const char* tag);
+  // warning: you have to lock the ext mutex if directly used
   double GetTotalNExt300(const char* tag);
   double GetTotalAvgExt300(const char* tag);
   double GetTotalMinExt300(const char* tag);
   double GetTotalMaxExt300(const char* tag);
 
-  // warning: you have to lock the mutex if directly used
-  double GetTotalAvg60(const char* tag);
+  // warning: you have to lock the ext mutex if directly used
   double GetTotalNExt60(const char* tag);
   double GetTotalAvgExt60(const char* tag);
   double GetTotalMinExt60(const char* tag);
   double GetTotalMaxExt60(const char* tag);
 
-  // warning: you have to lock the mutex if directly used
-  double GetTotalAvg5(const char* tag);
+  // warning: you have to lock the ext mutex if directly used
   double GetTotalNExt5(const char* tag);
   double GetTotalAvgExt5(const char* tag);
   double GetTotalMinExt5(const char* tag);
   double GetTotalMaxExt5(const char* tag);
 
-  // warning: you have to lock the mutex if directly used
   double GetExec(const char* tag, double& deviation);
 
-  // warning: you have to lock the mutex if directly used
   double GetTotalExec(double& deviation);
 
   void Clear();
@@ -565,6 +467,29 @@ public:
   void Circulate();
 
   ~Stat() = default;
+
+private:
+  //----------------------------------------------------------------------------
+  //! Get the sum of the uid counters of a tag
+  //!
+  //! @param tag tag name
+  //!
+  //! @return entry holding the sums
+  //----------------------------------------------------------------------------
+  StatCounters::Entry GetTotalEntry(const char* tag);
+
+  //----------------------------------------------------------------------------
+  //! Compute the average and standard deviation of execution times
+  //----------------------------------------------------------------------------
+  static double GetExecAvg(const std::vector<float>& samples,
+                           double& deviation);
+
+  StatCounters mCounters; ///< Counters, rates and execution times
+  XrdSysMutex mExtMutex; ///< Mutex protecting the extended statistics
+  google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, StatExt> >
+  StatExtUid;
+  google::sparse_hash_map<std::string, google::sparse_hash_map<gid_t, StatExt> >
+  StatExtGid;
 };
 
 EOSMGMNAMESPACE_END
@@ -0,0 +1,540 @@
+//------------------------------------------------------------------------------
+//! @file StatCounters.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/StatCounters.hh"
+
+EOSMGMNAMESPACE_BEGIN
+
+namespace
+{
+//! Initial number of slots of the cell table, must be a power of two
+constexpr size_t sInitialTableSize = 1024;
+//! Mask of the sum stored in the lower half of a bin
+constexpr uint64_t sBinSumMask = 0xffffffffull;
+}
+
+constexpr uint32_t StatRate::sNumBins;
+constexpr uint32_t StatCounters::sMaxTags;
+constexpr uint32_t StatCounters::sInvalidTag;
+constexpr uint32_t StatCounters::sExecSamples;
+constexpr uint32_t StatCounters::sTagSlots;
+
+//------------------------------------------------------------------------------
+// StatRate constructor
+//------------------------------------------------------------------------------
+StatRate::StatRate()
+{
+  Reset();
+}
+
+//------------------------------------------------------------------------------
+// Drop all the values
+//------------------------------------------------------------------------------
+void
+StatRate::Reset()
+{
+  for (uint32_t i = 0; i < sNumBins; ++i) {
+    mSecBins[i].store(0, std::memory_order_relaxed);
+    mMinBins[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Add value to the bin of a period
+//------------------------------------------------------------------------------
+void
+StatRate::AddToBin(std::atomic<uint64_t>& bin, uint32_t period,
+                   unsigned long val)
+{
+  uint64_t old_val = bin.load(std::memory_order_relaxed);
+
+  while (true) {
+    uint32_t old_period = (uint32_t)(old_val >> 32);
+
+    // The bin was already taken over by a later period, drop the value
+    if (old_period > period) {
+      return;
+    }
+
+    uint64_t sum = (old_period == period) ? (old_val & sBinSumMask) : 0;
+    sum += val;
+
+    if (sum > sBinSumMask) {
+      sum = sBinSumMask;
+    }
+
+    uint64_t new_val = ((uint64_t) period << 32) | sum;
+
+    if ((new_val == old_val) ||
+        bin.compare_exchange_weak(old_val, new_val, std::memory_order_relaxed)) {
+      return;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Add value
+//------------------------------------------------------------------------------
+void
+StatRate::Add(unsigned long val, uint32_t now)
+{
+  AddToBin(mSecBins[now % sNumBins], now, val);
+  AddToBin(mMinBins[(now / 60) % sNumBins], now / 60, val);
+}
+
+//------------------------------------------------------------------------------
+// Sum the bins of a ring covering [now - window + 1, now]
+//------------------------------------------------------------------------------
+double
+StatRate::SumBins(const std::atomic<uint64_t>* bins, uint32_t width,
+                  uint32_t window, uint32_t now)
+{
+  uint32_t start = (now >= window) ? (now - window + 1) : 0;
+  uint32_t first = start / width;
+  uint32_t last = now / width;
+  double sum = 0;
+
+  for (uint32_t period = first; period <= last; ++period) {
+    uint64_t val = bins[period % sNumBins].load(std::memory_order_relaxed);
+
+    if ((uint32_t)(val >> 32) != period) {
+      continue;
+    }
+
+    double bin_sum = (double)(val & sBinSumMask);
+
+    // Only the part of the oldest bin falling inside the window counts
+    if ((period == first) && (start % width)) {
+      bin_sum = bin_sum * (width - start % width) / width;
+    }
+
+    sum += bin_sum;
+  }
+
+  return sum;
+}
+
+//------------------------------------------------------------------------------
+// Get the sum of the values added during the last seconds
+//------------------------------------------------------------------------------
+double
+StatRate::GetSum(uint32_t window, uint32_t now) const
+{
+  if (window < sNumBins) {
+    return SumBins(mSecBins, 1, window, now);
+  }
+
+  // Keep one spare bin for the partially covered oldest minute
+  if (window > (sNumBins - 2) * 60) {
+    window = (sNumBins - 2) * 60;
+  }
+
+  return SumBins(mMinBins, 60, window, now);
+}
+
+//------------------------------------------------------------------------------
+// Table constructor
+//------------------------------------------------------------------------------
+StatCounters::Table::Table(size_t size):
+  mMask(size - 1), mSlots(new std::atomic<Cell*>[size])
+{
+  for (size_t i = 0; i < size; ++i) {
+    mSlots[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Table destructor
+//------------------------------------------------------------------------------
+StatCounters::Table::~Table()
+{
+  delete[] mSlots;
+}
+
+//------------------------------------------------------------------------------
+// ExecRing constructor
+//------------------------------------------------------------------------------
+StatCounters::ExecRing::ExecRing():
+  mCount(0)
+{
+  for (uint32_t i = 0; i < sExecSamples; ++i) {
+    mSamples[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+StatCounters::StatCounters():
+  mNumTags(0), mTable(new Table(sInitialTableSize))
+{
+  for (uint32_t i = 0; i < sTagSlots; ++i) {
+    mTagSlots[i].store(nullptr, std::memory_order_relaxed);
+  }
+
+  for (uint32_t i = 0; i < sMaxTags; ++i) {
+    mTagsById[i].store(nullptr, std::memory_order_relaxed);
+    mExec[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+StatCounters::~StatCounters()
+{
+  for (uint32_t i = 0; i < sMaxTags; ++i) {
+    delete mTagsById[i].load();
+    delete mExec[i].load();
+  }
+
+  for (auto* cell : mCells) {
+    delete cell;
+  }
+
+  for (auto* table : mRetiredTables) {
+    delete table;
+  }
+
+  delete mTable.load();
+}
+
+//------------------------------------------------------------------------------
+// Hash a tag name - FNV-1a
+//------------------------------------------------------------------------------
+uint64_t
+StatCounters::HashTag(const char* tag)
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+
+  for (const unsigned char* ptr = (const unsigned char*) tag; *ptr; ++ptr) {
+    hash ^= *ptr;
+    hash *= 0x100000001b3ull;
+  }
+
+  return hash;
+}
+
+//------------------------------------------------------------------------------
+// Find the entry of a tag in the tag table
+//------------------------------------------------------------------------------
+const StatCounters::TagEntry*
+StatCounters::FindTag(const char* tag, uint64_t hash) const
+{
+  size_t slot = hash & (sTagSlots - 1);
+
+  for (uint32_t probe = 0; probe < sTagSlots; ++probe) {
+    const TagEntry* entry = mTagSlots[slot].load(std::memory_order_acquire);
+
+    if (entry == nullptr) {
+      return nullptr;
+    }
+
+    if ((entry->mHash == hash) && (entry->mName == tag)) {
+      return entry;
+    }
+
+    slot = (slot + 1) & (sTagSlots - 1);
+  }
+
+  return nullptr;
+}
+
+//------------------------------------------------------------------------------
+// Get the id of a tag, registering it if needed
+//------------------------------------------------------------------------------
+uint32_t
+StatCounters::InternTag(const char* tag)
+{
+  uint64_t hash = HashTag(tag);
+  const TagEntry* entry = FindTag(tag, hash);
+
+  if (entry) {
+    return entry->mId;
+  }
+
+  std::lock_guard<std::mutex> lock(mTagMutex);
+  entry = FindTag(tag, hash);
+
+  if (entry) {
+    return entry->mId;
+  }
+
+  uint32_t id = mNumTags.load(std::memory_order_relaxed);
+
+  if (id >= sMaxTags) {
+    return sInvalidTag;
+  }
+
+  TagEntry* new_entry = new TagEntry{tag, hash, id};
+  mTagsById[id].store(new_entry, std::memory_order_release);
+  size_t slot = hash & (sTagSlots - 1);
+
+  while (mTagSlots[slot].load(std::memory_order_relaxed)) {
+    slot = (slot + 1) & (sTagSlots - 1);
+  }
+
+  mTagSlots[slot].store(new_entry, std::memory_order_release);
+  mNumTags.store(id + 1, std::memory_order_release);
+  return id;
+}
+
+//------------------------------------------------------------------------------
+// Get the id of an already registered tag
+//------------------------------------------------------------------------------
+uint32_t
+StatCounters::LookupTag(const char* tag) const
+{
+  const TagEntry* entry = FindTag(tag, HashTag(tag));
+  return (entry ? entry->mId : sInvalidTag);
+}
+
+//------------------------------------------------------------------------------
+// Get the name of a tag
+//------------------------------------------------------------------------------
+std::string
+StatCounters::GetTagName(uint32_t tag) const
+{
+  if (tag >= GetNumTags()) {
+    return std::string();
+  }
+
+  return mTagsById[tag].load(std::memory_order_acquire)->mName;
+}
+
+//------------------------------------------------------------------------------
+// Find the cell of a key
+//------------------------------------------------------------------------------
+StatCounters::Cell*
+StatCounters::FindCell(uint64_t key) const
+{
+  const Table* table = mTable.load(std::memory_order_acquire);
+  size_t slot = GetSlot(key, table->mMask);
+
+  while (true) {
+    Cell* cell = table->mSlots[slot].load(std::memory_order_acquire);
+
+    if ((cell == nullptr) || (cell->mKey == key)) {
+      return cell;
+    }
+
+    slot = (slot + 1) & table->mMask;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Insert a cell in a table which has a free slot for it
+//------------------------------------------------------------------------------
+void
+StatCounters::InsertCell(Table* table, Cell* cell)
+{
+  size_t slot = GetSlot(cell->mKey, table->mMask);
+
+  while (table->mSlots[slot].load(std::memory_order_relaxed)) {
+    slot = (slot + 1) & table->mMask;
+  }
+
+  table->mSlots[slot].store(cell, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+// Find the cell of a key, creating it if needed
+//------------------------------------------------------------------------------
+StatCounters::Cell*
+StatCounters::GetCell(uint64_t key)
+{
+  Cell* cell = FindCell(key);
+
+  if (cell) {
+    return cell;
+  }
+
+  std::lock_guard<std::mutex> lock(mCellMutex);
+  cell = FindCell(key);
+
+  if (cell) {
+    return cell;
+  }
+
+  cell = new Cell(key);
+  mCells.push_back(cell);
+  Table* table = mTable.load(std::memory_order_relaxed);
+
+  // Keep the load factor below 1/2, readers still probing the old table
+  // find the cells which existed when they started
+  if (2 * mCells.size() > table->mMask + 1) {
+    Table* new_table = new Table(2 * (table->mMask + 1));
+
+    for (auto* existing : mCells) {
+      InsertCell(new_table, existing);
+    }
+
+    mTable.store(new_table, std::memory_order_release);
+    mRetiredTables.push_back(table);
+  } else {
+    InsertCell(table, cell);
+  }
+
+  return cell;
+}
+
+//------------------------------------------------------------------------------
+// Add value for a uid and gid
+//------------------------------------------------------------------------------
+void
+StatCounters::Add(uint32_t tag, uid_t uid, gid_t gid, unsigned long val,
+                  uint32_t now)
+{
+  for (auto* cell : {
+         GetCell(MakeKey(tag, false, uid)), GetCell(MakeKey(tag, true, gid))
+       }) {
+    cell->mTotal.fetch_add(val, std::memory_order_relaxed);
+
+    if (!cell->mUsed.load(std::memory_order_relaxed)) {
+      cell->mUsed.store(true, std::memory_order_relaxed);
+    }
+
+    cell->mRate.Add(val, now);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Add an execution time sample
+//------------------------------------------------------------------------------
+void
+StatCounters::AddExec(uint32_t tag, float exectime)
+{
+  ExecRing* ring = mExec[tag].load(std::memory_order_acquire);
+
+  if (ring == nullptr) {
+    ExecRing* new_ring = new ExecRing();
+
+    if (mExec[tag].compare_exchange_strong(ring, new_ring,
+                                           std::memory_order_acq_rel)) {
+      ring = new_ring;
+    } else {
+      delete new_ring;
+    }
+  }
+
+  uint64_t index = ring->mCount.fetch_add(1, std::memory_order_relaxed);
+  ring->mSamples[index % sExecSamples].store(exectime,
+      std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+// Get the 5s average rate of a tag for a uid or gid
+//------------------------------------------------------------------------------
+double
+StatCounters::GetAvg5(uint32_t tag, bool by_gid, uint32_t id,
+                      uint32_t now) const
+{
+  const Cell* cell = FindCell(MakeKey(tag, by_gid, id));
+  return (cell ? cell->mRate.GetAvg5(now) : 0);
+}
+
+//------------------------------------------------------------------------------
+// Get a snapshot of the counters
+//------------------------------------------------------------------------------
+void
+StatCounters::Collect(std::vector<Entry>& entries, uint32_t now,
+                      uint32_t tag) const
+{
+  const Table* table = mTable.load(std::memory_order_acquire);
+
+  for (size_t i = 0; i <= table->mMask; ++i) {
+    const Cell* cell = table->mSlots[i].load(std::memory_order_acquire);
+
+    if ((cell == nullptr) ||
+        ((tag != sInvalidTag) && ((cell->mKey >> 33) != tag))) {
+      continue;
+    }
+
+    Entry entry;
+    entry.mTag = (uint32_t)(cell->mKey >> 33);
+    entry.mByGid = (cell->mKey >> 32) & 1;
+    entry.mId = (uint32_t) cell->mKey;
+    entry.mUsed = cell->mUsed.load(std::memory_order_relaxed);
+    entry.mTotal = cell->mTotal.load(std::memory_order_relaxed);
+    entry.mAvg5 = cell->mRate.GetAvg5(now);
+    entry.mAvg60 = cell->mRate.GetAvg60(now);
+    entry.mAvg300 = cell->mRate.GetAvg300(now);
+    entry.mAvg3600 = cell->mRate.GetAvg3600(now);
+    entries.push_back(entry);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the execution time samples of a tag
+//------------------------------------------------------------------------------
+void
+StatCounters::GetExecSamples(uint32_t tag, std::vector<float>& samples) const
+{
+  samples.clear();
+
+  if (tag >= sMaxTags) {
+    return;
+  }
+
+  const ExecRing* ring = mExec[tag].load(std::memory_order_acquire);
+
+  if (ring == nullptr) {
+    return;
+  }
+
+  uint64_t count = ring->mCount.load(std::memory_order_relaxed);
+
+  if (count > sExecSamples) {
+    count = sExecSamples;
+  }
+
+  for (uint64_t i = 0; i < count; ++i) {
+    samples.push_back(ring->mSamples[i].load(std::memory_order_relaxed));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Reset all the counters and execution times
+//------------------------------------------------------------------------------
+void
+StatCounters::Clear()
+{
+  {
+    std::lock_guard<std::mutex> lock(mCellMutex);
+
+    for (auto* cell : mCells) {
+      cell->mTotal.store(0, std::memory_order_relaxed);
+      cell->mUsed.store(false, std::memory_order_relaxed);
+      cell->mRate.Reset();
+    }
+  }
+
+  for (uint32_t i = 0; i < sMaxTags; ++i) {
+    ExecRing* ring = mExec[i].load(std::memory_order_acquire);
+
+    if (ring) {
+      ring->mCount.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,365 @@
+//------------------------------------------------------------------------------
+//! @file StatCounters.hh
+//! @brief Lock-free per uid/gid operation counters used by the MGM statistics
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSMGM_STATCOUNTERS_HH__
+#define __EOSMGM_STATCOUNTERS_HH__
+
+#include "mgm/Namespace.hh"
+#include <sys/types.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class StatRate
+//!
+//! Sliding window sums of a counter over the last 5s, 1min, 5min and 1h. The
+//! values are kept in two rings of bins, one of 1s bins and one of 1min bins.
+//! Every bin carries the period it belongs to in its upper half so stale bins
+//! are recognised and overwritten when the ring wraps, no periodic zeroing is
+//! needed. Updates are lock-free and the whole object takes 1 KB instead of
+//! the ~32 KB of one slot per second of the last hour.
+//------------------------------------------------------------------------------
+class StatRate
+{
+public:
+  static constexpr uint32_t sNumBins = 64; ///< Bins per ring
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  StatRate();
+
+  //----------------------------------------------------------------------------
+  //! Add value
+  //!
+  //! @param val value
+  //! @param now current time in seconds
+  //----------------------------------------------------------------------------
+  void Add(unsigned long val, uint32_t now);
+
+  //----------------------------------------------------------------------------
+  //! Get the sum of the values added during the last seconds
+  //!
+  //! @param window length of the window in seconds, at most 59 minutes
+  //! @param now current time in seconds
+  //!
+  //! @return sum of the values, the oldest 1min bin is weighted by its part
+  //!         falling inside the window
+  //----------------------------------------------------------------------------
+  double GetSum(uint32_t window, uint32_t now) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the average rates with the same normalisation as the former per
+  //! second arrays i.e. sum over the last N-1 seconds divided by N-1
+  //----------------------------------------------------------------------------
+  inline double GetAvg5(uint32_t now) const
+  {
+    return GetSum(4, now) / 4;
+  }
+
+  inline double GetAvg60(uint32_t now) const
+  {
+    return GetSum(59, now) / 59;
+  }
+
+  inline double GetAvg300(uint32_t now) const
+  {
+    return GetSum(299, now) / 299;
+  }
+
+  inline double GetAvg3600(uint32_t now) const
+  {
+    return GetSum(3599, now) / 3599;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop all the values
+  //----------------------------------------------------------------------------
+  void Reset();
+
+private:
+  //----------------------------------------------------------------------------
+  //! Add value to the bin of a period, the bin is taken over if it holds an
+  //! older period
+  //----------------------------------------------------------------------------
+  static void AddToBin(std::atomic<uint64_t>& bin, uint32_t period,
+                       unsigned long val);
+
+  //----------------------------------------------------------------------------
+  //! Sum the bins of a ring covering [now - window + 1, now]
+  //!
+  //! @param bins ring of bins
+  //! @param width width of a bin in seconds
+  //! @param window length of the window in seconds
+  //! @param now current time in seconds
+  //----------------------------------------------------------------------------
+  static double SumBins(const std::atomic<uint64_t>* bins, uint32_t width,
+                        uint32_t window, uint32_t now);
+
+  std::atomic<uint64_t> mSecBins[sNumBins]; ///< 1s bins (period << 32 | sum)
+  std::atomic<uint64_t> mMinBins[sNumBins]; ///< 1min bins (period << 32 | sum)
+};
+
+//------------------------------------------------------------------------------
+//! Class StatCounters
+//!
+//! Counters of the MGM operations per tag and uid/gid. Tag names are interned
+//! to small ids through an open addressing table which is read without
+//! locking, the lock is only taken the first time a tag is seen. Every
+//! (tag, uid) and (tag, gid) pair owns a cell holding its total and its
+//! StatRate. Cells are found through a hash table which readers access
+//! without locking. It is only locked to insert a new cell, which may grow
+//! the table. Cells and replaced tables are never freed before the
+//! destruction of the object, so a pointer obtained by a reader always stays
+//! valid. The execution times are kept in a lock-free ring of the last
+//! samples of every tag.
+//------------------------------------------------------------------------------
+class StatCounters
+{
+public:
+  static constexpr uint32_t sMaxTags = 2048; ///< Maximum number of tags
+  static constexpr uint32_t sInvalidTag = 0xffffffff; ///< Unknown tag id
+  static constexpr uint32_t sExecSamples = 100; ///< Exec samples per tag
+
+  //! Snapshot of the counter of a tag for one uid or gid
+  struct Entry {
+    uint32_t mTag; ///< Tag id
+    bool mByGid; ///< Entry is for a gid
+    uint32_t mId; ///< uid or gid
+    bool mUsed; ///< Values were added since the last reset
+    unsigned long long mTotal; ///< Sum of all the values
+    double mAvg5; ///< Average rate over 5s
+    double mAvg60; ///< Average rate over 1min
+    double mAvg300; ///< Average rate over 5min
+    double mAvg3600; ///< Average rate over 1h
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  StatCounters();
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~StatCounters();
+
+  //----------------------------------------------------------------------------
+  //! Get the id of a tag, registering it if needed
+  //!
+  //! @param tag tag name
+  //!
+  //! @return tag id or sInvalidTag if the registry is full
+  //----------------------------------------------------------------------------
+  uint32_t InternTag(const char* tag);
+
+  //----------------------------------------------------------------------------
+  //! Get the id of an already registered tag
+  //!
+  //! @param tag tag name
+  //!
+  //! @return tag id or sInvalidTag if the tag is unknown
+  //----------------------------------------------------------------------------
+  uint32_t LookupTag(const char* tag) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the name of a tag
+  //!
+  //! @param tag tag id
+  //!
+  //! @return tag name or empty string if id is unknown
+  //----------------------------------------------------------------------------
+  std::string GetTagName(uint32_t tag) const;
+
+  //----------------------------------------------------------------------------
+  //! Add value for a uid and gid
+  //!
+  //! @param tag tag id
+  //! @param uid user id
+  //! @param gid group id
+  //! @param val value
+  //! @param now current time in seconds
+  //----------------------------------------------------------------------------
+  void Add(uint32_t tag, uid_t uid, gid_t gid, unsigned long val, uint32_t now);
+
+  //----------------------------------------------------------------------------
+  //! Add an execution time sample
+  //!
+  //! @param tag tag id
+  //! @param exectime execution time in milliseconds
+  //----------------------------------------------------------------------------
+  void AddExec(uint32_t tag, float exectime);
+
+  //----------------------------------------------------------------------------
+  //! Get the 5s average rate of a tag for a uid or gid
+  //!
+  //! @param tag tag id
+  //! @param by_gid if true id is a gid otherwise a uid
+  //! @param id uid or gid
+  //! @param now current time in seconds
+  //!
+  //! @return average rate, 0 if nothing was accounted
+  //----------------------------------------------------------------------------
+  double GetAvg5(uint32_t tag, bool by_gid, uint32_t id, uint32_t now) const;
+
+  //----------------------------------------------------------------------------
+  //! Get a snapshot of the counters, in no particular order
+  //!
+  //! @param entries filled with one entry per (tag, uid) and (tag, gid)
+  //! @param now current time in seconds
+  //! @param tag if not sInvalidTag only the counters of this tag are taken
+  //----------------------------------------------------------------------------
+  void Collect(std::vector<Entry>& entries, uint32_t now,
+               uint32_t tag = sInvalidTag) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the execution time samples of a tag
+  //!
+  //! @param tag tag id
+  //! @param samples filled with up to sExecSamples latest samples
+  //----------------------------------------------------------------------------
+  void GetExecSamples(uint32_t tag, std::vector<float>& samples) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the number of interned tags
+  //----------------------------------------------------------------------------
+  inline uint32_t GetNumTags() const
+  {
+    return mNumTags.load(std::memory_order_acquire);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Reset all the counters and execution times, the tags stay registered
+  //----------------------------------------------------------------------------
+  void Clear();
+
+  //----------------------------------------------------------------------------
+  //! Forbid copying or moving StatCounters objects
+  //----------------------------------------------------------------------------
+  StatCounters(const StatCounters&) = delete;
+  StatCounters& operator=(const StatCounters&) = delete;
+
+private:
+  static constexpr uint32_t sTagSlots = 2 * sMaxTags; ///< Tag table size
+
+  //! Interned tag
+  struct TagEntry {
+    std::string mName; ///< Tag name
+    uint64_t mHash; ///< Hash of the name
+    uint32_t mId; ///< Tag id
+  };
+
+  //! Counter of a tag for a uid or gid
+  struct Cell {
+    explicit Cell(uint64_t key): mKey(key), mTotal(0), mUsed(false) {}
+
+    const uint64_t mKey; ///< Tag, kind and id, see MakeKey
+    std::atomic<unsigned long long> mTotal; ///< Sum of all the values
+    std::atomic<bool> mUsed; ///< Values were added since the last reset
+    StatRate mRate; ///< Sliding window sums
+  };
+
+  //! Open addressing table of cells
+  struct Table {
+    explicit Table(size_t size);
+    ~Table();
+
+    const size_t mMask; ///< Size of the table minus one
+    std::atomic<Cell*>* mSlots; ///< Slots of the table
+  };
+
+  //! Ring of the latest execution times of a tag
+  struct ExecRing {
+    ExecRing();
+
+    std::atomic<uint64_t> mCount; ///< Number of samples ever added
+    std::atomic<float> mSamples[sExecSamples]; ///< Latest samples
+  };
+
+  //----------------------------------------------------------------------------
+  //! Hash a tag name
+  //----------------------------------------------------------------------------
+  static uint64_t HashTag(const char* tag);
+
+  //----------------------------------------------------------------------------
+  //! Build the key of a cell
+  //----------------------------------------------------------------------------
+  static inline uint64_t
+  MakeKey(uint32_t tag, bool by_gid, uint32_t id)
+  {
+    return ((uint64_t) tag << 33) | ((uint64_t) by_gid << 32) | id;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the slot index of a key in a table
+  //----------------------------------------------------------------------------
+  static inline size_t
+  GetSlot(uint64_t key, size_t mask)
+  {
+    key ^= key >> 29;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 32;
+    return key & mask;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Find the cell of a key
+  //!
+  //! @return cell or nullptr if not present
+  //----------------------------------------------------------------------------
+  Cell* FindCell(uint64_t key) const;
+
+  //----------------------------------------------------------------------------
+  //! Find the cell of a key, creating it if needed
+  //----------------------------------------------------------------------------
+  Cell* GetCell(uint64_t key);
+
+  //----------------------------------------------------------------------------
+  //! Insert a cell in a table which has a free slot for it
+  //----------------------------------------------------------------------------
+  static void InsertCell(Table* table, Cell* cell);
+
+  //----------------------------------------------------------------------------
+  //! Find the entry of a tag in the tag table
+  //----------------------------------------------------------------------------
+  const TagEntry* FindTag(const char* tag, uint64_t hash) const;
+
+  std::atomic<TagEntry*> mTagSlots[sTagSlots]; ///< Tag table by name hash
+  std::atomic<TagEntry*> mTagsById[sMaxTags]; ///< Tags indexed by id
+  std::atomic<uint32_t> mNumTags; ///< Number of interned tags
+  std::mutex mTagMutex; ///< Mutex serializing the tag registrations
+  std::atomic<ExecRing*> mExec[sMaxTags]; ///< Exec samples indexed by tag id
+  std::atomic<Table*> mTable; ///< Current table of cells
+  std::mutex mCellMutex; ///< Mutex serializing the cell insertions
+  std::vector<Table*> mRetiredTables; ///< Tables replaced by a bigger one
+  std::vector<Cell*> mCells; ///< All cells, owned by the object
+};
+
+EOSMGMNAMESPACE_END
+
+#endif // __EOSMGM_STATCOUNTERS_HH__
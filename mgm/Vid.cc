@@ -36,7 +36,7 @@ EOSMGMNAMESPACE_BEGIN
 bool
 Vid::Set(const char* value, bool storeConfig)
 {
-  eos::common::RWMutexWriteLock lock(eos::common::Mapping::gMapMutex);
+  eos::common::Mapping::RulesWriteLock lock;
   XrdOucEnv env(value);
   XrdOucString skey = env.Get("mgm.vid.key");
   XrdOucString svalue = value;
@@ -317,7 +317,7 @@ Vid::Rm(XrdOucEnv& env,
         XrdOucString& stdErr,
         bool storeConfig)
 {
-  eos::common::RWMutexWriteLock lock(eos::common::Mapping::gMapMutex);
+  eos::common::Mapping::RulesWriteLock lock;
   XrdOucString skey = env.Get("mgm.vid.key");
   XrdOucString vidcmd = env.Get("mgm.vid.cmd");
   int envlen = 0;
@@ -302,16 +302,9 @@ VstMessaging::PublishVst()
            false);
     }
   }
-  {
-    XrdSysMutexHelper aLock(eos::common::Mapping::ActiveLock);
-    eos::common::Mapping::ActiveExpire(300, true);
-    clients = eos::common::Mapping::ActiveTidents.size();
-  }
-  {
-    XrdSysMutexHelper sLock(gOFS->MgmStats.mMutex);
-    lock_r = (unsigned long long) gOFS->MgmStats.GetTotalAvg300("NsLockR");
-    lock_w = (unsigned long long) gOFS->MgmStats.GetTotalAvg300("NsLockW");
-  }
+  clients = eos::common::Mapping::ActiveTidents.Count(300);
+  lock_r = (unsigned long long) gOFS->MgmStats.GetTotalAvg300("NsLockR");
+  lock_w = (unsigned long long) gOFS->MgmStats.GetTotalAvg300("NsLockW");
   unsigned long long files = 0;
   unsigned long long container = 0;
   {
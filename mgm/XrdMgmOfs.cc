@@ -71,6 +71,8 @@
 #include "mgm/XrdMgmOfs/fsctl/CommitHelper.hh"
 #include "namespace/interface/IFsView.hh"
 #include "namespace/Prefetcher.hh"
+#include "namespace/MetadataWarmup.hh"
+#include "namespace/ns_quarkdb/BackendClient.hh"
 #include "namespace/utils/Stat.hh"
 #include "namespace/utils/Checksum.hh"
 #include "namespace/utils/Etag.hh"
@@ -103,6 +105,7 @@ XrdSysError* XrdMgmOfs::eDest;
 XrdOucTrace gMgmOfsTrace(&gMgmOfsEroute);
 const char* XrdMgmOfs::gNameSpaceState[] = {"down", "booting", "booted", "failed", "compacting"};
 XrdMgmOfs* gOFS = 0;
+const std::string XrdMgmOfs::sNsWarmupHotKey {"eos-nswarmup-hot"};
 
 // Set the version information
 XrdVERSIONINFO(XrdSfsGetFileSystem, MgmOfs);
@@ -183,7 +186,7 @@ XrdMgmOfs::XrdMgmOfs(XrdSysError* ep):
   WFEPtr(new eos::mgm::WFE()), WFEd(*WFEPtr), UTF8(false), mFstGwHost(""),
   mFstGwPort(0), mQdbCluster(""), mHttpdPort(8000),
   mFusexPort(1100),
-  mTapeAwareGcDefaultSpaceEnable(false),
+  mTapeAwareGcDefaultSpaceEnable(false), mNsWarmupTimeout(0),
   mJeMallocHandler(new eos::common::JeMallocHandler()),
   mDoneOrderlyShutdown(false)
 {
@@ -264,6 +267,12 @@ XrdMgmOfs::OrderlyShutdown()
   mDrainEngine.Stop();
   eos_warning("%s", "msg=\"stopping geotree engine updater\"");
   gGeoTreeEngine.StopUpdater();
+  eos_warning("%s", "msg=\"stopping the view aggregate updater\"");
+  FsView::gFsView.StopAggregateUpdater();
+
+  if (IoStats && (mInitialized == kBooted)) {
+    SaveNsWarmupHotList(*IoStats);
+  }
 
   if (IoStats) {
     eos_warning("%s", "msg=\"stopping and deleting IoStats\"");
@@ -424,6 +433,36 @@ XrdMgmOfs::OrderlyShutdown()
               (end_ts - start_ts).count());
 }
 
+//------------------------------------------------------------------------------
+// Save the most accessed namespace entries in QuarkDB
+//------------------------------------------------------------------------------
+void
+XrdMgmOfs::SaveNsWarmupHotList(Iostat& iostat)
+{
+  if (!NsInQDB || !mNsWarmupTimeout || !mMaster || !mMaster->IsMaster()) {
+    return;
+  }
+
+  std::vector<std::string> hot_paths;
+  iostat.GetPopularPaths(100000, hot_paths);
+
+  // Keep the previous list if this MGM did not see any traffic
+  if (hot_paths.empty()) {
+    return;
+  }
+
+  qclient::QClient* qcl = eos::BackendClient::getInstance(mQdbContactDetails,
+                          "MGM_HA");
+
+  if (!eos::MetadataWarmup::saveList(*qcl, sNsWarmupHotKey, hot_paths)) {
+    eos_err("msg=\"failed to save namespace warm-up list\" key=%s",
+            sNsWarmupHotKey.c_str());
+  } else {
+    eos_info("msg=\"saved namespace warm-up list\" key=%s entries=%zu",
+             sNsWarmupHotKey.c_str(), hot_paths.size());
+  }
+}
+
 //------------------------------------------------------------------------------
 // This is just kept to be compatible with standard OFS plugins, but it is not
 // used for the moment.
@@ -43,9 +43,15 @@
  * to be used:
  * - eos::common::RWMutexXXXLock lock(FsView::gFsView.ViewMutex)  : lock 1
  * - eos::common::RWMutexXXXLock lock(gOFS->eosViewRWMutex)       : lock 2
+ * - eos::MDLocker of the entries in gOFS->eosMdLocks             : lock 2b
  * - eos::common::RWMutexXXXLock lock(Quota::pMapMutex)           : lock 3
  * The XXX is either Read or Write depending what has to be done on the
- * objects they are protecting. The first mutex is the file system view object
+ * objects they are protecting. Namespace mutations take lock 2 for reading
+ * and lock the containers and files they modify with one MDLocker, so
+ * mutations in disjoint subtrees run in parallel. Lock 2 is only taken for
+ * writing by structural operations which need the whole namespace frozen,
+ * and by every mutation of the in-memory namespace whose services are not
+ * thread-safe (see eos::MDMutationLock). The first mutex is the file system view object
  * (FsView.cc) which contains the current state of the storage
  * filesystem/node/group/space configuration. The second mutex is protecting
  * the quota configuration and scheduling. The last mutex is protecting the
@@ -111,6 +117,7 @@
 #include "mgm/drain/Drainer.hh"
 #include "mgm/TapeAwareGc.hh"
 #include "mgm/auth/AccessChecker.hh"
+#include "namespace/MDLocking.hh"
 #include "namespace/interface/IContainerMD.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
 #include "mgm/FuseNotificationGuard.hh"
@@ -1423,6 +1430,7 @@ public:
   //! Subtree mtime propagation
   eos::IContainerMDChangeListener* eosSyncTimeAccounting;
   eos::common::RWMutex eosViewRWMutex; ///< rw namespace mutex
+  eos::MDLockTable eosMdLocks; ///< Per-container and per-file locks
   XrdOucString
   MgmMetaLogDir; //  Directory containing the meta data (change) log files
 
@@ -1543,6 +1551,18 @@ public:
   //----------------------------------------------------------------------------
   void OrderlyShutdown();
 
+  //----------------------------------------------------------------------------
+  //! Save the most accessed namespace entries in QuarkDB, where the next
+  //! master reads them to warm up its caches. Only done by the master and if
+  //! the warm-up is enabled.
+  //!
+  //! @param iostat IO statistics providing the popularity history
+  //----------------------------------------------------------------------------
+  void SaveNsWarmupHotList(Iostat& iostat);
+
+  //! QuarkDB key of the most accessed namespace entries
+  static const std::string sNsWarmupHotKey;
+
   //----------------------------------------------------------------------------
   // Class objects
   //----------------------------------------------------------------------------
@@ -1613,6 +1633,9 @@ public:
   int mHttpdPort; ///< port of the http server, default 8000
   int mFusexPort; ///< port of the FUSEX brocasz MQZ, default 1100
   bool mTapeAwareGcDefaultSpaceEnable; ///< Flag to mark if tape aware garbage collection should be enabled
+  //! Max seconds spent warming up the namespace caches at boot, 0 disables it
+  uint64_t mNsWarmupTimeout;
+  std::string mNsWarmupList; ///< Extra list of entries to warm up at boot
   eos::common::XrdConnPool mXrdConnPool; ///< XRD connection pool
   TapeAwareGc mTapeAwareGc; ///< Tape aware garbage collector
 
@@ -327,13 +327,17 @@ XrdMgmOfs::_mkdir(const char* path,
       eos::common::Path tmp_path("");
 
       for (j = i + 1; j < (int) cPath.GetSubPathSize(); ++j) {
-        eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+        eos::MDMutationLock lock(gOFS->eosViewRWMutex, gOFS->eosMdLocks,
+                                 gOFS->NsInQDB);
+        eos::MDLocker& md_lock = lock.locker();
 
         try {
           errno = 0;
           eos_debug("creating path %s", cPath.GetSubPath(j));
           tmp_path.Init(cPath.GetSubPath(j));
-          dir = eosView->getContainer(tmp_path.GetParentPath());
+          std::vector<eos::MDLockTarget> targets {{tmp_path.GetParentPath()}};
+          eos::lockForUpdate(eosView, targets, md_lock);
+          dir = targets[0].mContainer;
           newdir = eosView->createContainer(cPath.GetSubPath(j), recurse);
           newdir->setCUid(vid.uid);
           newdir->setCGid(vid.gid);
@@ -359,6 +363,7 @@ XrdMgmOfs::_mkdir(const char* path,
           eos::ContainerIdentifier nd_id = newdir->getIdentifier();
           eos::ContainerIdentifier d_id = dir->getIdentifier();
           eos::ContainerIdentifier d_pid = dir->getParentIdentifier();
+          md_lock.unlock();
           lock.Release();
           gOFS->FuseXCastContainer(nd_id);
           gOFS->FuseXCastContainer(d_id);
@@ -387,11 +392,17 @@ XrdMgmOfs::_mkdir(const char* path,
     return Emsg(epname, error, errno, "mkdir", path);
   }
 
-  eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+  // Only the parent container is locked, mkdirs in other directories and
+  // lookups anywhere proceed in parallel
+  eos::MDMutationLock lock(gOFS->eosViewRWMutex, gOFS->eosMdLocks,
+                           gOFS->NsInQDB);
+  eos::MDLocker& md_lock = lock.locker();
 
   try {
     errno = 0;
-    dir = eosView->getContainer(cPath.GetParentPath());
+    std::vector<eos::MDLockTarget> targets {{cPath.GetParentPath()}};
+    eos::lockForUpdate(eosView, targets, md_lock);
+    dir = targets[0].mContainer;
     newdir = eosView->createContainer(path);
     newdir->setCUid(vid.uid);
     newdir->setCGid(vid.gid);
@@ -425,6 +436,7 @@ XrdMgmOfs::_mkdir(const char* path,
     eos::ContainerIdentifier nd_id = newdir->getIdentifier();
     eos::ContainerIdentifier d_id = dir->getIdentifier();
     eos::ContainerIdentifier d_pid = dir->getParentIdentifier();
+    md_lock.unlock();
     lock.Release();
     gOFS->FuseXCastContainer(nd_id);
     gOFS->FuseXCastContainer(d_id);
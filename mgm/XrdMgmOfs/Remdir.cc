@@ -109,9 +109,24 @@ XrdMgmOfs::_remdir(const char* path,
                 qpath.c_str());
   }
 
-  gOFS->eosViewRWMutex.LockWrite();
+  // Only the parent container and the removed one are locked, the latter
+  // can not get new entries while checking that it's empty
+  std::vector<eos::MDLockTarget> targets {
+    {cPath.GetParentPath(), cPath.GetName()}
+  };
+  eos::MDMutationLock ns_lock(gOFS->eosViewRWMutex, gOFS->eosMdLocks,
+                              gOFS->NsInQDB);
+  eos::MDLocker& md_lock = ns_lock.locker();
   std::string aclpath;
 
+  try {
+    eos::lockForUpdate(gOFS->eosView, targets, md_lock);
+  } catch (eos::MDException& e) {
+    // Never go on without the entry locks
+    ns_lock.Release();
+    return Emsg(epname, error, e.getErrno(), "rmdir - lock", path);
+  }
+
   try {
     dh = gOFS->eosView->getContainer(path);
     eos::common::Path pPath(gOFS->eosView->getUri(dh.get()).c_str());
@@ -128,7 +143,7 @@ XrdMgmOfs::_remdir(const char* path,
   // check existence
   if (!dh) {
     errno = ENOENT;
-    gOFS->eosViewRWMutex.UnLockWrite();
+    ns_lock.Release();
     return Emsg(epname, error, errno, "rmdir", path);
   }
 
@@ -137,7 +152,7 @@ XrdMgmOfs::_remdir(const char* path,
 
   if (vid.uid && !acl.IsMutable()) {
     errno = EPERM;
-    gOFS->eosViewRWMutex.UnLockWrite();
+    ns_lock.Release();
     return Emsg(epname, error, EPERM, "rmdir - immutable", path);
   }
 
@@ -149,7 +164,7 @@ XrdMgmOfs::_remdir(const char* path,
 
       if (option == "r") {
         // Recursive delete - need to unlock before calling the proc function
-        gOFS->eosViewRWMutex.UnLockWrite();
+        ns_lock.Release();
         ProcCommand cmd;
         XrdOucString info = "mgm.cmd=rm&mgm.option=r&mgm.path=";
         info += path;
@@ -177,7 +192,7 @@ XrdMgmOfs::_remdir(const char* path,
         (acl.CanNotDelete())) {
       // deletion is explicitly forbidden
       errno = EPERM;
-      gOFS->eosViewRWMutex.UnLockWrite();
+      ns_lock.Release();
       return Emsg(epname, error, EPERM, "rmdir by ACL", path);
     }
 
@@ -197,14 +212,14 @@ XrdMgmOfs::_remdir(const char* path,
 
   if (!permok) {
     errno = EPERM;
-    gOFS->eosViewRWMutex.UnLockWrite();
+    ns_lock.Release();
     return Emsg(epname, error, errno, "rmdir", path);
   }
 
   if ((dh->getFlags() && eos::QUOTA_NODE_FLAG) && (vid.uid)) {
     errno = EADDRINUSE;
     eos_err("%s is a quota node - deletion canceled", path);
-    gOFS->eosViewRWMutex.UnLockWrite();
+    ns_lock.Release();
     return Emsg(epname, error, errno, "rmdir - this is a quota node", path);
   }
 
@@ -238,7 +253,7 @@ XrdMgmOfs::_remdir(const char* path,
     }
   }
 
-  gOFS->eosViewRWMutex.UnLockWrite();
+  ns_lock.Release();
   EXEC_TIMING_END("RmDir");
 
   if (errno) {
@@ -377,9 +377,33 @@ XrdMgmOfs::_rename(const char* old_name,
   }
 
   {
-    eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+    // Directories moving to another parent freeze the namespace: the check
+    // that the target is not inside the moved tree is only valid as long as
+    // no other directory moves, and a move between quota nodes updates the
+    // whole subtree anyway. Any other rename only locks the source and target
+    // parents and the renamed entry, in a fixed order, so that crossed renames
+    // between two directories can not deadlock. The in-memory namespace
+    // services are not thread-safe, there every rename is exclusive.
+    const bool structural = renameDir && (findOk || (oP != nP));
+    const bool exclusive = structural || !gOFS->NsInQDB;
+    eos::common::RWMutexWriteLock wr_lock;
+    eos::common::RWMutexReadLock rd_lock;
+    eos::MDLocker md_lock(gOFS->eosMdLocks);
+
+    if (exclusive) {
+      wr_lock.Grab(gOFS->eosViewRWMutex);
+    } else {
+      rd_lock.Grab(gOFS->eosViewRWMutex);
+    }
 
     try {
+      if (!exclusive) {
+        std::vector<eos::MDLockTarget> targets {
+          {oPath.GetParentPath(), oPath.GetName()}, {nPath.GetParentPath()}
+        };
+        eos::lockForUpdate(eosView, targets, md_lock);
+      }
+
       dir = eosView->getContainer(oPath.GetParentPath());
       newdir = eosView->getContainer(nPath.GetParentPath());
       // Translate to paths without symlinks
@@ -127,7 +127,24 @@ XrdMgmOfs::_rem(const char* path,
   }
 
   // ---------------------------------------------------------------------------
-  gOFS->eosViewRWMutex.LockWrite();
+  // Only the parent container and the file are locked, removals in other
+  // directories and lookups anywhere proceed in parallel
+  eos::common::Path rm_path(path);
+  std::vector<eos::MDLockTarget> targets {
+    {rm_path.GetParentPath(), rm_path.GetName()}
+  };
+  eos::MDMutationLock ns_lock(gOFS->eosViewRWMutex, gOFS->eosMdLocks,
+                              gOFS->NsInQDB);
+  eos::MDLocker& md_lock = ns_lock.locker();
+
+  try {
+    eos::lockForUpdate(gOFS->eosView, targets, md_lock);
+  } catch (eos::MDException& e) {
+    // Never go on without the entry locks
+    ns_lock.Release();
+    return Emsg(epname, error, e.getErrno(), "remove - lock", path);
+  }
+
   // free the booked quota
   std::shared_ptr<eos::IFileMD> fmd;
   std::shared_ptr<eos::IContainerMD> container;
@@ -167,7 +184,7 @@ XrdMgmOfs::_rem(const char* path,
       }
 
       if (!ok) {
-        gOFS->eosViewRWMutex.UnLockWrite();
+        ns_lock.Release();
         errno = EXDEV;
         return Emsg(epname, error, errno,
                     "remove file with hard links only through fusex", path);
@@ -188,7 +205,7 @@ XrdMgmOfs::_rem(const char* path,
 
     if (vid.uid && !acl.IsMutable()) {
       errno = EPERM;
-      gOFS->eosViewRWMutex.UnLockWrite();
+      ns_lock.Release();
       return Emsg(epname, error, errno, "remove file - immutable", path);
     }
 
@@ -210,7 +227,7 @@ XrdMgmOfs::_rem(const char* path,
     if (container) {
       if (stdpermcheck && (!container->access(vid.uid, vid.gid, W_OK | X_OK))) {
         errno = EPERM;
-        gOFS->eosViewRWMutex.UnLockWrite();
+        ns_lock.Release();
         std::ostringstream oss;
         oss << path << " by tident=" << vid.tident;
         return Emsg(epname, error, errno, "remove file", oss.str().c_str());
@@ -218,7 +235,7 @@ XrdMgmOfs::_rem(const char* path,
 
       // check if this directory is write-once for the mapped user
       if (acl.CanWriteOnce() && (fmd->getSize())) {
-        gOFS->eosViewRWMutex.UnLockWrite();
+        ns_lock.Release();
         errno = EPERM;
         // this is a write once user
         return Emsg(epname, error, EPERM,
@@ -229,7 +246,7 @@ eos_debug("vid.uid %d vid.gid %d CanotDelete %d CUid %d", vid.uid, vid.gid, acl.
       // if there is a !d policy we cannot delete files which we don't own
       if (((vid.uid) && (vid.uid != 3) && (vid.gid != 4) && (acl.CanNotDelete())) &&
           ((fmd->getCUid() != vid.uid))) {
-        gOFS->eosViewRWMutex.UnLockWrite();
+        ns_lock.Release();
         errno = EPERM;
         // deletion is forbidden for not-owner
         return Emsg(epname, error, EPERM,
@@ -237,7 +254,7 @@ eos_debug("vid.uid %d vid.gid %d CanotDelete %d CUid %d", vid.uid, vid.gid, acl.
       }
 
       if ((!stdpermcheck) && (!acl.CanWrite())) {
-        gOFS->eosViewRWMutex.UnLockWrite();
+        ns_lock.Release();
         errno = EPERM;
         // this user is not allowed to write
         return Emsg(epname, error, EPERM,
@@ -273,7 +290,7 @@ eos_debug("vid.uid %d vid.gid %d CanotDelete %d CUid %d", vid.uid, vid.gid, acl.
       }
     }
   } else {
-    gOFS->eosViewRWMutex.UnLockWrite();
+    ns_lock.Release();
     errno = ENOENT;
     return Emsg(epname, error, errno, "remove", path);
   }
@@ -286,7 +303,7 @@ eos_debug("vid.uid %d vid.gid %d CanotDelete %d CUid %d", vid.uid, vid.gid, acl.
         // eventually trigger a workflow
         workflow.Init(&attrmap, path, fid);
         errno = 0;
-        gOFS->eosViewRWMutex.UnLockWrite();
+        ns_lock.Release();
         auto ret_wfe = workflow.Trigger("sync::delete", "default", vid, ininfo, errMsg);
 
         if (ret_wfe < 0 && errno == ENOKEY) {
@@ -295,14 +312,25 @@ eos_debug("vid.uid %d vid.gid %d CanotDelete %d CUid %d", vid.uid, vid.gid, acl.
           eos_info("msg=\"workflow trigger returned\" retc=%d errno=%d", ret_wfe, errno);
         }
 
-        gOFS->eosViewRWMutex.LockWrite();
+        int wfe_errno = errno;
+        ns_lock.Grab();
+        eos::lockForUpdate(gOFS->eosView, targets, md_lock);
 
-        if (ret_wfe && errno != ENOKEY) {
-          eos::MDException e(errno);
+        if (ret_wfe && wfe_errno != ENOKEY) {
+          eos::MDException e(wfe_errno);
           e.getMessage() << "Deletion workflow failed";
           throw e;
         }
 
+        // The file may have been renamed or removed while unlocked, continue
+        // only with the same file, as it is now
+        if (!targets[0].mFile || (targets[0].mFile->getId() != fid)) {
+          throw_mdexception(ENOENT, "File " << path << " changed during the "
+                            "deletion workflow");
+        }
+
+        fmd = gOFS->eosFileService->getFileMD(fid);
+        container = targets[0].mContainer;
         gOFS->eosView->unlinkFile(path);
         // Reload file object that was modifed in the unlinkFile method
         // TODO: this can be dropped if you use the unlinkFile which takes
@@ -337,7 +365,7 @@ eos_debug("vid.uid %d vid.gid %d CanotDelete %d CUid %d", vid.uid, vid.gid, acl.
   if (doRecycle && (!simulate)) {
     // Two-step deletion recycle logic
     XrdOucString recyclePath;
-    gOFS->eosViewRWMutex.UnLockWrite();
+    ns_lock.Release();
     // -------------------------------------------------------------------------
     std::string recycle_space = attrmap[Recycle::gRecyclingAttribute].c_str();
 
@@ -404,7 +432,7 @@ eos_debug("vid.uid %d vid.gid %d CanotDelete %d CUid %d", vid.uid, vid.gid, acl.
       errno = 0; // purge might return ENOENT if there was no version
     }
   } else {
-    gOFS->eosViewRWMutex.UnLockWrite();
+    ns_lock.Release();
 
     if ((!errno) && (!keepversion)) {
       // call the version purge function in case there is a version (without gQuota locked)
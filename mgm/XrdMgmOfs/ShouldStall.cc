@@ -120,38 +120,26 @@ XrdMgmOfs::ShouldStall(const char* function,
 
           if ((it->first.find(userwildcardmatch) == 0)) {
             // catch all rule = global user rate cut
-            XrdSysMutexHelper statLock(gOFS->MgmStats.mMutex);
-
-            if (gOFS->MgmStats.StatAvgUid.count(cmd) &&
-                gOFS->MgmStats.StatAvgUid[cmd].count(vid.uid) &&
-                (gOFS->MgmStats.StatAvgUid[cmd][vid.uid].GetAvg5() > cutoff)) {
+            if (gOFS->MgmStats.GetUserAvg5(cmd.c_str(), vid.uid) > cutoff) {
               stalltime = 5;
               smsg = Access::gStallComment[it->first];
             }
           } else if ((it->first.find(groupwildcardmatch) == 0)) {
             // catch all rule = global user rate cut
-            XrdSysMutexHelper statLock(gOFS->MgmStats.mMutex);
-
-            if (gOFS->MgmStats.StatAvgGid.count(cmd) &&
-                gOFS->MgmStats.StatAvgGid[cmd].count(vid.gid) &&
-                (gOFS->MgmStats.StatAvgGid[cmd][vid.gid].GetAvg5() > cutoff)) {
+            if (gOFS->MgmStats.GetGroupAvg5(cmd.c_str(), vid.gid) > cutoff) {
               stalltime = 5;
               smsg = Access::gStallComment[it->first];
             }
           } else if ((it->first.find(usermatch) == 0)) {
             // check user rule
-            if (gOFS->MgmStats.StatAvgUid.count(cmd) &&
-                gOFS->MgmStats.StatAvgUid[cmd].count(vid.uid) &&
-                (gOFS->MgmStats.StatAvgUid[cmd][vid.uid].GetAvg5() > cutoff)) {
+            if (gOFS->MgmStats.GetUserAvg5(cmd.c_str(), vid.uid) > cutoff) {
               // rate exceeded
               stalltime = 5;
               smsg = Access::gStallComment[it->first];
             }
           } else if ((it->first.find(groupmatch) == 0)) {
             // check group rule
-            if (gOFS->MgmStats.StatAvgGid.count(cmd) &&
-                gOFS->MgmStats.StatAvgGid[cmd].count(vid.gid) &&
-                (gOFS->MgmStats.StatAvgGid[cmd][vid.gid].GetAvg5() > cutoff)) {
+            if (gOFS->MgmStats.GetGroupAvg5(cmd.c_str(), vid.gid) > cutoff) {
               // rate exceeded
               stalltime = 5;
               smsg = Access::gStallComment[it->first];
@@ -623,6 +623,24 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
           }
         }
 
+        if (!strcmp("nswarmup.timeout", var)) {
+          if (!(val = Config.GetWord())) {
+            Eroute.Emsg("Config", "argument for nswarmup.timeout missing");
+          } else {
+            mNsWarmupTimeout = strtoull(val, 0, 10);
+            Eroute.Say("=====> mgmofs.nswarmup.timeout : ", val);
+          }
+        }
+
+        if (!strcmp("nswarmup.list", var)) {
+          if (!(val = Config.GetWord())) {
+            Eroute.Emsg("Config", "argument for nswarmup.list missing");
+          } else {
+            mNsWarmupList = val;
+            Eroute.Say("=====> mgmofs.nswarmup.list : ", val);
+          }
+        }
+
         if (!strcmp("tapeawaregc.defaultspace.enable", var)) {
           if ((!(val = Config.GetWord())) ||
               (strcmp("true", val) && strcmp("false", val) &&
@@ -1429,7 +1447,6 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
   eos::common::RWMutex* quota_mtx = &Quota::pMapMutex;
   eos::common::RWMutex* ns_mtx = &eosViewRWMutex;
   eos::common::RWMutex* fusex_client_mtx = &gOFS->zMQ->gFuseServer.Client();
-  eos::common::RWMutex* fusex_cap_mtx = &gOFS->zMQ->gFuseServer.Cap();
   // eos::common::RWMutex::EstimateLatenciesAndCompensation();
   fs_mtx->SetBlocking(true);
   fs_mtx->SetDebugName("FsView");
@@ -1445,7 +1462,6 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
   order.push_back(fs_mtx);
   order.push_back(ns_mtx);
   order.push_back(fusex_client_mtx);
-  order.push_back(fusex_cap_mtx);
   order.push_back(quota_mtx);
   eos::common::RWMutex::AddOrderRule("Eos Mgm Mutexes", order);
 #endif
@@ -1912,6 +1928,8 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
   // if there is no FST sending update
   gGeoTreeEngine.forceRefresh();
   gGeoTreeEngine.StartUpdater();
+  // Maintain the space/group/node aggregates from the same notifications
+  FsView::gFsView.StartAggregateUpdater();
 
   // Start the drain engine
   if (mIsCentralDrain) {
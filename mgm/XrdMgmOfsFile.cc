@@ -65,6 +65,44 @@
 /* MGM File Interface                                                         */
 /******************************************************************************/
 
+//------------------------------------------------------------------------------
+//! Lock a file whose replicas are updated together with its parent container,
+//! so that it can not be unlinked or removed until the update is stored. The
+//! file is given by path or, if fid is not 0, by id.
+//!
+//! @return locked file, throws MDException ENOENT if it is not linked anymore
+//------------------------------------------------------------------------------
+static std::shared_ptr<eos::IFileMD>
+LockFileForReplicas(const std::string& path, eos::IFileMD::id_t fid,
+                    eos::MDLocker& md_lock)
+{
+  std::string fpath = path;
+
+  if (fid) {
+    std::shared_ptr<eos::IFileMD> fmd = gOFS->eosFileService->getFileMD(fid);
+
+    if (!fmd->getContainerId()) {
+      throw_mdexception(ENOENT, "File fxid:" << eos::common::FileId::Fid2Hex(fid)
+                        << " is not linked");
+    }
+
+    fpath = gOFS->eosView->getUri(fmd.get());
+  }
+
+  eos::common::Path cPath(fpath.c_str());
+  std::vector<eos::MDLockTarget> targets {
+    {cPath.GetParentPath(), cPath.GetName()}
+  };
+  eos::lockForUpdate(gOFS->eosView, targets, md_lock);
+
+  // The file may have been unlinked or replaced before the lock was taken
+  if (!targets[0].mFile || (fid && (targets[0].mFile->getId() != fid))) {
+    throw_mdexception(ENOENT, "No such file " << fpath);
+  }
+
+  return targets[0].mFile;
+}
+
 /*----------------------------------------------------------------------------*/
 int
 XrdMgmOfsFile::open(const char* inpath,
@@ -840,10 +878,20 @@ XrdMgmOfsFile::open(const char* inpath,
         // creation of a new file or isOcUpload
         {
           // -------------------------------------------------------------------
-          eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+          // Lock only the parent container, and the existing target of an
+          // atomic upload which lives in the same directory
+          eos::MDMutationLock lock(gOFS->eosViewRWMutex, gOFS->eosMdLocks,
+                                   gOFS->NsInQDB);
+          eos::MDLocker& md_lock = lock.locker();
           std::shared_ptr<eos::IFileMD> ref_fmd;
 
           try {
+            eos::common::Path tPath(path);
+            std::vector<eos::MDLockTarget> targets {
+              {tPath.GetParentPath(), isAtomicUpload ? tPath.GetName() : ""}
+            };
+            eos::lockForUpdate(gOFS->eosView, targets, md_lock);
+
             if (!fmd) {
               // we create files with the uid/gid of the parent directory
               if (isAtomicUpload) {
@@ -885,6 +933,7 @@ XrdMgmOfsFile::open(const char* inpath,
             gOFS->eosView->updateContainerStore(cmd.get());
             eos::ContainerIdentifier cmd_id = cmd->getIdentifier();
             eos::ContainerIdentifier cmd_pid = cmd->getParentIdentifier();
+            md_lock.unlock();
             lock.Release();
             gOFS->FuseXCastContainer(cmd_id);
             gOFS->FuseXCastContainer(cmd_pid);
@@ -1076,7 +1125,11 @@ XrdMgmOfsFile::open(const char* inpath,
     layoutId = new_lid;
     {
       std::shared_ptr<eos::IFileMD> fmdnew;
-      eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+      eos::MDMutationLock lock(gOFS->eosViewRWMutex, gOFS->eosMdLocks,
+                               gOFS->NsInQDB);
+      eos::MDLocker& md_lock = lock.locker();
+      md_lock.addContainer(cid).addFile(fmd->getId());
+      md_lock.lock();
 
       if (!byfid) {
         try {
@@ -1138,6 +1191,7 @@ XrdMgmOfsFile::open(const char* inpath,
           }
         }
 
+        md_lock.unlock();
         lock.Release();
         gOFS->FuseXCastFile(fmd_id);
         gOFS->FuseXCastContainer(cmd_id);
@@ -1625,15 +1679,14 @@ XrdMgmOfsFile::open(const char* inpath,
             eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, creation_path);
           }
 
-          eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+          eos::MDMutationLock lock(gOFS->eosViewRWMutex, gOFS->eosMdLocks,
+                                   gOFS->NsInQDB);
+          eos::MDLocker& md_lock = lock.locker();
           // -------------------------------------------------------------------
 
           try {
-            if (byfid) {
-              fmd = gOFS->eosFileService->getFileMD(byfid);
-            } else {
-              fmd = gOFS->eosView->getFile(creation_path);
-            }
+            // The file is modified, its parent keeps it from being unlinked
+            fmd = LockFileForReplicas(creation_path, byfid, md_lock);
 
             if (isRecreation) {
               fmd->unlinkAllLocations();
@@ -1669,10 +1722,13 @@ XrdMgmOfsFile::open(const char* inpath,
           // the new FUSE client needs to have the replicas attached after the
           // first open call
           eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, byfid);
-          eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+          eos::MDMutationLock lock(gOFS->eosViewRWMutex, gOFS->eosMdLocks,
+                                   gOFS->NsInQDB);
+          eos::MDLocker& md_lock = lock.locker();
 
           try {
-            fmd = gOFS->eosFileService->getFileMD(byfid);
+            // The file is modified, its parent keeps it from being unlinked
+            fmd = LockFileForReplicas("", byfid, md_lock);
 
             for (auto& fsid : selectedfs) {
               fmd->addLocation(fsid);
@@ -2766,6 +2822,11 @@ XrdMgmOfsFile::~XrdMgmOfsFile()
     delete openOpaque;
     openOpaque = 0;
   }
+
+  // A command streaming its output might still be executing
+  if (mProcCmd) {
+    ProcInterface::DropCmd(std::move(mProcCmd));
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -230,7 +230,7 @@ IConfigEngine::ApplyConfig(XrdOucString& err, bool apply_stall_redirect)
   // Cleanup quota map
   (void) Quota::CleanUp();
   {
-    eos::common::RWMutexWriteLock wr_lock(eos::common::Mapping::gMapMutex);
+    eos::common::Mapping::RulesWriteLock wr_lock;
     eos::common::Mapping::gUserRoleVector.clear();
     eos::common::Mapping::gGroupRoleVector.clear();
     eos::common::Mapping::gVirtualUidMap.clear();
@@ -502,7 +502,7 @@ IConfigEngine::ResetConfig(bool apply_stall_redirect)
   mConfigFile = "";
   (void) Quota::CleanUp();
   {
-    eos::common::RWMutexWriteLock wr_lock(eos::common::Mapping::gMapMutex);
+    eos::common::Mapping::RulesWriteLock wr_lock;
     eos::common::Mapping::gUserRoleVector.clear();
     eos::common::Mapping::gGroupRoleVector.clear();
     eos::common::Mapping::gVirtualUidMap.clear();
@@ -35,6 +35,7 @@ EOSMGMNAMESPACE_BEGIN
 std::atomic_uint_least64_t IProcCommand::uuid{0};
 std::map<eos::console::RequestProto::CommandCase, std::atomic<uint64_t>>
     IProcCommand::mCmdsExecuting;
+std::atomic<uint64_t> IProcCommand::sStreamsRunning {0};
 
 //------------------------------------------------------------------------------
 // Open a proc command e.g. call the appropriate user or admin command and
@@ -51,6 +52,20 @@ IProcCommand::open(const char* path, const char* info,
 
   if (!mExecRequest) {
     if (HasSlot()) {
+      // Past the stream limit the client is stalled until the command is done
+      if (mStreamOutput && !TakeStreamSlot()) {
+        eos_notice("%s", SSTR("cmd_type=" << mReqProto.command_case() <<
+                              " too many streamed outputs, return the output "
+                              "once done").c_str());
+        mStreamOutput = false;
+      }
+
+      // The output files must exist before the client starts reading them
+      if (mStreamOutput && !OpenTemporaryOutputFiles()) {
+        ReleaseStreamSlot();
+        mStreamOutput = false;
+      }
+
       LaunchJob();
       mExecRequest = true;
     } else {
@@ -60,67 +75,98 @@ IProcCommand::open(const char* path, const char* info,
     }
   }
 
-  if (mFuture.wait_for(std::chrono::seconds(delay)) !=
-      std::future_status::ready) {
+  if (mStreamOutput) {
+    // The output is read while the command is executing, see read
+    ifstdoutStream.open(ofstdoutStreamFilename, std::ifstream::in);
+    readStdOutStream = true;
+  } else if (mFuture.wait_for(std::chrono::seconds(delay)) !=
+             std::future_status::ready) {
     // Stall the client
     std::string msg = "command not ready, stall the client 5 seconds";
     eos_notice("%s", msg.c_str());
     error->setErrInfo(0, msg.c_str());
     return delay;
+  } else if (!ofstdoutStreamFilename.empty() &&
+             !ofstderrStreamFilename.empty()) {
+    // Output is written in file
+    ifstdoutStream.open(ofstdoutStreamFilename, std::ifstream::in);
+    readStdOutStream = true;
+    FinishFileOutput();
   } else {
     eos::console::ReplyProto reply = mFuture.get();
-
-    // Output is written in file
-    if (!ofstdoutStreamFilename.empty() && !ofstderrStreamFilename.empty()) {
-      ifstdoutStream.open(ofstdoutStreamFilename, std::ifstream::in);
-      ifstderrStream.open(ofstderrStreamFilename, std::ifstream::in);
-      iretcStream.str(std::string("&mgm.proc.retc=") + std::to_string(reply.retc()));
-      readStdOutStream = true;
+    std::ostringstream oss;
+
+    if (mReqProto.format() == eos::console::RequestProto::JSON) {
+      Json::Value json;
+      json["result"] = ConvertOutputToJsonFormat(reply.std_out());
+      json["errormsg"] = reply.std_err();
+      json["retc"] = std::to_string(reply.retc());
+
+      oss << "mgm.proc.stdout=" << json
+          << "&mgm.proc.stderr=" << reply.std_err()
+          << "&mgm.proc.retc=" << reply.retc();
+    } else if (mReqProto.format() == eos::console::RequestProto::FUSE) {
+      // @todo (esindril) This format should be dropped and the client should
+      // just parse the stdout response. For example the FST dumpmd should do
+      // this.
+      oss << reply.std_out();
     } else {
-      std::ostringstream oss;
-
-      if (mReqProto.format() == eos::console::RequestProto::JSON) {
-        Json::Value json;
-        json["result"] = ConvertOutputToJsonFormat(reply.std_out());
-        json["errormsg"] = reply.std_err();
-        json["retc"] = std::to_string(reply.retc());
-
-        oss << "mgm.proc.stdout=" << json
-            << "&mgm.proc.stderr=" << reply.std_err()
-            << "&mgm.proc.retc=" << reply.retc();
-      } else if (mReqProto.format() == eos::console::RequestProto::FUSE) {
-        // @todo (esindril) This format should be dropped and the client should
-        // just parse the stdout response. For example the FST dumpmd should do
-        // this.
-        oss << reply.std_out();
-      } else {
-        oss << "mgm.proc.stdout=" << reply.std_out()
-            << "&mgm.proc.stderr=" << reply.std_err()
-            << "&mgm.proc.retc=" << reply.retc();
-      }
-
-      mTmpResp = oss.str();
+      oss << "mgm.proc.stdout=" << reply.std_out()
+          << "&mgm.proc.stderr=" << reply.std_err()
+          << "&mgm.proc.retc=" << reply.retc();
     }
 
-    // Store the client's command comment in the comments logbook
-    if ((vid.uid <= 2) || (vid.sudoer)) {
-      // Only instance users or sudoers can add to the logbook
-      if (mComment.length() && gOFS->mCommentLog) {
-        std::string argsJson;
-        (void) google::protobuf::util::MessageToJsonString(mReqProto, &argsJson);
-
-        if (!gOFS->mCommentLog->Add(mTimestamp, "", "", argsJson.c_str(),
-                                    mComment.c_str(), stdErr.c_str(),
-                                    reply.retc())) {
-          eos_err("failed to log to comments logbook");
-        }
-      }
-    }
+    mTmpResp = oss.str();
+
+    LogComment(reply.retc());
   }
 
   return SFS_OK;
 }
 
+//------------------------------------------------------------------------------
+// Collect the reply of a command writing its output to the temporary files
+//------------------------------------------------------------------------------
+void
+IProcCommand::FinishFileOutput()
+{
+  eos::console::ReplyProto reply = mFuture.get();
+
+  // The command might have bailed out without closing the files
+  if (ofstdoutStream.is_open()) {
+    ofstdoutStream.flush();
+  }
+
+  if (ofstderrStream.is_open()) {
+    ofstderrStream.flush();
+  }
+
+  ifstderrStream.open(ofstderrStreamFilename, std::ifstream::in);
+  iretcStream.str(std::string("&mgm.proc.retc=") + std::to_string(reply.retc()));
+  LogComment(reply.retc());
+}
+
+//------------------------------------------------------------------------------
+// Store the client's command comment in the comments logbook
+//------------------------------------------------------------------------------
+void
+IProcCommand::LogComment(int reply_retc)
+{
+  // Only instance users or sudoers can add to the logbook
+  if ((mVid.uid <= 2) || (mVid.sudoer)) {
+    if (mComment.length() && gOFS->mCommentLog) {
+      std::string argsJson;
+      (void) google::protobuf::util::MessageToJsonString(mReqProto, &argsJson);
+
+      if (!gOFS->mCommentLog->Add(mTimestamp, "", "", argsJson.c_str(),
+                                  mComment.c_str(), stdErr.c_str(),
+                                  reply_retc)) {
+        eos_err("failed to log to comments logbook");
+      }
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 // Read a part of the result stream created during open
 //------------------------------------------------------------------------------
@@ -129,6 +175,31 @@ IProcCommand::read(XrdSfsFileOffset offset, char* buff, XrdSfsXferSize blen)
 {
   size_t cpy_len = 0;
 
+  if (mStreamOutput && readStdOutStream) {
+    // An empty read ends the transfer, so wait until the command wrote more
+    // output or is done
+    while (true) {
+      ifstdoutStream.clear();
+      ifstdoutStream.read(buff, blen);
+      cpy_len = (size_t)ifstdoutStream.gcount();
+
+      if (cpy_len) {
+        return cpy_len;
+      }
+
+      if (mFuture.wait_for(std::chrono::milliseconds(100)) ==
+          std::future_status::ready) {
+        break;
+      }
+    }
+
+    // Hand out what is left of the output followed by the errors and retc
+    mStreamOutput = false;
+    ReleaseStreamSlot();
+    ifstdoutStream.clear();
+    FinishFileOutput();
+  }
+
   if (readStdOutStream && ifstdoutStream.is_open() && ifstderrStream.is_open()) {
     ifstdoutStream.read(buff, blen);
     cpy_len = (size_t)ifstdoutStream.gcount();
@@ -487,4 +558,34 @@ IProcCommand::HasSlot()
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Check if the output can be streamed and if so take a stream slot
+//------------------------------------------------------------------------------
+bool
+IProcCommand::TakeStreamSlot()
+{
+  uint64_t running = sStreamsRunning.load();
+
+  do {
+    if (running >= sMaxStreams) {
+      return false;
+    }
+  } while (!sStreamsRunning.compare_exchange_weak(running, running + 1));
+
+  mHasStreamSlot = true;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Release the stream slot taken by the command, if any
+//------------------------------------------------------------------------------
+void
+IProcCommand::ReleaseStreamSlot()
+{
+  if (mHasStreamSlot) {
+    mHasStreamSlot = false;
+    --sStreamsRunning;
+  }
+}
+
 EOSMGMNAMESPACE_END
@@ -93,6 +93,8 @@ public:
     if (mHasSlot) {
       --mCmdsExecuting[mReqProto.command_case()];
     }
+
+    ReleaseStreamSlot();
   }
 
   //----------------------------------------------------------------------------
@@ -133,7 +135,14 @@ public:
   {
     off_t size = 0;
 
-    if (readStdOutStream) {
+    if (mStreamOutput) {
+      // The final size is known only once the command is done
+      struct stat st;
+
+      if (!::stat(ofstdoutStreamFilename.c_str(), &st)) {
+        size = st.st_size;
+      }
+    } else if (readStdOutStream) {
       ifstdoutStream.seekg(0, ifstdoutStream.end);
       size += ifstdoutStream.tellg();
       ifstdoutStream.seekg(0, ifstdoutStream.beg);
@@ -193,6 +202,19 @@ protected:
   virtual bool OpenTemporaryOutputFiles();
   virtual bool CloseTemporaryOutputFiles();
 
+  //----------------------------------------------------------------------------
+  //! Collect the reply of a command writing its output to the temporary
+  //! files and prepare the files for reading
+  //----------------------------------------------------------------------------
+  void FinishFileOutput();
+
+  //----------------------------------------------------------------------------
+  //! Store the client's command comment in the comments logbook
+  //!
+  //! @param reply_retc return code of the command
+  //----------------------------------------------------------------------------
+  void LogComment(int reply_retc);
+
   //----------------------------------------------------------------------------
   //! Get a file's full path using the fid information stored in the opaque
   //! data.
@@ -241,7 +263,26 @@ protected:
   //----------------------------------------------------------------------------
   bool HasSlot();
 
+  //----------------------------------------------------------------------------
+  //! Check if the output can be streamed, i.e. if less than sMaxStreams
+  //! commands are streaming their output, and if so take a stream slot
+  //!
+  //! @return true if the output can be streamed, otherwise false
+  //----------------------------------------------------------------------------
+  bool TakeStreamSlot();
+
+  //----------------------------------------------------------------------------
+  //! Release the stream slot taken by the command, if any
+  //----------------------------------------------------------------------------
+  void ReleaseStreamSlot();
+
   static std::atomic_uint_least64_t uuid;
+  //! Max number of commands streaming their output at the same time. The
+  //! reads of a streamed output wait for the command, each of them holds
+  //! a thread of the XRootD pool.
+  static constexpr uint64_t sMaxStreams = 16;
+  //! Number of commands streaming their output
+  static std::atomic<uint64_t> sStreamsRunning;
   //! Map of command types to number of commands actually queued
   static std::map<eos::console::RequestProto::CommandCase,
          std::atomic<uint64_t>> mCmdsExecuting;
@@ -271,6 +312,10 @@ protected:
   bool readStdOutStream {false};
   bool readStdErrStream {false};
   bool readRetcStream {false};
+  //! Hand out the output file to the client while the command still writes
+  //! it, reset once the command is done
+  bool mStreamOutput {false};
+  bool mHasStreamSlot {false}; ///< Command counts in sStreamsRunning
 };
 
 EOSMGMNAMESPACE_END
@@ -141,6 +141,21 @@ ProcInterface::DropSubmittedCmd(const char* tident)
   }
 }
 
+//------------------------------------------------------------------------------
+// Drop a command whose client went away while reading its output
+//------------------------------------------------------------------------------
+void
+ProcInterface::DropCmd(std::unique_ptr<IProcCommand>&& pcmd)
+{
+  if (pcmd->KillJob()) {
+    pcmd.reset();
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutexCmds);
+  mCmdToDel.push_back(std::move(pcmd));
+}
+
 //----------------------------------------------------------------------------
 // Handle protobuf request
 //----------------------------------------------------------------------------
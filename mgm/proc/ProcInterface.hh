@@ -143,6 +143,14 @@ public:
   //----------------------------------------------------------------------------
   static void DropSubmittedCmd(const char* tident);
 
+  //----------------------------------------------------------------------------
+  //! Drop a command whose client went away while reading its output, the
+  //! deletion is deferred as long as the command is still executing
+  //!
+  //! @param pcmd proc command object
+  //----------------------------------------------------------------------------
+  static void DropCmd(std::unique_ptr<IProcCommand>&& pcmd);
+
   ///! Pool of threads executing asynchronously long-running client commands
   static eos::common::ThreadPool sProcThreads;
 
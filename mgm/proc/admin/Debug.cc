@@ -34,6 +34,7 @@ ProcCommand::Debug()
     XrdOucString debugnode = pOpaque->Get("mgm.nodename");
     XrdOucString debuglevel = pOpaque->Get("mgm.debuglevel");
     XrdOucString filterlist = pOpaque->Get("mgm.filter");
+    XrdOucString asyncmode = pOpaque->Get("mgm.debugasync");
     XrdMqMessage message("debug");
     int envlen;
     XrdOucString body = pOpaque->Env(envlen);
@@ -51,6 +52,41 @@ ProcCommand::Debug()
     if (nstars > 1) {
       stdErr = "error: debug level node can only contain one wildcard character (*) !";
       retc = EINVAL;
+    } else if (asyncmode.length()) {
+      // switch the asynchronous logging pipeline on or off
+      if ((asyncmode != "on") && (asyncmode != "off")) {
+        stdErr = "error: asynchronous logging can only be switched on or off";
+        retc = EINVAL;
+      } else {
+        if ((debugnode == "*") || (debugnode == "") ||
+            (debugnode == gOFS->MgmOfsQueue)) {
+          g_logging.SetAsync(asyncmode == "on");
+          stdOut = "success: asynchronous logging is now <";
+          stdOut += asyncmode;
+          stdOut += ">\n";
+          eos_notice("switching asynchronous logging <%s>", asyncmode.c_str());
+        }
+
+        if (debugnode == "*") {
+          debugnode = "/eos/*/fst";
+        }
+
+        if ((debugnode != "") && (debugnode != gOFS->MgmOfsQueue)) {
+          if (!Messaging::gMessageClient.SendMessage(message, debugnode.c_str())) {
+            stdErr = "error: could not switch asynchronous logging on nodes "
+                     "mgm.nodename=";
+            stdErr += debugnode;
+            retc = EINVAL;
+          } else {
+            stdOut += "success: switched asynchronous logging <";
+            stdOut += asyncmode;
+            stdOut += "> on nodes mgm.nodename=";
+            stdOut += debugnode;
+            eos_notice("forwarding asynchronous logging <%s> to nodes "
+                       "mgm.nodename=%s", asyncmode.c_str(), debugnode.c_str());
+          }
+        }
+      }
     } else {
       // always check debug level exists first
       int debugval = g_logging.GetPriorityByString(debuglevel.c_str());
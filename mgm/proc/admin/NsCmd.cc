@@ -41,6 +41,10 @@
 #include "mgm/Stat.hh"
 #include "mgm/Master.hh"
 #include "mgm/ZMQ.hh"
+#include "common/RWMutexProfiler.hh"
+#include "common/Executor.hh"
+#include "json/json.h"
+#include <iomanip>
 #include <sstream>
 
 EOSMGMNAMESPACE_BEGIN
@@ -93,7 +97,9 @@ NsCmd::MutexSubcmd(const eos::console::NsProto_MutexProto& mutex,
 
     if (mutex.sample_rate1() || mutex.sample_rate10() ||
         mutex.sample_rate100() || mutex.toggle_timing() ||
-        mutex.toggle_order()) {
+        mutex.toggle_order() || mutex.toggle_profile() ||
+        (mutex.profile_rate() > 0) || mutex.profile() ||
+        mutex.reset_profile()) {
       no_option = false;
     }
 
@@ -138,7 +144,12 @@ NsCmd::MutexSubcmd(const eos::console::NsProto_MutexProto& mutex,
             << "% of the mutex lock/unlock cycle duration)";
       }
 
-      oss << std::endl;
+      oss << std::endl
+          << "profiling      is : "
+          << (eos::common::RWMutexProfiler::IsEnabled() ? "on " : "off")
+          << " (sampling rate "
+          << eos::common::RWMutexProfiler::GetSamplingRate() << ")"
+          << std::endl;
     }
 
     if (mutex.toggle_timing()) {
@@ -192,6 +203,31 @@ NsCmd::MutexSubcmd(const eos::console::NsProto_MutexProto& mutex,
       ns_mtx->SetSampling(true, rate);
     }
 
+    if (mutex.profile_rate() > 0) {
+      eos::common::RWMutexProfiler::SetSamplingRate(mutex.profile_rate());
+      oss << "mutex profiling sampling rate is "
+          << eos::common::RWMutexProfiler::GetSamplingRate() << std::endl;
+    }
+
+    if (mutex.toggle_profile()) {
+      if (eos::common::RWMutexProfiler::IsEnabled()) {
+        eos::common::RWMutexProfiler::SetEnabled(false);
+        oss << "mutex profiling is off" << std::endl;
+      } else {
+        eos::common::RWMutexProfiler::SetEnabled(true);
+        oss << "mutex profiling is on" << std::endl;
+      }
+    }
+
+    if (mutex.reset_profile()) {
+      eos::common::RWMutexProfiler::Reset();
+      oss << "mutex profiling counters reset" << std::endl;
+    }
+
+    if (mutex.profile()) {
+      oss << GetMutexProfile();
+    }
+
     reply.set_std_out(oss.str());
   } else {
     reply.set_std_err("error: you have to take role 'root' to execute this"
@@ -200,6 +236,63 @@ NsCmd::MutexSubcmd(const eos::console::NsProto_MutexProto& mutex,
   }
 }
 
+//------------------------------------------------------------------------------
+// Get the report of the mutex contention profiler
+//------------------------------------------------------------------------------
+std::string
+NsCmd::GetMutexProfile() const
+{
+  using eos::common::LatencyHistogram;
+  using eos::common::RWMutexProfiler;
+  auto histo_to_json = [](const LatencyHistogram & histo) {
+    Json::Value json;
+    uint64_t count = histo.GetCount();
+    json["count"] = (Json::UInt64) count;
+    json["mean_ns"] = (Json::UInt64)(count ? histo.GetSum() / count : 0);
+    json["p50_ns"] = (Json::UInt64) histo.GetPercentile(0.5);
+    json["p90_ns"] = (Json::UInt64) histo.GetPercentile(0.9);
+    json["p99_ns"] = (Json::UInt64) histo.GetPercentile(0.99);
+    json["p999_ns"] = (Json::UInt64) histo.GetPercentile(0.999);
+    json["max_ns"] = (Json::UInt64) histo.GetMax();
+    return json;
+  };
+  Json::Value root;
+  root["enabled"] = RWMutexProfiler::IsEnabled();
+  root["sampling_rate"] = RWMutexProfiler::GetSamplingRate();
+  root["call_sites"] = Json::Value(Json::arrayValue);
+  root["top_holders"] = Json::Value(Json::arrayValue);
+
+  for (const auto* site : RWMutexProfiler::GetCallSites()) {
+    if (site->mWait.GetCount() == 0) {
+      continue;
+    }
+
+    Json::Value jsite;
+    jsite["mutex"] = site->mMutex;
+    jsite["file"] = site->mFile;
+    jsite["line"] = site->mLine;
+    jsite["mode"] = (site->mWrite ? "write" : "read");
+    jsite["wait"] = histo_to_json(site->mWait);
+    jsite["hold"] = histo_to_json(site->mHold);
+    root["call_sites"].append(jsite);
+  }
+
+  for (const auto& holder : RWMutexProfiler::GetTopHolders()) {
+    Json::Value jholder;
+    jholder["mutex"] = holder.mMutex;
+    jholder["file"] = holder.mFile;
+    jholder["line"] = holder.mLine;
+    jholder["mode"] = (holder.mWrite ? "write" : "read");
+    jholder["hold_ns"] = (Json::UInt64) holder.mHoldNs;
+    jholder["timestamp"] = (Json::Int64) holder.mTimestamp;
+    jholder["stacktrace"] = holder.mStacktrace;
+    root["top_holders"].append(jholder);
+  }
+
+  Json::StyledWriter writer;
+  return writer.write(root);
+}
+
 //------------------------------------------------------------------------------
 // Execute stat command
 //------------------------------------------------------------------------------
@@ -301,6 +394,31 @@ NsCmd::StatSubcmd(const eos::console::NsProto_StatProto& stat)
   size_t eosxd_locked_clients = 0;
   gOFS->zMQ->gFuseServer.Client().ClientStats(eosxd_nclients,
       eosxd_active_clients, eosxd_locked_clients);
+  PathCacheStatistics pathCacheStats = gOFS->eosView->getPathCacheStatistics();
+  int64_t dentryLookups = pathCacheStats.dentryHits +
+                          pathCacheStats.dentryNegativeHits +
+                          pathCacheStats.dentryMisses;
+  int64_t pathLookups = pathCacheStats.pathHits + pathCacheStats.pathMisses;
+  double dentryHitRatio = dentryLookups ? 100.0 * (pathCacheStats.dentryHits +
+                          pathCacheStats.dentryNegativeHits) / dentryLookups : 0;
+  double pathHitRatio = pathLookups ? 100.0 * pathCacheStats.pathHits /
+                        pathLookups : 0;
+  std::vector<eos::common::Executor::Stats> executorStats =
+    eos::common::Executor::GetAllStats();
+  eos::common::Logging& g_logging = eos::common::Logging::GetInstance();
+  eos::common::AsyncLogger::Stats logStats = g_logging.GetAsyncStats();
+  // Batches propagated by the accounting listeners, if they do batch
+  std::vector<std::pair<std::string, PropagationStats>> propagationStats;
+
+  if (gOFS->eosContainerAccounting) {
+    propagationStats.emplace_back(
+      "treesize", gOFS->eosContainerAccounting->getPropagationStats());
+  }
+
+  if (gOFS->eosSyncTimeAccounting) {
+    propagationStats.emplace_back(
+      "synctime", gOFS->eosSyncTimeAccounting->getPropagationStats());
+  }
 
   if (stat.monitor()) {
     oss << "uid=all gid=all ns.total.files=" << f << std::endl
@@ -345,6 +463,44 @@ NsCmd::StatSubcmd(const eos::console::NsProto_StatProto& stat)
         << "uid=all gid=all ns.fusex.lockedclients=" <<
         eosxd_locked_clients << std::endl ;
 
+    if (pathCacheStats.enabled) {
+      oss << "uid=all gid=all ns.cache.dentries.maxnum="
+          << pathCacheStats.dentryMaxNum
+          << " ns.cache.dentries.occupancy=" << pathCacheStats.dentryOccupancy
+          << " ns.cache.dentries.hits=" << pathCacheStats.dentryHits
+          << " ns.cache.dentries.negative_hits="
+          << pathCacheStats.dentryNegativeHits
+          << " ns.cache.dentries.misses=" << pathCacheStats.dentryMisses
+          << " ns.cache.dentries.hit_ratio=" << dentryHitRatio
+          << " ns.cache.dentries.invalidations="
+          << pathCacheStats.dentryInvalidations
+          << " ns.cache.dentries.evictions=" << pathCacheStats.dentryEvictions
+          << std::endl
+          << "uid=all gid=all ns.cache.paths.maxnum=" << pathCacheStats.pathMaxNum
+          << " ns.cache.paths.occupancy=" << pathCacheStats.pathOccupancy
+          << " ns.cache.paths.hits=" << pathCacheStats.pathHits
+          << " ns.cache.paths.misses=" << pathCacheStats.pathMisses
+          << " ns.cache.paths.hit_ratio=" << pathHitRatio
+          << " ns.cache.paths.invalidations=" << pathCacheStats.pathInvalidations
+          << " ns.cache.paths.evictions=" << pathCacheStats.pathEvictions
+          << std::endl;
+    }
+
+    for (const auto& prop : propagationStats) {
+      if (prop.second.mBatches) {
+        std::string prefix = " ns.propagation." + prop.first;
+        oss << "uid=all gid=all" << prefix << ".batches="
+            << prop.second.mBatches
+            << prefix << ".touched=" << prop.second.mTotalTouched
+            << prefix << ".latency_us.max=" << prop.second.mMaxLatencyUs
+            << prefix << ".last.queued=" << prop.second.mQueued
+            << prefix << ".last.touched=" << prop.second.mTouched
+            << prefix << ".last.rounds=" << prop.second.mRounds
+            << prefix << ".last.latency_us=" << prop.second.mLatencyUs
+            << std::endl;
+      }
+    }
+
     if (pstat.vsize > gOFS->LinuxStatsStartup.vsize) {
       oss << "uid=all gid=all ns.memory.growth=" << (unsigned long long)
           (pstat.vsize - gOFS->LinuxStatsStartup.vsize) << std::endl;
@@ -353,10 +509,27 @@ NsCmd::StatSubcmd(const eos::console::NsProto_StatProto& stat)
           (-pstat.vsize + gOFS->LinuxStatsStartup.vsize) << std::endl;
     }
 
+    oss << "uid=all gid=all ns.log.async=" << (g_logging.IsAsync() ? "on" : "off")
+        << " ns.log.async.queued=" << logStats.mQueued
+        << " ns.log.async.dropped=" << logStats.mDropped
+        << " ns.log.async.blocked=" << logStats.mBlocked << std::endl;
     oss << "uid=all gid=all ns.uptime="
         << (int)(time(NULL) - gOFS->mStartTime) << std::endl
         << "uid=all gid=all "
         << gOFS->mDrainEngine.GetThreadPoolInfo() << std::endl;
+
+    for (const auto& exec : executorStats) {
+      std::string prefix = " ns.executor." + exec.mName;
+      oss << "uid=all gid=all" << prefix << ".threads=" << exec.mThreads
+          << prefix << ".queued=" << exec.mQueued
+          << prefix << ".submitted=" << exec.mSubmitted
+          << prefix << ".executed=" << exec.mExecuted
+          << prefix << ".steals=" << exec.mSteals
+          << prefix << ".wait.p50=" << exec.mWaitP50 / 1000
+          << prefix << ".wait.p99=" << exec.mWaitP99 / 1000
+          << prefix << ".run.p50=" << exec.mRunP50 / 1000
+          << prefix << ".run.p99=" << exec.mRunP99 / 1000 << std::endl;
+    }
   } else {
     std::string line = "# ------------------------------------------------------"
                        "------------------------------";
@@ -427,6 +600,12 @@ NsCmd::StatSubcmd(const eos::console::NsProto_StatProto& stat)
           std::endl
           << "ALL      In-flight FileMD                 " << fileCacheStats.inFlight <<
           std::endl
+          << "ALL      File cache hits                  " << fileCacheStats.hits <<
+          std::endl
+          << "ALL      File cache misses                " << fileCacheStats.misses <<
+          std::endl
+          << "ALL      File cache evictions             " << fileCacheStats.evictions
+          << std::endl
           << "ALL      Container cache max num          " << containerCacheStats.maxNum
           << std::endl
           << "ALL      Container cache occupancy        " << containerCacheStats.occupancy
@@ -434,9 +613,89 @@ NsCmd::StatSubcmd(const eos::console::NsProto_StatProto& stat)
           << "ALL      In-flight ContainerMD            " << containerCacheStats.inFlight
           <<
           std::endl
+          << "ALL      Container cache hits             " << containerCacheStats.hits
+          << std::endl
+          << "ALL      Container cache misses           " << containerCacheStats.misses
+          << std::endl
+          << "ALL      Container cache evictions        " <<
+          containerCacheStats.evictions << std::endl
+          << line << std::endl;
+    }
+
+    if (pathCacheStats.enabled) {
+      oss << "ALL      Dentry cache max num             "
+          << pathCacheStats.dentryMaxNum << std::endl
+          << "ALL      Dentry cache occupancy           "
+          << pathCacheStats.dentryOccupancy << std::endl
+          << "ALL      Dentry cache hits                "
+          << pathCacheStats.dentryHits << std::endl
+          << "ALL      Dentry cache negative hits       "
+          << pathCacheStats.dentryNegativeHits << std::endl
+          << "ALL      Dentry cache misses              "
+          << pathCacheStats.dentryMisses << std::endl
+          << "ALL      Dentry cache hit ratio           "
+          << dentryHitRatio << " %" << std::endl
+          << "ALL      Dentry cache invalidations       "
+          << pathCacheStats.dentryInvalidations << std::endl
+          << "ALL      Dentry cache evictions           "
+          << pathCacheStats.dentryEvictions << std::endl
+          << "ALL      Path cache max num               "
+          << pathCacheStats.pathMaxNum << std::endl
+          << "ALL      Path cache occupancy             "
+          << pathCacheStats.pathOccupancy << std::endl
+          << "ALL      Path cache hits                  "
+          << pathCacheStats.pathHits << std::endl
+          << "ALL      Path cache misses                "
+          << pathCacheStats.pathMisses << std::endl
+          << "ALL      Path cache hit ratio             "
+          << pathHitRatio << " %" << std::endl
+          << "ALL      Path cache invalidations         "
+          << pathCacheStats.pathInvalidations << std::endl
+          << "ALL      Path cache evictions             "
+          << pathCacheStats.pathEvictions << std::endl
           << line << std::endl;
     }
 
+    bool propagated = false;
+
+    for (const auto& prop : propagationStats) {
+      if (prop.second.mBatches) {
+        oss << "ALL      Propagation " << std::left << std::setw(21)
+            << prop.first
+            << "batches=" << prop.second.mBatches
+            << " touched=" << prop.second.mTotalTouched
+            << " max_latency=" << prop.second.mMaxLatencyUs << "us"
+            << " last(queued/touched/rounds/latency)="
+            << prop.second.mQueued << "/" << prop.second.mTouched << "/"
+            << prop.second.mRounds << "/" << prop.second.mLatencyUs << "us"
+            << std::endl;
+        propagated = true;
+      }
+    }
+
+    if (propagated) {
+      oss << line << std::endl;
+    }
+
+    if (!executorStats.empty()) {
+      for (const auto& exec : executorStats) {
+        oss << "ALL      Executor " << std::left << std::setw(24) << exec.mName
+            << "threads=" << exec.mThreads << " queued=" << exec.mQueued
+            << " executed=" << exec.mExecuted << " steals=" << exec.mSteals
+            << " wait(p50/p99)=" << exec.mWaitP50 / 1000 << "/"
+            << exec.mWaitP99 / 1000 << "us run(p50/p99)="
+            << exec.mRunP50 / 1000 << "/" << exec.mRunP99 / 1000 << "us"
+            << std::endl;
+      }
+
+      oss << line << std::endl;
+    }
+
+    oss << "ALL      Async logging                    "
+        << (g_logging.IsAsync() ? "on" : "off")
+        << " queued=" << logStats.mQueued << " dropped=" << logStats.mDropped
+        << " blocked=" << logStats.mBlocked << std::endl
+        << line << std::endl;
     // Do them one at a time otherwise sizestring is saved only the first time
     oss << "ALL      memory virtual                   "
         << StringConversion::GetReadableSizeString(sizestring, (unsigned long long)
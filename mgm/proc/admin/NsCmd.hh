@@ -67,6 +67,14 @@ private:
   void MutexSubcmd(const eos::console::NsProto_MutexProto& mutex,
                    eos::console::ReplyProto& reply);
 
+  //----------------------------------------------------------------------------
+  //! Get the report of the mutex contention profiler
+  //!
+  //! @return JSON string with the per call site wait/hold percentiles and the
+  //!         longest lock holders
+  //----------------------------------------------------------------------------
+  std::string GetMutexProfile() const;
+
   //----------------------------------------------------------------------------
   //! Execute stat comand
   //!
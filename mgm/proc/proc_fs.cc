@@ -348,7 +348,8 @@ proc_fs_config(std::string& identifier, std::string& key, std::string& value,
            (eos::common::FileSystem::GetConfigStatusFromString(value.c_str()) !=
             eos::common::FileSystem::kUnknown)) ||
           (((key == "headroom") || (key == "scaninterval") ||
-            (key == "scanrate") || (key == "graceperiod") ||
+            (key == "scanrate") || (key == "scanstreams") ||
+            (key == "graceperiod") ||
             (key == "drainperiod") || (key == "proxygroup") ||
             (key == "filestickyproxydepth") || (key == "forcegeotag") ||
             (key == "s3credentials")))) {
@@ -387,8 +388,8 @@ proc_fs_config(std::string& identifier, std::string& key, std::string& value,
         }
 
         if ((key == "headroom") || (key == "scaninterval") ||
-            (key == "scanrate") || (key == "graceperiod") ||
-            (key == "drainperiod")) {
+            (key == "scanrate") || (key == "scanstreams") ||
+            (key == "graceperiod") || (key == "drainperiod")) {
           fs->SetLongLong(key.c_str(),
                           eos::common::StringConversion::GetSizeFromString(value.c_str()));
           FsView::gFsView.StoreFsConfig(fs);
@@ -362,6 +362,28 @@ static bool eliminateBasedOnAttr(const eos::console::FindProto& req,
   return (attr != req.attributevalue());
 }
 
+//------------------------------------------------------------------------------
+//! Check if a find request prints every entry it visits. Counters, the
+//! balance summary and selective filters may write nothing until the
+//! traversal ends, which would leave a streaming client waiting in read.
+//! The same holds for -d without -f, which skips the files silently, and for
+//! --purge, which only reports version directories or atomic files. These
+//! requests keep the file output: the client gets the result once the find
+//! is done.
+//------------------------------------------------------------------------------
+static bool
+printsEveryEntry(const eos::console::FindProto& req)
+{
+  return !(req.count() || req.balance() || req.zerosizefiles() ||
+           (req.directories() && !req.files()) || req.purge().length() ||
+           req.stripediff() || req.faultyacl() || req.mixedgroups() ||
+           req.onehourold() || req.youngerthan() || req.olderthan() ||
+           req.searchuid() || req.searchnotuid() || req.searchgid() ||
+           req.searchnotgid() || req.searchpermission() ||
+           req.searchnotpermission() || req.name().length() ||
+           req.attributekey().length());
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -369,6 +391,9 @@ FindCmd::FindCmd(eos::console::RequestProto&& req,
                  eos::common::Mapping::VirtualIdentity& vid) :
   IProcCommand(std::move(req), vid, true)
 {
+  // Results reach the client while the traversal goes on, as long as there
+  // are results to hand out
+  mStreamOutput = printsEveryEntry(mReqProto.find());
 }
 
 //------------------------------------------------------------------------------
@@ -596,10 +621,15 @@ public:
   // QDB: Initialize NamespaceExplorer
   //----------------------------------------------------------------------------
   FindResultProvider(qclient::QClient* qc, const std::string& target,
-    const eos::common::Mapping::VirtualIdentity &v)
+    const eos::common::Mapping::VirtualIdentity &v, int maxdepth)
     : qcl(qc), path(target), vid(v)
   {
     ExplorationOptions options;
+
+    if (maxdepth > 0) {
+      options.depthLimit = maxdepth;
+    }
+
     options.populateLinkedAttributes = true;
     options.expansionDecider.reset(new PermissionFilter(vid));
     options.view = gOFS->eosView;
@@ -650,6 +680,10 @@ public:
 
     // Search not started yet?
     if (!inMemStarted) {
+      if (found->empty()) {
+        return false;
+      }
+
       dirIterator = found->begin();
       targetFileSet = &dirIterator->second;
       fileIterator = targetFileSet->begin();
@@ -756,7 +790,8 @@ eos::mgm::FindCmd::ProcessRequest() noexcept
 {
   eos::console::ReplyProto reply;
 
-  if (!OpenTemporaryOutputFiles()) {
+  // The files are already open when the output is streamed
+  if (!ofstdoutStream.is_open() && !OpenTemporaryOutputFiles()) {
     reply.set_retc(EIO);
     reply.set_std_err(SSTR(
       "error: cannot write find result files on MGM" << std::endl));
@@ -852,26 +887,37 @@ eos::mgm::FindCmd::ProcessRequest() noexcept
     findResultProvider.reset(new FindResultProvider(
                                eos::BackendClient::getInstance(gOFS->mQdbContactDetails, "find"),
                                findRequest.path(),
-                               mVid
+                               mVid, finddepth
                              ));
   }
 
   unsigned int cnt = 0;
   unsigned long long filecounter = 0;
   unsigned long long dircounter = 0;
+  bool wantfiles = !nofiles && (findRequest.files() || !nodirs);
+  FindResult findResult;
+  // The result file is flushed regularly for a client reading it as it grows
+  auto last_flush = std::chrono::steady_clock::now();
+
+  // Single pass over the results: every entry is filtered and printed as soon
+  // as the provider hands it out, so nothing but the counters is accumulated
+  // and the output reaches the client while the traversal goes on. Stop once
+  // the client is gone.
+  while (!mForceKill && findResultProvider->next(findResult)) {
+    if (std::chrono::steady_clock::now() - last_flush >
+        std::chrono::seconds(1)) {
+      ofstdoutStream.flush();
+      last_flush = std::chrono::steady_clock::now();
+    }
 
-  if (findRequest.files() || !nodirs) {
-    FindResult findResult;
-
-    while (findResultProvider->next(findResult)) {
-      if (findResult.isdir) {
-
-        if(findResult.expansionFilteredOut) {
-          ofstderrStream << "error: no permissions to read directory ";
-          ofstderrStream << findResult.path << std::endl;
-        }
+    if (findResult.isdir) {
+      if (findResult.expansionFilteredOut) {
+        ofstderrStream << "error: no permissions to read directory ";
+        ofstderrStream << findResult.path << std::endl;
+      }
 
-        if (!findRequest.files() && !nodirs) {
+      if (!dirs) {
+        if (!nodirs) {
           if (!printcounter) {
             printPath(ofstdoutStream, findResult.path, printxurl);
             ofstdoutStream << std::endl;
@@ -879,110 +925,7 @@ eos::mgm::FindCmd::ProcessRequest() noexcept
 
           dircounter++;
         }
-      } else {
-        cnt++;
-        std::string fspath = findResult.path;
-        // Fetch fmd for target file
-        std::shared_ptr<eos::IFileMD> fmd = findResult.toFileMD();
-        bool selected = true;
-
-        // Do we have the fmd? If not, skip this entry.
-        if (!fmd) {
-          continue;
-        }
-
-        // fmd looks OK, proceed.
-        // Balance calculation? Ignore selection
-        // criteria (TODO: Change this?) and simply
-        // account all fmd's.
-        if (calcbalance) {
-          balanceCalculator.account(fmd);
-          continue;
-        }
-
-        // Selection
-        if (eliminateBasedOnTime(findRequest, fmd)) {
-          selected = false;
-        }
-
-        if (eliminateBasedOnUidGid(findRequest, fmd)) {
-          selected = false;
-        }
-
-        if (eliminateBasedOnAttr(findRequest, fmd)) {
-          selected = false;
-        }
-
-        if (findzero && fmd->getSize() != 0) {
-          selected = false;
-        }
-
-        if (findgroupmix && !hasMixedSchedGroups(fmd)) {
-          selected = false;
-        }
-
-        if (selectrepdiff &&
-            fmd->getNumLocation() == eos::common::LayoutId::GetStripeNumber(
-              fmd->getLayoutId() + 1)) {
-          selected = false;
-        }
-
-        // Printing
-        if (!selected) {
-          continue;
-        }
-
-        filecounter++;
-
-        // Skip printing each entry if we're only interested in the total count
-        if (printcounter) {
-          continue;
-        }
-
-        // Purge atomic files?
-        if (purge_atomic) {
-          this->ProcessAtomicFilePurge(ofstdoutStream, fspath, *fmd.get());
-          continue;
-        }
-
-        // Modify layout stripes?
-        if (layoutstripes) {
-          this->ModifyLayoutStripes(ofstdoutStream, findRequest, fspath);
-          continue;
-        }
-
-        // Print fileinfo -m?
-        if (printfileinfo) {
-          this->PrintFileInfoMinusM(fspath, errInfo);
-          continue;
-        }
-
-        // Print simple?
-        if (printSimple) {
-          printPath(ofstdoutStream, fspath, printxurl);
-          ofstdoutStream << std::endl;
-          continue;
-        }
-
-        // Nope, print fancy
-        ofstdoutStream << "path=";
-        printPath(ofstdoutStream, fspath, printxurl);
-        printFMD(ofstdoutStream, findRequest, fmd);
-        ofstdoutStream << std::endl;
-      }
-    }
 
-    gOFS->MgmStats.Add("FindEntries", mVid.uid, mVid.gid, cnt);
-  }
-
-  eos_debug("Listing directories");
-
-  if (dirs) {
-    FindResult findResult;
-
-    while (findResultProvider->next(findResult)) {
-      // Only interested in directories here.
-      if (!findResult.isdir) {
         continue;
       }
 
@@ -1062,9 +1005,116 @@ eos::mgm::FindCmd::ProcessRequest() noexcept
       printPath(ofstdoutStream, findResult.path, printxurl);
       printUidGid(ofstdoutStream, findRequest, mCmd);
       ofstdoutStream << std::endl;
+      continue;
+    }
+
+    if (!wantfiles) {
+      continue;
+    }
+
+    // The in-memory find already applied the name filter
+    if (gOFS->NsInQDB && filematch.length()) {
+      eos::common::Path fPath(findResult.path.c_str());
+      XrdOucString name = fPath.GetName();
+
+      if (!name.matches(filematch.c_str())) {
+        continue;
+      }
+    }
+
+    cnt++;
+    std::string fspath = findResult.path;
+    // Fetch fmd for target file
+    std::shared_ptr<eos::IFileMD> fmd = findResult.toFileMD();
+    bool selected = true;
+
+    // Do we have the fmd? If not, skip this entry.
+    if (!fmd) {
+      continue;
+    }
+
+    // fmd looks OK, proceed.
+    // Balance calculation? Ignore selection
+    // criteria (TODO: Change this?) and simply
+    // account all fmd's.
+    if (calcbalance) {
+      balanceCalculator.account(fmd);
+      continue;
+    }
+
+    // Selection
+    if (eliminateBasedOnTime(findRequest, fmd)) {
+      selected = false;
+    }
+
+    if (eliminateBasedOnUidGid(findRequest, fmd)) {
+      selected = false;
+    }
+
+    if (eliminateBasedOnAttr(findRequest, fmd)) {
+      selected = false;
+    }
+
+    if (findzero && fmd->getSize() != 0) {
+      selected = false;
+    }
+
+    if (findgroupmix && !hasMixedSchedGroups(fmd)) {
+      selected = false;
+    }
+
+    if (selectrepdiff &&
+        fmd->getNumLocation() == eos::common::LayoutId::GetStripeNumber(
+          fmd->getLayoutId() + 1)) {
+      selected = false;
+    }
+
+    // Printing
+    if (!selected) {
+      continue;
+    }
+
+    filecounter++;
+
+    // Skip printing each entry if we're only interested in the total count
+    if (printcounter) {
+      continue;
+    }
+
+    // Purge atomic files?
+    if (purge_atomic) {
+      this->ProcessAtomicFilePurge(ofstdoutStream, fspath, *fmd.get());
+      continue;
+    }
+
+    // Modify layout stripes?
+    if (layoutstripes) {
+      this->ModifyLayoutStripes(ofstdoutStream, findRequest, fspath);
+      continue;
+    }
+
+    // Print fileinfo -m?
+    if (printfileinfo) {
+      this->PrintFileInfoMinusM(fspath, errInfo);
+      continue;
+    }
+
+    // Print simple?
+    if (printSimple) {
+      printPath(ofstdoutStream, fspath, printxurl);
+      ofstdoutStream << std::endl;
+      continue;
     }
+
+    // Nope, print fancy
+    ofstdoutStream << "path=";
+    printPath(ofstdoutStream, fspath, printxurl);
+    printFMD(ofstdoutStream, findRequest, fmd);
+    ofstdoutStream << std::endl;
   }
 
+  gOFS->MgmStats.Add("FindEntries", mVid.uid, mVid.gid, cnt);
+
   if (printcounter) {
     ofstdoutStream << "nfiles=" << filecounter << " ndirectories=" << dircounter <<
                    std::endl;
@@ -61,6 +61,11 @@ ProcCommand::FuseX()
   XrdOucString authid = pOpaque->Get("mgm.authid") ? pOpaque->Get("mgm.authid") :
                         "";
   bool inlined = pOpaque->Get("mgm.inline") ? true : false; // clients supports inlined responses in error messages
+  // paginated listings: page size and where to resume
+  XrdOucString slimit = pOpaque->Get("mgm.ls.limit") ? pOpaque->Get("mgm.ls.limit") :
+                        "0";
+  XrdOucString scursor = pOpaque->Get("mgm.ls.cursor") ?
+                         pOpaque->Get("mgm.ls.cursor") : "";
 
   if (spath.length()) {
     // decode escaped path name
@@ -194,6 +199,8 @@ ProcCommand::FuseX()
 
     if (sop == "LS") {
       md.set_operation(md.LS);
+      md.set_ls_limit(strtoul(slimit.c_str(), 0, 10));
+      md.set_ls_cursor(scursor.c_str());
     }
 
     if (sop == "GETCAP") {
@@ -223,7 +230,8 @@ ProcCommand::FuseX()
       eos_debug("c1=%llu c2=%llu", md_clock, clock);
     }
 
-    if ((sop == "GET") || (sop == "LS")) {
+    // the following pages of a listing are always served
+    if ((sop == "GET") || ((sop == "LS") && !scursor.length())) {
       if (md_clock == clock) {
         // if the given clock is ok, we return EEXIST
         return gOFS->Emsg("FuseX", *mError, EEXIST, "get-if-clock", inpath);
@@ -43,10 +43,9 @@ ProcCommand::Who()
   bool showall = false;
   bool showauth = false;
   bool showsummary = false;
-  // call the expiration functions
-  eos::common::Mapping::ActiveLock.Lock();
-  eos::common::Mapping::ActiveExpire(300, true);
-  google::dense_hash_map<std::string, time_t>::const_iterator it;
+  // get the clients active within the last 5 minutes
+  std::vector<std::pair<std::string, time_t>> active;
+  eos::common::Mapping::ActiveTidents.Collect(300, active);
 
   if ((option.find("m")) != std::string::npos) {
     monitoring = true;
@@ -68,8 +67,7 @@ ProcCommand::Who()
     showsummary = true;
   }
 
-  for (it = eos::common::Mapping::ActiveTidents.begin();
-       it != eos::common::Mapping::ActiveTidents.end(); it++) {
+  for (auto it = active.begin(); it != active.end(); it++) {
     std::string username = "";
     tokens.clear();
     std::string intoken = it->first.c_str();
@@ -81,8 +79,6 @@ ProcCommand::Who()
     authcount[tokens[2]]++;
   }
 
-  eos::common::Mapping::ActiveLock.UnLock();
-
   if (showauth || showall) {
     std::map<std::string, int>::const_iterator it;
 
@@ -121,12 +117,10 @@ ProcCommand::Who()
     }
   }
 
-  eos::common::Mapping::ActiveLock.Lock();
   unsigned long long cnt = 0;
 
   if (showclients || showall || showsummary) {
-    for (it = eos::common::Mapping::ActiveTidents.begin();
-         it != eos::common::Mapping::ActiveTidents.end(); it++) {
+    for (auto it = active.begin(); it != active.end(); it++) {
       cnt++;
       std::string username = "";
       tokens.clear();
@@ -158,8 +152,6 @@ ProcCommand::Who()
     }
   }
 
-  eos::common::Mapping::ActiveLock.UnLock();
-
   if (showsummary) {
     char formatline[1024];
 
@@ -0,0 +1,427 @@
+//------------------------------------------------------------------------------
+//! @file XrdMqSharedHashCodec.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mq/XrdMqSharedHashCodec.hh"
+#include <cstring>
+
+namespace
+{
+const char sBase64Chars[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+//------------------------------------------------------------------------------
+//! Reverse lookup table for base64 decoding, -1 marks invalid characters
+//------------------------------------------------------------------------------
+struct Base64Table {
+  int8_t mValue[256];
+
+  Base64Table()
+  {
+    memset(mValue, -1, sizeof(mValue));
+
+    for (int i = 0; i < 64; ++i) {
+      mValue[(unsigned char) sBase64Chars[i]] = i;
+    }
+  }
+};
+
+const Base64Table sBase64Table;
+
+//------------------------------------------------------------------------------
+// Append base64 encoding of the input to the output string
+//------------------------------------------------------------------------------
+void
+AppendBase64(const std::string& in, std::string& out)
+{
+  const unsigned char* ptr = (const unsigned char*) in.data();
+  size_t len = in.length();
+  size_t pos = out.length();
+  out.resize(pos + 4 * ((len + 2) / 3));
+  char* dst = &out[pos];
+  size_t i = 0;
+
+  for (; i + 2 < len; i += 3) {
+    uint32_t triple = (ptr[i] << 16) | (ptr[i + 1] << 8) | ptr[i + 2];
+    *dst++ = sBase64Chars[(triple >> 18) & 0x3f];
+    *dst++ = sBase64Chars[(triple >> 12) & 0x3f];
+    *dst++ = sBase64Chars[(triple >> 6) & 0x3f];
+    *dst++ = sBase64Chars[triple & 0x3f];
+  }
+
+  if (i < len) {
+    uint32_t triple = ptr[i] << 16;
+
+    if (i + 1 < len) {
+      triple |= ptr[i + 1] << 8;
+    }
+
+    *dst++ = sBase64Chars[(triple >> 18) & 0x3f];
+    *dst++ = sBase64Chars[(triple >> 12) & 0x3f];
+    *dst++ = ((i + 1 < len) ? sBase64Chars[(triple >> 6) & 0x3f] : '=');
+    *dst++ = '=';
+  }
+}
+
+//------------------------------------------------------------------------------
+// Decode base64 input
+//------------------------------------------------------------------------------
+bool
+DecodeBase64(const char* in, size_t len, std::string& out)
+{
+  if (len % 4) {
+    return false;
+  }
+
+  out.clear();
+  out.reserve(3 * (len / 4));
+
+  for (size_t i = 0; i < len; i += 4) {
+    int8_t v[4];
+    int npad = 0;
+
+    for (int j = 0; j < 4; ++j) {
+      unsigned char c = in[i + j];
+
+      if ((c == '=') && (i + 4 == len) && (j >= 2)) {
+        v[j] = 0;
+        ++npad;
+      } else if (npad || ((v[j] = sBase64Table.mValue[c]) < 0)) {
+        return false;
+      }
+    }
+
+    uint32_t triple = (v[0] << 18) | (v[1] << 12) | (v[2] << 6) | v[3];
+    out += (char)((triple >> 16) & 0xff);
+
+    if (npad < 2) {
+      out += (char)((triple >> 8) & 0xff);
+    }
+
+    if (npad < 1) {
+      out += (char)(triple & 0xff);
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Append unsigned varint
+//------------------------------------------------------------------------------
+void
+PutVarint(std::string& out, uint64_t value)
+{
+  while (value >= 0x80) {
+    out += (char)((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+
+  out += (char) value;
+}
+
+//------------------------------------------------------------------------------
+// Append length prefixed string
+//------------------------------------------------------------------------------
+void
+PutString(std::string& out, const std::string& value)
+{
+  PutVarint(out, value.length());
+  out += value;
+}
+
+//------------------------------------------------------------------------------
+//! Bounds checked reader over the decoded record
+//------------------------------------------------------------------------------
+class Reader
+{
+public:
+  Reader(const std::string& data):
+    mPtr(data.data()), mEnd(data.data() + data.length())
+  {}
+
+  bool
+  GetByte(uint8_t& value)
+  {
+    if (mPtr >= mEnd) {
+      return false;
+    }
+
+    value = (uint8_t) * mPtr++;
+    return true;
+  }
+
+  bool
+  GetVarint(uint64_t& value)
+  {
+    value = 0;
+
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (mPtr >= mEnd) {
+        return false;
+      }
+
+      uint8_t byte = (uint8_t) * mPtr++;
+      value |= (uint64_t)(byte & 0x7f) << shift;
+
+      if (!(byte & 0x80)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  bool
+  GetString(std::string& value)
+  {
+    uint64_t len;
+
+    if (!GetVarint(len) || (len > (uint64_t)(mEnd - mPtr))) {
+      return false;
+    }
+
+    value.assign(mPtr, len);
+    mPtr += len;
+    return true;
+  }
+
+  bool
+  AtEnd() const
+  {
+    return (mPtr == mEnd);
+  }
+
+private:
+  const char* mPtr;
+  const char* mEnd;
+};
+}
+
+//------------------------------------------------------------------------------
+// Check if message body holds a binary encoded transaction
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedHashCodec::IsBinary(const char* body)
+{
+  return (body && (strncmp(body, XRDMQSHAREDHASH_BINARY,
+                           sizeof(XRDMQSHAREDHASH_BINARY) - 1) == 0));
+}
+
+//------------------------------------------------------------------------------
+// Check if value can be sent as integer
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedHashCodec::IsCanonicalInteger(const std::string& value,
+    int64_t& number)
+{
+  size_t len = value.length();
+  size_t pos = ((len && value[0] == '-') ? 1 : 0);
+  size_t ndigits = len - pos;
+
+  // 18 digits always fit in an int64_t
+  if ((ndigits == 0) || (ndigits > 18)) {
+    return false;
+  }
+
+  if ((value[pos] == '0') && ((ndigits > 1) || pos)) {
+    return false;
+  }
+
+  int64_t result = 0;
+
+  for (size_t i = pos; i < len; ++i) {
+    if ((value[i] < '0') || (value[i] > '9')) {
+      return false;
+    }
+
+    result = result * 10 + (value[i] - '0');
+  }
+
+  number = (pos ? -result : result);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Encode transaction as message body
+//------------------------------------------------------------------------------
+void
+XrdMqSharedHashCodec::Encode(const XrdMqSharedHashDelta& delta,
+                             std::string& out)
+{
+  std::string record;
+  record.reserve(64 + 32 * delta.mEntries.size());
+  record += (char) sVersion;
+  record += (char) delta.mCmd;
+  PutString(record, delta.mType);
+  PutVarint(record, delta.mSubjects.size());
+
+  for (const auto& subject : delta.mSubjects) {
+    PutString(record, subject);
+  }
+
+  PutVarint(record, delta.mEntries.size());
+  int64_t number;
+
+  for (const auto& entry : delta.mEntries) {
+    PutVarint(record, entry.mSubject);
+    PutString(record, entry.mKey);
+
+    if (delta.mCmd == XrdMqSharedHashDelta::kDelete) {
+      continue;
+    }
+
+    if (IsCanonicalInteger(entry.mValue, number)) {
+      record += (char) kInteger;
+      // Zig-zag encoding keeps small negative numbers short
+      PutVarint(record, ((uint64_t) number << 1) ^ (uint64_t)(number >> 63));
+    } else {
+      record += (char) kString;
+      PutString(record, entry.mValue);
+    }
+
+    PutVarint(record, entry.mChangeId);
+  }
+
+  out = XRDMQSHAREDHASH_BINARY;
+  AppendBase64(record, out);
+}
+
+//------------------------------------------------------------------------------
+// Decode message body
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedHashCodec::Decode(const char* body, XrdMqSharedHashDelta& delta,
+                             std::string& error)
+{
+  if (!IsBinary(body)) {
+    error = "not a binary shared hash message";
+    return false;
+  }
+
+  body += sizeof(XRDMQSHAREDHASH_BINARY) - 1;
+  std::string record;
+
+  if (!DecodeBase64(body, strlen(body), record)) {
+    error = "binary message: invalid base64 encoding";
+    return false;
+  }
+
+  Reader reader(record);
+  uint8_t version, cmd;
+
+  if (!reader.GetByte(version) || !reader.GetByte(cmd)) {
+    error = "binary message: truncated header";
+    return false;
+  }
+
+  if (version != sVersion) {
+    error = "binary message: unsupported version ";
+    error += std::to_string(version);
+    return false;
+  }
+
+  if ((cmd != XrdMqSharedHashDelta::kUpdate) &&
+      (cmd != XrdMqSharedHashDelta::kBcReply) &&
+      (cmd != XrdMqSharedHashDelta::kDelete)) {
+    error = "binary message: unknown command ";
+    error += std::to_string(cmd);
+    return false;
+  }
+
+  delta.mCmd = (XrdMqSharedHashDelta::Cmd) cmd;
+  uint64_t count;
+
+  if (!reader.GetString(delta.mType) || !reader.GetVarint(count) ||
+      (count > record.length())) {
+    error = "binary message: truncated subject list";
+    return false;
+  }
+
+  delta.mSubjects.resize(count);
+
+  for (auto& subject : delta.mSubjects) {
+    if (!reader.GetString(subject)) {
+      error = "binary message: truncated subject list";
+      return false;
+    }
+  }
+
+  if (!reader.GetVarint(count) || (count > record.length())) {
+    error = "binary message: truncated entry list";
+    return false;
+  }
+
+  delta.mEntries.resize(count);
+
+  for (auto& entry : delta.mEntries) {
+    uint64_t subject;
+
+    if (!reader.GetVarint(subject) || (subject >= delta.mSubjects.size()) ||
+        !reader.GetString(entry.mKey)) {
+      error = "binary message: corrupted entry";
+      return false;
+    }
+
+    entry.mSubject = subject;
+    entry.mChangeId = 0;
+
+    if (delta.mCmd == XrdMqSharedHashDelta::kDelete) {
+      entry.mValue.clear();
+      continue;
+    }
+
+    uint8_t kind;
+    uint64_t value;
+
+    if (!reader.GetByte(kind)) {
+      error = "binary message: corrupted entry";
+      return false;
+    }
+
+    if (kind == kInteger) {
+      if (!reader.GetVarint(value)) {
+        error = "binary message: corrupted entry";
+        return false;
+      }
+
+      int64_t number = (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+      entry.mValue = std::to_string(number);
+    } else if ((kind != kString) || !reader.GetString(entry.mValue)) {
+      error = "binary message: corrupted entry";
+      return false;
+    }
+
+    if (!reader.GetVarint(value)) {
+      error = "binary message: corrupted entry";
+      return false;
+    }
+
+    entry.mChangeId = value;
+  }
+
+  if (!reader.AtEnd()) {
+    error = "binary message: trailing data";
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,130 @@
+//------------------------------------------------------------------------------
+//! @file XrdMqSharedHashCodec.hh
+//! @brief Compact binary encoding of shared hash transactions
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __XRDMQ_SHAREDHASHCODEC_HH__
+#define __XRDMQ_SHAREDHASHCODEC_HH__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//! Body prefix of binary encoded shared hash messages
+#define XRDMQSHAREDHASH_BINARY    "mqsh.bin="
+
+//------------------------------------------------------------------------------
+//! Decoded form of a shared hash transaction
+//------------------------------------------------------------------------------
+struct XrdMqSharedHashDelta {
+  //! Commands which can be binary encoded
+  enum Cmd : uint8_t {
+    kUpdate = 1, ///< Update of the listed keys
+    kBcReply = 2, ///< Full content sent as reply to a broadcast request
+    kDelete = 3 ///< Deletion of the listed keys
+  };
+
+  //! Single key of the transaction
+  struct Entry {
+    uint32_t mSubject; ///< Index in mSubjects the key belongs to
+    std::string mKey; ///< Key name
+    std::string mValue; ///< Value, empty for deletions
+    unsigned long long mChangeId; ///< Change id of the value
+  };
+
+  Cmd mCmd = kUpdate; ///< Command
+  std::string mType; ///< Shared object type i.e. hash or queue
+  std::vector<std::string> mSubjects; ///< Subjects touched by the transaction
+  std::vector<Entry> mEntries; ///< Modified or deleted keys
+};
+
+//------------------------------------------------------------------------------
+//! Class XrdMqSharedHashCodec
+//!
+//! Encodes shared hash transactions as a versioned binary record carried in
+//! the message body as "mqsh.bin=<base64>". Strings are length prefixed and
+//! values which are canonical decimal integers travel as zig-zag varints so
+//! that they are restored byte for byte on the receiving side. The receiver
+//! works directly on the record without building an XrdOucEnv.
+//!
+//! Record layout (version 1):
+//!   u8 version, u8 cmd, str type, varint n_subjects, str subject...,
+//!   varint n_entries, entry...
+//! where an entry is
+//!   varint subject, str key [, u8 value_kind, value, varint change_id]
+//! and the value part is omitted for deletions.
+//------------------------------------------------------------------------------
+class XrdMqSharedHashCodec
+{
+public:
+  //! Current version of the record layout
+  static constexpr uint8_t sVersion = 1;
+
+  //----------------------------------------------------------------------------
+  //! Check if message body holds a binary encoded transaction
+  //!
+  //! @param body message body
+  //!
+  //! @return true if binary encoded, otherwise false
+  //----------------------------------------------------------------------------
+  static bool IsBinary(const char* body);
+
+  //----------------------------------------------------------------------------
+  //! Encode transaction as message body
+  //!
+  //! @param delta transaction to encode
+  //! @param out output message body including the XRDMQSHAREDHASH_BINARY
+  //!        prefix
+  //----------------------------------------------------------------------------
+  static void Encode(const XrdMqSharedHashDelta& delta, std::string& out);
+
+  //----------------------------------------------------------------------------
+  //! Decode message body
+  //!
+  //! @param body message body including the XRDMQSHAREDHASH_BINARY prefix
+  //! @param delta decoded transaction
+  //! @param error error message in case of failure
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool Decode(const char* body, XrdMqSharedHashDelta& delta,
+                     std::string& error);
+
+private:
+  //! Kind of the encoded value
+  enum ValueKind : uint8_t {
+    kString = 0, ///< Value sent as string
+    kInteger = 1 ///< Value sent as zig-zag encoded varint
+  };
+
+  //----------------------------------------------------------------------------
+  //! Check if value is a decimal integer which is restored exactly by
+  //! printing it back i.e. no sign for zero, no leading zeros, fits in int64
+  //!
+  //! @param value string value
+  //! @param number parsed number
+  //!
+  //! @return true if value can be sent as integer, otherwise false
+  //----------------------------------------------------------------------------
+  static bool IsCanonicalInteger(const std::string& value, int64_t& number);
+};
+
+#endif // __XRDMQ_SHAREDHASHCODEC_HH__
@@ -405,8 +405,14 @@ bool
 XrdMqSharedHash::CloseTransaction()
 {
   bool retval = true;
-
-  if (mSOM->mBroadcast && mTransactions.size()) {
+  bool binary = (mSOM->mBinaryEncoding && CanEncodeBinary());
+
+  if (mSOM->mBroadcast && mTransactions.size() && binary) {
+    XrdMqSharedHashDelta delta;
+    delta.mCmd = XrdMqSharedHashDelta::kUpdate;
+    AddTransactionsToDelta(delta, false);
+    retval &= XrdMqSharedObjectManager::SendDelta(delta, mBroadcastQueue.c_str());
+  } else if (mSOM->mBroadcast && mTransactions.size()) {
     XrdOucString txmessage = "";
     MakeUpdateEnvHeader(txmessage);
     AddTransactionsToEnvString(txmessage, false);
@@ -448,7 +454,12 @@ XrdMqSharedHash::CloseTransaction()
     }
   }
 
-  if (mSOM->mBroadcast && mDeletions.size()) {
+  if (mSOM->mBroadcast && mDeletions.size() && binary) {
+    XrdMqSharedHashDelta delta;
+    delta.mCmd = XrdMqSharedHashDelta::kDelete;
+    AddDeletionsToDelta(delta);
+    retval &= XrdMqSharedObjectManager::SendDelta(delta, mBroadcastQueue.c_str());
+  } else if (mSOM->mBroadcast && mDeletions.size()) {
     XrdOucString txmessage = "";
     MakeDeletionEnvHeader(txmessage);
     AddDeletionsToEnvString(txmessage);
@@ -537,9 +548,11 @@ XrdMqSharedHash::MakeRemoveEnvHeader(XrdOucString& out)
 // Broadcast hash as env string
 //-------------------------------------------------------------------------------
 bool
-XrdMqSharedHash::BroadCastEnvString(const char* receiver)
+XrdMqSharedHash::BroadCastEnvString(const char* receiver, bool binary)
 {
   XrdOucString txmessage = "";
+  XrdMqSharedHashDelta delta;
+  binary = (binary && CanEncodeBinary());
   {
     XrdSysMutexHelper lock(*mTransactMutex);
     mTransactions.clear();
@@ -551,12 +564,27 @@ XrdMqSharedHash::BroadCastEnvString(const char* receiver)
         mTransactions.insert(it->first);
       }
     }
-    MakeBroadCastEnvHeader(txmessage);
     // This will also clear the mTransactions set
-    AddTransactionsToEnvString(txmessage);
+    if (binary) {
+      delta.mCmd = XrdMqSharedHashDelta::kBcReply;
+      AddTransactionsToDelta(delta);
+    } else {
+      MakeBroadCastEnvHeader(txmessage);
+      AddTransactionsToEnvString(txmessage);
+    }
+
     mIsTransaction = false;
   }
 
+  if (mSOM->mBroadcast && binary) {
+    if (XrdMqSharedObjectManager::sDebug) {
+      fprintf(stderr, "XrdMqSharedObjectManager::BroadCastEnvString=>[%s]=>%s "
+              "binary\n", mSubject.c_str(), receiver);
+    }
+
+    return XrdMqSharedObjectManager::SendDelta(delta, receiver);
+  }
+
   if (mSOM->mBroadcast) {
     XrdMqMessage message("XrdMqSharedHashMessage");
     message.SetBody(txmessage.c_str());
@@ -626,6 +654,52 @@ XrdMqSharedHash::AddDeletionsToEnvString(XrdOucString& out)
   mDeletions.clear();
 }
 
+//-------------------------------------------------------------------------------
+// Add transactions to binary delta - this must be called with the
+// mTransactMutex locked.
+//-------------------------------------------------------------------------------
+void
+XrdMqSharedHash::AddTransactionsToDelta(XrdMqSharedHashDelta& delta,
+                                        bool clear_after)
+{
+  delta.mType = mType;
+  delta.mSubjects.assign(1, mSubject);
+  delta.mEntries.reserve(delta.mEntries.size() + mTransactions.size());
+  {
+    RWMutexReadLock rd_lock(*mStoreMutex);
+
+    for (auto it = mTransactions.begin(); it != mTransactions.end(); ++it) {
+      auto it_store = mStore.find(*it);
+
+      if (it_store != mStore.end()) {
+        delta.mEntries.push_back({0, *it, it_store->second.GetValue(),
+                                  it_store->second.GetChangeId()});
+      }
+    }
+  }
+
+  if (clear_after) {
+    mTransactions.clear();
+  }
+}
+
+//-------------------------------------------------------------------------------
+// Add deletions to binary delta - this must be called with the mTransactMutex
+// locked.
+//-------------------------------------------------------------------------------
+void
+XrdMqSharedHash::AddDeletionsToDelta(XrdMqSharedHashDelta& delta)
+{
+  delta.mType = mType;
+  delta.mSubjects.assign(1, mSubject);
+
+  for (auto it = mDeletions.begin(); it != mDeletions.end(); ++it) {
+    delta.mEntries.push_back({0, *it, "", 0});
+  }
+
+  mDeletions.clear();
+}
+
 //-------------------------------------------------------------------------------
 // Build and send broadcast request
 //-------------------------------------------------------------------------------
@@ -647,6 +721,10 @@ XrdMqSharedHash::BroadcastRequest(const char* req_target)
   out += XRDMQSHAREDHASH_TYPE;
   out += "=";
   out += mType.c_str();
+  // Announce that the reply can be binary encoded, older versions ignore it
+  out += "&";
+  out += XRDMQSHAREDHASH_ENCODING;
+  out += "=bin";
   message.SetBody(out.c_str());
   message.MarkAsMonitor();
   return XrdMqMessaging::gMessageClient.SendMessage(message, req_target, false,
@@ -1034,6 +1112,11 @@ XrdMqSharedQueue::SetImpl(const char* key, const char* value, bool broadcast)
   if (mStore.find(uuid) == mStore.end()) {
     if (XrdMqSharedHash::SetImpl(uuid.c_str(), value, broadcast)) {
       mQueue.push_back(uuid);
+
+      if (mSOM) {
+        mSOM->NotifyQueueListeners(mSubject);
+      }
+
       return true;
     }
   }
@@ -2436,6 +2519,12 @@ XrdMqSharedObjectManager::XrdMqSharedObjectManager():
   AutoReplyQueue = "";
   AutoReplyQueueDerive = false;
   IsMuxTransaction = false;
+
+  if (getenv("EOS_MQ_BINARY_ENCODING") &&
+      (std::string(getenv("EOS_MQ_BINARY_ENCODING")) == "1")) {
+    mBinaryEncoding = true;
+  }
+
   {
     XrdSysMutexHelper mLock(MuxTransactionsMutex);
     MuxTransactions.clear();
@@ -2496,6 +2585,7 @@ XrdMqSharedObjectManager::CreateSharedHash(const char* subject,
     XrdMqSharedHash* newhash = new XrdMqSharedHash(subject, broadcastqueue,
         som ? som : this);
     mHashSubjects.insert(std::pair<std::string, XrdMqSharedHash*> (ss, newhash));
+    mHashSuffixIndex.insert(std::string(ss.rbegin(), ss.rend()));
     HashMutex.UnLockWrite();
 
     if (mEnableQueue) {
@@ -2527,6 +2617,7 @@ XrdMqSharedObjectManager::CreateSharedQueue(const char* subject,
   } else {
     mQueueSubjects.emplace(ss, XrdMqSharedQueue(subject, broadcastqueue,
                            som ? som : this));
+    mQueueSuffixIndex.insert(std::string(ss.rbegin(), ss.rend()));
     HashMutex.UnLockWrite();
 
     if (mEnableQueue) {
@@ -2582,6 +2673,7 @@ XrdMqSharedObjectManager::DeleteSharedHash(const char* subject, bool broadcast)
 
     delete(mHashSubjects[ss]);
     mHashSubjects.erase(ss);
+    mHashSuffixIndex.erase(std::string(ss.rbegin(), ss.rend()));
     HashMutex.UnLockWrite();
 
     if (mEnableQueue) {
@@ -2611,7 +2703,7 @@ XrdMqSharedObjectManager::DeleteSharedQueue(const char* subject, bool broadcast)
   if ((mQueueSubjects.count(ss) > 0)) {
     if (mBroadcast && broadcast) {
       XrdOucString txmessage = "";
-      mHashSubjects[ss]->MakeRemoveEnvHeader(txmessage);
+      mQueueSubjects[ss].MakeRemoveEnvHeader(txmessage);
       XrdMqMessage message("XrdMqSharedHashMessage");
       message.SetBody(txmessage.c_str());
       message.MarkAsMonitor();
@@ -2619,6 +2711,7 @@ XrdMqSharedObjectManager::DeleteSharedQueue(const char* subject, bool broadcast)
     }
 
     mQueueSubjects.erase(ss);
+    mQueueSuffixIndex.erase(std::string(ss.rbegin(), ss.rend()));
     HashMutex.UnLockWrite();
 
     if (mEnableQueue) {
@@ -2684,6 +2777,54 @@ XrdMqSharedObjectManager::GetQueue(const char* subject)
   }
 }
 
+//------------------------------------------------------------------------------
+// Register a queue insertion listener
+//------------------------------------------------------------------------------
+uint64_t
+XrdMqSharedObjectManager::AddQueueListener(const std::string& subject,
+    std::function<void()> listener)
+{
+  std::lock_guard<std::mutex> lock(mQueueListenersMutex);
+  uint64_t id = ++mQueueListenerId;
+  mQueueListeners[subject][id] = std::move(listener);
+  return id;
+}
+
+//------------------------------------------------------------------------------
+// Remove a queue insertion listener
+//------------------------------------------------------------------------------
+void
+XrdMqSharedObjectManager::RemoveQueueListener(const std::string& subject,
+    uint64_t id)
+{
+  std::lock_guard<std::mutex> lock(mQueueListenersMutex);
+  auto it = mQueueListeners.find(subject);
+
+  if (it != mQueueListeners.end()) {
+    it->second.erase(id);
+
+    if (it->second.empty()) {
+      mQueueListeners.erase(it);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Call the listeners of a queue
+//------------------------------------------------------------------------------
+void
+XrdMqSharedObjectManager::NotifyQueueListeners(const std::string& subject)
+{
+  std::lock_guard<std::mutex> lock(mQueueListenersMutex);
+  auto it = mQueueListeners.find(subject);
+
+  if (it != mQueueListeners.end()) {
+    for (const auto& listener : it->second) {
+      listener.second();
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 // Dump contents of all shared objects to the output string
 //------------------------------------------------------------------------------
@@ -2780,6 +2921,10 @@ XrdMqSharedObjectManager::ParseEnvMessage(XrdMqMessage* message,
     return false;
   }
 
+  if (XrdMqSharedHashCodec::IsBinary(message->GetBody())) {
+    return ParseBinaryMessage(message->GetBody(), error);
+  }
+
   XrdOucEnv env(message->GetBody());
   int envlen;
   env.Env(envlen);
@@ -2814,56 +2959,7 @@ XrdMqSharedObjectManager::ParseEnvMessage(XrdMqMessage* message,
     HashMutex.LockRead();
     XrdMqSharedHash* sh = 0;
     std::vector<std::string> subjectlist;
-    int wpos = 0;
-
-    // support 'wild card' broadcasts with <name>/*
-    if ((wpos = subject.find("/*")) != STR_NPOS) {
-      XrdOucString wmatch = subject.c_str();
-      wmatch.erase(wpos);
-
-      for (auto it = mHashSubjects.begin(); it != mHashSubjects.end(); ++it) {
-        XrdOucString hs = it->first.c_str();
-
-        if (hs.beginswith(wmatch)) {
-          subjectlist.push_back(hs.c_str());
-        }
-      }
-
-      for (auto it = mQueueSubjects.begin(); it != mQueueSubjects.end(); ++it) {
-        XrdOucString hs = it->first.c_str();
-
-        if (hs.beginswith(wmatch)) {
-          subjectlist.push_back(hs.c_str());
-        }
-      }
-    } else {
-      // support 'wild card' broadcasts with */<name>
-      if ((subject.find("*/")) == 0) {
-        XrdOucString wmatch = subject.c_str();
-        wmatch.erase(0, 2);
-
-        for (auto it = mHashSubjects.begin(); it != mHashSubjects.end(); ++it) {
-          XrdOucString hs = it->first.c_str();
-
-          if (hs.endswith(wmatch)) {
-            subjectlist.push_back(hs.c_str());
-          }
-        }
-
-        for (auto it = mQueueSubjects.begin(); it != mQueueSubjects.end(); ++it) {
-          XrdOucString hs = it->first.c_str();
-
-          if (hs.endswith(wmatch)) {
-            subjectlist.push_back(hs.c_str());
-          }
-        }
-      } else {
-        std::string delimiter = "%";
-        // we support also multiplexed subject updates and split the list
-        eos::common::StringConversion::Tokenize(subject, subjectlist, delimiter);
-      }
-    }
-
+    MatchSubjects(subject, subjectlist);
     XrdOucString ftag = XRDMQSHAREDHASH_CMD;
     ftag += "=";
     ftag += env.Get(XRDMQSHAREDHASH_CMD);
@@ -2917,26 +3013,8 @@ XrdMqSharedObjectManager::ParseEnvMessage(XrdMqMessage* message,
       if (!sh) {
         HashMutex.UnLockRead();
 
-        if (AutoReplyQueueDerive) {
-          AutoReplyQueue = subject.c_str();
-          int pos = 0;
-
-          for (int i = 0; i < 4; i++) {
-            pos = subject.find("/", pos);
-
-            if (i < 3) {
-              if (pos == STR_NPOS) {
-                AutoReplyQueue = "";
-                error = "cannot derive the reply queue from ";
-                error += subject.c_str();
-                return false;
-              } else {
-                pos++;
-              }
-            } else {
-              AutoReplyQueue.erase(pos);
-            }
-          }
+        if (!DeriveAutoReplyQueue(subject, error)) {
+          return false;
         }
 
         // create the list of subjects
@@ -3077,6 +3155,9 @@ XrdMqSharedObjectManager::ParseEnvMessage(XrdMqMessage* message,
 
       if (ftag == XRDMQSHAREDHASH_BCREQUEST) {
         bool success = true;
+        // The requester announces if it understands binary encoded replies
+        bool binary = (env.Get(XRDMQSHAREDHASH_ENCODING) &&
+                       (strcmp(env.Get(XRDMQSHAREDHASH_ENCODING), "bin") == 0));
 
         for (unsigned int l = 0; l < subjectlist.size(); l++) {
           // try 'queue' and 'hash' to have wildcard broadcasts for both
@@ -3087,7 +3168,7 @@ XrdMqSharedObjectManager::ParseEnvMessage(XrdMqMessage* message,
           }
 
           if (sh) {
-            success *= sh->BroadCastEnvString(reply.c_str());
+            success *= sh->BroadCastEnvString(reply.c_str(), binary);
           }
         }
 
@@ -3149,6 +3230,226 @@ XrdMqSharedObjectManager::ParseEnvMessage(XrdMqMessage* message,
   return false;
 }
 
+//------------------------------------------------------------------------------
+// Resolve the subject of a message to the list of subjects it refers to
+//------------------------------------------------------------------------------
+void
+XrdMqSharedObjectManager::MatchSubjects(const std::string& subject,
+                                        std::vector<std::string>& subjects)
+{
+  size_t wpos = subject.find("/*");
+
+  // Support 'wild card' broadcasts with <name>/* - the subject maps are sorted
+  // so all the matches follow the lower bound of the prefix
+  if (wpos != std::string::npos) {
+    std::string prefix = subject.substr(0, wpos);
+
+    for (auto it = mHashSubjects.lower_bound(prefix);
+         (it != mHashSubjects.end()) &&
+         (it->first.compare(0, prefix.length(), prefix) == 0); ++it) {
+      subjects.push_back(it->first);
+    }
+
+    for (auto it = mQueueSubjects.lower_bound(prefix);
+         (it != mQueueSubjects.end()) &&
+         (it->first.compare(0, prefix.length(), prefix) == 0); ++it) {
+      subjects.push_back(it->first);
+    }
+
+    return;
+  }
+
+  // Support 'wild card' broadcasts with */<name> using the reversed subjects
+  if (subject.find("*/") == 0) {
+    std::string rsuffix(subject.rbegin(), subject.rend() - 2);
+
+    for (auto* index : {
+           &mHashSuffixIndex, &mQueueSuffixIndex
+         }) {
+      size_t first = subjects.size();
+
+      for (auto it = index->lower_bound(rsuffix); (it != index->end()) &&
+           (it->compare(0, rsuffix.length(), rsuffix) == 0); ++it) {
+        subjects.emplace_back(it->rbegin(), it->rend());
+      }
+
+      // Keep the matches in subject order
+      std::sort(subjects.begin() + first, subjects.end());
+    }
+
+    return;
+  }
+
+  // We support also multiplexed subject updates and split the list
+  eos::common::StringConversion::Tokenize(subject, subjects, "%");
+}
+
+//------------------------------------------------------------------------------
+// Derive the auto reply queue from the subject if requested
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedObjectManager::DeriveAutoReplyQueue(const std::string& subject,
+    XrdOucString& error)
+{
+  if (AutoReplyQueueDerive) {
+    AutoReplyQueue = subject.c_str();
+    int pos = 0;
+
+    for (int i = 0; i < 4; i++) {
+      pos = subject.find("/", pos);
+
+      if (i < 3) {
+        if (pos == STR_NPOS) {
+          AutoReplyQueue = "";
+          error = "cannot derive the reply queue from ";
+          error += subject.c_str();
+          return false;
+        } else {
+          pos++;
+        }
+      } else {
+        AutoReplyQueue.erase(pos);
+      }
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Parse and apply a binary encoded message
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedObjectManager::ParseBinaryMessage(const char* body,
+    XrdOucString& error)
+{
+  XrdMqSharedHashDelta delta;
+  std::string decode_error;
+
+  if (!XrdMqSharedHashCodec::Decode(body, delta, decode_error)) {
+    error = decode_error.c_str();
+    return false;
+  }
+
+  if (delta.mSubjects.empty()) {
+    error = "no subject in message body";
+    return false;
+  }
+
+  if (sDebug) {
+    fprintf(stderr, "XrdMqSharedObjectManager::ParseBinaryMessage=> cmd=%d "
+            "subject=%s nsubjects=%zu nentries=%zu\n", (int) delta.mCmd,
+            delta.mSubjects[0].c_str(), delta.mSubjects.size(),
+            delta.mEntries.size());
+  }
+
+  bool is_delete = (delta.mCmd == XrdMqSharedHashDelta::kDelete);
+  std::vector<std::string> missing;
+  {
+    RWMutexReadLock lock(HashMutex);
+
+    for (const auto& subject : delta.mSubjects) {
+      if (!GetObject(subject.c_str(), delta.mType.c_str())) {
+        missing.push_back(subject);
+      }
+    }
+  }
+
+  if (!missing.empty()) {
+    if (is_delete) {
+      error = "delete: don't know this subject ";
+      error += missing[0].c_str();
+      return false;
+    }
+
+    // Automatically create the subjects which don't exist
+    if (!DeriveAutoReplyQueue(delta.mSubjects[0], error)) {
+      return false;
+    }
+
+    for (const auto& subject : missing) {
+      if (!CreateSharedObject(subject.c_str(), AutoReplyQueue.c_str(),
+                              delta.mType.c_str())) {
+        error = "cannot create shared object for ";
+        error += subject.c_str();
+        error += " and type ";
+        error += delta.mType.c_str();
+        return false;
+      }
+    }
+  }
+
+  RWMutexReadLock lock(HashMutex);
+  std::vector<XrdMqSharedHash*> hashes;
+  hashes.reserve(delta.mSubjects.size());
+
+  for (const auto& subject : delta.mSubjects) {
+    XrdMqSharedHash* sh = GetObject(subject.c_str(), delta.mType.c_str());
+
+    if (!sh) {
+      error = "update: subject ";
+      error += subject.c_str();
+      error += " does not exist (FATAL!)";
+      return false;
+    }
+
+    if (delta.mCmd == XrdMqSharedHashDelta::kBcReply) {
+      // We don't have to broad cast this clear => it is a broad cast reply
+      sh->Clear(false);
+    }
+
+    hashes.push_back(sh);
+  }
+
+  for (const auto& entry : delta.mEntries) {
+    if (is_delete) {
+      hashes[entry.mSubject]->Delete(entry.mKey, false);
+    } else {
+      // Set entry without broadcast
+      hashes[entry.mSubject]->Set(entry.mKey.c_str(), entry.mValue.c_str(),
+                                  false);
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Send binary encoded transaction
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedObjectManager::SendDelta(const XrdMqSharedHashDelta& delta,
+                                    const char* receiver)
+{
+  std::string body;
+  XrdMqSharedHashCodec::Encode(delta, body);
+
+  if ((body.length() > (2 * 1000 * 1000)) && (delta.mEntries.size() > 1) &&
+      (delta.mCmd == XrdMqSharedHashDelta::kUpdate)) {
+    // Set the message size limit to 2M, if the message is bigger then just
+    // send transaction item by item.
+    bool retval = true;
+    XrdMqSharedHashDelta single;
+    single.mCmd = delta.mCmd;
+    single.mType = delta.mType;
+
+    for (const auto& entry : delta.mEntries) {
+      single.mSubjects.assign(1, delta.mSubjects[entry.mSubject]);
+      single.mEntries.assign(1, entry);
+      single.mEntries[0].mSubject = 0;
+      retval &= SendDelta(single, receiver);
+    }
+
+    return retval;
+  }
+
+  XrdMqMessage message("XrdMqSharedHashMessage");
+  message.SetBody(body.c_str());
+  message.MarkAsMonitor();
+  return XrdMqMessaging::gMessageClient.SendMessage(message, receiver, false,
+         false, true);
+}
+
 //------------------------------------------------------------------------------
 //
 //------------------------------------------------------------------------------
@@ -3176,7 +3477,34 @@ XrdMqSharedObjectManager::CloseMuxTransaction()
   // no deletions of subjects
   XrdSysMutexHelper mLock(MuxTransactionsMutex);
 
-  if (MuxTransactions.size()) {
+  if (MuxTransactions.size() && mBinaryEncoding) {
+    XrdMqSharedHashDelta delta;
+    delta.mCmd = XrdMqSharedHashDelta::kUpdate;
+    delta.mType = MuxTransactionType;
+
+    for (auto it_subj = MuxTransactions.begin(); it_subj != MuxTransactions.end();
+         ++it_subj) {
+      uint32_t index = delta.mSubjects.size();
+      delta.mSubjects.push_back(it_subj->first);
+      XrdMqSharedHash* hash = GetObject(it_subj->first.c_str(),
+                                        MuxTransactionType.c_str());
+
+      if (hash) {
+        RWMutexReadLock lock(*(hash->mStoreMutex));
+
+        for (auto it = it_subj->second.begin(); it != it_subj->second.end(); ++it) {
+          auto it_store = hash->mStore.find(*it);
+
+          if (it_store != hash->mStore.end()) {
+            delta.mEntries.push_back({index, *it, it_store->second.GetValue(),
+                                      it_store->second.GetChangeId()});
+          }
+        }
+      }
+    }
+
+    SendDelta(delta, MuxTransactionBroadCastQueue.c_str());
+  } else if (MuxTransactions.size()) {
     XrdOucString txmessage = "";
     MakeMuxUpdateEnvHeader(txmessage);
     AddMuxTransactionEnvString(txmessage);
@@ -25,6 +25,7 @@
 #define __XRDMQ_SHAREDHASH_HH__
 
 #include "mq/XrdMqClient.hh"
+#include "mq/XrdMqSharedHashCodec.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include "XrdSys/XrdSysSemWait.hh"
 #include "mgm/TableFormatter/TableCell.hh"
@@ -38,6 +39,8 @@
 #include <deque>
 #include <regex.h>
 #include <atomic>
+#include <functional>
+#include <mutex>
 
 #define XRDMQSHAREDHASH_CMD       "mqsh.cmd"
 #define XRDMQSHAREDHASH_UPDATE    "mqsh.cmd=update"
@@ -51,6 +54,7 @@
 #define XRDMQSHAREDHASH_KEYS      "mqsh.keys"
 #define XRDMQSHAREDHASH_REPLY     "mqsh.reply"
 #define XRDMQSHAREDHASH_TYPE      "mqsh.type"
+#define XRDMQSHAREDHASH_ENCODING  "mqsh.enc"
 
 //! Forward declaration
 class XrdMqSharedObjectManager;
@@ -500,14 +504,40 @@ private:
   //----------------------------------------------------------------------------
   void AddDeletionsToEnvString(XrdOucString& out);
 
+  //----------------------------------------------------------------------------
+  //! Add transactions to binary delta
+  //!
+  //! @param delta delta to fill in
+  //! @param clear_after if true clear transactions afterward, otherwise not
+  //----------------------------------------------------------------------------
+  void AddTransactionsToDelta(XrdMqSharedHashDelta& delta,
+                              bool clear_after = true);
+
+  //----------------------------------------------------------------------------
+  //! Add deletions to binary delta
+  //!
+  //! @param delta delta to fill in
+  //----------------------------------------------------------------------------
+  void AddDeletionsToDelta(XrdMqSharedHashDelta& delta);
+
+  //----------------------------------------------------------------------------
+  //! Check if the updates of this hash can be binary encoded. Wildcard
+  //! subjects are only understood by the text encoding.
+  //----------------------------------------------------------------------------
+  inline bool CanEncodeBinary() const
+  {
+    return (mSubject.find('*') == std::string::npos);
+  }
+
   //----------------------------------------------------------------------------
   //! Broadcast hash as env string
   //!
   //! @param receiver target of the broadcast message
+  //! @param binary if true use the binary encoding
   //!
   //! @return true if message sent successful, otherwise false
   //----------------------------------------------------------------------------
-  bool BroadCastEnvString(const char* receiver);
+  bool BroadCastEnvString(const char* receiver, bool binary = false);
 };
 
 
@@ -672,6 +702,28 @@ public:
     return mBroadcast;
   }
 
+  //----------------------------------------------------------------------------
+  //! Switch the encoding of the updates sent by this manager. The text
+  //! encoding is the default since all the receivers have to understand the
+  //! binary one. Broadcast replies are binary encoded whenever the requester
+  //! announces support for it, independently of this setting. Can also be
+  //! enabled by setting EOS_MQ_BINARY_ENCODING=1 in the environment.
+  //!
+  //! @param enable if true use the binary encoding, otherwise the text one
+  //----------------------------------------------------------------------------
+  inline void SetBinaryEncoding(bool enable)
+  {
+    mBinaryEncoding = enable;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Indicate if updates are binary encoded
+  //----------------------------------------------------------------------------
+  inline bool UseBinaryEncoding() const
+  {
+    return mBinaryEncoding;
+  }
+
   //----------------------------------------------------------------------------
   //!
   //----------------------------------------------------------------------------
@@ -765,6 +817,35 @@ public:
   //----------------------------------------------------------------------------
   XrdMqSharedQueue* GetQueue(const char* subject);
 
+  //----------------------------------------------------------------------------
+  //! Register a listener called after every insertion into a shared queue,
+  //! both local ones and those received from the broadcaster. The listener
+  //! runs with the queue locked: it must be cheap and must not call back into
+  //! the shared object manager.
+  //!
+  //! @param subject queue subject, the queue does not need to exist yet
+  //! @param listener callable
+  //!
+  //! @return listener id to be used for removal
+  //----------------------------------------------------------------------------
+  uint64_t AddQueueListener(const std::string& subject,
+                            std::function<void()> listener);
+
+  //----------------------------------------------------------------------------
+  //! Remove a queue listener
+  //!
+  //! @param subject queue subject
+  //! @param id listener id returned by AddQueueListener
+  //----------------------------------------------------------------------------
+  void RemoveQueueListener(const std::string& subject, uint64_t id);
+
+  //----------------------------------------------------------------------------
+  //! Call the listeners of a queue
+  //!
+  //! @param subject queue subject
+  //----------------------------------------------------------------------------
+  void NotifyQueueListeners(const std::string& subject);
+
   //----------------------------------------------------------------------------
   //! Dump contents of all shared objects to the output string
   //!
@@ -773,7 +854,13 @@ public:
   void DumpSharedObjects(XrdOucString& out);
 
   //----------------------------------------------------------------------------
+  //! Parse and apply a shared object message, both the text and the binary
+  //! encodings are accepted
   //!
+  //! @param message received message
+  //! @param error error message in case of failure
+  //!
+  //! @return true if successful, otherwise false
   //----------------------------------------------------------------------------
   bool ParseEnvMessage(XrdMqMessage* message, XrdOucString& error);
 
@@ -838,17 +925,70 @@ protected:
 
 private:
   std::atomic<bool> mBroadcast {true}; ///< Broadcast mode, default on
+  std::atomic<bool> mBinaryEncoding {false}; ///< Binary encoding of updates
   AssistedThread mDumperTid; ///< Dumper thread tid
+  std::mutex mQueueListenersMutex; ///< Mutex protecting the queue listeners
+  //! Map of queue subjects to their insertion listeners by id
+  std::map<std::string, std::map<uint64_t, std::function<void()>>>
+      mQueueListeners;
+  uint64_t mQueueListenerId {0}; ///< Last queue listener id
   ///! Map of subjects to shared hash objects
   std::map<std::string, XrdMqSharedHash*> mHashSubjects;
   ///! Map of subjects to shared queue objects
   std::map<std::string, XrdMqSharedQueue> mQueueSubjects;
+  //! Reversed hash and queue subjects used to resolve "*/<name>" wildcards,
+  //! "<name>/*" wildcards are resolved directly on the sorted subject maps
+  std::set<std::string> mHashSuffixIndex;
+  std::set<std::string> mQueueSuffixIndex;
   std::string mDumperFile; ///< File where dumps are written
   //! Queue used to setup the reply queue of hashes which have been broadcasted
   std::string AutoReplyQueue;
   //! True if the reply queue is derived from the subject e.g. the subject
   // "/eos/<host>/fst/<path>" derives as "/eos/<host>/fst"
   bool AutoReplyQueueDerive;
+
+  //----------------------------------------------------------------------------
+  //! Resolve the subject of a message to the list of subjects it refers to.
+  //! Supports "<name>/*" and "*/<name>" wildcards and multiplexed subjects
+  //! separated by '%'. Must be called with a lock on HashMutex.
+  //!
+  //! @param subject message subject
+  //! @param subjects list of matching subjects
+  //----------------------------------------------------------------------------
+  void MatchSubjects(const std::string& subject,
+                     std::vector<std::string>& subjects);
+
+  //----------------------------------------------------------------------------
+  //! Derive the auto reply queue from the subject if requested
+  //!
+  //! @param subject message subject
+  //! @param error error message in case of failure
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool DeriveAutoReplyQueue(const std::string& subject, XrdOucString& error);
+
+  //----------------------------------------------------------------------------
+  //! Parse and apply a binary encoded message
+  //!
+  //! @param body message body
+  //! @param error error message in case of failure
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool ParseBinaryMessage(const char* body, XrdOucString& error);
+
+  //----------------------------------------------------------------------------
+  //! Send binary encoded transaction. Updates exceeding the message size
+  //! limit are sent key by key.
+  //!
+  //! @param delta transaction to send
+  //! @param receiver target of the message
+  //!
+  //! @return true if message(s) sent successfully, otherwise false
+  //----------------------------------------------------------------------------
+  static bool SendDelta(const XrdMqSharedHashDelta& delta,
+                        const char* receiver);
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,290 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Per-container and per-file locks for namespace mutations
+//------------------------------------------------------------------------------
+
+#include "namespace/MDLocking.hh"
+#include "namespace/MDException.hh"
+#include "namespace/interface/IView.hh"
+#include <algorithm>
+
+EOSNSNAMESPACE_BEGIN
+
+namespace
+{
+//! Set while the thread holds an MDLocker
+thread_local bool tHoldsMDLocker = false;
+
+//! Attempts of lockForUpdate before giving up on moving targets
+constexpr int kMaxLockAttempts = 16;
+
+//------------------------------------------------------------------------------
+//! Resolve a mutation target, return false if anything changed compared to
+//! the previous resolution
+//------------------------------------------------------------------------------
+bool
+resolveTarget(IView* view, MDLockTarget& target)
+{
+  IContainerMDPtr cont = view->getContainer(target.mPath);
+  IFileMDPtr file;
+  IContainerMDPtr subcont;
+
+  if (!target.mName.empty()) {
+    file = cont->findFile(target.mName);
+
+    if (!file) {
+      subcont = cont->findContainer(target.mName);
+    }
+  }
+
+  bool same = target.mContainer &&
+              (target.mContainer->getId() == cont->getId()) &&
+              ((target.mFile ? target.mFile->getId() : 0) ==
+               (file ? file->getId() : 0)) &&
+              ((target.mSubContainer ? target.mSubContainer->getId() : 0) ==
+               (subcont ? subcont->getId() : 0));
+  target.mContainer = std::move(cont);
+  target.mFile = std::move(file);
+  target.mSubContainer = std::move(subcont);
+  return same;
+}
+
+//------------------------------------------------------------------------------
+//! Lock a stripe, counting the acquisitions which have to wait
+//------------------------------------------------------------------------------
+template <typename Stripe>
+void
+lockStripe(Stripe& stripe, std::atomic<uint64_t>& contended)
+{
+  if (!stripe.mMutex.try_lock()) {
+    contended.fetch_add(1, std::memory_order_relaxed);
+    stripe.mMutex.lock();
+  }
+}
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+MDLockTable::MDLockTable(size_t stripes):
+  mContended(0)
+{
+  size_t size = 1;
+
+  while (size < stripes) {
+    size <<= 1;
+  }
+
+  mMask = size - 1;
+  mContainers.reset(new Stripe[size]);
+  mFiles.reset(new Stripe[size]);
+}
+
+//------------------------------------------------------------------------------
+// Add a container to the set
+//------------------------------------------------------------------------------
+MDLocker&
+MDLocker::addContainer(IContainerMD::id_t id)
+{
+  if (mEnabled) {
+    mContainerStripes.push_back(mTable.getContainerStripe(id));
+  }
+
+  return *this;
+}
+
+//------------------------------------------------------------------------------
+// Add a file to the set
+//------------------------------------------------------------------------------
+MDLocker&
+MDLocker::addFile(IFileMD::id_t id)
+{
+  if (mEnabled) {
+    mFileStripes.push_back(mTable.getFileStripe(id));
+  }
+
+  return *this;
+}
+
+//------------------------------------------------------------------------------
+// Lock all the entries of the set
+//------------------------------------------------------------------------------
+void
+MDLocker::lock()
+{
+  if (mLocked) {
+    return;
+  }
+
+  if (!mEnabled) {
+    mLocked = true;
+    return;
+  }
+
+  if (tHoldsMDLocker) {
+    throw_mdexception(EDEADLK, "Thread already holds namespace entry locks");
+  }
+
+  // Entries sharing a stripe are locked once
+  for (auto* stripes : {
+         &mContainerStripes, &mFileStripes
+       }) {
+    std::sort(stripes->begin(), stripes->end());
+    stripes->erase(std::unique(stripes->begin(), stripes->end()),
+                   stripes->end());
+  }
+
+  for (size_t stripe : mContainerStripes) {
+    lockStripe(mTable.mContainers[stripe], mTable.mContended);
+  }
+
+  for (size_t stripe : mFileStripes) {
+    lockStripe(mTable.mFiles[stripe], mTable.mContended);
+  }
+
+  mLocked = true;
+  tHoldsMDLocker = true;
+}
+
+//------------------------------------------------------------------------------
+// Unlock all the entries of the set
+//------------------------------------------------------------------------------
+void
+MDLocker::unlock()
+{
+  if (!mLocked) {
+    return;
+  }
+
+  if (!mEnabled) {
+    mLocked = false;
+    return;
+  }
+
+  for (auto it = mFileStripes.rbegin(); it != mFileStripes.rend(); ++it) {
+    mTable.mFiles[*it].mMutex.unlock();
+  }
+
+  for (auto it = mContainerStripes.rbegin(); it != mContainerStripes.rend();
+       ++it) {
+    mTable.mContainers[*it].mMutex.unlock();
+  }
+
+  mLocked = false;
+  tHoldsMDLocker = false;
+}
+
+//------------------------------------------------------------------------------
+// Empty the set
+//------------------------------------------------------------------------------
+void
+MDLocker::clear()
+{
+  if (!mLocked) {
+    mContainerStripes.clear();
+    mFileStripes.clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Acquire the global namespace lock
+//------------------------------------------------------------------------------
+void
+MDMutationLock::Grab()
+{
+  if (mHeld) {
+    return;
+  }
+
+  if (mEntryLocks) {
+    mNsMutex.LockRead();
+  } else {
+    mNsMutex.LockWrite();
+  }
+
+  mHeld = true;
+}
+
+//------------------------------------------------------------------------------
+// Release the entry locks and the global namespace lock
+//------------------------------------------------------------------------------
+void
+MDMutationLock::Release()
+{
+  if (!mHeld) {
+    return;
+  }
+
+  mLocker.unlock();
+
+  if (mEntryLocks) {
+    mNsMutex.UnLockRead();
+  } else {
+    mNsMutex.UnLockWrite();
+  }
+
+  mHeld = false;
+}
+
+//------------------------------------------------------------------------------
+// Resolve and lock the targets of a namespace mutation
+//------------------------------------------------------------------------------
+void
+lockForUpdate(IView* view, std::vector<MDLockTarget>& targets,
+              MDLocker& locker)
+{
+  for (auto& target : targets) {
+    target.mContainer.reset();
+    (void) resolveTarget(view, target);
+  }
+
+  for (int attempt = 0; attempt < kMaxLockAttempts; ++attempt) {
+    locker.clear();
+
+    for (const auto& target : targets) {
+      locker.addContainer(target.mContainer->getId());
+
+      if (target.mFile) {
+        locker.addFile(target.mFile->getId());
+      }
+
+      if (target.mSubContainer) {
+        locker.addContainer(target.mSubContainer->getId());
+      }
+    }
+
+    locker.lock();
+    bool stable = true;
+
+    for (auto& target : targets) {
+      stable = resolveTarget(view, target) && stable;
+    }
+
+    if (stable) {
+      return;
+    }
+
+    locker.unlock();
+  }
+
+  throw_mdexception(EAGAIN, "Namespace entries keep moving, giving up locking");
+}
+
+EOSNSNAMESPACE_END
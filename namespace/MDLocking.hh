@@ -0,0 +1,323 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Per-container and per-file locks for namespace mutations
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include "namespace/interface/IContainerMD.hh"
+#include "namespace/interface/IFileMD.hh"
+#include "common/RWMutex.hh"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+class IView;
+
+//------------------------------------------------------------------------------
+//! Class MDLockTable
+//!
+//! Striped table of locks over container and file ids. The locks
+//! are not stored in the metadata objects, which can be evicted from the
+//! caches and reloaded at any time, but in two fixed arrays indexed by a hash
+//! of the id. Distinct ids may share a stripe, which only costs some false
+//! sharing between unrelated mutations.
+//!
+//! Locking protocol for namespace mutations:
+//! 1. take the global namespace lock for reading, it only excludes the rare
+//!    structural operations which still take it for writing;
+//! 2. lock all the containers and files touched by the mutation at once with
+//!    one MDLocker: the parent container(s), plus the moved or removed entry.
+//!    Containers are locked before files and both in ascending stripe order,
+//!    so any two mutations acquire their common stripes in the same order
+//!    and can not deadlock.
+//! A thread must never hold two MDLockers at the same time.
+//!
+//! Readers only hold the global lock for reading and take no entry locks, so
+//! they may run in the middle of a mutation. Caches derived from the
+//! namespace and filled by readers (the dentry and path caches of the
+//! QuarkDB view) use epochs: a fill is dropped if an invalidation happened
+//! since the reader took the epoch. For this to work, an entry must be
+//! invalidated after the change it depends on is visible, never only before:
+//! - dentries (parent id, name) are invalidated by the container entry
+//!   listeners, which run after the child maps were updated, so the add and
+//!   remove halves of renameFile, renameContainer and unlinkFile are covered;
+//! - container uris depend on the names of all the ancestors. removeContainer
+//!   invalidates them before setName runs, so renameContainer invalidates
+//!   them again once the new name is set. File uris are not cached.
+//!
+//! This only applies to namespace implementations whose services are safe to
+//! call concurrently (QuarkDB). The in-memory services allocate ids and write
+//! their changelogs without any internal locking, so their mutations must
+//! keep taking the global namespace lock for writing, see MDMutationLock.
+//------------------------------------------------------------------------------
+class MDLockTable
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param stripes number of stripes of each table, rounded up to a power
+  //!        of two
+  //----------------------------------------------------------------------------
+  explicit MDLockTable(size_t stripes = 4096);
+
+  //----------------------------------------------------------------------------
+  //! Get the stripe of a container
+  //----------------------------------------------------------------------------
+  inline size_t getContainerStripe(IContainerMD::id_t id) const
+  {
+    return hash(id) & mMask;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the stripe of a file
+  //----------------------------------------------------------------------------
+  inline size_t getFileStripe(IFileMD::id_t id) const
+  {
+    return hash(id) & mMask;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of stripes of each table
+  //----------------------------------------------------------------------------
+  inline size_t getNumStripes() const
+  {
+    return mMask + 1;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of lock acquisitions which had to wait
+  //----------------------------------------------------------------------------
+  inline uint64_t getContended() const
+  {
+    return mContended.load(std::memory_order_relaxed);
+  }
+
+private:
+  friend class MDLocker;
+
+  //! Lock padded to a cache line, neighbouring stripes don't share one
+  struct alignas(64) Stripe {
+    std::mutex mMutex;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Spread consecutive ids over the stripes
+  //----------------------------------------------------------------------------
+  static inline uint64_t hash(uint64_t id)
+  {
+    id ^= id >> 33;
+    id *= 0xff51afd7ed558ccdULL;
+    id ^= id >> 33;
+    return id;
+  }
+
+  size_t mMask; ///< Number of stripes minus one
+  std::unique_ptr<Stripe[]> mContainers; ///< Container stripes
+  std::unique_ptr<Stripe[]> mFiles; ///< File stripes
+  std::atomic<uint64_t> mContended; ///< Acquisitions which had to wait
+};
+
+//------------------------------------------------------------------------------
+//! Class MDLocker
+//!
+//! Exclusive lock over the set of containers and files touched by one
+//! namespace mutation. Collect the entries with addContainer / addFile and
+//! acquire them all in one go with lock(). Released by unlock() or when going
+//! out of scope. A disabled locker only tracks its state and locks nothing,
+//! it is used when the global namespace lock is held for writing anyway.
+//------------------------------------------------------------------------------
+class MDLocker
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param table lock table
+  //! @param enabled if false the locker does not lock any entry
+  //----------------------------------------------------------------------------
+  explicit MDLocker(MDLockTable& table, bool enabled = true):
+    mTable(table), mEnabled(enabled), mLocked(false) {}
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~MDLocker()
+  {
+    unlock();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Add a container to the set, before lock() only
+  //----------------------------------------------------------------------------
+  MDLocker& addContainer(IContainerMD::id_t id);
+
+  //----------------------------------------------------------------------------
+  //! Add a file to the set, before lock() only
+  //----------------------------------------------------------------------------
+  MDLocker& addFile(IFileMD::id_t id);
+
+  //----------------------------------------------------------------------------
+  //! Lock all the entries of the set, in deterministic order. Throws
+  //! MDException EDEADLK if the thread already holds another MDLocker.
+  //----------------------------------------------------------------------------
+  void lock();
+
+  //----------------------------------------------------------------------------
+  //! Unlock all the entries of the set
+  //----------------------------------------------------------------------------
+  void unlock();
+
+  //----------------------------------------------------------------------------
+  //! Empty the set, it must be unlocked
+  //----------------------------------------------------------------------------
+  void clear();
+
+  //----------------------------------------------------------------------------
+  //! Check if the set is locked
+  //----------------------------------------------------------------------------
+  inline bool isLocked() const
+  {
+    return mLocked;
+  }
+
+  MDLocker(const MDLocker&) = delete;
+  MDLocker& operator=(const MDLocker&) = delete;
+
+private:
+  MDLockTable& mTable; ///< Lock table
+  std::vector<size_t> mContainerStripes; ///< Container stripes of the set
+  std::vector<size_t> mFileStripes; ///< File stripes of the set
+  const bool mEnabled; ///< Entries are actually locked
+  bool mLocked; ///< Set is locked
+};
+
+//------------------------------------------------------------------------------
+//! Class MDMutationLock
+//!
+//! Namespace lock of one mutation. With entry locks it takes the global
+//! namespace lock for reading and the caller locks the touched entries with
+//! locker(). Without entry locks it takes the global namespace lock for
+//! writing and locker() is disabled, so the same call sites serve both
+//! namespace implementations.
+//------------------------------------------------------------------------------
+class MDMutationLock
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor, acquires the global namespace lock
+  //!
+  //! @param ns_mutex global namespace mutex
+  //! @param table entry lock table
+  //! @param entry_locks if true lock the touched entries, otherwise take the
+  //!        global namespace lock for writing
+  //----------------------------------------------------------------------------
+  MDMutationLock(eos::common::RWMutex& ns_mutex, MDLockTable& table,
+                 bool entry_locks):
+    mNsMutex(ns_mutex), mLocker(table, entry_locks), mEntryLocks(entry_locks),
+    mHeld(false)
+  {
+    Grab();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~MDMutationLock()
+  {
+    Release();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Acquire the global namespace lock again after Release, the entries
+  //! have to be locked again by the caller
+  //----------------------------------------------------------------------------
+  void Grab();
+
+  //----------------------------------------------------------------------------
+  //! Release the entry locks and the global namespace lock
+  //----------------------------------------------------------------------------
+  void Release();
+
+  //----------------------------------------------------------------------------
+  //! Get the entry locker
+  //----------------------------------------------------------------------------
+  inline MDLocker& locker()
+  {
+    return mLocker;
+  }
+
+  MDMutationLock(const MDMutationLock&) = delete;
+  MDMutationLock& operator=(const MDMutationLock&) = delete;
+
+private:
+  eos::common::RWMutex& mNsMutex; ///< Global namespace mutex
+  MDLocker mLocker; ///< Entry locker
+  const bool mEntryLocks; ///< Global lock taken for reading only
+  bool mHeld; ///< Global lock held
+};
+
+//------------------------------------------------------------------------------
+//! Container touched by a namespace mutation, optionally with one of its
+//! entries. Filled in by lockForUpdate.
+//------------------------------------------------------------------------------
+struct MDLockTarget {
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param path container path
+  //! @param name name of the entry in the container to lock as well, empty
+  //!        for none. If no such entry exists only the container is locked.
+  //----------------------------------------------------------------------------
+  MDLockTarget(const std::string& path, const std::string& name = ""):
+    mPath(path), mName(name) {}
+
+  std::string mPath; ///< Container path
+  std::string mName; ///< Entry name, empty for none
+  IContainerMDPtr mContainer; ///< Locked container
+  IFileMDPtr mFile; ///< Locked file entry, if any
+  IContainerMDPtr mSubContainer; ///< Locked container entry, if any
+};
+
+//------------------------------------------------------------------------------
+//! Resolve and lock the targets of a namespace mutation. The caller holds the
+//! global namespace lock, for reading or, with a disabled locker, for
+//! writing. The targets are resolved, locked all at
+//! once and resolved again: if a container or an entry was moved in the
+//! meantime the locker is released and the whole sequence is retried, so on
+//! return the targets are the ones currently found at their paths and they
+//! can no longer be moved or removed by a concurrent mutation.
+//!
+//! @param view namespace view
+//! @param targets mutation targets
+//! @param locker empty and unlocked locker, locked on return
+//!
+//! Throws MDException if a container does not exist, or EAGAIN if the
+//! targets keep moving.
+//------------------------------------------------------------------------------
+void lockForUpdate(IView* view, std::vector<MDLockTarget>& targets,
+                   MDLocker& locker);
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,304 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Bulk loader warming up the metadata caches
+//------------------------------------------------------------------------------
+
+#include "namespace/MetadataWarmup.hh"
+#include "namespace/interface/ContainerIterators.hh"
+#include "namespace/interface/IContainerMDSvc.hh"
+#include "namespace/interface/IFileMDSvc.hh"
+#include "namespace/interface/IView.hh"
+#include "qclient/QClient.hh"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+MetadataWarmup::MetadataWarmup(IView* view, size_t max_in_flight,
+                               uint64_t max_items, bool with_children):
+  mView(view), mMaxInFlight(max_in_flight ? max_in_flight : 1),
+  mMaxItems(max_items), mWithChildren(with_children), mStop(false)
+{}
+
+//------------------------------------------------------------------------------
+// Add a file or container given by path
+//------------------------------------------------------------------------------
+void
+MetadataWarmup::addPath(const std::string& path)
+{
+  mPending.push_back(Request{Kind::kPath, 0, path, mWithChildren});
+}
+
+//------------------------------------------------------------------------------
+// Add a file given by id
+//------------------------------------------------------------------------------
+void
+MetadataWarmup::addFileId(IFileMD::id_t id)
+{
+  mPending.push_back(Request{Kind::kFile, id, "", false});
+}
+
+//------------------------------------------------------------------------------
+// Add a container given by id
+//------------------------------------------------------------------------------
+void
+MetadataWarmup::addContainerId(IContainerMD::id_t id)
+{
+  mPending.push_back(Request{Kind::kContainer, id, "", mWithChildren});
+}
+
+//------------------------------------------------------------------------------
+// Add the entries of a warm-up list file
+//------------------------------------------------------------------------------
+int64_t
+MetadataWarmup::addList(const std::string& filename)
+{
+  std::ifstream file(filename);
+
+  if (!file.is_open()) {
+    return -1;
+  }
+
+  return addEntries(file);
+}
+
+//------------------------------------------------------------------------------
+// Add the entries of a warm-up list stored in QuarkDB
+//------------------------------------------------------------------------------
+int64_t
+MetadataWarmup::addList(qclient::QClient& qcl, const std::string& key)
+{
+  qclient::redisReplyPtr reply = qcl.exec("GET", key).get();
+
+  if ((reply == nullptr) || (reply->type != REDIS_REPLY_STRING)) {
+    return -1;
+  }
+
+  std::istringstream in(std::string(reply->str, reply->len));
+  return addEntries(in);
+}
+
+//------------------------------------------------------------------------------
+// Add the entries of a warm-up list, one per line
+//------------------------------------------------------------------------------
+int64_t
+MetadataWarmup::addEntries(std::istream& in)
+{
+  int64_t count = 0;
+  std::string line;
+
+  while (std::getline(in, line)) {
+    if (line.empty() || (line[0] == '#')) {
+      continue;
+    }
+
+    if (line[0] == '/') {
+      addPath(line);
+    } else if ((line.compare(0, 4, "fid:") == 0) ||
+               (line.compare(0, 4, "cid:") == 0)) {
+      char* end = nullptr;
+      uint64_t id = strtoull(line.c_str() + 4, &end, 10);
+
+      if ((id == 0) || (*end != '\0')) {
+        continue;
+      }
+
+      if (line[0] == 'f') {
+        addFileId(id);
+      } else {
+        addContainerId(id);
+      }
+    } else {
+      continue;
+    }
+
+    ++count;
+  }
+
+  return count;
+}
+
+//------------------------------------------------------------------------------
+// Save a warm-up list in QuarkDB
+//------------------------------------------------------------------------------
+bool
+MetadataWarmup::saveList(qclient::QClient& qcl, const std::string& key,
+                         const std::vector<std::string>& entries)
+{
+  std::string contents;
+
+  for (const auto& entry : entries) {
+    contents += entry;
+    contents += '\n';
+  }
+
+  qclient::redisReplyPtr reply = qcl.exec("SET", key, contents).get();
+  return (reply != nullptr) && (reply->type == REDIS_REPLY_STATUS);
+}
+
+//------------------------------------------------------------------------------
+// Issue the lookup of an entry
+//------------------------------------------------------------------------------
+folly::Future<FileOrContainerMD>
+MetadataWarmup::issue(const Request& req)
+{
+  switch (req.kind) {
+  case Kind::kFile:
+    return mView->getFileMDSvc()->getFileMDFut(req.id)
+    .then([](IFileMDPtr file) {
+      FileOrContainerMD item;
+      item.file = std::move(file);
+      return item;
+    });
+
+  case Kind::kContainer:
+    return mView->getContainerMDSvc()->getContainerMDFut(req.id)
+    .then([](IContainerMDPtr cont) {
+      FileOrContainerMD item;
+      item.container = std::move(cont);
+      return item;
+    });
+
+  default:
+    return mView->getItem(req.path, true);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Wait for a lookup to complete, account it and queue the children
+//------------------------------------------------------------------------------
+bool
+MetadataWarmup::complete(InFlight& item, WarmupStats& stats,
+                         Clock::time_point deadline)
+{
+  if (deadline == Clock::time_point::max()) {
+    item.fut.wait();
+  } else if (!item.fut.isReady()) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>
+                (deadline - Clock::now());
+    item.fut.wait(std::max(left, std::chrono::milliseconds(0)));
+
+    if (!item.fut.isReady()) {
+      return false;
+    }
+  }
+
+  if (item.fut.hasException()) {
+    ++stats.failed;
+    return true;
+  }
+
+  FileOrContainerMD md = item.fut.get();
+
+  if (!md.file && !md.container) {
+    ++stats.failed;
+    return true;
+  }
+
+  ++stats.loaded;
+
+  if (!item.expand || !md.container) {
+    return true;
+  }
+
+  // Children past the budget would never be issued, don't queue them
+  uint64_t budget = mMaxItems - std::min<uint64_t>(mMaxItems,
+                    stats.scheduled + mPending.size());
+
+  for (ContainerMapIterator it(md.container); it.valid() && budget;
+       it.next(), --budget) {
+    mPending.push_back(Request{Kind::kContainer, it.value(), "", false});
+  }
+
+  for (FileMapIterator it(md.container); it.valid() && budget;
+       it.next(), --budget) {
+    mPending.push_back(Request{Kind::kFile, it.value(), "", false});
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Load all the entries into the caches
+//------------------------------------------------------------------------------
+WarmupStats
+MetadataWarmup::run(std::chrono::seconds timeout, ProgressCallback progress,
+                    std::chrono::seconds progress_interval)
+{
+  WarmupStats stats;
+
+  if (mView->inMemory()) {
+    mPending.clear();
+    return stats;
+  }
+
+  const Clock::time_point start = Clock::now();
+  const Clock::time_point deadline = (timeout.count() ? start + timeout :
+                                      Clock::time_point::max());
+  Clock::time_point next_report = start + progress_interval;
+  std::deque<InFlight> in_flight;
+  bool expired = false;
+
+  while (true) {
+    // Top up the window, the oldest lookup is then the most likely to be done
+    while (!mStop && !expired && !mPending.empty() &&
+           (in_flight.size() < mMaxInFlight) && (stats.scheduled < mMaxItems)) {
+      in_flight.push_back(InFlight{issue(mPending.front()),
+                                   mPending.front().expand});
+      mPending.pop_front();
+      ++stats.scheduled;
+    }
+
+    if (in_flight.empty()) {
+      break;
+    }
+
+    // A slow lookup must not hold the warm-up past its deadline, what is
+    // still in flight then completes in the background and is dropped
+    if (mStop || !complete(in_flight.front(), stats, deadline)) {
+      stats.abandoned += in_flight.size();
+      in_flight.clear();
+      break;
+    }
+
+    in_flight.pop_front();
+    const Clock::time_point now = Clock::now();
+
+    if (now >= deadline) {
+      expired = true;
+    }
+
+    if (progress && (now >= next_report)) {
+      stats.elapsed = std::chrono::duration<double>(now - start).count();
+      progress(stats);
+      next_report = now + progress_interval;
+    }
+  }
+
+  stats.elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  return stats;
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,226 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Bulk loader warming up the metadata caches
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include "namespace/interface/IContainerMD.hh"
+#include "namespace/interface/IFileMD.hh"
+#include <folly/futures/Future.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace qclient
+{
+class QClient;
+}
+
+EOSNSNAMESPACE_BEGIN
+
+class IView;
+
+//------------------------------------------------------------------------------
+//! Progress of a metadata warm-up
+//------------------------------------------------------------------------------
+struct WarmupStats {
+  uint64_t scheduled = 0; ///< Number of lookups issued
+  uint64_t loaded = 0; ///< Number of items now in the caches
+  uint64_t failed = 0; ///< Number of lookups which failed, eg. removed items
+  uint64_t abandoned = 0; ///< Lookups still in flight at the deadline or stop
+  double elapsed = 0; ///< Seconds since the warm-up started
+
+  //----------------------------------------------------------------------------
+  //! Get the load rate in items per second
+  //----------------------------------------------------------------------------
+  double rate() const
+  {
+    return (elapsed > 0) ? (loaded / elapsed) : 0;
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Class MetadataWarmup
+//!
+//! Streams a list of containers and files into the metadata caches, typically
+//! the hottest entries of the previous master right after a namespace boot.
+//! Unlike the Prefetcher which waits for one batch of lookups at a time, the
+//! warm-up keeps a fixed window of lookups in flight: every completion is
+//! immediately replaced by the next pending entry. The metadata provider
+//! spreads the lookups over its per-shard QuarkDB connections, so all of them
+//! are kept busy with pipelined requests while the total concurrency stays
+//! bounded. Containers can optionally be expanded to their direct children,
+//! whose ids arrive with the container and need no path resolution.
+//------------------------------------------------------------------------------
+class MetadataWarmup
+{
+public:
+  //! Callback receiving the progress of a running warm-up
+  using ProgressCallback = std::function<void(const WarmupStats&)>;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param view namespace view
+  //! @param max_in_flight maximum number of concurrent lookups
+  //! @param max_items maximum number of lookups, including children
+  //! @param with_children if true load also the direct children of the
+  //!        containers listed
+  //----------------------------------------------------------------------------
+  MetadataWarmup(IView* view, size_t max_in_flight = 4096,
+                 uint64_t max_items = 1000000, bool with_children = true);
+
+  //----------------------------------------------------------------------------
+  //! Add a file or container given by path
+  //----------------------------------------------------------------------------
+  void addPath(const std::string& path);
+
+  //----------------------------------------------------------------------------
+  //! Add a file given by id
+  //----------------------------------------------------------------------------
+  void addFileId(IFileMD::id_t id);
+
+  //----------------------------------------------------------------------------
+  //! Add a container given by id
+  //----------------------------------------------------------------------------
+  void addContainerId(IContainerMD::id_t id);
+
+  //----------------------------------------------------------------------------
+  //! Add the entries of a warm-up list file: one entry per line, either an
+  //! absolute path, "fid:<id>" or "cid:<id>". Empty lines and lines starting
+  //! with '#' are ignored.
+  //!
+  //! @param filename list file
+  //!
+  //! @return number of entries added, -1 if the file can not be read
+  //----------------------------------------------------------------------------
+  int64_t addList(const std::string& filename);
+
+  //----------------------------------------------------------------------------
+  //! Add the entries of a warm-up list stored in QuarkDB by saveList
+  //!
+  //! @param qcl QuarkDB client
+  //! @param key key of the list
+  //!
+  //! @return number of entries added, -1 if the list does not exist or can
+  //!         not be read
+  //----------------------------------------------------------------------------
+  int64_t addList(qclient::QClient& qcl, const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of entries not issued yet
+  //----------------------------------------------------------------------------
+  size_t getPending() const
+  {
+    return mPending.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Load all the entries into the caches
+  //!
+  //! @param timeout stop issuing new lookups after this duration and abandon
+  //!        the ones not completed by then, 0 for none
+  //! @param progress callback called every progress_interval, may be empty
+  //! @param progress_interval interval between progress callbacks
+  //!
+  //! @return final statistics
+  //----------------------------------------------------------------------------
+  WarmupStats run(std::chrono::seconds timeout = std::chrono::seconds(0),
+                  ProgressCallback progress = nullptr,
+                  std::chrono::seconds progress_interval =
+                    std::chrono::seconds(5));
+
+  //----------------------------------------------------------------------------
+  //! Ask a running warm-up to stop issuing new lookups and to abandon the ones
+  //! in flight, thread-safe
+  //----------------------------------------------------------------------------
+  void stop()
+  {
+    mStop = true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Save a warm-up list in QuarkDB, replacing the previous one, so that any
+  //! MGM taking over can read it
+  //!
+  //! @param qcl QuarkDB client
+  //! @param key key of the list
+  //! @param entries list entries, in order of decreasing importance
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool saveList(qclient::QClient& qcl, const std::string& key,
+                       const std::vector<std::string>& entries);
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  //! Kind of entry to load
+  enum class Kind { kPath, kFile, kContainer };
+
+  //! Entry waiting to be issued
+  struct Request {
+    Kind kind; ///< Type of entry
+    uint64_t id; ///< File or container id, unused for paths
+    std::string path; ///< Path, only for kPath
+    bool expand; ///< Load also the children if it's a container
+  };
+
+  //! Lookup in flight
+  struct InFlight {
+    folly::Future<FileOrContainerMD> fut; ///< Result of the lookup
+    bool expand; ///< Load also the children if it's a container
+  };
+
+  //----------------------------------------------------------------------------
+  //! Issue the lookup of an entry
+  //----------------------------------------------------------------------------
+  folly::Future<FileOrContainerMD> issue(const Request& req);
+
+  //----------------------------------------------------------------------------
+  //! Add the entries of a warm-up list, one per line
+  //----------------------------------------------------------------------------
+  int64_t addEntries(std::istream& in);
+
+  //----------------------------------------------------------------------------
+  //! Wait for a lookup to complete, account it and queue the children
+  //!
+  //! @param item lookup in flight
+  //! @param stats statistics to update
+  //! @param deadline time after which to stop waiting
+  //!
+  //! @return false if the lookup did not complete before the deadline
+  //----------------------------------------------------------------------------
+  bool complete(InFlight& item, WarmupStats& stats, Clock::time_point deadline);
+
+  IView* mView; ///< Namespace view
+  const size_t mMaxInFlight; ///< Maximum number of concurrent lookups
+  const uint64_t mMaxItems; ///< Maximum number of lookups
+  const bool mWithChildren; ///< Load the children of listed containers
+  std::deque<Request> mPending; ///< Entries not issued yet
+  std::atomic<bool> mStop; ///< Flag to stop a running warm-up
+};
+
+EOSNSNAMESPACE_END
@@ -51,6 +51,29 @@ public:
 
   virtual ~IContainerMDChangeListener() {}
   virtual void containerMDChanged(IContainerMD* obj, Action type) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Notification about an entry being added to (Created) or removed from
+  //! (Deleted) a container, as done by create, rename, unlink and remove
+  //!
+  //! @param parent container holding the entry
+  //! @param name name of the entry
+  //! @param id id of the file or container
+  //! @param is_container true if the entry is a container
+  //! @param type Created or Deleted
+  //----------------------------------------------------------------------------
+  virtual void containerMDEntryChanged(IContainerMD* parent,
+                                       const std::string& name, uint64_t id,
+                                       bool is_container, Action type)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Get the statistics of the batches propagated by the listener
+  //----------------------------------------------------------------------------
+  virtual PropagationStats getPropagationStats()
+  {
+    return PropagationStats();
+  }
 };
 
 //----------------------------------------------------------------------------
@@ -140,6 +163,15 @@ public:
   virtual void notifyListeners(IContainerMD* obj,
                                IContainerMDChangeListener::Action a) = 0;
 
+  //----------------------------------------------------------------------------
+  //! Notify all subscribed listeners about an entry of a container
+  //----------------------------------------------------------------------------
+  virtual void notifyEntryListeners(IContainerMD* parent,
+                                    const std::string& name, uint64_t id,
+                                    bool is_container,
+                                    IContainerMDChangeListener::Action a)
+  {}
+
   //----------------------------------------------------------------------------
   //! Get the orphans container
   //----------------------------------------------------------------------------
@@ -81,6 +81,14 @@ public:
   virtual bool fileMDCheck(IFileMD* obj) = 0;
   virtual void AddTree(IContainerMD* obj , int64_t dsize) = 0;
   virtual void RemoveTree(IContainerMD* obj , int64_t dsize) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Get the statistics of the batches propagated by the listener
+  //----------------------------------------------------------------------------
+  virtual PropagationStats getPropagationStats()
+  {
+    return PropagationStats();
+  }
 };
 
 //------------------------------------------------------------------------------
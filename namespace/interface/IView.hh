@@ -30,6 +30,7 @@
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/MDException.hh"
 #include "namespace/interface/IContainerMD.hh"
+#include "namespace/interface/Misc.hh"
 
 namespace eos
 {
@@ -267,6 +268,15 @@ public:
   //! Return whether this is an in-memory namespace.
   //----------------------------------------------------------------------------
   virtual bool inMemory() = 0;
+
+  //----------------------------------------------------------------------------
+  //! Get statistics of the path lookup caches, disabled if there are none
+  //----------------------------------------------------------------------------
+  virtual PathCacheStatistics
+  getPathCacheStatistics()
+  {
+    return PathCacheStatistics();
+  }
 };
 };
 
@@ -25,6 +25,7 @@
 #define EOS_NS_MISC_H
 
 #include "namespace/Namespace.hh"
+#include <cstdint>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -36,6 +37,66 @@ struct CacheStatistics {
   int64_t maxNum = 0;
   int64_t occupancy = 0;
   int64_t inFlight = 0;
+  int64_t hits = 0;
+  int64_t misses = 0;
+  int64_t evictions = 0;
+};
+
+//------------------------------------------------------------------------------
+//! Struct to retrieve information about the path lookup caches of the view
+//------------------------------------------------------------------------------
+struct PathCacheStatistics {
+  bool enabled = false;
+  int64_t dentryMaxNum = 0;
+  int64_t dentryOccupancy = 0;
+  int64_t dentryHits = 0;
+  int64_t dentryNegativeHits = 0;
+  int64_t dentryMisses = 0;
+  int64_t dentryInvalidations = 0;
+  int64_t dentryEvictions = 0;
+  int64_t pathMaxNum = 0;
+  int64_t pathOccupancy = 0;
+  int64_t pathHits = 0;
+  int64_t pathMisses = 0;
+  int64_t pathInvalidations = 0;
+  int64_t pathEvictions = 0;
+};
+
+//------------------------------------------------------------------------------
+//! Statistics of the batches propagated by an accounting listener, all zero
+//! for the listeners which do not propagate in batches
+//------------------------------------------------------------------------------
+struct PropagationStats {
+  uint64_t mBatches = 0; ///< Number of non-empty batches propagated
+  uint64_t mQueued = 0; ///< Entries queued in the last batch
+  uint64_t mTouched = 0; ///< Containers updated by the last batch
+  uint64_t mRounds = 0; ///< Pipelined lookup rounds of the last batch
+  uint64_t mLatencyUs = 0; ///< Propagation latency of the last batch
+  uint64_t mTotalTouched = 0; ///< Containers updated by all batches
+  uint64_t mMaxLatencyUs = 0; ///< Highest propagation latency of a batch
+
+  //----------------------------------------------------------------------------
+  //! Account a propagated batch
+  //!
+  //! @param queued entries queued in the batch
+  //! @param touched containers updated
+  //! @param rounds pipelined lookup rounds
+  //! @param latency_us propagation latency in microseconds
+  //----------------------------------------------------------------------------
+  void Add(uint64_t queued, uint64_t touched, uint64_t rounds,
+           uint64_t latency_us)
+  {
+    ++mBatches;
+    mQueued = queued;
+    mTouched = touched;
+    mRounds = rounds;
+    mLatencyUs = latency_us;
+    mTotalTouched += touched;
+
+    if (latency_us > mMaxLatencyUs) {
+      mMaxLatencyUs = latency_us;
+    }
+  }
 };
 
 EOSNSNAMESPACE_END
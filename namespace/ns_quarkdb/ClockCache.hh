@@ -0,0 +1,628 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @file ClockCache.hh
+//! @brief Sharded CLOCK (second-chance) cache for namespace objects making
+//!        sure we never evict an entry which is still referenced in other
+//!        parts of the program.
+//------------------------------------------------------------------------------
+
+#ifndef __EOS_NS_CLOCK_CACHE_HH__
+#define __EOS_NS_CLOCK_CACHE_HH__
+
+#include "common/RWMutex.hh"
+#include "common/AssistedThread.hh"
+#include "common/Murmur3.hh"
+#include "namespace/Namespace.hh"
+#include <google/dense_hash_map>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Per shard cache statistics
+//------------------------------------------------------------------------------
+struct ClockCacheShardStats {
+  std::uint64_t size = 0; ///< Number of entries
+  std::uint64_t hits = 0; ///< Number of successful lookups
+  std::uint64_t misses = 0; ///< Number of failed lookups
+  std::uint64_t evictions = 0; ///< Number of evicted entries
+};
+
+//------------------------------------------------------------------------------
+//! CLOCK cache for namespace entries
+//!
+//! The key space is split into independent shards. A lookup only takes the
+//! read lock of its shard and marks the entry as recently used by setting its
+//! reference bit, so concurrent hits never serialize. Entries are kept in a
+//! circular list per shard and a background thread sweeps the "clock hand"
+//! over it once a shard exceeds its capacity: entries with the reference bit
+//! set get a second chance, entries referenced elsewhere are skipped and the
+//! rest are evicted in one batch. The evicted objects are deallocated by the
+//! background thread, outside of any lock.
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+class ClockCache
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param max_num maximum number of entries in the cache
+  //! @param num_shards number of independent shards
+  //----------------------------------------------------------------------------
+  ClockCache(std::uint64_t max_num, std::size_t num_shards = sDefaultShards);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~ClockCache();
+
+  //----------------------------------------------------------------------------
+  //! Get entry
+  //!
+  //! @param id entry id
+  //!
+  //! @return shared ptr to requested object or nullptr if not found
+  //----------------------------------------------------------------------------
+  std::shared_ptr<EntryT> get(IdT id);
+
+  //----------------------------------------------------------------------------
+  //! Get entry without accounting it as a hit or miss nor marking it as
+  //! recently used
+  //!
+  //! @param id entry id
+  //!
+  //! @return shared ptr to requested object or nullptr if not found
+  //----------------------------------------------------------------------------
+  std::shared_ptr<EntryT> peek(IdT id) const;
+
+  //----------------------------------------------------------------------------
+  //! Put entry
+  //!
+  //! @param id entry id
+  //! @param entry entry object
+  //!
+  //! @return the cached object - if an entry with the same id already exists
+  //!         then this one is returned. If the shard grows over its capacity
+  //!         the background eviction is triggered.
+  //----------------------------------------------------------------------------
+  std::shared_ptr<EntryT> put(IdT id, std::shared_ptr<EntryT> obj);
+
+  //----------------------------------------------------------------------------
+  //! Remove entry from cache
+  //!
+  //! @param id entry id
+  //!
+  //! @return true if successfully removed from the cache, false otherwise
+  //----------------------------------------------------------------------------
+  bool remove(IdT id);
+
+  //----------------------------------------------------------------------------
+  //! Run synchronously one eviction pass over all shards which are over
+  //! capacity, this is what the background thread does periodically.
+  //----------------------------------------------------------------------------
+  void evict();
+
+  //----------------------------------------------------------------------------
+  //! Get cache size
+  //!
+  //! @return cache size
+  //----------------------------------------------------------------------------
+  std::uint64_t size() const;
+
+  //----------------------------------------------------------------------------
+  //! Get maximim number of entries in the cache
+  //!
+  //! @return maximum cache num entries
+  //----------------------------------------------------------------------------
+  inline std::uint64_t
+  get_max_num() const
+  {
+    return mMaxNum;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Set max num entries
+  //!
+  //! @param max_num new maximum number of entries, if 0 then just drop the
+  //!                the current cache and disable it, if UINT64_MAX then just
+  //!                flush the cache
+  //----------------------------------------------------------------------------
+  void set_max_num(const std::uint64_t max_num);
+
+  //----------------------------------------------------------------------------
+  //! Get statistics for each of the shards
+  //----------------------------------------------------------------------------
+  std::vector<ClockCacheShardStats> get_shard_stats() const;
+
+  //----------------------------------------------------------------------------
+  //! Get statistics summed over all the shards
+  //----------------------------------------------------------------------------
+  ClockCacheShardStats get_stats() const;
+
+  //----------------------------------------------------------------------------
+  //! Forbid copying or moving ClockCache objects
+  //----------------------------------------------------------------------------
+  ClockCache(const ClockCache& other) = delete;
+  ClockCache& operator=(const ClockCache& other) = delete;
+  ClockCache(ClockCache&& other) = delete;
+  ClockCache& operator=(ClockCache&& other) = delete;
+
+private:
+  //! Cache entry with its reference bit
+  struct Node {
+    Node(IdT id, std::shared_ptr<EntryT> obj):
+      mId(id), mObj(std::move(obj)), mRef(false) {}
+
+    IdT mId;
+    std::shared_ptr<EntryT> mObj;
+    std::atomic<bool> mRef;
+  };
+
+  using ListT = std::list<Node>;
+  using MapT = google::dense_hash_map<IdT, typename ListT::iterator,
+        Murmur3::MurmurHasher<IdT>>;
+
+  //! Independent part of the cache with its own lock
+  struct Shard {
+    Shard(): mSize(0), mHits(0), mMisses(0), mEvictions(0)
+    {
+      mMap.set_empty_key(IdT(UINT64_MAX - 1));
+      mMap.set_deleted_key(IdT(UINT64_MAX));
+      mMutex.SetBlocking(true);
+      mHand = mList.end();
+    }
+
+    mutable eos::common::RWMutex mMutex; ///< Protects the map and the list
+    MapT mMap; ///< Map pointing to the entries in the list
+    ListT mList; ///< Circular list of entries swept by the clock hand
+    typename ListT::iterator mHand; ///< Clock hand
+    std::atomic<std::uint64_t> mSize; ///< Number of entries, readable lock-free
+    std::atomic<std::uint64_t> mHits;
+    std::atomic<std::uint64_t> mMisses;
+    std::atomic<std::uint64_t> mEvictions;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get shard responsible for the given id
+  //----------------------------------------------------------------------------
+  inline Shard&
+  GetShard(IdT id) const
+  {
+    // Use the high bits, the low ones select the bucket inside the shard map
+    return *mShards[(mHasher(id) >> 32) % mShards.size()];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the capacity of a shard
+  //----------------------------------------------------------------------------
+  inline std::uint64_t
+  GetShardMaxNum() const
+  {
+    return (mMaxNum + mShards.size() - 1) / mShards.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Sweep the clock hand over the shard evicting entries until the shard
+  //! size drops below the given limit or every entry was visited twice
+  //!
+  //! @param shard shard to sweep
+  //! @param limit target number of entries
+  //! @param evicted evicted objects to be deallocated by the caller once the
+  //!        shard lock is released
+  //! @note This method must be called with the shard mutex write locked.
+  //----------------------------------------------------------------------------
+  void Sweep(Shard& shard, std::uint64_t limit,
+             std::vector<std::shared_ptr<EntryT>>& evicted);
+
+  //----------------------------------------------------------------------------
+  //! Background job evicting entries from the shards over capacity
+  //----------------------------------------------------------------------------
+  void EvictorJob(ThreadAssistant& assistant);
+
+  //! Default number of shards
+  static constexpr std::size_t sDefaultShards = 16;
+  //! Percentage of the capacity at which eviction stops
+  static constexpr double sPurgeStopRatio = 0.9;
+  //! Shard size, relative to its capacity, after which put evicts inline
+  //! because the background thread is not keeping up
+  static constexpr double sInlinePurgeRatio = 2.0;
+  //! Load factor of a shard map under which a sweep compacts it
+  static constexpr double sCompactLoadFactor = 0.2;
+  //! Interval at which the evictor thread checks the shards unprompted
+  static constexpr std::chrono::milliseconds sEvictInterval {500};
+  std::vector<std::unique_ptr<Shard>> mShards; ///< Cache shards
+  std::atomic<std::uint64_t> mMaxNum; ///< Maximum number of entries
+  Murmur3::MurmurHasher<IdT> mHasher; ///< Hasher used for shard selection
+  std::mutex mEvictMutex; ///< Mutex for the evictor notification
+  std::condition_variable mEvictCv; ///< CV to wake up the evictor thread
+  bool mEvictPending; ///< Flag marking that eviction is needed
+  AssistedThread mEvictorThread; ///< Thread doing eviction and deallocation
+};
+
+// Definition of class static members
+template <typename IdT, typename EntryT>
+constexpr std::size_t ClockCache<IdT, EntryT>::sDefaultShards;
+template <typename IdT, typename EntryT>
+constexpr double ClockCache<IdT, EntryT>::sPurgeStopRatio;
+template <typename IdT, typename EntryT>
+constexpr double ClockCache<IdT, EntryT>::sInlinePurgeRatio;
+template <typename IdT, typename EntryT>
+constexpr double ClockCache<IdT, EntryT>::sCompactLoadFactor;
+template <typename IdT, typename EntryT>
+constexpr std::chrono::milliseconds ClockCache<IdT, EntryT>::sEvictInterval;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+ClockCache<IdT, EntryT>::ClockCache(std::uint64_t max_num,
+                                    std::size_t num_shards):
+  mMaxNum(max_num), mEvictPending(false)
+{
+  if (num_shards == 0) {
+    num_shards = 1;
+  }
+
+  for (std::size_t i = 0; i < num_shards; ++i) {
+    mShards.emplace_back(new Shard());
+  }
+
+  mEvictorThread.reset(&ClockCache::EvictorJob, this);
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+ClockCache<IdT, EntryT>::~ClockCache()
+{
+  mEvictorThread.stop();
+  {
+    std::lock_guard<std::mutex> lock(mEvictMutex);
+    mEvictCv.notify_all();
+  }
+  mEvictorThread.join();
+
+  for (auto& shard : mShards) {
+    eos::common::RWMutexWriteLock lock_w(shard->mMutex);
+    shard->mMap.clear();
+    shard->mList.clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get object
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+std::shared_ptr<EntryT>
+ClockCache<IdT, EntryT>::get(IdT id)
+{
+  Shard& shard = GetShard(id);
+  eos::common::RWMutexReadLock lock_r(shard.mMutex);
+  auto iter_map = shard.mMap.find(id);
+
+  if (iter_map == shard.mMap.end()) {
+    shard.mMisses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  Node& node = *iter_map->second;
+
+  // Avoid dirtying the cache line of hot entries which are already marked
+  if (!node.mRef.load(std::memory_order_relaxed)) {
+    node.mRef.store(true, std::memory_order_relaxed);
+  }
+
+  shard.mHits.fetch_add(1, std::memory_order_relaxed);
+  return node.mObj;
+}
+
+//------------------------------------------------------------------------------
+// Get object without touching statistics and reference bit
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+std::shared_ptr<EntryT>
+ClockCache<IdT, EntryT>::peek(IdT id) const
+{
+  Shard& shard = GetShard(id);
+  eos::common::RWMutexReadLock lock_r(shard.mMutex);
+  auto iter_map = shard.mMap.find(id);
+
+  if (iter_map == shard.mMap.end()) {
+    return nullptr;
+  }
+
+  return iter_map->second->mObj;
+}
+
+//------------------------------------------------------------------------------
+// Put object
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+std::shared_ptr<EntryT>
+ClockCache<IdT, EntryT>::put(IdT id, std::shared_ptr<EntryT> obj)
+{
+  if (mMaxNum == 0ull) {
+    return obj;
+  }
+
+  Shard& shard = GetShard(id);
+  std::vector<std::shared_ptr<EntryT>> evicted;
+  bool notify = false;
+  {
+    eos::common::RWMutexWriteLock lock_w(shard.mMutex);
+    auto iter_map = shard.mMap.find(id);
+
+    if (iter_map != shard.mMap.end()) {
+      return iter_map->second->mObj;
+    }
+
+    std::uint64_t shard_max = GetShardMaxNum();
+
+    if (shard.mMap.size() >= sInlinePurgeRatio * shard_max) {
+      Sweep(shard, static_cast<std::uint64_t>(sPurgeStopRatio * shard_max),
+            evicted);
+    } else if (shard.mMap.size() >= shard_max) {
+      notify = true;
+    }
+
+    // New entries are inserted right behind the clock hand so that they are
+    // the last ones to be visited by the next sweep
+    auto iter = shard.mList.emplace(shard.mHand, id, obj);
+    shard.mMap[id] = iter;
+    shard.mSize = shard.mMap.size();
+  }
+
+  if (notify) {
+    std::lock_guard<std::mutex> lock(mEvictMutex);
+
+    if (!mEvictPending) {
+      mEvictPending = true;
+      mEvictCv.notify_one();
+    }
+  }
+
+  return obj;
+}
+
+//------------------------------------------------------------------------------
+// Remove object
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+bool
+ClockCache<IdT, EntryT>::remove(IdT id)
+{
+  Shard& shard = GetShard(id);
+  std::shared_ptr<EntryT> obj;
+  eos::common::RWMutexWriteLock lock_w(shard.mMutex);
+  auto iter_map = shard.mMap.find(id);
+
+  if (iter_map == shard.mMap.end()) {
+    return false;
+  }
+
+  auto iter = iter_map->second;
+  obj = std::move(iter->mObj);
+
+  if (shard.mHand == iter) {
+    ++shard.mHand;
+  }
+
+  shard.mList.erase(iter);
+  shard.mMap.erase(iter_map);
+  shard.mSize = shard.mMap.size();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Run one eviction pass over all the shards over capacity
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+void
+ClockCache<IdT, EntryT>::evict()
+{
+  std::uint64_t shard_max = GetShardMaxNum();
+  std::vector<std::shared_ptr<EntryT>> evicted;
+
+  for (auto& shard : mShards) {
+    if (shard->mSize < shard_max) {
+      continue;
+    }
+
+    {
+      eos::common::RWMutexWriteLock lock_w(shard->mMutex);
+      Sweep(*shard, static_cast<std::uint64_t>(sPurgeStopRatio * shard_max),
+            evicted);
+    }
+    // Deallocate the evicted objects without holding the lock
+    evicted.clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get cache size
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+std::uint64_t
+ClockCache<IdT, EntryT>::size() const
+{
+  std::uint64_t total = 0ull;
+
+  for (const auto& shard : mShards) {
+    total += shard->mSize;
+  }
+
+  return total;
+}
+
+//------------------------------------------------------------------------------
+// Set max num entries
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+void
+ClockCache<IdT, EntryT>::set_max_num(const std::uint64_t max_num)
+{
+  if ((max_num == 0ull) || (max_num == UINT64_MAX)) {
+    // Flush the cache and disable it if requested
+    if (max_num == 0ull) {
+      mMaxNum = 0ull;
+    }
+
+    std::vector<std::shared_ptr<EntryT>> evicted;
+
+    for (auto& shard : mShards) {
+      {
+        eos::common::RWMutexWriteLock lock_w(shard->mMutex);
+        Sweep(*shard, 0ull, evicted);
+      }
+      evicted.clear();
+    }
+  } else {
+    mMaxNum = max_num;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get statistics for each of the shards
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+std::vector<ClockCacheShardStats>
+ClockCache<IdT, EntryT>::get_shard_stats() const
+{
+  std::vector<ClockCacheShardStats> stats;
+
+  for (const auto& shard : mShards) {
+    ClockCacheShardStats st;
+    st.size = shard->mSize;
+    st.hits = shard->mHits;
+    st.misses = shard->mMisses;
+    st.evictions = shard->mEvictions;
+    stats.push_back(st);
+  }
+
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+// Get statistics summed over all the shards
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+ClockCacheShardStats
+ClockCache<IdT, EntryT>::get_stats() const
+{
+  ClockCacheShardStats total;
+
+  for (const auto& st : get_shard_stats()) {
+    total.size += st.size;
+    total.hits += st.hits;
+    total.misses += st.misses;
+    total.evictions += st.evictions;
+  }
+
+  return total;
+}
+
+//------------------------------------------------------------------------------
+// Sweep the clock hand over the shard evicting entries
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+void
+ClockCache<IdT, EntryT>::Sweep(Shard& shard, std::uint64_t limit,
+                               std::vector<std::shared_ptr<EntryT>>& evicted)
+{
+  // Bound the sweep to two full rotations: the first one might only clear
+  // reference bits, after the second one only pinned entries remain
+  std::uint64_t steps = 2 * shard.mList.size();
+  std::uint64_t num_evicted = 0ull;
+
+  while ((shard.mMap.size() > limit) && steps--) {
+    if (shard.mHand == shard.mList.end()) {
+      shard.mHand = shard.mList.begin();
+    }
+
+    Node& node = *shard.mHand;
+
+    if (node.mRef.load(std::memory_order_relaxed)) {
+      // Second chance
+      node.mRef.store(false, std::memory_order_relaxed);
+      ++shard.mHand;
+      continue;
+    }
+
+    // If object is referenced also by someone else then skip it
+    if (node.mObj.use_count() > 1) {
+      ++shard.mHand;
+      continue;
+    }
+
+    shard.mMap.erase(node.mId);
+    evicted.push_back(std::move(node.mObj));
+    shard.mHand = shard.mList.erase(shard.mHand);
+    ++num_evicted;
+  }
+
+  if (num_evicted) {
+    // Rehashing copies the whole map under the shard lock, so only compact
+    // once it became sparse. The tombstones left otherwise are reused by the
+    // following inserts.
+    if (shard.mMap.size() < sCompactLoadFactor * shard.mMap.bucket_count()) {
+      shard.mMap.resize(0);
+    }
+
+    shard.mSize = shard.mMap.size();
+    shard.mEvictions.fetch_add(num_evicted, std::memory_order_relaxed);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Background job evicting entries from the shards over capacity
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+void
+ClockCache<IdT, EntryT>::EvictorJob(ThreadAssistant& assistant)
+{
+  while (!assistant.terminationRequested()) {
+    {
+      std::unique_lock<std::mutex> lock(mEvictMutex);
+      mEvictCv.wait_for(lock, sEvictInterval, [&]() {
+        return mEvictPending || assistant.terminationRequested();
+      });
+      mEvictPending = false;
+    }
+
+    if (assistant.terminationRequested()) {
+      break;
+    }
+
+    evict();
+  }
+}
+
+EOSNSNAMESPACE_END
+
+#endif // __EOS_NS_CLOCK_CACHE_HH__
@@ -234,10 +234,14 @@ QuarkContainerMD::removeContainer(const std::string& name)
     throw e;
   }
 
+  IContainerMD::id_t id = it->second;
   mSubcontainers->erase(it);
   mSubcontainers->resize(0);
   // Delete container also from KV backend
   pFlusher->hdel(pDirsKey, name);
+  lock.unlock();
+  pContSvc->notifyEntryListeners(this, name, id, true,
+                                 IContainerMDChangeListener::Deleted);
 }
 
 //------------------------------------------------------------------------------
@@ -279,6 +283,9 @@ QuarkContainerMD::addContainer(IContainerMD* container)
                                 container->getId()));
   // Add to new container to KV backend
   pFlusher->hset(pDirsKey, container->getName(), stringify(container->getId()));
+  lock.unlock();
+  pContSvc->notifyEntryListeners(this, container->getName(), container->getId(),
+                                 true, IContainerMDChangeListener::Created);
 }
 
 //------------------------------------------------------------------------------
@@ -354,6 +361,8 @@ QuarkContainerMD::addFile(IFileMD* file)
   (void)mFiles->insert(std::make_pair(file->getName(), file->getId()));
   pFlusher->hset(pFilesKey, file->getName(), std::to_string(file->getId()));
   lock.unlock();
+  pContSvc->notifyEntryListeners(this, file->getName(), file->getId(), false,
+                                 IContainerMDChangeListener::Created);
 
   if (file->getSize() != 0u) {
     IFileMDChangeListener::Event e(file, IFileMDChangeListener::SizeChange, 0,
@@ -376,9 +385,11 @@ QuarkContainerMD::removeFile(const std::string& name)
     mFiles->erase(iter);
     mFiles->resize(0);
     pFlusher->hdel(pFilesKey, name);
+    lock.unlock();
+    pContSvc->notifyEntryListeners(this, name, id, false,
+                                   IContainerMDChangeListener::Deleted);
 
     try {
-      lock.unlock();
       std::shared_ptr<IFileMD> file = pFileSvc->getFileMD(id);
       // NOTE: This is an ugly hack. The file object has no reference to the
       // container id, therefore we hijack the "location" member of the Event
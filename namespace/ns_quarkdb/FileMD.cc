@@ -16,11 +16,13 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
  ************************************************************************/
 
+#include <algorithm>
 #include <sstream>
 #include <chrono>
 #include "common/StacktraceHere.hh"
 #include "namespace/ns_quarkdb/FileMD.hh"
 #include "namespace/ns_quarkdb/persistency/Serialization.hh"
+#include "namespace/ns_quarkdb/persistency/StackArena.hh"
 #include "namespace/interface/IContainerMD.hh"
 #include "namespace/interface/IFileMDSvc.hh"
 #include "namespace/utils/DataHelper.hh"
@@ -32,20 +34,86 @@
 EOSNSNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
-// Empty constructor
+// Load the contents of a protobuf object
 //------------------------------------------------------------------------------
-QuarkFileMD::QuarkFileMD()
+void
+FileMdRecord::fromProto(const eos::ns::FileMdProto& proto)
 {
-  pFileMDSvc = nullptr;
+  mId = proto.id();
+  mContId = proto.cont_id();
+  mUid = proto.uid();
+  mGid = proto.gid();
+  mSize = proto.size();
+  mLayoutId = proto.layout_id();
+  mFlags = proto.flags();
+  mCTime = {0, 0};
+  mMTime = {0, 0};
+  (void) memcpy(&mCTime, proto.ctime().data(),
+                std::min(proto.ctime().size(), sizeof(mCTime)));
+  (void) memcpy(&mMTime, proto.mtime().data(),
+                std::min(proto.mtime().size(), sizeof(mMTime)));
+  mName.assign(proto.name().data(), proto.name().size());
+  mLinkName.assign(proto.link_name().data(), proto.link_name().size());
+  mChecksum.assign(proto.checksum().data(), proto.checksum().size());
+  mLocations.assign(proto.locations().begin(), proto.locations().end());
+  mUnlinkLocations.assign(proto.unlink_locations().begin(),
+                          proto.unlink_locations().end());
+  mXAttrs.clear();
+  mXAttrs.reserve(proto.xattrs().size());
+
+  for (const auto& elem : proto.xattrs()) {
+    mXAttrs.set(elem.first, elem.second);
+  }
 }
 
+//------------------------------------------------------------------------------
+// Store the contents into a protobuf object
+//------------------------------------------------------------------------------
+void
+FileMdRecord::toProto(eos::ns::FileMdProto& proto) const
+{
+  proto.set_id(mId);
+  proto.set_cont_id(mContId);
+  proto.set_uid(mUid);
+  proto.set_gid(mGid);
+  proto.set_size(mSize);
+  proto.set_layout_id(mLayoutId);
+  proto.set_flags(mFlags);
+  proto.set_ctime(&mCTime, sizeof(mCTime));
+  proto.set_mtime(&mMTime, sizeof(mMTime));
+  proto.set_name(mName.data(), mName.size());
+  proto.set_link_name(mLinkName.data(), mLinkName.size());
+  proto.set_checksum(mChecksum.data(), mChecksum.size());
+
+  for (const auto& loc : mLocations) {
+    proto.add_locations(loc);
+  }
+
+  for (const auto& loc : mUnlinkLocations) {
+    proto.add_unlink_locations(loc);
+  }
+
+  auto* xattrs = proto.mutable_xattrs();
+
+  for (const auto& elem : mXAttrs) {
+    (*xattrs)[*elem.first] = elem.second.toStdString();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Empty constructor
+//------------------------------------------------------------------------------
+QuarkFileMD::QuarkFileMD():
+  pFileMDSvc(nullptr), mClock(0)
+{}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 QuarkFileMD::QuarkFileMD(IFileMD::id_t id, IFileMDSvc* fileMDSvc):
   pFileMDSvc(fileMDSvc)
 {
-  mFile.set_id(id);
+  mFile.mId = id;
   mClock = std::chrono::high_resolution_clock::now().time_since_epoch().count();
 }
 
@@ -91,7 +159,7 @@ void QuarkFileMD::setName(const std::string& name)
   }
 
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile.set_name(name);
+  mFile.mName.assign(name.data(), name.size());
 }
 
 //------------------------------------------------------------------------------
@@ -106,7 +174,7 @@ QuarkFileMD::addLocation(location_t location)
     return;
   }
 
-  mFile.add_locations(location);
+  mFile.mLocations.push_back(location);
   lock.unlock();
   IFileMDChangeListener::Event e(this, IFileMDChangeListener::LocationAdded,
                                  location);
@@ -121,10 +189,10 @@ QuarkFileMD::removeLocation(location_t location)
 {
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
 
-  for (auto it = mFile.mutable_unlink_locations()->cbegin();
-       it != mFile.mutable_unlink_locations()->cend(); ++it) {
+  for (auto it = mFile.mUnlinkLocations.begin();
+       it != mFile.mUnlinkLocations.end(); ++it) {
     if (*it == location) {
-      it = mFile.mutable_unlink_locations()->erase(it);
+      mFile.mUnlinkLocations.erase(it);
       lock.unlock();
       IFileMDChangeListener::Event
       e(this, IFileMDChangeListener::LocationRemoved, location);
@@ -142,9 +210,9 @@ QuarkFileMD::removeAllLocations()
 {
   while (true) {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.unlink_locations().cbegin();
+    auto it = mFile.mUnlinkLocations.cbegin();
 
-    if (it == mFile.unlink_locations().cend()) {
+    if (it == mFile.mUnlinkLocations.cend()) {
       return;
     }
 
@@ -162,11 +230,11 @@ QuarkFileMD::unlinkLocation(location_t location)
 {
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
 
-  for (auto it = mFile.mutable_locations()->cbegin();
-       it != mFile.mutable_locations()->cend(); ++it) {
+  for (auto it = mFile.mLocations.begin(); it != mFile.mLocations.end();
+       ++it) {
     if (*it == location) {
-      mFile.add_unlink_locations(*it);
-      it = mFile.mutable_locations()->erase(it);
+      mFile.mUnlinkLocations.push_back(location);
+      mFile.mLocations.erase(it);
       lock.unlock();
       IFileMDChangeListener::Event
       e(this, IFileMDChangeListener::LocationUnlinked, location);
@@ -184,9 +252,9 @@ QuarkFileMD::unlinkAllLocations()
 {
   while (true) {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.locations().cbegin();
+    auto it = mFile.mLocations.cbegin();
 
-    if (it == mFile.locations().cend()) {
+    if (it == mFile.mLocations.cend()) {
       return;
     }
 
@@ -205,7 +273,7 @@ QuarkFileMD::getEnv(std::string& env, bool escapeAnd)
   std::shared_lock<std::shared_timed_mutex> lock(mMutex);
   env = "";
   std::ostringstream oss;
-  std::string saveName = mFile.name();
+  std::string saveName = mFile.mName.toStdString();
 
   if (escapeAnd) {
     if (!saveName.empty()) {
@@ -225,37 +293,37 @@ QuarkFileMD::getEnv(std::string& env, bool escapeAnd)
   ctime_t mtime;
   (void) getCTimeNoLock(ctime);
   (void) getMTimeNoLock(mtime);
-  oss << "name=" << saveName << "&id=" << mFile.id()
+  oss << "name=" << saveName << "&id=" << mFile.mId
       << "&ctime=" << ctime.tv_sec << "&ctime_ns=" << ctime.tv_nsec
       << "&mtime=" << mtime.tv_sec << "&mtime_ns=" << mtime.tv_nsec
-      << "&size=" << mFile.size() << "&cid=" << mFile.cont_id()
-      << "&uid=" << mFile.uid() << "&gid=" << mFile.gid()
-      << "&lid=" << mFile.layout_id() << "&flags=" << mFile.flags()
-      << "&link=" << mFile.link_name();
+      << "&size=" << mFile.mSize << "&cid=" << mFile.mContId
+      << "&uid=" << mFile.mUid << "&gid=" << mFile.mGid
+      << "&lid=" << mFile.mLayoutId << "&flags=" << mFile.mFlags
+      << "&link=" << mFile.mLinkName;
   env += oss.str();
   env += "&location=";
   char locs[16];
 
-  for (const auto& elem : mFile.locations()) {
+  for (const auto& elem : mFile.mLocations) {
     snprintf(static_cast<char*>(locs), sizeof(locs), "%u", elem);
     env += static_cast<char*>(locs);
     env += ",";
   }
 
-  for (const auto& elem : mFile.unlink_locations()) {
+  for (const auto& elem : mFile.mUnlinkLocations) {
     snprintf(static_cast<char*>(locs), sizeof(locs), "!%u", elem);
     env += static_cast<char*>(locs);
     env += ",";
   }
 
   env += "&checksum=";
-  uint8_t size = mFile.checksum().size();
+  uint8_t size = mFile.mChecksum.size();
 
   for (uint8_t i = 0; i < size; i++) {
     char hx[3];
     hx[0] = 0;
     snprintf(static_cast<char*>(hx), sizeof(hx), "%02x",
-             *(unsigned char*)(mFile.checksum().data() + i));
+             *(unsigned char*)(mFile.mChecksum.data() + i));
     env += static_cast<char*>(hx);
   }
 }
@@ -276,8 +344,12 @@ QuarkFileMD::serialize(eos::Buffer& buffer)
 
   // Increase clock to mark that metadata file has suffered updates
   mClock = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+  // Build the transient protobuf object on the stack arena
+  StackArena<> arena;
+  eos::ns::FileMdProto* proto = arena.create<eos::ns::FileMdProto>();
+  mFile.toProto(*proto);
   // Align the buffer to 4 bytes to efficiently compute the checksum
-  size_t obj_size = mFile.ByteSizeLong();
+  size_t obj_size = proto->ByteSizeLong();
   uint32_t align_size = (obj_size + 3) >> 2 << 2;
   size_t sz = sizeof(align_size);
   size_t msg_size = align_size + 2 * sz;
@@ -287,7 +359,7 @@ QuarkFileMD::serialize(eos::Buffer& buffer)
   const char* ptr = buffer.getDataPtr() + 2 * sz;
   google::protobuf::io::ArrayOutputStream aos((void*)ptr, align_size);
 
-  if (!mFile.SerializeToZeroCopyStream(&aos)) {
+  if (!proto->SerializeToZeroCopyStream(&aos)) {
     MDException ex(EIO);
     ex.getMessage() << "Failed while serializing buffer";
     throw ex;
@@ -307,10 +379,10 @@ QuarkFileMD::serialize(eos::Buffer& buffer)
 // Initialize from protobuf contents
 //------------------------------------------------------------------------------
 void
-QuarkFileMD::initialize(eos::ns::FileMdProto&& proto)
+QuarkFileMD::initialize(const eos::ns::FileMdProto& proto)
 {
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile = std::move(proto);
+  mFile.fromProto(proto);
 }
 
 //------------------------------------------------------------------------------
@@ -319,8 +391,11 @@ QuarkFileMD::initialize(eos::ns::FileMdProto&& proto)
 void
 QuarkFileMD::deserialize(const eos::Buffer& buffer)
 {
+  StackArena<> arena;
+  eos::ns::FileMdProto* proto = arena.create<eos::ns::FileMdProto>();
+  Serialization::deserializeFile(buffer, *proto);
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  Serialization::deserializeFile(buffer, mFile);
+  mFile.fromProto(*proto);
 }
 
 //------------------------------------------------------------------------------
@@ -330,8 +405,8 @@ void
 QuarkFileMD::setSize(uint64_t size)
 {
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  int64_t sizeChange = (size & 0x0000ffffffffffff) - mFile.size();
-  mFile.set_size(size & 0x0000ffffffffffff);
+  int64_t sizeChange = (size & 0x0000ffffffffffff) - mFile.mSize;
+  mFile.mSize = size & 0x0000ffffffffffff;
   lock.unlock();
   IFileMDChangeListener::Event e(this, IFileMDChangeListener::SizeChange, 0,
                                  sizeChange);
@@ -344,7 +419,7 @@ QuarkFileMD::setSize(uint64_t size)
 void
 QuarkFileMD::getCTimeNoLock(ctime_t& ctime) const
 {
-  (void) memcpy(&ctime, mFile.ctime().data(), sizeof(ctime_t));
+  ctime = mFile.mCTime;
 }
 
 //------------------------------------------------------------------------------
@@ -364,7 +439,7 @@ void
 QuarkFileMD::setCTime(ctime_t ctime)
 {
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile.set_ctime(&ctime, sizeof(ctime));
+  mFile.mCTime = ctime;
 }
 
 //----------------------------------------------------------------------------
@@ -391,7 +466,7 @@ QuarkFileMD::setCTimeNow()
 void
 QuarkFileMD::getMTimeNoLock(ctime_t& mtime) const
 {
-  (void) memcpy(&mtime, mFile.mtime().data(), sizeof(ctime_t));
+  mtime = mFile.mMTime;
 }
 
 //------------------------------------------------------------------------------
@@ -411,7 +486,7 @@ void
 QuarkFileMD::setMTime(ctime_t mtime)
 {
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile.set_mtime(&mtime, sizeof(mtime));
+  mFile.mMTime = mtime;
 }
 
 //------------------------------------------------------------------------------
@@ -441,8 +516,8 @@ QuarkFileMD::getAttributes() const
   std::shared_lock<std::shared_timed_mutex> lock(mMutex);
   std::map<std::string, std::string> xattrs;
 
-  for (const auto& elem : mFile.xattrs()) {
-    xattrs.insert(elem);
+  for (const auto& elem : mFile.mXAttrs) {
+    xattrs.emplace(*elem.first, elem.second.toStdString());
   }
 
   return xattrs;
@@ -453,8 +528,8 @@ QuarkFileMD::hasUnlinkedLocation(IFileMD::location_t location)
 {
   std::shared_lock<std::shared_timed_mutex> lock(mMutex);
 
-  for (int i = 0; i < mFile.unlink_locations_size(); ++i) {
-    if (mFile.unlink_locations()[i] == location) {
+  for (const auto& loc : mFile.mUnlinkLocations) {
+    if (loc == location) {
       return true;
     }
   }
@@ -26,7 +26,10 @@
 
 #include "namespace/interface/IFileMD.hh"
 #include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
+#include "namespace/ns_quarkdb/InternedXAttrs.hh"
 #include "proto/FileMd.pb.h"
+#include <folly/FBString.h>
+#include <folly/small_vector.h>
 #include <cstdint>
 #include <sys/time.h>
 #include <shared_mutex>
@@ -40,6 +43,42 @@ EOSNSNAMESPACE_BEGIN
 class IFileMDSvc;
 class IContainerMD;
 
+//------------------------------------------------------------------------------
+//! In-memory representation of the file metadata
+//!
+//! The protobuf object is only used to load and store the file. Once cached,
+//! the metadata lives in this record: names and checksums up to 23 bytes and
+//! up to four replica locations are stored inline, the attribute names are
+//! interned and the times are kept as timespec instead of byte strings.
+//------------------------------------------------------------------------------
+struct FileMdRecord {
+  uint64_t mId = 0; ///< File id
+  uint64_t mContId = 0; ///< Parent container id
+  uint64_t mUid = 0; ///< Owner uid
+  uint64_t mGid = 0; ///< Owner gid
+  uint64_t mSize = 0; ///< File size
+  uint32_t mLayoutId = 0; ///< Layout id
+  uint32_t mFlags = 0; ///< Flags
+  IFileMD::ctime_t mCTime {0, 0}; ///< Creation time
+  IFileMD::ctime_t mMTime {0, 0}; ///< Modification time
+  folly::fbstring mName; ///< File name
+  folly::fbstring mLinkName; ///< Symbolic link target
+  folly::fbstring mChecksum; ///< Binary checksum
+  folly::small_vector<IFileMD::location_t, 4> mLocations; ///< Locations
+  folly::small_vector<IFileMD::location_t, 2> mUnlinkLocations; ///< Unlinked
+  InternedXAttrs mXAttrs; ///< Extended attributes
+
+  //----------------------------------------------------------------------------
+  //! Load the contents of a protobuf object
+  //----------------------------------------------------------------------------
+  void fromProto(const eos::ns::FileMdProto& proto);
+
+  //----------------------------------------------------------------------------
+  //! Store the contents into a protobuf object
+  //----------------------------------------------------------------------------
+  void toProto(eos::ns::FileMdProto& proto) const;
+};
+
 //------------------------------------------------------------------------------
 //! Class holding the metadata information concerning a single file
 //------------------------------------------------------------------------------
@@ -115,7 +154,7 @@ public:
   getId() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.id();
+    return mFile.mId;
   }
 
   //----------------------------------------------------------------------------
@@ -124,7 +163,7 @@ public:
   inline FileIdentifier getIdentifier() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return FileIdentifier(mFile.id());
+    return FileIdentifier(mFile.mId);
   }
 
   //----------------------------------------------------------------------------
@@ -134,7 +173,7 @@ public:
   getSize() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.size();
+    return mFile.mSize;
   }
 
   //----------------------------------------------------------------------------
@@ -149,7 +188,7 @@ public:
   getContainerId() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.cont_id();
+    return mFile.mContId;
   }
 
   //----------------------------------------------------------------------------
@@ -159,7 +198,7 @@ public:
   setContainerId(IContainerMD::id_t containerId) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_cont_id(containerId);
+    mFile.mContId = containerId;
   }
 
   //----------------------------------------------------------------------------
@@ -169,8 +208,8 @@ public:
   getChecksum() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    Buffer buff(mFile.checksum().size());
-    buff.putData((void*)mFile.checksum().data(), mFile.checksum().size());
+    Buffer buff(mFile.mChecksum.size());
+    buff.putData((void*)mFile.mChecksum.data(), mFile.mChecksum.size());
     return buff;
   }
 
@@ -181,7 +220,7 @@ public:
   setChecksum(const Buffer& checksum) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_checksum(checksum.getDataPtr(), checksum.getSize());
+    mFile.mChecksum.assign(checksum.getDataPtr(), checksum.getSize());
   }
 
   //----------------------------------------------------------------------------
@@ -191,7 +230,7 @@ public:
   clearChecksum(uint8_t size = 20) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_checksum();
+    mFile.mChecksum.clear();
   }
 
   //----------------------------------------------------------------------------
@@ -204,7 +243,7 @@ public:
   setChecksum(const void* checksum, uint8_t size) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_checksum(checksum, size);
+    mFile.mChecksum.assign(static_cast<const char*>(checksum), size);
   }
 
   //----------------------------------------------------------------------------
@@ -214,7 +253,7 @@ public:
   getName() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.name();
+    return mFile.mName.toStdString();
   }
 
   //----------------------------------------------------------------------------
@@ -233,7 +272,7 @@ public:
   inline LocationVector getLocations() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    LocationVector locations(mFile.locations().begin(), mFile.locations().end());
+    LocationVector locations(mFile.mLocations.begin(), mFile.mLocations.end());
     return locations;
   }
 
@@ -245,8 +284,8 @@ public:
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
 
-    if (index < (unsigned int)mFile.locations_size()) {
-      return mFile.locations(index);
+    if (index < mFile.mLocations.size()) {
+      return mFile.mLocations[index];
     }
 
     return 0;
@@ -269,7 +308,7 @@ public:
   clearLocations() override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_locations();
+    mFile.mLocations.clear();
   }
 
   //----------------------------------------------------------------------------
@@ -278,8 +317,8 @@ public:
   bool
   hasLocationNoLock(location_t location)
   {
-    for (int i = 0; i < mFile.locations_size(); i++) {
-      if (mFile.locations(i) == location) {
+    for (const auto& loc : mFile.mLocations) {
+      if (loc == location) {
         return true;
       }
     }
@@ -304,7 +343,7 @@ public:
   getNumLocation() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.locations_size();
+    return mFile.mLocations.size();
   }
 
   //----------------------------------------------------------------------------
@@ -313,8 +352,8 @@ public:
   inline LocationVector getUnlinkedLocations() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    LocationVector unlinked_locations(mFile.unlink_locations().begin(),
-                                      mFile.unlink_locations().end());
+    LocationVector unlinked_locations(mFile.mUnlinkLocations.begin(),
+                                      mFile.mUnlinkLocations.end());
     return unlinked_locations;
   }
 
@@ -335,7 +374,7 @@ public:
   clearUnlinkedLocations() override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_unlink_locations();
+    mFile.mUnlinkLocations.clear();
   }
 
   //----------------------------------------------------------------------------
@@ -351,7 +390,7 @@ public:
   getNumUnlinkedLocation() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.unlink_locations_size();
+    return mFile.mUnlinkLocations.size();
   }
 
   //----------------------------------------------------------------------------
@@ -361,7 +400,7 @@ public:
   getCUid() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.uid();
+    return mFile.mUid;
   }
 
   //----------------------------------------------------------------------------
@@ -371,7 +410,7 @@ public:
   setCUid(uid_t uid) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_uid(uid);
+    mFile.mUid = uid;
   }
 
   //----------------------------------------------------------------------------
@@ -381,7 +420,7 @@ public:
   getCGid() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.gid();
+    return mFile.mGid;
   }
 
   //----------------------------------------------------------------------------
@@ -391,7 +430,7 @@ public:
   setCGid(gid_t gid) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_gid(gid);
+    mFile.mGid = gid;
   }
 
   //----------------------------------------------------------------------------
@@ -401,7 +440,7 @@ public:
   getLayoutId() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.layout_id();
+    return mFile.mLayoutId;
   }
 
   //----------------------------------------------------------------------------
@@ -411,7 +450,7 @@ public:
   setLayoutId(layoutId_t layoutId) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_layout_id(layoutId);
+    mFile.mLayoutId = layoutId;
   }
 
   //----------------------------------------------------------------------------
@@ -421,7 +460,7 @@ public:
   getFlags() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.flags();
+    return mFile.mFlags;
   }
 
   //----------------------------------------------------------------------------
@@ -431,7 +470,7 @@ public:
   getFlag(uint8_t n) override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return (bool)(mFile.flags() & (0x0001 << n));
+    return (bool)(mFile.mFlags & (0x0001 << n));
   }
 
   //----------------------------------------------------------------------------
@@ -441,7 +480,7 @@ public:
   setFlags(uint16_t flags) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_flags(flags);
+    mFile.mFlags = flags;
   }
 
   //----------------------------------------------------------------------------
@@ -453,9 +492,9 @@ public:
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
 
     if (flag) {
-      mFile.set_flags(mFile.flags() | (1 << n));
+      mFile.mFlags |= (1 << n);
     } else {
-      mFile.set_flags(mFile.flags() & (~(1 << n)));
+      mFile.mFlags &= ~(1 << n);
     }
   }
 
@@ -491,7 +530,7 @@ public:
   getLink() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.link_name();
+    return mFile.mLinkName.toStdString();
   }
 
   //----------------------------------------------------------------------------
@@ -501,7 +540,7 @@ public:
   setLink(std::string link_name) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_link_name(link_name);
+    mFile.mLinkName.assign(link_name.data(), link_name.size());
   }
 
   //----------------------------------------------------------------------------
@@ -511,7 +550,7 @@ public:
   isLink() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return !mFile.link_name().empty();
+    return !mFile.mLinkName.empty();
   }
 
   //----------------------------------------------------------------------------
@@ -521,7 +560,7 @@ public:
   setAttribute(const std::string& name, const std::string& value) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    (*mFile.mutable_xattrs())[name] = value;
+    mFile.mXAttrs.set(name, value);
   }
 
   //----------------------------------------------------------------------------
@@ -531,11 +570,7 @@ public:
   removeAttribute(const std::string& name) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.xattrs().find(name);
-
-    if (it != mFile.xattrs().end()) {
-      mFile.mutable_xattrs()->erase(it->first);
-    }
+    mFile.mXAttrs.remove(name);
   }
 
   //----------------------------------------------------------------------------
@@ -544,7 +579,7 @@ public:
   void clearAttributes() override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_xattrs();
+    mFile.mXAttrs.clear();
   }
 
   //----------------------------------------------------------------------------
@@ -554,7 +589,7 @@ public:
   hasAttribute(const std::string& name) const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return (mFile.xattrs().find(name) != mFile.xattrs().end());
+    return (mFile.mXAttrs.find(name) != nullptr);
   }
 
   //----------------------------------------------------------------------------
@@ -564,7 +599,7 @@ public:
   numAttributes() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.xattrs().size();
+    return mFile.mXAttrs.size();
   }
 
   //----------------------------------------------------------------------------
@@ -574,15 +609,15 @@ public:
   getAttribute(const std::string& name) const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.xattrs().find(name);
+    const folly::fbstring* value = mFile.mXAttrs.find(name);
 
-    if (it == mFile.xattrs().end()) {
+    if (value == nullptr) {
       MDException e(ENOENT);
       e.getMessage() << "Attribute: " << name << " not found";
       throw e;
     }
 
-    return it->second;
+    return value->toStdString();
   }
 
   //----------------------------------------------------------------------------
@@ -600,7 +635,7 @@ public:
   //----------------------------------------------------------------------------
   //! Initialize from protobuf contents
   //----------------------------------------------------------------------------
-  void initialize(eos::ns::FileMdProto&& proto);
+  void initialize(const eos::ns::FileMdProto& proto);
 
   //----------------------------------------------------------------------------
   //! Deserialize the class to a buffer
@@ -633,7 +668,7 @@ private:
   void getCTimeNoLock(ctime_t& ctime) const;
 
   mutable std::shared_timed_mutex mMutex;
-  eos::ns::FileMdProto mFile; ///< Protobuf file representation
+  FileMdRecord mFile; ///< Compact file representation
   uint64_t mClock; ///< Value tracking metadata changes
 };
 
@@ -0,0 +1,146 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Extended attributes with interned names
+//------------------------------------------------------------------------------
+
+#include "namespace/ns_quarkdb/InternedXAttrs.hh"
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
+EOSNSNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+//! Shard of the name pool. Elements of an unordered_set never move, pointers
+//! to them stay valid across rehashes.
+//------------------------------------------------------------------------------
+struct PoolShard {
+  std::mutex mMutex; ///< Mutex protecting the names
+  std::unordered_set<std::string> mNames; ///< Distinct names
+};
+
+constexpr size_t kPoolShards = 16;
+
+//------------------------------------------------------------------------------
+//! Get the pool shards, constructed on first use
+//------------------------------------------------------------------------------
+PoolShard*
+getPoolShards()
+{
+  static PoolShard shards[kPoolShards];
+  return shards;
+}
+}
+
+//------------------------------------------------------------------------------
+// Get the pooled copy of an attribute name
+//------------------------------------------------------------------------------
+const std::string*
+XAttrKeyPool::Intern(const std::string& name)
+{
+  if ((name.compare(0, 4, "sys.") != 0) &&
+      (name.compare(0, 9, "user.eos.") != 0)) {
+    return nullptr;
+  }
+
+  PoolShard& shard = getPoolShards()[std::hash<std::string>()(name) %
+                                     kPoolShards];
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  auto it = shard.mNames.find(name);
+
+  if (it != shard.mNames.end()) {
+    return &(*it);
+  }
+
+  if (shard.mNames.size() >= cMaxNames / kPoolShards) {
+    return nullptr;
+  }
+
+  return &(*shard.mNames.insert(name).first);
+}
+
+//------------------------------------------------------------------------------
+// Get the number of distinct names in the pool
+//------------------------------------------------------------------------------
+size_t
+XAttrKeyPool::Size()
+{
+  size_t count = 0;
+  PoolShard* shards = getPoolShards();
+
+  for (size_t i = 0; i < kPoolShards; ++i) {
+    std::lock_guard<std::mutex> lock(shards[i].mMutex);
+    count += shards[i].mNames.size();
+  }
+
+  return count;
+}
+
+//------------------------------------------------------------------------------
+// Set an attribute
+//------------------------------------------------------------------------------
+void
+InternedXAttrs::set(const std::string& name, const std::string& value)
+{
+  for (auto& entry : mEntries) {
+    if (*entry.first == name) {
+      entry.second.assign(value.data(), value.size());
+      return;
+    }
+  }
+
+  mEntries.emplace_back(XAttrName(name),
+                        folly::fbstring(value.data(), value.size()));
+}
+
+//------------------------------------------------------------------------------
+// Remove an attribute
+//------------------------------------------------------------------------------
+bool
+InternedXAttrs::remove(const std::string& name)
+{
+  for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+    if (*it->first == name) {
+      mEntries.erase(it);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Get the value of an attribute
+//------------------------------------------------------------------------------
+const folly::fbstring*
+InternedXAttrs::find(const std::string& name) const
+{
+  for (const auto& entry : mEntries) {
+    if (*entry.first == name) {
+      return &entry.second;
+    }
+  }
+
+  return nullptr;
+}
+
+EOSNSNAMESPACE_END
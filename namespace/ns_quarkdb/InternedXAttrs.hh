@@ -0,0 +1,187 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Extended attributes with interned names
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include <folly/FBString.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Pool of extended attribute names
+//!
+//! The cached metadata objects carry the same few attribute names over and
+//! over (sys.eos.btime, sys.fs.tracking, user.eos.* tags ...). Every distinct
+//! name is stored once in the pool and the objects only keep a pointer to it.
+//! The names are never released, therefore only the sys.* and user.eos.*
+//! names, which come from a small vocabulary, are pooled and the pool is
+//! capped at cMaxNames. Free-form user names are owned by the objects.
+//! Thread-safe.
+//------------------------------------------------------------------------------
+class XAttrKeyPool
+{
+public:
+  static constexpr size_t cMaxNames = 4096; ///< Max distinct pooled names
+
+  //----------------------------------------------------------------------------
+  //! Get the pooled copy of an attribute name, valid for the lifetime of the
+  //! process
+  //!
+  //! @return pooled name or nullptr if the name is not pooled
+  //----------------------------------------------------------------------------
+  static const std::string* Intern(const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of distinct names in the pool
+  //----------------------------------------------------------------------------
+  static size_t Size();
+};
+
+//------------------------------------------------------------------------------
+//! Name of an extended attribute, pooled if possible and otherwise owned
+//------------------------------------------------------------------------------
+class XAttrName
+{
+public:
+  explicit XAttrName(const std::string& name):
+    mName(XAttrKeyPool::Intern(name))
+  {
+    if (!mName) {
+      mOwned.reset(new std::string(name));
+      mName = mOwned.get();
+    }
+  }
+
+  XAttrName(const XAttrName& other):
+    mName(other.mName)
+  {
+    if (other.mOwned) {
+      mOwned.reset(new std::string(*other.mOwned));
+      mName = mOwned.get();
+    }
+  }
+
+  XAttrName(XAttrName&& other) = default;
+
+  XAttrName& operator=(XAttrName other)
+  {
+    std::swap(mName, other.mName);
+    std::swap(mOwned, other.mOwned);
+    return *this;
+  }
+
+  const std::string& operator*() const
+  {
+    return *mName;
+  }
+
+  const std::string* operator->() const
+  {
+    return mName;
+  }
+
+private:
+  const std::string* mName; ///< Pooled or owned name
+  std::unique_ptr<std::string> mOwned; ///< Owned name if not pooled
+};
+
+//------------------------------------------------------------------------------
+//! Compact extended attribute container
+//!
+//! Attributes are kept in a flat vector of (interned name, value) pairs in
+//! insertion order. Objects have a handful of attributes at most, a linear
+//! scan is then cheaper than any map both in memory and in time. Lookups
+//! compare the names directly and never touch the pool. Not thread-safe, the
+//! owner provides the locking.
+//------------------------------------------------------------------------------
+class InternedXAttrs
+{
+public:
+  //! Attribute entry: name and value
+  using Entry = std::pair<XAttrName, folly::fbstring>;
+  using const_iterator = std::vector<Entry>::const_iterator;
+
+  //----------------------------------------------------------------------------
+  //! Set an attribute, replacing any previous value
+  //----------------------------------------------------------------------------
+  void set(const std::string& name, const std::string& value);
+
+  //----------------------------------------------------------------------------
+  //! Remove an attribute
+  //!
+  //! @return true if the attribute existed, otherwise false
+  //----------------------------------------------------------------------------
+  bool remove(const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Remove all attributes, releasing their memory
+  //----------------------------------------------------------------------------
+  void clear()
+  {
+    std::vector<Entry>().swap(mEntries);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the value of an attribute
+  //!
+  //! @return pointer to the value or nullptr if not found
+  //----------------------------------------------------------------------------
+  const folly::fbstring* find(const std::string& name) const;
+
+  //----------------------------------------------------------------------------
+  //! Reserve room for the given number of attributes
+  //----------------------------------------------------------------------------
+  void reserve(size_t count)
+  {
+    mEntries.reserve(count);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of attributes
+  //----------------------------------------------------------------------------
+  size_t size() const
+  {
+    return mEntries.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Iterate over the attributes
+  //----------------------------------------------------------------------------
+  const_iterator begin() const
+  {
+    return mEntries.begin();
+  }
+
+  const_iterator end() const
+  {
+    return mEntries.end();
+  }
+
+private:
+  std::vector<Entry> mEntries; ///< Attributes in insertion order
+};
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,162 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/accounting/AncestorTree.hh"
+#include "namespace/MDException.hh"
+#include <folly/futures/Future.h>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Fetch the batch containers and their ancestors
+//------------------------------------------------------------------------------
+void
+AncestorTree::Build(const std::vector<IContainerMD::id_t>& ids,
+                    const AscendT& ascend)
+{
+  std::vector<IContainerMD::id_t> level;
+  mNodes.clear();
+  mRounds = 0;
+
+  for (auto id : ids) {
+    if ((id > 1) && mNodes.emplace(id, NodeT {0, 0}).second) {
+      level.push_back(id);
+    }
+  }
+
+  while (!level.empty()) {
+    std::vector<IContainerMD::id_t> next;
+    std::vector<IContainerMDPtr> conts = FetchAll(mContainerMDSvc, level);
+    ++mRounds;
+
+    for (size_t i = 0; i < level.size(); ++i) {
+      if (!conts[i]) {
+        mNodes.erase(level[i]);
+        continue;
+      }
+
+      if (ascend && !ascend(conts[i])) {
+        continue;
+      }
+
+      IContainerMD::id_t pid = conts[i]->getParentId();
+
+      if ((pid <= 1) || (pid == level[i])) {
+        continue;
+      }
+
+      mNodes[level[i]].mParent = pid;
+
+      // Parents already in the tree are fetched only once
+      if ((mRounds < mMaxDepth) && mNodes.emplace(pid, NodeT {0, 0}).second) {
+        next.push_back(pid);
+      }
+    }
+
+    level.swap(next);
+  }
+
+  // Link the nodes, the walk stops below the parents which are not in the
+  // tree i.e. could not be fetched or are above the maximum depth
+  for (auto& elem : mNodes) {
+    if (elem.second.mParent) {
+      auto it = mNodes.find(elem.second.mParent);
+
+      if (it == mNodes.end()) {
+        elem.second.mParent = 0;
+      } else {
+        ++it->second.mChildren;
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the containers of the tree, children first
+//------------------------------------------------------------------------------
+std::vector<IContainerMD::id_t>
+AncestorTree::GetBottomUpOrder() const
+{
+  std::vector<IContainerMD::id_t> order;
+  std::unordered_map<IContainerMD::id_t, uint32_t> remaining;
+  order.reserve(mNodes.size());
+
+  for (const auto& elem : mNodes) {
+    if (elem.second.mChildren == 0) {
+      order.push_back(elem.first);
+    }
+  }
+
+  // A parent is appended once all its children are in the list. Nodes on a
+  // cycle (corrupted namespace) never get there and are left out.
+  for (size_t i = 0; i < order.size(); ++i) {
+    IContainerMD::id_t pid = mNodes.at(order[i]).mParent;
+
+    if (pid == 0) {
+      continue;
+    }
+
+    auto it = remaining.emplace(pid, mNodes.at(pid).mChildren).first;
+
+    if (--it->second == 0) {
+      order.push_back(pid);
+    }
+  }
+
+  return order;
+}
+
+//------------------------------------------------------------------------------
+// Get the parent of a container in the tree
+//------------------------------------------------------------------------------
+IContainerMD::id_t
+AncestorTree::GetParent(IContainerMD::id_t id) const
+{
+  auto it = mNodes.find(id);
+  return ((it == mNodes.end()) ? 0 : it->second.mParent);
+}
+
+//------------------------------------------------------------------------------
+// Fetch the given containers in one pipelined round
+//------------------------------------------------------------------------------
+std::vector<IContainerMDPtr>
+AncestorTree::FetchAll(IContainerMDSvc* svc,
+                       const std::vector<IContainerMD::id_t>& ids)
+{
+  std::vector<folly::Future<IContainerMDPtr>> futs;
+  std::vector<IContainerMDPtr> conts;
+  futs.reserve(ids.size());
+  conts.reserve(ids.size());
+
+  // Issue all the lookups before waiting for any of them
+  for (auto id : ids) {
+    futs.emplace_back(svc->getContainerMDFut(id));
+  }
+
+  for (auto& fut : futs) {
+    try {
+      conts.push_back(std::move(fut).get());
+    } catch (const std::exception& e) {
+      conts.push_back(nullptr);
+    }
+  }
+
+  return conts;
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------------
+//! @file AncestorTree.hh
+//! @brief Ancestor tree of a batch of containers used by the accounting
+//!        listeners to propagate updates bottom-up
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include "namespace/interface/IContainerMDSvc.hh"
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Ancestor tree of a batch of containers. The parent chains of all the
+//! containers are fetched level by level, each level in one pipelined round
+//! of asynchronous lookups through the container service. The nodes are then
+//! returned children first so that an update merged bottom-up touches every
+//! ancestor exactly once, however many containers of the batch are below it.
+//------------------------------------------------------------------------------
+class AncestorTree
+{
+public:
+  //! Callback deciding if the walk continues above a container
+  using AscendT = std::function<bool(const IContainerMDPtr&)>;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param svc container metadata service
+  //! @param max_depth maximum number of levels walked above the batch
+  //----------------------------------------------------------------------------
+  AncestorTree(IContainerMDSvc* svc, uint16_t max_depth = 255):
+    mContainerMDSvc(svc), mMaxDepth(max_depth), mRounds(0)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Fetch the batch containers and their ancestors up to (excluding) the
+  //! root. A container which can not be fetched is left out of the tree and
+  //! stops the walk of its descendants.
+  //!
+  //! @param ids containers of the batch, duplicates are allowed
+  //! @param ascend optional callback, the walk stops at the containers for
+  //!        which it returns false
+  //----------------------------------------------------------------------------
+  void Build(const std::vector<IContainerMD::id_t>& ids,
+             const AscendT& ascend = nullptr);
+
+  //----------------------------------------------------------------------------
+  //! Get the containers of the tree, every container comes after all its
+  //! children in the tree
+  //----------------------------------------------------------------------------
+  std::vector<IContainerMD::id_t> GetBottomUpOrder() const;
+
+  //----------------------------------------------------------------------------
+  //! Get the parent of a container in the tree
+  //!
+  //! @param id container id
+  //!
+  //! @return parent id or 0 if the propagation stops at this container
+  //----------------------------------------------------------------------------
+  IContainerMD::id_t GetParent(IContainerMD::id_t id) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the number of pipelined lookup rounds done by Build
+  //----------------------------------------------------------------------------
+  inline uint64_t GetRounds() const
+  {
+    return mRounds;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Fetch the given containers in one pipelined round
+  //!
+  //! @param svc container metadata service
+  //! @param ids container ids
+  //!
+  //! @return containers in the order of the ids, null for the ones which
+  //!         could not be fetched
+  //----------------------------------------------------------------------------
+  static std::vector<IContainerMDPtr>
+  FetchAll(IContainerMDSvc* svc, const std::vector<IContainerMD::id_t>& ids);
+
+private:
+  //! Node of the tree
+  struct NodeT {
+    IContainerMD::id_t mParent; ///< Parent in the tree, 0 if none
+    uint32_t mChildren; ///< Number of children in the tree
+  };
+
+  IContainerMDSvc* mContainerMDSvc; ///< Container metadata service
+  uint16_t mMaxDepth; ///< Maximum number of levels walked
+  uint64_t mRounds; ///< Lookup rounds done by Build
+  std::unordered_map<IContainerMD::id_t, NodeT> mNodes; ///< Nodes by id
+};
+
+EOSNSNAMESPACE_END
@@ -17,7 +17,6 @@
  ************************************************************************/
 
 #include "namespace/ns_quarkdb/accounting/ContainerAccounting.hh"
-#include <iostream>
 #include <chrono>
 
 EOSNSNAMESPACE_BEGIN
@@ -100,30 +99,12 @@ QuarkContainerAccounting::RemoveTree(IContainerMD* obj, int64_t dsize)
 void
 QuarkContainerAccounting::QueueForUpdate(IContainerMD::id_t id, int64_t dsize)
 {
-  uint16_t deepness = 0;
-  std::shared_ptr<IContainerMD> cont;
-  std::lock_guard<std::mutex> scope_lock(mMutexBatch);
-  auto& batch = mBatch[mAccumulateIndx];
-
-  while ((id > 1) && (deepness < 255)) {
-    try {
-      cont = mContainerMDSvc->getContainerMD(id);
-    } catch (const MDException& e) {
-      // TODO (esindril): error message using default logging
-      break;
-    }
-
-    auto it_map = batch.mMap.find(id);
-
-    if (it_map != batch.mMap.end()) {
-      it_map->second += dsize;
-    } else {
-      batch.mMap.emplace(id, dsize);
-    }
-
-    id = cont->getParentId();
-    ++deepness;
+  if (id <= 1) {
+    return;
   }
+
+  std::lock_guard<std::mutex> scope_lock(mMutexBatch);
+  mBatch[mAccumulateIndx].mMap[id] += dsize;
 }
 
 //------------------------------------------------------------------------------
@@ -156,22 +137,11 @@ QuarkContainerAccounting::PropagateUpdates(ThreadAssistant* assistant)
     }
 
     auto& batch = mBatch[mCommitIndx];
-    {
-      // Need to lock the namespace
-      eos::common::RWMutexWriteLock wr_lock(*gNsRwMutex);
-      std::shared_ptr<IContainerMD> cont;
-
-      for (auto const& elem : batch.mMap) {
-        try {
-          cont = mContainerMDSvc->getContainerMD(elem.first);
-          cont->updateTreeSize(elem.second);
-          mContainerMDSvc->updateStore(cont.get());
-        } catch (const MDException& e) {
-          // TODO: (esindril) error message using default logging
-          continue;
-        }
-      }
+
+    if (!batch.mMap.empty()) {
+      ApplyBatch(batch.mMap);
     }
+
     batch.mMap.clear();
 
     if (mUpdateIntervalSec) {
@@ -186,4 +156,84 @@ QuarkContainerAccounting::PropagateUpdates(ThreadAssistant* assistant)
   }
 }
 
+//------------------------------------------------------------------------------
+// Merge the deltas of a batch bottom-up and apply them to the containers
+//------------------------------------------------------------------------------
+void
+QuarkContainerAccounting::ApplyBatch(
+  const std::unordered_map<IContainerMD::id_t, int64_t>& updates)
+{
+  auto start = std::chrono::steady_clock::now();
+  std::vector<IContainerMD::id_t> ids;
+  ids.reserve(updates.size());
+
+  for (const auto& elem : updates) {
+    ids.push_back(elem.first);
+  }
+
+  // Resolve the parent chains without holding the namespace lock
+  AncestorTree tree(mContainerMDSvc);
+  tree.Build(ids);
+  // Every container gets the sum of the deltas queued in its subtree
+  std::unordered_map<IContainerMD::id_t, int64_t> deltas(updates.begin(),
+      updates.end());
+  std::vector<IContainerMD::id_t> upd_ids;
+
+  for (auto id : tree.GetBottomUpOrder()) {
+    int64_t dsize = deltas[id];
+    IContainerMD::id_t pid = tree.GetParent(id);
+
+    if (pid) {
+      deltas[pid] += dsize;
+    }
+
+    if (dsize) {
+      upd_ids.push_back(id);
+    }
+  }
+
+  unsigned long long touched = 0;
+  {
+    // Need to lock the namespace, the containers are fetched again so that
+    // the ones removed in the meantime are not written back
+    eos::common::RWMutexWriteLock wr_lock(*gNsRwMutex);
+    std::vector<IContainerMDPtr> conts =
+      AncestorTree::FetchAll(mContainerMDSvc, upd_ids);
+
+    for (size_t i = 0; i < upd_ids.size(); ++i) {
+      if (!conts[i]) {
+        continue;
+      }
+
+      try {
+        conts[i]->updateTreeSize(deltas[upd_ids[i]]);
+        mContainerMDSvc->updateStore(conts[i].get());
+        ++touched;
+      } catch (const MDException& e) {
+        continue;
+      }
+    }
+  }
+  unsigned long long latency_us =
+    std::chrono::duration_cast<std::chrono::microseconds>
+    (std::chrono::steady_clock::now() - start).count();
+  {
+    std::lock_guard<std::mutex> scope_lock(mMutexStats);
+    mStats.Add(updates.size(), touched, tree.GetRounds(), latency_us);
+  }
+  eos_debug("msg=\"propagated tree size batch\" queued=%zu touched=%llu "
+            "rounds=%llu latency_us=%llu", updates.size(), touched,
+            (unsigned long long) tree.GetRounds(), latency_us);
+}
+
+//------------------------------------------------------------------------------
+// Get the statistics of the propagated batches
+//------------------------------------------------------------------------------
+PropagationStats
+QuarkContainerAccounting::getPropagationStats()
+{
+  std::lock_guard<std::mutex> scope_lock(mMutexStats);
+  return mStats;
+}
+
 EOSNSNAMESPACE_END
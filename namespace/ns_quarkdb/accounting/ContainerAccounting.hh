@@ -25,6 +25,8 @@
 #include "namespace/Namespace.hh"
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/interface/IFileMDSvc.hh"
+#include "namespace/ns_quarkdb/accounting/AncestorTree.hh"
+#include "common/Logging.hh"
 #include "common/RWMutex.hh"
 #include "common/AssistedThread.hh"
 #include <mutex>
@@ -39,7 +41,8 @@ EOSNSNAMESPACE_BEGIN
 //------------------------------------------------------------------------------
 //! Container subtree accounting listener
 //------------------------------------------------------------------------------
-class QuarkContainerAccounting : public IFileMDChangeListener
+class QuarkContainerAccounting : public IFileMDChangeListener,
+  public eos::common::LogId
 {
 public:
   //----------------------------------------------------------------------------
@@ -116,13 +119,19 @@ public:
   void QueueForUpdate(IContainerMD::id_t pid, int64_t dsize);
 
   //----------------------------------------------------------------------------
-  //! Propagate updates in the hierarchical structure
+  //! Propagate updates in the hierarchical structure. The deltas of a batch
+  //! are merged bottom-up so that every ancestor is updated once per batch.
   //!
   //! @param assistant thread doing the propagation or null by default if the
   //!        update should be done in the calling thread.
   //----------------------------------------------------------------------------
   void PropagateUpdates(ThreadAssistant* assistant = nullptr);
 
+  //----------------------------------------------------------------------------
+  //! Get the statistics of the propagated batches
+  //----------------------------------------------------------------------------
+  virtual PropagationStats getPropagationStats() override;
+
 private:
 
   //----------------------------------------------------------------------------
@@ -133,9 +142,17 @@ private:
   //----------------------------------------------------------------------------
   void AssistedPropagateUpdates(ThreadAssistant& assistant) noexcept;
 
-  //! Update structure containing the nodes that need an update. We try to
-  //! optimise the number of updates to the backend by computing the final
-  //! size deltas from a number of individual updates.
+  //----------------------------------------------------------------------------
+  //! Merge the deltas of a batch bottom-up and apply them to the containers
+  //!
+  //! @param updates size deltas of the containers having changed files
+  //----------------------------------------------------------------------------
+  void ApplyBatch(const std::unordered_map<IContainerMD::id_t, int64_t>&
+                  updates);
+
+  //! Update structure containing the containers whose content changed. Only
+  //! the direct parent of a file is queued, the ancestors are resolved when
+  //! the batch is propagated.
   struct UpdateT {
     std::unordered_map<IContainerMD::id_t, int64_t> mMap; ///< Map updates
   };
@@ -152,6 +169,8 @@ private:
   uint32_t mUpdateIntervalSec; ///< Interval in seconds when updates are pushed
   IContainerMDSvc* mContainerMDSvc; ///< container MD service
   eos::common::RWMutex* gNsRwMutex; ///< Global (MGM) name RW mutex
+  std::mutex mMutexStats; ///< Mutex protecting the statistics
+  PropagationStats mStats; ///< Statistics of the propagated batches
 };
 
 EOSNSNAMESPACE_END
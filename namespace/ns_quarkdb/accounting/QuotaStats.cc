@@ -308,19 +308,31 @@ QuarkQuotaStats::configure(const std::map<std::string, std::string>& config)
 IQuotaNode*
 QuarkQuotaStats::getQuotaNode(IContainerMD::id_t node_id)
 {
-  auto it = pNodeMap.find(node_id);
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(pNodeMapMutex);
+    auto it = pNodeMap.find(node_id);
 
-  if(it != pNodeMap.end()) {
-    return it->second.get();
+    if (it != pNodeMap.end()) {
+      return it->second.get();
+    }
   }
 
   std::string snode_id = std::to_string(node_id);
 
   if ((pQcl->exists(KeyQuotaUidMap(snode_id)) == 1) ||
       (pQcl->exists(KeyQuotaGidMap(snode_id)) == 1)) {
-    QuarkQuotaNode* ptr = new QuarkQuotaNode(this, node_id);
-    ptr->updateFromBackend();
-    pNodeMap[node_id].reset(ptr);
+    std::unique_ptr<QuarkQuotaNode> node(new QuarkQuotaNode(this, node_id));
+    node->updateFromBackend();
+    std::unique_lock<std::shared_timed_mutex> lock(pNodeMapMutex);
+    // Another thread may have loaded the same node in the meantime
+    auto it = pNodeMap.find(node_id);
+
+    if (it != pNodeMap.end()) {
+      return it->second.get();
+    }
+
+    QuarkQuotaNode* ptr = node.get();
+    pNodeMap[node_id] = std::move(node);
     return ptr;
   }
 
@@ -334,6 +346,7 @@ IQuotaNode*
 QuarkQuotaStats::registerNewNode(IContainerMD::id_t node_id)
 {
   std::string snode_id = std::to_string(node_id);
+  std::unique_lock<std::shared_timed_mutex> lock(pNodeMapMutex);
 
   if (pNodeMap.count(node_id) ||
       (pQcl->exists(KeyQuotaUidMap(snode_id)) == 1) ||
@@ -354,10 +367,13 @@ QuarkQuotaStats::registerNewNode(IContainerMD::id_t node_id)
 void
 QuarkQuotaStats::removeNode(IContainerMD::id_t node_id)
 {
-  auto it = pNodeMap.find(node_id);
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(pNodeMapMutex);
+    auto it = pNodeMap.find(node_id);
 
-  if (it != pNodeMap.end()) {
-    pNodeMap.erase(it);
+    if (it != pNodeMap.end()) {
+      pNodeMap.erase(it);
+    }
   }
 
   std::string snode_id = std::to_string(node_id);
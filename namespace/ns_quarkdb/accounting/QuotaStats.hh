@@ -24,6 +24,7 @@
 #pragma once
 #include "namespace/Namespace.hh"
 #include "namespace/interface/IQuota.hh"
+#include <shared_mutex>
 
 namespace qclient
 {
@@ -189,6 +190,8 @@ private:
   static bool ParseQuotaId(const std::string& input, IContainerMD::id_t& id);
 
   std::map<IContainerMD::id_t, std::unique_ptr<IQuotaNode>> pNodeMap; ///< Map of quota nodes
+  //! Protects pNodeMap, concurrent mutations only hold entry locks
+  std::shared_timed_mutex pNodeMapMutex;
   qclient::QClient* pQcl; ///< Backend client
   std::shared_ptr<MetadataFlusher> pFlusher; ///< Metadata flusher object
 };
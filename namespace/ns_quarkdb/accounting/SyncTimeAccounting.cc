@@ -19,9 +19,23 @@
 #include "namespace/ns_quarkdb/accounting/SyncTimeAccounting.hh"
 #include <iostream>
 #include <chrono>
+#include <unordered_set>
 
 EOSNSNAMESPACE_BEGIN
 
+namespace
+{
+//------------------------------------------------------------------------------
+// Check if a time is more recent than another one
+//------------------------------------------------------------------------------
+bool
+IsNewer(const IContainerMD::tmtime_t& a, const IContainerMD::tmtime_t& b)
+{
+  return ((a.tv_sec > b.tv_sec) ||
+          ((a.tv_sec == b.tv_sec) && (a.tv_nsec > b.tv_nsec)));
+}
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -117,81 +131,124 @@ QuarkSyncTimeAccounting::PropagateUpdates(ThreadAssistant* assistant)
       std::swap(mAccumulateIndx, mCommitIndx);
     }
 
-    uint16_t deepness = 0;
-    IContainerMD::id_t id = 0;
-    std::set<IContainerMD::id_t> upd_nodes;
     auto& lst = mBatch[mCommitIndx].mLstUpd;
 
-    // Start updating form the last node (most recent) and also collect the
-    // nodes that we've updated so that older updates don't propagate further
-    // up than strictly necessary.
-    for (auto it_id = lst.rbegin(); it_id != lst.rend(); ++it_id) {
-      deepness = 0;
-      id = *it_id;
+    if (!lst.empty()) {
+      ApplyBatch(lst);
+    }
+
+    // Clean up the batch
+    mBatch[mCommitIndx].Clean();
+
+    if (mUpdateIntervalSec) {
+      if (assistant) {
+        assistant->wait_for(std::chrono::seconds(mUpdateIntervalSec));
+      } else {
+        std::this_thread::sleep_for(std::chrono::seconds(mUpdateIntervalSec));
+      }
+    } else {
+      break;
+    }
+  }
+}
 
-      if (id == 0u) {
+//------------------------------------------------------------------------------
+// Merge the mtimes of a batch bottom-up and apply them to the containers
+//------------------------------------------------------------------------------
+void
+QuarkSyncTimeAccounting::ApplyBatch(const std::list<IContainerMD::id_t>& lst)
+{
+  auto start = std::chrono::steady_clock::now();
+  std::vector<IContainerMD::id_t> ids(lst.begin(), lst.end());
+  std::unordered_set<IContainerMD::id_t> queued(lst.begin(), lst.end());
+  // Resolve the parent chains without holding the namespace lock, only
+  // traverse containers having an attribute saying so
+  AncestorTree tree(mContainerMDSvc);
+  tree.Build(ids, [](const IContainerMDPtr & cont) {
+    return cont->hasAttribute("sys.mtime.propagation");
+  });
+  std::vector<IContainerMD::id_t> order = tree.GetBottomUpOrder();
+  // Most recent mtime propagated to every ancestor by its children
+  std::unordered_map<IContainerMD::id_t, IContainerMD::tmtime_t> propagated;
+  unsigned long long touched = 0;
+
+  if (!order.empty()) {
+    eos::common::RWMutexWriteLock wr_lock(*gNsRwMutex);
+    std::vector<IContainerMDPtr> conts =
+      AncestorTree::FetchAll(mContainerMDSvc, order);
+
+    for (size_t i = 0; i < order.size(); ++i) {
+      IContainerMD::id_t id = order[i];
+      std::shared_ptr<IContainerMD>& cont = conts[i];
+      bool is_queued = (queued.count(id) != 0);
+      auto it_prop = propagated.find(id);
+
+      if (!cont || (!is_queued && (it_prop == propagated.end()))) {
         continue;
       }
 
-      eos_debug("Container_id=%lu sync time", id);
-      IContainerMD::ctime_t mtime {0};
-      eos::common::RWMutexWriteLock wr_lock(*gNsRwMutex);
+      try {
+        if (!cont->hasAttribute("sys.mtime.propagation")) {
+          continue;
+        }
+
+        // If there was a temporary ETAG this has not to be removed
+        if (cont->hasAttribute("sys.tmp.etag")) {
+          cont->removeAttribute("sys.tmp.etag");
+        }
 
-      while ((id > 1) && (deepness < 255)) {
-        std::shared_ptr<IContainerMD> cont;
+        IContainerMD::ctime_t mtime {0};
 
-        // If node is already in the set of updates then don't bother
-        // propagating this update
-        if (upd_nodes.count(id)) {
-          break;
+        if (is_queued) {
+          cont->getMTime(mtime);
         }
 
-        try {
-          cont = mContainerMDSvc->getContainerMD(id);
+        if ((it_prop != propagated.end()) && IsNewer(it_prop->second, mtime)) {
+          mtime = it_prop->second;
+        }
 
-          // Only traverse if there there is an attribute saying so
-          if (!cont->hasAttribute("sys.mtime.propagation")) {
-            break;
-          }
+        // Ancestors already having a more recent time stop the propagation
+        if (!cont->setTMTime(mtime) && !is_queued) {
+          continue;
+        }
 
-          // If there was a temporary ETAG this has not to be removed
-          if (cont->hasAttribute("sys.tmp.etag")) {
-            cont->removeAttribute("sys.tmp.etag");
-          }
+        mContainerMDSvc->updateStore(cont.get());
+        ++touched;
+        IContainerMD::id_t pid = tree.GetParent(id);
 
-          if (deepness == 0u) {
-            cont->getMTime(mtime);
-          }
+        if (pid) {
+          auto it_parent = propagated.emplace(pid, mtime).first;
 
-          if (!cont->setTMTime(mtime) && deepness) {
-            break;
+          if (IsNewer(mtime, it_parent->second)) {
+            it_parent->second = mtime;
           }
-
-          (void) upd_nodes.insert(id);
-          mContainerMDSvc->updateStore(cont.get());
-        } catch (MDException& e) {
-          cont = nullptr;
-          break;
         }
-
-        id = cont->getParentId();
-        ++deepness;
+      } catch (MDException& e) {
+        continue;
       }
     }
+  }
 
-    // Clean up the batch
-    mBatch[mCommitIndx].Clean();
-
-    if (mUpdateIntervalSec) {
-      if (assistant) {
-        assistant->wait_for(std::chrono::seconds(mUpdateIntervalSec));
-      } else {
-        std::this_thread::sleep_for(std::chrono::seconds(mUpdateIntervalSec));
-      }
-    } else {
-      break;
-    }
+  unsigned long long latency_us =
+    std::chrono::duration_cast<std::chrono::microseconds>
+    (std::chrono::steady_clock::now() - start).count();
+  {
+    std::lock_guard<std::mutex> scope_lock(mMutexStats);
+    mStats.Add(lst.size(), touched, tree.GetRounds(), latency_us);
   }
+  eos_debug("msg=\"propagated sync time batch\" queued=%zu touched=%llu "
+            "rounds=%llu latency_us=%llu", lst.size(), touched,
+            (unsigned long long) tree.GetRounds(), latency_us);
+}
+
+//------------------------------------------------------------------------------
+// Get the statistics of the propagated batches
+//------------------------------------------------------------------------------
+PropagationStats
+QuarkSyncTimeAccounting::getPropagationStats()
+{
+  std::lock_guard<std::mutex> scope_lock(mMutexStats);
+  return mStats;
 }
 
 EOSNSNAMESPACE_END
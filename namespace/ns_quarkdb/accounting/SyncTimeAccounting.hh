@@ -25,6 +25,7 @@
 #include "namespace/MDException.hh"
 #include "namespace/Namespace.hh"
 #include "namespace/interface/IContainerMDSvc.hh"
+#include "namespace/ns_quarkdb/accounting/AncestorTree.hh"
 #include "common/Logging.hh"
 #include "common/RWMutex.hh"
 #include "common/AssistedThread.hh"
@@ -76,12 +77,18 @@ public:
 
   //----------------------------------------------------------------------------
   //! Propagate updates in the hierarchical structure. Method ran by the
-  //! asynchronous thread.
+  //! asynchronous thread. The mtimes of a batch are merged bottom-up so that
+  //! every ancestor is updated once per batch.
   //!
   //! @param assistant thread doing the propagation
   //----------------------------------------------------------------------------
   void PropagateUpdates(ThreadAssistant* assistant = nullptr);
 
+  //----------------------------------------------------------------------------
+  //! Get the statistics of the propagated batches
+  //----------------------------------------------------------------------------
+  virtual PropagationStats getPropagationStats() override;
+
   //----------------------------------------------------------------------------
   //! Queue container info for update
   //!
@@ -99,10 +106,16 @@ private:
   //----------------------------------------------------------------------------
   void AssistedPropagateUpdates(ThreadAssistant& assistant) noexcept;
 
+  //----------------------------------------------------------------------------
+  //! Merge the mtimes of a batch bottom-up and apply them to the containers
+  //!
+  //! @param lst containers whose mtime changed
+  //----------------------------------------------------------------------------
+  void ApplyBatch(const std::list<IContainerMD::id_t>& lst);
+
   //! Update structure containing a list of the nodes that need an update in
-  //! the order that the updates need to be applied and also a map used for
-  //! filtering out multiple updates to the same container ID. Try to optimise
-  //! the number of updates to a container by keeping only the last one.
+  //! the order they were queued and also a map used for filtering out
+  //! multiple updates to the same container ID.
   struct UpdateT {
     std::list<IContainerMD::id_t> mLstUpd; ///< Ordered list of updates
     //! Map used for fast search/insert operations
@@ -128,6 +141,8 @@ private:
   uint32_t mUpdateIntervalSec; ///< Interval in seconds when updates are pushed
   IContainerMDSvc* mContainerMDSvc; ///< Container meta-data service
   eos::common::RWMutex* gNsRwMutex; ///< Global(MGM) namespace RW mutex
+  std::mutex mMutexStats; ///< Mutex protecting the statistics
+  PropagationStats mStats; ///< Statistics of the propagated batches
 };
 
 EOSNSNAMESPACE_END
@@ -21,6 +21,7 @@
 #include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
 #include "namespace/utils/Attributes.hh"
 #include "common/Assert.hh"
+#include <algorithm>
 #include <memory>
 #include <numeric>
 
@@ -66,16 +67,36 @@ void SearchNode::stageFileMds()
   }
 
   pendingFileMdsLoaded = true;
-  // fileMap is hashmap, thus unsorted... must sort first by filename.. sigh.
-  // storing into a vector and calling std::sort might be faster, TODO
-  std::map<std::string, IFileMD::id_t> sortedFileMap;
+  // fileMap is hashmap, thus unsorted... must sort first by filename.
+  sortedFiles.reserve(fileMap->size());
 
   for (auto it = fileMap->begin(); it != fileMap->end(); it++) {
-    sortedFileMap[it->first] = it->second;
+    sortedFiles.emplace_back(it->first, it->second);
   }
 
-  for (auto it = sortedFileMap.begin(); it != sortedFileMap.end(); it++) {
-    pendingFileMds.push_back(MetadataFetcher::getFileFromId(qcl, FileIdentifier(it->second)));
+  // The names are already in sortedFiles, no need to keep the map around
+  fileMap->clear();
+  std::sort(sortedFiles.begin(), sortedFiles.end());
+  refillFileMds();
+}
+
+//------------------------------------------------------------------------------
+// Keep the window of in-flight file md requests full
+//------------------------------------------------------------------------------
+void SearchNode::refillFileMds()
+{
+  size_t window = std::max<size_t>(1, explorer.options.filePrefetchWindow);
+
+  while (pendingFileMds.size() < window && nextFile < sortedFiles.size()) {
+    pendingFileMds.push_back(MetadataFetcher::getFileFromId(qcl,
+                             FileIdentifier(sortedFiles[nextFile].second)));
+    nextFile++;
+  }
+
+  if (nextFile == sortedFiles.size()) {
+    // Release the memory as soon as the last request has been sent
+    std::vector<std::pair<std::string, IFileMD::id_t>>().swap(sortedFiles);
+    nextFile = 0;
   }
 }
 
@@ -103,6 +124,7 @@ std::unique_ptr<SearchNode> SearchNode::expand()
   // Explicit transfer of ownership
   std::unique_ptr<SearchNode> retval = std::move(children.front());
   children.pop_front();
+  refillChildren();
   return retval;
 }
 
@@ -135,17 +157,41 @@ void SearchNode::stageChildren()
   }
 
   childrenLoaded = true;
-  // containerMap is hashmap, thus unsorted... must sort first by filename.. sigh.
-  // storing into a vector and calling std::sort might be faster, TODO
-  std::map<std::string, IContainerMD::id_t, FilesystemEntryComparator> sortedContainerMap;
+  // containerMap is hashmap, thus unsorted... must sort first by filename.
+  sortedChildren.reserve(containerMap->size());
 
   for (auto it = containerMap->begin(); it != containerMap->end(); it++) {
-    sortedContainerMap[it->first] = it->second;
+    sortedChildren.emplace_back(it->first, it->second);
   }
 
-  for (auto it = sortedContainerMap.begin(); it != sortedContainerMap.end();
-       it++) {
-    children.emplace_back(new SearchNode(explorer, ContainerIdentifier(it->second), this));
+  containerMap->clear();
+  FilesystemEntryComparator cmp;
+  std::sort(sortedChildren.begin(), sortedChildren.end(),
+  [&cmp](const std::pair<std::string, IContainerMD::id_t>& lhs,
+  const std::pair<std::string, IContainerMD::id_t>& rhs) {
+    return cmp(lhs.first, rhs.first);
+  });
+  refillChildren();
+}
+
+//------------------------------------------------------------------------------
+// Keep the window of prefetched subcontainers full. Every SearchNode sends off
+// its own requests on construction, so creating them lazily bounds both the
+// memory and the number of requests in flight.
+//------------------------------------------------------------------------------
+void SearchNode::refillChildren()
+{
+  size_t window = std::max<size_t>(1, explorer.options.containerPrefetchWindow);
+
+  while (children.size() < window && nextChild < sortedChildren.size()) {
+    children.emplace_back(new SearchNode(explorer,
+                                         ContainerIdentifier(sortedChildren[nextChild].second), this));
+    nextChild++;
+  }
+
+  if (nextChild == sortedChildren.size()) {
+    std::vector<std::pair<std::string, IContainerMD::id_t>>().swap(sortedChildren);
+    nextChild = 0;
   }
 }
 
@@ -162,6 +208,7 @@ bool SearchNode::fetchChild(eos::ns::FileMdProto& output)
 
   output = pendingFileMds[0].get();
   pendingFileMds.pop_front();
+  refillFileMds();
   return true;
 }
 
@@ -375,7 +422,13 @@ bool NamespaceExplorer::fetch(NamespaceItem& item)
   }
 
   while (!dfsPath.empty()) {
-    dfsPath.back()->handleAsync();
+    // Containers at the depth limit are reported, but not looked into
+    bool atDepthLimit = (dfsPath.size() > (size_t) std::max(options.depthLimit,
+                         0));
+
+    if (!atDepthLimit) {
+      dfsPath.back()->handleAsync();
+    }
 
     // Has top node been visited yet?
     if (!dfsPath.back()->isVisited()) {
@@ -396,6 +449,11 @@ bool NamespaceExplorer::fetch(NamespaceItem& item)
       return true;
     }
 
+    if (atDepthLimit) {
+      dfsPath.pop_back();
+      continue;
+    }
+
     // Does the top node have any pending file children?
     if (!dfsPath.back()->expansionFilteredOut && dfsPath.back()->fetchChild(item.fileMd)) {
       item.isFile = true;
@@ -32,6 +32,8 @@
 #include <string>
 #include <vector>
 #include <deque>
+#include <limits>
+#include <utility>
 #include <folly/futures/Future.h>
 
 namespace qclient
@@ -56,7 +58,11 @@ public:
 };
 
 struct ExplorationOptions {
-  int depthLimit;
+  //----------------------------------------------------------------------------
+  //! Containers deeper than this, relative to the starting one, are not
+  //! visited; containers exactly at the limit are reported but not expanded.
+  //----------------------------------------------------------------------------
+  int depthLimit = std::numeric_limits<int>::max();
   std::shared_ptr<ExpansionDecider> expansionDecider;
   bool populateLinkedAttributes = false;
   bool prefixLinks = false; // only relevant if populateLinkedAttributes is true
@@ -65,6 +71,14 @@ struct ExplorationOptions {
   // You must supply the view if populateLinkedAttributes = true
   //----------------------------------------------------------------------------
   eos::IView *view = nullptr;
+
+  //----------------------------------------------------------------------------
+  //! Maximum number of file metadata requests in flight per container, and
+  //! maximum number of subcontainers prefetched ahead of the DFS. Together
+  //! with the depth of the tree they bound the memory used by an exploration.
+  //----------------------------------------------------------------------------
+  size_t filePrefetchWindow = 256;
+  size_t containerPrefetchWindow = 16;
 };
 
 struct NamespaceItem {
@@ -140,19 +154,24 @@ private:
   common::FutureWrapper<IContainerMD::FileMap> fileMap;
   common::FutureWrapper<IContainerMD::ContainerMap> containerMap;
 
-  // Second and final round fills out:
+  // Second and final round fills out, keeping only a bounded window of
+  // requests in flight which is refilled as entries are consumed:
+  std::vector<std::pair<std::string, IFileMD::id_t>> sortedFiles;
+  size_t nextFile = 0;
   std::deque<folly::Future<eos::ns::FileMdProto>> pendingFileMds;
   bool pendingFileMdsLoaded = false;
 
-  std::deque<std::unique_ptr<SearchNode>> children; // expanded containers
+  std::vector<std::pair<std::string, IContainerMD::id_t>> sortedChildren;
+  size_t nextChild = 0;
+  std::deque<std::unique_ptr<SearchNode>> children; // prefetched containers
   bool childrenLoaded = false;
 
   eos::IContainerMD::XAttrMap attrs;
 
-  // @todo (gbitzes): Replace this mess with a nice iterator object which
-  // provides all children of a container, fully asynchronous with prefetching.
   void stageFileMds();
   void stageChildren();
+  void refillFileMds();
+  void refillChildren();
 };
 
 //------------------------------------------------------------------------------
@@ -160,7 +179,9 @@ private:
 //! Useful for "Find" commands - no consistency guarantees, if a write is in
 //! the flusher, it might not be seen here.
 //!
-//! Implemented by simple DFS on the namespace.
+//! Implemented by simple DFS on the namespace. Metadata requests are
+//! pipelined ahead of the traversal within bounded windows, so the memory
+//! footprint does not grow with the size of the explored subtree.
 //------------------------------------------------------------------------------
 class NamespaceExplorer
 {
@@ -344,6 +344,19 @@ QuarkContainerMDSvc::notifyListeners(IContainerMD* obj,
   }
 }
 
+//------------------------------------------------------------------------------
+// Notify the listeners about an entry added to or removed from a container
+//------------------------------------------------------------------------------
+void
+QuarkContainerMDSvc::notifyEntryListeners(IContainerMD* parent,
+    const std::string& name, uint64_t id, bool is_container,
+    IContainerMDChangeListener::Action a)
+{
+  for (const auto& elem : pListeners) {
+    elem->containerMDEntryChanged(parent, name, id, is_container, a);
+  }
+}
+
 //------------------------------------------------------------------------------
 // Get first free container id
 //------------------------------------------------------------------------------
@@ -206,6 +206,13 @@ private:
   void notifyListeners(IContainerMD* obj, IContainerMDChangeListener::Action a)
   override;
 
+  //----------------------------------------------------------------------------
+  //! Notify the listeners about an entry added to or removed from a container
+  //----------------------------------------------------------------------------
+  void notifyEntryListeners(IContainerMD* parent, const std::string& name,
+                            uint64_t id, bool is_container,
+                            IContainerMDChangeListener::Action a) override;
+
   //----------------------------------------------------------------------------
   //! Safety check to make sure there are no container entries in the backend
   //! with ids bigger than the max container id. If there is any problem this
@@ -220,20 +220,31 @@ private:
   folly::Promise<ContainerType> mPromise;
 };
 
+//------------------------------------------------------------------------------
+// Parse the file metadata out of a reply, throw on error
+//------------------------------------------------------------------------------
+void
+MetadataFetcher::parseFileMdProto(const redisReplyPtr& reply,
+                                  FileIdentifier id, eos::ns::FileMdProto& proto)
+{
+  redisReplyPtr rep = reply;
+  ensureStringReply(rep).throwIfNotOk(SSTR("Error while fetching FileMD #"
+                                      << id.getUnderlyingUInt64()
+                                      << " protobuf from QDB: "));
+  Serialization::deserialize(rep->str, rep->len, proto)
+  .throwIfNotOk(SSTR("Error while deserializing FileMD #"
+                     << id.getUnderlyingUInt64()
+                     << " protobuf: "));
+}
+
 //------------------------------------------------------------------------------
 // Parse FileMDProto from a redis response, throw on error.
 //------------------------------------------------------------------------------
 static eos::ns::FileMdProto
 parseFileMdProtoResponse(redisReplyPtr reply, FileIdentifier id)
 {
-  ensureStringReply(reply).throwIfNotOk(SSTR("Error while fetching FileMD #"
-                                        << id.getUnderlyingUInt64()
-                                        << " protobuf from QDB: "));
   eos::ns::FileMdProto proto;
-  Serialization::deserialize(reply->str, reply->len, proto)
-  .throwIfNotOk(SSTR("Error while deserializing FileMD #"
-                     << id.getUnderlyingUInt64()
-                     << " protobuf: "));
+  MetadataFetcher::parseFileMdProto(reply, id, proto);
   return std::move(proto);
 }
 
@@ -247,6 +258,16 @@ MetadataFetcher::getFileFromId(qclient::QClient& qcl, FileIdentifier id)
          .then(std::bind(parseFileMdProtoResponse, _1, id));
 }
 
+//------------------------------------------------------------------------------
+// Fetch the serialized file metadata for current id
+//------------------------------------------------------------------------------
+folly::Future<redisReplyPtr>
+MetadataFetcher::getSerializedFileFromId(qclient::QClient& qcl,
+    FileIdentifier id)
+{
+  return qcl.follyExec(RequestBuilder::readFileProto(id));
+}
+
 //----------------------------------------------------------------------------
 // Fetch file metadata info for current id
 //------------------------------------------------------------------------------
@@ -29,15 +29,10 @@
 #include "namespace/Namespace.hh"
 #include "proto/FileMd.pb.h"
 #include "proto/ContainerMd.pb.h"
+#include "qclient/QClient.hh"
 #include <future>
 #include <folly/futures/Future.h>
 
-//! Forward declaration
-namespace qclient
-{
-class QClient;
-}
-
 EOSNSNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
@@ -57,6 +52,29 @@ public:
   static folly::Future<eos::ns::FileMdProto>
   getFileFromId(qclient::QClient& qcl, FileIdentifier id);
 
+  //----------------------------------------------------------------------------
+  //! Fetch the serialized file metadata for current id, leaving the parsing
+  //! to the caller. Allows parsing outside of the qclient event loop and into
+  //! a caller provided protobuf object, eg. one living on an arena.
+  //!
+  //! @param qcl qclient object
+  //! @param id file id
+  //!
+  //! @return future holding the raw reply
+  //----------------------------------------------------------------------------
+  static folly::Future<qclient::redisReplyPtr>
+  getSerializedFileFromId(qclient::QClient& qcl, FileIdentifier id);
+
+  //----------------------------------------------------------------------------
+  //! Parse the file metadata out of a reply, throws MDException on error
+  //!
+  //! @param reply reply to a file metadata request
+  //! @param id file id
+  //! @param proto protobuf object to fill in
+  //----------------------------------------------------------------------------
+  static void parseFileMdProto(const qclient::redisReplyPtr& reply,
+                               FileIdentifier id, eos::ns::FileMdProto& proto);
+
   //----------------------------------------------------------------------------
   //! Fetch container metadata info for current id
   //!
@@ -117,6 +117,9 @@ void aggregateStatistics(CacheStatistics &global, const CacheStatistics local) {
   global.occupancy += local.occupancy;
   global.maxNum += local.maxNum;
   global.inFlight += local.inFlight;
+  global.hits += local.hits;
+  global.misses += local.misses;
+  global.evictions += local.evictions;
 }
 
 //------------------------------------------------------------------------------
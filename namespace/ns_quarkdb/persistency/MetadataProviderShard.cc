@@ -28,6 +28,7 @@
 #include "namespace/ns_quarkdb/ContainerMD.hh"
 #include "namespace/MDException.hh"
 #include "namespace/ns_quarkdb/BackendClient.hh"
+#include "namespace/ns_quarkdb/persistency/StackArena.hh"
 #include "common/Assert.hh"
 #include <functional>
 
@@ -46,15 +47,55 @@ MetadataProviderShard::MetadataProviderShard(qclient::QClient *qcl,
   mQcl = qcl;
 }
 
+//------------------------------------------------------------------------------
+// Turn a cached ContainerMD into a ready future
+//------------------------------------------------------------------------------
+folly::Future<IContainerMDPtr>
+MetadataProviderShard::ToFuture(IContainerMDPtr&& item, ContainerIdentifier id)
+{
+  // Handle special case where we're dealing with a tombstone.
+  if (item->isDeleted()) {
+    return folly::makeFuture<IContainerMDPtr>
+           (make_mdexception(ENOENT, "Container #" << id.getUnderlyingUInt64()
+                             << " does not exist (found deletion tombstone)"));
+  }
+
+  return folly::makeFuture<IContainerMDPtr>(std::move(item));
+}
+
+//------------------------------------------------------------------------------
+// Turn a cached FileMD into a ready future
+//------------------------------------------------------------------------------
+folly::Future<IFileMDPtr>
+MetadataProviderShard::ToFuture(IFileMDPtr&& item, FileIdentifier id)
+{
+  // Handle special case where we're dealing with a tombstone.
+  if (item->isDeleted()) {
+    return folly::makeFuture<IFileMDPtr>
+           (make_mdexception(ENOENT, "File #" << id.getUnderlyingUInt64()
+                             << " does not exist (found deletion tombstone)"));
+  }
+
+  return folly::makeFuture<IFileMDPtr>(std::move(item));
+}
+
 //------------------------------------------------------------------------------
 // Retrieve ContainerMD by ID.
 //------------------------------------------------------------------------------
 folly::Future<IContainerMDPtr>
 MetadataProviderShard::retrieveContainerMD(ContainerIdentifier id)
 {
-  std::unique_lock<std::mutex> lock(mMutex);
   // A ContainerMD can be in three states: Not in cache, inside in-flight cache,
-  // and cached. Is it inside in-flight cache?
+  // and cached. The cache lookup only takes a shard read lock, so try it
+  // first without serializing on the in-flight staging area mutex.
+  IContainerMDPtr result = mContainerCache.get(id);
+
+  if (result) {
+    return ToFuture(std::move(result), id);
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  // Is it inside in-flight cache?
   auto it = mInFlightContainers.find(id);
 
   if (it != mInFlightContainers.end()) {
@@ -64,20 +105,12 @@ MetadataProviderShard::retrieveContainerMD(ContainerIdentifier id)
     return it->second.getFuture();
   }
 
-  // Nope.. is it inside the long-lived cache?
-  IContainerMDPtr result = mContainerCache.get(id);
+  // Nope.. did it make it into the long-lived cache in the meantime?
+  result = mContainerCache.peek(id);
 
   if (result) {
     lock.unlock();
-
-    // Handle special case where we're dealing with a tombstone.
-    if (result->isDeleted()) {
-      return folly::makeFuture<IContainerMDPtr>
-             (make_mdexception(ENOENT, "Container #" << id.getUnderlyingUInt64()
-                               << " does not exist (found deletion tombstone)"));
-    }
-
-    return folly::makeFuture<IContainerMDPtr>(std::move(result));
+    return ToFuture(std::move(result), id);
   }
 
   // Nope, need to fetch, and insert into the in-flight staging area. Merge
@@ -109,9 +142,17 @@ MetadataProviderShard::retrieveContainerMD(ContainerIdentifier id)
 folly::Future<IFileMDPtr>
 MetadataProviderShard::retrieveFileMD(FileIdentifier id)
 {
-  std::unique_lock<std::mutex> lock(mMutex);
   // A FileMD can be in three states: Not in cache, inside in-flight cache,
-  // and cached. Is it inside in-flight cache?
+  // and cached. The cache lookup only takes a shard read lock, so try it
+  // first without serializing on the in-flight staging area mutex.
+  IFileMDPtr result = mFileCache.get(id);
+
+  if (result) {
+    return ToFuture(std::move(result), id);
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  // Is it inside in-flight cache?
   auto it = mInFlightFiles.find(id);
 
   if (it != mInFlightFiles.end()) {
@@ -121,26 +162,22 @@ MetadataProviderShard::retrieveFileMD(FileIdentifier id)
     return it->second.getFuture();
   }
 
-  // Nope.. is it inside the long-lived cache?
-  IFileMDPtr result = mFileCache.get(id);
+  // Nope.. did it make it into the long-lived cache in the meantime?
+  result = mFileCache.peek(id);
 
   if (result) {
     lock.unlock();
-
-    // Handle special case where we're dealing with a tombstone.
-    if (result->isDeleted()) {
-      return folly::makeFuture<IFileMDPtr>
-             (make_mdexception(ENOENT, "File #" << id.getUnderlyingUInt64()
-                               << " does not exist (found deletion tombstone)"));
-    }
-
-    return folly::makeFuture<IFileMDPtr>(std::move(result));
+    return ToFuture(std::move(result), id);
   }
 
   // Nope, need to fetch, and insert into the in-flight staging area.
-  folly::Future<IFileMDPtr> fut = MetadataFetcher::getFileFromId(*mQcl, id)
-                                  .via(mExecutor)
-                                  .then(std::bind(&MetadataProviderShard::processIncomingFileMdProto, this, id, _1))
+  // Only the raw reply is received on the qclient event loop, the parsing
+  // happens on the executor.
+  folly::Future<IFileMDPtr> fut =
+    MetadataFetcher::getSerializedFileFromId(*mQcl, id)
+    .via(mExecutor)
+    .then(std::bind(&MetadataProviderShard::processIncomingFileMdReply, this, id,
+                    _1))
   .onError([this, id](const folly::exception_wrapper & e) {
     // If the operation failed, clear the in-flight cache.
     std::lock_guard<std::mutex> lock(mMutex);
@@ -232,20 +269,33 @@ MetadataProviderShard::processIncomingContainerMD(ContainerIdentifier id,
   return item;
 }
 
+//------------------------------------------------------------------------------
+// Parse an incoming FileMD reply on a stack arena and process it
+//------------------------------------------------------------------------------
+IFileMDPtr
+MetadataProviderShard::processIncomingFileMdReply(FileIdentifier id,
+    qclient::redisReplyPtr reply)
+{
+  StackArena<> arena;
+  eos::ns::FileMdProto* proto = arena.create<eos::ns::FileMdProto>();
+  MetadataFetcher::parseFileMdProto(reply, id, *proto);
+  return processIncomingFileMdProto(id, *proto);
+}
+
 //------------------------------------------------------------------------------
 // Turn an incoming FileMDProto into FileMD, removing from the inFlight
 // staging area, and inserting into the cache.
 //------------------------------------------------------------------------------
 IFileMDPtr
 MetadataProviderShard::processIncomingFileMdProto(FileIdentifier id,
-    eos::ns::FileMdProto proto)
+    const eos::ns::FileMdProto& proto)
 {
-  std::lock_guard<std::mutex> lock(mMutex);
   // Things look sane?
   eos_assert(proto.id() == id.getUnderlyingUInt64());
   // Yep, construct FileMD object..
   QuarkFileMD* fileMD = new QuarkFileMD(0, mFileSvc);
-  fileMD->initialize(std::move(proto));
+  fileMD->initialize(proto);
+  std::lock_guard<std::mutex> lock(mMutex);
   // Drop inFlightFiles future..
   auto it = mInFlightFiles.find(id);
   eos_assert(it != mInFlightFiles.end());
@@ -265,6 +315,10 @@ CacheStatistics MetadataProviderShard::getFileMDCacheStats()
   stats.enabled = true;
   stats.occupancy = mFileCache.size();
   stats.maxNum = mFileCache.get_max_num();
+  ClockCacheShardStats cache_stats = mFileCache.get_stats();
+  stats.hits = cache_stats.hits;
+  stats.misses = cache_stats.misses;
+  stats.evictions = cache_stats.evictions;
 
   std::lock_guard<std::mutex> lock(mMutex);
   stats.inFlight = mInFlightFiles.size();
@@ -280,6 +334,10 @@ CacheStatistics MetadataProviderShard::getContainerMDCacheStats()
   stats.enabled = true;
   stats.occupancy = mContainerCache.size();
   stats.maxNum = mContainerCache.get_max_num();
+  ClockCacheShardStats cache_stats = mContainerCache.get_stats();
+  stats.hits = cache_stats.hits;
+  stats.misses = cache_stats.misses;
+  stats.evictions = cache_stats.evictions;
 
   std::lock_guard<std::mutex> lock(mMutex);
   stats.inFlight = mInFlightContainers.size();
@@ -26,7 +26,7 @@
 #include "namespace/interface/IFileMD.hh"
 #include "namespace/interface/IContainerMD.hh"
 #include "namespace/Namespace.hh"
-#include "namespace/ns_quarkdb/LRU.hh"
+#include "namespace/ns_quarkdb/ClockCache.hh"
 #include "namespace/interface/Misc.hh"
 #include "namespace/ns_quarkdb/FileMD.hh"
 #include "namespace/ns_quarkdb/ContainerMD.hh"
@@ -103,12 +103,30 @@ public:
   CacheStatistics getContainerMDCacheStats();
 
 private:
+  //----------------------------------------------------------------------------
+  //! Turn a cached ContainerMD into a ready future, handling tombstones
+  //----------------------------------------------------------------------------
+  static folly::Future<IContainerMDPtr> ToFuture(IContainerMDPtr&& item,
+      ContainerIdentifier id);
+
+  //----------------------------------------------------------------------------
+  //! Turn a cached FileMD into a ready future, handling tombstones
+  //----------------------------------------------------------------------------
+  static folly::Future<IFileMDPtr> ToFuture(IFileMDPtr&& item,
+      FileIdentifier id);
+
+  //----------------------------------------------------------------------------
+  //! Parse an incoming FileMD reply on a stack arena and process it
+  //----------------------------------------------------------------------------
+  IFileMDPtr processIncomingFileMdReply(FileIdentifier id,
+                                        qclient::redisReplyPtr reply);
+
   //----------------------------------------------------------------------------
   //! Turn an incoming FileMDProto into FileMD, removing from the inFlight
   //! staging area, and inserting into the cache
   //----------------------------------------------------------------------------
   IFileMDPtr processIncomingFileMdProto(FileIdentifier id,
-                                        eos::ns::FileMdProto proto);
+                                        const eos::ns::FileMdProto& proto);
 
   //----------------------------------------------------------------------------
   //! Turn a (ContainerMDProto, FileMap, ContainerMap) triplet into a
@@ -128,8 +146,8 @@ private:
   std::map<ContainerIdentifier,
       folly::FutureSplitter<IContainerMDPtr>> mInFlightContainers;
   std::map<FileIdentifier, folly::FutureSplitter<IFileMDPtr>> mInFlightFiles;
-  LRU<ContainerIdentifier, IContainerMD> mContainerCache;
-  LRU<FileIdentifier, IFileMD> mFileCache;
+  ClockCache<ContainerIdentifier, IContainerMD> mContainerCache;
+  ClockCache<FileIdentifier, IFileMD> mFileCache;
   folly::Executor *mExecutor; // no ownership
 };
 
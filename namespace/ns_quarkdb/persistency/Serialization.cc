@@ -31,62 +31,74 @@
 
 EOSNSNAMESPACE_BEGIN
 
-MDStatus
-Serialization::deserializeNoThrow(const Buffer& buffer, eos::ns::FileMdProto &proto)
+//------------------------------------------------------------------------------
+// Verify the checksum of a serialized object and parse the protobuf in it
+// straight from the given memory
+//------------------------------------------------------------------------------
+template<typename Proto>
+static MDStatus
+parseChecksummed(const char* data, size_t len, Proto& proto, const char* what)
 {
   uint32_t cksum_expected = 0;
   uint32_t obj_size = 0;
   size_t sz = sizeof(cksum_expected);
-  const char* ptr = buffer.getDataPtr();
+
+  if (len < 2 * sz) {
+    return MDStatus(EIO, SSTR(what << " object too short"));
+  }
+
+  const char* ptr = data;
   (void) memcpy(&cksum_expected, ptr, sz);
   ptr += sz;
   (void) memcpy(&obj_size, ptr, sz);
-  size_t msg_size = buffer.getSize();
-  uint32_t align_size = msg_size - 2 * sz;
+  uint32_t align_size = len - 2 * sz;
   ptr += sz; // now pointing to the serialized object
+
+  if (obj_size > align_size) {
+    return MDStatus(EIO, SSTR(what << " object size mismatch"));
+  }
+
   uint32_t cksum_computed = DataHelper::computeCRC32C((void*)ptr, align_size);
   cksum_computed = DataHelper::finalizeCRC32C(cksum_computed);
 
   if (cksum_expected != cksum_computed) {
-    return MDStatus(EIO, "FileMD object checksum mismatch");
+    return MDStatus(EIO, SSTR(what << " object checksum mismatch"));
   }
 
   google::protobuf::io::ArrayInputStream ais(ptr, obj_size);
 
   if (!proto.ParseFromZeroCopyStream(&ais)) {
-    return MDStatus(EIO, "Failed while deserializing FileMD buffer");
+    return MDStatus(EIO, SSTR("Failed while deserializing " << what
+                              << " buffer"));
   }
 
   return {};
 }
 
 MDStatus
-Serialization::deserializeNoThrow(const Buffer& buffer, eos::ns::ContainerMdProto &proto)
+Serialization::deserializeNoThrow(const char* data, size_t len,
+                                  eos::ns::FileMdProto& proto)
 {
-  uint32_t cksum_expected = 0;
-  uint32_t obj_size = 0;
-  size_t sz = sizeof(cksum_expected);
-  const char* ptr = buffer.getDataPtr();
-  (void) memcpy(&cksum_expected, ptr, sz);
-  ptr += sz;
-  (void) memcpy(&obj_size, ptr, sz);
-  size_t msg_size = buffer.getSize();
-  uint32_t align_size = msg_size - 2 * sz;
-  ptr += sz; // now pointing to the serialized object
-  uint32_t cksum_computed = DataHelper::computeCRC32C((void*)ptr, align_size);
-  cksum_computed = DataHelper::finalizeCRC32C(cksum_computed);
-
-  if (cksum_expected != cksum_computed) {
-    return MDStatus(EIO, "ContainerMD object checksum mismatch");
-  }
+  return parseChecksummed(data, len, proto, "FileMD");
+}
 
-  google::protobuf::io::ArrayInputStream ais(ptr, obj_size);
+MDStatus
+Serialization::deserializeNoThrow(const char* data, size_t len,
+                                  eos::ns::ContainerMdProto& proto)
+{
+  return parseChecksummed(data, len, proto, "ContainerMD");
+}
 
-  if (!proto.ParseFromZeroCopyStream(&ais)) {
-    return MDStatus(EIO, "Failed while deserializing ContainerMD buffer");
-  }
+MDStatus
+Serialization::deserializeNoThrow(const Buffer& buffer, eos::ns::FileMdProto &proto)
+{
+  return deserializeNoThrow(buffer.getDataPtr(), buffer.getSize(), proto);
+}
 
-  return {};
+MDStatus
+Serialization::deserializeNoThrow(const Buffer& buffer, eos::ns::ContainerMdProto &proto)
+{
+  return deserializeNoThrow(buffer.getDataPtr(), buffer.getSize(), proto);
 }
 
 MDStatus
@@ -43,6 +43,18 @@ class Serialization
 {
 public:
 
+  //----------------------------------------------------------------------------
+  //! Deserialize a FileMD protobuf straight from the given memory
+  //----------------------------------------------------------------------------
+  static MDStatus deserializeNoThrow(const char* data, size_t len,
+                                     eos::ns::FileMdProto& proto);
+
+  //----------------------------------------------------------------------------
+  //! Deserialize a ContainerMD protobuf straight from the given memory
+  //----------------------------------------------------------------------------
+  static MDStatus deserializeNoThrow(const char* data, size_t len,
+                                     eos::ns::ContainerMdProto& proto);
+
   //----------------------------------------------------------------------------
   //! Deserialize a FileMD protobuf
   //----------------------------------------------------------------------------
@@ -64,6 +76,21 @@ public:
   //----------------------------------------------------------------------------
   static MDStatus deserializeNoThrow(const Buffer& buffer, int64_t& val);
 
+  //----------------------------------------------------------------------------
+  //! Deserialize protobufs without copying the input
+  //----------------------------------------------------------------------------
+  static MDStatus deserialize(const char* str, size_t len,
+                              eos::ns::FileMdProto& output)
+  {
+    return Serialization::deserializeNoThrow(str, len, output);
+  }
+
+  static MDStatus deserialize(const char* str, size_t len,
+                              eos::ns::ContainerMdProto& output)
+  {
+    return Serialization::deserializeNoThrow(str, len, output);
+  }
+
   //----------------------------------------------------------------------------
   //! Deserialize any supported type.
   //----------------------------------------------------------------------------
@@ -0,0 +1,76 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Protobuf arena starting on a stack buffer
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include <google/protobuf/arena.h>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Protobuf arena for messages which only live while they are converted from
+//! or to the in-memory metadata representation. All the strings, repeated
+//! fields and map entries of a message created on it are carved out of one
+//! embedded buffer, so parsing or building an average FileMdProto needs no
+//! heap allocation as long as it fits in BlockSize. Larger messages overflow
+//! into heap blocks, allocated by the arena and released together when it
+//! goes out of scope.
+//------------------------------------------------------------------------------
+template <size_t BlockSize = 8192>
+class StackArena
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  StackArena(): mArena(MakeOptions(mBlock))
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Create a message on the arena, owned by the arena
+  //----------------------------------------------------------------------------
+  template <typename Message>
+  Message* create()
+  {
+    return google::protobuf::Arena::CreateMessage<Message>(&mArena);
+  }
+
+  StackArena(const StackArena&) = delete;
+  StackArena& operator=(const StackArena&) = delete;
+
+private:
+  //----------------------------------------------------------------------------
+  //! Arena options using the embedded buffer as first block
+  //----------------------------------------------------------------------------
+  static google::protobuf::ArenaOptions MakeOptions(char* block)
+  {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = block;
+    options.initial_block_size = BlockSize;
+    return options;
+  }
+
+  alignas(16) char mBlock[BlockSize]; ///< First block of the arena
+  google::protobuf::Arena mArena; ///< Arena, declared after its first block
+};
+
+EOSNSNAMESPACE_END
@@ -23,11 +23,16 @@
 #include "common/RWMutex.hh"
 #include "common/StringConversion.hh"
 #include "common/Timing.hh"
+#include "namespace/ns_quarkdb/FileMD.hh"
 #include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
 #include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
+#include "namespace/ns_quarkdb/persistency/Serialization.hh"
 #include "namespace/ns_quarkdb/views/HierarchicalView.hh"
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -211,6 +216,121 @@ RunReader(void* tconf)
   return nullptr;
 }
 
+//------------------------------------------------------------------------------
+// Build the path of a file in the deep path benchmark
+//------------------------------------------------------------------------------
+static std::string
+DeepFilePath(const std::string& dir, size_t n)
+{
+  char s_file[64];
+  snprintf(static_cast<char*>(s_file), sizeof(s_file) - 1,
+           "/file____________________%08u", static_cast<unsigned int>(n));
+  return dir + static_cast<char*>(s_file);
+}
+
+//------------------------------------------------------------------------------
+// Print the statistics of the path lookup caches
+//------------------------------------------------------------------------------
+static void
+PrintPathCacheStatus(eos::IView* view)
+{
+  eos::PathCacheStatistics stats = view->getPathCacheStatistics();
+  int64_t lookups = stats.dentryHits + stats.dentryNegativeHits +
+                    stats.dentryMisses;
+  fprintf(stderr, "ALL      dentry cache hits                %lld\n"
+          "ALL      dentry cache misses              %lld\n"
+          "ALL      dentry cache hit ratio           %.02f %%\n"
+          "ALL      dentry cache invalidations       %lld\n"
+          "# -------------------------------------------------------------\n",
+          static_cast<long long>(stats.dentryHits),
+          static_cast<long long>(stats.dentryMisses),
+          lookups ? 100.0 * (stats.dentryHits + stats.dentryNegativeHits) /
+          lookups : 0.0, static_cast<long long>(stats.dentryInvalidations));
+}
+
+//------------------------------------------------------------------------------
+// Build a serialized file metadata object typical for a replica layout
+//------------------------------------------------------------------------------
+static eos::Buffer
+SerializedFileMD(eos::IFileMDSvc* fileSvc)
+{
+  eos::ns::FileMdProto proto;
+  struct timespec ts {1546300800, 123456789};
+  proto.set_id(123456789);
+  proto.set_cont_id(4242);
+  proto.set_uid(10234);
+  proto.set_gid(1028);
+  proto.set_size(1048576);
+  proto.set_layout_id(0x00100112);
+  proto.set_name("file____________________00000042");
+  proto.set_ctime(&ts, sizeof(ts));
+  proto.set_mtime(&ts, sizeof(ts));
+  proto.set_checksum("\x1a\x2b\x3c\x4d", 4);
+  proto.add_locations(17);
+  proto.add_locations(42);
+  (*proto.mutable_xattrs())["sys.eos.btime"] = "1546300800.123456789";
+  (*proto.mutable_xattrs())["sys.fs.tracking"] = "+17+42";
+  (*proto.mutable_xattrs())["sys.utrace"] = "cb1e7c4e-0c8b-11e9-ab14-d663bd873d93";
+  eos::QuarkFileMD fmd(0, fileSvc);
+  fmd.initialize(proto);
+  eos::Buffer buffer;
+  fmd.serialize(buffer);
+  return buffer;
+}
+
+//------------------------------------------------------------------------------
+// Measure the parse rate and per-entry memory footprint of cached file
+// metadata: the protobuf representation against the compact QuarkFileMD one
+//------------------------------------------------------------------------------
+static void
+RunDeserializationBenchmark(eos::IFileMDSvc* fileSvc, size_t n_entries)
+{
+  eos::Buffer buffer = SerializedFileMD(fileSvc);
+  eos::common::LinuxMemConsumption::linux_mem_t mem[2];
+  // Protobuf objects, one heap allocated message per entry
+  std::vector<std::unique_ptr<eos::ns::FileMdProto>> protos;
+  protos.reserve(n_entries);
+  eos::common::LinuxMemConsumption::GetMemoryFootprint(mem[0]);
+  eos::common::Timing tm_proto("proto");
+  COMMONTIMING("proto-start", &tm_proto);
+
+  for (size_t n = 0; n < n_entries; ++n) {
+    protos.emplace_back(new eos::ns::FileMdProto());
+    eos::Serialization::deserializeFile(buffer, *protos.back());
+  }
+
+  COMMONTIMING("proto-stop", &tm_proto);
+  eos::common::LinuxMemConsumption::GetMemoryFootprint(mem[1]);
+  double proto_rate = n_entries / tm_proto.RealTime() * 1000.0;
+  double proto_bytes = (1.0 * mem[1].resident - mem[0].resident) / n_entries;
+  protos.clear();
+  protos.shrink_to_fit();
+  // Compact objects, parsed on a stack arena
+  std::vector<std::unique_ptr<eos::QuarkFileMD>> files;
+  files.reserve(n_entries);
+  eos::common::LinuxMemConsumption::GetMemoryFootprint(mem[0]);
+  eos::common::Timing tm_compact("compact");
+  COMMONTIMING("compact-start", &tm_compact);
+
+  for (size_t n = 0; n < n_entries; ++n) {
+    files.emplace_back(new eos::QuarkFileMD(0, fileSvc));
+    files.back()->deserialize(buffer);
+  }
+
+  COMMONTIMING("compact-stop", &tm_compact);
+  eos::common::LinuxMemConsumption::GetMemoryFootprint(mem[1]);
+  double compact_rate = n_entries / tm_compact.RealTime() * 1000.0;
+  double compact_bytes = (1.0 * mem[1].resident - mem[0].resident) / n_entries;
+  fprintf(stderr, "ALL      serialized size                  %u B\n"
+          "ALL      protobuf parse rate              %.02f entries/s\n"
+          "ALL      protobuf footprint               %.02f B/entry\n"
+          "ALL      compact parse rate               %.02f entries/s\n"
+          "ALL      compact footprint                %.02f B/entry\n"
+          "# -------------------------------------------------------------\n",
+          static_cast<unsigned int>(buffer.getSize()), proto_rate, proto_bytes,
+          compact_rate, compact_bytes);
+}
+
 //------------------------------------------------------------------------------
 // Main function
 //----------------------------------------------------------------------------
@@ -423,5 +543,84 @@ main(int argc, char** argv)
     double rate = (n_files * n_i * n_j * n_k) / tm.RealTime() * 1000.0;
     PrintStatus(view, &st[0], &st[1], &mem[0], &mem[1], rate);
   }
+  // Run a parallel lookup benchmark on deep paths
+  try {
+    eos::common::LinuxStat::linux_stat_t st[10];
+    eos::common::LinuxMemConsumption::linux_mem_t mem[10];
+    std::cerr << "# ***********************************************************"
+              << std::endl;
+    std::cerr << "[i] Parallel deep path lookup benchmark ..." << std::endl;
+    std::cerr << "# ***********************************************************"
+              << std::endl;
+    const size_t depth = 32;
+    std::string deep_dir = "/eos/nsbench/deep";
+
+    for (size_t level = 0; level < depth; ++level) {
+      deep_dir += "/level_" + std::to_string(level);
+    }
+
+    view->createContainer(deep_dir, true);
+
+    for (size_t n = 0; n < n_files; n++) {
+      try {
+        view->createFile(DeepFilePath(deep_dir, n), 0, 0);
+      } catch (eos::MDException& e) {
+        // Already created by a previous run
+      }
+    }
+
+    eos::common::LinuxStat::GetStat(st[0]);
+    eos::common::LinuxMemConsumption::GetMemoryFootprint(mem[0]);
+    eos::common::Timing tm("deep");
+    COMMONTIMING("deep-start", &tm);
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < n_i; i++) {
+      threads.emplace_back([view, deep_dir, n_j, n_files]() {
+        try {
+          for (size_t j = 0; j < n_j; j++) {
+            for (size_t n = 0; n < n_files; n++) {
+              std::shared_ptr<eos::IFileMD> fmd =
+                view->getFile(DeepFilePath(deep_dir, n));
+              (void) fmd;
+            }
+          }
+        } catch (eos::MDException& e) {
+          std::cerr << "[!] Error: " << e.getMessage().str() << std::endl;
+        }
+      });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    eos::common::LinuxStat::GetStat(st[1]);
+    eos::common::LinuxMemConsumption::GetMemoryFootprint(mem[1]);
+    COMMONTIMING("deep-stop", &tm);
+    tm.Print();
+    double rate = (n_files * n_i * n_j) / tm.RealTime() * 1000.0;
+    fprintf(stderr, "# lookups of %u levels deep paths per second\n",
+            static_cast<unsigned int>(depth + 3));
+    PrintStatus(view, &st[0], &st[1], &mem[0], &mem[1], rate);
+    PrintPathCacheStatus(view);
+  } catch (eos::MDException& e) {
+    std::cerr << "[!] Error: " << e.getMessage().str() << std::endl;
+    return 2;
+  }
+  // Run the file metadata deserialization benchmark
+  try {
+    std::cerr << "# ***********************************************************"
+              << std::endl;
+    std::cerr << "[i] File metadata deserialization benchmark ..." << std::endl;
+    std::cerr << "# ***********************************************************"
+              << std::endl;
+    RunDeserializationBenchmark(view->getFileMDSvc(),
+                                n_files * n_i * n_j * n_k);
+  } catch (eos::MDException& e) {
+    std::cerr << "[!] Error: " << e.getMessage().str() << std::endl;
+    return 2;
+  }
+
   return 0;
 }
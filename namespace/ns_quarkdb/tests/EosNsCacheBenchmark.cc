@@ -0,0 +1,150 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Multithreaded benchmark comparing the namespace LRU cache with the
+//!        sharded CLOCK cache under a lookup dominated workload
+//------------------------------------------------------------------------------
+
+#include "namespace/ns_quarkdb/ClockCache.hh"
+#include "namespace/ns_quarkdb/LRU.hh"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Cached object, mimics the size of a small metadata entry
+//------------------------------------------------------------------------------
+struct Entry {
+  explicit Entry(std::uint64_t id) : mId(id) {}
+
+  std::uint64_t
+  getId() const
+  {
+    return mId;
+  }
+
+  std::uint64_t mId;
+  char mPayload[120];
+};
+
+//------------------------------------------------------------------------------
+// Run the workload with the given number of threads and return the
+// aggregated rate in millions of operations per second. Each thread does a
+// lookup for a skewed random id: 90% of the lookups hit a hot set of half
+// the cache capacity, the rest spread over twice the capacity. A miss is
+// followed by an insert, like the metadata provider does once the entry
+// arrives from QuarkDB. The cache is filled up before the measurement.
+//------------------------------------------------------------------------------
+template <typename CacheT>
+double
+RunWorkload(CacheT& cache, std::uint64_t capacity, unsigned int nthreads,
+            std::uint64_t ops_per_thread, std::uint64_t& misses)
+{
+  std::vector<std::thread> workers;
+  std::vector<std::uint64_t> thread_misses(nthreads, 0);
+
+  // Start from a warm cache so that the steady state is measured
+  for (std::uint64_t id = 0; id < capacity; ++id) {
+    cache.put(id, std::make_shared<Entry>(id));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned int t = 0; t < nthreads; ++t) {
+    workers.emplace_back([&, t]() {
+      std::mt19937_64 gen(t + 1);
+      std::uniform_int_distribution<std::uint64_t> hot(0, capacity / 2);
+      std::uniform_int_distribution<std::uint64_t> cold(0, 2 * capacity);
+      std::uniform_int_distribution<int> pick(0, 9);
+
+      for (std::uint64_t i = 0; i < ops_per_thread; ++i) {
+        std::uint64_t id = (pick(gen) ? hot(gen) : cold(gen));
+
+        if (!cache.get(id)) {
+          ++thread_misses[t];
+          cache.put(id, std::make_shared<Entry>(id));
+        }
+      }
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() -
+                                          start;
+  misses = 0;
+
+  for (auto m : thread_misses) {
+    misses += m;
+  }
+
+  return (1.0 * nthreads * ops_per_thread) / (elapsed.count() * 1e6);
+}
+
+//------------------------------------------------------------------------------
+// Usage: eosnscachebench [capacity] [ops_per_thread]
+//------------------------------------------------------------------------------
+int
+main(int argc, char** argv)
+{
+  std::uint64_t capacity = 1000000;
+  std::uint64_t ops_per_thread = 1000000;
+
+  if (argc > 1) {
+    capacity = strtoull(argv[1], 0, 10);
+  }
+
+  if (argc > 2) {
+    ops_per_thread = strtoull(argv[2], 0, 10);
+  }
+
+  if ((capacity == 0) || (ops_per_thread == 0)) {
+    fprintf(stderr, "Usage: eosnscachebench [capacity] [ops_per_thread]\n");
+    return 1;
+  }
+
+  fprintf(stdout, "%-8s %-14s %-10s %-14s %-10s\n", "threads", "lru[Mops/s]",
+          "lru-miss%", "clock[Mops/s]", "clock-miss%");
+
+  for (unsigned int nthreads = 1; nthreads <= 64; nthreads *= 2) {
+    std::uint64_t total_ops = nthreads * ops_per_thread;
+    std::uint64_t lru_misses = 0, clock_misses = 0;
+    double lru_rate, clock_rate;
+    {
+      eos::LRU<std::uint64_t, Entry> lru(capacity);
+      lru_rate = RunWorkload(lru, capacity, nthreads, ops_per_thread,
+                             lru_misses);
+    }
+    {
+      eos::ClockCache<std::uint64_t, Entry> clock(capacity);
+      clock_rate = RunWorkload(clock, capacity, nthreads, ops_per_thread,
+                               clock_misses);
+    }
+    fprintf(stdout, "%-8u %-14.02f %-10.02f %-14.02f %-10.02f\n", nthreads,
+            lru_rate, 100.0 * lru_misses / total_ops, clock_rate,
+            100.0 * clock_misses / total_ops);
+  }
+
+  return 0;
+}
@@ -0,0 +1,202 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @file EosNsExplorerBenchmark.cc
+//! @brief Measure the rate at which the NamespaceExplorer streams a synthetic
+//!        namespace out of QuarkDB, and the memory it takes to do so.
+//------------------------------------------------------------------------------
+
+#include "common/LinuxMemConsumption.hh"
+#include "common/StringConversion.hh"
+#include "common/Timing.hh"
+#include "namespace/ns_quarkdb/BackendClient.hh"
+#include "namespace/ns_quarkdb/QdbContactDetails.hh"
+#include "namespace/ns_quarkdb/explorer/NamespaceExplorer.hh"
+#include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
+#include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
+#include "namespace/ns_quarkdb/views/HierarchicalView.hh"
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+static const std::string sBenchRoot = "/eos/nsexplorerbench/";
+
+//------------------------------------------------------------------------------
+// File size mapping function
+//------------------------------------------------------------------------------
+static uint64_t
+mapSize(const eos::IFileMD* /*file*/)
+{
+  return 0u;
+}
+
+//------------------------------------------------------------------------------
+// Boot the namespace
+//------------------------------------------------------------------------------
+static eos::IView*
+bootNamespace(const std::map<std::string, std::string>& config)
+{
+  eos::IContainerMDSvc* contSvc = new eos::QuarkContainerMDSvc();
+  eos::IFileMDSvc* fileSvc = new eos::QuarkFileMDSvc();
+  eos::IView* view = new eos::QuarkHierarchicalView();
+  fileSvc->configure(config);
+  contSvc->configure(config);
+  fileSvc->setContMDService(contSvc);
+  contSvc->setFileMDService(fileSvc);
+  view->setContainerMDSvc(contSvc);
+  view->setFileMDSvc(fileSvc);
+  view->configure(config);
+  view->getQuotaStats()->registerSizeMapper(mapSize);
+  view->initialize();
+  return view;
+}
+
+//------------------------------------------------------------------------------
+// Close the namespace, flushing all pending updates to QuarkDB
+//------------------------------------------------------------------------------
+static void
+closeNamespace(eos::IView* view)
+{
+  eos::IContainerMDSvc* contSvc = view->getContainerMDSvc();
+  eos::IFileMDSvc* fileSvc = view->getFileMDSvc();
+  view->finalize();
+  delete view;
+  delete contSvc;
+  delete fileSvc;
+}
+
+//------------------------------------------------------------------------------
+// Populate the synthetic namespace: n_dirs directories of n_files files each
+//------------------------------------------------------------------------------
+static void
+populate(const std::map<std::string, std::string>& config, size_t n_dirs,
+         size_t n_files)
+{
+  eos::IView* view = bootNamespace(config);
+  eos::common::Timing tm("populate");
+  COMMONTIMING("start", &tm);
+
+  for (size_t i = 0; i < n_dirs; i++) {
+    char s_dir[64];
+    snprintf(static_cast<char*>(s_dir), sizeof(s_dir) - 1, "dir_%08u/",
+             static_cast<unsigned int>(i));
+    std::string dir_path = sBenchRoot + static_cast<char*>(s_dir);
+    view->createContainer(dir_path, true);
+
+    for (size_t n = 0; n < n_files; n++) {
+      char s_file[64];
+      snprintf(static_cast<char*>(s_file), sizeof(s_file) - 1, "file_%08u",
+               static_cast<unsigned int>(n));
+      std::shared_ptr<eos::IFileMD> fmd =
+        view->createFile(dir_path + static_cast<char*>(s_file), 0, 0);
+      fmd->addLocation(1 + (n % 16));
+      fmd->setSize(n);
+      view->updateFileStore(fmd.get());
+    }
+
+    if ((i % 100) == 0) {
+      fprintf(stderr, "# populated %u/%u directories\n",
+              static_cast<unsigned int>(i), static_cast<unsigned int>(n_dirs));
+    }
+  }
+
+  COMMONTIMING("stop", &tm);
+  closeNamespace(view);
+  fprintf(stderr, "ALL      populate rate                    %.02f entries/s\n",
+          (n_dirs * (n_files + 1)) / tm.RealTime() * 1000.0);
+}
+
+//------------------------------------------------------------------------------
+// Main function
+//------------------------------------------------------------------------------
+int
+main(int argc, char** argv)
+{
+  if (argc < 3 || argc > 6) {
+    std::cerr << "Usage:" << std::endl;
+    std::cerr << "  eosnsexplorerbench <qdb_host> <qdb_port> [<dirs> "
+              << "<files-per-dir> [<populate 0|1>]]" << std::endl;
+    std::cerr << "  default: 10000 dirs of 1000 files i.e. 10M entries"
+              << std::endl;
+    return 1;
+  }
+
+  std::map<std::string, std::string> config = {{"qdb_host", argv[1]},
+    {"qdb_port", argv[2]}
+  };
+  size_t n_dirs = (argc > 3) ? std::stoul(argv[3]) : 10000;
+  size_t n_files = (argc > 4) ? std::stoul(argv[4]) : 1000;
+  bool do_populate = (argc > 5) ? (std::stoi(argv[5]) != 0) : true;
+
+  try {
+    if (do_populate) {
+      std::cerr << "[i] Populating " << n_dirs * (n_files + 1)
+                << " entries ..." << std::endl;
+      populate(config, n_dirs, n_files);
+    }
+
+    std::cerr << "[i] Exploring " << sBenchRoot << " ..." << std::endl;
+    qclient::QClient* qcl = eos::BackendClient::getInstance(
+                              eos::QdbContactDetails(qclient::Members(argv[1],
+                                  std::stoi(argv[2])), ""), "explorerbench");
+    eos::common::LinuxMemConsumption::linux_mem_t mem[2];
+    eos::common::LinuxMemConsumption::GetMemoryFootprint(mem[0]);
+    eos::common::Timing tm("explore");
+    COMMONTIMING("start", &tm);
+    eos::ExplorationOptions options;
+    eos::NamespaceExplorer explorer(sBenchRoot, options, *qcl);
+    eos::NamespaceItem item;
+    unsigned long long nfiles = 0;
+    unsigned long long ndirs = 0;
+    unsigned long long peak_resident = mem[0].resident;
+
+    while (explorer.fetch(item)) {
+      if (item.isFile) {
+        nfiles++;
+      } else {
+        ndirs++;
+      }
+
+      if (((nfiles + ndirs) % 1000000) == 0) {
+        eos::common::LinuxMemConsumption::GetMemoryFootprint(mem[1]);
+        peak_resident = std::max(peak_resident, mem[1].resident);
+        fprintf(stderr, "# explored %llu entries\n", nfiles + ndirs);
+      }
+    }
+
+    COMMONTIMING("stop", &tm);
+    eos::common::LinuxMemConsumption::GetMemoryFootprint(mem[1]);
+    peak_resident = std::max(peak_resident, mem[1].resident);
+    XrdOucString sizestring;
+    fprintf(stderr, "# -------------------------------------------------------------\n");
+    fprintf(stderr, "ALL      Files                            %llu\n", nfiles);
+    fprintf(stderr, "ALL      Directories                      %llu\n", ndirs);
+    fprintf(stderr, "ALL      explore rate                     %.02f entries/s\n",
+            (nfiles + ndirs) / tm.RealTime() * 1000.0);
+    fprintf(stderr, "ALL      memory resident growth           %s\n",
+            eos::common::StringConversion::GetReadableSizeString(sizestring,
+                peak_resident - mem[0].resident, "B"));
+    fprintf(stderr, "# -------------------------------------------------------------\n");
+  } catch (eos::MDException& e) {
+    std::cerr << "[!] Error: " << e.getMessage().str() << std::endl;
+    return 2;
+  }
+
+  return 0;
+}
@@ -0,0 +1,234 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @file EosNsLockingBenchmark.cc
+//! @brief Compare the rate of concurrent create/stat/rename mixes running in
+//!        disjoint subtrees when mutations take the global namespace lock for
+//!        writing against the one with per-container and per-file locks.
+//------------------------------------------------------------------------------
+
+#include "common/RWMutex.hh"
+#include "common/Timing.hh"
+#include "namespace/MDLocking.hh"
+#include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
+#include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
+#include "namespace/ns_quarkdb/views/HierarchicalView.hh"
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const std::string sBenchRoot = "/eos/nslockbench/";
+
+//------------------------------------------------------------------------------
+// File size mapping function
+//------------------------------------------------------------------------------
+static uint64_t
+mapSize(const eos::IFileMD* /*file*/)
+{
+  return 0u;
+}
+
+//------------------------------------------------------------------------------
+// Boot the namespace
+//------------------------------------------------------------------------------
+static eos::IView*
+bootNamespace(const std::map<std::string, std::string>& config)
+{
+  eos::IContainerMDSvc* contSvc = new eos::QuarkContainerMDSvc();
+  eos::IFileMDSvc* fileSvc = new eos::QuarkFileMDSvc();
+  eos::IView* view = new eos::QuarkHierarchicalView();
+  fileSvc->configure(config);
+  contSvc->configure(config);
+  fileSvc->setContMDService(contSvc);
+  contSvc->setFileMDService(fileSvc);
+  view->setContainerMDSvc(contSvc);
+  view->setFileMDSvc(fileSvc);
+  view->configure(config);
+  view->getQuotaStats()->registerSizeMapper(mapSize);
+  view->initialize();
+  return view;
+}
+
+//------------------------------------------------------------------------------
+// Close the namespace, flushing all pending updates to QuarkDB
+//------------------------------------------------------------------------------
+static void
+closeNamespace(eos::IView* view)
+{
+  eos::IContainerMDSvc* contSvc = view->getContainerMDSvc();
+  eos::IFileMDSvc* fileSvc = view->getFileMDSvc();
+  view->finalize();
+  delete view;
+  delete contSvc;
+  delete fileSvc;
+}
+
+//------------------------------------------------------------------------------
+// Get the path of the subtree of a thread in a run
+//------------------------------------------------------------------------------
+static std::string
+subtreePath(const std::string& run, size_t thread)
+{
+  char s_dir[64];
+  snprintf(static_cast<char*>(s_dir), sizeof(s_dir) - 1, "t_%04u/",
+           static_cast<unsigned int>(thread));
+  return sBenchRoot + run + "/" + static_cast<char*>(s_dir);
+}
+
+//------------------------------------------------------------------------------
+// Get the name of a benchmark file
+//------------------------------------------------------------------------------
+static std::string
+fileName(const char* prefix, size_t n)
+{
+  char s_file[64];
+  snprintf(static_cast<char*>(s_file), sizeof(s_file) - 1, "%s_%08u", prefix,
+           static_cast<unsigned int>(n));
+  return static_cast<char*>(s_file);
+}
+
+//------------------------------------------------------------------------------
+// Run the operation mix of one thread in its own subtree: every iteration
+// creates a file, stats it and renames it. Mutations either take the global
+// lock for writing or the global lock for reading plus entry locks.
+//------------------------------------------------------------------------------
+static void
+runMix(eos::IView* view, eos::common::RWMutex& ns_mutex,
+       eos::MDLockTable& md_locks, bool fine_grained, const std::string& dir,
+       size_t n_ops)
+{
+  for (size_t n = 0; n < n_ops; n++) {
+    std::string name = fileName("file", n);
+    std::string new_name = fileName("renamed", n);
+
+    // create
+    if (fine_grained) {
+      eos::common::RWMutexReadLock lock(ns_mutex);
+      eos::MDLocker md_lock(md_locks);
+      std::vector<eos::MDLockTarget> targets {{dir}};
+      eos::lockForUpdate(view, targets, md_lock);
+      view->createFile(dir + name, 0, 0);
+    } else {
+      eos::common::RWMutexWriteLock lock(ns_mutex);
+      view->createFile(dir + name, 0, 0);
+    }
+
+    // stat
+    {
+      eos::common::RWMutexReadLock lock(ns_mutex);
+      (void) view->getFile(dir + name)->getSize();
+    }
+
+    // rename
+    if (fine_grained) {
+      eos::common::RWMutexReadLock lock(ns_mutex);
+      eos::MDLocker md_lock(md_locks);
+      std::vector<eos::MDLockTarget> targets {{dir, name}};
+      eos::lockForUpdate(view, targets, md_lock);
+      view->renameFile(targets[0].mFile.get(), new_name);
+    } else {
+      eos::common::RWMutexWriteLock lock(ns_mutex);
+      view->renameFile(view->getFile(dir + name).get(), new_name);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Run the mix on n_threads threads, returns the rate in operations per second
+//------------------------------------------------------------------------------
+static double
+runThreads(eos::IView* view, eos::MDLockTable& md_locks, bool fine_grained,
+           size_t n_threads, size_t n_ops)
+{
+  static std::atomic<size_t> sRun(0);
+  std::string run = std::string(fine_grained ? "fine" : "global") + "_" +
+                    std::to_string(n_threads) + "_" + std::to_string(sRun++);
+  eos::common::RWMutex ns_mutex;
+
+  for (size_t t = 0; t < n_threads; t++) {
+    view->createContainer(subtreePath(run, t), true);
+  }
+
+  std::vector<std::thread> threads;
+  eos::common::Timing tm("mix");
+  COMMONTIMING("start", &tm);
+
+  for (size_t t = 0; t < n_threads; t++) {
+    threads.emplace_back(runMix, view, std::ref(ns_mutex), std::ref(md_locks),
+                         fine_grained, subtreePath(run, t), n_ops);
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  COMMONTIMING("stop", &tm);
+  // three operations per iteration
+  return (3.0 * n_threads * n_ops) / tm.RealTime() * 1000.0;
+}
+
+//------------------------------------------------------------------------------
+// Main function
+//------------------------------------------------------------------------------
+int
+main(int argc, char** argv)
+{
+  if (argc < 3 || argc > 5) {
+    std::cerr << "Usage:" << std::endl;
+    std::cerr << "  eosnslockbench <qdb_host> <qdb_port> [<iterations-per-thread> "
+              << "[<max-threads>]]" << std::endl;
+    std::cerr << "  default: 1000 create/stat/rename iterations, 1 to 64 threads"
+              << std::endl;
+    return 1;
+  }
+
+  std::map<std::string, std::string> config = {{"qdb_host", argv[1]},
+    {"qdb_port", argv[2]}
+  };
+  size_t n_ops = (argc > 3) ? std::stoul(argv[3]) : 1000;
+  size_t max_threads = (argc > 4) ? std::stoul(argv[4]) : 64;
+
+  try {
+    eos::IView* view = bootNamespace(config);
+    eos::MDLockTable md_locks;
+    fprintf(stderr, "# -------------------------------------------------------------\n");
+    fprintf(stderr, "# threads  global write lock   entry locks    speed-up\n");
+
+    for (size_t n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+      double global_rate = runThreads(view, md_locks, false, n_threads, n_ops);
+      double fine_rate = runThreads(view, md_locks, true, n_threads, n_ops);
+      fprintf(stderr, "%9lu  %12.02f op/s  %12.02f op/s  %8.02fx\n",
+              (unsigned long) n_threads, global_rate, fine_rate,
+              fine_rate / global_rate);
+    }
+
+    fprintf(stderr, "# -------------------------------------------------------------\n");
+    fprintf(stderr, "ALL      contended entry lock acquisitions %llu\n",
+            (unsigned long long) md_locks.getContended());
+    fprintf(stderr, "# -------------------------------------------------------------\n");
+    closeNamespace(view);
+  } catch (eos::MDException& e) {
+    std::cerr << "[!] Error: " << e.getMessage().str() << std::endl;
+    return 2;
+  }
+
+  return 0;
+}
@@ -0,0 +1,218 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @file EosNsWarmupBenchmark.cc
+//! @brief Compare the file access rate of a freshly booted namespace with cold
+//!        caches against the one after a MetadataWarmup of the same tree.
+//------------------------------------------------------------------------------
+
+#include "common/Timing.hh"
+#include "namespace/MetadataWarmup.hh"
+#include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
+#include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
+#include "namespace/ns_quarkdb/views/HierarchicalView.hh"
+#include <iostream>
+#include <string>
+
+static const std::string sBenchRoot = "/eos/nswarmupbench/";
+
+//------------------------------------------------------------------------------
+// File size mapping function
+//------------------------------------------------------------------------------
+static uint64_t
+mapSize(const eos::IFileMD* /*file*/)
+{
+  return 0u;
+}
+
+//------------------------------------------------------------------------------
+// Boot the namespace
+//------------------------------------------------------------------------------
+static eos::IView*
+bootNamespace(const std::map<std::string, std::string>& config)
+{
+  eos::IContainerMDSvc* contSvc = new eos::QuarkContainerMDSvc();
+  eos::IFileMDSvc* fileSvc = new eos::QuarkFileMDSvc();
+  eos::IView* view = new eos::QuarkHierarchicalView();
+  fileSvc->configure(config);
+  contSvc->configure(config);
+  fileSvc->setContMDService(contSvc);
+  contSvc->setFileMDService(fileSvc);
+  view->setContainerMDSvc(contSvc);
+  view->setFileMDSvc(fileSvc);
+  view->configure(config);
+  view->getQuotaStats()->registerSizeMapper(mapSize);
+  view->initialize();
+  return view;
+}
+
+//------------------------------------------------------------------------------
+// Close the namespace, flushing all pending updates to QuarkDB
+//------------------------------------------------------------------------------
+static void
+closeNamespace(eos::IView* view)
+{
+  eos::IContainerMDSvc* contSvc = view->getContainerMDSvc();
+  eos::IFileMDSvc* fileSvc = view->getFileMDSvc();
+  view->finalize();
+  delete view;
+  delete contSvc;
+  delete fileSvc;
+}
+
+//------------------------------------------------------------------------------
+// Get the path of a benchmark directory
+//------------------------------------------------------------------------------
+static std::string
+dirPath(size_t i)
+{
+  char s_dir[64];
+  snprintf(static_cast<char*>(s_dir), sizeof(s_dir) - 1, "dir_%08u/",
+           static_cast<unsigned int>(i));
+  return sBenchRoot + static_cast<char*>(s_dir);
+}
+
+//------------------------------------------------------------------------------
+// Get the name of a benchmark file
+//------------------------------------------------------------------------------
+static std::string
+fileName(size_t n)
+{
+  char s_file[64];
+  snprintf(static_cast<char*>(s_file), sizeof(s_file) - 1, "file_%08u",
+           static_cast<unsigned int>(n));
+  return static_cast<char*>(s_file);
+}
+
+//------------------------------------------------------------------------------
+// Populate the synthetic namespace: n_dirs directories of n_files files each
+//------------------------------------------------------------------------------
+static void
+populate(const std::map<std::string, std::string>& config, size_t n_dirs,
+         size_t n_files)
+{
+  eos::IView* view = bootNamespace(config);
+
+  for (size_t i = 0; i < n_dirs; i++) {
+    std::string dir_path = dirPath(i);
+    view->createContainer(dir_path, true);
+
+    for (size_t n = 0; n < n_files; n++) {
+      std::shared_ptr<eos::IFileMD> fmd =
+        view->createFile(dir_path + fileName(n), 0, 0);
+      fmd->setSize(n);
+      view->updateFileStore(fmd.get());
+    }
+  }
+
+  closeNamespace(view);
+}
+
+//------------------------------------------------------------------------------
+// Access every file by path, one at a time like a single client would.
+// Returns the access rate in files per second.
+//------------------------------------------------------------------------------
+static double
+accessFiles(eos::IView* view, size_t n_dirs, size_t n_files)
+{
+  eos::common::Timing tm("access");
+  COMMONTIMING("start", &tm);
+
+  for (size_t i = 0; i < n_dirs; i++) {
+    std::string dir_path = dirPath(i);
+
+    for (size_t n = 0; n < n_files; n++) {
+      view->getFile(dir_path + fileName(n));
+    }
+  }
+
+  COMMONTIMING("stop", &tm);
+  return (n_dirs * n_files) / tm.RealTime() * 1000.0;
+}
+
+//------------------------------------------------------------------------------
+// Main function
+//------------------------------------------------------------------------------
+int
+main(int argc, char** argv)
+{
+  if (argc < 3 || argc > 7) {
+    std::cerr << "Usage:" << std::endl;
+    std::cerr << "  eosnswarmupbench <qdb_host> <qdb_port> [<dirs> "
+              << "<files-per-dir> [<in-flight> [<populate 0|1>]]]" << std::endl;
+    std::cerr << "  default: 1000 dirs of 1000 files, 4096 lookups in flight"
+              << std::endl;
+    return 1;
+  }
+
+  std::map<std::string, std::string> config = {{"qdb_host", argv[1]},
+    {"qdb_port", argv[2]}
+  };
+  size_t n_dirs = (argc > 3) ? std::stoul(argv[3]) : 1000;
+  size_t n_files = (argc > 4) ? std::stoul(argv[4]) : 1000;
+  size_t in_flight = (argc > 5) ? std::stoul(argv[5]) : 4096;
+  bool do_populate = (argc > 6) ? (std::stoi(argv[6]) != 0) : true;
+
+  try {
+    if (do_populate) {
+      std::cerr << "[i] Populating " << n_dirs * (n_files + 1)
+                << " entries ..." << std::endl;
+      populate(config, n_dirs, n_files);
+    }
+
+    // Cold caches: every access goes to QuarkDB
+    eos::IView* view = bootNamespace(config);
+    double cold_rate = accessFiles(view, n_dirs, n_files);
+    closeNamespace(view);
+    // Warmed-up caches
+    view = bootNamespace(config);
+    eos::MetadataWarmup warmup(view, in_flight, 2 * n_dirs * (n_files + 1));
+
+    for (size_t i = 0; i < n_dirs; i++) {
+      warmup.addPath(dirPath(i));
+    }
+
+    eos::WarmupStats stats = warmup.run(std::chrono::seconds(0),
+    [](const eos::WarmupStats & progress) {
+      fprintf(stderr, "# warm-up loaded %llu entries, %.02f entries/s\n",
+              (unsigned long long) progress.loaded, progress.rate());
+    }, std::chrono::seconds(1));
+    double warm_rate = accessFiles(view, n_dirs, n_files);
+    closeNamespace(view);
+    fprintf(stderr, "# -------------------------------------------------------------\n");
+    fprintf(stderr, "ALL      cold access rate                 %.02f files/s\n",
+            cold_rate);
+    fprintf(stderr, "ALL      warm-up loaded                   %llu entries\n",
+            (unsigned long long) stats.loaded);
+    fprintf(stderr, "ALL      warm-up failed                   %llu entries\n",
+            (unsigned long long) stats.failed);
+    fprintf(stderr, "ALL      warm-up duration                 %.02f s\n",
+            stats.elapsed);
+    fprintf(stderr, "ALL      warm-up rate                     %.02f entries/s\n",
+            stats.rate());
+    fprintf(stderr, "ALL      warm access rate                 %.02f files/s\n",
+            warm_rate);
+    fprintf(stderr, "# -------------------------------------------------------------\n");
+  } catch (eos::MDException& e) {
+    std::cerr << "[!] Error: " << e.getMessage().str() << std::endl;
+    return 2;
+  }
+
+  return 0;
+}
@@ -576,6 +576,43 @@ TEST_F(HierarchicalViewF, AddContainerWithConflicts)
   cont1->addContainer(cont4.get()); // conflicts with itself, thus, no conflict
 }
 
+TEST_F(HierarchicalViewF, PathLookupCacheInvalidation)
+{
+  eos::IContainerMDPtr cont1 = view()->createContainer("/eos/a/b", true);
+  eos::IContainerMDPtr cont2 = view()->createContainer("/eos/a/b/c", true);
+  eos::IFileMDPtr file1 = view()->createFile("/eos/a/b/c/file1");
+  // Populate the caches, including a negative entry
+  ASSERT_EQ(file1->getId(), view()->getFile("/eos/a/b/c/file1")->getId());
+  ASSERT_EQ("/eos/a/b/c/", view()->getUri(cont2.get()));
+  ASSERT_THROW(view()->getFile("/eos/a/b/c/file2"), eos::MDException);
+  ASSERT_EQ(file1->getId(), view()->getFile("/eos/a/b/c/file1")->getId());
+  eos::PathCacheStatistics stats = view()->getPathCacheStatistics();
+  ASSERT_TRUE(stats.enabled);
+  ASSERT_GT(stats.dentryHits, 0);
+  ASSERT_GT(stats.dentryNegativeHits + stats.dentryMisses, 0);
+  // The negative entry is dropped when the file is created
+  eos::IFileMDPtr file2 = view()->createFile("/eos/a/b/c/file2");
+  ASSERT_EQ(file2->getId(), view()->getFile("/eos/a/b/c/file2")->getId());
+  // Renaming a subtree updates dentries and uris
+  view()->renameContainer(cont1.get(), "d");
+  ASSERT_THROW(view()->getFile("/eos/a/b/c/file1"), eos::MDException);
+  ASSERT_EQ(file1->getId(), view()->getFile("/eos/a/d/c/file1")->getId());
+  ASSERT_EQ("/eos/a/d/c/", view()->getUri(cont2.get()));
+  // Renaming a leaf container and a file
+  view()->renameContainer(cont2.get(), "e");
+  ASSERT_EQ("/eos/a/d/e/", view()->getUri(cont2.get()));
+  view()->renameFile(file1.get(), "file3");
+  ASSERT_THROW(view()->getFile("/eos/a/d/e/file1"), eos::MDException);
+  ASSERT_EQ(file1->getId(), view()->getFile("/eos/a/d/e/file3")->getId());
+  // Unlink and remove
+  view()->unlinkFile("/eos/a/d/e/file3");
+  ASSERT_THROW(view()->getFile("/eos/a/d/e/file3"), eos::MDException);
+  view()->unlinkFile("/eos/a/d/e/file2");
+  view()->removeContainer("/eos/a/d/e");
+  ASSERT_THROW(view()->getContainer("/eos/a/d/e"), eos::MDException);
+  ASSERT_GT(view()->getPathCacheStatistics().dentryInvalidations, 0);
+}
+
 TEST_F(HierarchicalViewF, QuotaRecomputation)
 {
   eos::IContainerMDPtr quota1 = view()->createContainer("/quota1", true);
@@ -60,6 +60,11 @@ TEST(NsQuarkdb, FileMd)
   file.setLayoutId(lid);
   std::string file_cksum = "abcdefgh";
   file.setChecksum(file_cksum.data(), file_cksum.size());
+  file.setAttribute("sys.eos.btime", "1546300800.123456789");
+  file.setAttribute("user.tag", "a value longer than the inline string capacity");
+  file.setAttribute("user.tag", "overwritten");
+  file.setAttribute("user.removed", "value");
+  file.removeAttribute("user.removed");
   std::vector<eos::IFileMD::location_t> locations = {2, 23, 3736, 3871, 21, 47, 55, 76};
 
   for (auto && elem : locations) {
@@ -83,6 +88,15 @@ TEST(NsQuarkdb, FileMd)
   file.getEnv(orig_rep);
   rfile.getEnv(new_rep);
   ASSERT_EQ(orig_rep, new_rep);
+  ASSERT_EQ(file.getAttributes(), rfile.getAttributes());
+  ASSERT_EQ(2u, rfile.numAttributes());
+  ASSERT_EQ("overwritten", rfile.getAttribute("user.tag"));
+  ASSERT_FALSE(rfile.hasAttribute("user.removed"));
+  ASSERT_EQ(file.getUnlinkedLocations(), rfile.getUnlinkedLocations());
+  // A truncated object must be rejected, not read past its end
+  eos::Buffer truncated;
+  truncated.putData(buffer.getDataPtr(), 6);
+  ASSERT_THROW(rfile.deserialize(truncated), eos::MDException);
   // Force a checksum corruption and check if it's detected
   uint32_t cksum = 0;
   (void) memcpy(&cksum, buffer.getDataPtr(), sizeof(cksum));
@@ -21,10 +21,16 @@
 // desc:   Other tests
 //------------------------------------------------------------------------------
 
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <vector>
+#include "namespace/MDLocking.hh"
 #include "namespace/ns_quarkdb/ConfigurationParser.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
 #include "namespace/ns_quarkdb/LRU.hh"
+#include "namespace/ns_quarkdb/ClockCache.hh"
+#include "namespace/ns_quarkdb/views/PathLookupCache.hh"
 #include "namespace/utils/PathProcessor.hh"
 #include "namespace/utils/TestHelpers.hh"
 #include <gtest/gtest.h>
@@ -128,6 +134,147 @@ TEST(LRU, BasicSanity)
   ASSERT_TRUE(!cache.get(100));
 }
 
+TEST(ClockCache, BasicSanity)
+{
+  struct Entry {
+    explicit Entry(std::uint64_t id) : id_(id) {}
+
+    ~Entry() = default;
+
+    std::uint64_t
+    getId() const
+    {
+      return id_;
+    }
+
+    std::uint64_t id_;
+  };
+  std::uint64_t max_size = 2000;
+  std::uint64_t num_entries = 1000;
+  std::uint64_t shard_max = max_size / 4;
+  eos::ClockCache<std::uint64_t, Entry> cache{max_size, 4};
+
+  // Fill half of the cache, no shard reaches its capacity so the background
+  // evictor has nothing to do
+  for (std::uint64_t id = 0; id < num_entries; ++id) {
+    ASSERT_TRUE(cache.put(id, std::make_shared<Entry>(id)));
+  }
+
+  for (const auto& st : cache.get_shard_stats()) {
+    ASSERT_LT(st.size, shard_max);
+  }
+
+  ASSERT_EQ(num_entries, cache.size());
+
+  for (std::uint64_t id = 0; id < num_entries; ++id) {
+    std::shared_ptr<Entry> obj = cache.get(id);
+    ASSERT_TRUE(obj);
+    ASSERT_EQ(id, obj->getId());
+  }
+
+  ASSERT_TRUE(!cache.get(max_size));
+  // Go over capacity, the shards get evicted by the background thread or by
+  // the eviction pass below, so only bounds hold from now on
+  std::uint64_t num_puts = num_entries + max_size;
+
+  for (auto extra_id = num_entries; extra_id < num_puts; ++extra_id) {
+    ASSERT_TRUE(cache.put(extra_id, std::make_shared<Entry>(extra_id)));
+  }
+
+  cache.evict();
+  ASSERT_LE(cache.size(), max_size);
+
+  for (const auto& st : cache.get_shard_stats()) {
+    ASSERT_LT(st.size, shard_max);
+  }
+
+  // Nothing is evicted anymore once every shard is below its capacity
+  eos::ClockCacheShardStats stats = cache.get_stats();
+  ASSERT_EQ(num_entries, stats.hits);
+  ASSERT_EQ(1u, stats.misses);
+  ASSERT_EQ(num_puts, stats.evictions + stats.size);
+  ASSERT_EQ(4u, cache.get_shard_stats().size());
+  // Flush the cache while holding a reference to one of the objects
+  std::shared_ptr<Entry> elem = cache.put(3 * max_size,
+                                          std::make_shared<Entry>(3 * max_size));
+  cache.set_max_num(UINT64_MAX);
+  ASSERT_EQ(1u, cache.size());
+  ASSERT_TRUE(cache.peek(3 * max_size));
+  elem.reset();
+  // Disable the cache
+  cache.set_max_num(0);
+  ASSERT_EQ(0u, cache.size());
+  ASSERT_EQ(0u, cache.get_max_num());
+  ASSERT_TRUE(cache.put(1, std::make_shared<Entry>(1)));
+  ASSERT_TRUE(!cache.get(1));
+}
+
+TEST(PathLookupCache, BasicSanity)
+{
+  eos::PathLookupCache cache(100, 100, 4);
+  eos::PathLookupCache::Dentry dentry;
+  // Positive and negative entries
+  uint64_t epoch = cache.getDentryEpoch(1, "eos");
+  dentry.mId = 2;
+  dentry.mIsContainer = true;
+  cache.putDentry(1, "eos", dentry, epoch);
+  epoch = cache.getDentryEpoch(2, "missing");
+  cache.putDentry(2, "missing", eos::PathLookupCache::Dentry(), epoch);
+  ASSERT_TRUE(cache.getDentry(1, "eos", dentry));
+  ASSERT_EQ(2u, dentry.mId);
+  ASSERT_TRUE(dentry.mIsContainer);
+  ASSERT_TRUE(cache.getDentry(2, "missing", dentry));
+  ASSERT_EQ(0u, dentry.mId);
+  ASSERT_FALSE(cache.getDentry(2, "eos", dentry));
+  // A fill started before an invalidation is dropped
+  epoch = cache.getDentryEpoch(2, "file");
+  cache.invalidateDentry(2, "file");
+  dentry.mId = 10;
+  dentry.mIsContainer = false;
+  cache.putDentry(2, "file", dentry, epoch);
+  ASSERT_FALSE(cache.getDentry(2, "file", dentry));
+  cache.invalidateDentry(2, "missing");
+  ASSERT_FALSE(cache.getDentry(2, "missing", dentry));
+  // Paths
+  std::string path;
+  epoch = cache.getPathEpoch();
+  cache.putPath(2, "/eos/", epoch);
+  cache.putPath(3, "/eos/dir/", epoch);
+  ASSERT_TRUE(cache.getPath(3, path));
+  ASSERT_EQ("/eos/dir/", path);
+  cache.invalidatePath(3);
+  ASSERT_FALSE(cache.getPath(3, path));
+  cache.putPath(3, "/eos/dir/", epoch);
+  ASSERT_FALSE(cache.getPath(3, path));
+  ASSERT_TRUE(cache.getPath(2, path));
+  cache.invalidateAllPaths();
+  ASSERT_FALSE(cache.getPath(2, path));
+  // Bounded size
+  epoch = cache.getPathEpoch();
+
+  for (uint64_t id = 100; id < 1100; ++id) {
+    cache.putPath(id, "/eos/" + std::to_string(id) + "/", epoch);
+  }
+
+  eos::PathCacheStatistics stats = cache.getStatistics();
+  ASSERT_TRUE(stats.enabled);
+  ASSERT_EQ(100, stats.pathMaxNum);
+  ASSERT_EQ(100, stats.pathOccupancy);
+  ASSERT_EQ(900, stats.pathEvictions);
+  ASSERT_TRUE(cache.getPath(1099, path));
+  ASSERT_EQ(1, stats.dentryOccupancy);
+  ASSERT_EQ(1, stats.dentryHits);
+  ASSERT_EQ(1, stats.dentryNegativeHits);
+  ASSERT_EQ(3, stats.dentryMisses);
+  ASSERT_EQ(1, stats.dentryInvalidations);
+  ASSERT_EQ(2, stats.pathInvalidations);
+  // Disabled cache
+  eos::PathLookupCache disabled(0, 0);
+  disabled.putPath(2, "/eos/", disabled.getPathEpoch());
+  ASSERT_FALSE(disabled.getPath(2, path));
+  ASSERT_FALSE(disabled.getStatistics().enabled);
+}
+
 TEST(PathProcessor, AbsPathTest)
 {
   std::string path = "/a/b/c/d/";
@@ -168,3 +315,82 @@ TEST(QdbContactDetails, BasicSanity)
   ASSERT_EQ(cd.members.toString(), "example1.cern.ch:1234,example2.cern.ch:2345,example3.cern.ch:3456");
   ASSERT_EQ(cd.password, "turtles_turtles_etc");
 }
+
+TEST(MDLocker, BasicSanity)
+{
+  eos::MDLockTable table(1000);
+  ASSERT_EQ(table.getNumStripes(), 1024u);
+  eos::MDLocker locker(table);
+  // The same entry added twice is locked once
+  locker.addContainer(1).addContainer(2).addContainer(1).addFile(1).addFile(5);
+  ASSERT_FALSE(locker.isLocked());
+  locker.lock();
+  ASSERT_TRUE(locker.isLocked());
+  // A second locker on the same thread would deadlock
+  eos::MDLocker other(table);
+  other.addContainer(3);
+  ASSERT_THROW(other.lock(), eos::MDException);
+  // Entries are held until unlocked
+  std::thread([&table]() {
+    eos::MDLocker locker2(table);
+    locker2.addFile(7);
+    locker2.lock();
+  }).join();
+  std::atomic<bool> acquired(false);
+  std::thread waiter([&table, &acquired]() {
+    eos::MDLocker locker2(table);
+    locker2.addFile(5).addContainer(9);
+    locker2.lock();
+    acquired = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_FALSE(acquired);
+  locker.unlock();
+  waiter.join();
+  ASSERT_TRUE(acquired);
+  ASSERT_GE(table.getContended(), 1u);
+  // Once unlocked the thread can lock again
+  other.lock();
+  ASSERT_TRUE(other.isLocked());
+}
+
+TEST(MDMutationLock, GlobalWriteLockWithoutEntryLocks)
+{
+  eos::MDLockTable table;
+  eos::common::RWMutex ns_mutex;
+  // Check from another thread whether the namespace can be read-locked
+  auto can_read = [&ns_mutex]() {
+    bool ok = false;
+    std::thread([&ns_mutex, &ok]() {
+      ok = ns_mutex.TimedRdLock(10 * 1000 * 1000);
+
+      if (ok) {
+        ns_mutex.UnLockRead();
+      }
+    }).join();
+    return ok;
+  };
+  {
+    // Entry locks: the namespace is only read-locked
+    eos::MDMutationLock lock(ns_mutex, table, true);
+    lock.locker().addContainer(1).lock();
+    ASSERT_TRUE(can_read());
+    eos::MDLocker other(table);
+    other.addContainer(2);
+    ASSERT_THROW(other.lock(), eos::MDException);
+  }
+  {
+    // No entry locks: exclusive namespace lock, the locker is a no-op and a
+    // second one on the same thread does not throw
+    eos::MDMutationLock lock(ns_mutex, table, false);
+    lock.locker().addContainer(1).lock();
+    ASSERT_TRUE(lock.locker().isLocked());
+    ASSERT_FALSE(can_read());
+    eos::MDLocker other(table, false);
+    other.addContainer(1);
+    ASSERT_NO_THROW(other.lock());
+    lock.Release();
+    ASSERT_FALSE(lock.locker().isLocked());
+    ASSERT_TRUE(can_read());
+  }
+}
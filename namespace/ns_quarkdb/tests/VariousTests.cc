@@ -31,6 +31,8 @@
 #include "namespace/ns_quarkdb/persistency/RequestBuilder.hh"
 #include "namespace/ns_quarkdb/views/HierarchicalView.hh"
 #include "namespace/ns_quarkdb/accounting/FileSystemView.hh"
+#include "namespace/ns_quarkdb/accounting/ContainerAccounting.hh"
+#include "namespace/ns_quarkdb/accounting/SyncTimeAccounting.hh"
 #include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
 #include "namespace/ns_quarkdb/FileMD.hh"
 #include "namespace/ns_quarkdb/ContainerMD.hh"
@@ -38,10 +40,14 @@
 #include "namespace/utils/Checksum.hh"
 #include "namespace/utils/Etag.hh"
 #include "namespace/utils/Attributes.hh"
+#include "namespace/MetadataWarmup.hh"
 #include "namespace/PermissionHandler.hh"
 #include "namespace/Resolver.hh"
 #include "TestUtils.hh"
 #include <folly/futures/Future.h>
+#include <atomic>
+#include <fstream>
+#include <thread>
 
 using namespace eos;
 
@@ -473,7 +479,7 @@ TEST_F(VariousTests, EtagFormatting) {
   file1->setCTime(mtime);
 
   eos::QuarkFileMD *file1f = reinterpret_cast<QuarkFileMD*>(file1.get());
-  file1f->mFile.set_id(4697755903ull);
+  file1f->mFile.mId = 4697755903ull;
 
   // File has no checksum, using inode + modification time.
   std::string outcome;
@@ -492,7 +498,7 @@ TEST_F(VariousTests, EtagFormatting) {
   char buff[4];
   buff[0] = 0xa7; buff[1] = 0x25; buff[2] = 0x99; buff[3] = 0x97;
   file1->setChecksum(buff, 4);
-  file1f->mFile.set_id(4697755939ull);
+  file1f->mFile.mId = 4697755939ull;
 
   unsigned long layout = eos::common::LayoutId::GetId(
     eos::common::LayoutId::kReplica,
@@ -812,6 +818,55 @@ TEST_F(NamespaceExplorerF, ExpansionDecider) {
   ASSERT_FALSE(explorer.fetch(item));
 }
 
+TEST_F(NamespaceExplorerF, DepthLimitAndPrefetchWindows) {
+  populateDummyData1();
+
+  // Tiny prefetch windows must not change the order of the results
+  ExplorationOptions options;
+  options.filePrefetchWindow = 1;
+  options.containerPrefetchWindow = 1;
+
+  NamespaceExplorer explorer("/eos/d2", options, qcl());
+  NamespaceItem item;
+  std::vector<std::string> paths;
+
+  while(explorer.fetch(item)) {
+    paths.push_back(item.fullPath);
+  }
+
+  ASSERT_EQ(paths.size(), 23u);
+  ASSERT_EQ(paths[0], "/eos/d2/");
+  ASSERT_EQ(paths[1], "/eos/d2/asdf1");
+  ASSERT_EQ(paths[10], "/eos/d2/zzzzz6");
+  ASSERT_EQ(paths[11], "/eos/d2/d3-1/");
+  ASSERT_EQ(paths[12], "/eos/d2/d3-2/");
+  ASSERT_EQ(paths[13], "/eos/d2/d3-2/my-file");
+  ASSERT_EQ(paths[14], "/eos/d2/d4/");
+  ASSERT_EQ(paths[15], "/eos/d2/d4/adsf");
+  ASSERT_EQ(paths[22], "/eos/d2/d4/1/2/3/4/5/6/7/");
+
+  // Depth 0: only the starting container
+  options.depthLimit = 0;
+  NamespaceExplorer explorer2("/eos/d2", options, qcl());
+  ASSERT_TRUE(explorer2.fetch(item));
+  ASSERT_EQ(item.fullPath, "/eos/d2/");
+  ASSERT_FALSE(explorer2.fetch(item));
+
+  // Depth 1: the files and subcontainers of the starting container
+  options.depthLimit = 1;
+  NamespaceExplorer explorer3("/eos/d2", options, qcl());
+  paths.clear();
+
+  while(explorer3.fetch(item)) {
+    paths.push_back(item.fullPath);
+  }
+
+  ASSERT_EQ(paths.size(), 14u);
+  ASSERT_EQ(paths[11], "/eos/d2/d3-1/");
+  ASSERT_EQ(paths[12], "/eos/d2/d3-2/");
+  ASSERT_EQ(paths[13], "/eos/d2/d4/");
+}
+
 TEST_F(VariousTests, LinkedExtendedAttributes) {
   IContainerMDPtr cont1 = view()->createContainer("/eos/dir1", true);
   IContainerMDPtr cont2 = view()->createContainer("/eos/dir1/dir2", true);
@@ -1049,3 +1104,164 @@ TEST(FileOrContainerIdentifier, BasicSanity) {
   ASSERT_EQ(container.toFileIdentifier(), FileIdentifier(0));
   ASSERT_EQ(container.toContainerIdentifier(), ContainerIdentifier(222));
 }
+
+TEST_F(VariousTests, ContainerAccountingBatch) {
+  eos::common::RWMutex ns_mutex;
+  eos::QuarkContainerAccounting accounting(containerSvc(), &ns_mutex, 0);
+  std::shared_ptr<eos::IContainerMD> cont1 = view()->createContainer("/a/b/c1", true);
+  std::shared_ptr<eos::IContainerMD> cont2 = view()->createContainer("/a/b/c2", true);
+  std::shared_ptr<eos::IContainerMD> cont3 = view()->createContainer("/a/d", true);
+
+  accounting.QueueForUpdate(cont1->getId(), 100);
+  accounting.QueueForUpdate(cont1->getId(), 20);
+  accounting.QueueForUpdate(cont2->getId(), 5);
+  accounting.QueueForUpdate(cont3->getId(), 1000);
+  accounting.QueueForUpdate(cont3->getId(), -1000);
+  accounting.PropagateUpdates();
+
+  ASSERT_EQ(view()->getContainer("/a/b/c1")->getTreeSize(), 120u);
+  ASSERT_EQ(view()->getContainer("/a/b/c2")->getTreeSize(), 5u);
+  ASSERT_EQ(view()->getContainer("/a/b")->getTreeSize(), 125u);
+  ASSERT_EQ(view()->getContainer("/a")->getTreeSize(), 125u);
+  ASSERT_EQ(view()->getContainer("/a/d")->getTreeSize(), 0u);
+
+  // c1, c2, b and a are updated once, d has a null delta
+  eos::PropagationStats stats = accounting.getPropagationStats();
+  ASSERT_EQ(stats.mBatches, 1u);
+  ASSERT_EQ(stats.mQueued, 3u);
+  ASSERT_EQ(stats.mTouched, 4u);
+  ASSERT_EQ(stats.mRounds, 2u);
+
+  // Empty batches are not accounted
+  accounting.PropagateUpdates();
+  ASSERT_EQ(accounting.getPropagationStats().mBatches, 1u);
+}
+
+TEST_F(VariousTests, SyncTimeAccountingBatch) {
+  eos::common::RWMutex ns_mutex;
+  eos::QuarkSyncTimeAccounting accounting(containerSvc(), &ns_mutex, 0);
+  std::shared_ptr<eos::IContainerMD> contA = view()->createContainer("/a", true);
+  std::shared_ptr<eos::IContainerMD> contB = view()->createContainer("/a/b", true);
+  std::shared_ptr<eos::IContainerMD> cont1 = view()->createContainer("/a/b/c1", true);
+  std::shared_ptr<eos::IContainerMD> cont2 = view()->createContainer("/a/b/c2", true);
+  std::shared_ptr<eos::IContainerMD> cont3 = view()->createContainer("/x/y", true);
+
+  for (auto& cont : {contA, contB, cont1, cont2}) {
+    cont->setAttribute("sys.mtime.propagation", "1");
+  }
+
+  eos::IContainerMD::mtime_t old_mtime {1000, 0};
+  eos::IContainerMD::mtime_t new_mtime {2000, 5};
+  cont1->setMTime(new_mtime);
+  cont2->setMTime(old_mtime);
+  cont3->setMTime(new_mtime);
+  contB->setAttribute("sys.tmp.etag", "etag");
+
+  accounting.QueueForUpdate(cont2->getId());
+  accounting.QueueForUpdate(cont1->getId());
+  accounting.QueueForUpdate(cont3->getId());
+  accounting.PropagateUpdates();
+
+  // The most recent mtime of the subtree reaches the ancestors
+  for (auto& path : {"/a", "/a/b", "/a/b/c1"}) {
+    eos::IContainerMD::tmtime_t tmtime;
+    view()->getContainer(path)->getTMTime(tmtime);
+    ASSERT_EQ(tmtime.tv_sec, new_mtime.tv_sec);
+    ASSERT_EQ(tmtime.tv_nsec, new_mtime.tv_nsec);
+  }
+
+  ASSERT_FALSE(contB->hasAttribute("sys.tmp.etag"));
+
+  // Containers without the propagation attribute are left alone
+  eos::PropagationStats stats = accounting.getPropagationStats();
+  ASSERT_EQ(stats.mBatches, 1u);
+  ASSERT_EQ(stats.mQueued, 3u);
+  ASSERT_EQ(stats.mTouched, 4u);
+}
+
+TEST_F(VariousTests, ConcurrentRenameAndGetUri) {
+  IContainerMDPtr dir = view()->createContainer("/eos/race/dir-0", true);
+  IContainerMDPtr sub = view()->createContainer("/eos/race/dir-0/sub", true);
+  IContainerMDPtr leaf = view()->createContainer("/eos/race/leaf-0", true);
+
+  // Renames within a directory run concurrently with the uri lookups, which
+  // must never keep a stale uri in the path cache
+  std::atomic<bool> done(false);
+  std::thread reader([&]() {
+    while (!done) {
+      (void) view()->getUri(sub->getId());
+      (void) view()->getUri(leaf->getId());
+    }
+  });
+
+  int stale = 0;
+
+  for (int i = 1; i <= 500; ++i) {
+    view()->renameContainer(dir.get(), SSTR("dir-" << i));
+    view()->renameContainer(leaf.get(), SSTR("leaf-" << i));
+
+    if ((view()->getUri(sub.get()) != SSTR("/eos/race/dir-" << i << "/sub/")) ||
+        (view()->getUri(leaf.get()) != SSTR("/eos/race/leaf-" << i << "/"))) {
+      ++stale;
+    }
+  }
+
+  done = true;
+  reader.join();
+  ASSERT_EQ(stale, 0);
+  ASSERT_EQ(view()->getUri(sub.get()), "/eos/race/dir-500/sub/");
+  ASSERT_EQ(view()->getContainer("/eos/race/leaf-500")->getId(), leaf->getId());
+}
+
+TEST_F(VariousTests, MetadataWarmup) {
+  populateDummyData1();
+  IFileMD::id_t f1 = view()->getFile("/eos/d1/f1")->getId();
+  IContainerMD::id_t d3 = view()->getContainer("/eos/d2/d3-2")->getId();
+  shut_down_everything();
+
+  // The list lives in the flusher queue directory wiped by Main.cc
+  std::string list = "/tmp/eos-ns-tests/warmup.list";
+  {
+    std::ofstream file(list);
+    file << "# warm-up list\n/eos/d2/\n/eos/does-not-exist/\n"
+         << "fid:" << f1 << "\ncid:" << d3 << "\n\ngarbage\nfid:abc\n";
+    ASSERT_TRUE(file.good());
+  }
+
+  MetadataWarmup warmup(view(), 2);
+  ASSERT_EQ(warmup.addList(list), 4);
+  ASSERT_EQ(warmup.addList("/tmp/eos-ns-tests/missing.list"), -1);
+  ASSERT_EQ(warmup.getPending(), 4u);
+
+  // d2 brings 3 subcontainers and 10 files, d3-2 brings my-file
+  WarmupStats stats = warmup.run();
+  ASSERT_EQ(stats.scheduled, 18u);
+  ASSERT_EQ(stats.loaded, 17u);
+  ASSERT_EQ(stats.failed, 1u);
+  ASSERT_EQ(warmup.getPending(), 0u);
+  ASSERT_GE(fileSvc()->getCacheStatistics().occupancy, 12u);
+
+  // The budget bounds the children expansion
+  shut_down_everything();
+  MetadataWarmup bounded(view(), 4, 5);
+  bounded.addPath("/eos/d2");
+  stats = bounded.run();
+  ASSERT_EQ(stats.scheduled, 5u);
+  ASSERT_EQ(stats.loaded, 5u);
+  ASSERT_EQ(bounded.getPending(), 0u);
+
+  // Lists saved in QuarkDB can be read by any MGM
+  shut_down_everything();
+  ASSERT_TRUE(MetadataWarmup::saveList(qcl(), "eos-nswarmup-test",
+                                       {"/eos/d2/", SSTR("fid:" << f1), "garbage"}));
+  MetadataWarmup from_qdb(view(), 2);
+  ASSERT_EQ(from_qdb.addList(qcl(), "eos-nswarmup-test"), 2);
+  ASSERT_EQ(from_qdb.addList(qcl(), "eos-nswarmup-missing"), -1);
+
+  // A stopped warm-up issues nothing
+  from_qdb.stop();
+  stats = from_qdb.run(std::chrono::seconds(1));
+  ASSERT_EQ(stats.scheduled, 0u);
+  ASSERT_EQ(stats.abandoned, 0u);
+  ASSERT_EQ(from_qdb.getPending(), 2u);
+}
@@ -18,7 +18,7 @@
 
 #include "namespace/ns_quarkdb/tools/ConvertMemToKV.hh"
 #include "common/LayoutId.hh"
-#include "common/Parallel.hh"
+#include "common/Executor.hh"
 #include "namespace/Constants.hh"
 #include "namespace/ns_in_memory/persistency/ChangeLogConstants.hh"
 #include "namespace/ns_quarkdb/accounting/FileSystemView.hh"
@@ -471,8 +471,9 @@ ConvertContainerMDSvc::commitToBackend()
   int nthreads = sThreads;
   int chunk = total / nthreads;
   int last_chunk = chunk + total - (chunk * nthreads);
-  // Parallel loop
-  eos::common::Parallel::For(0, nthreads, [&](int i) {
+  // Parallel loop, one worker per backend connection
+  eos::common::Executor pool("convert", nthreads);
+  pool.ParallelFor(0, nthreads, [&](int i) {
     std::int64_t count = 0;
     qclient::AsyncHandler ah;
     eos::ConvertContainerMD* conv_cont = nullptr;
@@ -602,8 +603,9 @@ ConvertFileMDSvc::initialize()
   auto start = std::time(nullptr);
   std::mutex mutex_lost_found;
   mFirstFreeId = scanner.getLargestId() + 1;
-  // Recreate the files
-  eos::common::Parallel::For(0, nthreads, [&](int i) noexcept {
+  // Recreate the files, one worker per backend connection
+  eos::common::Executor pool("convert", nthreads);
+  pool.ParallelFor(0, nthreads, [&](int i) noexcept {
     std::int64_t count = 0;
     IdMap::iterator it = pIdMap.begin();
     std::advance(it, i * chunk);
@@ -932,8 +934,9 @@ ConvertFsView::commitToBackend()
   int last_chunk = chunk + total - (chunk * nthreads);
   uint32_t max_batches = 20;
   int max_sadd_size = 1000;
-  // Parallel loop
-  eos::common::Parallel::For(0, nthreads, [&](int i) {
+  // Parallel loop, one worker per backend connection
+  eos::common::Executor pool("convert", nthreads);
+  pool.ParallelFor(0, nthreads, [&](int i) {
     std::uint64_t count = 0u;
     std::string key, val;
     qclient::AsyncHandler ah;
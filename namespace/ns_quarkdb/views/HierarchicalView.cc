@@ -18,6 +18,7 @@
 
 #include "common/Logging.hh"
 #include "common/Assert.hh"
+#include "common/FollyExecutor.hh"
 #include "namespace/ns_quarkdb/views/HierarchicalView.hh"
 #include "namespace/Constants.hh"
 #include "namespace/interface/IContainerMDSvc.hh"
@@ -27,7 +28,6 @@
 #include <cerrno>
 #include <ctime>
 #include <functional>
-#include <folly/executors/IOThreadPoolExecutor.h>
 
 using std::placeholders::_1;
 
@@ -44,7 +44,10 @@ QuarkHierarchicalView::QuarkHierarchicalView()
   : pContainerSvc(nullptr), pFileSvc(nullptr),
     pQuotaStats(new QuarkQuotaStats()), pRoot(nullptr)
 {
-  pExecutor.reset(new folly::IOThreadPoolExecutor(8));
+  // Continuations of the path lookups run on the shared namespace pool
+  pExecutor.reset(new eos::common::FollyExecutor(
+                    eos::common::Executor::GetPool("namespace", 8)));
+  mLookupCache.reset(new PathLookupCache());
 }
 
 //------------------------------------------------------------------------------
@@ -93,6 +96,7 @@ void
 QuarkHierarchicalView::initialize1()
 {
   pContainerSvc->initialize();
+  pContainerSvc->addChangeListener(this);
 
   // Get root container
   try {
@@ -143,6 +147,7 @@ QuarkHierarchicalView::finalize()
 {
   pContainerSvc->finalize();
   pFileSvc->finalize();
+  mLookupCache->clear();
   delete pQuotaStats;
   pQuotaStats = nullptr;
 }
@@ -199,6 +204,14 @@ static FileOrContainerMD toFileOrContainerMD(IContainerMDPtr ptr)
   return {nullptr, ptr};
 }
 
+//------------------------------------------------------------------------------
+// Convert a FileMDPtr to FileOrContainerMD.
+//------------------------------------------------------------------------------
+static FileOrContainerMD fileToFileOrContainerMD(IFileMDPtr ptr)
+{
+  return {ptr, nullptr};
+}
+
 //------------------------------------------------------------------------------
 // Lookup a given path - deferred function.
 //------------------------------------------------------------------------------
@@ -310,12 +323,69 @@ QuarkHierarchicalView::getPathInternal(FileOrContainerMD state,
         continue;
       }
 
+      //------------------------------------------------------------------------
+      // Fast case: Walk as many chunks as possible through the dentry cache,
+      // only the metadata of the last entry needs to be retrieved.
+      //------------------------------------------------------------------------
+      PathLookupCache::Dentry dentry;
+      dentry.mId = state.container->getId();
+      dentry.mIsContainer = true;
+      size_t cached = 0;
+
+      while (dentry.mIsContainer && cached < pendingChunks.size()) {
+        const std::string& chunk = pendingChunks[cached];
+        PathLookupCache::Dentry child;
+
+        if (chunk == "." || chunk == ".." ||
+            !mLookupCache->getDentry(dentry.mId, chunk, child)) {
+          break;
+        }
+
+        if (child.mId == 0) {
+          return folly::makeFuture<FileOrContainerMD>(make_mdexception(ENOENT,
+                 "No such file or directory"));
+        }
+
+        dentry = child;
+        ++cached;
+      }
+
+      if (cached) {
+        pendingChunks.erase(pendingChunks.begin(), pendingChunks.begin() + cached);
+
+        if (dentry.mIsContainer) {
+          folly::Future<IContainerMDPtr> fut = pContainerSvc->getContainerMDFut(
+                                                 dentry.mId);
+
+          if (!fut.isReady()) {
+            return getPathDeferred(std::move(fut), pendingChunks, follow,
+                                   expendedEffort);
+          }
+
+          state.container = fut.get();
+          continue;
+        }
+
+        folly::Future<FileOrContainerMD> next = pFileSvc->getFileMDFut(dentry.mId)
+                                                .then(fileToFileOrContainerMD);
+
+        if (!next.isReady()) {
+          return getPathDeferred(std::move(next), pendingChunks, follow,
+                                 expendedEffort);
+        }
+
+        state = next.get();
+        continue;
+      }
+
       //------------------------------------------------------------------------
       // Normal case: Our current state contains a container, and we're simply
       // looking up the next chunk.
       //------------------------------------------------------------------------
-      folly::Future<FileOrContainerMD> next = state.container->findItem(
-          pendingChunks.front());
+      IContainerMD::id_t parentId = state.container->getId();
+      std::string chunk = pendingChunks.front();
+      uint64_t epoch = mLookupCache->getDentryEpoch(parentId, chunk);
+      folly::Future<FileOrContainerMD> next = state.container->findItem(chunk);
       pendingChunks.pop_front();
 
       //------------------------------------------------------------------------
@@ -324,12 +394,22 @@ QuarkHierarchicalView::getPathInternal(FileOrContainerMD state,
       //------------------------------------------------------------------------
       if (next.isReady()) {
         state = next.get();
+        cacheDentry(parentId, chunk, state, epoch);
         continue;
       } else {
         //----------------------------------------------------------------------
-        // We're blocked, "pause" execution, unblock caller.
+        // We're blocked, "pause" execution, unblock caller. Only positive
+        // results are cached from here, findItem also reports failures to
+        // fetch an existing entry as an empty result.
         //----------------------------------------------------------------------
-        return getPathDeferred(std::move(next), pendingChunks, follow, expendedEffort);
+        return getPathDeferred(std::move(next).then([this, parentId, chunk,
+        epoch](FileOrContainerMD item) {
+          if (item.file || item.container) {
+            cacheDentry(parentId, chunk, item, epoch);
+          }
+
+          return item;
+        }), pendingChunks, follow, expendedEffort);
       }
     }
 
@@ -390,6 +470,26 @@ QuarkHierarchicalView::getPathInternal(FileOrContainerMD state,
   }
 }
 
+//------------------------------------------------------------------------------
+// Store the result of looking up a name in a container in the dentry cache
+//------------------------------------------------------------------------------
+void
+QuarkHierarchicalView::cacheDentry(IContainerMD::id_t parent,
+                                   const std::string& name,
+                                   const FileOrContainerMD& item, uint64_t epoch)
+{
+  PathLookupCache::Dentry dentry;
+
+  if (item.container) {
+    dentry.mId = item.container->getId();
+    dentry.mIsContainer = true;
+  } else if (item.file) {
+    dentry.mId = item.file->getId();
+  }
+
+  mLookupCache->putDentry(parent, name, dentry, epoch);
+}
+
 //------------------------------------------------------------------------------
 // Retrieve a file for given uri, asynchronously
 //------------------------------------------------------------------------------
@@ -761,23 +861,35 @@ QuarkHierarchicalView::getUriFut(ContainerIdentifier id) const
 std::string
 QuarkHierarchicalView::getUri(const IContainerMD::id_t cid) const
 {
-  // Gather the uri elements
-  std::vector<std::string> elements;
+  std::string path;
+
+  if (mLookupCache->getPath(cid, path)) {
+    return path;
+  }
+
+  // Gather the uri elements up to the root or to a cached ancestor
+  uint64_t epoch = mLookupCache->getPathEpoch();
+  std::vector<std::pair<IContainerMD::id_t, std::string>> elements;
   elements.reserve(10);
   std::shared_ptr<IContainerMD> cursor = pContainerSvc->getContainerMD(cid);
+  path = "/";
 
   while (cursor->getId() != 1) {
-    elements.push_back(cursor->getName());
-    cursor = pContainerSvc->getContainerMD(cursor->getParentId());
-  }
+    elements.emplace_back(cursor->getId(), cursor->getName());
+    IContainerMD::id_t parentId = cursor->getParentId();
 
-  // Assemble the uri
-  std::string path = "/";
-  std::vector<std::string>::reverse_iterator rit;
+    if ((parentId == 1) || mLookupCache->getPath(parentId, path)) {
+      break;
+    }
+
+    cursor = pContainerSvc->getContainerMD(parentId);
+  }
 
-  for (rit = elements.rbegin(); rit != elements.rend(); ++rit) {
-    path += *rit;
+  // Assemble the uri, caching the one of every container on the way
+  for (auto rit = elements.rbegin(); rit != elements.rend(); ++rit) {
+    path += rit->second;
     path += "/";
+    mLookupCache->putPath(rit->first, path, epoch);
   }
 
   return path;
@@ -1021,6 +1133,19 @@ QuarkHierarchicalView::renameContainer(IContainerMD* container,
   parent->removeContainer(container->getName());
   container->setName(newName);
   parent->addContainer(container);
+
+  //----------------------------------------------------------------------------
+  // Renames within a directory only hold entry locks, so a concurrent getUri
+  // may have taken the epoch after the invalidation done by removeContainer
+  // and still read the old name. Drop the uris again now that the new name
+  // is visible.
+  //----------------------------------------------------------------------------
+  if (container->getNumContainers() == 0) {
+    mLookupCache->invalidatePath(container->getId());
+  } else {
+    mLookupCache->invalidateAllPaths();
+  }
+
   updateContainerStore(container);
 }
 
@@ -1079,4 +1204,68 @@ folly::Future<IContainerMDPtr> QuarkHierarchicalView::getParentContainer(
   return pContainerSvc->getContainerMDFut(parentId);
 }
 
+//------------------------------------------------------------------------------
+// Get statistics of the path lookup caches
+//------------------------------------------------------------------------------
+PathCacheStatistics
+QuarkHierarchicalView::getPathCacheStatistics()
+{
+  return mLookupCache->getStatistics();
+}
+
+//------------------------------------------------------------------------------
+// Container change notification
+//------------------------------------------------------------------------------
+void
+QuarkHierarchicalView::containerMDChanged(IContainerMD* obj, Action type)
+{
+  if (type == IContainerMDChangeListener::Deleted) {
+    mLookupCache->invalidatePath(obj->getId());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Container entry change notification
+//------------------------------------------------------------------------------
+void
+QuarkHierarchicalView::containerMDEntryChanged(IContainerMD* parent,
+    const std::string& name, uint64_t id, bool is_container, Action type)
+{
+  mLookupCache->invalidateDentry(parent->getId(), name);
+
+  //----------------------------------------------------------------------------
+  // A container only gets a new uri by being removed from its parent first,
+  // so a container being added - mkdir or second half of a rename - has no
+  // cached uri to drop.
+  //----------------------------------------------------------------------------
+  if (!is_container || (type != IContainerMDChangeListener::Deleted)) {
+    return;
+  }
+
+  //----------------------------------------------------------------------------
+  // The uri of the container changes and, if it has subcontainers, the uris
+  // of the whole subtree as well. Those are not indexed by ancestor, so moving
+  // a subtree drops all the cached uris. The caller holds the container, so
+  // it is resolved from the metadata cache, never waiting for the backend -
+  // if it is not there all the uris are dropped. A container which can no
+  // longer be retrieved was removed, hence empty.
+  //----------------------------------------------------------------------------
+  bool leaf = false;
+  folly::Future<IContainerMDPtr> fut = pContainerSvc->getContainerMDFut(id);
+
+  if (fut.isReady()) {
+    if (fut.hasException()) {
+      leaf = true;
+    } else {
+      leaf = (fut.value()->getNumContainers() == 0);
+    }
+  }
+
+  if (leaf) {
+    mLookupCache->invalidatePath(id);
+  } else {
+    mLookupCache->invalidateAllPaths();
+  }
+}
+
 EOSNSNAMESPACE_END
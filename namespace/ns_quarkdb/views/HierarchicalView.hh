@@ -29,6 +29,7 @@
 #include "namespace/interface/IFileMDSvc.hh"
 #include "namespace/interface/IView.hh"
 #include "namespace/ns_quarkdb/accounting/QuotaStats.hh"
+#include "namespace/ns_quarkdb/views/PathLookupCache.hh"
 
 #ifdef __clang__
 #pragma clang diagnostic ignored "-Wunused-private-field"
@@ -38,8 +39,12 @@ EOSNSNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
 //! Implementation of the hierarchical namespace
+//!
+//! Path lookups go through a dentry cache which lets a lookup jump over the
+//! intermediate containers, and container uris are kept in a path cache. The
+//! view listens to the container entry changes to keep both consistent.
 //------------------------------------------------------------------------------
-class QuarkHierarchicalView : public IView
+class QuarkHierarchicalView : public IView, public IContainerMDChangeListener
 {
 public:
   //----------------------------------------------------------------------------
@@ -297,6 +302,24 @@ public:
   virtual folly::Future<IContainerMDPtr> getParentContainer(
     IFileMD *file);
 
+  //----------------------------------------------------------------------------
+  //! Get statistics of the path lookup caches
+  //----------------------------------------------------------------------------
+  virtual PathCacheStatistics getPathCacheStatistics() override;
+
+  //----------------------------------------------------------------------------
+  //! Container change notification, drops the path of deleted containers
+  //----------------------------------------------------------------------------
+  virtual void containerMDChanged(IContainerMD* obj, Action type) override;
+
+  //----------------------------------------------------------------------------
+  //! Container entry change notification, invalidates the cached lookups
+  //! affected by the change
+  //----------------------------------------------------------------------------
+  virtual void containerMDEntryChanged(IContainerMD* parent,
+                                       const std::string& name, uint64_t id,
+                                       bool is_container, Action type) override;
+
 private:
   //----------------------------------------------------------------------------
   //! Lookup a given path - internal function.
@@ -325,6 +348,17 @@ private:
   folly::Future<IContainerMDPtr>
   getPathExpectContainer(const std::deque<std::string> &chunks);
 
+  //----------------------------------------------------------------------------
+  //! Store the result of looking up a name in a container in the dentry cache
+  //!
+  //! @param parent id of the container
+  //! @param name looked up name
+  //! @param item lookup result
+  //! @param epoch dentry epoch taken before the lookup started
+  //----------------------------------------------------------------------------
+  void cacheDentry(IContainerMD::id_t parent, const std::string& name,
+                   const FileOrContainerMD& item, uint64_t epoch);
+
   //----------------------------------------------------------------------------
   //! Clean up contents of container
   //!
@@ -340,6 +374,7 @@ private:
   IQuotaStats* pQuotaStats;
   std::shared_ptr<IContainerMD> pRoot;
   std::unique_ptr<folly::Executor> pExecutor;
+  std::unique_ptr<PathLookupCache> mLookupCache; ///< Dentry and path caches
 };
 
 EOSNSNAMESPACE_END
@@ -0,0 +1,263 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/views/PathLookupCache.hh"
+
+EOSNSNAMESPACE_BEGIN
+
+constexpr std::uint64_t PathLookupCache::sDefaultMaxDentries;
+constexpr std::uint64_t PathLookupCache::sDefaultMaxPaths;
+constexpr std::size_t PathLookupCache::sDefaultShards;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+PathLookupCache::PathLookupCache(std::uint64_t max_dentries,
+                                 std::uint64_t max_paths,
+                                 std::size_t num_shards):
+  mPathEpoch(0), mDentryHits(0), mDentryNegativeHits(0), mDentryMisses(0),
+  mDentryInvalidations(0), mDentryEvictions(0), mPathHits(0), mPathMisses(0),
+  mPathInvalidations(0), mPathEvictions(0)
+{
+  if (num_shards == 0) {
+    num_shards = 1;
+  }
+
+  for (std::size_t i = 0; i < num_shards; ++i) {
+    mDentryShards.emplace_back(new DentryShard());
+    mPathShards.emplace_back(new PathShard());
+  }
+
+  mMaxDentriesPerShard = (max_dentries + num_shards - 1) / num_shards;
+  mMaxPathsPerShard = (max_paths + num_shards - 1) / num_shards;
+}
+
+//------------------------------------------------------------------------------
+// Get the epoch of the shard responsible for a dentry
+//------------------------------------------------------------------------------
+std::uint64_t
+PathLookupCache::getDentryEpoch(std::uint64_t parent,
+                                const std::string& name) const
+{
+  DentryKey key {parent, name};
+  DentryShard& shard = GetDentryShard(key);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  return shard.mEpoch;
+}
+
+//------------------------------------------------------------------------------
+// Lookup a dentry
+//------------------------------------------------------------------------------
+bool
+PathLookupCache::getDentry(std::uint64_t parent, const std::string& name,
+                           Dentry& dentry)
+{
+  if (mMaxDentriesPerShard == 0) {
+    return false;
+  }
+
+  DentryKey key {parent, name};
+  DentryShard& shard = GetDentryShard(key);
+  bool found;
+  {
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    found = shard.get(key, dentry);
+  }
+
+  if (!found) {
+    mDentryMisses++;
+  } else if (dentry.mId == 0) {
+    mDentryNegativeHits++;
+  } else {
+    mDentryHits++;
+  }
+
+  return found;
+}
+
+//------------------------------------------------------------------------------
+// Store the result of a lookup
+//------------------------------------------------------------------------------
+void
+PathLookupCache::putDentry(std::uint64_t parent, const std::string& name,
+                           const Dentry& dentry, std::uint64_t epoch)
+{
+  if (mMaxDentriesPerShard == 0) {
+    return;
+  }
+
+  DentryKey key {parent, name};
+  DentryShard& shard = GetDentryShard(key);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+
+  if (shard.mEpoch != epoch) {
+    return;
+  }
+
+  mDentryEvictions += shard.put(key, dentry, mMaxDentriesPerShard);
+}
+
+//------------------------------------------------------------------------------
+// Drop a dentry
+//------------------------------------------------------------------------------
+void
+PathLookupCache::invalidateDentry(std::uint64_t parent, const std::string& name)
+{
+  DentryKey key {parent, name};
+  DentryShard& shard = GetDentryShard(key);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+
+  if (shard.remove(key)) {
+    mDentryInvalidations++;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Lookup the path of a container
+//------------------------------------------------------------------------------
+bool
+PathLookupCache::getPath(std::uint64_t id, std::string& path)
+{
+  if (mMaxPathsPerShard == 0) {
+    return false;
+  }
+
+  PathShard& shard = GetPathShard(id);
+  bool found;
+  {
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    found = shard.get(id, path);
+  }
+
+  if (found) {
+    mPathHits++;
+  } else {
+    mPathMisses++;
+  }
+
+  return found;
+}
+
+//------------------------------------------------------------------------------
+// Store the path of a container
+//------------------------------------------------------------------------------
+void
+PathLookupCache::putPath(std::uint64_t id, const std::string& path,
+                         std::uint64_t epoch)
+{
+  if (mMaxPathsPerShard == 0) {
+    return;
+  }
+
+  PathShard& shard = GetPathShard(id);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+
+  // Invalidations bump the epoch while holding the shard lock, so checking
+  // it under the same lock orders the fill before or after them
+  if (mPathEpoch.load() != epoch) {
+    return;
+  }
+
+  mPathEvictions += shard.put(id, path, mMaxPathsPerShard);
+}
+
+//------------------------------------------------------------------------------
+// Drop the path of a container
+//------------------------------------------------------------------------------
+void
+PathLookupCache::invalidatePath(std::uint64_t id)
+{
+  PathShard& shard = GetPathShard(id);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  mPathEpoch++;
+
+  if (shard.remove(id)) {
+    mPathInvalidations++;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop all the paths
+//------------------------------------------------------------------------------
+void
+PathLookupCache::invalidateAllPaths()
+{
+  // Bump the epoch first so that no fill started before this call lands in
+  // an already flushed shard
+  mPathEpoch++;
+
+  for (auto& shard : mPathShards) {
+    std::lock_guard<std::mutex> lock(shard->mMutex);
+    mPathInvalidations += shard->mMap.size();
+    shard->clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop all the entries of both caches
+//------------------------------------------------------------------------------
+void
+PathLookupCache::clear()
+{
+  for (auto& shard : mDentryShards) {
+    std::lock_guard<std::mutex> lock(shard->mMutex);
+    shard->clear();
+  }
+
+  mPathEpoch++;
+
+  for (auto& shard : mPathShards) {
+    std::lock_guard<std::mutex> lock(shard->mMutex);
+    shard->clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get statistics
+//------------------------------------------------------------------------------
+PathCacheStatistics
+PathLookupCache::getStatistics() const
+{
+  PathCacheStatistics stats;
+  stats.enabled = (mMaxDentriesPerShard || mMaxPathsPerShard);
+  stats.dentryMaxNum = mMaxDentriesPerShard * mDentryShards.size();
+  stats.pathMaxNum = mMaxPathsPerShard * mPathShards.size();
+
+  for (const auto& shard : mDentryShards) {
+    std::lock_guard<std::mutex> lock(shard->mMutex);
+    stats.dentryOccupancy += shard->mMap.size();
+  }
+
+  for (const auto& shard : mPathShards) {
+    std::lock_guard<std::mutex> lock(shard->mMutex);
+    stats.pathOccupancy += shard->mMap.size();
+  }
+
+  stats.dentryHits = mDentryHits.load();
+  stats.dentryNegativeHits = mDentryNegativeHits.load();
+  stats.dentryMisses = mDentryMisses.load();
+  stats.dentryInvalidations = mDentryInvalidations.load();
+  stats.dentryEvictions = mDentryEvictions.load();
+  stats.pathHits = mPathHits.load();
+  stats.pathMisses = mPathMisses.load();
+  stats.pathInvalidations = mPathInvalidations.load();
+  stats.pathEvictions = mPathEvictions.load();
+  return stats;
+}
+
+EOSNSNAMESPACE_END
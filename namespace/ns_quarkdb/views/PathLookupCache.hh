@@ -0,0 +1,310 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @file PathLookupCache.hh
+//! @brief Bounded, sharded dentry and container path caches used by the
+//!        hierarchical view to resolve paths without visiting every level.
+//------------------------------------------------------------------------------
+
+#ifndef __EOS_NS_PATH_LOOKUP_CACHE_HH__
+#define __EOS_NS_PATH_LOOKUP_CACHE_HH__
+
+#include "namespace/Namespace.hh"
+#include "namespace/interface/Misc.hh"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Cache of path lookups
+//!
+//! The dentry cache maps (parent container id, name) to the id of the child
+//! and whether it is a container, or remembers that the name does not exist.
+//! The path cache maps a container id to its full path. Both are split in
+//! shards with their own lock and LRU list, and are bounded in size.
+//!
+//! Fills race with invalidations: a lookup done before an entry is removed
+//! could otherwise insert stale data after the removal. Every fill therefore
+//! carries the epoch read before the lookup started and is dropped if an
+//! invalidation happened in the meantime.
+//------------------------------------------------------------------------------
+class PathLookupCache
+{
+public:
+  //! Cached directory entry, a null id marks a negative entry
+  struct Dentry {
+    std::uint64_t mId = 0; ///< Id of the child
+    bool mIsContainer = false; ///< True if the child is a container
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param max_dentries maximum number of dentries, 0 disables the cache
+  //! @param max_paths maximum number of container paths, 0 disables the cache
+  //! @param num_shards number of independent shards of each cache
+  //----------------------------------------------------------------------------
+  PathLookupCache(std::uint64_t max_dentries = sDefaultMaxDentries,
+                  std::uint64_t max_paths = sDefaultMaxPaths,
+                  std::size_t num_shards = sDefaultShards);
+
+  //----------------------------------------------------------------------------
+  //! Get the epoch to pass to putDentry for a lookup about to start
+  //----------------------------------------------------------------------------
+  std::uint64_t getDentryEpoch(std::uint64_t parent,
+                               const std::string& name) const;
+
+  //----------------------------------------------------------------------------
+  //! Lookup a dentry
+  //!
+  //! @param parent parent container id
+  //! @param name entry name
+  //! @param dentry filled with the cached entry
+  //!
+  //! @return true if found, check dentry.mId for negative entries
+  //----------------------------------------------------------------------------
+  bool getDentry(std::uint64_t parent, const std::string& name, Dentry& dentry);
+
+  //----------------------------------------------------------------------------
+  //! Store the result of a lookup unless the entry was invalidated since
+  //! the given epoch was taken
+  //----------------------------------------------------------------------------
+  void putDentry(std::uint64_t parent, const std::string& name,
+                 const Dentry& dentry, std::uint64_t epoch);
+
+  //----------------------------------------------------------------------------
+  //! Drop a dentry after the parent container changed
+  //----------------------------------------------------------------------------
+  void invalidateDentry(std::uint64_t parent, const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Get the epoch to pass to putPath for a path computation about to start
+  //----------------------------------------------------------------------------
+  inline std::uint64_t
+  getPathEpoch() const
+  {
+    return mPathEpoch.load();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Lookup the path of a container
+  //!
+  //! @param id container id
+  //! @param path filled with the path, ending with "/"
+  //!
+  //! @return true if found
+  //----------------------------------------------------------------------------
+  bool getPath(std::uint64_t id, std::string& path);
+
+  //----------------------------------------------------------------------------
+  //! Store the path of a container unless any path was invalidated since the
+  //! given epoch was taken
+  //----------------------------------------------------------------------------
+  void putPath(std::uint64_t id, const std::string& path, std::uint64_t epoch);
+
+  //----------------------------------------------------------------------------
+  //! Drop the path of a container without subcontainers
+  //----------------------------------------------------------------------------
+  void invalidatePath(std::uint64_t id);
+
+  //----------------------------------------------------------------------------
+  //! Drop all the paths, used when a whole subtree moves
+  //----------------------------------------------------------------------------
+  void invalidateAllPaths();
+
+  //----------------------------------------------------------------------------
+  //! Drop all the entries of both caches
+  //----------------------------------------------------------------------------
+  void clear();
+
+  //----------------------------------------------------------------------------
+  //! Get statistics
+  //----------------------------------------------------------------------------
+  PathCacheStatistics getStatistics() const;
+
+  PathLookupCache(const PathLookupCache& other) = delete;
+  PathLookupCache& operator=(const PathLookupCache& other) = delete;
+
+  //! Default maximum number of dentries
+  static constexpr std::uint64_t sDefaultMaxDentries = 4000000;
+  //! Default maximum number of container paths
+  static constexpr std::uint64_t sDefaultMaxPaths = 1000000;
+  //! Default number of shards
+  static constexpr std::size_t sDefaultShards = 64;
+
+private:
+  //! Key of the dentry cache
+  struct DentryKey {
+    std::uint64_t mParent;
+    std::string mName;
+
+    bool operator==(const DentryKey& other) const
+    {
+      return (mParent == other.mParent) && (mName == other.mName);
+    }
+  };
+
+  struct DentryKeyHasher {
+    std::size_t operator()(const DentryKey& key) const
+    {
+      return std::hash<std::string>()(key.mName) ^
+             (key.mParent * 0x9e3779b97f4a7c15ull);
+    }
+  };
+
+  struct IdHasher {
+    std::size_t operator()(std::uint64_t id) const
+    {
+      return id * 0x9e3779b97f4a7c15ull;
+    }
+  };
+
+  //! LRU shard of one of the caches
+  template <typename KeyT, typename ValueT, typename HashT>
+  struct Shard {
+    using ListT = std::list<std::pair<KeyT, ValueT>>;
+
+    //--------------------------------------------------------------------------
+    //! Lookup an entry and mark it as most recently used
+    //--------------------------------------------------------------------------
+    bool get(const KeyT& key, ValueT& value)
+    {
+      auto it = mMap.find(key);
+
+      if (it == mMap.end()) {
+        return false;
+      }
+
+      mList.splice(mList.begin(), mList, it->second);
+      value = it->second->second;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Insert or replace an entry, evicting the least recently used ones
+    //! over capacity
+    //!
+    //! @return number of evicted entries
+    //--------------------------------------------------------------------------
+    std::uint64_t put(const KeyT& key, const ValueT& value, std::uint64_t max)
+    {
+      auto it = mMap.find(key);
+
+      if (it != mMap.end()) {
+        it->second->second = value;
+        mList.splice(mList.begin(), mList, it->second);
+        return 0;
+      }
+
+      mList.emplace_front(key, value);
+      mMap.emplace(key, mList.begin());
+      std::uint64_t evicted = 0;
+
+      while (mMap.size() > max) {
+        mMap.erase(mList.back().first);
+        mList.pop_back();
+        ++evicted;
+      }
+
+      return evicted;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Remove an entry and move to the next epoch
+    //!
+    //! @return true if the entry was cached
+    //--------------------------------------------------------------------------
+    bool remove(const KeyT& key)
+    {
+      ++mEpoch;
+      auto it = mMap.find(key);
+
+      if (it == mMap.end()) {
+        return false;
+      }
+
+      mList.erase(it->second);
+      mMap.erase(it);
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Remove all the entries
+    //--------------------------------------------------------------------------
+    void clear()
+    {
+      ++mEpoch;
+      mMap.clear();
+      mList.clear();
+    }
+
+    mutable std::mutex mMutex; ///< Protects the members below
+    ListT mList; ///< Entries, most recently used first
+    std::unordered_map<KeyT, typename ListT::iterator, HashT> mMap;
+    std::uint64_t mEpoch = 0; ///< Incremented on every invalidation
+  };
+
+  using DentryShard = Shard<DentryKey, Dentry, DentryKeyHasher>;
+  using PathShard = Shard<std::uint64_t, std::string, IdHasher>;
+
+  //----------------------------------------------------------------------------
+  //! Get the shard responsible for the given dentry
+  //----------------------------------------------------------------------------
+  inline DentryShard&
+  GetDentryShard(const DentryKey& key) const
+  {
+    return *mDentryShards[(DentryKeyHasher()(key) >> 32) % mDentryShards.size()];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the shard responsible for the given container path
+  //----------------------------------------------------------------------------
+  inline PathShard&
+  GetPathShard(std::uint64_t id) const
+  {
+    return *mPathShards[(IdHasher()(id) >> 32) % mPathShards.size()];
+  }
+
+  std::vector<std::unique_ptr<DentryShard>> mDentryShards; ///< Dentry shards
+  std::vector<std::unique_ptr<PathShard>> mPathShards; ///< Path shards
+  std::uint64_t mMaxDentriesPerShard; ///< Capacity of a dentry shard
+  std::uint64_t mMaxPathsPerShard; ///< Capacity of a path shard
+  std::atomic<std::uint64_t> mPathEpoch; ///< Incremented on path invalidation
+  std::atomic<std::uint64_t> mDentryHits;
+  std::atomic<std::uint64_t> mDentryNegativeHits;
+  std::atomic<std::uint64_t> mDentryMisses;
+  std::atomic<std::uint64_t> mDentryInvalidations;
+  std::atomic<std::uint64_t> mDentryEvictions;
+  std::atomic<std::uint64_t> mPathHits;
+  std::atomic<std::uint64_t> mPathMisses;
+  std::atomic<std::uint64_t> mPathInvalidations;
+  std::atomic<std::uint64_t> mPathEvictions;
+};
+
+EOSNSNAMESPACE_END
+
+#endif // __EOS_NS_PATH_LOOKUP_CACHE_HH__
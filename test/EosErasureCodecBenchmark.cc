@@ -0,0 +1,153 @@
+// ----------------------------------------------------------------------
+// File: EosErasureCodecBenchmark.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+/*-----------------------------------------------------------------------------*/
+#include "common/LayoutId.hh"
+#include "common/Logging.hh"
+#include "common/Timing.hh"
+#include "fst/layout/ErasureCodec.hh"
+/*-----------------------------------------------------------------------------*/
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using eos::fst::ErasureCodec;
+using eos::common::LayoutId;
+
+// Amount of data encoded/decoded for every measurement
+#define CODECVOLUME 2ll*1024ll*1024ll*1024ll
+
+//------------------------------------------------------------------------------
+// Run the given operation over CODECVOLUME bytes of data and return GB/s
+//------------------------------------------------------------------------------
+template <typename Op>
+double Measure(size_t bytes_per_op, Op op)
+{
+  size_t iterations = (CODECVOLUME) / bytes_per_op + 1;
+  eos::common::Timing tm("Codec");
+  COMMONTIMING("START", &tm);
+
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!op()) {
+      return -1;
+    }
+  }
+
+  COMMONTIMING("STOP", &tm);
+  return (1.0 * iterations * bytes_per_op) / (tm.RealTime() * 1e6);
+}
+
+//------------------------------------------------------------------------------
+// Benchmark the erasure coding backends for all the (k, m) geometries that the
+// RAIN layouts support: RAID6 (m = 2) and archive (m = 3) with up to 16
+// stripes in total. Usage: eos-erasure-codec-bench [blocksize_bytes]
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  eos::common::Logging& g_logging = eos::common::Logging::GetInstance();
+  g_logging.SetUnit("eoserasurecodecbenchmark@localhost");
+  g_logging.gShortFormat = true;
+  g_logging.SetLogPriority(LOG_INFO);
+  size_t blocksize = LayoutId::BlockSize(LayoutId::k1M);
+
+  if (argc == 2) {
+    blocksize = strtoull(argv[1], 0, 10);
+
+    if ((blocksize == 0) || (blocksize % LayoutId::OssXsBlockSize)) {
+      fprintf(stderr, "error: block size must be a multiple of 4KB\n");
+      return -1;
+    }
+  }
+
+  const unsigned int max_stripes = 16;
+  std::vector<std::pair<const char*, unsigned int>> layouts {
+    {"raid6", LayoutId::GetRedundancyStripeNumber(LayoutId::GetId(LayoutId::kRaid6))},
+    {"archive", LayoutId::GetRedundancyStripeNumber(LayoutId::GetId(LayoutId::kArchive))}
+  };
+  std::vector<ErasureCodec::Type> types {
+    ErasureCodec::Type::kJerasureCauchy, ErasureCodec::Type::kGfSplit
+  };
+  std::vector<std::vector<char>> blocks(max_stripes,
+                                        std::vector<char>(blocksize));
+
+  for (auto& block : blocks) {
+    for (auto& c : block) {
+      c = random() % 256;
+    }
+  }
+
+  fprintf(stdout, "%-16s %-8s %-3s %-3s %-12s %-14s %-14s %-10s\n", "codec",
+          "layout", "k", "m", "encode[GB/s]", "decode1[GB/s]", "decodeM[GB/s]",
+          "misses");
+
+  for (auto type : types) {
+    for (const auto& layout : layouts) {
+      unsigned int m = layout.second;
+
+      for (unsigned int k = 2; k + m <= max_stripes; ++k) {
+        auto codec = ErasureCodec::Get(type, k, m, blocksize);
+
+        if (!codec) {
+          eos_static_err("failed to get codec=%s k=%u m=%u",
+                         ErasureCodec::TypeToString(type), k, m);
+          continue;
+        }
+
+        std::vector<char*> data, coding;
+
+        for (unsigned int i = 0; i < k; ++i) {
+          data.push_back(blocks[i].data());
+        }
+
+        for (unsigned int i = 0; i < m; ++i) {
+          coding.push_back(blocks[k + i].data());
+        }
+
+        size_t group_bytes = k * blocksize;
+        double encode = Measure(group_bytes, [&]() {
+          return codec->Encode(data.data(), coding.data(), blocksize);
+        });
+        // Decode with one missing data stripe and with m missing stripes
+        std::set<unsigned int> one {0};
+        std::set<unsigned int> all;
+
+        for (unsigned int i = 0; i < m; ++i) {
+          all.insert(i * (k + m) / m);
+        }
+
+        double decode_one = Measure(group_bytes, [&]() {
+          return codec->Decode(one, data.data(), coding.data(), blocksize);
+        });
+        double decode_all = Measure(group_bytes, [&]() {
+          return codec->Decode(all, data.data(), coding.data(), blocksize);
+        });
+        uint64_t hits = 0, misses = 0;
+        codec->GetDecodeCacheStats(hits, misses);
+        fprintf(stdout, "%-16s %-8s %-3u %-3u %-12.02f %-14.02f %-14.02f %-10lu\n",
+                ErasureCodec::TypeToString(type), layout.first, k, m, encode,
+                decode_one, decode_all, misses);
+      }
+    }
+  }
+
+  return 0;
+}
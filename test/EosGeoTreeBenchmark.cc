@@ -0,0 +1,347 @@
+//------------------------------------------------------------------------------
+// @file EosGeoTreeBenchmark.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Multithreaded placement benchmark of the double buffered fast
+//!        structures as used by the GeoTreeEngine. Scheduler threads copy the
+//!        placement tree of a random group and place 3 replicas while an
+//!        updater thread rebuilds the background structures of every group
+//!        from the slow tree and swaps the buffers. The readers either take
+//!        the read lock of the group, as the GeoTreeEngine used to, or protect
+//!        the foreground buffer with a hazard pointer.
+//------------------------------------------------------------------------------
+
+#include "mgm/geotree/SchedulingSlowTree.hh"
+#include "common/HazardPointer.hh"
+#include "common/RWMutex.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace eos::mgm;
+
+const size_t groupSize = 100;
+const size_t nFsPerBox = 10;
+const size_t nReplicas = 3;
+const size_t bufferSize = 1 << 16;
+
+//------------------------------------------------------------------------------
+//! Fast structures of a group, filled by the updater only
+//------------------------------------------------------------------------------
+struct FastStructs {
+  FastPlacementTree placementTree;
+  FastROAccessTree rOAccessTree;
+  FastRWAccessTree rWAccessTree;
+  FastBalancingPlacementTree blcPlacementTree;
+  FastBalancingAccessTree blcAccessTree;
+  FastDrainingPlacementTree drnPlacementTree;
+  FastDrainingAccessTree drnAccessTree;
+  SchedTreeBase::FastTreeInfo treeInfo;
+  Fs2TreeIdxMap fs2TreeIdx;
+  GeoTag2NodeIdxMap tag2NodeIdx;
+
+  void allocate(size_t nodeCount)
+  {
+    placementTree.selfAllocate(nodeCount);
+    rOAccessTree.selfAllocate(nodeCount);
+    rWAccessTree.selfAllocate(nodeCount);
+    blcPlacementTree.selfAllocate(nodeCount);
+    blcAccessTree.selfAllocate(nodeCount);
+    drnPlacementTree.selfAllocate(nodeCount);
+    drnAccessTree.selfAllocate(nodeCount);
+    fs2TreeIdx.selfAllocate(nodeCount);
+    tag2NodeIdx.selfAllocate(nodeCount);
+  }
+
+  bool build(const SlowTree& slowTree)
+  {
+    return slowTree.buildFastStrcturesSched(&placementTree, &rOAccessTree,
+                                            &rWAccessTree, &blcPlacementTree,
+                                            &blcAccessTree, &drnPlacementTree,
+                                            &drnAccessTree, &treeInfo,
+                                            &fs2TreeIdx, &tag2NodeIdx);
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Scheduling group with its double buffered fast structures
+//------------------------------------------------------------------------------
+struct Group {
+  SlowTree slowTree;
+  FastStructs fastStructs[2];
+  FastStructs* foreground;
+  FastStructs* background;
+  eos::common::RWMutex doubleBufferMutex;
+
+  Group(): foreground(fastStructs), background(fastStructs + 1)
+  {
+    doubleBufferMutex.SetBlocking(true);
+  }
+};
+
+enum class Mode { kRWMutex, kHazardPointer };
+
+//------------------------------------------------------------------------------
+// Build the groups for the given number of file systems, every group holds
+// groupSize file systems located on different boxes
+//------------------------------------------------------------------------------
+std::vector<std::unique_ptr<Group>>
+BuildGroups(size_t nFs)
+{
+  size_t nBoxes = std::max<size_t>(nFs / nFsPerBox, 1);
+  size_t nGroups = std::max<size_t>(nFs / groupSize, 1);
+  std::vector<std::unique_ptr<Group>> groups;
+
+  for (size_t g = 0; g < nGroups; ++g) {
+    groups.emplace_back(new Group());
+    groups.back()->slowTree.setName(std::to_string(g));
+  }
+
+  for (size_t fs = 0; fs < nFs; ++fs) {
+    size_t box = fs % nBoxes;
+    char geotag[64], host[64];
+    snprintf(geotag, sizeof(geotag), "site%zu::rack%02zu::box%04zu", box % 2,
+             (box / 2) % 32, box);
+    snprintf(host, sizeof(host), "fst%04zu.cern.ch", box);
+    SchedTreeBase::TreeNodeInfo info;
+    info.geotag = geotag;
+    info.host = host;
+    info.hostport = std::string(host) + ":1095";
+    info.fsId = fs + 1;
+    SchedTreeBase::TreeNodeStateFloat state;
+    state.dlScore = 1.0;
+    state.ulScore = 1.0;
+    state.mStatus = SchedTreeBase::Available | SchedTreeBase::Writable |
+                    SchedTreeBase::Readable;
+    state.fillRatio = 0.5;
+    state.totalSpace = 2e12;
+    groups[(fs / groupSize) % nGroups]->slowTree.insert(&info, &state);
+  }
+
+  for (auto& group : groups) {
+    for (auto& fastStructs : group->fastStructs) {
+      fastStructs.allocate(group->slowTree.getNodeCount());
+
+      if (!fastStructs.build(group->slowTree)) {
+        fprintf(stderr, "error: failed to build the fast structures\n");
+        exit(1);
+      }
+    }
+  }
+
+  return groups;
+}
+
+//------------------------------------------------------------------------------
+// Place the replicas on the given fast structures like placeNewReplicas does,
+// i.e. on a private copy of the placement tree
+//------------------------------------------------------------------------------
+bool
+Place(const FastStructs* fastStructs, char* buffer)
+{
+  if (fastStructs->placementTree.copyToBuffer(buffer, bufferSize)) {
+    return false;
+  }
+
+  FastPlacementTree* tree = (FastPlacementTree*) buffer;
+  SchedTreeBase::tFastTreeIdx idx;
+  size_t placed = 0;
+
+  for (size_t i = 0; i < nReplicas; ++i) {
+    if (tree->findFreeSlot(idx)) {
+      ++placed;
+    }
+  }
+
+  return (placed == nReplicas);
+}
+
+//------------------------------------------------------------------------------
+//! Result of a run
+//------------------------------------------------------------------------------
+struct RunResult {
+  double mRate; ///< Placements per second
+  double mP50; ///< Median latency in microseconds
+  double mP99; ///< 99th percentile latency in microseconds
+  size_t mSwaps; ///< Number of buffer swaps done by the updater
+  size_t mErrors; ///< Failed placements
+};
+
+//------------------------------------------------------------------------------
+// Run the scheduler threads and the updater for the given duration
+//------------------------------------------------------------------------------
+RunResult
+Run(std::vector<std::unique_ptr<Group>>& groups, Mode mode,
+    unsigned int nThreads, unsigned int durationMs, unsigned int updateMs)
+{
+  std::atomic<bool> stop(false);
+  std::atomic<size_t> swaps(0), errors(0);
+  std::vector<std::vector<uint32_t>> latencies(nThreads);
+  std::vector<std::thread> schedulers;
+  std::thread updater([&]() {
+    while (!stop) {
+      for (auto& group : groups) {
+        if (!group->background->build(group->slowTree)) {
+          ++errors;
+        }
+
+        if (mode == Mode::kRWMutex) {
+          eos::common::RWMutexWriteLock lock(group->doubleBufferMutex);
+          std::swap(group->foreground, group->background);
+        } else {
+          FastStructs* previous = group->foreground;
+          eos::common::HazardPointer::Publish(group->foreground,
+                                              group->background);
+          group->background = previous;
+          eos::common::HazardPointer::WaitUntilUnprotected(previous);
+        }
+
+        ++swaps;
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(updateMs));
+    }
+  });
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned int t = 0; t < nThreads; ++t) {
+    schedulers.emplace_back([&, t]() {
+      std::unique_ptr<uint64_t[]> buffer(new uint64_t[bufferSize / 8]);
+      std::mt19937 rng(t);
+      std::vector<uint32_t>& lat = latencies[t];
+      lat.reserve(1 << 20);
+
+      while (!stop) {
+        Group* group = groups[rng() % groups.size()].get();
+        auto begin = std::chrono::steady_clock::now();
+        bool ok;
+
+        if (mode == Mode::kRWMutex) {
+          eos::common::RWMutexReadLock lock(group->doubleBufferMutex);
+          ok = Place(group->foreground, (char*) buffer.get());
+        } else {
+          eos::common::HazardPointer guard;
+          ok = Place(guard.Protect(group->foreground), (char*) buffer.get());
+        }
+
+        auto end = std::chrono::steady_clock::now();
+
+        if (!ok) {
+          ++errors;
+        }
+
+        lat.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>
+                      (end - begin).count());
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(durationMs));
+  stop = true;
+
+  for (auto& scheduler : schedulers) {
+    scheduler.join();
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() -
+                                          start;
+  updater.join();
+  std::vector<uint32_t> all;
+
+  for (auto& lat : latencies) {
+    all.insert(all.end(), lat.begin(), lat.end());
+  }
+
+  RunResult result {0, 0, 0, swaps, errors};
+
+  if (!all.empty()) {
+    size_t p50 = all.size() / 2;
+    size_t p99 = std::min(all.size() - 1, (all.size() * 99) / 100);
+    std::nth_element(all.begin(), all.begin() + p50, all.end());
+    result.mP50 = all[p50] / 1000.0;
+    std::nth_element(all.begin(), all.begin() + p99, all.end());
+    result.mP99 = all[p99] / 1000.0;
+    result.mRate = (nReplicas * all.size()) / elapsed.count();
+  }
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+// Usage: eosgeotreebench [threads] [duration_ms] [update_period_ms]
+//------------------------------------------------------------------------------
+int
+main(int argc, char** argv)
+{
+  unsigned int nThreads = std::max(4u, std::thread::hardware_concurrency());
+  unsigned int durationMs = 2000;
+  unsigned int updateMs = 10;
+
+  if (argc > 1) {
+    nThreads = strtoul(argv[1], 0, 10);
+  }
+
+  if (argc > 2) {
+    durationMs = strtoul(argv[2], 0, 10);
+  }
+
+  if (argc > 3) {
+    updateMs = strtoul(argv[3], 0, 10);
+  }
+
+  if (!nThreads || !durationMs) {
+    fprintf(stderr, "Usage: eosgeotreebench [threads] [duration_ms] "
+            "[update_period_ms]\n");
+    return 1;
+  }
+
+  SchedTreeBase::gSettings.checkLevel = 0;
+  SchedTreeBase::gSettings.debugLevel = 0;
+  fprintf(stdout, "%-8s %-7s %-8s %-8s %-14s %-10s %-10s %-8s %-6s\n", "fs",
+          "groups", "threads", "mode", "placements/s", "p50(us)", "p99(us)",
+          "swaps", "errors");
+  const size_t fsCounts[] = {1000, 5000, 10000, 20000};
+
+  for (size_t nFs : fsCounts) {
+    auto groups = BuildGroups(nFs);
+
+    for (Mode mode : {
+           Mode::kRWMutex, Mode::kHazardPointer
+         }) {
+      RunResult result = Run(groups, mode, nThreads, durationMs, updateMs);
+      fprintf(stdout, "%-8zu %-7zu %-8u %-8s %-14.0f %-10.2f %-10.2f %-8zu %-6zu\n",
+              nFs, groups.size(), nThreads,
+              (mode == Mode::kRWMutex) ? "rwmutex" : "hazard", result.mRate,
+              result.mP50, result.mP99, result.mSwaps, result.mErrors);
+      fflush(stdout);
+    }
+  }
+
+  return 0;
+}
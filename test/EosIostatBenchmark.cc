@@ -0,0 +1,266 @@
+//------------------------------------------------------------------------------
+// File: EosIostatBenchmark.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Replay benchmark of the iostat accounting: transfer report lines,
+//!        either recorded in an .eosreport file or generated, are fed by
+//!        several threads through the MGM ingestion path (Iostat::AddReport),
+//!        through the sharded counters alone and through the previous single
+//!        mutex nested map layout for comparison.
+//------------------------------------------------------------------------------
+
+#include "mgm/Iostat.hh"
+#include "mgm/IostatCounters.hh"
+#include "common/Report.hh"
+#include "XrdOuc/XrdOucEnv.hh"
+#include <google/sparse_hash_map>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using eos::mgm::Iostat;
+using eos::mgm::IostatAvg;
+using eos::mgm::IostatCounters;
+
+//------------------------------------------------------------------------------
+//! Previous layout: one mutex and nested maps keyed by the tag name
+//------------------------------------------------------------------------------
+class LegacyCounters
+{
+public:
+  void
+  Add(const char* tag, uid_t uid, gid_t gid, unsigned long val,
+      time_t starttime, time_t stoptime)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mUid[tag][uid] += val;
+    mGid[tag][gid] += val;
+    mAvgUid[tag][uid].Add(val, starttime, stoptime);
+    mAvgGid[tag][gid].Add(val, starttime, stoptime);
+  }
+
+  void
+  AddReport(const eos::common::Report& r)
+  {
+    Add("bytes_read", r.uid, r.gid, r.rb, r.ots, r.cts);
+    Add("bytes_read", r.uid, r.gid, r.rvb_sum, r.ots, r.cts);
+    Add("bytes_written", r.uid, r.gid, r.wb, r.ots, r.cts);
+    Add("read_calls", r.uid, r.gid, r.nrc, r.ots, r.cts);
+    Add("readv_calls", r.uid, r.gid, r.rv_op, r.ots, r.cts);
+    Add("write_calls", r.uid, r.gid, r.nwc, r.ots, r.cts);
+    Add("fwd_seeks", r.uid, r.gid, r.nfwds, r.ots, r.cts);
+    Add("bwd_seeks", r.uid, r.gid, r.nbwds, r.ots, r.cts);
+    Add("xl_fwd_seeks", r.uid, r.gid, r.nxlfwds, r.ots, r.cts);
+    Add("xl_bwd_seeks", r.uid, r.gid, r.nxlbwds, r.ots, r.cts);
+    Add("bytes_fwd_seek", r.uid, r.gid, r.sfwdb, r.ots, r.cts);
+    Add("bytes_bwd_wseek", r.uid, r.gid, r.sbwdb, r.ots, r.cts);
+    Add("bytes_xl_fwd_seek", r.uid, r.gid, r.sxlfwdb, r.ots, r.cts);
+    Add("bytes_xl_bwd_wseek", r.uid, r.gid, r.sxlbwdb, r.ots, r.cts);
+    Add("disk_time_read", r.uid, r.gid, (unsigned long long) r.rt, r.ots, r.cts);
+    Add("disk_time_write", r.uid, r.gid, (unsigned long long) r.wt, r.ots, r.cts);
+  }
+
+  unsigned long long
+  GetTotal(const char* tag)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    unsigned long long val = 0;
+
+    for (const auto& elem : mUid[tag]) {
+      val += elem.second;
+    }
+
+    return val;
+  }
+
+private:
+  std::mutex mMutex;
+  google::sparse_hash_map<std::string,
+         google::sparse_hash_map<uid_t, unsigned long long>> mUid;
+  google::sparse_hash_map<std::string,
+         google::sparse_hash_map<gid_t, unsigned long long>> mGid;
+  google::sparse_hash_map<std::string,
+         google::sparse_hash_map<uid_t, IostatAvg>> mAvgUid;
+  google::sparse_hash_map<std::string,
+         google::sparse_hash_map<gid_t, IostatAvg>> mAvgGid;
+};
+
+//------------------------------------------------------------------------------
+// Generate a report line like the ones sent by the FSTs
+//------------------------------------------------------------------------------
+std::string
+GenerateLine(unsigned int seed, time_t now)
+{
+  char line[1024];
+  unsigned int uid = 1000 + (seed * 7919) % 2000;
+  unsigned int gid = 100 + uid % 50;
+  unsigned long long rb = (seed % 3) ? (seed * 104729ull) % (1 << 30) : 0;
+  unsigned long long wb = (seed % 3) ? 0 : (seed * 15485863ull) % (1 << 30);
+  snprintf(line, sizeof(line),
+           "log=bench&path=/eos/bench/user%u/dir%u/file%u&ruid=%u&rgid=%u&"
+           "td=user.1:1@client&host=fst.cern.ch&lid=1048850&fid=%u&fsid=%u&"
+           "ots=%lu&otms=0&cts=%lu&ctms=0&nrc=%llu&nwc=%llu&rb=%llu&"
+           "rv_op=0&rvb_sum=0&wb=%llu&sfwdb=0&sbwdb=0&sxlfwdb=0&sxlbwdb=0&"
+           "nfwds=%u&nbwds=0&nxlfwds=0&nxlbwds=0&rt=%.02f&rvt=0.00&wt=%.02f&"
+           "osize=0&csize=%llu&sec.prot=krb5&sec.name=user%u&"
+           "sec.host=lxplus%u.cern.ch&sec.app=bench",
+           uid, seed % 100, seed, uid, gid, seed, seed % 500,
+           (unsigned long)(now - seed % 30), (unsigned long) now,
+           rb / 65536, wb / 65536, rb, wb, seed % 5, (seed % 1000) / 10.0,
+           (seed % 700) / 10.0, rb + wb, uid, seed % 100);
+  return line;
+}
+
+//------------------------------------------------------------------------------
+// Replay the reports with the given number of threads, returns the rate in
+// reports per second
+//------------------------------------------------------------------------------
+template <typename Counters>
+double
+Replay(Counters& counters, const std::vector<eos::common::Report>& reports,
+       unsigned int nthreads, unsigned int passes)
+{
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned int t = 0; t < nthreads; ++t) {
+    workers.emplace_back([&, t]() {
+      for (unsigned int pass = 0; pass < passes; ++pass) {
+        for (size_t i = t; i < reports.size(); i += nthreads) {
+          counters.AddReport(reports[i]);
+        }
+      }
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() -
+                                          start;
+  return (1.0 * passes * reports.size()) / elapsed.count();
+}
+
+//------------------------------------------------------------------------------
+// Usage: eosiostatbench [report_file|-] [passes]
+//
+// Without a report file (or with '-') 100k report lines are generated. The
+// timestamps of the recorded lines are shifted so that the last report ends
+// now and all of them fall into the averaging windows.
+//------------------------------------------------------------------------------
+int
+main(int argc, char** argv)
+{
+  std::vector<std::string> lines;
+  unsigned int passes = 5;
+  time_t now = time(NULL);
+
+  if ((argc > 1) && strcmp(argv[1], "-")) {
+    std::ifstream in(argv[1]);
+    std::string line;
+
+    while (std::getline(in, line)) {
+      if (line.length()) {
+        lines.push_back(line);
+      }
+    }
+
+    if (lines.empty()) {
+      fprintf(stderr, "error: no report lines in %s\n", argv[1]);
+      return 1;
+    }
+  } else {
+    for (unsigned int i = 0; i < 100000; ++i) {
+      lines.push_back(GenerateLine(i, now));
+    }
+  }
+
+  if (argc > 2) {
+    passes = strtoul(argv[2], 0, 10);
+  }
+
+  if (passes == 0) {
+    fprintf(stderr, "Usage: eosiostatbench [report_file|-] [passes]\n");
+    return 1;
+  }
+
+  std::vector<eos::common::Report> reports;
+  reports.reserve(lines.size());
+  unsigned long long max_cts = 0;
+
+  for (const auto& line : lines) {
+    XrdOucEnv env(line.c_str());
+    reports.emplace_back(env);
+    max_cts = std::max(max_cts, reports.back().cts);
+  }
+
+  unsigned long long shift = now - max_cts;
+
+  for (auto& report : reports) {
+    report.ots += shift;
+    report.cts += shift;
+  }
+
+  fprintf(stdout, "replaying %zu reports x %u passes\n", reports.size(),
+          passes);
+  fprintf(stdout, "%-8s %-8s %-14s %-14s %-8s\n", "layout", "threads",
+          "reports/s", "bytes_read", "check");
+
+  for (unsigned int nthreads = 1; nthreads <= 16; nthreads *= 4) {
+    unsigned long long legacy_total = 0;
+    {
+      std::unique_ptr<LegacyCounters> legacy(new LegacyCounters());
+      double rate = Replay(*legacy, reports, nthreads, passes);
+      legacy_total = legacy->GetTotal("bytes_read");
+      fprintf(stdout, "%-8s %-8u %-14.0f %-14llu %-8s\n", "legacy", nthreads,
+              rate, legacy_total, "-");
+    }
+    {
+      std::unique_ptr<IostatCounters> sharded(new IostatCounters());
+      double rate = Replay(*sharded, reports, nthreads, passes);
+      unsigned long long total =
+        sharded->GetSummary(IostatCounters::kBytesRead).mTotal;
+      fprintf(stdout, "%-8s %-8u %-14.0f %-14llu %-8s\n", "sharded", nthreads,
+              rate, total, (total == legacy_total) ? "ok" : "MISMATCH");
+    }
+    {
+      // Counters, popularity and domain/application accounting as done for
+      // every report received by the MGM
+      std::unique_ptr<Iostat> iostat(new Iostat());
+      double rate = Replay(*iostat, reports, nthreads, passes);
+      unsigned long long total = iostat->GetTotal("bytes_read");
+      fprintf(stdout, "%-8s %-8u %-14.0f %-14llu %-8s\n", "iostat", nthreads,
+              rate, total, (total == legacy_total) ? "ok" : "MISMATCH");
+    }
+    fflush(stdout);
+  }
+
+  return 0;
+}
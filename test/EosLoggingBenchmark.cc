@@ -0,0 +1,156 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Multithreaded benchmark comparing the synchronous and asynchronous
+//!        logging modes in terms of throughput and latency of a log call
+//------------------------------------------------------------------------------
+
+#include "common/Logging.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Run the workload with the given number of threads, every thread issues
+// msgs_per_thread info messages. Returns the rate in records per second and
+// fills in the latencies of all the log calls in nanoseconds.
+//------------------------------------------------------------------------------
+double
+RunWorkload(unsigned int nthreads, uint64_t msgs_per_thread,
+            std::vector<uint64_t>& latencies)
+{
+  std::vector<std::thread> workers;
+  std::vector<std::vector<uint64_t>> thread_lat(nthreads);
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned int t = 0; t < nthreads; ++t) {
+    workers.emplace_back([&, t]() {
+      std::vector<uint64_t>& lat = thread_lat[t];
+      lat.reserve(msgs_per_thread);
+
+      for (uint64_t i = 0; i < msgs_per_thread; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        eos_static_info("msg=\"benchmark message\" thread=%u seq=%llu path=%s",
+                        t, (unsigned long long) i, "/eos/dev/bench/file");
+        auto t1 = std::chrono::steady_clock::now();
+        lat.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>
+                      (t1 - t0).count());
+      }
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  // Asynchronous records are only done once they reach the output
+  eos::common::Logging::GetInstance().FlushAsync();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() -
+                                          start;
+  latencies.clear();
+
+  for (const auto& lat : thread_lat) {
+    latencies.insert(latencies.end(), lat.begin(), lat.end());
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  return (1.0 * nthreads * msgs_per_thread) / elapsed.count();
+}
+
+//------------------------------------------------------------------------------
+// Get percentile from sorted values
+//------------------------------------------------------------------------------
+double
+Percentile(const std::vector<uint64_t>& sorted, double pct)
+{
+  if (sorted.empty()) {
+    return 0;
+  }
+
+  size_t pos = (size_t)(pct / 100.0 * (sorted.size() - 1));
+  return sorted[pos] / 1000.0;
+}
+
+//------------------------------------------------------------------------------
+// Usage: eoslogbench [msgs_per_thread] [log_file]
+//
+// The log lines go to stderr which is redirected to log_file or /dev/null,
+// the results are printed on stdout.
+//------------------------------------------------------------------------------
+int
+main(int argc, char** argv)
+{
+  uint64_t msgs_per_thread = 20000;
+  const char* log_file = "/dev/null";
+
+  if (argc > 1) {
+    msgs_per_thread = strtoull(argv[1], 0, 10);
+  }
+
+  if (argc > 2) {
+    log_file = argv[2];
+  }
+
+  if (msgs_per_thread == 0) {
+    fprintf(stderr, "Usage: eoslogbench [msgs_per_thread] [log_file]\n");
+    return 1;
+  }
+
+  if (!freopen(log_file, "a", stderr)) {
+    fprintf(stdout, "error: failed to redirect stderr to %s\n", log_file);
+    return 1;
+  }
+
+  eos::common::Logging& g_logging = eos::common::Logging::GetInstance();
+  g_logging.SetLogPriority(LOG_INFO);
+  g_logging.SetUnit("eoslogbench");
+  std::vector<uint64_t> latencies;
+  fprintf(stdout, "%-6s %-8s %-14s %-10s %-10s %-10s %-10s %-10s\n", "mode",
+          "threads", "records/s", "p50[us]", "p99[us]", "p99.9[us]", "max[us]",
+          "dropped");
+
+  for (unsigned int nthreads = 1; nthreads <= 64; nthreads *= 4) {
+    for (bool async : {
+           false, true
+         }) {
+      g_logging.SetAsync(async);
+      uint64_t dropped = g_logging.GetAsyncStats().mDropped;
+      double rate = RunWorkload(nthreads, msgs_per_thread, latencies);
+      dropped = g_logging.GetAsyncStats().mDropped - dropped;
+      fprintf(stdout, "%-6s %-8u %-14.0f %-10.02f %-10.02f %-10.02f %-10.02f "
+              "%-10llu\n", async ? "async" : "sync", nthreads, rate,
+              Percentile(latencies, 50), Percentile(latencies, 99),
+              Percentile(latencies, 99.9), Percentile(latencies, 100),
+              (unsigned long long) dropped);
+      fflush(stdout);
+    }
+  }
+
+  g_logging.SetAsync(false);
+  eos::common::AsyncLogger::Stats stats = g_logging.GetAsyncStats();
+  fprintf(stdout, "async totals: queued=%llu written=%llu dropped=%llu "
+          "blocked=%llu\n", (unsigned long long) stats.mQueued,
+          (unsigned long long) stats.mWritten,
+          (unsigned long long) stats.mDropped,
+          (unsigned long long) stats.mBlocked);
+  return 0;
+}
@@ -0,0 +1,191 @@
+//------------------------------------------------------------------------------
+// File: EosMappingBenchmark.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/Mapping.hh"
+#include "common/Logging.hh"
+#include "XrdSec/XrdSecEntity.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using eos::common::Mapping;
+
+//------------------------------------------------------------------------------
+// Install the mapping rules used by the benchmark: physical mapping for krb5
+// and sss, forced mapping for unix, plus a realistic number of gateway and
+// alias rules which are not hit.
+//------------------------------------------------------------------------------
+void
+SetupRules()
+{
+  Mapping::RulesWriteLock lock;
+  Mapping::gVirtualUidMap["krb5:\"<pwd>\":uid"] = 0;
+  Mapping::gVirtualGidMap["krb5:\"<pwd>\":gid"] = 0;
+  Mapping::gVirtualUidMap["sss:\"<pwd>\":uid"] = 0;
+  Mapping::gVirtualGidMap["sss:\"<pwd>\":gid"] = 0;
+  Mapping::gVirtualUidMap["unix:\"<pwd>\":uid"] = 99;
+  Mapping::gVirtualGidMap["unix:\"<pwd>\":gid"] = 99;
+
+  for (int i = 0; i < 500; ++i) {
+    std::string host = "gateway" + std::to_string(i) + ".cern.ch";
+    Mapping::gVirtualUidMap["tident:\"*@" + host + "\":uid"] = 0;
+    Mapping::gVirtualGidMap["tident:\"*@" + host + "\":gid"] = 0;
+    Mapping::gVirtualUidMap["krb5:\"user" + std::to_string(i) + "\":uid"] =
+      10000 + i;
+  }
+
+  Mapping::gUserRoleVector[0] = {0, 3};
+  Mapping::gSudoerMap[0] = 1;
+}
+
+//------------------------------------------------------------------------------
+// Run the workload with the given number of threads, every thread maps
+// ops_per_thread identities of the given protocol from a set of client hosts.
+// Returns the rate in mappings per second and fills in the latencies of all
+// the calls in nanoseconds.
+//------------------------------------------------------------------------------
+double
+RunWorkload(const char* prot, const char* name, unsigned int nthreads,
+            uint64_t ops_per_thread, std::vector<uint64_t>& latencies)
+{
+  std::vector<std::thread> workers;
+  std::vector<std::vector<uint64_t>> thread_lat(nthreads);
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned int t = 0; t < nthreads; ++t) {
+    workers.emplace_back([&, t]() {
+      std::vector<uint64_t>& lat = thread_lat[t];
+      lat.reserve(ops_per_thread);
+      XrdSecEntity client(prot);
+      client.name = const_cast<char*>(name);
+      std::vector<std::string> tidents;
+
+      // Connections from 64 client hosts per thread
+      for (int i = 0; i < 64; ++i) {
+        tidents.push_back(std::string(name) + "." + std::to_string(1000 + i) +
+                          ":" + std::to_string(t) + "@client" +
+                          std::to_string(t * 64 + i) + ".cern.ch");
+      }
+
+      for (uint64_t i = 0; i < ops_per_thread; ++i) {
+        Mapping::VirtualIdentity vid;
+        const std::string& tident = tidents[i % tidents.size()];
+        client.tident = tident.c_str();
+        auto t0 = std::chrono::steady_clock::now();
+        Mapping::IdMap(&client, "eos.app=bench", tident.c_str(), vid, false);
+        auto t1 = std::chrono::steady_clock::now();
+        lat.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>
+                      (t1 - t0).count());
+      }
+
+      client.name = nullptr;
+      client.tident = nullptr;
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() -
+                                          start;
+  latencies.clear();
+
+  for (const auto& lat : thread_lat) {
+    latencies.insert(latencies.end(), lat.begin(), lat.end());
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  return (1.0 * nthreads * ops_per_thread) / elapsed.count();
+}
+
+//------------------------------------------------------------------------------
+// Get percentile from sorted values
+//------------------------------------------------------------------------------
+double
+Percentile(const std::vector<uint64_t>& sorted, double pct)
+{
+  if (sorted.empty()) {
+    return 0;
+  }
+
+  size_t pos = (size_t)(pct / 100.0 * (sorted.size() - 1));
+  return sorted[pos] / 1000.0;
+}
+
+//------------------------------------------------------------------------------
+// Usage: eosmappingbench [ops_per_thread]
+//
+// Maps krb5, sss and unix identities with 1 to 64 threads and prints the
+// mapping rate and latencies.
+//------------------------------------------------------------------------------
+int
+main(int argc, char** argv)
+{
+  uint64_t ops_per_thread = 100000;
+
+  if (argc > 1) {
+    ops_per_thread = strtoull(argv[1], 0, 10);
+  }
+
+  if (ops_per_thread == 0) {
+    fprintf(stderr, "Usage: eosmappingbench [ops_per_thread]\n");
+    return 1;
+  }
+
+  eos::common::Logging& g_logging = eos::common::Logging::GetInstance();
+  g_logging.SetLogPriority(LOG_ERR);
+  g_logging.SetUnit("eosmappingbench");
+  Mapping::Init();
+  SetupRules();
+  // The physical mapping needs names known to the password database
+  const struct {
+    const char* mProt;
+    const char* mName;
+  } identities[] = {
+    {"krb5", "root"}, {"sss", "daemon"}, {"unix", "nobody"}
+  };
+  std::vector<uint64_t> latencies;
+  fprintf(stdout, "%-6s %-8s %-14s %-10s %-10s %-10s %-10s\n", "prot",
+          "threads", "mappings/s", "p50[us]", "p99[us]", "p99.9[us]",
+          "max[us]");
+
+  for (const auto& identity : identities) {
+    for (unsigned int nthreads = 1; nthreads <= 64; nthreads *= 2) {
+      double rate = RunWorkload(identity.mProt, identity.mName, nthreads,
+                                ops_per_thread, latencies);
+      fprintf(stdout, "%-6s %-8u %-14.0f %-10.02f %-10.02f %-10.02f %-10.02f\n",
+              identity.mProt, nthreads, rate, Percentile(latencies, 50),
+              Percentile(latencies, 99), Percentile(latencies, 99.9),
+              Percentile(latencies, 100));
+      fflush(stdout);
+    }
+  }
+
+  fprintf(stdout, "active clients: %zu\n",
+          Mapping::ActiveTidents.Count(300));
+  return 0;
+}
@@ -0,0 +1,129 @@
+// ----------------------------------------------------------------------
+// File: EosXorBenchmark.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+/*-----------------------------------------------------------------------------*/
+#include "common/LayoutId.hh"
+#include "common/Logging.hh"
+#include "common/Timing.hh"
+#include "common/StringConversion.hh"
+#include "fst/layout/XorKernel.hh"
+/*-----------------------------------------------------------------------------*/
+#include <XrdOuc/XrdOucString.hh>
+/*-----------------------------------------------------------------------------*/
+#include <cstdlib>
+#include <vector>
+
+using eos::fst::XorKernel;
+
+// Amount of source data XOR-ed for every measurement
+#define XORVOLUME 4ll*1024ll*1024ll*1024ll
+
+//------------------------------------------------------------------------------
+// Benchmark the multi-source XOR kernel used for the RAID-DP parity for all
+// the supported instruction sets, stripe widths (block sizes) and number of
+// source blocks. Usage: eosxorbench [max_sources]
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  eos::common::Logging& g_logging = eos::common::Logging::GetInstance();
+  g_logging.SetUnit("eosxorbenchmark@localhost");
+  g_logging.gShortFormat = true;
+  g_logging.SetLogPriority(LOG_INFO);
+  size_t max_srcs = 16;
+
+  if (argc == 2) {
+    max_srcs = atoi(argv[1]);
+
+    if (max_srcs < 2) {
+      fprintf(stdout, "info: forcing max_sources=2\n");
+      max_srcs = 2;
+    }
+  }
+
+  std::vector<int> blocksizes {
+    eos::common::LayoutId::k4k, eos::common::LayoutId::k64k,
+    eos::common::LayoutId::k128k, eos::common::LayoutId::k512k,
+    eos::common::LayoutId::k1M, eos::common::LayoutId::k4M
+  };
+  std::vector<XorKernel::Isa> isas {
+    XorKernel::Isa::kScalar, XorKernel::Isa::kSSE2,
+    XorKernel::Isa::kAVX2, XorKernel::Isa::kAVX512
+  };
+  const unsigned long max_bs = eos::common::LayoutId::BlockSize(
+                                 eos::common::LayoutId::k4M);
+  std::vector<char*> blocks;
+
+  for (size_t i = 0; i <= max_srcs; ++i) {
+    char* ptr = (char*) malloc(max_bs);
+
+    if (!ptr) {
+      fprintf(stderr, "error: failed to allocate reference buffers!\n");
+      exit(-1);
+    }
+
+    for (unsigned long j = 0; j < max_bs; ++j) {
+      ptr[j] = random() % 256;
+    }
+
+    blocks.push_back(ptr);
+  }
+
+  eos_static_info("best instruction set: %s",
+                  XorKernel::IsaToString(XorKernel::GetBestIsa()));
+  fprintf(stdout, "%-8s %-8s %-8s %-12s\n", "isa", "width", "sources",
+          "rate[GB/s]");
+
+  for (auto isa : isas) {
+    if (!XorKernel::SetIsa(isa)) {
+      eos_static_info("instruction set %s not supported, skipping",
+                      XorKernel::IsaToString(isa));
+      continue;
+    }
+
+    for (auto bs_type : blocksizes) {
+      unsigned long bs = eos::common::LayoutId::BlockSize(bs_type);
+      XrdOucString sizestring;
+      eos::common::StringConversion::GetReadableSizeString(sizestring, bs, "B");
+
+      for (size_t nsrcs = 2; nsrcs <= max_srcs; nsrcs *= 2) {
+        size_t iterations = (XORVOLUME) / (bs * nsrcs);
+        eos::common::Timing tm("Xor");
+        COMMONTIMING("START", &tm);
+
+        for (size_t it = 0; it < iterations; ++it) {
+          XorKernel::Xor(blocks[max_srcs], blocks.data(), nsrcs, bs);
+        }
+
+        COMMONTIMING("STOP", &tm);
+        double rate = (1.0 * iterations * bs * nsrcs) / (tm.RealTime() * 1e6);
+        fprintf(stdout, "%-8s %-8s %-8zu %-12.02f\n", XorKernel::IsaToString(isa),
+                sizestring.c_str(), nsrcs, rate);
+      }
+    }
+  }
+
+  for (auto ptr : blocks) {
+    free(ptr);
+  }
+
+  return 0;
+}
@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------------
+// File: ExecutorTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/Executor.hh"
+#include "common/Parallel.hh"
+#include <set>
+#include <stdexcept>
+
+using eos::common::Executor;
+
+//------------------------------------------------------------------------------
+// Tasks and futures
+//------------------------------------------------------------------------------
+TEST(Executor, PushTask)
+{
+  Executor pool("test", 3);
+  ASSERT_EQ(3u, pool.GetSize());
+  std::vector<std::future<int>> futures;
+
+  for (int i = 0; i < 1000; ++i) {
+    futures.emplace_back(pool.PushTask<int>([i] {
+      return 2 * i;
+    }));
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(2 * i, futures[i].get());
+  }
+
+  Executor::Stats stats = pool.GetStats();
+  ASSERT_EQ(1000u, stats.mSubmitted);
+  ASSERT_EQ(0u, stats.mQueued);
+}
+
+//------------------------------------------------------------------------------
+// Tasks spawned by a busy worker are stolen by the idle ones
+//------------------------------------------------------------------------------
+TEST(Executor, Stealing)
+{
+  Executor pool("test", 4);
+  std::mutex mutex;
+  std::set<std::thread::id> ids;
+  std::promise<void> spawned;
+  pool.Add([&] {
+    for (int i = 0; i < 64; ++i) {
+      pool.Add([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        std::lock_guard<std::mutex> lock(mutex);
+        ids.insert(std::this_thread::get_id());
+      });
+    }
+
+    spawned.set_value();
+  });
+  spawned.get_future().wait();
+  pool.Stop();
+  ASSERT_EQ(64u + 1, pool.GetStats().mExecuted);
+  ASSERT_GT(pool.GetStats().mSteals, 0u);
+  ASSERT_GT(ids.size(), 1u);
+}
+
+//------------------------------------------------------------------------------
+// Higher priority tasks overtake the queued ones
+//------------------------------------------------------------------------------
+TEST(Executor, Priorities)
+{
+  Executor pool("test", 1);
+  std::promise<void> release;
+  std::shared_future<void> gate = release.get_future().share();
+  std::vector<int> order;
+  pool.Add([gate] {
+    gate.wait();
+  });
+  // Let the worker pick up the blocking task
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  pool.Add([&order] {
+    order.push_back(2);
+  }, Executor::Priority::Low);
+  pool.Add([&order] {
+    order.push_back(1);
+  }, Executor::Priority::Normal);
+  pool.Add([&order] {
+    order.push_back(0);
+  }, Executor::Priority::High);
+  release.set_value();
+  pool.Stop();
+  ASSERT_EQ((std::vector<int> {0, 1, 2}), order);
+}
+
+//------------------------------------------------------------------------------
+// Parallel loops, also nested ones and exceptions
+//------------------------------------------------------------------------------
+TEST(Executor, ParallelFor)
+{
+  Executor pool("test", 4);
+  std::vector<std::atomic<int>> hits(1001);
+
+  for (auto& hit : hits) {
+    hit = 0;
+  }
+
+  pool.ParallelFor(0, 1001, [&](int i) {
+    hits[i]++;
+  });
+
+  for (auto& hit : hits) {
+    ASSERT_EQ(1, hit.load());
+  }
+
+  std::atomic<int> sum {0};
+  pool.ParallelFor(0, 8, [&](int) {
+    pool.ParallelFor(0, 100, [&](int j) {
+      sum += j;
+    });
+  });
+  ASSERT_EQ(8 * 4950, sum.load());
+  pool.ParallelFor(5, 5, [&](int) {
+    FAIL();
+  });
+  ASSERT_THROW(pool.ParallelFor(0, 100, [](int i) {
+    if (i == 42) {
+      throw std::runtime_error("expected");
+    }
+  }), std::runtime_error);
+  std::atomic<int> count {0};
+  eos::common::Parallel::For(0, 10, [&](int) {
+    count++;
+  });
+  ASSERT_EQ(10, count.load());
+}
+
+//------------------------------------------------------------------------------
+// Parsing of the NUMA topology
+//------------------------------------------------------------------------------
+TEST(Executor, CpuList)
+{
+  ASSERT_EQ((std::vector<int> {0, 1, 2, 3, 8, 10, 11}),
+            Executor::ParseCpuList("0-3,8,10-11\n"));
+  ASSERT_TRUE(Executor::ParseCpuList("").empty());
+  ASSERT_FALSE(Executor::GetNumaTopology().empty());
+}
@@ -0,0 +1,113 @@
+//------------------------------------------------------------------------------
+// File: HazardPointerTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/HazardPointer.hh"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using eos::common::HazardPointer;
+
+//------------------------------------------------------------------------------
+// Protection follows the lifetime of the guard
+//------------------------------------------------------------------------------
+TEST(HazardPointer, ProtectReset)
+{
+  int values[2] = {1, 2};
+  int* published = &values[0];
+  {
+    HazardPointer guard;
+    ASSERT_EQ(&values[0], guard.Protect(published));
+    ASSERT_TRUE(HazardPointer::IsProtected(&values[0]));
+    HazardPointer::Publish(published, &values[1]);
+    // the previous object stays protected until the guard is reset
+    ASSERT_TRUE(HazardPointer::IsProtected(&values[0]));
+    guard.Reset();
+    ASSERT_FALSE(HazardPointer::IsProtected(&values[0]));
+    ASSERT_EQ(&values[1], guard.Protect(published));
+  }
+  ASSERT_FALSE(HazardPointer::IsProtected(&values[1]));
+  // many guards in the same thread need more than one record
+  std::vector<HazardPointer> guards;
+
+  for (int i = 0; i < 20; ++i) {
+    guards.emplace_back();
+    guards.back().Protect(published);
+  }
+
+  ASSERT_TRUE(HazardPointer::IsProtected(&values[1]));
+  guards.clear();
+  ASSERT_FALSE(HazardPointer::IsProtected(&values[1]));
+}
+
+//------------------------------------------------------------------------------
+// Double buffering: the writer only modifies the buffer no reader can see
+//------------------------------------------------------------------------------
+TEST(HazardPointer, DoubleBuffering)
+{
+  struct Buffer {
+    std::atomic<uint64_t> mA;
+    std::atomic<uint64_t> mB;
+  };
+  Buffer buffers[2];
+  buffers[0].mA = buffers[0].mB = 0;
+  buffers[1].mA = buffers[1].mB = 0;
+  Buffer* foreground = &buffers[0];
+  Buffer* background = &buffers[1];
+  std::atomic<bool> stop(false);
+  std::atomic<uint64_t> errors(0);
+  std::vector<std::thread> readers;
+
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&]() {
+      while (!stop) {
+        HazardPointer guard;
+        Buffer* buffer = guard.Protect(foreground);
+        uint64_t a = buffer->mA.load();
+        std::this_thread::yield();
+
+        if (buffer->mB.load() != a) {
+          ++errors;
+        }
+      }
+    });
+  }
+
+  for (uint64_t gen = 1; gen <= 2000; ++gen) {
+    // a torn update of the background would be seen by a reader as mA != mB
+    background->mA = gen;
+    background->mB = gen;
+    Buffer* previous = foreground;
+    HazardPointer::Publish(foreground, background);
+    HazardPointer::WaitUntilUnprotected(previous);
+    background = previous;
+  }
+
+  stop = true;
+
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  ASSERT_EQ(0u, errors.load());
+}
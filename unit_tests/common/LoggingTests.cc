@@ -42,4 +42,34 @@ TEST(Logging, Log)
   function_using_logging();
 }
 
+TEST(Logging, AsyncLog)
+{
+  using namespace eos::common;
+  Logging& g_logging = Logging::GetInstance();
+  g_logging.SetLogPriority(LOG_INFO);
+  g_logging.SetAsync(true);
+  ASSERT_TRUE(g_logging.IsAsync());
+  unsigned long index = 0;
+  {
+    XrdSysMutexHelper scope_lock(g_logging.gMutex);
+    index = g_logging.gLogCircularIndex[LOG_ERR];
+  }
+  AsyncLogger::Stats before = g_logging.GetAsyncStats();
+  std::string ret = eos_static_err("msg=\"async test line\" value=%d", 42);
+  ASSERT_NE(std::string::npos, ret.find("msg=\"async test line\" value=42"));
+  g_logging.FlushAsync();
+  AsyncLogger::Stats after = g_logging.GetAsyncStats();
+  ASSERT_EQ(before.mQueued + 1, after.mQueued);
+  ASSERT_EQ(after.mQueued, after.mWritten);
+  {
+    // Message must be visible in the in-memory log once flushed
+    XrdSysMutexHelper scope_lock(g_logging.gMutex);
+    ASSERT_EQ(index + 1, g_logging.gLogCircularIndex[LOG_ERR]);
+    ASSERT_STREQ(ret.c_str(), g_logging.gLogMemory[LOG_ERR][index %
+                 g_logging.gCircularIndexSize].c_str());
+  }
+  g_logging.SetAsync(false);
+  ASSERT_FALSE(g_logging.IsAsync());
+}
+
 EOSCOMMONTESTING_END
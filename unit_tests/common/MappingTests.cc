@@ -24,6 +24,8 @@
 #include "gtest/gtest.h"
 #include "Namespace.hh"
 #include "common/Mapping.hh"
+#include <algorithm>
+#include <thread>
 
 EOSCOMMONTESTING_BEGIN
 
@@ -78,4 +80,48 @@ TEST(Mapping, VidAssignOperator)
   ASSERT_TRUE(vid.sudoer == copy_vid.sudoer);
 }
 
+//------------------------------------------------------------------------------
+// Active client table keeps one slot per client and reuses idle slots
+//------------------------------------------------------------------------------
+TEST(Mapping, ActiveTidentTable)
+{
+  using namespace eos::common;
+  Mapping::ActiveTidentTable table(64, 300);
+  time_t now = time(NULL);
+  std::vector<std::pair<std::string, time_t>> entries;
+  table.Touch("0^root@host1^sss^host1^", now - 100);
+  table.Touch("0^root@host1^sss^host1^", now - 10);
+  table.Touch("99^nobody@host2^unix^host2^", now - 1000);
+  ASSERT_EQ(1u, table.Count(300));
+  ASSERT_EQ(2u, table.Count(2000));
+  table.Collect(300, entries);
+  ASSERT_EQ(1u, entries.size());
+  ASSERT_EQ("0^root@host1^sss^host1^", entries[0].first);
+  ASSERT_EQ(now - 10, entries[0].second);
+  // Fill the table, the idle client makes room for a new one
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&table, now, t]() {
+      for (int i = 0; i < 1000; ++i) {
+        table.Touch(std::to_string(t * 1000 + i % 63), now);
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_LE(table.Count(300), 64u);
+  entries.clear();
+  table.Collect(300, entries);
+  std::sort(entries.begin(), entries.end());
+  ASSERT_TRUE(std::adjacent_find(entries.begin(), entries.end()) ==
+              entries.end());
+  ASSERT_EQ(0u, table.Count(2000) - table.Count(300));
+  table.Clear();
+  ASSERT_EQ(0u, table.Count(2000));
+}
+
 EOSCOMMONTESTING_END
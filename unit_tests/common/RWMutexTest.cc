@@ -130,3 +130,130 @@ TEST(RWMutex, MultiWrLockTest)
   ASSERT_NO_THROW(mutex.UnLockWrite());
   t.join();
 }
+
+//------------------------------------------------------------------------------
+// Latency histogram buckets and percentiles
+//------------------------------------------------------------------------------
+TEST(RWMutexProfiler, HistogramTest)
+{
+  using eos::common::LatencyHistogram;
+
+  for (uint64_t val : {0ull, 1ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull}) {
+    uint32_t index = LatencyHistogram::GetBucketIndex(val);
+    ASSERT_LE(val, LatencyHistogram::GetBucketUpperBound(index));
+
+    if (index) {
+      ASSERT_GT(val, LatencyHistogram::GetBucketUpperBound(index - 1));
+    }
+  }
+
+  ASSERT_EQ(LatencyHistogram::sNumBuckets - 1,
+            LatencyHistogram::GetBucketIndex(UINT64_MAX));
+  LatencyHistogram histo;
+  ASSERT_EQ(0ull, histo.GetPercentile(0.5));
+
+  for (uint64_t val = 1; val <= 1000; ++val) {
+    histo.Record(val * 1000);
+  }
+
+  ASSERT_EQ(1000ull, histo.GetCount());
+  ASSERT_EQ(1000000ull, histo.GetMax());
+  // Relative error bounded by the sub-bucket width
+  ASSERT_NEAR(500000.0, histo.GetPercentile(0.5), 500000.0 / 16);
+  ASSERT_NEAR(990000.0, histo.GetPercentile(0.99), 990000.0 / 16);
+  ASSERT_EQ(1000000ull, histo.GetPercentile(1.0));
+  histo.Reset();
+  ASSERT_EQ(0ull, histo.GetCount());
+}
+
+//------------------------------------------------------------------------------
+// Call sites and longest holders recorded by the profiler
+//------------------------------------------------------------------------------
+TEST(RWMutexProfiler, CallSiteTest)
+{
+  using eos::common::RWMutexProfiler;
+  eos::common::RWMutex mutex;
+  mutex.SetDebugName("profiled");
+  RWMutexProfiler::Reset();
+  RWMutexProfiler::SetSamplingRate(1.0);
+  RWMutexProfiler::SetEnabled(true);
+  int wr_line = __LINE__ + 2;
+  {
+    eos::common::RWMutexWriteLock wr_lock(mutex);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  int rd_line = __LINE__ + 3;
+
+  for (int i = 0; i < 10; ++i) {
+    eos::common::RWMutexReadLock rd_lock(mutex);
+  }
+
+  RWMutexProfiler::SetEnabled(false);
+  {
+    // Not recorded once disabled
+    eos::common::RWMutexWriteLock wr_lock(mutex);
+  }
+  const eos::common::RWMutexCallSite* wr_site = nullptr;
+  const eos::common::RWMutexCallSite* rd_site = nullptr;
+
+  for (const auto* site : RWMutexProfiler::GetCallSites()) {
+    if (site->mMutex != "profiled") {
+      continue;
+    }
+
+    if (site->mWrite) {
+      ASSERT_EQ(wr_line, site->mLine);
+      wr_site = site;
+    } else {
+      ASSERT_EQ(rd_line, site->mLine);
+      rd_site = site;
+    }
+  }
+
+  ASSERT_TRUE(wr_site != nullptr);
+  ASSERT_TRUE(rd_site != nullptr);
+  ASSERT_EQ(1ull, wr_site->mHold.GetCount());
+  ASSERT_GE(wr_site->mHold.GetMax(), 20000000ull);
+  ASSERT_EQ(10ull, rd_site->mWait.GetCount());
+  ASSERT_EQ(10ull, rd_site->mHold.GetCount());
+  auto top = RWMutexProfiler::GetTopHolders();
+  ASSERT_FALSE(top.empty());
+  ASSERT_EQ("profiled", top[0].mMutex);
+  ASSERT_EQ(wr_line, top[0].mLine);
+  ASSERT_TRUE(top[0].mWrite);
+  RWMutexProfiler::Reset();
+  ASSERT_EQ(0ull, wr_site->mHold.GetCount());
+  ASSERT_TRUE(RWMutexProfiler::GetTopHolders().empty());
+}
+
+//------------------------------------------------------------------------------
+// Write lock released by a different thread than the one which acquired it
+//------------------------------------------------------------------------------
+TEST(RWMutexProfiler, CrossThreadWriteReleaseTest)
+{
+  using eos::common::RWMutexProfiler;
+  eos::common::RWMutex mutex;
+  mutex.SetDebugName("cross_thread");
+  RWMutexProfiler::Reset();
+  RWMutexProfiler::SetSamplingRate(1.0);
+  RWMutexProfiler::SetEnabled(true);
+  mutex.LockWrite();
+  std::thread releaser([&mutex]() {
+    mutex.UnLockWrite();
+  });
+  releaser.join();
+  // The acquiring thread holds no sampled lock anymore
+  mutex.LockWrite();
+  mutex.UnLockWrite();
+  RWMutexProfiler::SetEnabled(false);
+  uint64_t num_holds = 0;
+
+  for (const auto* site : RWMutexProfiler::GetCallSites()) {
+    if ((site->mMutex == "cross_thread") && site->mWrite) {
+      num_holds += site->mHold.GetCount();
+    }
+  }
+
+  ASSERT_EQ(2ull, num_holds);
+  RWMutexProfiler::Reset();
+}
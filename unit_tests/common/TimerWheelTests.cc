@@ -0,0 +1,83 @@
+//------------------------------------------------------------------------------
+// File: TimerWheelTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/TimerWheel.hh"
+#include <algorithm>
+#include <string>
+
+using eos::common::TimerWheel;
+
+//------------------------------------------------------------------------------
+// Items expire once their deadline passed, in any slot
+//------------------------------------------------------------------------------
+TEST(TimerWheel, Expiry)
+{
+  TimerWheel<std::string> wheel(16, 1000);
+  std::vector<std::string> expired;
+  wheel.Insert(1005, "a");
+  wheel.Insert(1005, "b");
+  wheel.Insert(1010, "c");
+  ASSERT_EQ(3u, wheel.Size());
+  ASSERT_EQ(0u, wheel.Advance(1004, expired));
+  ASSERT_EQ(2u, wheel.Advance(1005, expired));
+  std::sort(expired.begin(), expired.end());
+  ASSERT_EQ((std::vector<std::string> {"a", "b"}), expired);
+  // Going back in time is a no-op
+  ASSERT_EQ(0u, wheel.Advance(1003, expired));
+  expired.clear();
+  ASSERT_EQ(1u, wheel.Advance(1020, expired));
+  ASSERT_EQ("c", expired[0]);
+  ASSERT_EQ(0u, wheel.Size());
+}
+
+//------------------------------------------------------------------------------
+// Deadlines beyond one turn and overdue inserts
+//------------------------------------------------------------------------------
+TEST(TimerWheel, Turns)
+{
+  TimerWheel<int> wheel(8, 100);
+  std::vector<int> expired;
+  // Same slot as 103, but three turns later
+  wheel.Insert(127, 1);
+  wheel.Insert(103, 2);
+  ASSERT_EQ(1u, wheel.Advance(104, expired));
+  ASSERT_EQ(2, expired[0]);
+  expired.clear();
+  ASSERT_EQ(0u, wheel.Advance(120, expired));
+  ASSERT_EQ(1u, wheel.Advance(127, expired));
+  ASSERT_EQ(1, expired[0]);
+  // Overdue items expire on the next advance
+  expired.clear();
+  wheel.Insert(50, 3);
+  ASSERT_EQ(1u, wheel.Advance(128, expired));
+  ASSERT_EQ(3, expired[0]);
+  // A jump longer than a turn visits every slot once
+  expired.clear();
+
+  for (int i = 0; i < 100; ++i) {
+    wheel.Insert(130 + i, i);
+  }
+
+  ASSERT_EQ(100u, wheel.Advance(1000, expired));
+  ASSERT_EQ(0u, wheel.Size());
+}
@@ -0,0 +1,66 @@
+//------------------------------------------------------------------------------
+// File: TtlCacheTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/TtlCache.hh"
+#include <string>
+
+using eos::common::TtlCache;
+
+//------------------------------------------------------------------------------
+// Entries expire a fixed time after they were stored
+//------------------------------------------------------------------------------
+TEST(TtlCache, Expiry)
+{
+  TtlCache<std::string, int> cache(10);
+  int value = 0;
+  ASSERT_FALSE(cache.Get("a", value, 1000));
+  cache.Store("a", 1, 1000);
+  cache.Store("b", 2, 1005);
+  ASSERT_TRUE(cache.Get("a", value, 1009));
+  ASSERT_EQ(1, value);
+  ASSERT_FALSE(cache.Get("a", value, 1010));
+  ASSERT_EQ(1u, cache.Size());
+  // Replacing an entry renews it
+  cache.Store("b", 3, 1010);
+  ASSERT_TRUE(cache.Get("b", value, 1019));
+  ASSERT_EQ(3, value);
+  cache.Clear();
+  ASSERT_FALSE(cache.Get("b", value, 1011));
+}
+
+//------------------------------------------------------------------------------
+// The number of entries stays bounded
+//------------------------------------------------------------------------------
+TEST(TtlCache, Capacity)
+{
+  TtlCache<uint64_t, uint64_t> cache(3600, 64, 4);
+
+  for (uint64_t i = 0; i < 1000; ++i) {
+    cache.Store(i, i * 2, 1000);
+  }
+
+  ASSERT_LE(cache.Size(), 64u);
+  uint64_t value = 0;
+  ASSERT_TRUE(cache.Get(999, value, 1000));
+  ASSERT_EQ(1998u, value);
+}
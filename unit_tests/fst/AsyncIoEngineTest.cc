@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------------
+// File: AsyncIoEngineTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/io/AsyncIoEngine.hh"
+#include "fst/utils/CompletionSequencer.hh"
+#include "gtest/gtest.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <future>
+
+using eos::fst::AsyncIoEngine;
+
+//------------------------------------------------------------------------------
+// Write blocks with a known pattern and read them back with both backends
+//------------------------------------------------------------------------------
+static void
+RoundTrip(bool use_uring)
+{
+  char path[] = "/tmp/eos.aio.XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  unlink(path);
+  const size_t nblocks = 256;
+  const size_t blk_size = 4096;
+  std::vector<char> data(nblocks * blk_size);
+
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i / blk_size + i);
+  }
+
+  std::vector<char> copy(data.size());
+  std::atomic<size_t> read {0};
+  {
+    // Depth 4 so that most of the requests have to wait for a slot
+    AsyncIoEngine engine("test", 4, use_uring);
+    std::atomic<size_t> written {0};
+    std::atomic<size_t> done {0};
+    std::promise<void> all_written;
+
+    for (size_t i = 0; i < nblocks; ++i) {
+      engine.Write(fd, data.data() + i * blk_size, blk_size, i * blk_size,
+      [&](ssize_t rc) {
+        if (rc == 4096) {
+          written++;
+        }
+
+        if (++done == nblocks) {
+          all_written.set_value();
+        }
+      });
+    }
+
+    all_written.get_future().wait();
+    ASSERT_EQ(nblocks, written.load());
+    std::promise<ssize_t> eof;
+
+    for (size_t i = 0; i < nblocks; ++i) {
+      engine.Read(fd, copy.data() + i * blk_size, blk_size, i * blk_size,
+      [&read](ssize_t rc) {
+        if (rc == 4096) {
+          read++;
+        }
+      });
+    }
+
+    // Short read at the end of the file
+    char tail[2 * blk_size];
+    engine.Read(fd, tail, sizeof(tail), (nblocks - 1) * blk_size,
+    [&eof](ssize_t rc) {
+      eof.set_value(rc);
+    });
+    ASSERT_EQ((ssize_t) blk_size, eof.get_future().get());
+    AsyncIoEngine::Stats stats = engine.GetStats();
+    ASSERT_EQ(4u, stats.mDepth);
+    ASSERT_LE(stats.mInFlight, 4u);
+    // The destructor waits for the outstanding reads
+  }
+  ASSERT_EQ(nblocks, read.load());
+  ASSERT_TRUE(data == copy);
+  // Errors are reported as -errno
+  AsyncIoEngine engine("test", 1, use_uring);
+  std::promise<ssize_t> failed;
+  char buffer[16];
+  engine.Read(-1, buffer, sizeof(buffer), 0, [&failed](ssize_t rc) {
+    failed.set_value(rc);
+  });
+  ASSERT_EQ(-EBADF, failed.get_future().get());
+  close(fd);
+}
+
+TEST(AsyncIoEngine, Threads)
+{
+  AsyncIoEngine engine("test", 2, false);
+  ASSERT_TRUE(engine.GetBackend() == AsyncIoEngine::Backend::Threads);
+  RoundTrip(false);
+}
+
+TEST(AsyncIoEngine, IoUring)
+{
+  if (!AsyncIoEngine::IoUringAvailable()) {
+    std::cerr << "[ SKIPPED  ] io_uring not available" << std::endl;
+    return;
+  }
+
+  AsyncIoEngine engine("test", 2, true);
+  ASSERT_TRUE(engine.GetBackend() == AsyncIoEngine::Backend::IoUring);
+  RoundTrip(true);
+}
+
+//------------------------------------------------------------------------------
+// Completion handlers run in ticket order, whatever the completion order
+//------------------------------------------------------------------------------
+TEST(CompletionSequencer, Order)
+{
+  eos::fst::CompletionSequencer sequencer;
+  std::vector<uint64_t> tickets;
+  std::vector<int> order;
+
+  for (int i = 0; i < 4; ++i) {
+    tickets.push_back(sequencer.Next());
+  }
+
+  ASSERT_EQ(4u, sequencer.GetPending());
+  sequencer.Complete(tickets[2], [&order]() {
+    order.push_back(2);
+  });
+  sequencer.Complete(tickets[1], [&order]() {
+    order.push_back(1);
+  });
+  ASSERT_TRUE(order.empty());
+  sequencer.Complete(tickets[0], [&order]() {
+    order.push_back(0);
+  });
+  ASSERT_EQ((std::vector<int> {0, 1, 2}), order);
+  std::thread last([&]() {
+    sequencer.Complete(tickets[3], nullptr);
+  });
+  sequencer.WaitAll();
+  last.join();
+  ASSERT_EQ(0u, sequencer.GetPending());
+}
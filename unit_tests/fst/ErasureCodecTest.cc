@@ -0,0 +1,201 @@
+//------------------------------------------------------------------------------
+// File: ErasureCodecTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "fst/layout/ErasureCodec.hh"
+#include "fst/layout/XorKernel.hh"
+#include "fst/layout/jerasure/include/jerasure.h"
+#include "fst/layout/jerasure/include/cauchy.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using eos::fst::ErasureCodec;
+using eos::fst::XorKernel;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Encode random data, erase every combination of up to m blocks and check
+// that decoding brings back the original contents
+//------------------------------------------------------------------------------
+void CheckRoundTrip(ErasureCodec::Type type, unsigned int k, unsigned int m,
+                    size_t bs)
+{
+  auto codec = ErasureCodec::Get(type, k, m, bs);
+  ASSERT_TRUE(codec != nullptr);
+  std::vector<std::vector<char>> blocks(k + m, std::vector<char>(bs));
+  std::vector<char*> data, coding;
+
+  for (unsigned int i = 0; i < k + m; ++i) {
+    for (auto& c : blocks[i]) {
+      c = random() % 256;
+    }
+
+    if (i < k) {
+      data.push_back(blocks[i].data());
+    } else {
+      coding.push_back(blocks[i].data());
+    }
+  }
+
+  ASSERT_TRUE(codec->Encode(data.data(), coding.data(), bs));
+  auto orig = blocks;
+
+  for (unsigned int mask = 1; mask < (1u << (k + m)); ++mask) {
+    std::set<unsigned int> erasures;
+
+    for (unsigned int i = 0; i < k + m; ++i) {
+      if (mask & (1u << i)) {
+        erasures.insert(i);
+      }
+    }
+
+    if (erasures.size() > m) {
+      continue;
+    }
+
+    for (auto id : erasures) {
+      memset(blocks[id].data(), 0, bs);
+    }
+
+    ASSERT_TRUE(codec->Decode(erasures, data.data(), coding.data(), bs));
+    ASSERT_TRUE(blocks == orig);
+  }
+
+  // Too many erasures must fail
+  std::set<unsigned int> too_many;
+
+  for (unsigned int i = 0; i <= m; ++i) {
+    too_many.insert(i);
+  }
+
+  ASSERT_FALSE(codec->Decode(too_many, data.data(), coding.data(), bs));
+}
+}
+
+TEST(ErasureCodec, JerasureRoundTrip)
+{
+  CheckRoundTrip(ErasureCodec::Type::kJerasureCauchy, 4, 2, 64 * 1024);
+  CheckRoundTrip(ErasureCodec::Type::kJerasureCauchy, 6, 3, 64 * 1024);
+}
+
+TEST(ErasureCodec, GfSplitRoundTrip)
+{
+  CheckRoundTrip(ErasureCodec::Type::kGfSplit, 4, 2, 64 * 1024);
+  CheckRoundTrip(ErasureCodec::Type::kGfSplit, 6, 3, 64 * 1024 + 7);
+}
+
+TEST(ErasureCodec, JerasureOnDiskCompatible)
+{
+  // The codec must produce the same parity as the original ReedSLayout code
+  const unsigned int k = 8, m = 3;
+  const size_t bs = 128 * 1024;
+  auto codec = ErasureCodec::Get(ErasureCodec::Type::kJerasureCauchy, k, m, bs);
+  ASSERT_TRUE(codec != nullptr);
+  std::vector<std::vector<char>> blocks(k + 2 * m, std::vector<char>(bs));
+  std::vector<char*> data, coding, legacy;
+
+  for (unsigned int i = 0; i < k; ++i) {
+    for (auto& c : blocks[i]) {
+      c = random() % 256;
+    }
+
+    data.push_back(blocks[i].data());
+  }
+
+  for (unsigned int i = 0; i < m; ++i) {
+    coding.push_back(blocks[k + i].data());
+    legacy.push_back(blocks[k + m + i].data());
+  }
+
+  ASSERT_TRUE(codec->Encode(data.data(), coding.data(), bs));
+  int* matrix = cauchy_good_general_coding_matrix(k, m, 8);
+  int* bitmatrix = jerasure_matrix_to_bitmatrix(k, m, 8, matrix);
+  int** schedule = jerasure_smart_bitmatrix_to_schedule(k, m, 8, bitmatrix);
+  jerasure_schedule_encode(k, m, 8, schedule, data.data(), legacy.data(), bs,
+                           bs / (8 * sizeof(int)));
+  jerasure_free_schedule(schedule);
+  free(bitmatrix);
+  free(matrix);
+
+  for (unsigned int i = 0; i < m; ++i) {
+    ASSERT_TRUE(blocks[k + i] == blocks[k + m + i]);
+  }
+}
+
+TEST(ErasureCodec, DecodeCacheReuse)
+{
+  auto codec = ErasureCodec::Get(ErasureCodec::Type::kGfSplit, 10, 4, 4096);
+  ASSERT_TRUE(codec != nullptr);
+  std::vector<std::vector<char>> blocks(14, std::vector<char>(4096, 'a'));
+  std::vector<char*> data, coding;
+
+  for (unsigned int i = 0; i < 14; ++i) {
+    (i < 10 ? data : coding).push_back(blocks[i].data());
+  }
+
+  uint64_t hits_before, misses_before, hits, misses;
+  codec->GetDecodeCacheStats(hits_before, misses_before);
+  std::set<unsigned int> erasures {1, 5, 11};
+
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(codec->Decode(erasures, data.data(), coding.data(), 4096));
+  }
+
+  codec->GetDecodeCacheStats(hits, misses);
+  ASSERT_EQ(misses_before + 1, misses);
+  ASSERT_EQ(hits_before + 9, hits);
+}
+
+TEST(XorKernel, AllInstructionSets)
+{
+  const size_t len = 64 * 1024 + 13;
+  std::vector<std::vector<char>> blocks(7, std::vector<char>(len));
+  std::vector<const char*> srcs;
+  std::vector<char> expected(len, 0), result(len);
+
+  for (auto& block : blocks) {
+    for (size_t i = 0; i < len; ++i) {
+      block[i] = random() % 256;
+      expected[i] ^= block[i];
+    }
+
+    srcs.push_back(block.data());
+  }
+
+  auto best = XorKernel::GetBestIsa();
+
+  for (auto isa : {
+         XorKernel::Isa::kScalar, XorKernel::Isa::kSSE2,
+         XorKernel::Isa::kAVX2, XorKernel::Isa::kAVX512
+       }) {
+    if (!XorKernel::SetIsa(isa)) {
+      continue;
+    }
+
+    XorKernel::Xor(result.data(), srcs.data(), srcs.size(), len);
+    ASSERT_TRUE(result == expected) << XorKernel::IsaToString(isa);
+  }
+
+  ASSERT_TRUE(XorKernel::SetIsa(best));
+}
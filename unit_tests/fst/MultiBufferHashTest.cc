@@ -0,0 +1,164 @@
+//------------------------------------------------------------------------------
+// File: MultiBufferHashTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/checksum/MultiBufferHash.hh"
+#include "fst/checksum/MD5.hh"
+#include "fst/checksum/SHA1.hh"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using eos::fst::MultiBufferHash;
+
+//------------------------------------------------------------------------------
+// Digest of a buffer computed by the single stream checksum used by the scanner
+//------------------------------------------------------------------------------
+static std::string
+SingleStreamDigest(MultiBufferHash::Type type, const std::string& data)
+{
+  std::unique_ptr<eos::fst::CheckSum> xs;
+
+  if (type == MultiBufferHash::Type::kMD5) {
+    xs.reset(new eos::fst::MD5());
+  } else {
+    xs.reset(new eos::fst::SHA1());
+  }
+
+  xs->Add(data.c_str(), data.length(), 0);
+  xs->Finalize();
+  int len = 0;
+  const char* digest = xs->GetBinChecksum(len);
+  return std::string(digest, len);
+}
+
+//------------------------------------------------------------------------------
+// Stream lengths around the block and padding boundaries
+//------------------------------------------------------------------------------
+static std::vector<std::string>
+MakeStreams()
+{
+  const size_t lengths[MultiBufferHash::sLanes] = {
+    0, 1, 55, 56, 64, 1000, 4096 + 7, 65536
+  };
+  std::vector<std::string> streams;
+  unsigned int seed = 12345;
+
+  for (size_t len : lengths) {
+    std::string data(len, '\0');
+
+    for (auto& c : data) {
+      seed = seed * 1103515245 + 12345;
+      c = (char)(seed >> 16);
+    }
+
+    streams.push_back(data);
+  }
+
+  return streams;
+}
+
+class MultiBufferHashTest :
+  public ::testing::TestWithParam<MultiBufferHash::Type>
+{
+};
+
+//------------------------------------------------------------------------------
+// All the lanes fed together in chunks of unequal sizes
+//------------------------------------------------------------------------------
+TEST_P(MultiBufferHashTest, LanesMatchSingleStream)
+{
+  MultiBufferHash::Type type = GetParam();
+  std::vector<std::string> streams = MakeStreams();
+  MultiBufferHash hash(type);
+  size_t offsets[MultiBufferHash::sLanes] = {0};
+
+  for (size_t lane = 0; lane < MultiBufferHash::sLanes; ++lane) {
+    hash.Reset(lane);
+  }
+
+  for (size_t round = 0; ; ++round) {
+    const char* buffers[MultiBufferHash::sLanes] = {nullptr};
+    size_t lengths[MultiBufferHash::sLanes] = {0};
+    bool active = false;
+
+    for (size_t lane = 0; lane < MultiBufferHash::sLanes; ++lane) {
+      size_t left = streams[lane].length() - offsets[lane];
+
+      if (!left) {
+        continue;
+      }
+
+      // chunks not aligned to the block size, sometimes skipping a lane
+      size_t chunk = ((round + lane) % 3) ? 4096 + 13 * lane + round : 0;
+      chunk = std::min(chunk, left);
+      buffers[lane] = streams[lane].c_str() + offsets[lane];
+      lengths[lane] = chunk;
+      offsets[lane] += chunk;
+      active = true;
+    }
+
+    if (!active) {
+      break;
+    }
+
+    hash.Update(buffers, lengths);
+  }
+
+  for (size_t lane = 0; lane < MultiBufferHash::sLanes; ++lane) {
+    unsigned char digest[MultiBufferHash::sMaxDigestLen];
+    hash.Final(lane, digest);
+    ASSERT_EQ(SingleStreamDigest(type, streams[lane]),
+              std::string((char*) digest, hash.GetDigestLen()))
+        << "lane=" << lane << " length=" << streams[lane].length();
+  }
+}
+
+//------------------------------------------------------------------------------
+// A lane fed on its own and reused after a reset
+//------------------------------------------------------------------------------
+TEST_P(MultiBufferHashTest, SingleLaneMatchesSingleStream)
+{
+  MultiBufferHash::Type type = GetParam();
+  std::vector<std::string> streams = MakeStreams();
+  MultiBufferHash hash(type);
+
+  for (const auto& data : streams) {
+    unsigned char digest[MultiBufferHash::sMaxDigestLen];
+    hash.Reset(3);
+
+    for (size_t off = 0; off < data.length(); off += 777) {
+      hash.Update(3, data.c_str() + off, std::min((size_t) 777,
+                  data.length() - off));
+    }
+
+    hash.Final(3, digest);
+    ASSERT_EQ(SingleStreamDigest(type, data),
+              std::string((char*) digest, hash.GetDigestLen()))
+        << "length=" << data.length();
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(MultiBufferHash, MultiBufferHashTest,
+                        ::testing::Values(MultiBufferHash::Type::kMD5,
+                            MultiBufferHash::Type::kSHA1));
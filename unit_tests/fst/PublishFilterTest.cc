@@ -0,0 +1,109 @@
+//------------------------------------------------------------------------------
+// File: PublishFilterTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/storage/PublishFilter.hh"
+#include "gtest/gtest.h"
+
+using eos::fst::PublishFilter;
+
+TEST(PublishFilter, FirstPublishAll)
+{
+  PublishFilter filter(0.01, std::chrono::seconds(300));
+  std::map<std::string, std::string> values {
+    {"stat.boot", "booted"}, {"stat.ropen", "3"}
+  };
+  ASSERT_EQ(filter.Filter("/fs1", values), values);
+  // nothing changed
+  ASSERT_TRUE(filter.Filter("/fs1", values).empty());
+  // other subjects are independent
+  ASSERT_EQ(filter.Filter("/fs2", values), values);
+  ASSERT_EQ(filter.GetSuppressed(), 2u);
+}
+
+TEST(PublishFilter, Threshold)
+{
+  PublishFilter filter(0.01, std::chrono::seconds(300));
+  PublishFilter::Clock::time_point now = PublishFilter::Clock::now();
+  filter.Filter("/fs1", {{"stat.disk.readratemb", "1000000"}, {"stat.ropen", "0"}},
+                now);
+  // below 1%: suppressed, small counters always get through
+  auto out = filter.Filter("/fs1", {{"stat.disk.readratemb", "995000"},
+    {"stat.ropen", "1"}
+  }, now);
+  ASSERT_EQ(out.size(), 1u);
+  ASSERT_EQ(out["stat.ropen"], "1");
+  // the drift from the value last published adds up
+  out = filter.Filter("/fs1", {{"stat.disk.readratemb", "989000"},
+    {"stat.ropen", "1"}
+  }, now);
+  ASSERT_EQ(out.size(), 1u);
+  ASSERT_EQ(out["stat.disk.readratemb"], "989000");
+  // strings are published on any change
+  ASSERT_EQ(filter.Filter("/fs1", {{"stat.boot", "booting"}}, now).size(), 1u);
+  ASSERT_EQ(filter.Filter("/fs1", {{"stat.boot", "booted"}}, now).size(), 1u);
+}
+
+TEST(PublishFilter, ExactKeys)
+{
+  PublishFilter filter(0.01, std::chrono::seconds(300));
+  filter.AddExactKey("stat.statfs.freebytes");
+  PublishFilter::Clock::time_point now = PublishFilter::Clock::now();
+  filter.Filter("/fs1", {{"stat.statfs.freebytes", "10000000000000"}}, now);
+  // far below the threshold, but still published
+  auto out = filter.Filter("/fs1", {{"stat.statfs.freebytes", "9999000000000"}},
+                           now);
+  ASSERT_EQ(out.size(), 1u);
+  ASSERT_TRUE(filter.Filter("/fs1", {{"stat.statfs.freebytes", "9999000000000"}},
+                            now).empty());
+}
+
+TEST(PublishFilter, AlwaysAndRefresh)
+{
+  PublishFilter filter(0.01, std::chrono::seconds(60));
+  filter.AddAlwaysKey("stat.publishtimestamp");
+  PublishFilter::Clock::time_point now = PublishFilter::Clock::now();
+  std::map<std::string, std::string> values {
+    {"stat.publishtimestamp", "1000"}, {"stat.disk.load", "0.5"}
+  };
+  filter.Filter("/fs1", values, now);
+  auto out = filter.Filter("/fs1", values, now + std::chrono::seconds(10));
+  ASSERT_EQ(out.size(), 1u);
+  ASSERT_TRUE(out.count("stat.publishtimestamp"));
+  // everything goes out again after the refresh period
+  out = filter.Filter("/fs1", values, now + std::chrono::seconds(61));
+  ASSERT_EQ(out, values);
+  // and after forgetting the subject
+  filter.Forget("/fs1");
+  ASSERT_EQ(filter.Filter("/fs1", values, now + std::chrono::seconds(62)),
+            values);
+}
+
+TEST(PublishFilter, ZeroThreshold)
+{
+  PublishFilter filter(0, std::chrono::seconds(300));
+  ASSERT_FALSE(filter.IsChanged("100", "100"));
+  ASSERT_TRUE(filter.IsChanged("100", "100.000001"));
+  PublishFilter relative(0.01, std::chrono::seconds(300));
+  ASSERT_FALSE(relative.IsChanged("0.000000", "0"));
+  ASSERT_TRUE(relative.IsChanged("0", "0.1"));
+  ASSERT_TRUE(relative.IsChanged("12abc", "12abd"));
+}
@@ -0,0 +1,277 @@
+//------------------------------------------------------------------------------
+// File: ReadaheadEngineTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/io/xrd/ReadaheadEngine.hh"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <thread>
+
+using eos::fst::ReadaheadEngine;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Remote file answering every request from its own thread
+//------------------------------------------------------------------------------
+class FakeRemote
+{
+public:
+  FakeRemote(size_t size, int delay_ms = 0, bool fail = false):
+    mDelay(delay_ms), mFail(fail), mData(size)
+  {
+    for (size_t i = 0; i < size; ++i) {
+      mData[i] = static_cast<char>(i * 7 + i / 251);
+    }
+  }
+
+  ~FakeRemote()
+  {
+    for (auto& thread : mThreads) {
+      thread.join();
+    }
+  }
+
+  ReadaheadEngine::Fetcher GetFetcher()
+  {
+    return [this](uint64_t offset, uint32_t length, char* buffer,
+    ReadaheadEngine::Callback done) {
+      mRequests++;
+      mThreads.emplace_back([this, offset, length, buffer, done]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(mDelay));
+
+        if (mFail) {
+          done(-EIO);
+          return;
+        }
+
+        int64_t n = 0;
+
+        if (offset < mData.size()) {
+          n = std::min<uint64_t>(length, mData.size() - offset);
+          memcpy(buffer, mData.data() + offset, n);
+        }
+
+        done(n);
+      });
+      return true;
+    };
+  }
+
+  const std::vector<char>& Data() const
+  {
+    return mData;
+  }
+
+  std::atomic<int> mRequests {0};
+
+private:
+  int mDelay;
+  bool mFail;
+  std::vector<char> mData;
+  std::vector<std::thread> mThreads;
+};
+
+ReadaheadEngine::Config MakeConfig()
+{
+  ReadaheadEngine::Config config;
+  config.mBlockSize = 4096;
+  config.mMaxBlocks = 8;
+  config.mMaxStreams = 2;
+  config.mMinWindow = 1;
+  config.mMaxWindow = 4;
+  return config;
+}
+}
+
+//------------------------------------------------------------------------------
+// Sequential reads are served from the prefetched blocks
+//------------------------------------------------------------------------------
+TEST(ReadaheadEngine, Sequential)
+{
+  FakeRemote remote(64 * 1024);
+  ReadaheadEngine engine(MakeConfig(), remote.GetFetcher());
+  std::vector<char> out(remote.Data().size());
+  uint64_t offset = 0;
+
+  while (offset < out.size()) {
+    ReadaheadEngine::Result res = engine.Read(offset, out.data() + offset, 1000);
+    ASSERT_FALSE(res.mError);
+
+    if (res.mBytes < 1000) {
+      // miss: read the rest directly like XrdIo does
+      memcpy(out.data() + offset + res.mBytes,
+             remote.Data().data() + offset + res.mBytes,
+             std::min<uint64_t>(1000 - res.mBytes,
+                                out.size() - offset - res.mBytes));
+    }
+
+    offset += 1000;
+  }
+
+  engine.Drain();
+  ASSERT_TRUE(out == remote.Data());
+  ReadaheadEngine::Stats stats = engine.GetStats();
+  ASSERT_EQ(stats.mStreams, 1u);
+  ASSERT_GT(stats.mHits + stats.mLateHits, 10u);
+  ASSERT_LE(stats.mMisses, 2u);
+}
+
+//------------------------------------------------------------------------------
+// The end of file is reported once the last short block is consumed
+//------------------------------------------------------------------------------
+TEST(ReadaheadEngine, EndOfFile)
+{
+  FakeRemote remote(3 * 4096 + 100);
+  ReadaheadEngine engine(MakeConfig(), remote.GetFetcher());
+  char buffer[4096];
+  bool eof = false;
+
+  for (uint64_t offset = 0; offset < 8 * 4096; offset += 4096) {
+    ReadaheadEngine::Result res = engine.Read(offset, buffer, sizeof(buffer));
+
+    if (res.mEof) {
+      ASSERT_EQ(offset, 3 * 4096u);
+      ASSERT_EQ(res.mBytes, 100);
+      eof = true;
+      break;
+    }
+  }
+
+  ASSERT_TRUE(eof);
+}
+
+//------------------------------------------------------------------------------
+// Interleaved sequential cursors are followed as separate streams
+//------------------------------------------------------------------------------
+TEST(ReadaheadEngine, InterleavedStreams)
+{
+  FakeRemote remote(1024 * 1024);
+  ReadaheadEngine engine(MakeConfig(), remote.GetFetcher());
+  char buffer[4096];
+  const uint64_t base[2] = {0, 512 * 1024};
+
+  for (uint64_t i = 0; i < 32; ++i) {
+    for (int s = 0; s < 2; ++s) {
+      uint64_t offset = base[s] + i * 4096;
+      ReadaheadEngine::Result res = engine.Read(offset, buffer, sizeof(buffer));
+
+      if (res.mBytes) {
+        ASSERT_EQ(res.mBytes, 4096);
+        ASSERT_EQ(0, memcmp(buffer, remote.Data().data() + offset, 4096));
+      }
+    }
+  }
+
+  ReadaheadEngine::Stats stats = engine.GetStats();
+  ASSERT_EQ(stats.mStreams, 2u);
+  ASSERT_GT(stats.mHits + stats.mLateHits, 50u);
+}
+
+//------------------------------------------------------------------------------
+// Waiting for blocks in flight grows the window, up to its maximum
+//------------------------------------------------------------------------------
+TEST(ReadaheadEngine, WindowGrowsOnLateHits)
+{
+  FakeRemote remote(1024 * 1024, 5);
+  ReadaheadEngine engine(MakeConfig(), remote.GetFetcher());
+  char buffer[4096];
+  uint64_t offset = 0;
+
+  for (; offset < 64 * 4096; offset += 4096) {
+    engine.Read(offset, buffer, sizeof(buffer));
+  }
+
+  ASSERT_GT(engine.GetStats().mLateHits, 0u);
+  ASSERT_EQ(engine.GetWindow(offset), 4u);
+}
+
+//------------------------------------------------------------------------------
+// Random reads do not trigger prefetching
+//------------------------------------------------------------------------------
+TEST(ReadaheadEngine, RandomReads)
+{
+  FakeRemote remote(16 * 1024 * 1024);
+  ReadaheadEngine engine(MakeConfig(), remote.GetFetcher());
+  char buffer[512];
+  uint64_t offset = 12345;
+
+  for (int i = 0; i < 100; ++i) {
+    offset = (offset * 1103515245 + 12345) % (remote.Data().size() - 512);
+    ASSERT_EQ(engine.Read(offset, buffer, sizeof(buffer)).mBytes, 0);
+  }
+
+  ASSERT_EQ(remote.mRequests, 0);
+  ASSERT_EQ(engine.GetStats().mMisses, 100u);
+}
+
+//------------------------------------------------------------------------------
+// Slices hand over the data without copy and pin the buffer
+//------------------------------------------------------------------------------
+TEST(ReadaheadEngine, ZeroCopy)
+{
+  FakeRemote remote(64 * 1024);
+  ReadaheadEngine::Slice kept;
+  {
+    ReadaheadEngine engine(MakeConfig(), remote.GetFetcher());
+    ReadaheadEngine::Slice slice;
+    ASSERT_EQ(engine.Get(0, 4096, slice).mBytes, 0);
+    ASSERT_EQ(engine.Get(4096, 4096, slice).mBytes, 0);
+    ReadaheadEngine::Result res = engine.Get(8192, 4096, slice);
+    ASSERT_EQ(res.mBytes, 4096);
+    ASSERT_EQ(slice.mLength, 4096u);
+    ASSERT_EQ(0, memcmp(slice.mData, remote.Data().data() + 8192, 4096));
+    kept = slice;
+  }
+  // the engine is gone, the slice still holds the data
+  ASSERT_EQ(0, memcmp(kept.mData, remote.Data().data() + 8192, 4096));
+}
+
+//------------------------------------------------------------------------------
+// A failed prefetch disables the engine
+//------------------------------------------------------------------------------
+TEST(ReadaheadEngine, Failure)
+{
+  FakeRemote remote(64 * 1024, 0, true);
+  ReadaheadEngine engine(MakeConfig(), remote.GetFetcher());
+  char buffer[4096];
+  engine.Read(0, buffer, sizeof(buffer));
+  engine.Read(4096, buffer, sizeof(buffer));
+  ReadaheadEngine::Result res = engine.Read(8192, buffer, sizeof(buffer));
+  ASSERT_TRUE(res.mError);
+  ASSERT_FALSE(engine.IsEnabled());
+  ASSERT_EQ(engine.Read(12288, buffer, sizeof(buffer)).mBytes, 0);
+}
+
+//------------------------------------------------------------------------------
+// Blocks prefetched for an abandoned stream are counted as wasted
+//------------------------------------------------------------------------------
+TEST(ReadaheadEngine, Wasted)
+{
+  FakeRemote remote(1024 * 1024);
+  ReadaheadEngine engine(MakeConfig(), remote.GetFetcher());
+  char buffer[4096];
+  engine.Read(0, buffer, sizeof(buffer));
+  engine.Read(4096, buffer, sizeof(buffer));
+  engine.Drain();
+  ASSERT_GT(engine.GetStats().mWasted, 0u);
+  ASSERT_EQ(engine.GetStats().mWasted, engine.GetStats().mPrefetched);
+}
@@ -0,0 +1,101 @@
+//------------------------------------------------------------------------------
+// File: TokenBucketTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/txqueue/TokenBucket.hh"
+#include "gtest/gtest.h"
+
+using eos::fst::TokenBucket;
+
+TEST(TokenBucket, Unlimited)
+{
+  TokenBucket bucket;
+  TokenBucket::Clock::time_point now = TokenBucket::Clock::now();
+  bucket.Consume(1e12, now);
+  ASSERT_TRUE(bucket.IsAvailable(now));
+  ASSERT_EQ(bucket.TimeToAvailable(now).count(), 0);
+}
+
+TEST(TokenBucket, Debt)
+{
+  TokenBucket::Clock::time_point now = TokenBucket::Clock::now();
+  TokenBucket bucket;
+  // 100 tokens per second, burst of 100
+  bucket.Configure(100, 100, now);
+  ASSERT_TRUE(bucket.IsAvailable(now));
+  bucket.Consume(50, now);
+  ASSERT_TRUE(bucket.IsAvailable(now));
+  bucket.Consume(100, now);
+  ASSERT_FALSE(bucket.IsAvailable(now));
+  ASSERT_NEAR(bucket.GetTokens(now), -50, 1e-6);
+  // the debt of 50 is paid back after half a second
+  ASSERT_EQ(bucket.TimeToAvailable(now).count(), 501);
+  ASSERT_FALSE(bucket.IsAvailable(now + std::chrono::milliseconds(400)));
+  ASSERT_TRUE(bucket.IsAvailable(now + std::chrono::milliseconds(501)));
+  // refill stops at the burst size
+  ASSERT_NEAR(bucket.GetTokens(now + std::chrono::seconds(10)), 100, 1e-6);
+}
+
+TEST(TokenBucket, Reconfigure)
+{
+  TokenBucket::Clock::time_point now = TokenBucket::Clock::now();
+  TokenBucket bucket;
+  bucket.Configure(100, 100, now);
+  bucket.Consume(300, now);
+  // the debt survives a change of the rate, which changes the pay back time
+  bucket.Configure(400, 400, now);
+  ASSERT_NEAR(bucket.GetTokens(now), -200, 1e-6);
+  ASSERT_EQ(bucket.TimeToAvailable(now).count(), 501);
+  // disabling the limit admits right away
+  bucket.Configure(0, 0, now);
+  ASSERT_TRUE(bucket.IsAvailable(now));
+}
+
+TEST(TokenBucket, LongJobAtStreamRate)
+{
+  TokenBucket::Clock::time_point now = TokenBucket::Clock::now();
+  TokenBucket bucket;
+  // two slots of 25 MB/s each, burst of one second
+  const double stream_rate = 25e6;
+  bucket.Configure(2 * stream_rate, 2 * stream_rate, now);
+
+  // a 10 GB job at the stream rate charged as it progresses never keeps the
+  // queue from admitting the next job
+  for (int sec = 1; sec <= 400; ++sec) {
+    bucket.Consume(stream_rate, now + std::chrono::seconds(sec));
+    ASSERT_EQ(bucket.TimeToAvailable(now + std::chrono::seconds(sec)).count(),
+              0) << "second=" << sec;
+  }
+
+  // both slots busy at the stream rate stay within the limit as well
+  now += std::chrono::seconds(400);
+
+  for (int sec = 1; sec <= 400; ++sec) {
+    bucket.Consume(2 * stream_rate, now + std::chrono::seconds(sec));
+    ASSERT_EQ(bucket.TimeToAvailable(now + std::chrono::seconds(sec)).count(),
+              0) << "second=" << sec;
+  }
+
+  // a single slot copying above the stream rate gets throttled
+  now += std::chrono::seconds(400);
+  bucket.Consume(4 * stream_rate, now + std::chrono::seconds(1));
+  ASSERT_GT(bucket.TimeToAvailable(now + std::chrono::seconds(1)).count(), 0);
+}
@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+// File: XorKernelTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/layout/XorKernel.hh"
+#include "gtest/gtest.h"
+#include <vector>
+
+using eos::fst::XorKernel;
+
+//------------------------------------------------------------------------------
+// Byte by byte XOR of the source blocks
+//------------------------------------------------------------------------------
+static std::vector<char>
+ScalarXor(const std::vector<const char*>& srcs, size_t length)
+{
+  std::vector<char> result(length, 0);
+
+  for (const char* src : srcs) {
+    for (size_t i = 0; i < length; ++i) {
+      result[i] ^= src[i];
+    }
+  }
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+// Every instruction set supported by the CPU against the scalar reference,
+// for lengths around the vector sizes, any number of sources and blocks not
+// aligned to the vector size
+//------------------------------------------------------------------------------
+TEST(XorKernel, MatchesScalarReference)
+{
+  const size_t lengths[] = {0, 1, 15, 16, 17, 31, 32, 63, 64, 65, 127, 128,
+                            255, 256, 4096 + 13
+                           };
+  const size_t max_len = 4096 + 13;
+  const size_t max_srcs = 9;
+  // one spare byte per block to shift the start of the buffers
+  std::vector<std::vector<char>> blocks(max_srcs,
+                                        std::vector<char>(max_len + 1));
+  unsigned int seed = 12345;
+
+  for (auto& block : blocks) {
+    for (auto& c : block) {
+      seed = seed * 1103515245 + 12345;
+      c = (char)(seed >> 16);
+    }
+  }
+
+  auto best = XorKernel::GetBestIsa();
+
+  for (auto isa : {
+         XorKernel::Isa::kScalar, XorKernel::Isa::kSSE2,
+         XorKernel::Isa::kAVX2, XorKernel::Isa::kAVX512
+       }) {
+    if (!XorKernel::SetIsa(isa)) {
+      continue;
+    }
+
+    for (size_t offset = 0; offset < 2; ++offset) {
+      for (size_t nsrcs = 0; nsrcs <= max_srcs; ++nsrcs) {
+        std::vector<const char*> srcs;
+
+        for (size_t i = 0; i < nsrcs; ++i) {
+          srcs.push_back(blocks[i].data() + offset);
+        }
+
+        for (size_t len : lengths) {
+          std::vector<char> expected = ScalarXor(srcs, len);
+          // guard byte after the destination must not be touched
+          std::vector<char> result(len + 1, 'x');
+          XorKernel::Xor(result.data(), srcs.data(), nsrcs, len);
+          ASSERT_EQ('x', result[len]);
+          result.resize(len);
+          ASSERT_TRUE(result == expected)
+              << "isa=" << XorKernel::IsaToString(isa) << " offset=" << offset
+              << " sources=" << nsrcs << " length=" << len;
+        }
+      }
+    }
+  }
+
+  ASSERT_TRUE(XorKernel::SetIsa(best));
+}
@@ -0,0 +1,102 @@
+//------------------------------------------------------------------------------
+// File: FsAggregateTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/FsAggregate.hh"
+#include "gtest/gtest.h"
+#include <cmath>
+
+using eos::mgm::FsAggregate;
+
+//------------------------------------------------------------------------------
+// Test query parsing
+//------------------------------------------------------------------------------
+TEST(FsAggregate, Query)
+{
+  FsAggregate::Query plain("stat.statfs.usedbytes");
+  ASSERT_EQ("stat.statfs.usedbytes", plain.mParam);
+  ASSERT_FALSE(plain.mIsQuery);
+  ASSERT_TRUE(plain.mKey.empty());
+  FsAggregate::Query query("stat.statfs.capacity?configstatus@rw");
+  ASSERT_EQ("stat.statfs.capacity", query.mParam);
+  ASSERT_TRUE(query.mIsQuery);
+  ASSERT_EQ("configstatus", query.mKey);
+  ASSERT_EQ("rw", query.mValue);
+}
+
+//------------------------------------------------------------------------------
+// Test that incremental updates match a full recomputation
+//------------------------------------------------------------------------------
+TEST(FsAggregate, Incremental)
+{
+  FsAggregate aggregate("stat.statfs.filled");
+  FsAggregate::Sample sample;
+
+  for (unsigned int fsid = 1; fsid <= 10; ++fsid) {
+    sample.mLongValue = fsid * 1000000000000ll;
+    sample.mValue = fsid;
+    sample.mConsidered = (fsid != 10);
+    aggregate.Set(fsid, sample);
+  }
+
+  FsAggregate::Stats stats = aggregate.GetStats();
+  ASSERT_EQ(55000000000000ll, stats.mLongSum);
+  ASSERT_DOUBLE_EQ(55, stats.mSum);
+  ASSERT_EQ(9, stats.mCount);
+  ASSERT_DOUBLE_EQ(5, stats.mAvg);
+  ASSERT_NEAR(std::sqrt(60.0 / 9), stats.mSigma, 1e-9);
+  ASSERT_DOUBLE_EQ(1, stats.mMin);
+  ASSERT_DOUBLE_EQ(9, stats.mMax);
+  // Replace, exclude and remove some contributions
+  FsAggregate full("stat.statfs.filled");
+
+  for (unsigned int fsid = 1; fsid <= 10; ++fsid) {
+    sample.mLongValue = 0;
+    sample.mValue = fsid + 0.5;
+    sample.mConsidered = (fsid % 2);
+    aggregate.Set(fsid, sample);
+
+    if (fsid != 3) {
+      full.Set(fsid, sample);
+    }
+  }
+
+  aggregate.Remove(3);
+  ASSERT_FALSE(aggregate.Has(3));
+  ASSERT_EQ(9u, aggregate.Size());
+  ASSERT_TRUE(aggregate.Matches(full));
+  stats = aggregate.GetStats();
+  ASSERT_EQ(0, stats.mLongSum);
+  ASSERT_EQ(4, stats.mCount);
+  ASSERT_DOUBLE_EQ(6, stats.mAvg);
+  ASSERT_DOUBLE_EQ(1.5, stats.mMin);
+  ASSERT_DOUBLE_EQ(9.5, stats.mMax);
+  // A drifted aggregate is detected
+  sample.mValue = 100;
+  sample.mConsidered = true;
+  aggregate.Set(1, sample);
+  ASSERT_FALSE(aggregate.Matches(full));
+  aggregate.Clear();
+  stats = aggregate.GetStats();
+  ASSERT_EQ(0u, aggregate.Size());
+  ASSERT_EQ(0, stats.mCount);
+  ASSERT_DOUBLE_EQ(0, stats.mSigma);
+}
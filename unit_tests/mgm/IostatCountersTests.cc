@@ -0,0 +1,95 @@
+//------------------------------------------------------------------------------
+// File: IostatCountersTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/IostatCounters.hh"
+#include "common/Report.hh"
+#include "gtest/gtest.h"
+#include <algorithm>
+
+using eos::mgm::IostatCounters;
+
+//------------------------------------------------------------------------------
+// Test tag interning
+//------------------------------------------------------------------------------
+TEST(IostatCounters, InternTag)
+{
+  IostatCounters counters;
+  ASSERT_EQ(IostatCounters::kBytesRead, counters.InternTag("bytes_read"));
+  ASSERT_EQ(IostatCounters::kFilesDeleted, counters.InternTag("files_deleted"));
+  ASSERT_EQ("bytes_bwd_wseek",
+            counters.GetTagName(IostatCounters::kBytesBwdSeek));
+  size_t id = counters.InternTag("custom_tag");
+  ASSERT_EQ((size_t) IostatCounters::kNumFixedTags, id);
+  ASSERT_EQ(id, counters.InternTag("custom_tag"));
+  ASSERT_EQ("custom_tag", counters.GetTagName(id));
+  ASSERT_EQ("", counters.GetTagName(id + 1));
+}
+
+//------------------------------------------------------------------------------
+// Test accounting of reports and restored totals
+//------------------------------------------------------------------------------
+TEST(IostatCounters, AddAndCollect)
+{
+  IostatCounters counters;
+  time_t now = time(NULL);
+  std::vector<std::pair<std::string, size_t>> tags;
+  counters.GetActiveTags(tags);
+  ASSERT_TRUE(tags.empty());
+
+  // Spread the ids over several shards
+  for (uid_t uid = 1; uid <= 100; ++uid) {
+    counters.Add(IostatCounters::kBytesRead, uid, uid % 10, uid, now - 1, now);
+  }
+
+  XrdOucEnv env("ruid=7&rgid=3&rb=1000&rvb_sum=24&wb=10&nrc=2");
+  eos::common::Report report(env);
+  report.ots = now - 1;
+  report.cts = now;
+  counters.AddReport(report);
+  counters.GetActiveTags(tags);
+  // AddReport touches all the per report tags even if zero
+  ASSERT_EQ((size_t) IostatCounters::kBytesDeleted, tags.size());
+  IostatCounters::Entry sum = counters.GetSummary(IostatCounters::kBytesRead);
+  ASSERT_EQ(5050ull + 1024ull, sum.mTotal);
+  ASSERT_EQ(5050.0 + 1024.0, sum.mAvg60);
+  std::vector<IostatCounters::Entry> entries;
+  counters.Collect(IostatCounters::kBytesRead, true, entries);
+  ASSERT_EQ(10u, entries.size());
+  auto it = std::find_if(entries.begin(), entries.end(),
+  [](const IostatCounters::Entry & e) {
+    return e.mId == 3;
+  });
+  ASSERT_TRUE(it != entries.end());
+  // gid 3 collects uids 3, 13, ..., 93 and the report
+  ASSERT_EQ(3ull + 13 + 23 + 33 + 43 + 53 + 63 + 73 + 83 + 93 + 1024,
+            it->mTotal);
+  // Restored counters have a total but no averages
+  size_t custom = counters.InternTag("custom_tag");
+  counters.SetTotal(custom, false, 42, 123);
+  counters.Collect(custom, false, entries);
+  ASSERT_EQ(1u, entries.size());
+  ASSERT_EQ(42u, entries[0].mId);
+  ASSERT_EQ(123ull, entries[0].mTotal);
+  ASSERT_FALSE(entries[0].mHasAvg);
+  counters.Collect(custom, true, entries);
+  ASSERT_TRUE(entries.empty());
+}
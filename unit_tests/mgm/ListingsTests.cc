@@ -0,0 +1,134 @@
+//------------------------------------------------------------------------------
+// File: ListingsTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/FuseServer/Listings.hh"
+#include "gtest/gtest.h"
+#include <ctime>
+
+using eos::mgm::FuseServer::Listings;
+
+//------------------------------------------------------------------------------
+// Build a snapshot with the given number of children
+//------------------------------------------------------------------------------
+static Listings::shared_children
+MakeChildren(size_t count)
+{
+  auto children = std::make_shared<Listings::children_t>();
+
+  for (size_t i = 0; i < count; ++i) {
+    children->emplace_back("file" + std::to_string(i), 1000 + i);
+  }
+
+  return children;
+}
+
+//------------------------------------------------------------------------------
+// Cursors survive a round trip
+//------------------------------------------------------------------------------
+TEST(Listings, CursorRoundTrip)
+{
+  uint64_t id = 0;
+  size_t offset = 0;
+  ASSERT_EQ(Listings::MakeCursor(0x1a, 0x200), "1a:200");
+  ASSERT_TRUE(Listings::ParseCursor("1a:200", id, offset));
+  ASSERT_EQ(id, 0x1au);
+  ASSERT_EQ(offset, 0x200u);
+  ASSERT_TRUE(Listings::ParseCursor(Listings::MakeCursor(0xffffffffffffffff,
+                                    0), id, offset));
+  ASSERT_EQ(id, 0xffffffffffffffffu);
+  ASSERT_EQ(offset, 0u);
+}
+
+//------------------------------------------------------------------------------
+// Malformed cursors are rejected
+//------------------------------------------------------------------------------
+TEST(Listings, MalformedCursor)
+{
+  uint64_t id = 0;
+  size_t offset = 0;
+
+  for (const auto& cursor : {
+         "", ":", "1", "1:", ":1", "xyz:1", "1x:1", "1:2x", "1:2:3"
+       }) {
+    ASSERT_FALSE(Listings::ParseCursor(cursor, id, offset)) << cursor;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Listings are only served for the inode they were created for
+//------------------------------------------------------------------------------
+TEST(Listings, GetAndDrop)
+{
+  Listings listings;
+  uint64_t id = listings.Create(42, MakeChildren(3));
+  ASSERT_EQ(listings.Size(), 1u);
+  auto children = listings.Get(id, 42);
+  ASSERT_TRUE(children != nullptr);
+  ASSERT_EQ(children->size(), 3u);
+  ASSERT_EQ((*children)[2].first, "file2");
+  ASSERT_EQ((*children)[2].second, 1002u);
+  ASSERT_TRUE(listings.Get(id, 43) == nullptr);
+  ASSERT_TRUE(listings.Get(id + 1, 42) == nullptr);
+  listings.Drop(id);
+  ASSERT_TRUE(listings.Get(id, 42) == nullptr);
+  ASSERT_EQ(listings.Size(), 0u);
+}
+
+//------------------------------------------------------------------------------
+// Listings are dropped once their time to live passed
+//------------------------------------------------------------------------------
+TEST(Listings, Expire)
+{
+  Listings listings;
+  time_t now = time(NULL);
+  uint64_t id = listings.Create(42, MakeChildren(1));
+  listings.Expire(now);
+  ASSERT_TRUE(listings.Get(id, 42) != nullptr);
+  listings.Expire(time(NULL) + Listings::cListingTTL + 1);
+  ASSERT_EQ(listings.Size(), 0u);
+  ASSERT_TRUE(listings.Get(id, 42) == nullptr);
+}
+
+//------------------------------------------------------------------------------
+// The oldest listing is evicted when too many are in flight and its client
+// restarts with a new listing
+//------------------------------------------------------------------------------
+TEST(Listings, EvictAndRestart)
+{
+  const size_t max_listings = Listings::cMaxListings;
+  Listings listings;
+  uint64_t first = listings.Create(1, MakeChildren(1));
+  uint64_t last = first;
+
+  for (size_t i = 1; i <= max_listings; ++i) {
+    last = listings.Create(1 + i, MakeChildren(1));
+  }
+
+  ASSERT_EQ(listings.Size(), max_listings);
+  ASSERT_TRUE(listings.Get(first, 1) == nullptr);
+  ASSERT_TRUE(listings.Get(first + 1, 2) != nullptr);
+  ASSERT_TRUE(listings.Get(last, 1 + max_listings) != nullptr);
+  uint64_t restart = listings.Create(1, MakeChildren(1));
+  ASSERT_NE(restart, first);
+  ASSERT_TRUE(listings.Get(restart, 1) != nullptr);
+  ASSERT_EQ(listings.Size(), max_listings);
+}
@@ -0,0 +1,140 @@
+//------------------------------------------------------------------------------
+// File: StatCountersTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/StatCounters.hh"
+#include "gtest/gtest.h"
+#include <thread>
+
+using eos::mgm::StatCounters;
+using eos::mgm::StatRate;
+
+//------------------------------------------------------------------------------
+// Test tag interning
+//------------------------------------------------------------------------------
+TEST(StatCounters, InternTag)
+{
+  StatCounters counters;
+  ASSERT_EQ(StatCounters::sInvalidTag, counters.LookupTag("Open"));
+  uint32_t open = counters.InternTag("Open");
+  uint32_t stat = counters.InternTag("Stat");
+  ASSERT_NE(open, stat);
+  ASSERT_EQ(open, counters.InternTag("Open"));
+  ASSERT_EQ(open, counters.LookupTag("Open"));
+  ASSERT_EQ("Stat", counters.GetTagName(stat));
+  ASSERT_EQ("", counters.GetTagName(stat + 1));
+  ASSERT_EQ(2u, counters.GetNumTags());
+
+  for (uint32_t i = counters.GetNumTags(); i < StatCounters::sMaxTags; ++i) {
+    ASSERT_EQ(i, counters.InternTag(std::to_string(i).c_str()));
+  }
+
+  ASSERT_EQ(StatCounters::sInvalidTag, counters.InternTag("Overflow"));
+  ASSERT_EQ(stat, counters.LookupTag("Stat"));
+}
+
+//------------------------------------------------------------------------------
+// Test the sliding window sums
+//------------------------------------------------------------------------------
+TEST(StatCounters, Rate)
+{
+  StatRate rate;
+  uint32_t now = 1000000;
+
+  // One value per second during more than the last hour
+  for (uint32_t t = now - 3700; t <= now; ++t) {
+    rate.Add(1, t);
+  }
+
+  ASSERT_DOUBLE_EQ(4, rate.GetSum(4, now));
+  ASSERT_DOUBLE_EQ(59, rate.GetSum(59, now));
+  ASSERT_NEAR(299, rate.GetSum(299, now), 1);
+  ASSERT_NEAR(3599, rate.GetSum(3599, now), 1);
+  ASSERT_DOUBLE_EQ(1, rate.GetAvg5(now));
+  ASSERT_DOUBLE_EQ(1, rate.GetAvg60(now));
+  // Values older than the window are not counted
+  ASSERT_DOUBLE_EQ(0, rate.GetSum(59, now + 120));
+  ASSERT_NEAR(3599 - 120, rate.GetSum(3599, now + 120), 1);
+  // Stale bins are taken over when the ring wraps
+  rate.Add(5, now + 64);
+  ASSERT_DOUBLE_EQ(5, rate.GetSum(4, now + 64));
+  rate.Reset();
+  ASSERT_DOUBLE_EQ(0, rate.GetSum(3599, now));
+}
+
+//------------------------------------------------------------------------------
+// Test accounting from several threads and collection
+//------------------------------------------------------------------------------
+TEST(StatCounters, AddAndCollect)
+{
+  StatCounters counters;
+  uint32_t open = counters.InternTag("Open");
+  uint32_t now = 1000000;
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      for (uid_t uid = 0; uid < 1000; ++uid) {
+        counters.Add(open, uid, uid % 10, 1, now);
+        counters.AddExec(open, 2.0);
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<StatCounters::Entry> entries;
+  counters.Collect(entries, now);
+  ASSERT_EQ(1010u, entries.size());
+  unsigned long long uid_total = 0, gid_total = 0;
+
+  for (const auto& entry : entries) {
+    ASSERT_EQ(open, entry.mTag);
+    ASSERT_TRUE(entry.mUsed);
+    (entry.mByGid ? gid_total : uid_total) += entry.mTotal;
+
+    if (!entry.mByGid) {
+      ASSERT_EQ(4u, entry.mTotal);
+      ASSERT_DOUBLE_EQ(1.0, entry.mAvg5);
+    }
+  }
+
+  ASSERT_EQ(4000u, uid_total);
+  ASSERT_EQ(4000u, gid_total);
+  ASSERT_DOUBLE_EQ(1.0, counters.GetAvg5(open, false, 7, now));
+  ASSERT_DOUBLE_EQ(100.0, counters.GetAvg5(open, true, 7, now));
+  ASSERT_DOUBLE_EQ(0, counters.GetAvg5(open, false, 5000, now));
+  std::vector<float> samples;
+  counters.GetExecSamples(open, samples);
+  ASSERT_EQ(StatCounters::sExecSamples, samples.size());
+  ASSERT_FLOAT_EQ(2.0, samples[0]);
+  // Clearing keeps the cells but drops their values
+  counters.Clear();
+  entries.clear();
+  counters.Collect(entries, now, open);
+  ASSERT_EQ(1010u, entries.size());
+  ASSERT_FALSE(entries[0].mUsed);
+  ASSERT_EQ(0u, entries[0].mTotal);
+  counters.GetExecSamples(open, samples);
+  ASSERT_TRUE(samples.empty());
+}
@@ -0,0 +1,120 @@
+//------------------------------------------------------------------------------
+// File: XrdMqSharedHashCodecTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mq/XrdMqSharedHashCodec.hh"
+
+//------------------------------------------------------------------------------
+// Update round trip keeps values byte for byte, including the ones which look
+// like numbers but are not canonical integers
+//------------------------------------------------------------------------------
+TEST(XrdMqSharedHashCodec, UpdateRoundTrip)
+{
+  XrdMqSharedHashDelta delta;
+  delta.mCmd = XrdMqSharedHashDelta::kUpdate;
+  delta.mType = "hash";
+  delta.mSubjects = {"/eos/fst1.cern.ch:1095/fst/data01",
+                     "/eos/fst1.cern.ch:1095/fst/data02"
+                    };
+  std::vector<std::string> values = {
+    "0", "1", "-1", "1539012345", "-922337203685477580", "9223372036854775807",
+    "007", "-0", "1.5", "1e3", "+1", "-", "online", "a b&c=d|e~f%g", " "
+  };
+
+  for (size_t i = 0; i < values.size(); ++i) {
+    delta.mEntries.push_back({(uint32_t)(i % 2), "stat.key" + std::to_string(i),
+                              values[i], 1000 + i});
+  }
+
+  std::string body;
+  XrdMqSharedHashCodec::Encode(delta, body);
+  ASSERT_TRUE(XrdMqSharedHashCodec::IsBinary(body.c_str()));
+  ASSERT_EQ(std::string::npos, body.find('&'));
+  XrdMqSharedHashDelta decoded;
+  std::string error;
+  ASSERT_TRUE(XrdMqSharedHashCodec::Decode(body.c_str(), decoded, error))
+      << error;
+  ASSERT_EQ(delta.mCmd, decoded.mCmd);
+  ASSERT_EQ(delta.mType, decoded.mType);
+  ASSERT_EQ(delta.mSubjects, decoded.mSubjects);
+  ASSERT_EQ(delta.mEntries.size(), decoded.mEntries.size());
+
+  for (size_t i = 0; i < delta.mEntries.size(); ++i) {
+    ASSERT_EQ(delta.mEntries[i].mSubject, decoded.mEntries[i].mSubject);
+    ASSERT_EQ(delta.mEntries[i].mKey, decoded.mEntries[i].mKey);
+    ASSERT_EQ(delta.mEntries[i].mValue, decoded.mEntries[i].mValue);
+    ASSERT_EQ(delta.mEntries[i].mChangeId, decoded.mEntries[i].mChangeId);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Deletions only carry the keys
+//------------------------------------------------------------------------------
+TEST(XrdMqSharedHashCodec, DeleteRoundTrip)
+{
+  XrdMqSharedHashDelta delta;
+  delta.mCmd = XrdMqSharedHashDelta::kDelete;
+  delta.mType = "queue";
+  delta.mSubjects = {"/eos/fst1.cern.ch:1095/fst/txqueue"};
+  delta.mEntries.push_back({0, "17", "", 0});
+  delta.mEntries.push_back({0, "18", "", 0});
+  std::string body;
+  XrdMqSharedHashCodec::Encode(delta, body);
+  XrdMqSharedHashDelta decoded;
+  std::string error;
+  ASSERT_TRUE(XrdMqSharedHashCodec::Decode(body.c_str(), decoded, error));
+  ASSERT_EQ(XrdMqSharedHashDelta::kDelete, decoded.mCmd);
+  ASSERT_EQ(2u, decoded.mEntries.size());
+  ASSERT_EQ("18", decoded.mEntries[1].mKey);
+  ASSERT_TRUE(decoded.mEntries[1].mValue.empty());
+}
+
+//------------------------------------------------------------------------------
+// Text messages and corrupted binary messages are rejected
+//------------------------------------------------------------------------------
+TEST(XrdMqSharedHashCodec, Invalid)
+{
+  XrdMqSharedHashDelta decoded;
+  std::string error;
+  ASSERT_FALSE(XrdMqSharedHashCodec::IsBinary("mqsh.cmd=update&mqsh.subject=a"));
+  ASSERT_FALSE(XrdMqSharedHashCodec::Decode("mqsh.cmd=update", decoded, error));
+  ASSERT_FALSE(XrdMqSharedHashCodec::Decode("mqsh.bin=!!!!", decoded, error));
+  XrdMqSharedHashDelta delta;
+  delta.mType = "hash";
+  delta.mSubjects = {"/eos/subject"};
+  delta.mEntries.push_back({0, "key", "value", 1});
+  std::string body;
+  XrdMqSharedHashCodec::Encode(delta, body);
+
+  // Every truncation must be detected
+  for (size_t len = sizeof(XRDMQSHAREDHASH_BINARY) - 1; len < body.length();
+       len += 4) {
+    ASSERT_FALSE(XrdMqSharedHashCodec::Decode(body.substr(0, len).c_str(),
+                 decoded, error));
+  }
+
+  // Unknown version
+  XrdMqSharedHashCodec::Encode(delta, body);
+  body[sizeof(XRDMQSHAREDHASH_BINARY) - 1] = 'B';
+  ASSERT_FALSE(XrdMqSharedHashCodec::Decode(body.c_str(), decoded, error));
+  ASSERT_NE(std::string::npos, error.find("version"));
+}